@@ -0,0 +1,92 @@
+# Genera la tabla ordenada de comandos internos a partir del manifiesto.
+#
+# Uso: cmake -DMANIFIESTO=<src/builtins.manifest> -DSALIDA=<builtins_tabla.h> -P GenerarBuiltins.cmake
+#
+# El header generado define el array tabla_builtins ordenado por nombre (orden de strcmp), listo para bsearch().
+# Sólo se reescribe si el contenido cambió, para no forzar recompilaciones.
+
+cmake_minimum_required(VERSION 3.28)
+
+if(NOT DEFINED MANIFIESTO OR NOT DEFINED SALIDA)
+    message(FATAL_ERROR "Uso: cmake -DMANIFIESTO=<manifiesto> -DSALIDA=<header> -P GenerarBuiltins.cmake")
+endif()
+
+file(STRINGS "${MANIFIESTO}" lineas ENCODING UTF-8)
+
+set(entradas "")
+set(nombres "")
+foreach(linea IN LISTS lineas)
+    string(STRIP "${linea}" linea)
+    if(linea STREQUAL "" OR linea MATCHES "^#")
+        continue()
+    endif()
+
+    string(REGEX REPLACE "[ \t]+" ";" campos "${linea}")
+    list(LENGTH campos num_campos)
+    if(NOT num_campos EQUAL 6)
+        message(FATAL_ERROR
+            "${MANIFIESTO}: se esperaban 6 campos (nombre manejador pipeline fork flujos externo) en '${linea}'")
+    endif()
+
+    list(GET campos 0 nombre)
+    list(GET campos 1 manejador)
+    list(GET campos 2 pipeline)
+    list(GET campos 3 requiere_fork)
+    list(GET campos 4 flujos)
+    list(GET campos 5 externo)
+
+    if(NOT nombre MATCHES "^[A-Za-z_][A-Za-z0-9_]*$" OR NOT manejador MATCHES "^[A-Za-z_][A-Za-z0-9_]*$")
+        message(FATAL_ERROR "${MANIFIESTO}: nombre o manejador inválido en '${linea}'")
+    endif()
+    if(NOT pipeline MATCHES "^(si|no)$" OR NOT requiere_fork MATCHES "^(si|no)$" OR NOT flujos MATCHES "^(si|no)$"
+       OR NOT externo MATCHES "^(si|no)$")
+        message(FATAL_ERROR
+            "${MANIFIESTO}: los campos pipeline, fork, flujos y externo deben ser 'si' o 'no' en '${linea}'")
+    endif()
+    if(nombre IN_LIST nombres)
+        message(FATAL_ERROR "${MANIFIESTO}: comando '${nombre}' duplicado")
+    endif()
+    list(APPEND nombres "${nombre}")
+
+    # El espacio separa el nombre del resto y ordena antes que cualquier carácter válido, igual que strcmp()
+    list(APPEND entradas "${nombre} ${manejador} ${pipeline} ${requiere_fork} ${flujos} ${externo}")
+endforeach()
+
+list(SORT entradas COMPARE STRING CASE SENSITIVE)
+list(LENGTH entradas num_entradas)
+
+set(contenido "/* Generado por cmake/GenerarBuiltins.cmake a partir de src/builtins.manifest. No editar. */\n\n")
+string(APPEND contenido "#define NUM_BUILTINS ${num_entradas}\n\n")
+string(APPEND contenido "static const descriptor_builtin tabla_builtins[NUM_BUILTINS] = {\n")
+foreach(entrada IN LISTS entradas)
+    string(REPLACE " " ";" campos "${entrada}")
+    list(GET campos 0 nombre)
+    list(GET campos 1 manejador)
+    list(GET campos 2 pipeline)
+    list(GET campos 3 requiere_fork)
+    list(GET campos 4 flujos)
+    list(GET campos 5 externo)
+    set(en_pipeline false)
+    set(con_fork false)
+    set(usa_flujos false)
+    set(reemplaza_externo false)
+    if(pipeline STREQUAL "si")
+        set(en_pipeline true)
+    endif()
+    if(requiere_fork STREQUAL "si")
+        set(con_fork true)
+    endif()
+    if(flujos STREQUAL "si")
+        set(usa_flujos true)
+    endif()
+    if(externo STREQUAL "si")
+        set(reemplaza_externo true)
+    endif()
+    string(APPEND contenido
+        "    {\"${nombre}\", ${manejador}, ${en_pipeline}, ${con_fork}, ${usa_flujos}, ${reemplaza_externo}},\n")
+endforeach()
+string(APPEND contenido "};\n")
+
+file(WRITE "${SALIDA}.tmp" "${contenido}")
+file(COPY_FILE "${SALIDA}.tmp" "${SALIDA}" ONLY_IF_DIFFERENT)
+file(REMOVE "${SALIDA}.tmp")
@@ -0,0 +1,115 @@
+/**
+ * @file arena.h
+ * @brief Arena de memoria por bloques para los nodos del árbol de comandos.
+ *
+ * Todas las reservas se hacen avanzando un puntero dentro del bloque actual. Liberar todo lo reservado es O(1):
+ * arena_reiniciar() vuelve al primer bloque y los bloques siguientes se reutilizan a medida que se necesitan, sin
+ * devolverlos al sistema.
+ */
+
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+
+/**
+ *  @brief Tamaño mínimo de cada bloque de la arena
+ */
+#define ARENA_TAM_BLOQUE 4096
+
+/**
+ * @brief Bloque de memoria de la arena.
+ */
+typedef struct bloque_arena
+{
+    struct bloque_arena* siguiente;              /**< Siguiente bloque de la cadena */
+    size_t capacidad;                            /**< Bytes disponibles en datos */
+    size_t usado;                                /**< Bytes ya reservados */
+    _Alignas(max_align_t) unsigned char datos[]; /**< Memoria del bloque */
+} bloque_arena;
+
+/**
+ * @brief Arena de memoria: cadena de bloques con un bloque actual.
+ */
+typedef struct
+{
+    bloque_arena* primero; /**< Primer bloque de la cadena */
+    bloque_arena* actual;  /**< Bloque donde se hacen las reservas */
+} arena;
+
+/**
+ * @brief Posición de una arena: arena_volver() libera sólo lo reservado después de tomarla.
+ */
+typedef struct
+{
+    bloque_arena* bloque; /**< Bloque actual al tomar la marca, NULL si la arena estaba vacía */
+    size_t usado;         /**< Bytes usados en ese bloque */
+} marca_arena;
+
+/**
+ * @brief Inicializa una arena vacía. El primer bloque se reserva con la primera asignación.
+ *
+ * @param a Arena a inicializar.
+ */
+void arena_inicializar(arena* a);
+
+/**
+ * @brief Reserva memoria alineada para cualquier tipo dentro de la arena.
+ *
+ * @param a Arena.
+ * @param tam Cantidad de bytes.
+ * @return void* Memoria reservada (sin inicializar), o NULL si no hay memoria.
+ */
+void* arena_reservar(arena* a, size_t tam);
+
+/**
+ * @brief Reserva memoria inicializada en cero dentro de la arena.
+ *
+ * @param a Arena.
+ * @param tam Cantidad de bytes.
+ * @return void* Memoria reservada, o NULL si no hay memoria.
+ */
+void* arena_reservar_cero(arena* a, size_t tam);
+
+/**
+ * @brief Copia los primeros n bytes de una cadena en la arena y agrega el terminador.
+ *
+ * @param a Arena.
+ * @param texto Cadena de origen.
+ * @param n Cantidad de bytes a copiar.
+ * @return char* Copia terminada en '\0', o NULL si no hay memoria.
+ */
+char* arena_copiar(arena* a, const char* texto, size_t n);
+
+/**
+ * @brief Libera en O(1) todo lo reservado, conservando los bloques para reutilizarlos.
+ *
+ * @param a Arena.
+ */
+void arena_reiniciar(arena* a);
+
+/**
+ * @brief Toma una marca de la posición actual de la arena.
+ *
+ * @param a Arena.
+ * @return marca_arena Marca para arena_volver().
+ */
+marca_arena arena_marcar(const arena* a);
+
+/**
+ * @brief Libera en O(1) lo reservado después de una marca, conservando lo anterior. Las marcas se devuelven en
+ * orden inverso al que se tomaron.
+ *
+ * @param a Arena.
+ * @param marca Marca tomada con arena_marcar() sobre la misma arena.
+ */
+void arena_volver(arena* a, marca_arena marca);
+
+/**
+ * @brief Devuelve al sistema todos los bloques de la arena.
+ *
+ * @param a Arena.
+ */
+void arena_liberar(arena* a);
+
+#endif // ARENA_H
@@ -0,0 +1,67 @@
+/**
+ * @file batch.h
+ * @brief Ejecución de archivos de comandos (modo batch).
+ *
+ * El archivo se mapea en memoria (o se lee completo si no es un archivo regular) y un hilo lector lo analiza y lo
+ * compila a bytecode (ver bytecode.h) por adelantado mientras el hilo principal ejecuta los programas ya compilados.
+ * Un comando puede ocupar varias líneas (comillas sin cerrar, '|', '&&', '||' o '\' al final de la línea, o un
+ * comando compuesto como if ... fi, while ... done o una definición de función, que se compila entero).
+ *
+ * Los bloques paralelos ejecutan sus comandos de forma concurrente:
+ *
+ *     begin_parallel [N]
+ *     comando1
+ *     comando2
+ *     end_parallel
+ *
+ * Cada comando del bloque se ejecuta en un proceso hijo del shell, con hasta N en ejecución a la vez (por defecto,
+ * la cantidad de CPUs en línea). end_parallel espera a que terminen todos.
+ *
+ * Los errores de sintaxis y los comandos que fallan se informan por stderr con el archivo y la línea, y al terminar
+ * se imprime un resumen con las líneas por segundo y la cantidad de fallos.
+ *
+ * Mientras analiza el texto, el hilo lector arma la caché del script (ver script_cache.h). Si en la próxima
+ * ejecución la caché sigue vigente, las unidades se toman directamente del archivo de caché mapeado, sin hilo lector
+ * ni análisis.
+ */
+
+#ifndef BATCH_H
+#define BATCH_H
+
+/**
+ *  @brief Cantidad de comandos analizados por adelantado que esperan ser ejecutados
+ */
+#define BATCH_COMANDOS_ADELANTADOS 128
+
+/**
+ *  @brief Máximo de comandos simultáneos en un bloque paralelo
+ */
+#define BATCH_MAX_PARALELO 256
+
+/**
+ *  @brief Máximo de archivos anidados con 'source' (protege la pila de un archivo que se incluye a sí mismo)
+ */
+#define BATCH_MAX_ANIDADOS 64
+
+/**
+ * @brief Ejecuta un archivo de comandos.
+ *
+ * @param ruta Ruta del archivo.
+ * @return int -1 si el archivo no se pudo abrir; en otro caso, la cantidad de comandos que fallaron (errores de
+ *         sintaxis incluidos).
+ */
+int ejecutar_script(const char* ruta);
+
+/**
+ * @brief Comando 'source': ejecuta un archivo de comandos en el shell actual.
+ *
+ * El archivo se ejecuta como con ejecutar_script(), caché incluida, y sus variables y funciones quedan definidas en
+ * el shell. No se informan los comandos que fallan ni se imprime el resumen; los errores de sintaxis sí.
+ *
+ * @param argc Número de argumentos.
+ * @param argv Argumentos: el archivo y, opcionalmente, los parámetros posicionales mientras se ejecuta.
+ * @return int Estado del último comando ejecutado, 1 si el archivo no se pudo abrir o 2 si falta el archivo.
+ */
+int manejar_comando_source(int argc, char** argv);
+
+#endif // BATCH_H
@@ -0,0 +1,304 @@
+/**
+ * @file builtins.h
+ * @brief Registro de comandos internos del shell.
+ *
+ * Los comandos internos se declaran en src/builtins.manifest. En tiempo de compilación, CMake genera a partir de ese
+ * manifiesto una tabla ordenada por nombre (builtins_tabla.h) que buscar_builtin() recorre con búsqueda binaria, de
+ * modo que un comando externo se descarta con unas pocas comparaciones en lugar de probar cada comando interno.
+ */
+
+#ifndef BUILTINS_H
+#define BUILTINS_H
+
+#include <stdbool.h>
+
+/**
+ * @brief Función que ejecuta un comando interno sobre sus argumentos ya tokenizados.
+ *
+ * @param argc Número de argumentos, incluyendo el nombre del comando.
+ * @param argv Argumentos terminados en NULL; argv[0] es el nombre del comando.
+ * @return int Estado de salida del comando (0 si tuvo éxito).
+ */
+typedef int (*manejador_builtin)(int argc, char** argv);
+
+/**
+ * @brief Descriptor de un comando interno.
+ */
+typedef struct
+{
+    const char* nombre;          /**< Nombre con el que se invoca el comando */
+    manejador_builtin manejador; /**< Función que lo ejecuta */
+    bool en_pipeline;            /**< Puede ser una etapa de un pipe */
+    bool requiere_fork;          /**< Como etapa de un pipe, debe ejecutarse siempre en un proceso hijo */
+    bool usa_flujos;             /**< En el shell, sus redirecciones reemplazan stdin, stdout y stderr */
+    bool reemplaza_externo;      /**< Reemplaza a un programa externo; sólo se usa con "set -o internos" */
+} descriptor_builtin;
+
+/**
+ * @brief Busca un comando interno por nombre.
+ *
+ * @param nombre Nombre del comando (argv[0]).
+ * @return const descriptor_builtin* Descriptor del comando, o NULL si no es un comando interno.
+ */
+const descriptor_builtin* buscar_builtin(const char* nombre);
+
+/**
+ * @brief Elige el comando interno que ejecutará un comando, si corresponde.
+ *
+ * Un comando que reemplaza a un programa externo (ver core_utils.h) sólo se elige con "set -o internos" y si
+ * utilidad_aplicable() acepta sus argumentos.
+ *
+ * @param args Argumentos del comando terminados en NULL; args[0] no es NULL.
+ * @return const descriptor_builtin* Descriptor del comando, o NULL si debe ejecutarse un programa.
+ */
+const descriptor_builtin* elegir_builtin(char** args);
+
+/**
+ * @brief Comando interno 'bg': reanuda un trabajo en segundo plano.
+ * @param argc Número de argumentos.
+ * @param argv Argumentos del comando.
+ * @return int Estado de salida.
+ */
+int builtin_bg(int argc, char** argv);
+
+/**
+ * @brief Comando interno 'buscar_config': busca un texto en los archivos de configuración de un árbol, en paralelo.
+ * @param argc Número de argumentos.
+ * @param argv Argumentos del comando.
+ * @return int Estado de salida.
+ */
+int builtin_buscar_config(int argc, char** argv);
+
+/**
+ * @brief Comando interno 'cat': concatena archivos en la salida estándar (reemplaza al programa cat).
+ * @param argc Número de argumentos.
+ * @param argv Argumentos del comando.
+ * @return int Estado de salida.
+ */
+int builtin_cat(int argc, char** argv);
+
+/**
+ * @brief Comando interno 'cd': cambia el directorio de trabajo.
+ * @param argc Número de argumentos.
+ * @param argv Argumentos del comando.
+ * @return int Estado de salida.
+ */
+int builtin_cd(int argc, char** argv);
+
+/**
+ * @brief Comando interno 'clr': limpia la pantalla.
+ * @param argc Número de argumentos.
+ * @param argv Argumentos del comando.
+ * @return int Estado de salida.
+ */
+int builtin_clr(int argc, char** argv);
+
+/**
+ * @brief Comando interno 'echo': imprime sus argumentos.
+ * @param argc Número de argumentos.
+ * @param argv Argumentos del comando.
+ * @return int Estado de salida.
+ */
+int builtin_echo(int argc, char** argv);
+
+/**
+ * @brief Comando interno 'explorar_config': busca archivos de configuración en un árbol de directorios, en paralelo.
+ * @param argc Número de argumentos.
+ * @param argv Argumentos del comando.
+ * @return int Estado de salida.
+ */
+int builtin_explorar_config(int argc, char** argv);
+
+/**
+ * @brief Comando interno 'export': pasa variables del shell al entorno de los programas que se ejecuten.
+ * @param argc Número de argumentos.
+ * @param argv Argumentos del comando.
+ * @return int Estado de salida.
+ */
+int builtin_export(int argc, char** argv);
+
+/**
+ * @brief Comando interno 'false': termina con estado 1 (reemplaza al programa false).
+ * @param argc Número de argumentos.
+ * @param argv Argumentos del comando.
+ * @return int Estado de salida.
+ */
+int builtin_false(int argc, char** argv);
+
+/**
+ * @brief Comando interno 'fdcheck': lista los descriptores del shell o los que deja abiertos un comando.
+ * @param argc Número de argumentos.
+ * @param argv Argumentos del comando.
+ * @return int Estado de salida.
+ */
+int builtin_fdcheck(int argc, char** argv);
+
+/**
+ * @brief Comando interno 'fg': trae un trabajo a primer plano.
+ * @param argc Número de argumentos.
+ * @param argv Argumentos del comando.
+ * @return int Estado de salida.
+ */
+int builtin_fg(int argc, char** argv);
+
+/**
+ * @brief Comando interno 'hash': administra la caché de ubicación de comandos.
+ * @param argc Número de argumentos.
+ * @param argv Argumentos del comando.
+ * @return int Estado de salida.
+ */
+int builtin_hash(int argc, char** argv);
+
+/**
+ * @brief Comando interno 'head': muestra las primeras líneas de archivos (reemplaza al programa head).
+ * @param argc Número de argumentos.
+ * @param argv Argumentos del comando.
+ * @return int Estado de salida.
+ */
+int builtin_head(int argc, char** argv);
+
+/**
+ * @brief Comando interno 'jobs': lista los trabajos en segundo plano y detenidos.
+ * @param argc Número de argumentos.
+ * @param argv Argumentos del comando.
+ * @return int Estado de salida.
+ */
+int builtin_jobs(int argc, char** argv);
+
+/**
+ * @brief Comando interno 'metrics_query': agregados del historial de métricas del monitor en una ventana de tiempo.
+ * @param argc Número de argumentos.
+ * @param argv Argumentos del comando.
+ * @return int Estado de salida.
+ */
+int builtin_metrics_query(int argc, char** argv);
+
+/**
+ * @brief Comando interno 'monitor_top': muestra las métricas que publica el monitor en memoria compartida.
+ * @param argc Número de argumentos.
+ * @param argv Argumentos del comando.
+ * @return int Estado de salida.
+ */
+int builtin_monitor_top(int argc, char** argv);
+
+/**
+ * @brief Comando interno 'parallel': ejecuta un comando sobre muchos elementos con un grupo de trabajadores.
+ * @param argc Número de argumentos.
+ * @param argv Argumentos del comando.
+ * @return int Estado de salida.
+ */
+int builtin_parallel(int argc, char** argv);
+
+/**
+ * @brief Comando interno 'pipestatus': imprime el código de salida de cada etapa del último pipe.
+ * @param argc Número de argumentos.
+ * @param argv Argumentos del comando.
+ * @return int Estado de salida.
+ */
+int builtin_pipestatus(int argc, char** argv);
+
+/**
+ * @brief Comando interno 'prompt': muestra o elige los segmentos del prompt.
+ * @param argc Número de argumentos.
+ * @param argv Argumentos del comando.
+ * @return int Estado de salida.
+ */
+int builtin_prompt(int argc, char** argv);
+
+/**
+ * @brief Comando interno 'quit': libera los recursos y sale del shell.
+ * @param argc Número de argumentos.
+ * @param argv Argumentos del comando.
+ * @return int Estado de salida.
+ */
+int builtin_quit(int argc, char** argv);
+
+/**
+ * @brief Comando interno 'set': consulta y modifica las opciones del shell.
+ * @param argc Número de argumentos.
+ * @param argv Argumentos del comando.
+ * @return int Estado de salida.
+ */
+int builtin_set(int argc, char** argv);
+
+/**
+ * @brief Comando interno 'source': ejecuta un archivo de comandos en el shell actual.
+ * @param argc Número de argumentos.
+ * @param argv Argumentos del comando.
+ * @return int Estado de salida.
+ */
+int builtin_source(int argc, char** argv);
+
+/**
+ * @brief Comando interno 'start_monitor': inicia el proceso de monitoreo.
+ * @param argc Número de argumentos.
+ * @param argv Argumentos del comando.
+ * @return int Estado de salida.
+ */
+int builtin_start_monitor(int argc, char** argv);
+
+/**
+ * @brief Comando interno 'status_monitor': muestra el estado del proceso de monitoreo.
+ * @param argc Número de argumentos.
+ * @param argv Argumentos del comando.
+ * @return int Estado de salida.
+ */
+int builtin_status_monitor(int argc, char** argv);
+
+/**
+ * @brief Comando interno 'stop_monitor': detiene el proceso de monitoreo.
+ * @param argc Número de argumentos.
+ * @param argv Argumentos del comando.
+ * @return int Estado de salida.
+ */
+int builtin_stop_monitor(int argc, char** argv);
+
+/**
+ * @brief Comando interno 'tail': muestra las últimas líneas de archivos (reemplaza al programa tail).
+ * @param argc Número de argumentos.
+ * @param argv Argumentos del comando.
+ * @return int Estado de salida.
+ */
+int builtin_tail(int argc, char** argv);
+
+/**
+ * @brief Comando interno 'test': evalúa una expresión condicional (reemplaza al programa test).
+ * @param argc Número de argumentos.
+ * @param argv Argumentos del comando.
+ * @return int Estado de salida.
+ */
+int builtin_test(int argc, char** argv);
+
+/**
+ * @brief Comando interno 'true': termina con estado 0 (reemplaza al programa true).
+ * @param argc Número de argumentos.
+ * @param argv Argumentos del comando.
+ * @return int Estado de salida.
+ */
+int builtin_true(int argc, char** argv);
+
+/**
+ * @brief Comando interno 'unset': elimina variables del shell y del entorno.
+ * @param argc Número de argumentos.
+ * @param argv Argumentos del comando.
+ * @return int Estado de salida.
+ */
+int builtin_unset(int argc, char** argv);
+
+/**
+ * @brief Comando interno 'update_config': actualiza la configuración del monitor.
+ * @param argc Número de argumentos.
+ * @param argv Argumentos del comando.
+ * @return int Estado de salida.
+ */
+int builtin_update_config(int argc, char** argv);
+
+/**
+ * @brief Comando interno 'wc': cuenta líneas y bytes de archivos (reemplaza al programa wc).
+ * @param argc Número de argumentos.
+ * @param argv Argumentos del comando.
+ * @return int Estado de salida.
+ */
+int builtin_wc(int argc, char** argv);
+
+#endif // BUILTINS_H
@@ -0,0 +1,188 @@
+/**
+ * @file bytecode.h
+ * @brief Compilación de listas de comandos a un programa de bytecode compacto.
+ *
+ * El árbol que produce parsear_comandos() se compila una sola vez en un programa plano que ejecuta la máquina virtual
+ * de vm.h: las estructuras de control (if, while, until, for, case, '&&', '||', '!') se vuelven saltos entre
+ * instrucciones, de modo que un ciclo no vuelve a recorrer el árbol ni crea procesos para evaluarse. Cada pipe queda
+ * como una instrucción OP_EJECUTAR que apunta a sus tablas de etapas, palabras y redirecciones.
+ *
+ * El programa ocupa un único bloque contiguo y no contiene punteros: una cabecera seguida de las tablas de
+ * instrucciones, pipes, etapas, palabras y redirecciones (cada una alineada a 8 bytes) y de las cadenas, todas
+ * referidas por índice o desplazamiento. Por eso puede copiarse, guardarse en un archivo o mapearse tal cual;
+ * programa_abrir() valida un bloque de origen desconocido antes de ejecutarlo.
+ */
+
+#ifndef BYTECODE_H
+#define BYTECODE_H
+
+#include "arena.h"
+#include "parser.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+/**
+ *  @brief Identificación de un programa de bytecode ("SHBC")
+ */
+#define BYTECODE_MAGIA 0x43424853u
+
+/**
+ *  @brief Versión del formato; cambia con cualquier cambio en las estructuras o en el significado de los códigos
+ */
+#define BYTECODE_VERSION 1u
+
+/**
+ *  @brief Máximo de ciclos anidados dentro de un mismo cuerpo (el programa principal o una función)
+ */
+#define BYTECODE_MAX_CICLOS 32
+
+/**
+ * @brief Código de operación de una instrucción.
+ *
+ * "Estado" es el código de salida del último comando (ultimo_estado, o $?).
+ */
+typedef enum
+{
+    OP_EJECUTAR,        /**< Ejecutar el pipe a */
+    OP_ASIGNAR,         /**< Asignar las n palabras nombre=valor desde la palabra a */
+    OP_SALTAR,          /**< Saltar a la instrucción a */
+    OP_SALTAR_SI_FALLA, /**< Saltar a la instrucción a si el estado no es 0 */
+    OP_SALTAR_SI_EXITO, /**< Saltar a la instrucción a si el estado es 0 */
+    OP_NEGAR,           /**< Invertir el estado: 0 pasa a 1 y cualquier otro valor a 0 */
+    OP_ESTADO,          /**< Fijar el estado en a */
+    OP_CICLO_INICIO,    /**< Abrir el ciclo n con estado 0 */
+    OP_CICLO_GUARDAR,   /**< Guardar el estado como estado del ciclo n y cerrar los ciclos más internos */
+    OP_CICLO_FIN,       /**< Cerrar el ciclo n (y los más internos) y volver al estado guardado */
+    OP_PARA_INICIO,     /**< Abrir el ciclo n de un for con los campos de las b palabras desde la palabra a */
+    OP_PARA_SIGUIENTE,  /**< Asignar el siguiente campo del ciclo n a la variable de la cadena a, o saltar a b */
+    OP_CASO_SUJETO,     /**< Expandir la palabra a como sujeto del case */
+    OP_CASO_PROBAR,     /**< Saltar a b si el sujeto coincide con el patrón de la palabra a */
+    OP_FUNCION,         /**< Definir la función de nombre a, cuyo cuerpo sigue, y saltar a b */
+    OP_RETORNAR,        /**< Terminar la función; con n = 1, el estado es el valor de la palabra a */
+    OP_FIN,             /**< Terminar el programa */
+    OP_CANTIDAD         /**< Cantidad de códigos de operación */
+} codigo_operacion;
+
+/**
+ * @brief Cabecera del bloque de un programa.
+ */
+typedef struct
+{
+    uint32_t magia;             /**< BYTECODE_MAGIA */
+    uint32_t version;           /**< BYTECODE_VERSION */
+    uint32_t num_instrucciones; /**< Instrucciones del programa */
+    uint32_t num_pipelines;     /**< Pipes */
+    uint32_t num_etapas;        /**< Etapas de todos los pipes */
+    uint32_t num_palabras;      /**< Palabras de las etapas, de los for y de los case */
+    uint32_t num_redirecciones; /**< Redirecciones de las etapas */
+    uint32_t largo_cadenas;     /**< Bytes de la tabla de cadenas, terminadores incluidos */
+} cabecera_programa;
+
+/**
+ * @brief Instrucción: código y hasta tres operandos.
+ */
+typedef struct
+{
+    uint16_t op; /**< Código de operación (codigo_operacion) */
+    uint16_t n;  /**< Operando pequeño: número de ciclo, cantidad de palabras o indicador */
+    uint32_t a;  /**< Primer operando */
+    uint32_t b;  /**< Segundo operando */
+} instruccion;
+
+/**
+ * @brief Pipe compilado.
+ */
+typedef struct
+{
+    uint32_t primera_etapa;    /**< Índice de su primera etapa */
+    uint32_t num_etapas;       /**< Cantidad de etapas */
+    uint32_t en_segundo_plano; /**< 1 si el pipe terminaba con '&' */
+    int32_t linea;             /**< Línea del texto donde empieza el pipe */
+} pipeline_compilado;
+
+/**
+ * @brief Etapa compilada: un comando simple.
+ */
+typedef struct
+{
+    uint32_t primera_palabra;     /**< Índice de su primera palabra */
+    uint32_t num_palabras;        /**< Cantidad de palabras */
+    uint32_t primera_redireccion; /**< Índice de su primera redirección */
+    uint32_t num_redirecciones;   /**< Cantidad de redirecciones */
+} etapa_compilada;
+
+/**
+ * @brief Palabra compilada.
+ */
+typedef struct
+{
+    uint32_t texto;    /**< Desplazamiento del texto en la tabla de cadenas */
+    uint32_t expandir; /**< 1 si la palabra contiene expansiones */
+} palabra_compilada;
+
+/**
+ * @brief Redirección compilada.
+ */
+typedef struct
+{
+    uint32_t tipo;             /**< tipo_redireccion */
+    int32_t fd;                /**< Descriptor redirigido */
+    palabra_compilada destino; /**< Archivo o descriptor destino */
+} redireccion_compilada;
+
+/**
+ * @brief Programa abierto: punteros a cada tabla dentro del bloque.
+ */
+typedef struct
+{
+    const cabecera_programa* cabecera;          /**< Cabecera, al principio del bloque */
+    const instruccion* instrucciones;           /**< Instrucciones */
+    const pipeline_compilado* pipelines;        /**< Pipes */
+    const etapa_compilada* etapas;              /**< Etapas */
+    const palabra_compilada* palabras;          /**< Palabras */
+    const redireccion_compilada* redirecciones; /**< Redirecciones */
+    const char* cadenas;                        /**< Tabla de cadenas */
+    size_t largo;                               /**< Tamaño del bloque completo */
+} programa;
+
+/**
+ * @brief Compila una lista de comandos en un programa.
+ *
+ * Además de las estructuras de control, se resuelven al compilar 'break [n]' y 'continue [n]' (saltos a la salida o
+ * a la próxima vuelta del ciclo n), 'return [valor]' y los comandos formados sólo por asignaciones nombre=valor.
+ * Usarlos fuera de un ciclo o de una función es un error de compilación. Una función se compila en línea, a
+ * continuación de su instrucción OP_FUNCION, y dentro de ella no se ven los ciclos del cuerpo que la define.
+ *
+ * @param lista Lista producida por parsear_comandos(); el programa no la referencia.
+ * @param a Arena donde se reserva el bloque del programa.
+ * @param salida Salida: programa abierto.
+ * @param error Buffer para el mensaje de error.
+ * @param tam_error Tamaño del buffer de error.
+ * @return int 0 si se compiló, -1 si hay un error (ya escrito en el buffer).
+ */
+int compilar_lista(const lista_comandos* lista, arena* a, programa* salida, char* error, size_t tam_error);
+
+/**
+ * @brief Abre un programa guardado en un bloque, verificando que sea válido.
+ *
+ * Comprueba la cabecera, que el tamaño del bloque coincida exactamente con el de sus tablas, que todos los índices,
+ * desplazamientos y destinos de salto estén dentro de sus tablas, que la tabla de cadenas termine en '\0' y que la
+ * última instrucción sea OP_FIN u OP_RETORNAR. Un programa abierto sin errores puede ejecutarse sin más controles.
+ *
+ * @param bloque Bloque del programa, alineado a 8 bytes; no se copia.
+ * @param largo Tamaño del bloque.
+ * @param p Salida: programa abierto.
+ * @return int 0 si el bloque es válido, -1 si no.
+ */
+int programa_abrir(const void* bloque, size_t largo, programa* p);
+
+/**
+ * @brief Escribe un listado legible del programa: una línea por instrucción, con el texto de cada pipe.
+ *
+ * @param p Programa.
+ * @param salida Flujo donde se escribe el listado.
+ */
+void programa_volcar(const programa* p, FILE* salida);
+
+#endif // BYTECODE_H
@@ -6,7 +6,9 @@
 #ifndef COMMANDS_H
 #define COMMANDS_H
 
+#include "bytecode.h"
 #include "globals.h"
+#include "parser.h"
 #include <fcntl.h>  // Add this line to include the definition of O_CREAT and other file control options
 #include <signal.h> // Add this line to include the definition of SIGCONT
 #include <stdbool.h>
@@ -20,16 +22,60 @@
 /**
  * @brief Analiza y ejecuta un comando dado.
  *
- * Esta función toma un comando en forma de cadena, lo analiza y ejecuta la acción correspondiente.
- * Soporta comandos internos como "cd", "clr", "echo", "quit", "fg", "bg", "start_monitor", "stop_monitor",
- * "status_monitor" y "update_config". Si el comando no es reconocido como un comando interno, se intenta
- * ejecutar como un programa externo.
+ * Esta función analiza la línea completa en una sola pasada (ver parser.h), sin límite de longitud, y ejecuta el
+ * árbol resultante con ejecutar_lista(). Los nodos se reservan en una arena propia de la línea que se libera de una
+ * vez al terminar. Si la línea tiene un error de sintaxis no se ejecuta ningún comando.
  *
- * @param comando La cadena de caracteres que contiene el comando a analizar.
+ * @param comando La cadena de caracteres que contiene el comando a analizar; no se modifica.
  * @return int Retorna 0 si el comando fue procesado correctamente.
  */
 int analizar_comando(char*);
 
+/**
+ * @brief Compila una lista de comandos a bytecode y la ejecuta con ejecutar_programa().
+ *
+ * El programa se reserva en la arena de la línea. Si la lista no puede compilarse (por ejemplo, un break fuera de un
+ * ciclo) se informa el error, no se ejecuta ningún comando y el estado pasa a ser 2.
+ *
+ * @param lista Lista de comandos producida por parsear_comandos(); puede estar en cualquier arena.
+ */
+void ejecutar_lista(const lista_comandos*);
+
+/**
+ * @brief Ejecuta un programa ya compilado con la máquina virtual (ver vm.h).
+ *
+ * La ejecución se detiene si un comando pide salir del shell. Al terminar se libera la memoria usada por las
+ * expansiones (y por el árbol y el programa, si los construyó analizar_comando()). Con --dump-bytecode el programa
+ * se lista antes en stderr.
+ *
+ * @param p Programa abierto; puede estar en cualquier arena o mapeado de un archivo.
+ */
+void ejecutar_programa(const programa*);
+
+/**
+ * @brief Ejecuta un pipe: los de una sola etapa con ejecutar_comando_simple() y el resto con ejecutar_pipeline().
+ *
+ * Lo que reservan sus expansiones se libera al terminar, de modo que la máquina virtual puede ejecutar un pipe
+ * cualquier cantidad de veces sin acumular memoria.
+ *
+ * @param p Pipe a ejecutar; debe seguir siendo válido hasta que termine.
+ */
+void ejecutar_pipe(const pipeline*);
+
+/**
+ * @brief Ejecuta un comando simple que no forma parte de un pipe.
+ *
+ * Las palabras se expanden al momento de ejecutar. El nombre del comando se busca primero entre las funciones del
+ * shell (ver vm.h) y después en la tabla de comandos internos generada a partir de src/builtins.manifest (ver
+ * builtins.h); una función o un comando interno se ejecuta en el propio shell, con sus redirecciones aplicadas sólo
+ * mientras dura. Si no es ninguno de los dos, o si termina en '&', se ejecuta en otro proceso, igual que un pipe de
+ * una sola etapa (ver ejecutar_pipeline()).
+ *
+ * @param comando Comando simple a ejecutar.
+ * @param en_segundo_plano true si el comando terminaba con '&'.
+ */
+void ejecutar_comando_simple(const comando_simple*, bool);
+
 /**
  * @brief Maneja el comando 'cd' para cambiar el directorio de trabajo actual.
  *
@@ -70,7 +116,8 @@ void cambiar_a_directorio(const char*);
  * (OLDPWD).
  *
  * Esta función guarda el directorio de trabajo actual en la variable de entorno `OLDPWD`,
- * luego actualiza la variable de entorno `PWD` al nuevo directorio de trabajo actual.
+ * luego actualiza la variable de entorno `PWD` al nuevo directorio de trabajo actual y avisa
+ * al prompt (ver prompt_directorio_cambiado()).
  * Si no se puede obtener el directorio de trabajo actual, se imprime un mensaje de error.
  *
  * @note Esta función asume que `cwd` es una variable global de tipo `char[]` con suficiente tamaño para contener la
@@ -88,120 +135,101 @@ void actualizar_pwd(void);
 void limpiar_pantalla(void);
 
 /**
- * @brief Ejecuta el comando echo con soporte para redirección y variables de entorno.
+ * @brief Ejecuta el comando echo.
  *
- * Esta función toma un argumento de cadena, lo tokeniza y procesa cada token.
- * Si se encuentra una redirección de entrada o salida, se maneja adecuadamente.
- * Además, si un token comienza con '$', se interpreta como una variable de entorno
- * y se imprime su valor. Si la variable no existe, se imprime un espacio.
- * Finalmente, se imprimen todos los tokens con un espacio entre ellos y una nueva línea al final.
+ * Esta función recibe los argumentos que siguen a "echo", ya expandidos y sin redirecciones, y los imprime
+ * separados por un espacio, con una nueva línea al final.
  *
- * @param argumento La cadena de texto que contiene el comando y sus argumentos.
+ * @param args Argumentos a imprimir, terminados en NULL.
  */
-void ejecutar_echo(char*);
-
-/**
- * @brief Ejecuta un programa externo dado un comando.
- *
- * Esta función toma un comando como entrada, lo tokeniza en una lista de argumentos,
- * y luego crea un proceso hijo para ejecutar el programa especificado.
- * Soporta la ejecución en segundo plano si el comando termina con '&'.
- *
- * @param comando El comando a ejecutar, incluyendo sus argumentos.
- *
- * La función realiza las siguientes acciones:
- * - Tokeniza el comando en una lista de argumentos.
- * - Verifica si el comando debe ejecutarse en segundo plano.
- * - Crea un proceso hijo usando fork().
- * - En el proceso hijo, establece el grupo de procesos y maneja redirecciones antes de ejecutar el programa.
- * - En el proceso padre, maneja la ejecución en primer o segundo plano, y actualiza la lista de trabajos en segundo
- * plano.
- *
- * @note Si el comando está vacío, la función retorna sin hacer nada.
- * @note Si ocurre un error al crear el proceso hijo o al ejecutar el programa, se imprime un mensaje de error.
- */
-void ejecutar_programa_externo(char*);
+void ejecutar_echo(char**);
 
 /**
  * @brief Maneja el comando 'fg' para reanudar un trabajo en primer plano.
  *
- * Esta función toma un número de trabajo, lo convierte en un PID y envía
- * una señal SIGCONT para reanudar el proceso en primer plano. Luego espera
- * a que el proceso termine o sea suspendido.
- *
- * @param job_number El número del trabajo que se desea reanudar.
+ * Busca el trabajo indicado (%n, %+, %- o un PID; sin argumento, el trabajo actual), le entrega la terminal, le envía
+ * SIGCONT y espera a sus procesos vivos. Si el trabajo vuelve a detenerse queda en la tabla como detenido; si termina
+ * se elimina.
  *
- * @note Si el PID no es válido, se imprime un mensaje de error.
- * @note Si ocurre un error al enviar la señal SIGCONT, se imprime un mensaje de error.
+ * @param argc Número de argumentos, incluyendo "fg".
+ * @param argv Argumentos del comando.
+ * @return int Estado de salida del trabajo, 128 más SIGTSTP si se detuvo, o 1 si el trabajo no existe.
  */
-void manejar_comando_fg(int);
+int manejar_comando_fg(int, char**);
 
 /**
- * @brief Maneja el comando para reanudar un trabajo en segundo plano.
+ * @brief Maneja el comando 'bg' para reanudar en segundo plano un trabajo detenido.
  *
- * Esta función toma un número de trabajo, lo convierte en un PID y envía
- * la señal SIGCONT para reanudar el proceso en segundo plano. Si el PID
- * no es válido, imprime un mensaje de error. Si la señal SIGCONT se envía
- * correctamente, el proceso se agrega a la lista de trabajos en segundo plano.
- *
- * @param job_number El número del trabajo que se desea reanudar.
+ * @param argc Número de argumentos, incluyendo "bg".
+ * @param argv Argumentos del comando; argv[1] es el trabajo (%n, %+, %- o un PID), por defecto el actual.
+ * @return int 0 si el trabajo se reanudó o ya estaba en ejecución, 1 si no existe.
  */
-void manejar_comando_bg(int);
+int manejar_comando_bg(int, char**);
 
 /**
  * @brief Ejecutar un comando con pipes
  *
  * Esta función toma una cadena de comando que puede contener múltiples comandos
- * separados por el carácter '|', los divide y los ejecuta en una secuencia de
- * procesos conectados por pipes.
+ * separados por el carácter '|', la analiza y la ejecuta con ejecutar_pipeline().
  *
  * @param comando Una cadena de caracteres que contiene los comandos a ejecutar,
  * separados por el carácter '|'.
- *
- * La función realiza los siguientes pasos:
- * 1. Divide la cadena de comando en segmentos separados por '|'.
- * 2. Crea un pipe para conectar los procesos.
- * 3. Usa fork() para crear un nuevo proceso hijo para cada comando.
- * 4. Redirecciona la entrada y salida estándar según sea necesario para conectar
- *    los procesos a través del pipe.
- * 5. Ejecuta el comando actual en el proceso hijo.
- * 6. En el proceso padre, actualiza el descriptor de archivo de entrada para la
- *    próxima iteración.
- * 7. Espera a que todos los procesos hijos terminen antes de finalizar.
- *
- * @warning Si ocurre un error al crear el pipe o al hacer fork(), la función
- *          imprimirá un mensaje de error y terminará el proceso.
  */
 void ejecutar_comando_con_pipes(char*);
 
 /**
- * @brief Maneja las redirecciones de entrada y salida en un comando.
+ * @brief Ejecutar las etapas de un pipe ya analizado
  *
- * Esta función recorre los argumentos de un comando en busca de operadores de redirección
- * de entrada ("<") y salida (">"). Si encuentra un operador de redirección, abre el archivo
- * correspondiente y redirige el flujo estándar (stdin o stdout) al archivo especificado.
+ * @param p Pipe con sus etapas; las palabras de todas las etapas se expanden antes de lanzar la primera.
  *
- * @param args Array de cadenas de caracteres que representan los argumentos del comando.
- *             El array debe estar terminado en NULL.
+ * La función realiza los siguientes pasos:
+ * 1. Crea un pipe con O_CLOEXEC para conectar cada comando con el siguiente.
+ * 2. Prepara un plan de spawn por comando que redirecciona la entrada y salida
+ *    estándar a los pipes y agrega las redirecciones propias de la etapa.
+ * 3. Lanza exactamente un proceso por etapa con posix_spawn(); los comandos internos en
+ *    medio del pipe, o marcados en el manifiesto como etapas que requieren un hijo, y las funciones
+ *    del shell usan fork().
+ *    Todas las etapas comparten un grupo de procesos, cuyo líder es la primera etapa lanzada.
+ *    Los comandos internos del principio y del final del pipe no crean procesos: se ejecutan
+ *    en el propio shell, escribiendo directo en el pipe o leyendo de él, y los que quedan
+ *    uno al lado del otro se conectan con buffers en memoria (memfd) en lugar de pipes.
+ * 4. En el proceso padre, cierra cada extremo apenas se entrega al hijo.
+ * 5. Si el pipe terminaba con '&', lo registra como un trabajo en segundo plano.
+ *    En otro caso entrega la terminal al grupo (en modo interactivo) y espera sólo a
+ *    sus etapas con esperar_procesos(), sin recolectar otros hijos del shell.
+ * 6. Guarda el código de salida de cada etapa (ver el comando "pipestatus") y el estado
+ *    del pipe en ultimo_estado: el de la última etapa o, con "set -o pipefail", el de la
+ *    última etapa que falló.
+ *
+ * @warning Si ocurre un error al crear el pipe, la función imprime un mensaje
+ *          de error y no lanza el resto de los comandos.
+ */
+void ejecutar_pipeline(const pipeline*);
+
+/**
+ * @brief Maneja el comando 'set' para consultar y modificar las opciones del shell.
  *
- * @note Esta función modifica el array de argumentos para eliminar los operadores de redirección
- *       y los nombres de archivo correspondientes.
+ * Formatos soportados:
+ * - set o set -o: lista las opciones con su estado.
+ * - set -o opción: activa la opción.
+ * - set +o opción: desactiva la opción.
  *
- * @warning Si no se puede abrir un archivo de redirección, se imprime un mensaje de error y
- *          la función retorna sin realizar ninguna redirección.
+ * Opciones reconocidas: pipefail e internos (versiones internas de cat, wc, head, tail, true, false y
+ * test; ver core_utils.h).
+ *
+ * @param argc Número de argumentos, incluyendo "set".
+ * @param argv Argumentos del comando.
+ * @return int 0 si la operación fue válida, 1 si la opción no existe, 2 si el uso es incorrecto.
  */
-void manejar_redirecciones(char**);
+int manejar_comando_set(int, char**);
 
 /**
- * @brief Explora un directorio en busca de archivos de configuración.
- *
- * Esta función toma un directorio y una extensión de archivo como entrada, y busca
- * todos los archivos con la extensión especificada en el directorio dado. Para cada
- * archivo encontrado, imprime su nombre y tamaño en bytes.
+ * @brief Maneja el comando 'pipestatus': imprime el código de salida de cada etapa del último pipe.
  *
- * @param directorio La ruta del directorio a explorar en busca de archivos de configuración.
- * @param extension La extensión de archivo que se utilizará para buscar archivos de configuración.
+ * @param argc Número de argumentos, incluyendo "pipestatus".
+ * @param argv Argumentos del comando.
+ * @return int Siempre 0.
  */
-void buscar_configuraciones(const char*, const char*);
+int manejar_comando_pipestatus(int, char**);
 
 #endif // COMMANDS_H
@@ -0,0 +1,206 @@
+/**
+ * @file config_explorer.h
+ * @brief Comando interno 'explorar_config': recorrido paralelo de un árbol de directorios en busca de archivos.
+ *
+ * Cada directorio se lee con getdents64() sobre un descriptor abierto con openat() respecto del de su padre, así las
+ * rutas no se recortan ni se resuelven otra vez desde la raíz. Los directorios pendientes se reparten entre hilos
+ * trabajadores, cada uno con su propia pila; el que se queda sin trabajo roba el directorio más antiguo de la pila de
+ * otro, que suele ser el de un subárbol más grande.
+ *
+ * Las entradas de cada directorio se ordenan por nombre y el hilo que llamó a explorar_directorio() las entrega en
+ * orden de recorrido en profundidad a medida que los trabajadores las completan: la salida es siempre la misma y
+ * empieza antes de que termine el recorrido.
+ *
+ * Si d_type es DT_UNKNOWN (algunos sistemas de archivos no lo informan) el tipo se consulta con fstatat(). Los
+ * enlaces simbólicos no se siguen salvo que se pida; un directorio que ya está entre sus ancestros (mismo dispositivo
+ * e inodo) se informa como bucle y no se recorre.
+ *
+ * El comando consulta primero el índice persistente de config_index.h y sólo recorre lo que cambió, y vuelca el
+ * contenido de los archivos con file_stream.h, sin copiarlo a buffers del shell.
+ */
+
+#ifndef CONFIG_EXPLORER_H
+#define CONFIG_EXPLORER_H
+
+#include <limits.h>
+#include <stdbool.h>
+
+/**
+ *  @brief Máximo de hilos trabajadores de una exploración
+ */
+#define EXPLORAR_MAX_TRABAJADORES 64
+
+/**
+ *  @brief Máximo de extensiones por exploración
+ */
+#define EXPLORAR_MAX_EXTENSIONES 8
+
+/**
+ *  @brief Extensión que busca 'explorar_config' si no se indica ningún filtro
+ */
+#define EXPLORAR_EXTENSION_PREDETERMINADA ".config"
+
+/**
+ *  @brief Paginador de 'explorar_config -p' si la variable de entorno PAGER no está definida
+ */
+#define EXPLORAR_PAGINADOR_PREDETERMINADO "less"
+
+/**
+ * @brief Filtros y parámetros de una exploración
+ */
+typedef struct
+{
+    int profundidad_maxima;                           /**< Niveles bajo el directorio inicial; -1 sin límite */
+    const char* extensiones[EXPLORAR_MAX_EXTENSIONES]; /**< Sufijos aceptados; sin ninguno, se acepta cualquiera */
+    int num_extensiones;                              /**< Extensiones */
+    const char* patron;                               /**< Patrón glob del nombre (fnmatch()), o NULL */
+    int trabajadores;                                 /**< Hilos trabajadores; 0 = uno por CPU */
+    bool seguir_enlaces;                              /**< Recorrer los enlaces simbólicos a directorios */
+    bool metadatos;                                   /**< Informar tamaño y modificación de los archivos */
+} opciones_exploracion;
+
+/**
+ * @brief Qué se encontró en una posición del recorrido
+ */
+typedef enum
+{
+    HALLAZGO_ARCHIVO,    /**< Archivo que cumple los filtros */
+    HALLAZGO_DIRECTORIO, /**< Directorio leído; sus entradas se entregan a continuación */
+    HALLAZGO_ERROR,      /**< Directorio que no se pudo abrir o leer */
+    HALLAZGO_BUCLE       /**< Directorio que ya es un ancestro: no se recorre */
+} tipo_hallazgo;
+
+/**
+ * @brief Un hallazgo del recorrido
+ */
+typedef struct
+{
+    tipo_hallazgo tipo;             /**< Tipo de hallazgo */
+    const char* ruta;               /**< Ruta del archivo o directorio; válida sólo durante la llamada */
+    int error;                      /**< Con HALLAZGO_ERROR, el valor de errno */
+    long long tamano;               /**< Archivos con metadatos: tamaño en bytes */
+    long long modificado_ns;        /**< Archivos con metadatos y directorios: st_mtim en nanosegundos */
+    unsigned long long dispositivo; /**< Directorios: dispositivo */
+    unsigned long long inodo;       /**< Directorios: inodo */
+    unsigned long long hash;        /**< Archivos entregados por el índice: FNV-1a del contenido; si no, 0 */
+} hallazgo;
+
+/**
+ * @brief Recibe cada hallazgo, en el hilo que llamó a explorar_directorio().
+ *
+ * @param h Hallazgo.
+ * @param dato Dato del llamador.
+ * @return true para continuar, false para terminar la exploración.
+ */
+typedef bool (*manejador_hallazgo)(const hallazgo* h, void* dato);
+
+/**
+ * @brief Indica si un nombre de archivo cumple los filtros: el patrón, si hay, y alguna extensión, si hay.
+ *
+ * @param opciones Filtros.
+ * @param nombre Nombre del archivo, sin directorio.
+ * @return true si cumple.
+ */
+bool explorar_cumple_filtros(const opciones_exploracion* opciones, const char* nombre);
+
+/**
+ * @brief Indica si una entrada de directorio es un subdirectorio a recorrer.
+ *
+ * @param fd Descriptor del directorio que contiene la entrada.
+ * @param nombre Nombre de la entrada.
+ * @param tipo d_type de la entrada; con DT_UNKNOWN, o con DT_LNK si se siguen enlaces, se consulta fstatat().
+ * @param seguir_enlaces Seguir los enlaces simbólicos.
+ * @return true si es un directorio.
+ */
+bool explorar_es_directorio(int fd, const char* nombre, unsigned char tipo, bool seguir_enlaces);
+
+/**
+ * @brief Recorre un árbol de directorios y entrega en orden los archivos que cumplen los filtros.
+ *
+ * @param directorio Directorio inicial; si es un enlace simbólico, se sigue.
+ * @param opciones Filtros y cantidad de trabajadores.
+ * @param manejador Manejador de los hallazgos.
+ * @param dato Dato que se pasa al manejador.
+ * @return long Archivos entregados, o -1 si no hay memoria.
+ */
+long explorar_directorio(const char* directorio, const opciones_exploracion* opciones, manejador_hallazgo manejador,
+                         void* dato);
+
+/**
+ * @brief Opciones de recorrido de un comando interno, leídas de la línea de comandos
+ */
+typedef struct
+{
+    opciones_exploracion opciones;                            /**< Filtros; las extensiones apuntan a 'extensiones' */
+    char extensiones[EXPLORAR_MAX_EXTENSIONES][NAME_MAX + 2]; /**< Extensiones indicadas, con su punto */
+    bool usar_indice;                                         /**< Consultar y actualizar el índice persistente */
+    bool reconstruir;                                         /**< Descartar el índice y reconstruirlo */
+} argumentos_exploracion;
+
+/**
+ * @brief Inicializa las opciones de recorrido: sin límite de profundidad ni filtros, consultando el índice.
+ *
+ * @param a Opciones a inicializar; no deben copiarse después, porque los filtros apuntan dentro de la estructura.
+ */
+void explorar_argumentos_inicializar(argumentos_exploracion* a);
+
+/**
+ * @brief Interpreta una opción de recorrido: -d N, -e extensión, -g patrón, -j N, -L, -n o -r.
+ *
+ * @param a Opciones de recorrido.
+ * @param argc Número de argumentos.
+ * @param argv Argumentos.
+ * @param i Posición de la opción; si la opción lleva un valor, avanza hasta él.
+ * @return true si la opción es de recorrido y es válida.
+ */
+bool explorar_argumentos_leer(argumentos_exploracion* a, int argc, char** argv, int* i);
+
+/**
+ * @brief Sin -e ni -g, busca los archivos EXPLORAR_EXTENSION_PREDETERMINADA.
+ *
+ * @param a Opciones de recorrido ya leídas.
+ */
+void explorar_argumentos_completar(argumentos_exploracion* a);
+
+/**
+ * @brief Entrega los hallazgos de un árbol con indice_explorar() o, con -n, con explorar_directorio().
+ *
+ * @param a Opciones de recorrido completas.
+ * @param directorio Directorio inicial.
+ * @param manejador Manejador de los hallazgos.
+ * @param dato Dato que se pasa al manejador.
+ * @return long Archivos entregados, o -1 si no hay memoria.
+ */
+long explorar_argumentos_ejecutar(const argumentos_exploracion* a, const char* directorio,
+                                  manejador_hallazgo manejador, void* dato);
+
+/**
+ * @brief Maneja el comando interno 'explorar_config'.
+ *
+ * Formato: explorar_config [-d N] [-e extensión]... [-g patrón] [-j N] [-L] [-n | -r] [-l | -i N | -f N] [-p]
+ *          [directorio]
+ *
+ * - -d N: descender a lo sumo N niveles (0: sólo los archivos del directorio).
+ * - -e extensión: buscar archivos que terminan en la extensión (con o sin el punto); puede repetirse.
+ * - -g patrón: buscar archivos cuyo nombre cumple el patrón glob (por ejemplo, "app*.json").
+ * - -j N: cantidad de trabajadores (por defecto, la cantidad de CPUs en línea).
+ * - -L: seguir los enlaces simbólicos a directorios.
+ * - -n: recorrer el árbol sin consultar ni actualizar el índice.
+ * - -r: descartar el índice y reconstruirlo.
+ * - -l: mostrar sólo la ruta de cada archivo, una por línea, sin encabezado ni contenido.
+ * - -i N: mostrar sólo las primeras N líneas de cada archivo.
+ * - -f N: mostrar sólo las últimas N líneas de cada archivo.
+ * - -p: si la salida es una terminal, mostrarla a través del paginador de $PAGER (por defecto,
+ *   EXPLORAR_PAGINADOR_PREDETERMINADO); el shell espera a que se cierre.
+ *
+ * Sin -e ni -g se buscan los archivos EXPLORAR_EXTENSION_PREDETERMINADA; sin directorio se explora el actual. Se
+ * muestra la ruta y el contenido de cada archivo encontrado; los archivos que no son regulares (FIFOs, dispositivos)
+ * se informan como error y no se leen.
+ *
+ * @param argc Número de argumentos, incluyendo "explorar_config".
+ * @param argv Argumentos del comando.
+ * @return int 0 si se recorrió todo, 1 si algún directorio o archivo no se pudo leer, 2 si el uso es incorrecto.
+ */
+int manejar_comando_explorar_config(int argc, char** argv);
+
+#endif // CONFIG_EXPLORER_H
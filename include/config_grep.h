@@ -0,0 +1,43 @@
+/**
+ * @file config_grep.h
+ * @brief Comando interno 'buscar_config': busca un texto en los archivos que encuentra 'explorar_config'.
+ *
+ * Los archivos se obtienen con el mismo recorrido (y el mismo índice persistente) que 'explorar_config' y se reparten
+ * entre hilos trabajadores. Cada trabajador lee el archivo entero en su propio buffer y busca con los núcleos
+ * vectoriales de simd_search.h: una expresión se acelera buscando primero el literal más largo que toda coincidencia
+ * debe contener, y sólo las líneas que lo tienen se verifican con la expresión. Los números de línea se calculan
+ * contando los saltos de línea entre una coincidencia y la anterior, también con instrucciones vectoriales.
+ *
+ * La salida de cada archivo se arma en memoria y se escribe en el orden del recorrido, sea cual sea el trabajador que
+ * la termine primero.
+ */
+
+#ifndef CONFIG_GREP_H
+#define CONFIG_GREP_H
+
+/**
+ *  @brief Máximo de elementos de una expresión de 'buscar_config -x'
+ */
+#define BUSCAR_MAX_ATOMOS 128
+
+/**
+ * @brief Maneja el comando interno 'buscar_config'.
+ *
+ * Formato: buscar_config [-d N] [-e extensión]... [-g patrón] [-j N] [-L] [-n | -r] [-x] texto [directorio]
+ *
+ * - -d, -e, -g, -j, -L, -n y -r: eligen los archivos como en 'explorar_config' (sin -e ni -g, los
+ *   EXPLORAR_EXTENSION_PREDETERMINADA); -j indica también los hilos que buscan.
+ * - -x: el texto es una expresión simple: '.' acepta cualquier carácter, '*' repite cero o más veces el elemento
+ *   anterior, '^' y '$' anclan al principio y al final de la línea, y '\' quita el significado especial del carácter
+ *   siguiente.
+ *
+ * Por cada línea que contiene el texto se muestra "ruta:número:línea". Los archivos que no son regulares se ignoran.
+ *
+ * @param argc Número de argumentos, incluyendo "buscar_config".
+ * @param argv Argumentos del comando.
+ * @return int 0 si alguna línea coincidió, 1 si ninguna, 2 si el uso es incorrecto o algún directorio o archivo no se
+ *             pudo leer.
+ */
+int manejar_comando_buscar_config(int argc, char** argv);
+
+#endif // CONFIG_GREP_H
@@ -0,0 +1,72 @@
+/**
+ * @file config_index.h
+ * @brief Índice persistente de los archivos que encuentra 'explorar_config'.
+ *
+ * Para cada directorio inicial y combinación de filtros se guarda en disco el árbol de directorios recorrido y los
+ * archivos que cumplen los filtros, con su tamaño, su última modificación y un hash FNV-1a de su contenido. Una
+ * consulta repetida se responde desde el índice en memoria y sólo vuelve a leer los directorios que cambiaron:
+ *
+ * - Mientras el shell está en ejecución, un descriptor de inotify vigila cada directorio del índice; sus avisos (que
+ *   atiende el bucle de eventos o, si no está activo, la consulta siguiente) marcan los directorios a revisar, y el
+ *   resto del árbol no se toca.
+ * - Un índice que se carga del disco, o que no se puede vigilar (por ejemplo, si se agota el límite de vigilancias
+ *   de inotify), se revalida por tiempo de modificación: un directorio cuyo dispositivo, inodo y st_mtim no cambiaron
+ *   conserva su lista de entradas y sólo se consultan sus archivos; uno que cambió se vuelve a listar. Un cambio
+ *   dentro de los INDICE_MARGEN_DUDOSO_NS anteriores a la última validación no basta para confiar en st_mtim (la
+ *   resolución del reloj del sistema de archivos puede ocultar una segunda modificación) y se vuelve a comprobar.
+ *
+ * Los índices se guardan en el directorio de la variable de entorno INDICE_ENV o, si no está definida, en
+ * $XDG_CACHE_HOME/ShellProject (o $HOME/.cache/ShellProject), de forma atómica y sólo si cambiaron.
+ */
+
+#ifndef CONFIG_INDEX_H
+#define CONFIG_INDEX_H
+
+#include "config_explorer.h"
+#include <stdbool.h>
+
+/**
+ *  @brief Variable de entorno con el directorio de los índices
+ */
+#define INDICE_ENV "SHELL_INDICE"
+
+/**
+ *  @brief Antigüedad mínima de una modificación, respecto de la última validación, para confiar en st_mtim
+ */
+#define INDICE_MARGEN_DUDOSO_NS 2000000000LL
+
+/**
+ * @brief Trabajo que hizo una consulta del índice
+ */
+typedef struct
+{
+    bool desde_disco;  /**< El índice se cargó del disco */
+    bool reconstruido; /**< No había índice (o no servía) y se recorrió todo el árbol */
+    long revisados;    /**< Directorios comprobados con stat() */
+    long releidos;     /**< Directorios que se volvieron a listar */
+} resumen_indice;
+
+/**
+ * @brief Entrega, como explorar_directorio(), los hallazgos de un árbol, consultando primero el índice.
+ *
+ * La secuencia de hallazgos es la misma que la de explorar_directorio() con los mismos filtros; los archivos traen
+ * además su tamaño, su última modificación y el hash de su contenido. Si no hay índice, el árbol se recorre y los
+ * hallazgos se entregan a medida que se encuentran; si el manejador termina antes, el índice incompleto no se guarda.
+ *
+ * @param directorio Directorio inicial.
+ * @param opciones Filtros; los trabajadores se usan para los recorridos completos.
+ * @param reconstruir Descartar el índice existente y recorrer todo el árbol.
+ * @param manejador Manejador de los hallazgos.
+ * @param dato Dato que se pasa al manejador.
+ * @param resumen Si no es NULL, recibe el trabajo que hizo la consulta.
+ * @return long Archivos entregados, o -1 si no hay memoria.
+ */
+long indice_explorar(const char* directorio, const opciones_exploracion* opciones, bool reconstruir,
+                     manejador_hallazgo manejador, void* dato, resumen_indice* resumen);
+
+/**
+ * @brief Libera el índice en memoria y deja de vigilar sus directorios; el archivo en disco se conserva.
+ */
+void indice_liberar(void);
+
+#endif // CONFIG_INDEX_H
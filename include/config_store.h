@@ -0,0 +1,143 @@
+/**
+ * @file config_store.h
+ * @brief Configuración del monitor (config.json) en memoria.
+ *
+ * El archivo se lee una sola vez, cuando algún comando necesita la configuración por primera vez (el arranque del
+ * shell no lo toca), y queda en memoria como un árbol cJSON; las lecturas se sirven de esa copia. Los cambios se
+ * aplican sobre la copia y sólo se escriben en disco si algo cambió, de forma atómica: el contenido se escribe en un
+ * archivo temporal del mismo directorio, se sincroniza con fsync() y reemplaza al anterior con rename(), así un
+ * lector (el monitor) nunca ve un archivo a medio escribir.
+ *
+ * Un descriptor de inotify vigila el directorio del archivo: si otro programa lo modifica, la copia se vuelve a leer
+ * apenas llega el aviso al bucle de eventos o, si el bucle no está activo, antes de la próxima lectura.
+ *
+ * La ruta es la de la variable de entorno SHELL_CONFIG o, si no está definida, CONFIG_RUTA_PREDETERMINADA; una ruta
+ * relativa se resuelve una única vez, en config_preparar(), respecto del directorio de trabajo inicial, así un 'cd'
+ * posterior no cambia el archivo.
+ */
+
+#ifndef CONFIG_STORE_H
+#define CONFIG_STORE_H
+
+#include <cjson/cJSON.h>
+#include <stdbool.h>
+
+/**
+ *  @brief Variable de entorno con la ruta del archivo de configuración
+ */
+#define CONFIG_ENV "SHELL_CONFIG"
+
+/**
+ *  @brief Ruta del archivo de configuración si CONFIG_ENV no está definida
+ */
+#define CONFIG_RUTA_PREDETERMINADA "../config.json"
+
+/**
+ * @brief Manejador que se llama cuando la configuración cambia por una edición externa del archivo.
+ */
+typedef void (*manejador_configuracion)(void);
+
+/**
+ * @brief Fija la ruta del archivo de configuración, sin leerlo.
+ *
+ * Se llama al arrancar el shell, antes de cualquier 'cd'; si no se llamó, config_cargar() resuelve la ruta respecto
+ * del directorio actual.
+ *
+ * @return true si la ruta se pudo resolver.
+ */
+bool config_preparar(void);
+
+/**
+ * @brief Carga la configuración, si todavía no se cargó.
+ *
+ * Si el archivo no existe se crea con la configuración predeterminada (intervalo de muestreo y métricas); si existe
+ * pero no es JSON válido, se usa la predeterminada en memoria sin tocar el archivo. Con el bucle de eventos activo
+ * (ver event_loop.h), registra en él el descriptor de inotify.
+ *
+ * @return true si la configuración está disponible en memoria.
+ */
+bool config_cargar(void);
+
+/**
+ * @brief Devuelve la ruta absoluta del archivo de configuración.
+ *
+ * @return const char* Ruta, o la cadena vacía si la configuración no se cargó.
+ */
+const char* config_ruta(void);
+
+/**
+ * @brief Devuelve el valor de una clave de la configuración.
+ *
+ * @param clave Clave del objeto raíz.
+ * @return const cJSON* Valor, o NULL si la clave no existe. Es válido hasta el próximo cambio de la configuración.
+ */
+const cJSON* config_obtener(const char* clave);
+
+/**
+ * @brief Devuelve el intervalo de muestreo configurado.
+ *
+ * @return int Intervalo en segundos; el predeterminado si la clave falta o no es un número.
+ */
+int config_intervalo(void);
+
+/**
+ * @brief Devuelve las métricas configuradas.
+ *
+ * @param nombres Nombres de las métricas; apuntan a la configuración en memoria (ver config_obtener()).
+ * @param max Capacidad de nombres.
+ * @return int Métricas encontradas.
+ */
+int config_metricas(const char** nombres, int max);
+
+/**
+ * @brief Reemplaza el valor de una clave.
+ *
+ * @param clave Clave del objeto raíz.
+ * @param valor Nuevo valor; pasa a ser de la configuración, incluso si no se usa.
+ * @return int 1 si la configuración cambió, 0 si el valor era igual al anterior, -1 si no hay memoria.
+ */
+int config_establecer(const char* clave, cJSON* valor);
+
+/**
+ * @brief Aplica una operación de 'update_config' a la configuración en memoria.
+ *
+ * - set: reemplaza el valor de la clave. El valor se interpreta como JSON (5, [..], "texto", true) y, si no lo es,
+ *   como una cadena.
+ * - add: agrega el valor a la lista de la clave, si no estaba; si la clave no existe, crea la lista.
+ * - remove: quita el valor de la lista de la clave; sin valor, quita la clave.
+ *
+ * @param operacion "set", "add" o "remove".
+ * @param clave Clave del objeto raíz.
+ * @param valor Valor, o NULL (sólo para remove).
+ * @return int 1 si la configuración cambió, 0 si no, -1 si la operación no es válida (mensaje en stderr).
+ */
+int config_aplicar(const char* operacion, const char* clave, const char* valor);
+
+/**
+ * @brief Escribe la configuración en el archivo, si cambió desde la última escritura.
+ *
+ * @return int 0 si el archivo quedó al día, -1 si no se pudo escribir (mensaje en stderr).
+ */
+int config_guardar(void);
+
+/**
+ * @brief Serializa la configuración en JSON compacto.
+ *
+ * @return char* Texto, que se libera con cJSON_free(), o NULL si no hay configuración o memoria.
+ */
+char* config_serializar(void);
+
+/**
+ * @brief Registra el manejador de los cambios externos de la configuración.
+ *
+ * @param manejador Manejador, o NULL para no recibir avisos.
+ */
+void config_al_cambiar(manejador_configuracion manejador);
+
+/**
+ * @brief Libera la configuración en memoria, deja de vigilar el archivo y olvida su ruta; la próxima lectura vuelve a
+ * resolver la ruta y a cargarla.
+ */
+void config_liberar(void);
+
+#endif // CONFIG_STORE_H
@@ -0,0 +1,84 @@
+/**
+ * @file core_utils.h
+ * @brief Versiones internas de cat, wc, head, tail, true, false y test.
+ *
+ * Con "set -o internos", estos comandos se ejecutan dentro del shell en lugar de lanzar el programa del mismo nombre,
+ * que en los scripts suele ser la mayor parte de los procesos creados. Su salida es idéntica byte a byte a la de
+ * GNU coreutils para los argumentos que reproducen; con cualquier otro argumento (una opción que no implementan, un
+ * nombre de archivo que coreutils mostraría entre comillas, o una lectura de la terminal, que en el shell no podría
+ * interrumpirse con Ctrl+C) utilidad_aplicable() devuelve false y se ejecuta el programa.
+ *
+ * - cat [-u] [archivo...]: cada entrada se vuelca con volcar_descriptor() (file_stream.h): sendfile() o
+ *   copy_file_range() para archivos regulares y splice() para pipes, sin pasar los datos por el shell.
+ * - wc [-l] [-c] [archivo...]: los saltos de línea se cuentan con contar_byte() (simd_search.h) sobre bloques
+ *   grandes; con sólo -c, el tamaño de un archivo regular se toma de fstat() sin leerlo.
+ * - head/tail [-n N | -N] [archivo...]: lecturas acotadas; tail lee hacia atrás desde el final de un archivo
+ *   regular y no recorre el resto.
+ * - test expresión: las expresiones de POSIX (archivos, cadenas, enteros, '!', '-a', '-o' y paréntesis), con los
+ *   operadores adicionales de GNU ('==', '-nt', '-ot', '-ef', '-O', '-G', '-k').
+ */
+
+#ifndef CORE_UTILS_H
+#define CORE_UTILS_H
+
+#include <stdbool.h>
+
+/**
+ *  @brief Bytes por lectura al contar con wc
+ */
+#define UTILIDADES_TAM_BLOQUE (256 * 1024)
+
+/**
+ * @brief Indica si la versión interna de un comando reproduce exactamente al programa con estos argumentos.
+ *
+ * @param argv Argumentos terminados en NULL; argv[0] es el nombre del comando.
+ * @return true si se puede usar la versión interna, false si debe ejecutarse el programa.
+ */
+bool utilidad_aplicable(char** argv);
+
+/**
+ * @brief Comando interno 'cat'.
+ *
+ * @param argc Número de argumentos.
+ * @param argv Argumentos del comando.
+ * @return int 0 si se volcaron todas las entradas, 1 si alguna falló.
+ */
+int manejar_comando_cat(int argc, char** argv);
+
+/**
+ * @brief Comando interno 'wc' (sólo -l y -c).
+ *
+ * @param argc Número de argumentos.
+ * @param argv Argumentos del comando.
+ * @return int 0 si se contaron todas las entradas, 1 si alguna falló.
+ */
+int manejar_comando_wc(int argc, char** argv);
+
+/**
+ * @brief Comando interno 'head' (sólo -n N).
+ *
+ * @param argc Número de argumentos.
+ * @param argv Argumentos del comando.
+ * @return int 0 si se mostraron todas las entradas, 1 si alguna falló.
+ */
+int manejar_comando_head(int argc, char** argv);
+
+/**
+ * @brief Comando interno 'tail' (sólo -n N).
+ *
+ * @param argc Número de argumentos.
+ * @param argv Argumentos del comando.
+ * @return int 0 si se mostraron todas las entradas, 1 si alguna falló.
+ */
+int manejar_comando_tail(int argc, char** argv);
+
+/**
+ * @brief Comando interno 'test'.
+ *
+ * @param argc Número de argumentos.
+ * @param argv Argumentos del comando.
+ * @return int 0 si la expresión es verdadera, 1 si es falsa, 2 si es inválida.
+ */
+int manejar_comando_test(int argc, char** argv);
+
+#endif // CORE_UTILS_H
@@ -0,0 +1,134 @@
+/**
+ * @file event_loop.h
+ * @brief Bucle de eventos del shell basado en epoll.
+ *
+ * Un único epoll multiplexa todo lo que el shell espera entre comandos: la entrada de la terminal, las señales (leídas
+ * con signalfd en lugar de manejadores asíncronos), la terminación de procesos vigilados (pidfd), los temporizadores
+ * (timerfd) y cualquier otro descriptor registrado, como el canal de control del monitor. Todos los manejadores se
+ * ejecutan en el hilo principal, de a uno, así los avisos de trabajos, el prompt y los eventos del monitor nunca se
+ * mezclan.
+ *
+ * Las señales atendidas por el bucle quedan bloqueadas en el shell; los hijos lanzados con launcher.h las reciben
+ * desbloqueadas y con su acción por defecto.
+ */
+
+#ifndef EVENT_LOOP_H
+#define EVENT_LOOP_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+/**
+ * @brief Manejador de un descriptor registrado en el bucle.
+ *
+ * @param fd Descriptor que está listo.
+ * @param eventos Eventos de epoll (EPOLLIN, EPOLLHUP, ...).
+ * @param dato Dato opaco entregado al registrar el descriptor.
+ */
+typedef void (*manejador_evento)(int fd, uint32_t eventos, void* dato);
+
+/**
+ * @brief Manejador de las señales atendidas por el bucle.
+ *
+ * @param sig Número de la señal recibida.
+ */
+typedef void (*manejador_senal_bucle)(int sig);
+
+/**
+ * @brief Crea el bucle de eventos y comienza a atender señales por signalfd.
+ *
+ * SIGCHLD se atiende siempre: cada vez que llega, el bucle activa hijos_pendientes (ver jobs.h) antes de llamar al
+ * manejador de señales. En modo interactivo se atienden además SIGINT, SIGQUIT y SIGTSTP. Si el bucle ya estaba
+ * inicializado no hace nada.
+ *
+ * @param interactivo El shell está conectado a una terminal.
+ * @param manejador Función llamada con cada señal recibida, o NULL.
+ * @return true si el bucle se creó, false si epoll o signalfd no están disponibles.
+ */
+bool eventos_inicializar(bool interactivo, manejador_senal_bucle manejador);
+
+/**
+ * @brief Registra un descriptor en el bucle.
+ *
+ * @param fd Descriptor a vigilar; el bucle no lo cierra.
+ * @param eventos Eventos de epoll a esperar.
+ * @param manejador Función llamada cuando el descriptor está listo.
+ * @param dato Dato opaco para el manejador.
+ * @return int 0 si se registró, -1 si hubo un error o el bucle no está inicializado.
+ */
+int eventos_agregar_fd(int fd, uint32_t eventos, manejador_evento manejador, void* dato);
+
+/**
+ * @brief Quita un descriptor del bucle. Puede llamarse desde un manejador, incluso el del propio descriptor.
+ *
+ * Los descriptores creados por el bucle (temporizadores y pidfds) se cierran; los registrados con
+ * eventos_agregar_fd() no.
+ *
+ * @param fd Descriptor a quitar.
+ */
+void eventos_quitar_fd(int fd);
+
+/**
+ * @brief Crea un temporizador (timerfd) y lo registra en el bucle.
+ *
+ * El manejador se llama cada vez que el temporizador vence; el bucle ya consumió el contador de vencimientos.
+ *
+ * @param ms Milisegundos hasta el primer vencimiento.
+ * @param periodico Repetir el temporizador cada ms milisegundos.
+ * @param manejador Función llamada al vencer.
+ * @param dato Dato opaco para el manejador.
+ * @return int Descriptor del temporizador (para eventos_reprogramar() y eventos_quitar_fd()), o -1 si hubo un error.
+ */
+int eventos_agregar_temporizador(unsigned ms, bool periodico, manejador_evento manejador, void* dato);
+
+/**
+ * @brief Vuelve a programar un temporizador creado con eventos_agregar_temporizador().
+ *
+ * @param fd Descriptor del temporizador.
+ * @param ms Milisegundos hasta el próximo vencimiento; 0 lo desarma.
+ * @param periodico Repetir el temporizador cada ms milisegundos.
+ * @return int 0 si se reprogramó, -1 si hubo un error.
+ */
+int eventos_reprogramar(int fd, unsigned ms, bool periodico);
+
+/**
+ * @brief Vigila la terminación de un proceso hijo con un pidfd.
+ *
+ * El manejador se llama cuando el proceso termina; debe recolectarlo (por ejemplo con waitid(P_PIDFD)) y quitar el
+ * descriptor del bucle.
+ *
+ * @param pid Proceso a vigilar.
+ * @param manejador Función llamada al terminar el proceso.
+ * @param dato Dato opaco para el manejador.
+ * @return int pidfd registrado, o -1 si el núcleo no soporta pidfd o el bucle no está inicializado.
+ */
+int eventos_vigilar_proceso(pid_t pid, manejador_evento manejador, void* dato);
+
+/**
+ * @brief Espera eventos y ejecuta sus manejadores.
+ *
+ * @param espera_ms Tiempo máximo de espera en milisegundos; -1 espera indefinidamente y 0 sólo atiende los eventos
+ *                  ya pendientes.
+ * @return int Cantidad de eventos atendidos, o -1 si el bucle no está inicializado o epoll_wait falló.
+ */
+int eventos_esperar(int espera_ms);
+
+/**
+ * @brief Indica que un manejador escribió en la terminal y el prompt debe volver a mostrarse.
+ */
+void eventos_marcar_salida(void);
+
+/**
+ * @brief Consulta y limpia la marca de eventos_marcar_salida().
+ *
+ * @return true si algún manejador escribió en la terminal desde la última consulta.
+ */
+bool eventos_hubo_salida(void);
+
+/**
+ * @brief Cierra el bucle, sus descriptores propios y restaura la máscara de señales.
+ */
+void eventos_cerrar(void);
+
+#endif // EVENT_LOOP_H
@@ -0,0 +1,93 @@
+/**
+ * @file fd_check.h
+ * @brief Comando interno de depuración 'fdcheck': descriptores abiertos del shell y descriptores que deja un comando.
+ *
+ * Todo descriptor que abre el shell debe llevar FD_CLOEXEC (O_CLOEXEC, pipe2(O_CLOEXEC), SOCK_CLOEXEC...) y todo
+ * descriptor que abre un comando debe estar cerrado cuando el comando termina. 'fdcheck' toma una foto de la tabla de
+ * descriptores del shell (de /proc/self/fd, o probando cada número con fcntl() si /proc no está montado) antes y
+ * después de ejecutar un comando e informa los que quedaron abiertos de más y los que heredarían los hijos.
+ */
+
+#ifndef FD_CHECK_H
+#define FD_CHECK_H
+
+#include <stdbool.h>
+#include <stdio.h>
+
+/**
+ *  @brief Largo máximo del destino de un descriptor que se guarda (se trunca si es más largo)
+ */
+#define FDCHECK_LARGO_DESTINO 128
+
+/**
+ *  @brief Descriptores que se prueban con fcntl() cuando /proc/self/fd no está disponible
+ */
+#define FDCHECK_MAX_SIN_PROC 1024
+
+/**
+ * @brief Descriptor abierto del shell.
+ */
+typedef struct
+{
+    int fd;                              /**< Número de descriptor */
+    bool cierre_en_exec;                 /**< Tiene FD_CLOEXEC: los programas que se ejecuten no lo heredan */
+    char destino[FDCHECK_LARGO_DESTINO]; /**< Archivo, pipe o socket al que apunta, o "?" si no se conoce */
+} descriptor_abierto;
+
+/**
+ * @brief Foto de la tabla de descriptores del shell.
+ */
+typedef struct
+{
+    descriptor_abierto* descriptores; /**< Descriptores abiertos, de menor a mayor */
+    int cantidad;                     /**< Cantidad de descriptores */
+} tabla_descriptores;
+
+/**
+ * @brief Lee la tabla de descriptores abiertos del shell.
+ *
+ * El descriptor que se usa para recorrer /proc/self/fd no aparece en la tabla.
+ *
+ * @param tabla Tabla a completar; se libera con tabla_descriptores_liberar().
+ * @return int 0 si se leyó, -1 si no hubo memoria.
+ */
+int tabla_descriptores_leer(tabla_descriptores* tabla);
+
+/**
+ * @brief Libera una tabla leída con tabla_descriptores_leer().
+ *
+ * @param tabla Tabla a liberar.
+ */
+void tabla_descriptores_liberar(tabla_descriptores* tabla);
+
+/**
+ * @brief Compara dos fotos de la tabla e informa los problemas de la segunda.
+ *
+ * Son problemas los descriptores que están en la segunda tabla y no en la primera (un comando los dejó abiertos) y
+ * los descriptores desde el 3 que no tienen FD_CLOEXEC (los heredaría cualquier programa que lance el shell).
+ *
+ * @param antes Tabla antes del comando.
+ * @param despues Tabla después del comando.
+ * @param informe Flujo donde se describe cada problema, o NULL para sólo contarlos.
+ * @return int Cantidad de problemas.
+ */
+int tabla_descriptores_comparar(const tabla_descriptores* antes, const tabla_descriptores* despues, FILE* informe);
+
+/**
+ * @brief Maneja el comando interno 'fdcheck'.
+ *
+ * Formato: fdcheck [comando [args...]]
+ *
+ * Sin argumentos, lista los descriptores abiertos del shell con su destino y si los heredan los programas que se
+ * ejecutan. Con un comando, lo ejecuta como un comando simple (interno o externo, con los argumentos ya expandidos)
+ * e informa por stderr los descriptores que quedaron abiertos después de él y los que no tienen FD_CLOEXEC. Los
+ * recursos que un comando crea la primera vez que se usa (por ejemplo, el índice de 'explorar_config') también
+ * aparecen: para distinguirlos de una fuga, conviene repetir el comando.
+ *
+ * @param argc Número de argumentos, incluyendo "fdcheck".
+ * @param argv Argumentos del comando.
+ * @return int 0 si no hay problemas, 1 si hay descriptores de más o heredables, 2 si no se pudo leer la tabla.
+ */
+int manejar_comando_fdcheck(int argc, char** argv);
+
+#endif // FD_CHECK_H
@@ -0,0 +1,108 @@
+/**
+ * @file fd_plan.h
+ * @brief Plan de descriptores de un comando: compilación de sus redirecciones y aplicación en el propio shell.
+ *
+ * Las redirecciones de un comando simple se compilan, con sus palabras ya expandidas, en las acciones de un plan de
+ * spawn (ver launcher.h): abrir un archivo sobre un descriptor, duplicar un descriptor sobre otro o cerrarlo, en el
+ * orden en que aparecen en la línea. El mismo plan sirve para los tres lugares donde puede ejecutarse el comando:
+ *
+ * - En un hijo (programa externo, o comando interno en medio de un pipe): lanzar_plan() o lanzar_con_fork() aplican
+ *   las acciones sobre los descriptores que hereda el hijo.
+ * - En el shell, si el comando interno sólo escribe con los flujos de stdio (columna "flujos" de
+ *   src/builtins.manifest): plan_aplicar_en_flujos() calcula qué descriptor queda detrás de la entrada, la salida y
+ *   los errores estándar, y reemplaza stdin, stdout y stderr por flujos sobre esos descriptores. Los descriptores del
+ *   shell no cambian, por lo que no hay nada que guardar ni restaurar.
+ * - En el shell, para el resto de los comandos internos: plan_aplicar_en_shell() aplica las acciones sobre los
+ *   descriptores del shell, guardando antes una copia de cada descriptor que cambia.
+ *
+ * Todo archivo que abre el propio shell lleva O_CLOEXEC, de modo que ningún proceso lanzado mientras dura el comando
+ * lo hereda salvo por una duplicación explícita.
+ */
+
+#ifndef FD_PLAN_H
+#define FD_PLAN_H
+
+#include "arena.h"
+#include "launcher.h"
+#include "parser.h"
+#include <stdbool.h>
+#include <stdio.h>
+
+/**
+ *  @brief Flujos estándar que puede reemplazar plan_aplicar_en_flujos(): stdin, stdout y stderr
+ */
+#define PLAN_FLUJOS_ESTANDAR 3
+
+/**
+ * @brief Descriptor del shell reemplazado por plan_aplicar_en_shell().
+ */
+typedef struct
+{
+    int fd;    /**< Descriptor redirigido */
+    int copia; /**< Copia del descriptor original, o -1 si estaba cerrado */
+} descriptor_guardado;
+
+/**
+ * @brief Estado del shell mientras un plan está aplicado; plan_restaurar() lo deshace.
+ */
+typedef struct
+{
+    FILE* originales[PLAN_FLUJOS_ESTANDAR];           /**< stdin, stdout y stderr del shell */
+    FILE* flujos[PLAN_FLUJOS_ESTANDAR];               /**< Flujos que los reemplazan, NULL si no cambiaron */
+    int abiertos[PLAN_MAX_ACCIONES];                  /**< Archivos abiertos por el plan en modo flujos */
+    int num_abiertos;                                 /**< Cantidad de archivos abiertos */
+    descriptor_guardado guardados[PLAN_MAX_ACCIONES]; /**< Descriptores del shell reemplazados, en orden */
+    int num_guardados;                                /**< Cantidad de descriptores guardados */
+} plan_aplicado;
+
+/**
+ * @brief Compila las redirecciones de un comando en acciones del plan.
+ *
+ * Las palabras de destino se expanden en la arena. Los archivos se abren con los flags que corresponden al operador
+ * ('&>' abre la salida y duplica sobre ella los errores) y las duplicaciones necesitan un número de descriptor o '-'.
+ * Las acciones se agregan al final del plan, por lo que tienen prioridad sobre las que ya tenía (los pipes).
+ *
+ * @param plan Plan al que se agregan las acciones.
+ * @param a Arena donde se expanden los destinos; deben seguir siendo válidos hasta aplicar el plan.
+ * @param redirecciones Lista de redirecciones del comando.
+ * @return int 0 si se compilaron todas, -1 si alguna no es válida o el plan se llenó (el error ya fue informado).
+ */
+int plan_compilar_redirecciones(plan_spawn* plan, arena* a, const redireccion* redirecciones);
+
+/**
+ * @brief Aplica un plan a los flujos de stdio, sin tocar los descriptores del shell.
+ *
+ * Recorre las acciones sobre una tabla de descriptores virtual: los archivos se abren de verdad (con O_CLOEXEC), pero
+ * las duplicaciones y los cierres sólo cambian la tabla. Al final, cada uno de los descriptores 0, 1 y 2 que quedó
+ * apuntando a otro lugar se reemplaza por un flujo sobre el descriptor real (sin ser su dueño); escribir en uno que
+ * quedó cerrado falla con EBADF. Un plan sin acciones no hace nada.
+ *
+ * @param plan Plan a aplicar.
+ * @param aplicado Estado a completar; se deshace con plan_restaurar() incluso si la aplicación falla.
+ * @return int 0 si se aplicó, -1 si una acción falló (el error ya fue informado).
+ */
+int plan_aplicar_en_flujos(const plan_spawn* plan, plan_aplicado* aplicado);
+
+/**
+ * @brief Aplica un plan sobre los descriptores del propio shell.
+ *
+ * Antes de cambiar un descriptor por primera vez se guarda una copia (con FD_CLOEXEC, a partir de 10). Se usa con los
+ * comandos internos que escriben directamente en los descriptores o que lanzan procesos que deben heredarlos.
+ *
+ * @param plan Plan a aplicar.
+ * @param aplicado Estado a completar; se deshace con plan_restaurar() incluso si la aplicación falla.
+ * @return int 0 si se aplicó, -1 si una acción falló (el error ya fue informado).
+ */
+int plan_aplicar_en_shell(const plan_spawn* plan, plan_aplicado* aplicado);
+
+/**
+ * @brief Deshace un plan aplicado con plan_aplicar_en_flujos() o plan_aplicar_en_shell().
+ *
+ * Vacía y cierra los flujos que reemplazaron a los estándar, cierra los archivos que abrió el plan y devuelve los
+ * descriptores guardados a su lugar, en orden inverso.
+ *
+ * @param aplicado Estado devuelto por la aplicación.
+ */
+void plan_restaurar(plan_aplicado* aplicado);
+
+#endif // FD_PLAN_H
@@ -0,0 +1,52 @@
+/**
+ * @file file_stream.h
+ * @brief Volcado del contenido de un descriptor en otro sin pasar por buffers del shell.
+ *
+ * Un archivo regular se envía con sendfile(): el núcleo copia las páginas de la caché directamente al descriptor de
+ * salida. Si la salida es otro archivo regular se usa antes copy_file_range(), que el sistema de archivos puede
+ * resolver sin copiar los datos. Para mostrar sólo las primeras o las últimas líneas, los límites se buscan con
+ * memchr()/memrchr() leyendo con pread() sólo los bloques necesarios (las últimas líneas, hacia atrás desde el final) y
+ * después se envía ese rango, también con sendfile(). No se usa mmap(): un archivo que otro proceso trunca mientras se
+ * lee terminaría el shell con SIGBUS. Las demás entradas (pipes, FIFOs, dispositivos, y los archivos de /proc, que
+ * informan tamaño 0) se mueven con splice() cuando uno de los extremos es un pipe. Si el núcleo rechaza la copia
+ * directa (por ejemplo, si la salida es una terminal) se copia con read()/write() a partir del punto en que quedó.
+ */
+
+#ifndef FILE_STREAM_H
+#define FILE_STREAM_H
+
+/**
+ * @brief Qué parte de la entrada se vuelca
+ */
+typedef enum
+{
+    VOLCAR_TODO,     /**< Todo el contenido */
+    VOLCAR_PRIMERAS, /**< Sólo las primeras líneas */
+    VOLCAR_ULTIMAS   /**< Sólo las últimas líneas; una entrada que no es un archivo regular se lee entera en memoria */
+} modo_volcado;
+
+/**
+ * @brief Resultado de un volcado
+ */
+typedef enum
+{
+    VOLCADO_COMPLETO,       /**< Se volcó todo lo pedido */
+    VOLCADO_ERROR_LECTURA,  /**< No se pudo leer la entrada (errno indica el motivo) */
+    VOLCADO_ERROR_ESCRITURA /**< No se pudo escribir la salida (errno indica el motivo; EPIPE si el lector se fue) */
+} resultado_volcado;
+
+/**
+ * @brief Vuelca el contenido de un descriptor, desde su posición actual, en otro.
+ *
+ * Los datos se escriben directamente en el descriptor de salida: si es el de un FILE* con datos pendientes, el
+ * llamador debe vaciarlo antes. Al terminar, la posición de un archivo regular queda después de lo volcado.
+ *
+ * @param entrada Descriptor que se lee.
+ * @param salida Descriptor en el que se escribe.
+ * @param modo Parte de la entrada que se vuelca.
+ * @param lineas Con VOLCAR_PRIMERAS o VOLCAR_ULTIMAS, cantidad de líneas (0 no vuelca nada); si no, se ignora.
+ * @return resultado_volcado Resultado; en caso de error, errno indica el motivo.
+ */
+resultado_volcado volcar_descriptor(int entrada, int salida, modo_volcado modo, long lineas);
+
+#endif // FILE_STREAM_H
@@ -9,23 +9,14 @@
 #define GLOBALS_H
 
 #include <limits.h>    // Include this header for PATH_MAX
+#include <stdbool.h>   // Include this header for bool
 #include <sys/types.h> // Include this header for pid_t
 
-/**
- *  @brief Maximo tamaño de la linea de comando
- */
-#define MAX_LINE 1024
-
 /**
  *  @brief Maximo tamaño de los nombres
  */
 #define MAX_NAMES 256
 
-/**
- *  @brief Maximo tamaño de los trabajos en segundo plano
- */
-#define MAX_JOBS 100
-
 /**
  *  @brief Intervalo de tiempo en seg
  */
@@ -43,21 +34,30 @@ extern char cwd[PATH_MAX];
  */
 extern int EXIT;
 
-// Variables para el manejo de trabajos en segundo plano
 /**
- *  @brief ID del trabajo en segundo plano
+ *  @brief PID del proceso en primer plano
+ */
+extern pid_t proceso_en_primer_plano;
+
+/**
+ *  @brief Código de salida del último comando ejecutado en primer plano
  */
-extern int job_id;
+extern int ultimo_estado;
 
 /**
- *  @brief Lista para almacenar los PIDs de los trabajos en segundo plano
+ *  @brief Opción pipefail, modificable con "set -o pipefail" y "set +o pipefail"
  */
-extern pid_t jobs[MAX_JOBS];
+extern bool opcion_pipefail;
 
 /**
- *  @brief PID del proceso en primer plano
+ *  @brief Opción internos, modificable con "set -o internos" y "set +o internos"
  */
-extern pid_t proceso_en_primer_plano;
+extern bool opcion_internos;
+
+/**
+ *  @brief Opción --dump-bytecode: listar en stderr cada programa antes de ejecutarlo
+ */
+extern bool opcion_volcar_bytecode;
 
 // Variables para el manejo de la terminal
 
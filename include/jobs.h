@@ -0,0 +1,140 @@
+/**
+ * @file jobs.h
+ * @brief Tabla de trabajos del shell: pipes en segundo plano o detenidos.
+ *
+ * Cada trabajo es un grupo de procesos con un número estable, asignado al crearlo y que no cambia hasta que el
+ * trabajo se elimina. Los trabajos se guardan en un vector ordenado por número, que crece según haga falta, y cada
+ * proceso se encuentra en O(1) a partir de su PID mediante una tabla hash.
+ *
+ * El manejador de SIGCHLD sólo marca que hay hijos con cambios; la recolección con waitpid() y los mensajes se hacen
+ * después, fuera del manejador, en trabajos_actualizar() y trabajos_notificar().
+ */
+
+#ifndef JOBS_H
+#define JOBS_H
+
+#include <signal.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+/**
+ * @brief Estado de un trabajo.
+ */
+typedef enum
+{
+    TRABAJO_EN_EJECUCION, /**< Algún proceso sigue en ejecución */
+    TRABAJO_DETENIDO,     /**< Algún proceso se detuvo (Ctrl+Z, SIGSTOP) */
+    TRABAJO_TERMINADO     /**< Todos los procesos terminaron */
+} estado_trabajo;
+
+/**
+ * @brief Trabajo: un pipe lanzado como grupo de procesos.
+ */
+typedef struct
+{
+    int id;                /**< Número del trabajo (%n) */
+    pid_t pgid;            /**< Grupo de procesos */
+    int num_procesos;      /**< Cantidad de procesos del pipe */
+    int vivos;             /**< Procesos que todavía no fueron recolectados */
+    pid_t* pids;           /**< PID de cada proceso, -1 si la etapa no se lanzó */
+    int* estados;          /**< Código de salida de cada proceso, -1 mientras no termine */
+    estado_trabajo estado; /**< Estado del trabajo */
+    bool notificado;       /**< El cambio de estado ya se informó al usuario */
+    uint64_t inicio_ns;    /**< Momento en que se registró (CLOCK_REALTIME), en nanosegundos */
+    char* comando;         /**< Texto del comando, para los listados */
+} trabajo;
+
+/**
+ * @brief Bandera que el manejador de SIGCHLD activa cuando algún hijo cambió de estado.
+ */
+extern volatile sig_atomic_t hijos_pendientes;
+
+/**
+ * @brief Agrega un trabajo a la tabla.
+ *
+ * @param pgid Grupo de procesos del trabajo.
+ * @param pids PID de cada proceso; los menores o iguales a 0 se consideran etapas que no se lanzaron.
+ * @param estados Código de salida de cada proceso, o -1 si sigue en ejecución; NULL si todos están en ejecución.
+ * @param n Cantidad de procesos.
+ * @param comando Texto del comando; se copia.
+ * @param estado Estado inicial (en ejecución o detenido).
+ * @return trabajo* Trabajo creado, o NULL si no hay memoria.
+ */
+trabajo* trabajos_agregar(pid_t pgid, const pid_t* pids, const int* estados, int n, const char* comando,
+                          estado_trabajo estado);
+
+/**
+ * @brief Busca un trabajo a partir de una especificación.
+ *
+ * Formatos: %n (número de trabajo), %+ o %% (trabajo actual), %- (trabajo anterior), o un PID de cualquiera de sus
+ * procesos. NULL o la cadena vacía equivalen al trabajo actual, que es el más reciente.
+ *
+ * @param especificacion Especificación del trabajo.
+ * @return trabajo* Trabajo encontrado, o NULL si no existe.
+ */
+trabajo* trabajos_buscar(const char* especificacion);
+
+/**
+ * @brief Elimina un trabajo de la tabla y libera su memoria.
+ *
+ * @param t Trabajo a eliminar.
+ */
+void trabajos_eliminar(trabajo* t);
+
+/**
+ * @brief Actualiza la tabla después de que otro código recolectó procesos del trabajo (por ejemplo, 'fg').
+ *
+ * Los procesos cuyo estado dejó de ser -1 se quitan de la tabla de PIDs; si no queda ninguno vivo, el trabajo pasa a
+ * estar terminado.
+ *
+ * @param t Trabajo.
+ */
+void trabajos_sincronizar(trabajo* t);
+
+/**
+ * @brief Recolecta los hijos que cambiaron de estado y actualiza sus trabajos.
+ *
+ * No hace nada si no hay cambios marcados por SIGCHLD (por el manejador o por el bucle de eventos) ni una SIGCHLD
+ * bloqueada pendiente. Usa waitpid(-1), por lo que sólo debe llamarse cuando ningún otro código del shell está
+ * esperando a sus propios hijos (entre comandos).
+ */
+void trabajos_actualizar(void);
+
+/**
+ * @brief Indica si hay trabajos que terminaron o se detuvieron y todavía no se informaron.
+ *
+ * @return true si trabajos_notificar() imprimiría algún aviso.
+ */
+bool trabajos_hay_avisos(void);
+
+/**
+ * @brief Informa los trabajos que terminaron o se detuvieron desde el último aviso y elimina los terminados.
+ */
+void trabajos_notificar(void);
+
+/**
+ * @brief Devuelve la cantidad de trabajos en la tabla.
+ *
+ * @return int Número de trabajos.
+ */
+int trabajos_cantidad(void);
+
+/**
+ * @brief Envía SIGTERM (y SIGCONT a los detenidos) a todos los trabajos y vacía la tabla.
+ */
+void trabajos_terminar_todos(void);
+
+/**
+ * @brief Maneja el comando interno 'jobs'.
+ *
+ * Formato: jobs [-l | -p] [%n...]. Sin opciones lista número, estado y comando de cada trabajo; -l agrega el grupo
+ * de procesos y -p imprime sólo los grupos de procesos. Los trabajos terminados se eliminan después de listarlos.
+ *
+ * @param argc Número de argumentos, incluyendo "jobs".
+ * @param argv Argumentos del comando.
+ * @return int 0 si todos los trabajos pedidos existen, 1 en caso contrario, 2 si el uso es incorrecto.
+ */
+int manejar_comando_jobs(int argc, char** argv);
+
+#endif // JOBS_H
@@ -0,0 +1,165 @@
+/**
+ * @file launcher.h
+ * @brief Lanzador de procesos basado en posix_spawn a partir de un plan preparado.
+ *
+ * Un plan de spawn describe todo lo que el hijo necesita antes de ejecutar el programa: el vector de argumentos,
+ * las acciones sobre descriptores (redirecciones, pipes), el grupo de procesos y el estado de las señales. El plan se
+ * ejecuta con posix_spawn(), que en glibc usa clone(CLONE_VM | CLONE_VFORK) y evita copiar la tabla de páginas del
+ * shell. Sólo cuando un comando interno debe ejecutarse en el hijo se recurre a fork().
+ */
+
+#ifndef LAUNCHER_H
+#define LAUNCHER_H
+
+#include <stdbool.h>
+#include <sys/types.h>
+
+/**
+ *  @brief Máximo de acciones sobre descriptores en un plan
+ */
+#define PLAN_MAX_ACCIONES 16
+
+/**
+ *  @brief Valor de pgid que indica que el hijo conserva el grupo de procesos del shell
+ */
+#define PLAN_SIN_GRUPO ((pid_t)-1)
+
+/**
+ * @brief Tipo de acción sobre un descriptor de archivo en el hijo.
+ */
+typedef enum
+{
+    ACCION_ABRIR, /**< Abrir una ruta sobre un descriptor */
+    ACCION_DUP2,  /**< Duplicar un descriptor sobre otro */
+    ACCION_CERRAR /**< Cerrar un descriptor */
+} tipo_accion_fd;
+
+/**
+ * @brief Acción sobre un descriptor que se aplica en el hijo antes de ejecutar el programa.
+ */
+typedef struct
+{
+    tipo_accion_fd tipo; /**< Tipo de acción */
+    int fd;              /**< Descriptor destino en el hijo */
+    int fd_origen;       /**< Descriptor origen (sólo ACCION_DUP2) */
+    const char* ruta;    /**< Ruta del archivo (sólo ACCION_ABRIR) */
+    int flags;           /**< Flags de open() (sólo ACCION_ABRIR) */
+    mode_t modo;         /**< Permisos de creación (sólo ACCION_ABRIR) */
+} accion_fd;
+
+/**
+ * @brief Plan de spawn: todo lo necesario para lanzar un proceso hijo.
+ */
+typedef struct
+{
+    char** argv;                           /**< Argumentos terminados en NULL; argv[0] es el programa */
+    accion_fd acciones[PLAN_MAX_ACCIONES]; /**< Acciones sobre descriptores, en orden */
+    int num_acciones;                      /**< Número de acciones cargadas */
+    pid_t pgid;                            /**< 0: grupo propio, >0: unirse a ese grupo, PLAN_SIN_GRUPO: no tocar */
+    bool restaurar_senales;                /**< Restablecer las señales del shell a SIG_DFL y vaciar la máscara */
+} plan_spawn;
+
+/**
+ * @brief Función que ejecuta un comando interno dentro de un hijo creado con fork().
+ *
+ * @param dato Dato opaco entregado a lanzar_con_fork().
+ * @return int Estado de salida del hijo.
+ */
+typedef int (*funcion_hijo)(void* dato);
+
+/**
+ * @brief Inicializa un plan de spawn vacío.
+ *
+ * El plan queda con el vector de argumentos dado, sin acciones sobre descriptores, con un grupo de procesos propio
+ * para el hijo y con la restauración de señales activada.
+ *
+ * @param plan Plan a inicializar.
+ * @param argv Vector de argumentos terminado en NULL.
+ */
+void plan_inicializar(plan_spawn* plan, char** argv);
+
+/**
+ * @brief Agrega al plan la apertura de un archivo sobre un descriptor del hijo.
+ *
+ * @param plan Plan a modificar.
+ * @param fd Descriptor destino en el hijo.
+ * @param ruta Ruta del archivo; debe seguir siendo válida hasta lanzar el plan.
+ * @param flags Flags de open().
+ * @param modo Permisos en caso de creación.
+ * @return int 0 si la acción se agregó, -1 si el plan está lleno.
+ */
+int plan_agregar_abrir(plan_spawn* plan, int fd, const char* ruta, int flags, mode_t modo);
+
+/**
+ * @brief Agrega al plan la duplicación de un descriptor sobre otro.
+ *
+ * @param plan Plan a modificar.
+ * @param fd_origen Descriptor del shell que se duplica.
+ * @param fd Descriptor destino en el hijo.
+ * @return int 0 si la acción se agregó, -1 si el plan está lleno.
+ */
+int plan_agregar_dup2(plan_spawn* plan, int fd_origen, int fd);
+
+/**
+ * @brief Agrega al plan el cierre de un descriptor en el hijo.
+ *
+ * @param plan Plan a modificar.
+ * @param fd Descriptor a cerrar.
+ * @return int 0 si la acción se agregó, -1 si el plan está lleno.
+ */
+int plan_agregar_cerrar(plan_spawn* plan, int fd);
+
+/**
+ * @brief Lanza el programa descrito por el plan con posix_spawn().
+ *
+ * El programa se resuelve con la caché de ubicación de comandos (ver path_cache.h) y se ejecuta directamente sobre
+ * la ruta absoluta. Si la ruta cacheada ya no existe, se descarta y se vuelve a buscar en $PATH.
+ *
+ * Después de las acciones del plan, el hijo cierra todos los descriptores mayores que el más alto que abre o duplica
+ * el plan (normalmente, todos desde el 3), de modo que ni un descriptor que al shell se le haya escapado sin
+ * O_CLOEXEC llega al programa.
+ *
+ * @param plan Plan a ejecutar.
+ * @return pid_t PID del hijo, o -1 si no se pudo lanzar (el error ya fue informado por stderr).
+ */
+pid_t lanzar_plan(const plan_spawn* plan);
+
+/**
+ * @brief Lanza un hijo con fork() que aplica el plan y ejecuta una función en lugar de un programa.
+ *
+ * Se usa sólo para comandos internos que deben ejecutarse en un proceso aparte, por ejemplo como etapa de un pipe.
+ * El campo argv del plan se ignora. Después de las acciones del plan, el hijo marca con FD_CLOEXEC todos los
+ * descriptores desde el 3 salvo los que abre o duplica el plan: los sigue usando, pero los programas que lance no
+ * los heredan.
+ *
+ * @param plan Plan con el grupo de procesos, las señales y las acciones sobre descriptores.
+ * @param funcion Función a ejecutar en el hijo; su retorno es el estado de salida.
+ * @param dato Dato opaco para la función.
+ * @return pid_t PID del hijo, o -1 si fork() falló.
+ */
+pid_t lanzar_con_fork(const plan_spawn* plan, funcion_hijo funcion, void* dato);
+
+/**
+ * @brief Convierte el estado devuelto por wait en un código de salida al estilo del shell.
+ *
+ * @param status Estado devuelto por waitpid().
+ * @return int Código de salida del proceso, o 128 más el número de señal si terminó o se detuvo por una señal.
+ */
+int codigo_de_salida(int status);
+
+/**
+ * @brief Espera a que terminen los procesos indicados, sin recolectar ningún otro hijo del shell.
+ *
+ * Cada proceso se sigue con un pidfd (pidfd_open) y se recolecta con waitid(P_PIDFD). La espera termina cuando
+ * todos los procesos terminaron o cuando alguno se detiene (por ejemplo con Ctrl+Z). Si el núcleo no soporta pidfd
+ * se espera cada proceso con waitpid().
+ *
+ * @param pids PIDs a esperar; las posiciones con PID menor o igual a 0 se ignoran.
+ * @param n Cantidad de PIDs.
+ * @param estados Salida: código de salida de cada proceso (ver codigo_de_salida()); las posiciones ignoradas y los
+ *                procesos que siguen en ejecución o detenidos no se modifican.
+ * @return true si algún proceso se detuvo, false si todos terminaron.
+ */
+bool esperar_procesos(const pid_t* pids, int n, int* estados);
+
+#endif // LAUNCHER_H
@@ -0,0 +1,146 @@
+/**
+ * @file metrics_shm.h
+ * @brief Anillo de muestras de métricas en memoria compartida POSIX.
+ *
+ * El shell crea el segmento al iniciar el monitor y le pasa su nombre en la variable de entorno MONITOR_SHM; el
+ * monitor es el único escritor y publica una muestra por intervalo con metricas_publicar(). Los lectores (el shell,
+ * u otros procesos que abran el segmento) leen directamente de la memoria, sin llamadas al sistema ni bloqueos.
+ *
+ * Cada celda tiene un contador de versión al estilo seqlock: el escritor lo deja impar mientras escribe y lo vuelve a
+ * dejar par al terminar. La muestra número k (desde 0) ocupa la celda k % METRICAS_CAPACIDAD y, una vez publicada,
+ * su celda tiene versión 2 * (k / METRICAS_CAPACIDAD + 1); un lector que ve otra versión sabe que la muestra ya fue
+ * reemplazada o se está reemplazando, y la descarta en lugar de devolver datos mezclados.
+ */
+
+#ifndef METRICS_SHM_H
+#define METRICS_SHM_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ *  @brief Variable de entorno con el nombre del segmento en el monitor
+ */
+#define METRICAS_SHM_ENV "MONITOR_SHM"
+
+/**
+ *  @brief Marca al comienzo del segmento ("SMTR")
+ */
+#define METRICAS_MAGIA 0x52544D53u
+
+/**
+ *  @brief Versión del formato del segmento
+ */
+#define METRICAS_VERSION 1
+
+/**
+ *  @brief Cantidad de muestras que guarda el anillo (potencia de dos)
+ */
+#define METRICAS_CAPACIDAD 1024
+
+/**
+ * @brief Muestra de métricas del sistema.
+ */
+typedef struct
+{
+    uint64_t instante_ns; /**< Momento de la muestra (CLOCK_REALTIME), en nanosegundos */
+    double cpu;           /**< Uso de CPU, en porcentaje */
+    double memoria;       /**< Uso de memoria, en porcentaje */
+    double red_rx;        /**< Bytes por segundo recibidos */
+    double red_tx;        /**< Bytes por segundo enviados */
+} muestra_metricas;
+
+/**
+ * @brief Celda del anillo: una muestra con su versión.
+ */
+typedef struct
+{
+    _Atomic uint64_t version; /**< Par: la muestra está completa; impar: el escritor la está reemplazando */
+    muestra_metricas muestra; /**< Muestra */
+} celda_metricas;
+
+/**
+ * @brief Segmento compartido: cabecera y anillo de muestras.
+ */
+typedef struct
+{
+    uint32_t magia;                            /**< METRICAS_MAGIA */
+    uint32_t version;                          /**< METRICAS_VERSION */
+    uint32_t capacidad;                        /**< METRICAS_CAPACIDAD */
+    uint32_t intervalo_ms;                     /**< Intervalo de muestreo informado por el monitor, 0 si no se sabe */
+    _Atomic uint64_t escritas;                 /**< Muestras publicadas desde que se creó el segmento */
+    celda_metricas celdas[METRICAS_CAPACIDAD]; /**< Anillo de muestras */
+} anillo_metricas;
+
+/**
+ * @brief Crea el segmento compartido y lo mapea para escritura.
+ *
+ * Si ya existía un segmento con ese nombre (por ejemplo, de un shell que terminó sin eliminarlo), se reemplaza.
+ *
+ * @param nombre Nombre POSIX del segmento ("/nombre").
+ * @return anillo_metricas* Segmento mapeado y vacío, o NULL si hubo un error.
+ */
+anillo_metricas* metricas_crear(const char* nombre);
+
+/**
+ * @brief Abre un segmento existente.
+ *
+ * @param nombre Nombre POSIX del segmento.
+ * @param escritura Mapear para escritura (el monitor) o sólo para lectura.
+ * @return anillo_metricas* Segmento mapeado, o NULL si no existe o no tiene el formato esperado.
+ */
+anillo_metricas* metricas_abrir(const char* nombre, bool escritura);
+
+/**
+ * @brief Desmapea un segmento.
+ *
+ * @param anillo Segmento mapeado, o NULL.
+ */
+void metricas_cerrar(anillo_metricas* anillo);
+
+/**
+ * @brief Elimina el nombre del segmento; los procesos que lo tienen mapeado pueden seguir usándolo.
+ *
+ * @param nombre Nombre POSIX del segmento.
+ */
+void metricas_eliminar(const char* nombre);
+
+/**
+ * @brief Publica una muestra. Sólo puede haber un escritor por segmento.
+ *
+ * @param anillo Segmento mapeado para escritura.
+ * @param muestra Muestra a publicar.
+ */
+void metricas_publicar(anillo_metricas* anillo, const muestra_metricas* muestra);
+
+/**
+ * @brief Devuelve la cantidad de muestras publicadas desde que se creó el segmento.
+ *
+ * @param anillo Segmento mapeado.
+ * @return uint64_t Número de muestras; la más reciente es la número total - 1.
+ */
+uint64_t metricas_total(const anillo_metricas* anillo);
+
+/**
+ * @brief Lee una muestra publicada.
+ *
+ * @param anillo Segmento mapeado.
+ * @param numero Número de la muestra (desde 0).
+ * @param muestra Muestra leída.
+ * @return true si la muestra sigue en el anillo; false si todavía no se publicó o ya fue reemplazada.
+ */
+bool metricas_leer(const anillo_metricas* anillo, uint64_t numero, muestra_metricas* muestra);
+
+/**
+ * @brief Lee las muestras más recientes, de la más antigua a la más nueva.
+ *
+ * @param anillo Segmento mapeado.
+ * @param muestras Muestras leídas.
+ * @param n Máximo de muestras a leer.
+ * @return int Cantidad de muestras leídas; puede ser menor que n si el anillo tiene menos o si el escritor reemplazó
+ *         algunas durante la lectura.
+ */
+int metricas_leer_ultimas(const anillo_metricas* anillo, muestra_metricas* muestras, int n);
+
+#endif // METRICS_SHM_H
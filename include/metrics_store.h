@@ -0,0 +1,200 @@
+/**
+ * @file metrics_store.h
+ * @brief Historial de métricas del monitor y comando interno 'metrics_query'.
+ *
+ * El anillo compartido con el monitor (ver metrics_shm.h) sólo guarda las últimas muestras; el shell las copia
+ * periódicamente a un almacén propio, en memoria y por columnas: un vector de instantes y un vector de valores por
+ * métrica, de modo que una consulta recorre sólo la columna que necesita.
+ *
+ * El almacén tiene varios niveles de resolución. El nivel 0 guarda las muestras crudas; los siguientes las agrupan
+ * en intervalos de ALMACEN_ANCHO_NIVEL_1 y ALMACEN_ANCHO_NIVEL_2 segundos y guardan, por intervalo y por métrica, la
+ * cantidad, el mínimo, el máximo, la suma y un histograma. Cada nivel es un anillo: los niveles gruesos cubren
+ * períodos mucho más largos con la misma memoria, y una consulta sobre una ventana larga recorre pocos intervalos en
+ * lugar de miles de muestras. Los percentiles son exactos sobre el nivel 0 y aproximados (por el histograma) sobre los
+ * demás.
+ *
+ * Las columnas se arman con las métricas listadas en config.json que el monitor publica: cpu_usage, memory_usage y
+ * network_usage (que agrega las columnas network_rx y network_tx).
+ */
+
+#ifndef METRICS_STORE_H
+#define METRICS_STORE_H
+
+#include "metrics_shm.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ *  @brief Cantidad de niveles de resolución
+ */
+#define ALMACEN_NIVELES 3
+
+/**
+ *  @brief Muestras crudas que guarda el nivel 0
+ */
+#define ALMACEN_CAPACIDAD_CRUDA 4096
+
+/**
+ *  @brief Segundos por intervalo del nivel 1
+ */
+#define ALMACEN_ANCHO_NIVEL_1 60
+
+/**
+ *  @brief Intervalos que guarda el nivel 1 (24 horas)
+ */
+#define ALMACEN_CAPACIDAD_NIVEL_1 1440
+
+/**
+ *  @brief Segundos por intervalo del nivel 2
+ */
+#define ALMACEN_ANCHO_NIVEL_2 900
+
+/**
+ *  @brief Intervalos que guarda el nivel 2 (7 días)
+ */
+#define ALMACEN_CAPACIDAD_NIVEL_2 672
+
+/**
+ *  @brief Máximo de columnas (métricas) del almacén
+ */
+#define ALMACEN_MAX_COLUMNAS 8
+
+/**
+ *  @brief Clases del histograma de cada intervalo
+ */
+#define ALMACEN_CLASES 64
+
+/**
+ *  @brief Máximo de percentiles por consulta
+ */
+#define ALMACEN_MAX_PERCENTILES 8
+
+/**
+ *  @brief Segundos entre copias del anillo del monitor al almacén
+ */
+#define ALMACEN_PERIODO_COPIA 5
+
+/**
+ * @brief Almacén de métricas (opaco).
+ */
+typedef struct almacen_metricas almacen_metricas;
+
+/**
+ * @brief Resultado de una consulta sobre una métrica.
+ */
+typedef struct
+{
+    uint64_t cantidad;                          /**< Muestras en la ventana */
+    double minimo;                              /**< Valor mínimo */
+    double maximo;                              /**< Valor máximo */
+    double media;                               /**< Media */
+    int nivel;                                  /**< Nivel de resolución usado */
+    int num_percentiles;                        /**< Percentiles pedidos */
+    double percentiles[ALMACEN_MAX_PERCENTILES]; /**< Valor de cada percentil pedido, en el mismo orden */
+} resultado_consulta;
+
+/**
+ * @brief Crea un almacén vacío.
+ *
+ * @param metricas Nombres de las métricas, como en config.json; los que el monitor no publica se ignoran. NULL para
+ *        todas las que publica.
+ * @param n Cantidad de nombres.
+ * @return almacen_metricas* Almacén creado, o NULL si ninguna métrica es conocida o no hay memoria.
+ */
+almacen_metricas* almacen_crear(const char* const* metricas, int n);
+
+/**
+ * @brief Libera un almacén.
+ *
+ * @param almacen Almacén, o NULL.
+ */
+void almacen_liberar(almacen_metricas* almacen);
+
+/**
+ * @brief Agrega una muestra a todos los niveles.
+ *
+ * Las muestras deben llegar en orden de tiempo; una muestra más antigua que la última se descarta.
+ *
+ * @param almacen Almacén.
+ * @param muestra Muestra del monitor.
+ */
+void almacen_agregar(almacen_metricas* almacen, const muestra_metricas* muestra);
+
+/**
+ * @brief Copia al almacén las muestras del anillo que todavía no se copiaron.
+ *
+ * @param almacen Almacén.
+ * @param anillo Anillo del monitor.
+ * @param leidas Muestras del anillo ya copiadas; se actualiza.
+ * @return int Muestras copiadas.
+ */
+int almacen_copiar_anillo(almacen_metricas* almacen, const anillo_metricas* anillo, uint64_t* leidas);
+
+/**
+ * @brief Busca las columnas de una métrica.
+ *
+ * Una métrica se busca por el nombre de la columna o por el de la métrica de config.json que la produce (por
+ * ejemplo, network_usage devuelve network_rx y network_tx).
+ *
+ * @param almacen Almacén.
+ * @param metrica Nombre buscado, o NULL para todas las columnas.
+ * @param columnas Nombres de las columnas encontradas.
+ * @param max Capacidad de columnas.
+ * @return int Columnas encontradas.
+ */
+int almacen_columnas(const almacen_metricas* almacen, const char* metrica, const char** columnas, int max);
+
+/**
+ * @brief Calcula los agregados de una métrica en una ventana de tiempo.
+ *
+ * @param almacen Almacén.
+ * @param metrica Nombre de la columna (cpu_usage, memory_usage, network_rx, network_tx).
+ * @param desde_ns Comienzo de la ventana (CLOCK_REALTIME, en nanosegundos).
+ * @param hasta_ns Final de la ventana.
+ * @param nivel Nivel de resolución a usar, o -1 para el más fino que cubre la ventana.
+ * @param percentiles Percentiles a calcular (entre 0 y 100).
+ * @param num_percentiles Cantidad de percentiles (como máximo ALMACEN_MAX_PERCENTILES).
+ * @param resultado Resultado de la consulta.
+ * @return int 0 si hay muestras en la ventana, 1 si no hay, -1 si la métrica no es una columna del almacén.
+ */
+int almacen_consultar(const almacen_metricas* almacen, const char* metrica, uint64_t desde_ns, uint64_t hasta_ns,
+                      int nivel, const double* percentiles, int num_percentiles, resultado_consulta* resultado);
+
+/**
+ * @brief Prepara el historial del shell para un monitor recién iniciado.
+ *
+ * La primera vez crea el almacén con las métricas de config.json y un temporizador que copia el anillo cada
+ * ALMACEN_PERIODO_COPIA segundos. El historial se conserva entre reinicios del monitor.
+ */
+void historial_iniciar(void);
+
+/**
+ * @brief Copia al historial las muestras del anillo que todavía no se copiaron.
+ *
+ * @param anillo Anillo del monitor, o NULL (no hace nada).
+ */
+void historial_sincronizar(const anillo_metricas* anillo);
+
+/**
+ * @brief Libera el historial del shell.
+ */
+void historial_liberar(void);
+
+/**
+ * @brief Maneja el comando interno 'metrics_query'.
+ *
+ * Formato: metrics_query [-w ventana | -s desde] [-r nivel] agregado[,agregado...] [métrica...]
+ *
+ * - -w: duración de la ventana hasta ahora, con unidad s, m, h o d (por ejemplo 5m). Por defecto, todo el historial.
+ * - -s: comienzo de la ventana: %n (el inicio del trabajo n), o segundos desde la época.
+ * - -r: nivel de resolución: 0 (crudo), 1 o 2. Por defecto, el más fino que cubre la ventana.
+ * - agregados: min, max, mean, count o pNN (percentil, por ejemplo p99 o p99.9).
+ * - métricas: columnas del historial, o métricas de config.json como network_usage. Por defecto, todas.
+ *
+ * @param argc Número de argumentos, incluyendo "metrics_query".
+ * @param argv Argumentos del comando.
+ * @return int 0 si todas las métricas tienen muestras en la ventana, 1 si alguna no tiene, 2 si el uso es incorrecto.
+ */
+int manejar_comando_metrics_query(int argc, char** argv);
+
+#endif // METRICS_STORE_H
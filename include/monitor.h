@@ -6,6 +6,23 @@
 #ifndef MONITOR_H
 #define MONITOR_H
 
+#include "metrics_shm.h"
+
+/**
+ *  @brief Ventana en milisegundos en la que varias actualizaciones seguidas se envían al monitor como una sola
+ */
+#define MONITOR_AGRUPAR_MS 200
+
+/**
+ *  @brief Milisegundos que se espera la confirmación del monitor antes de reiniciarlo para aplicar la configuración
+ */
+#define MONITOR_ESPERA_ACK_MS 2000
+
+/**
+ *  @brief Milisegundos que se espera a que el monitor atienda SIGTERM antes de enviarle SIGKILL
+ */
+#define MONITOR_ESPERA_TERMINAR_MS 2000
+
 /**
  * @brief Inicia el proceso de monitoreo si no está ya en ejecución.
  *
@@ -16,6 +33,11 @@
  * Si la llamada a `execl()` falla, se imprime un mensaje de error y el proceso hijo sale con un estado de fallo.
  * Si la llamada a `fork()` falla, se imprime un mensaje de error.
  * Si la llamada a `fork()` tiene éxito, se imprime un mensaje con el PID del nuevo proceso de monitoreo creado.
+ *
+ * Antes del `fork()` se crean el canal de control (ver monitor_protocol.h) y el segmento de métricas (ver
+ * metrics_shm.h); el monitor recibe su extremo del canal en la variable de entorno MONITOR_CONTROL_FD y el nombre del
+ * segmento en MONITOR_SHM. Con el bucle de eventos activo, el shell vigila la terminación del monitor con un pidfd
+ * y lo recolecta si termina por su cuenta.
  */
 void start_monitor(void);
 
@@ -24,15 +46,25 @@ void start_monitor(void);
  *
  * Esta función verifica si el proceso de monitoreo está en ejecución comprobando
  * la variable global `monitor_pid`. Si el proceso de monitoreo está en ejecución,
- * envía una señal SIGTERM para terminarlo. Si la terminación es exitosa, actualiza
- * `monitor_pid` a -1 y muestra un mensaje de éxito. Si la terminación falla,
- * muestra un mensaje de error.
+ * cierra el canal de control y envía una señal SIGTERM para terminarlo; si no termina
+ * en MONITOR_ESPERA_TERMINAR_MS milisegundos, lo termina con SIGKILL. En ambos casos
+ * lo recolecta, actualiza `monitor_pid` a -1 y muestra un mensaje de éxito. Si la
+ * señal no se puede enviar, muestra un mensaje de error.
  *
  * @note La función asume que `monitor_pid` es una variable global que contiene
  * el ID del proceso de monitoreo.
  */
 void stop_monitor(void);
 
+/**
+ * @brief Devuelve el anillo de muestras que publica el monitor en memoria compartida (ver metrics_shm.h).
+ *
+ * El segmento se crea en start_monitor() y se elimina cuando el monitor se detiene o termina.
+ *
+ * @return const anillo_metricas* Anillo mapeado, o NULL si el monitor no está en ejecución o no hay segmento.
+ */
+const anillo_metricas* monitor_metricas(void);
+
 /**
  * @brief Verifica el estado del monitor.
  *
@@ -43,38 +75,49 @@ void stop_monitor(void);
 void status_monitor(void);
 
 /**
- * @brief Maneja el comando de actualización analizando la cadena de entrada, extrayendo el intervalo de muestreo y las
- * métricas, actualizando la configuración y reiniciando el proceso de monitoreo si está en ejecución.
+ * @brief Maneja el comando 'update_config': aplica un cambio a la configuración (ver config_store.h), la guarda si
+ * cambió y se la envía al proceso de monitoreo si está en ejecución.
  *
- * @param input Una cadena que contiene el comando de actualización con el intervalo de muestreo y las métricas.
+ * @param argc Número de argumentos, incluyendo "update_config".
+ * @param argv Argumentos del comando ya tokenizados.
  *
- * La cadena de entrada debe estar en el formato: "update_config interval metric1 metric2 ... metricN"
- * donde interval es el intervalo de muestreo en segundos y metric1, metric2, ..., metricN son las métricas a
- * monitorear.
+ * Formatos:
+ * - "update_config set clave valor": reemplaza el valor de una clave.
+ * - "update_config add clave valor": agrega un valor a una lista (por ejemplo, una métrica).
+ * - "update_config remove clave [valor]": quita un valor de una lista o, sin valor, la clave.
+ * - "update_config interval metric1 ... metricN": forma original; reemplaza el intervalo de muestreo (en segundos)
+ *   y la lista completa de métricas.
  *
  * La función realiza los siguientes pasos:
- * 1. Analiza la cadena de entrada para extraer el intervalo de muestreo y las métricas.
- * 2. Valida el intervalo y las métricas extraídas.
- * 3. Actualiza la configuración con el nuevo intervalo y métricas.
- * 4. Si el proceso de monitoreo está en ejecución, detiene y reinicia el monitor para aplicar la nueva configuración.
+ * 1. Aplica el cambio a la configuración en memoria.
+ * 2. Si algo cambió, escribe el archivo de forma atómica; si nada cambió, no escribe ni envía nada.
+ * 3. Si el proceso de monitoreo está en ejecución, le envía la configuración por el canal de control. Las
+ *    actualizaciones que llegan dentro de MONITOR_AGRUPAR_MS se agrupan y sólo se envía la última. El monitor la
+ *    aplica sin reiniciarse y la confirma; si no entiende el protocolo o no confirma en MONITOR_ESPERA_ACK_MS, se
+ *    lo reinicia para que lea el archivo, como antes.
  *
- * Si no se proporciona el intervalo o no se especifican métricas, la función imprime un mensaje de error y retorna.
+ * Los cambios que otro programa hace en el archivo mientras el monitor está en ejecución se le envían de la misma
+ * forma.
  *
  * Ejemplo de uso:
  * update_config 5 cpu_usage memory_usage
+ * update_config add metrics network_usage
+ *
+ * @return int 0 si la configuración se actualizó o no cambió, 1 si no se pudo guardar, 2 si el uso es incorrecto.
  */
-void handle_update_command(char*);
+int handle_update_command(int, char**);
 
 /**
- * @brief Actualiza el archivo de configuración con el intervalo de muestreo y las métricas proporcionadas.
+ * @brief Actualiza la configuración en memoria con el intervalo de muestreo y las métricas proporcionadas.
  *
- * Esta función crea un objeto JSON que contiene el intervalo de muestreo y un array de métricas,
- * luego escribe este objeto JSON en un archivo de configuración llamado "config.json".
+ * Reemplaza las claves "sampling_interval" y "metrics" de la configuración (ver config_store.h); el archivo se escribe
+ * después con config_guardar().
  *
  * @param interval El intervalo de muestreo que se agregará a la configuración.
  * @param metrics Un array de cadenas que contiene las métricas a agregar.
  * @param metric_count El número de métricas en el array.
+ * @return int 1 si la configuración cambió, 0 si ya tenía esos valores, -1 si no hay memoria.
  */
-void update_config(int, char**, int);
+int update_config(int, char**, int);
 
 #endif // MONITOR_H
@@ -0,0 +1,97 @@
+/**
+ * @file monitor_protocol.h
+ * @brief Protocolo del canal de control entre el shell y el programa de monitoreo.
+ *
+ * El shell crea un par de sockets Unix (SOCK_SEQPACKET) al iniciar el monitor y le pasa un extremo; el número de
+ * descriptor se publica en la variable de entorno MONITOR_CONTROL_FD. Cada mensaje viaja en un único paquete, así el
+ * socket conserva los límites entre mensajes: una cabecera de tamaño fijo seguida de la carga.
+ *
+ * Intercambio:
+ * - El monitor envía MONITOR_MSG_HOLA al arrancar; un monitor que no lo envía no entiende el protocolo y el shell lo
+ *   reinicia para aplicar la configuración, como antes.
+ * - El shell envía MONITOR_MSG_CONFIGURAR con los cambios en JSON ({"sampling_interval": n, "metrics": [...]}).
+ * - El monitor aplica los cambios sin reiniciarse y responde MONITOR_MSG_ACK con la misma secuencia y un estado
+ *   (0 si se aplicaron).
+ */
+
+#ifndef MONITOR_PROTOCOL_H
+#define MONITOR_PROTOCOL_H
+
+#include <stdint.h>
+#include <sys/types.h>
+
+/**
+ *  @brief Variable de entorno con el descriptor del canal de control en el monitor
+ */
+#define MONITOR_CONTROL_ENV "MONITOR_CONTROL_FD"
+
+/**
+ *  @brief Marca al comienzo de cada mensaje ("SMON")
+ */
+#define MONITOR_PROTOCOLO_MAGIA 0x4E4F4D53u
+
+/**
+ *  @brief Versión del protocolo
+ */
+#define MONITOR_PROTOCOLO_VERSION 1
+
+/**
+ *  @brief Tamaño máximo de la carga de un mensaje
+ */
+#define MONITOR_CARGA_MAX 4096
+
+/**
+ * @brief Tipos de mensaje.
+ */
+typedef enum
+{
+    MONITOR_MSG_HOLA = 1,       /**< Monitor -> shell: el monitor entiende el protocolo */
+    MONITOR_MSG_CONFIGURAR = 2, /**< Shell -> monitor: cambios de configuración en JSON */
+    MONITOR_MSG_ACK = 3         /**< Monitor -> shell: configuración aplicada; la carga es un int32_t con el estado */
+} tipo_mensaje_monitor;
+
+/**
+ * @brief Cabecera de un mensaje.
+ */
+typedef struct
+{
+    uint32_t magia;     /**< MONITOR_PROTOCOLO_MAGIA */
+    uint16_t version;   /**< MONITOR_PROTOCOLO_VERSION */
+    uint16_t tipo;      /**< tipo_mensaje_monitor */
+    uint32_t secuencia; /**< Número de mensaje; el ACK repite el de la configuración que confirma */
+    uint32_t longitud;  /**< Bytes de carga que siguen a la cabecera */
+} cabecera_monitor;
+
+/**
+ * @brief Mensaje recibido.
+ */
+typedef struct
+{
+    cabecera_monitor cabecera;         /**< Cabecera validada */
+    char carga[MONITOR_CARGA_MAX + 1]; /**< Carga, terminada en '\0' para las cargas de texto */
+} mensaje_monitor;
+
+/**
+ * @brief Envía un mensaje por el canal de control.
+ *
+ * @param fd Socket del canal.
+ * @param tipo Tipo de mensaje.
+ * @param secuencia Número de mensaje.
+ * @param carga Carga del mensaje, o NULL si no tiene.
+ * @param longitud Bytes de carga (como máximo MONITOR_CARGA_MAX).
+ * @return int 0 si se envió, -1 si hubo un error (errno indica cuál).
+ */
+int monitor_enviar_mensaje(int fd, tipo_mensaje_monitor tipo, uint32_t secuencia, const void* carga,
+                           uint32_t longitud);
+
+/**
+ * @brief Recibe un mensaje del canal de control.
+ *
+ * @param fd Socket del canal.
+ * @param mensaje Mensaje recibido.
+ * @return int 1 si se recibió un mensaje válido, 0 si el otro extremo cerró el canal, -1 si hubo un error o el
+ *         mensaje no respeta el protocolo (EPROTO).
+ */
+int monitor_recibir_mensaje(int fd, mensaje_monitor* mensaje);
+
+#endif // MONITOR_PROTOCOL_H
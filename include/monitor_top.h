@@ -0,0 +1,42 @@
+/**
+ * @file monitor_top.h
+ * @brief Comando interno 'monitor_top': muestra las métricas que publica el monitor.
+ *
+ * Lee el anillo de muestras directamente de la memoria compartida (ver metrics_shm.h): cada actualización de la
+ * pantalla sólo copia muestras del segmento mapeado, sin llamadas al sistema, y escribe el cuadro completo con una
+ * única escritura.
+ */
+
+#ifndef MONITOR_TOP_H
+#define MONITOR_TOP_H
+
+/**
+ *  @brief Muestras de la ventana por defecto
+ */
+#define MONITOR_TOP_VENTANA 60
+
+/**
+ *  @brief Segundos entre actualizaciones por defecto
+ */
+#define MONITOR_TOP_INTERVALO 1
+
+/**
+ * @brief Maneja el comando interno 'monitor_top'.
+ *
+ * Formato: monitor_top [-n muestras] [-d segundos] [-c cuadros]
+ *
+ * - -n: cantidad de muestras de la ventana sobre la que se calculan mínimo, media y máximo (por defecto 60).
+ * - -d: segundos entre actualizaciones (por defecto 1).
+ * - -c: cantidad de cuadros a mostrar. Por defecto, en una terminal se actualiza hasta Ctrl+C y fuera de ella se
+ *   muestra un único cuadro.
+ *
+ * Cada cuadro muestra la última muestra de CPU, memoria y red, y el mínimo, la media y el máximo de la ventana, con
+ * un gráfico de la evolución de CPU y memoria.
+ *
+ * @param argc Número de argumentos, incluyendo "monitor_top".
+ * @param argv Argumentos del comando.
+ * @return int 0 si se mostraron las métricas, 1 si el monitor no está en ejecución, 2 si el uso es incorrecto.
+ */
+int manejar_comando_monitor_top(int argc, char** argv);
+
+#endif // MONITOR_TOP_H
@@ -0,0 +1,46 @@
+/**
+ * @file parallel.h
+ * @brief Comando interno 'parallel': ejecuta un comando sobre muchos elementos con un grupo de trabajadores.
+ *
+ * Los elementos (uno por línea de la entrada estándar, o los argumentos que siguen a ':::') se agrupan en lotes y
+ * cada lote se pasa como argumentos de una ejecución del comando, sin superar ARG_MAX. Cada trabajador es un hilo con
+ * su propia cola de lotes; el que vacía su cola roba lotes del final de la cola de otro, de modo que los lotes lentos
+ * no dejan CPUs ociosas. Cada trabajador lanza sus procesos con posix_spawn() y los espera con waitpid().
+ */
+
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+/**
+ *  @brief Máximo de trabajadores simultáneos
+ */
+#define PARALLEL_MAX_TRABAJADORES 256
+
+/**
+ *  @brief Separador entre el comando y los elementos dados como argumentos
+ */
+#define PARALLEL_SEPARADOR ":::"
+
+/**
+ * @brief Maneja el comando interno 'parallel'.
+ *
+ * Formato: parallel [-j N] [-n N | -X] [-k] [-s] [--halt] comando [args...] [::: elementos...]
+ *
+ * - -j N: cantidad de trabajadores (por defecto, la cantidad de CPUs en línea).
+ * - -n N: máximo de elementos por ejecución (por defecto 1).
+ * - -X: repartir los elementos en partes iguales entre los trabajadores, llenando cada ejecución hasta ARG_MAX.
+ * - -k: mantener la salida en el orden de los elementos; sin -k la salida de los procesos se intercala.
+ * - -s: informar por stderr el estado de salida de cada elemento.
+ * - --halt: no lanzar más ejecuciones después del primer fallo (por defecto se continúa).
+ *
+ * Un argumento "{}" del comando se reemplaza por los elementos del lote; si no hay ninguno, los elementos se agregan
+ * al final. Los elementos que fallan se informan por stderr con su estado de salida.
+ *
+ * @param argc Número de argumentos, incluyendo "parallel".
+ * @param argv Argumentos del comando.
+ * @return int 0 si todas las ejecuciones terminaron bien; en otro caso, la cantidad de elementos que fallaron o no se
+ *         ejecutaron (como máximo 100), o 255 si el uso es incorrecto.
+ */
+int manejar_comando_parallel(int argc, char** argv);
+
+#endif // PARALLEL_H
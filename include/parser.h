@@ -0,0 +1,218 @@
+/**
+ * @file parser.h
+ * @brief Analizador léxico y sintáctico de la línea de comandos.
+ *
+ * En una sola pasada convierte el texto en un árbol de comandos: una lista de pipes separados por ';', '&', '&&',
+ * '||' o saltos de línea, donde cada pipe es una secuencia de comandos simples con sus palabras y redirecciones, o un
+ * único comando compuesto. Soporta comillas simples y dobles, escapes con '\', comentarios con '#' y líneas de
+ * cualquier longitud. Todos los nodos se reservan en una arena, que se libera de una vez al terminar de ejecutar la
+ * línea.
+ *
+ * Los comandos compuestos son los del Bourne Shell: if/elif/else/fi, while y until ... do ... done, for ... in ... do
+ * ... done, case ... in patrón) ... ;; esac, grupos { ...; } y definiciones de funciones nombre() { ...; }. Sus
+ * palabras reservadas sólo se reconocen sin comillas y en el lugar de un nombre de comando. Un comando compuesto no
+ * puede ser una etapa de un pipe de varias etapas, ni ejecutarse en segundo plano, ni llevar redirecciones.
+ *
+ * Las palabras que contienen expansiones ($VAR, ${VAR}, los parámetros especiales $?, $#, $@, $*, $$ y los
+ * posicionales $0 a $9) conservan su texto original y se expanden al ejecutarse con expandir_palabra(); el resto se
+ * guarda ya sin comillas ni escapes. Los valores se buscan con variable_buscar() (ver shell_vars.h).
+ */
+
+#ifndef PARSER_H
+#define PARSER_H
+
+#include "arena.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * @brief Tipo de redirección.
+ */
+typedef enum
+{
+    REDIR_ENTRADA,           /**< n<archivo */
+    REDIR_SALIDA,            /**< n>archivo */
+    REDIR_AGREGAR,           /**< n>>archivo */
+    REDIR_LECTURA_ESCRITURA, /**< n<>archivo: lectura y escritura, sin truncar */
+    REDIR_DUPLICAR,          /**< n>&m o n<&m: copia del descriptor m; n>&- o n<&- cierra n */
+    REDIR_SALIDA_Y_ERRORES,  /**< &>archivo: salida y errores al mismo archivo */
+    REDIR_AGREGAR_Y_ERRORES  /**< &>>archivo */
+} tipo_redireccion;
+
+/**
+ * @brief Palabra de un comando.
+ */
+typedef struct
+{
+    const char* texto; /**< Texto final, o texto original si expandir es true */
+    bool expandir;     /**< La palabra contiene expansiones que se resuelven al ejecutar */
+} palabra;
+
+/**
+ * @brief Redirección de un comando simple.
+ */
+typedef struct redireccion
+{
+    tipo_redireccion tipo;           /**< Tipo de redirección */
+    int fd;                          /**< Descriptor redirigido */
+    palabra destino;                 /**< Archivo destino, o descriptor (o '-') de REDIR_DUPLICAR */
+    struct redireccion* siguiente;   /**< Siguiente redirección, en el orden de la línea */
+} redireccion;
+
+/**
+ * @brief Comando simple: palabras y redirecciones.
+ */
+typedef struct
+{
+    palabra* palabras;                   /**< Palabras del comando; la primera es el nombre */
+    int num_palabras;                    /**< Cantidad de palabras */
+    redireccion* redirecciones;          /**< Lista de redirecciones, NULL si no hay */
+    struct comando_compuesto* compuesto; /**< Comando compuesto, o NULL si es un comando simple */
+} comando_simple;
+
+/**
+ * @brief Cómo se encadena un pipe con el anterior de su lista.
+ */
+typedef enum
+{
+    CONECTOR_SECUENCIA, /**< Primer pipe, o después de ';', '&' o un salto de línea: se ejecuta siempre */
+    CONECTOR_Y,         /**< '&&': se ejecuta si el estado es 0 */
+    CONECTOR_O          /**< '||': se ejecuta si el estado no es 0 */
+} tipo_conector;
+
+/**
+ * @brief Pipe: uno o más comandos simples conectados por '|'.
+ */
+typedef struct
+{
+    comando_simple* etapas; /**< Comandos del pipe, en orden */
+    int num_etapas;         /**< Cantidad de comandos */
+    bool en_segundo_plano;  /**< El pipe terminaba con '&' */
+    int linea;              /**< Línea del texto donde empieza el pipe */
+    tipo_conector conector; /**< Operador que lo une al pipe anterior */
+    bool negado;            /**< El pipe empezaba con '!': se invierte su estado */
+} pipeline;
+
+/**
+ * @brief Lista de pipes a ejecutar en orden.
+ */
+typedef struct lista_comandos
+{
+    pipeline* pipelines; /**< Pipes de la lista */
+    int num_pipelines;   /**< Cantidad de pipes */
+} lista_comandos;
+
+/**
+ * @brief Tipo de comando compuesto.
+ */
+typedef enum
+{
+    COMPUESTO_SI,       /**< if condición; then cuerpo; [elif ...;] [else alternativa;] fi */
+    COMPUESTO_MIENTRAS, /**< while condición; do cuerpo; done */
+    COMPUESTO_HASTA,    /**< until condición; do cuerpo; done */
+    COMPUESTO_PARA,     /**< for nombre [in palabras]; do cuerpo; done */
+    COMPUESTO_CASO,     /**< case palabra in patrón[|patrón]) cuerpo ;; ... esac */
+    COMPUESTO_GRUPO,    /**< { cuerpo; } */
+    COMPUESTO_FUNCION   /**< nombre() comando_compuesto */
+} tipo_compuesto;
+
+/**
+ * @brief Rama de un case.
+ */
+typedef struct rama_caso
+{
+    palabra* patrones;           /**< Patrones de la rama (fnmatch) */
+    int num_patrones;            /**< Cantidad de patrones */
+    lista_comandos* cuerpo;      /**< Comandos de la rama; puede estar vacía */
+    struct rama_caso* siguiente; /**< Siguiente rama, en el orden del texto */
+} rama_caso;
+
+/**
+ * @brief Comando compuesto: estructura de control, grupo o definición de función.
+ */
+typedef struct comando_compuesto
+{
+    tipo_compuesto tipo;         /**< Tipo de comando */
+    lista_comandos* condicion;   /**< Condición de if, while y until */
+    lista_comandos* cuerpo;      /**< Cuerpo; en una función, un pipe con el comando compuesto que la define */
+    lista_comandos* alternativa; /**< else de un if (un elif es un if dentro de la alternativa), o NULL */
+    const char* nombre;          /**< Variable de un for o nombre de una función */
+    palabra* palabras;           /**< Palabras de un for ("$@" si no tenía 'in') o palabra de un case */
+    int num_palabras;            /**< Cantidad de palabras */
+    rama_caso* ramas;            /**< Ramas de un case */
+} comando_compuesto;
+
+/**
+ * @brief Resultado del análisis de un texto.
+ */
+typedef enum
+{
+    PARSEO_OK,        /**< El texto se analizó completo */
+    PARSEO_ERROR,     /**< Error de sintaxis */
+    PARSEO_INCOMPLETO /**< El texto terminó dentro de comillas, después de '|', '&&' o '||', o dentro de un comando
+                           compuesto */
+} resultado_parseo;
+
+/**
+ * @brief Analiza un texto y construye la lista de comandos en la arena.
+ *
+ * @param a Arena donde se reservan todos los nodos.
+ * @param texto Texto a analizar; no necesita estar terminado en '\0'.
+ * @param largo Cantidad de bytes del texto.
+ * @param linea_inicial Número de la primera línea del texto, usado en los nodos y en los mensajes de error.
+ * @param lista Salida: lista de comandos (vacía si el texto sólo tiene espacios o comentarios).
+ * @param error Buffer para el mensaje de error.
+ * @param tam_error Tamaño del buffer de error.
+ * @return resultado_parseo PARSEO_OK si el texto es válido.
+ */
+resultado_parseo parsear_comandos(arena* a, const char* texto, size_t largo, int linea_inicial, lista_comandos** lista,
+                                  char* error, size_t tam_error);
+
+/**
+ * @brief Resuelve comillas, escapes y expansiones de una palabra.
+ *
+ * @param a Arena donde se reserva el resultado.
+ * @param p Palabra a expandir.
+ * @return char* Texto final de la palabra (el propio texto si no requiere expansión), o NULL si no hay memoria.
+ */
+char* expandir_palabra(arena* a, const palabra* p);
+
+/**
+ * @brief Expande las palabras de un comando simple en un vector de argumentos terminado en NULL.
+ *
+ * Las palabras sin comillas cuya expansión queda vacía se descartan, igual que en el Bourne Shell, y una palabra que
+ * es exactamente $@ o "$@" produce un argumento por cada parámetro posicional. No se separan campos: $VAR produce un
+ * solo argumento aunque su valor tenga espacios.
+ *
+ * @param a Arena donde se reserva el vector.
+ * @param comando Comando simple.
+ * @param argc Salida: cantidad de argumentos.
+ * @return char** Vector de argumentos, o NULL si no hay memoria.
+ */
+char** expandir_argumentos(arena* a, const comando_simple* comando, int* argc);
+
+/**
+ * @brief Expande una lista de palabras separando en campos las expansiones sin comillas, como la lista de un for.
+ *
+ * Una palabra sin comillas se divide en los espacios, tabuladores y saltos de línea de su expansión; una palabra con
+ * comillas produce un solo campo, salvo "$@", que produce uno por parámetro posicional.
+ *
+ * @param a Arena donde se reservan el vector y los campos.
+ * @param palabras Palabras a expandir.
+ * @param n Cantidad de palabras.
+ * @param num_campos Salida: cantidad de campos.
+ * @return char** Campos terminados en NULL, o NULL si no hay memoria.
+ */
+char** expandir_campos(arena* a, const palabra* palabras, int n, int* num_campos);
+
+/**
+ * @brief Verifica si un texto es un nombre válido de variable o de función: letras, dígitos y '_', sin empezar con
+ * un dígito.
+ *
+ * @param texto Texto a verificar.
+ * @param largo Cantidad de bytes del texto.
+ * @return true si es un nombre válido.
+ */
+bool es_nombre_valido(const char* texto, size_t largo);
+
+#endif // PARSER_H
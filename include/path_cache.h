@@ -0,0 +1,66 @@
+/**
+ * @file path_cache.h
+ * @brief Caché de ubicación de comandos: tabla hash de nombre a ruta absoluta dentro de $PATH.
+ *
+ * La primera vez que se ejecuta un comando se recorre $PATH y la ruta encontrada queda guardada; las ejecuciones
+ * siguientes van directo a posix_spawn() sobre esa ruta. La caché se vacía sola cuando cambia $PATH, y una entrada
+ * se descarta cuando el archivo al que apunta deja de existir. Las funciones de la caché pueden llamarse desde varios
+ * hilos.
+ */
+
+#ifndef PATH_CACHE_H
+#define PATH_CACHE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * @brief Resuelve el nombre de un comando a una ruta ejecutable.
+ *
+ * Si el nombre contiene una barra se devuelve tal cual, sin consultar $PATH ni la caché. En otro caso se consulta la
+ * caché y, si no hay entrada, se recorre $PATH y se guarda el resultado. Cada consulta exitosa incrementa el contador
+ * de usos de la entrada.
+ *
+ * @param nombre Nombre del comando.
+ * @param ruta Buffer donde se copia la ruta resuelta.
+ * @param tam Tamaño del buffer.
+ * @return true si se encontró un ejecutable, false en caso contrario.
+ */
+bool cache_resolver(const char* nombre, char* ruta, size_t tam);
+
+/**
+ * @brief Descarta la entrada de un comando, por ejemplo porque su ruta ya no existe.
+ *
+ * @param nombre Nombre del comando.
+ * @return true si había una entrada para el comando.
+ */
+bool cache_olvidar(const char* nombre);
+
+/**
+ * @brief Vacía la caché completa.
+ */
+void cache_limpiar(void);
+
+/**
+ * @brief Devuelve la cantidad de comandos guardados en la caché.
+ *
+ * @return size_t Número de entradas.
+ */
+size_t cache_tamano(void);
+
+/**
+ * @brief Maneja el comando interno 'hash'.
+ *
+ * Formatos soportados:
+ * - hash: lista las entradas con su cantidad de usos.
+ * - hash -r: vacía la caché.
+ * - hash -d nombre...: descarta las entradas indicadas.
+ * - hash nombre...: busca los comandos en $PATH y los guarda en la caché (precarga).
+ *
+ * @param argc Número de argumentos, incluyendo "hash".
+ * @param argv Argumentos del comando.
+ * @return int 0 si todos los comandos se encontraron, 1 en caso contrario.
+ */
+int manejar_comando_hash(int argc, char** argv);
+
+#endif // PATH_CACHE_H
@@ -0,0 +1,95 @@
+/**
+ * @file prompt.h
+ * @brief Motor del prompt: datos en caché, segmentos configurables y cálculo asíncrono de los segmentos lentos.
+ *
+ * Usuario, host y directorio home (de getpwuid()) se leen una sola vez; el directorio actual se toma de la variable
+ * global cwd, que sólo cambia con 'cd' (ver actualizar_pwd()). El prompt se arma en un buffer y se escribe con un
+ * único write().
+ *
+ * Después de "usuario@host:directorio" pueden mostrarse segmentos, en el orden elegido con el comando 'prompt' o con
+ * la variable de entorno PROMPT_ENV:
+ * - estado: estado de salida del último comando, si no fue 0.
+ * - duracion: duración del último comando, si superó PROMPT_DURACION_MINIMA_MS.
+ * - trabajos: cantidad de trabajos en la tabla, si hay alguno.
+ * - monitor: indica si el monitor está en ejecución.
+ * - git: rama (o commit) del repositorio git del directorio actual.
+ *
+ * Los segmentos lentos (git, que recorre el sistema de archivos) se calculan en un hilo aparte. El prompt espera el
+ * resultado a lo sumo PROMPT_PRESUPUESTO_MS; si no llega a tiempo se muestra el último valor calculado para el mismo
+ * directorio, o nada, y el resultado nuevo aparece en el próximo prompt.
+ */
+
+#ifndef PROMPT_H
+#define PROMPT_H
+
+#include <stddef.h>
+
+/**
+ *  @brief Variable de entorno con los segmentos iniciales del prompt, separados por comas o espacios
+ */
+#define PROMPT_ENV "SHELL_PROMPT"
+
+/**
+ *  @brief Tiempo máximo que el prompt espera a los segmentos lentos, en milisegundos
+ */
+#define PROMPT_PRESUPUESTO_MS 20
+
+/**
+ *  @brief Duración mínima de un comando para mostrarla en el segmento "duracion", en milisegundos
+ */
+#define PROMPT_DURACION_MINIMA_MS 1000
+
+/**
+ * @brief Registra el comienzo de un comando, para medir su duración.
+ */
+void prompt_antes_de_comando(void);
+
+/**
+ * @brief Registra el final de un comando: su duración y su estado de salida (ultimo_estado).
+ *
+ * Los segmentos lentos se vuelven a calcular para el próximo prompt, porque el comando pudo cambiarlos (por ejemplo,
+ * 'git checkout').
+ */
+void prompt_despues_de_comando(void);
+
+/**
+ * @brief Actualiza el directorio que muestra el prompt a partir de cwd; se llama después de cada 'cd'.
+ */
+void prompt_directorio_cambiado(void);
+
+/**
+ * @brief Arma el prompt en un buffer.
+ *
+ * La primera llamada lee usuario, host y home. Puede esperar a los segmentos lentos hasta PROMPT_PRESUPUESTO_MS.
+ *
+ * @param buffer Buffer de destino; el texto siempre termina en '\0'.
+ * @param tam Tamaño del buffer.
+ * @return size_t Longitud del prompt (recortada al tamaño del buffer).
+ */
+size_t prompt_componer(char* buffer, size_t tam);
+
+/**
+ * @brief Muestra el prompt en la salida estándar con un único write(), después de vaciar el buffer de stdout.
+ */
+void prompt_mostrar(void);
+
+/**
+ * @brief Detiene el hilo de los segmentos lentos, si se creó.
+ */
+void prompt_liberar(void);
+
+/**
+ * @brief Maneja el comando interno 'prompt'.
+ *
+ * Formatos soportados:
+ * - prompt: muestra los segmentos activos y los disponibles.
+ * - prompt -r: quita todos los segmentos.
+ * - prompt segmento...: reemplaza los segmentos activos; los nombres pueden separarse con espacios o comas.
+ *
+ * @param argc Número de argumentos, incluyendo "prompt".
+ * @param argv Argumentos del comando.
+ * @return int 0 si se pudo, 2 si algún segmento no existe (la configuración no cambia).
+ */
+int manejar_comando_prompt(int argc, char** argv);
+
+#endif // PROMPT_H
@@ -0,0 +1,163 @@
+/**
+ * @file script_cache.h
+ * @brief Caché en disco de los scripts ya compilados a bytecode.
+ *
+ * Al ejecutar un archivo de comandos (ver batch.h) se guarda, junto al resto de las cachés del shell, la secuencia
+ * de unidades en que quedó dividido: los programas compilados (ver bytecode.h), las directivas de los bloques
+ * paralelos y los errores de sintaxis. La próxima ejecución del mismo archivo mapea la caché con mmap() y ejecuta
+ * los programas directamente desde el mapa, sin volver a leer ni a analizar el texto.
+ *
+ * Cada archivo de caché se identifica por la ruta real del script y guarda el tamaño, el dispositivo, el inodo y
+ * st_mtim del script, la versión del shell y la del formato del bytecode. Una caché que no coincide con el script
+ * actual, que está truncada o cuya suma de verificación no coincide se descarta y se vuelve a generar. Un script
+ * modificado hace menos de CACHE_SCRIPTS_MARGEN_NS no se guarda: la resolución de st_mtim podría ocultar una
+ * segunda modificación.
+ *
+ * Las cachés se guardan en el directorio de la variable de entorno CACHE_SCRIPTS_ENV o, si no está definida, en
+ * $XDG_CACHE_HOME/ShellProject/scripts (o $HOME/.cache/ShellProject/scripts), de forma atómica.
+ */
+
+#ifndef SCRIPT_CACHE_H
+#define SCRIPT_CACHE_H
+
+#include "bytecode.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/stat.h>
+
+/**
+ *  @brief Versión del shell; forma parte de la identificación de cada caché
+ */
+#ifndef SHELL_VERSION
+#define SHELL_VERSION "desconocida"
+#endif
+
+/**
+ *  @brief Variable de entorno con el directorio de las cachés de scripts
+ */
+#define CACHE_SCRIPTS_ENV "SHELL_CACHE_SCRIPTS"
+
+/**
+ *  @brief Identificación de un archivo de caché ("SHSC")
+ */
+#define CACHE_SCRIPTS_MAGIA 0x43534853u
+
+/**
+ *  @brief Versión del formato del archivo de caché
+ */
+#define CACHE_SCRIPTS_VERSION 1u
+
+/**
+ *  @brief Antigüedad mínima de la modificación de un script para guardar su caché
+ */
+#define CACHE_SCRIPTS_MARGEN_NS 2000000000LL
+
+/**
+ * @brief Tipo de unidad de un script.
+ */
+typedef enum
+{
+    UNIDAD_COMANDOS,        /**< Lista de comandos ya compilada, lista para ejecutar */
+    UNIDAD_INICIO_PARALELO, /**< begin_parallel [N] */
+    UNIDAD_FIN_PARALELO,    /**< end_parallel */
+    UNIDAD_ERROR            /**< Error de sintaxis */
+} tipo_unidad;
+
+/**
+ * @brief Unidad leída de una caché; sus datos apuntan al mapa.
+ */
+typedef struct
+{
+    tipo_unidad tipo;  /**< Tipo de unidad */
+    int linea;         /**< Línea donde empieza la unidad */
+    int grado;         /**< Procesos simultáneos, 0 para la cantidad de CPUs (sólo UNIDAD_INICIO_PARALELO) */
+    programa programa; /**< Programa abierto sobre el mapa (sólo UNIDAD_COMANDOS) */
+    const char* error; /**< Mensaje (sólo UNIDAD_ERROR) */
+} unidad_cacheada;
+
+/**
+ * @brief Caché de un script abierta para leer.
+ */
+typedef struct
+{
+    unsigned char* mapa; /**< Archivo de caché mapeado */
+    size_t largo;        /**< Tamaño del mapa */
+    size_t posicion;     /**< Desplazamiento del próximo registro */
+    uint32_t restantes;  /**< Unidades que quedan por leer */
+    int lineas;          /**< Líneas del script */
+} cache_script;
+
+/**
+ * @brief Caché de un script en construcción.
+ */
+typedef struct
+{
+    char* archivo;         /**< Ruta del archivo de caché, o NULL si no se guardará */
+    unsigned char* datos;  /**< Contenido, cabecera incluida */
+    size_t largo;          /**< Bytes usados */
+    size_t capacidad;      /**< Capacidad de datos */
+    uint32_t num_unidades; /**< Unidades agregadas */
+    bool ok;               /**< No hubo errores de memoria */
+} escritor_cache;
+
+/**
+ * @brief Abre la caché de un script si existe y corresponde a su versión actual.
+ *
+ * Se verifican la identificación del script, la suma de verificación y cada unidad (los programas con
+ * programa_abrir()), de modo que las unidades de una caché abierta pueden ejecutarse sin más controles. Una caché
+ * inválida se borra.
+ *
+ * @param ruta Ruta del script.
+ * @param info Datos de stat() del script, obtenidos antes de leerlo.
+ * @param c Salida: caché abierta.
+ * @return int 0 si se abrió, -1 si no hay una caché válida.
+ */
+int cache_abrir(const char* ruta, const struct stat* info, cache_script* c);
+
+/**
+ * @brief Lee la siguiente unidad de una caché abierta.
+ *
+ * @param c Caché.
+ * @param u Salida: unidad; sigue siendo válida hasta cerrar la caché.
+ * @return true si se leyó una unidad, false al final de la caché.
+ */
+bool cache_siguiente(cache_script* c, unidad_cacheada* u);
+
+/**
+ * @brief Cierra una caché abierta con cache_abrir().
+ *
+ * @param c Caché.
+ */
+void cache_cerrar(cache_script* c);
+
+/**
+ * @brief Empieza a armar la caché de un script.
+ *
+ * Si no hay directorio de cachés, el script no es un archivo regular o se modificó hace muy poco, el escritor
+ * acepta unidades pero cache_terminar() no guarda nada.
+ *
+ * @param w Escritor.
+ * @param ruta Ruta del script.
+ * @param info Datos de stat() del script, obtenidos antes de leerlo.
+ */
+void cache_crear(escritor_cache* w, const char* ruta, const struct stat* info);
+
+/**
+ * @brief Agrega una unidad a la caché en construcción.
+ *
+ * @param w Escritor.
+ * @param u Unidad; para UNIDAD_COMANDOS se copia el bloque del programa y para UNIDAD_ERROR, el mensaje.
+ */
+void cache_agregar(escritor_cache* w, const unidad_cacheada* u);
+
+/**
+ * @brief Guarda la caché (si corresponde) y libera el escritor.
+ *
+ * @param w Escritor.
+ * @param lineas Líneas del script.
+ * @param guardar false para descartar la caché, por ejemplo si no se llegó a leer todo el script.
+ */
+void cache_terminar(escritor_cache* w, int lineas, bool guardar);
+
+#endif // SCRIPT_CACHE_H
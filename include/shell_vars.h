@@ -0,0 +1,104 @@
+/**
+ * @file shell_vars.h
+ * @brief Variables del shell, parámetros posicionales y parámetros especiales.
+ *
+ * Una asignación nombre=valor crea una variable del shell, que los programas lanzados no ven, salvo que el nombre ya
+ * sea una variable de entorno: en ese caso se actualiza el entorno, como en el Bourne Shell con las variables
+ * exportadas. 'export' pasa una variable al entorno y 'unset' la elimina de los dos lugares.
+ *
+ * Al expandir una palabra, variable_buscar() resuelve además los parámetros especiales: $? (estado del último
+ * comando), $# (cantidad de parámetros posicionales), $@ y $* (los parámetros separados por espacios), $$ (PID del
+ * shell) y $0 a $9 (nombre del shell o del script y parámetros posicionales, que fija cada llamada a una función).
+ */
+
+#ifndef SHELL_VARS_H
+#define SHELL_VARS_H
+
+#include <stdbool.h>
+
+/**
+ * @brief Parámetros posicionales ($1, $2, ...) de la función en ejecución.
+ */
+typedef struct
+{
+    char** valores; /**< Parámetros, sin el nombre de la función; los administra quien los fija */
+    int cantidad;   /**< Cantidad de parámetros */
+} parametros_shell;
+
+/**
+ * @brief Busca el valor de una variable o de un parámetro especial.
+ *
+ * @param nombre Nombre de la variable, o "?", "#", "@", "*", "$" o un número.
+ * @return const char* Valor (válido hasta la próxima asignación o búsqueda de un parámetro especial), o NULL si no
+ *         está definida.
+ */
+const char* variable_buscar(const char* nombre);
+
+/**
+ * @brief Asigna una variable: en el entorno si ya era una variable de entorno, como variable del shell si no.
+ *
+ * @param nombre Nombre válido de variable (ver es_nombre_valido()).
+ * @param valor Valor; se copia.
+ * @return int 0 si se asignó, -1 si no hubo memoria.
+ */
+int variable_asignar(const char* nombre, const char* valor);
+
+/**
+ * @brief Elimina una variable del shell y del entorno.
+ *
+ * @param nombre Nombre de la variable.
+ */
+void variable_eliminar(const char* nombre);
+
+/**
+ * @brief Fija el valor de $0: el nombre del shell o la ruta del script en ejecución.
+ *
+ * @param nombre Nombre; no se copia y debe seguir siendo válido mientras se use.
+ */
+void parametros_fijar_nombre(const char* nombre);
+
+/**
+ * @brief Devuelve los parámetros posicionales actuales.
+ *
+ * @param cantidad Salida: cantidad de parámetros.
+ * @return char* const* Parámetros ($1 en la posición 0).
+ */
+char* const* parametros_posicionales(int* cantidad);
+
+/**
+ * @brief Reemplaza los parámetros posicionales, por ejemplo al llamar a una función.
+ *
+ * @param cantidad Cantidad de parámetros.
+ * @param valores Parámetros; no se copian y deben seguir siendo válidos hasta restaurar los anteriores.
+ * @param anteriores Salida: parámetros que había, para parametros_restaurar().
+ */
+void parametros_cambiar(int cantidad, char** valores, parametros_shell* anteriores);
+
+/**
+ * @brief Vuelve a los parámetros posicionales guardados por parametros_cambiar().
+ *
+ * @param anteriores Parámetros guardados.
+ */
+void parametros_restaurar(const parametros_shell* anteriores);
+
+/**
+ * @brief Maneja el comando interno 'export'.
+ *
+ * Formato: export [nombre[=valor]...]. Sin argumentos lista las variables del shell que no están en el entorno.
+ *
+ * @param argc Número de argumentos, incluyendo "export".
+ * @param argv Argumentos del comando.
+ * @return int 0 si todos los nombres son válidos, 1 en caso contrario.
+ */
+int manejar_comando_export(int argc, char** argv);
+
+/**
+ * @brief Maneja el comando interno 'unset': elimina las variables indicadas.
+ *
+ * @param argc Número de argumentos, incluyendo "unset".
+ * @param argv Argumentos del comando.
+ * @return int 0 si todos los nombres son válidos, 1 en caso contrario.
+ */
+int manejar_comando_unset(int argc, char** argv);
+
+#endif // SHELL_VARS_H
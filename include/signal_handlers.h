@@ -5,28 +5,16 @@
 #ifndef SIGNAL_HANDLERS_H
 #define SIGNAL_HANDLERS_H
 
-/**
- * @brief Manejador de señales.
- * @param sig El número de señal recibido.
- *
- * Esta función maneja las señales comprobando si hay un proceso en primer plano.
- * Si hay un proceso en primer plano, envía la señal recibida a ese grupo de procesos.
- * De lo contrario, imprime una nueva línea, muestra el prompt y vacía el búfer de salida.
- */
-void manejador_senales(int sig);
 /**
  * @brief Manejador de la señal SIGCHLD.
  *
- * Esta función se llama cuando se recibe una señal SIGCHLD, indicando que un proceso hijo ha terminado.
- * Recoge el estado de todos los procesos hijos terminados y actualiza la lista de trabajos en consecuencia.
+ * Esta función se llama cuando se recibe una señal SIGCHLD, indicando que un proceso hijo cambió de estado.
+ * Sólo activa la bandera hijos_pendientes, que es lo único seguro dentro de un manejador de señales; la recolección
+ * y los avisos se hacen después, entre comandos, con trabajos_actualizar() y trabajos_notificar(). Las etapas de un
+ * pipe en primer plano las recolecta el propio pipe (ver esperar_procesos()).
  *
- * La función realiza los siguientes pasos:
- * 1. Utiliza waitpid en un bucle con WNOHANG para recoger el estado de todos los procesos hijos terminados.
- * 2. Itera a través de la lista de trabajos para encontrar el trabajo correspondiente a cada proceso hijo terminado.
- * 3. Imprime un mensaje indicando la terminación del proceso hijo.
- * 4. Decrementa el contador de ID de trabajo y limpia el PID de la lista de trabajos.
- * 5. Llama a mostrar_prompt para mostrar el prompt después de manejar SIGCHLD.
- * 6. Vacía la salida estándar para asegurar que el prompt se muestre correctamente.
+ * Mientras el bucle de eventos está activo SIGCHLD permanece bloqueada y se lee por signalfd (ver event_loop.h); este
+ * manejador sólo se ejecuta cuando esperar_procesos() la desbloquea dentro de ppoll().
  */
 void manejador_SIGCHLD(int sig __attribute__((unused)));
 
@@ -0,0 +1,67 @@
+/**
+ * @file simd_search.h
+ * @brief Búsqueda de subcadenas y conteo de bytes con instrucciones vectoriales.
+ *
+ * La búsqueda de subcadenas compara a la vez 16 (SSE2) o 32 (AVX2) posiciones candidatas: una máscara marca las
+ * posiciones donde coinciden el primer y el último byte de la aguja, y sólo esas se verifican con memcmp(). Con
+ * agujas cuyos extremos son poco frecuentes casi ningún candidato llega a verificarse.
+ *
+ * SSE2 está siempre disponible en x86-64; AVX2 se compila aparte con el atributo target y se usa sólo si el
+ * procesador lo informa. En otras arquitecturas se usa la versión escalar, que recorre los candidatos con memchr().
+ */
+
+#ifndef SIMD_SEARCH_H
+#define SIMD_SEARCH_H
+
+#include <stddef.h>
+
+/**
+ * @brief Juego de instrucciones de una búsqueda
+ */
+typedef enum
+{
+    BUSQUEDA_ESCALAR, /**< memchr() y memcmp() de la biblioteca */
+    BUSQUEDA_SSE2,    /**< Bloques de 16 bytes */
+    BUSQUEDA_AVX2     /**< Bloques de 32 bytes */
+} nivel_busqueda;
+
+/**
+ * @brief Devuelve el mejor juego de instrucciones que soporta el procesador.
+ *
+ * @return nivel_busqueda Nivel disponible; los niveles menores también lo están.
+ */
+nivel_busqueda busqueda_nivel_disponible(void);
+
+/**
+ * @brief Devuelve el nombre de un juego de instrucciones ("escalar", "sse2" o "avx2").
+ *
+ * @param nivel Juego de instrucciones.
+ * @return const char* Nombre.
+ */
+const char* busqueda_nombre_nivel(nivel_busqueda nivel);
+
+/**
+ * @brief Busca la primera aparición de una subcadena.
+ *
+ * @param nivel Juego de instrucciones; no mayor que busqueda_nivel_disponible().
+ * @param texto Texto en el que se busca; no necesita terminar en '\0'.
+ * @param largo Bytes del texto.
+ * @param aguja Subcadena buscada.
+ * @param largo_aguja Bytes de la subcadena; una vacía aparece al principio del texto.
+ * @return const char* Primera aparición dentro del texto, o NULL si no aparece.
+ */
+const char* buscar_subcadena(nivel_busqueda nivel, const char* texto, size_t largo, const char* aguja,
+                             size_t largo_aguja);
+
+/**
+ * @brief Cuenta las apariciones de un byte (por ejemplo, los saltos de línea antes de una coincidencia).
+ *
+ * @param nivel Juego de instrucciones; no mayor que busqueda_nivel_disponible().
+ * @param texto Texto.
+ * @param largo Bytes del texto.
+ * @param byte Byte buscado.
+ * @return size_t Apariciones.
+ */
+size_t contar_byte(nivel_busqueda nivel, const char* texto, size_t largo, char byte);
+
+#endif // SIMD_SEARCH_H
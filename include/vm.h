@@ -0,0 +1,60 @@
+/**
+ * @file vm.h
+ * @brief Máquina virtual que ejecuta los programas de bytecode, y tabla de funciones del shell.
+ *
+ * La máquina recorre las instrucciones de un programa (ver bytecode.h) dentro del propio shell: los saltos, los
+ * ciclos, los case y las asignaciones no crean procesos, y cada pipe se entrega a ejecutar_pipe() (commands.h). El
+ * estado de la máquina es ultimo_estado ($?); los ciclos en curso guardan su propio estado y, en un for, los campos
+ * que quedan por recorrer. Las expansiones de cada instrucción se liberan al terminarla, por lo que un ciclo largo
+ * no acumula memoria.
+ *
+ * Una definición de función guarda una copia del programa que la contiene (compartida por todas las funciones
+ * definidas en él) y la posición de su cuerpo, de modo que la función sigue disponible después de liberar la línea o
+ * la unidad del script donde se definió. Cada llamada fija sus propios parámetros posicionales y ejecuta el cuerpo
+ * con una máquina nueva, con sus propios ciclos.
+ */
+
+#ifndef VM_H
+#define VM_H
+
+#include "bytecode.h"
+
+/**
+ *  @brief Máximo de llamadas a funciones anidadas (protege la pila del shell de una recursión sin fin)
+ */
+#define VM_MAX_LLAMADAS 200
+
+/**
+ * @brief Función definida en el shell.
+ */
+typedef struct funcion_shell funcion_shell;
+
+/**
+ * @brief Ejecuta un programa desde su primera instrucción.
+ *
+ * La ejecución se detiene al llegar a OP_FIN, cuando un comando pide salir del shell o cuando un comando termina
+ * por SIGINT (Ctrl+C interrumpe el script entero, no sólo el comando en curso).
+ *
+ * @param p Programa abierto; debe seguir siendo válido hasta que termine la ejecución.
+ */
+void vm_ejecutar(const programa* p);
+
+/**
+ * @brief Busca una función definida en el shell.
+ *
+ * @param nombre Nombre de la función.
+ * @return funcion_shell* Función, o NULL si no existe. Sigue siendo válida aunque la función se redefina.
+ */
+funcion_shell* vm_buscar_funcion(const char* nombre);
+
+/**
+ * @brief Llama a una función con los argumentos indicados como parámetros posicionales.
+ *
+ * @param f Función devuelta por vm_buscar_funcion().
+ * @param argc Cantidad de argumentos, incluyendo el nombre de la función.
+ * @param argv Argumentos; argv[1] pasa a ser $1. Deben seguir siendo válidos durante la llamada.
+ * @return int Estado de salida: el de return, o el del último comando de la función.
+ */
+int vm_llamar_funcion(funcion_shell* f, int argc, char** argv);
+
+#endif // VM_H
@@ -0,0 +1,145 @@
+/**
+ * @file arena.c
+ * @brief Implementación de la arena de memoria por bloques.
+ */
+
+#include "arena.h"
+#include <stdalign.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Redondear un tamaño al alineamiento máximo
+static size_t alinear(size_t tam)
+{
+    size_t alineamiento = alignof(max_align_t);
+    return (tam + alineamiento - 1) & ~(alineamiento - 1);
+}
+
+// Crear un bloque con al menos la capacidad pedida
+static bloque_arena* nuevo_bloque(size_t minimo)
+{
+    size_t capacidad = minimo > ARENA_TAM_BLOQUE ? minimo : ARENA_TAM_BLOQUE;
+    bloque_arena* bloque = malloc(sizeof(bloque_arena) + capacidad);
+    if (bloque == NULL)
+    {
+        return NULL;
+    }
+    bloque->siguiente = NULL;
+    bloque->capacidad = capacidad;
+    bloque->usado = 0;
+    return bloque;
+}
+
+// Inicializar una arena vacía
+void arena_inicializar(arena* a)
+{
+    a->primero = NULL;
+    a->actual = NULL;
+}
+
+// Reservar memoria en la arena
+void* arena_reservar(arena* a, size_t tam)
+{
+    tam = alinear(tam == 0 ? 1 : tam);
+
+    if (a->actual == NULL) // Primera reserva
+    {
+        a->primero = a->actual = nuevo_bloque(tam);
+        if (a->actual == NULL)
+        {
+            return NULL;
+        }
+    }
+
+    while (a->actual->capacidad - a->actual->usado < tam)
+    {
+        bloque_arena* siguiente = a->actual->siguiente;
+        if (siguiente != NULL && siguiente->capacidad >= tam)
+        {
+            siguiente->usado = 0; // Reutilizar un bloque de una vuelta anterior
+        }
+        else
+        {
+            // Insertar un bloque nuevo después del actual, conservando los que siguen
+            bloque_arena* bloque = nuevo_bloque(tam);
+            if (bloque == NULL)
+            {
+                return NULL;
+            }
+            bloque->siguiente = siguiente;
+            a->actual->siguiente = bloque;
+            siguiente = bloque;
+        }
+        a->actual = siguiente;
+    }
+
+    void* memoria = a->actual->datos + a->actual->usado;
+    a->actual->usado += tam;
+    return memoria;
+}
+
+// Reservar memoria inicializada en cero
+void* arena_reservar_cero(arena* a, size_t tam)
+{
+    void* memoria = arena_reservar(a, tam);
+    if (memoria != NULL)
+    {
+        memset(memoria, 0, tam);
+    }
+    return memoria;
+}
+
+// Copiar una cadena en la arena
+char* arena_copiar(arena* a, const char* texto, size_t n)
+{
+    char* copia = arena_reservar(a, n + 1);
+    if (copia != NULL)
+    {
+        memcpy(copia, texto, n);
+        copia[n] = '\0';
+    }
+    return copia;
+}
+
+// Liberar todo lo reservado en O(1)
+void arena_reiniciar(arena* a)
+{
+    a->actual = a->primero;
+    if (a->actual != NULL)
+    {
+        a->actual->usado = 0;
+    }
+}
+
+// Tomar una marca de la posición actual
+marca_arena arena_marcar(const arena* a)
+{
+    marca_arena marca = {.bloque = a->actual, .usado = a->actual != NULL ? a->actual->usado : 0};
+    return marca;
+}
+
+// Liberar lo reservado después de una marca
+void arena_volver(arena* a, marca_arena marca)
+{
+    if (marca.bloque == NULL)
+    {
+        arena_reiniciar(a);
+        return;
+    }
+    a->actual = marca.bloque; // Los bloques siguientes quedan en la cadena para reutilizarse
+    a->actual->usado = marca.usado;
+}
+
+// Devolver todos los bloques al sistema
+void arena_liberar(arena* a)
+{
+    bloque_arena* bloque = a->primero;
+    while (bloque != NULL)
+    {
+        bloque_arena* siguiente = bloque->siguiente;
+        free(bloque);
+        bloque = siguiente;
+    }
+    a->primero = NULL;
+    a->actual = NULL;
+}
@@ -0,0 +1,668 @@
+/**
+ * @file batch.c
+ * @brief Implementación de la ejecución de archivos de comandos con análisis adelantado y bloques paralelos.
+ */
+
+#include "batch.h"
+#include "arena.h"
+#include "bytecode.h"
+#include "commands.h"
+#include "event_loop.h"
+#include "globals.h"
+#include "jobs.h"
+#include "launcher.h"
+#include "parser.h"
+#include "script_cache.h"
+#include "shell_vars.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+/**
+ * @brief Unidad del script ya analizada, con la arena donde vive su árbol.
+ */
+typedef struct
+{
+    tipo_unidad tipo;       /**< Tipo de unidad */
+    lista_comandos* lista;  /**< Comandos */
+    programa programa;      /**< Comandos compilados (sólo UNIDAD_COMANDOS) */
+    int linea;              /**< Línea donde empieza la unidad */
+    int grado;              /**< Procesos simultáneos, 0 para la cantidad de CPUs (sólo UNIDAD_INICIO_PARALELO) */
+    char error[256];        /**< Mensaje (sólo UNIDAD_ERROR) */
+    arena memoria;          /**< Arena de la unidad; se reutiliza al reciclar la unidad */
+} unidad_script;
+
+/**
+ * @brief Cola circular de unidades entre el hilo lector y el hilo que ejecuta.
+ */
+typedef struct
+{
+    unidad_script unidades[BATCH_COMANDOS_ADELANTADOS]; /**< Unidades de la cola */
+    int inicio;                                        /**< Próxima unidad a ejecutar */
+    int cantidad;                                      /**< Unidades publicadas y todavía no liberadas */
+    bool terminado;                                    /**< El lector llegó al final del texto */
+    bool cancelado;                                    /**< El ejecutor dejó de consumir (por ejemplo, quit) */
+    int lineas;                                        /**< Líneas leídas por el lector */
+    const char* texto;                                 /**< Texto completo del script */
+    size_t largo;                                      /**< Largo del texto */
+    escritor_cache cache;                              /**< Caché que arma el lector con las unidades analizadas */
+    pthread_mutex_t mutex;                             /**< Protege los campos de control */
+    pthread_cond_t hay_unidades;                       /**< Se publicó una unidad o el lector terminó */
+    pthread_cond_t hay_lugar;                          /**< Se liberó una unidad o se canceló la lectura */
+} cola_script;
+
+/**
+ * @brief Comando de un bloque paralelo en ejecución.
+ */
+typedef struct
+{
+    pid_t pid;   /**< Proceso hijo que ejecuta el comando */
+    int linea;   /**< Línea del comando en el script */
+} comando_paralelo;
+
+/**
+ * @brief Estado de la ejecución del script.
+ */
+typedef struct
+{
+    const char* ruta;                /**< Ruta del script, para los mensajes */
+    bool informar;                   /**< Informar los comandos que fallan y el resumen final (no en source) */
+    int comandos;                    /**< Comandos ejecutados */
+    int fallos;                      /**< Comandos fallidos y errores de sintaxis */
+    bool en_bloque;                  /**< Dentro de begin_parallel ... end_parallel */
+    int grado;                       /**< Procesos simultáneos del bloque actual */
+    comando_paralelo* activos;       /**< Comandos del bloque en ejecución */
+    int num_activos;                 /**< Cantidad de comandos en ejecución */
+} ejecucion_script;
+
+// Esperar una unidad libre para analizar; devuelve NULL si la lectura fue cancelada
+static unidad_script* reservar_unidad(cola_script* cola)
+{
+    pthread_mutex_lock(&cola->mutex);
+    while (cola->cantidad == BATCH_COMANDOS_ADELANTADOS && !cola->cancelado)
+    {
+        pthread_cond_wait(&cola->hay_lugar, &cola->mutex);
+    }
+    unidad_script* u =
+        cola->cancelado ? NULL : &cola->unidades[(cola->inicio + cola->cantidad) % BATCH_COMANDOS_ADELANTADOS];
+    pthread_mutex_unlock(&cola->mutex);
+    return u;
+}
+
+// Entregar al ejecutor la unidad reservada
+static void publicar_unidad(cola_script* cola)
+{
+    pthread_mutex_lock(&cola->mutex);
+    cola->cantidad++;
+    pthread_cond_signal(&cola->hay_unidades);
+    pthread_mutex_unlock(&cola->mutex);
+}
+
+// Esperar la siguiente unidad analizada; devuelve NULL al final del script
+static unidad_script* tomar_unidad(cola_script* cola)
+{
+    pthread_mutex_lock(&cola->mutex);
+    while (cola->cantidad == 0 && !cola->terminado)
+    {
+        pthread_cond_wait(&cola->hay_unidades, &cola->mutex);
+    }
+    unidad_script* u = cola->cantidad > 0 ? &cola->unidades[cola->inicio] : NULL;
+    pthread_mutex_unlock(&cola->mutex);
+    return u;
+}
+
+// Devolver al lector la unidad ya ejecutada
+static void liberar_unidad(cola_script* cola)
+{
+    pthread_mutex_lock(&cola->mutex);
+    cola->inicio = (cola->inicio + 1) % BATCH_COMANDOS_ADELANTADOS;
+    cola->cantidad--;
+    pthread_cond_signal(&cola->hay_lugar);
+    pthread_mutex_unlock(&cola->mutex);
+}
+
+// Reconocer las directivas begin_parallel y end_parallel en una lista recién analizada
+static void clasificar_unidad(unidad_script* u)
+{
+    u->tipo = UNIDAD_COMANDOS;
+    if (u->lista->num_pipelines != 1 || u->lista->pipelines[0].num_etapas != 1)
+    {
+        return;
+    }
+
+    const comando_simple* c = &u->lista->pipelines[0].etapas[0];
+    if (c->num_palabras == 0 || c->palabras[0].expandir)
+    {
+        return;
+    }
+
+    if (strcmp(c->palabras[0].texto, "begin_parallel") == 0 && c->num_palabras <= 2)
+    {
+        u->tipo = UNIDAD_INICIO_PARALELO;
+        u->grado = 0; // Se resuelve al ejecutar: la caché puede usarse en otra máquina con otra cantidad de CPUs
+        if (c->num_palabras == 2)
+        {
+            char* fin;
+            long grado = strtol(c->palabras[1].texto, &fin, 10);
+            if (*fin != '\0' || grado < 1 || grado > BATCH_MAX_PARALELO)
+            {
+                u->tipo = UNIDAD_ERROR;
+                snprintf(u->error, sizeof(u->error), "línea %d: begin_parallel: grado inválido '%s' (1 a %d)",
+                         u->linea, c->palabras[1].texto, BATCH_MAX_PARALELO);
+                return;
+            }
+            u->grado = (int)grado;
+        }
+    }
+    else if (strcmp(c->palabras[0].texto, "end_parallel") == 0 && c->num_palabras == 1)
+    {
+        u->tipo = UNIDAD_FIN_PARALELO;
+    }
+}
+
+// Vista de una unidad de la cola con el formato de las unidades de la caché
+static unidad_cacheada vista_unidad(const unidad_script* u)
+{
+    unidad_cacheada vista = {u->tipo, u->linea, u->grado, u->programa, u->error};
+    return vista;
+}
+
+// Hilo lector: separar el texto en comandos completos y analizarlos por adelantado
+static void* leer_script(void* dato)
+{
+    cola_script* cola = dato;
+    const char* p = cola->texto;
+    const char* fin = cola->texto + cola->largo;
+    int linea = 1;
+    unidad_script* u = NULL;
+    bool completo = true;
+
+    while (p < fin)
+    {
+        if (u == NULL && (u = reservar_unidad(cola)) == NULL)
+        {
+            completo = false; // El ejecutor ya no consume unidades
+            break;
+        }
+
+        // Un comando ocupa tantas líneas como haga falta para que el análisis no quede incompleto
+        const char* inicio = p;
+        int linea_inicio = linea;
+        resultado_parseo resultado;
+        do
+        {
+            const char* salto = memchr(p, '\n', (size_t)(fin - p));
+            p = salto != NULL ? salto + 1 : fin;
+            if (salto != NULL)
+            {
+                linea++;
+            }
+            arena_reiniciar(&u->memoria);
+            resultado = parsear_comandos(&u->memoria, inicio, (size_t)(p - inicio), linea_inicio, &u->lista,
+                                         u->error, sizeof(u->error));
+        } while (resultado == PARSEO_INCOMPLETO && p < fin);
+
+        u->linea = linea_inicio;
+        if (resultado != PARSEO_OK)
+        {
+            u->tipo = UNIDAD_ERROR;
+        }
+        else if (u->lista->num_pipelines == 0)
+        {
+            continue; // Línea vacía o comentario: reutilizar la misma unidad
+        }
+        else
+        {
+            clasificar_unidad(u);
+        }
+
+        // Compilar también por adelantado: el ejecutor sólo recorre el bytecode
+        if (u->tipo == UNIDAD_COMANDOS &&
+            compilar_lista(u->lista, &u->memoria, &u->programa, u->error, sizeof(u->error)) == -1)
+        {
+            u->tipo = UNIDAD_ERROR;
+        }
+        unidad_cacheada vista = vista_unidad(u);
+        cache_agregar(&cola->cache, &vista);
+        publicar_unidad(cola);
+        u = NULL;
+    }
+
+    int lineas = linea - (cola->largo > 0 && cola->texto[cola->largo - 1] == '\n' ? 1 : 0);
+    pthread_mutex_lock(&cola->mutex);
+    cola->terminado = true;
+    cola->lineas = lineas;
+    pthread_cond_signal(&cola->hay_unidades);
+    pthread_mutex_unlock(&cola->mutex);
+
+    // Guardar la caché fuera del camino del ejecutor; sólo si se analizó el texto completo
+    cache_terminar(&cola->cache, lineas, completo);
+    return NULL;
+}
+
+// Informar un comando que terminó con error
+static void informar_fallo(ejecucion_script* e, int linea, int estado)
+{
+    if (e->informar)
+    {
+        fprintf(stderr, "%s: línea %d: el comando terminó con estado %d\n", e->ruta, linea, estado);
+    }
+    e->fallos++;
+}
+
+// Obtener un pidfd para un proceso hijo
+static int abrir_pidfd(pid_t pid)
+{
+#ifdef SYS_pidfd_open
+    return (int)syscall(SYS_pidfd_open, pid, 0);
+#else
+    (void)pid;
+    errno = ENOSYS;
+    return -1;
+#endif
+}
+
+// Esperar a que termine cualquiera de los comandos del bloque en ejecución
+static void esperar_un_paralelo(ejecucion_script* e)
+{
+    int terminado = 0; // Sin pidfd se espera al más antiguo
+    int status = 0;
+    struct pollfd pidfds[BATCH_MAX_PARALELO];
+
+    for (int i = 0; i < e->num_activos; i++)
+    {
+        pidfds[i].fd = abrir_pidfd(e->activos[i].pid);
+        pidfds[i].events = POLLIN;
+    }
+
+    bool con_pidfd = true;
+    for (int i = 0; i < e->num_activos; i++)
+    {
+        con_pidfd = con_pidfd && pidfds[i].fd >= 0;
+    }
+    if (con_pidfd)
+    {
+        while (poll(pidfds, (nfds_t)e->num_activos, -1) == -1 && errno == EINTR)
+            ;
+        for (int i = 0; i < e->num_activos; i++)
+        {
+            if (pidfds[i].revents != 0)
+            {
+                terminado = i;
+                break;
+            }
+        }
+    }
+    for (int i = 0; i < e->num_activos; i++)
+    {
+        if (pidfds[i].fd >= 0)
+            close(pidfds[i].fd);
+    }
+
+    while (waitpid(e->activos[terminado].pid, &status, 0) == -1 && errno == EINTR)
+        ;
+    int estado = codigo_de_salida(status);
+    if (estado != 0)
+    {
+        informar_fallo(e, e->activos[terminado].linea, estado);
+    }
+
+    e->activos[terminado] = e->activos[--e->num_activos]; // El orden de los activos no importa
+}
+
+// Ejecutar un programa en el hijo de un bloque paralelo
+static int ejecutar_programa_en_hijo(void* dato)
+{
+    ejecutar_programa(dato);
+    return ultimo_estado;
+}
+
+// Lanzar un comando del bloque paralelo, esperando antes si ya hay tantos en ejecución como el grado del bloque
+static void lanzar_paralelo(ejecucion_script* e, const unidad_cacheada* u)
+{
+    while (e->num_activos >= e->grado)
+    {
+        esperar_un_paralelo(e);
+    }
+
+    // El hijo es una copia del shell que ejecuta la lista y termina; sus propios hijos restauran las señales
+    plan_spawn plan;
+    plan_inicializar(&plan, NULL);
+    plan.pgid = PLAN_SIN_GRUPO;
+    plan.restaurar_senales = false;
+
+    pid_t pid = lanzar_con_fork(&plan, ejecutar_programa_en_hijo, (void*)&u->programa);
+    if (pid < 0)
+    {
+        informar_fallo(e, u->linea, 127);
+        return;
+    }
+    e->activos[e->num_activos].pid = pid;
+    e->activos[e->num_activos].linea = u->linea;
+    e->num_activos++;
+}
+
+// Ejecutar una unidad ya analizada
+static void ejecutar_unidad(ejecucion_script* e, const unidad_cacheada* u)
+{
+    switch (u->tipo)
+    {
+    case UNIDAD_ERROR:
+        fprintf(stderr, "%s: %s\n", e->ruta, u->error);
+        e->fallos++;
+        ultimo_estado = 2;
+        break;
+
+    case UNIDAD_INICIO_PARALELO:
+        if (e->en_bloque)
+        {
+            fprintf(stderr, "%s: línea %d: begin_parallel dentro de otro bloque paralelo\n", e->ruta, u->linea);
+            e->fallos++;
+            break;
+        }
+        e->en_bloque = true;
+        e->grado = u->grado;
+        if (e->grado == 0)
+        {
+            long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+            e->grado = cpus > 0 ? (int)cpus : 1;
+        }
+        break;
+
+    case UNIDAD_FIN_PARALELO:
+        if (!e->en_bloque)
+        {
+            fprintf(stderr, "%s: línea %d: end_parallel sin begin_parallel\n", e->ruta, u->linea);
+            e->fallos++;
+            break;
+        }
+        while (e->num_activos > 0)
+        {
+            esperar_un_paralelo(e);
+        }
+        e->en_bloque = false;
+        break;
+
+    case UNIDAD_COMANDOS:
+        e->comandos++;
+        if (e->en_bloque)
+        {
+            lanzar_paralelo(e, u);
+        }
+        else
+        {
+            ejecutar_programa(&u->programa);
+            if (ultimo_estado != 0)
+            {
+                informar_fallo(e, u->linea, ultimo_estado);
+            }
+        }
+        break;
+    }
+}
+
+// Cargar el texto del script: mapeado en memoria si es un archivo regular, leído completo en otro caso
+static char* cargar_script(int fd, const struct stat* info, size_t* largo, bool* mapeado)
+{
+    *mapeado = false;
+    *largo = 0;
+
+    if (S_ISREG(info->st_mode) && info->st_size > 0)
+    {
+        void* texto = mmap(NULL, (size_t)info->st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (texto != MAP_FAILED)
+        {
+            madvise(texto, (size_t)info->st_size, MADV_SEQUENTIAL);
+            *mapeado = true;
+            *largo = (size_t)info->st_size;
+            return texto;
+        }
+    }
+
+    size_t capacidad = 0;
+    char* texto = NULL;
+    for (;;)
+    {
+        if (*largo == capacidad)
+        {
+            capacidad = capacidad == 0 ? 65536 : capacidad * 2;
+            char* nuevo = realloc(texto, capacidad);
+            if (nuevo == NULL)
+            {
+                free(texto);
+                return NULL;
+            }
+            texto = nuevo;
+        }
+        ssize_t leidos = read(fd, texto + *largo, capacidad - *largo);
+        if (leidos == -1 && errno == EINTR)
+            continue;
+        if (leidos <= 0)
+            break;
+        *largo += (size_t)leidos;
+    }
+    return texto;
+}
+
+// Liberar el texto cargado por cargar_script()
+static void liberar_script(char* texto, size_t largo, bool mapeado)
+{
+    if (mapeado)
+    {
+        munmap(texto, largo);
+    }
+    else
+    {
+        free(texto);
+    }
+}
+
+// Atender los eventos pendientes y ejecutar una unidad
+static void atender_y_ejecutar(ejecucion_script* e, const unidad_cacheada* u)
+{
+    if (e->num_activos == 0) // Con comandos del bloque en ejecución, recolectar podría quitarles sus hijos
+    {
+        eventos_esperar(0); // Atender sin esperar las señales y descriptores pendientes (por ejemplo, el monitor)
+        trabajos_actualizar();
+        trabajos_notificar();
+    }
+    ejecutar_unidad(e, u);
+}
+
+// Ejecutar las unidades de una caché válida; devuelve las líneas del script
+static int ejecutar_desde_cache(ejecucion_script* e, cache_script* cache)
+{
+    unidad_cacheada u;
+    while (EXIT && cache_siguiente(cache, &u))
+    {
+        atender_y_ejecutar(e, &u);
+    }
+    int lineas = cache->lineas;
+    cache_cerrar(cache);
+    return lineas;
+}
+
+// Analizar el texto del script por adelantado mientras se ejecuta, armando su caché; devuelve las líneas leídas o -1
+static int ejecutar_texto(ejecucion_script* e, int fd, const struct stat* info)
+{
+    size_t largo;
+    bool mapeado;
+    char* texto = cargar_script(fd, info, &largo, &mapeado);
+    close(fd);
+    if (texto == NULL && largo > 0)
+    {
+        fprintf(stderr, "Error: memoria insuficiente para leer %s\n", e->ruta);
+        return -1;
+    }
+
+    cola_script* cola = calloc(1, sizeof(cola_script));
+    if (cola == NULL)
+    {
+        fprintf(stderr, "Error: memoria insuficiente para ejecutar %s\n", e->ruta);
+        liberar_script(texto, largo, mapeado);
+        return -1;
+    }
+    cola->texto = texto;
+    cola->largo = largo;
+    cache_crear(&cola->cache, e->ruta, info);
+    pthread_mutex_init(&cola->mutex, NULL);
+    pthread_cond_init(&cola->hay_unidades, NULL);
+    pthread_cond_init(&cola->hay_lugar, NULL);
+    for (int i = 0; i < BATCH_COMANDOS_ADELANTADOS; i++)
+    {
+        arena_inicializar(&cola->unidades[i].memoria);
+    }
+
+    // El lector analiza por adelantado mientras este hilo ejecuta
+    pthread_t lector;
+    int error = pthread_create(&lector, NULL, leer_script, cola);
+    if (error != 0)
+    {
+        fprintf(stderr, "Error al crear el hilo lector: %s\n", strerror(error));
+        cola->terminado = true; // Sin lector no hay unidades: sólo se libera lo reservado
+        cache_terminar(&cola->cache, 0, false);
+    }
+
+    unidad_script* u;
+    while (EXIT && (u = tomar_unidad(cola)) != NULL)
+    {
+        unidad_cacheada vista = vista_unidad(u);
+        atender_y_ejecutar(e, &vista);
+        liberar_unidad(cola);
+    }
+
+    // Si el script terminó con quit, detener al lector
+    pthread_mutex_lock(&cola->mutex);
+    cola->cancelado = true;
+    pthread_cond_signal(&cola->hay_lugar);
+    pthread_mutex_unlock(&cola->mutex);
+    if (error == 0)
+    {
+        pthread_join(lector, NULL);
+    }
+
+    int lineas = cola->lineas;
+    for (int i = 0; i < BATCH_COMANDOS_ADELANTADOS; i++)
+    {
+        arena_liberar(&cola->unidades[i].memoria);
+    }
+    pthread_cond_destroy(&cola->hay_lugar);
+    pthread_cond_destroy(&cola->hay_unidades);
+    pthread_mutex_destroy(&cola->mutex);
+    free(cola);
+    liberar_script(texto, largo, mapeado);
+    return error != 0 ? -1 : lineas;
+}
+
+// Ejecutar un archivo de comandos, desde su caché si está vigente; devuelve la cantidad de fallos o -1
+static int ejecutar_archivo(const char* ruta, bool informar)
+{
+    int fd = open(ruta, O_RDONLY | O_CLOEXEC);
+    struct stat info;
+    if (fd == -1 || fstat(fd, &info) == -1)
+    {
+        fprintf(stderr, "Error al abrir el archivo de comandos %s: %s\n", ruta, strerror(errno));
+        if (fd != -1)
+            close(fd);
+        return -1;
+    }
+
+    comando_paralelo* activos = calloc(BATCH_MAX_PARALELO, sizeof(comando_paralelo));
+    if (activos == NULL)
+    {
+        fprintf(stderr, "Error: memoria insuficiente para ejecutar %s\n", ruta);
+        close(fd);
+        return -1;
+    }
+
+    ejecucion_script e = {.ruta = ruta, .informar = informar, .activos = activos};
+    struct timespec inicio;
+    struct timespec fin;
+    clock_gettime(CLOCK_MONOTONIC, &inicio);
+
+    // El stat se tomó antes de leer el texto: si el script cambia mientras tanto, la caché queda vieja, no errónea
+    cache_script cache;
+    int lineas;
+    if (cache_abrir(ruta, &info, &cache) == 0)
+    {
+        close(fd);
+        lineas = ejecutar_desde_cache(&e, &cache);
+    }
+    else
+    {
+        lineas = ejecutar_texto(&e, fd, &info);
+    }
+
+    if (e.en_bloque) // Un bloque sin end_parallel termina con el script
+    {
+        fprintf(stderr, "%s: falta end_parallel al final del archivo\n", ruta);
+        e.fallos++;
+    }
+    while (e.num_activos > 0)
+    {
+        esperar_un_paralelo(&e);
+    }
+    free(activos);
+    if (lineas == -1)
+    {
+        return -1;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &fin);
+    double segundos = (double)(fin.tv_sec - inicio.tv_sec) + (double)(fin.tv_nsec - inicio.tv_nsec) / 1e9;
+    if (informar)
+    {
+        fprintf(stderr, "%s: %d líneas, %d comandos en %.3f s (%.0f líneas/s), %d con errores\n", ruta, lineas,
+                e.comandos, segundos, segundos > 0 ? lineas / segundos : 0.0, e.fallos);
+    }
+    return e.fallos;
+}
+
+// Ejecutar un archivo de comandos
+int ejecutar_script(const char* ruta)
+{
+    return ejecutar_archivo(ruta, true);
+}
+
+// Comando "source"
+int manejar_comando_source(int argc, char** argv)
+{
+    static int anidados = 0;
+    if (argc < 2)
+    {
+        fprintf(stderr, "Uso: source archivo [argumentos...]\n");
+        return 2;
+    }
+    if (anidados >= BATCH_MAX_ANIDADOS)
+    {
+        fprintf(stderr, "source: %s: demasiados archivos anidados (máximo %d)\n", argv[1], BATCH_MAX_ANIDADOS);
+        return 1;
+    }
+
+    // Con argumentos, el archivo los ve como parámetros posicionales; sin ellos, ve los del shell
+    parametros_shell anteriores;
+    if (argc > 2)
+    {
+        parametros_cambiar(argc - 2, argv + 2, &anteriores);
+    }
+    ultimo_estado = 0; // Un archivo sin comandos termina con estado 0
+    anidados++;
+    int fallos = ejecutar_archivo(argv[1], false);
+    anidados--;
+    if (argc > 2)
+    {
+        parametros_restaurar(&anteriores);
+    }
+    return fallos == -1 ? 1 : ultimo_estado;
+}
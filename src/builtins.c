@@ -0,0 +1,248 @@
+/**
+ * @file builtins.c
+ * @brief Implementación del registro de comandos internos y de sus manejadores.
+ */
+
+#include "builtins.h"
+#include "batch.h"
+#include "commands.h"
+#include "config_explorer.h"
+#include "core_utils.h"
+#include "config_grep.h"
+#include "fd_check.h"
+#include "globals.h"
+#include "jobs.h"
+#include "metrics_store.h"
+#include "monitor.h"
+#include "monitor_top.h"
+#include "parallel.h"
+#include "path_cache.h"
+#include "prompt.h"
+#include "shell_utils.h"
+#include "shell_vars.h"
+#include <stdlib.h>
+#include <string.h>
+
+// Tabla ordenada generada por cmake/GenerarBuiltins.cmake a partir de src/builtins.manifest
+#include "builtins_tabla.h"
+
+// Comparar un nombre con un descriptor para bsearch
+static int comparar_builtin(const void* clave, const void* elemento)
+{
+    return strcmp((const char*)clave, ((const descriptor_builtin*)elemento)->nombre);
+}
+
+// Buscar un comando interno en la tabla ordenada
+const descriptor_builtin* buscar_builtin(const char* nombre)
+{
+    if (nombre == NULL)
+    {
+        return NULL;
+    }
+    return bsearch(nombre, tabla_builtins, NUM_BUILTINS, sizeof(descriptor_builtin), comparar_builtin);
+}
+
+// Elegir el comando interno de un comando; los que reemplazan programas dependen de la opción internos
+const descriptor_builtin* elegir_builtin(char** args)
+{
+    const descriptor_builtin* builtin = buscar_builtin(args[0]);
+    if (builtin != NULL && builtin->reemplaza_externo && !(opcion_internos && utilidad_aplicable(args)))
+    {
+        return NULL;
+    }
+    return builtin;
+}
+
+// Comando "bg"
+int builtin_bg(int argc, char** argv)
+{
+    return manejar_comando_bg(argc, argv);
+}
+
+// Comando "buscar_config"
+int builtin_buscar_config(int argc, char** argv)
+{
+    return manejar_comando_buscar_config(argc, argv);
+}
+
+// Comando "cat"
+int builtin_cat(int argc, char** argv)
+{
+    return manejar_comando_cat(argc, argv);
+}
+
+// Comando "cd"
+int builtin_cd(int argc, char** argv)
+{
+    Ctrl_CD(argc > 1 ? argv[1] : NULL); // Llamar a la función para cambiar el directorio
+    return 0;
+}
+
+// Comando "clr"
+int builtin_clr(int argc __attribute__((unused)), char** argv __attribute__((unused)))
+{
+    limpiar_pantalla(); // Llamar a la función para limpiar la pantalla
+    return 0;
+}
+
+// Comando "echo"
+int builtin_echo(int argc __attribute__((unused)), char** argv)
+{
+    ejecutar_echo(argv + 1); // Imprimir los argumentos que siguen a "echo"
+    return 0;
+}
+
+// Comando "explorar_config"
+int builtin_explorar_config(int argc, char** argv)
+{
+    return manejar_comando_explorar_config(argc, argv);
+}
+
+// Comando "export"
+int builtin_export(int argc, char** argv)
+{
+    return manejar_comando_export(argc, argv);
+}
+
+// Comando "false"
+int builtin_false(int argc __attribute__((unused)), char** argv __attribute__((unused)))
+{
+    return 1;
+}
+
+// Comando "fdcheck"
+int builtin_fdcheck(int argc, char** argv)
+{
+    return manejar_comando_fdcheck(argc, argv);
+}
+
+// Comando "fg"
+int builtin_fg(int argc, char** argv)
+{
+    return manejar_comando_fg(argc, argv);
+}
+
+// Comando "hash"
+int builtin_hash(int argc, char** argv)
+{
+    return manejar_comando_hash(argc, argv);
+}
+
+// Comando "head"
+int builtin_head(int argc, char** argv)
+{
+    return manejar_comando_head(argc, argv);
+}
+
+// Comando "jobs"
+int builtin_jobs(int argc, char** argv)
+{
+    return manejar_comando_jobs(argc, argv);
+}
+
+// Comando "metrics_query"
+int builtin_metrics_query(int argc, char** argv)
+{
+    return manejar_comando_metrics_query(argc, argv);
+}
+
+// Comando "monitor_top"
+int builtin_monitor_top(int argc, char** argv)
+{
+    return manejar_comando_monitor_top(argc, argv);
+}
+
+// Comando "parallel"
+int builtin_parallel(int argc, char** argv)
+{
+    return manejar_comando_parallel(argc, argv);
+}
+
+// Comando "pipestatus"
+int builtin_pipestatus(int argc, char** argv)
+{
+    return manejar_comando_pipestatus(argc, argv);
+}
+
+// Comando "prompt"
+int builtin_prompt(int argc, char** argv)
+{
+    return manejar_comando_prompt(argc, argv);
+}
+
+// Comando "quit"
+int builtin_quit(int argc __attribute__((unused)), char** argv __attribute__((unused)))
+{
+    EXIT = 0;           // Cambiar el valor de la variable para salir del shell
+    liberar_recursos(); // Llamar a la función para liberar los recursos
+    return 0;
+}
+
+// Comando "set"
+int builtin_set(int argc, char** argv)
+{
+    return manejar_comando_set(argc, argv);
+}
+
+// Comando "source"
+int builtin_source(int argc, char** argv)
+{
+    return manejar_comando_source(argc, argv);
+}
+
+// Comando "start_monitor"
+int builtin_start_monitor(int argc __attribute__((unused)), char** argv __attribute__((unused)))
+{
+    start_monitor(); // Llamar a la función para iniciar el monitor
+    return 0;
+}
+
+// Comando "status_monitor"
+int builtin_status_monitor(int argc __attribute__((unused)), char** argv __attribute__((unused)))
+{
+    status_monitor(); // Llamar a la función para mostrar el estado del monitor
+    return 0;
+}
+
+// Comando "stop_monitor"
+int builtin_stop_monitor(int argc __attribute__((unused)), char** argv __attribute__((unused)))
+{
+    stop_monitor(); // Llamar a la función para detener el monitor
+    return 0;
+}
+
+// Comando "tail"
+int builtin_tail(int argc, char** argv)
+{
+    return manejar_comando_tail(argc, argv);
+}
+
+// Comando "test"
+int builtin_test(int argc, char** argv)
+{
+    return manejar_comando_test(argc, argv);
+}
+
+// Comando "true"
+int builtin_true(int argc __attribute__((unused)), char** argv __attribute__((unused)))
+{
+    return 0;
+}
+
+// Comando "unset"
+int builtin_unset(int argc, char** argv)
+{
+    return manejar_comando_unset(argc, argv);
+}
+
+// Comando "update_config"
+int builtin_update_config(int argc, char** argv)
+{
+    return handle_update_command(argc, argv); // Llamar a la función para actualizar la configuración
+}
+
+// Comando "wc"
+int builtin_wc(int argc, char** argv)
+{
+    return manejar_comando_wc(argc, argv);
+}
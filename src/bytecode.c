@@ -0,0 +1,923 @@
+/**
+ * @file bytecode.c
+ * @brief Implementación del compilador de listas de comandos a bytecode, de la validación y del listado.
+ */
+
+#include "bytecode.h"
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ *  @brief Destino de un salto todavía sin resolver; también termina las cadenas de saltos pendientes
+ */
+#define SIN_DESTINO UINT32_MAX
+
+/**
+ * @brief Ciclo abierto durante la compilación.
+ */
+typedef struct
+{
+    uint32_t continuar; /**< Instrucción donde empieza la próxima vuelta */
+    uint32_t salidas;   /**< Cadena de saltos a la salida del ciclo, pendientes de resolver */
+} ciclo_abierto;
+
+/**
+ * @brief Ciclos y función visibles desde el cuerpo que se está compilando.
+ */
+typedef struct
+{
+    ciclo_abierto ciclos[BYTECODE_MAX_CICLOS]; /**< Ciclos abiertos, del más externo al más interno */
+    int cantidad;                              /**< Cantidad de ciclos abiertos */
+    bool en_funcion;                           /**< El cuerpo es el de una función: se permite return */
+} ambito_compilacion;
+
+/**
+ * @brief Estado del compilador: tablas del programa en construcción.
+ */
+typedef struct
+{
+    instruccion* instrucciones;           /**< Instrucciones emitidas */
+    uint32_t num_instrucciones;           /**< Cantidad de instrucciones */
+    uint32_t cap_instrucciones;           /**< Capacidad de la tabla de instrucciones */
+    pipeline_compilado* pipelines;        /**< Pipes */
+    uint32_t num_pipelines;               /**< Cantidad de pipes */
+    uint32_t cap_pipelines;               /**< Capacidad de la tabla de pipes */
+    etapa_compilada* etapas;              /**< Etapas */
+    uint32_t num_etapas;                  /**< Cantidad de etapas */
+    uint32_t cap_etapas;                  /**< Capacidad de la tabla de etapas */
+    palabra_compilada* palabras;          /**< Palabras */
+    uint32_t num_palabras;                /**< Cantidad de palabras */
+    uint32_t cap_palabras;                /**< Capacidad de la tabla de palabras */
+    redireccion_compilada* redirecciones; /**< Redirecciones */
+    uint32_t num_redirecciones;           /**< Cantidad de redirecciones */
+    uint32_t cap_redirecciones;           /**< Capacidad de la tabla de redirecciones */
+    char* cadenas;                        /**< Tabla de cadenas */
+    size_t largo_cadenas;                 /**< Bytes usados de la tabla de cadenas */
+    size_t cap_cadenas;                   /**< Capacidad de la tabla de cadenas */
+    ambito_compilacion ambito;            /**< Ciclos y función del cuerpo actual */
+    char* error;                          /**< Buffer del mensaje de error */
+    size_t tam_error;                     /**< Tamaño del buffer de error */
+    bool fallo;                           /**< Hubo un error; el resto de la compilación no hace nada */
+} compilador;
+
+/**
+ * @brief Desplazamiento de cada tabla dentro del bloque de un programa.
+ */
+typedef struct
+{
+    uint64_t instrucciones; /**< Tabla de instrucciones */
+    uint64_t pipelines;     /**< Tabla de pipes */
+    uint64_t etapas;        /**< Tabla de etapas */
+    uint64_t palabras;      /**< Tabla de palabras */
+    uint64_t redirecciones; /**< Tabla de redirecciones */
+    uint64_t cadenas;       /**< Tabla de cadenas */
+    uint64_t total;         /**< Tamaño del bloque completo */
+} disposicion_programa;
+
+/**
+ *  @brief Nombre de cada código de operación en el listado
+ */
+static const char* const nombres_operaciones[OP_CANTIDAD] = {
+    "EJECUTAR",     "ASIGNAR",     "SALTAR",        "SALTAR_SI_FALLA", "SALTAR_SI_EXITO", "NEGAR",
+    "ESTADO",       "CICLO_INICIO", "CICLO_GUARDAR", "CICLO_FIN",       "PARA_INICIO",     "PARA_SIGUIENTE",
+    "CASO_SUJETO",  "CASO_PROBAR",  "FUNCION",       "RETORNAR",        "FIN"};
+
+/**
+ *  @brief Operador de cada tipo de redirección en el listado
+ */
+static const char* const operadores_redireccion[] = {"<", ">", ">>", "<>", ">&", "&>", "&>>"};
+
+// Registrar un error de compilación; devuelve false para encadenar con return
+static bool fallar(compilador* c, const char* formato, ...)
+{
+    if (!c->fallo && c->error != NULL && c->tam_error > 0)
+    {
+        va_list args;
+        va_start(args, formato);
+        vsnprintf(c->error, c->tam_error, formato, args);
+        va_end(args);
+    }
+    c->fallo = true;
+    return false;
+}
+
+// Asegurar lugar para un elemento más en una tabla; devuelve la tabla (quizás movida) o NULL si no hay memoria
+static void* crecer(compilador* c, void* tabla, uint32_t cantidad, uint32_t* capacidad, size_t tam)
+{
+    if (c->fallo)
+    {
+        return NULL;
+    }
+    if (cantidad < *capacidad)
+    {
+        return tabla;
+    }
+    if (*capacidad > UINT32_MAX / 2)
+    {
+        fallar(c, "el programa es demasiado grande");
+        return NULL;
+    }
+    uint32_t nueva = *capacidad == 0 ? 16 : *capacidad * 2;
+    void* nueva_tabla = realloc(tabla, (size_t)nueva * tam);
+    if (nueva_tabla == NULL)
+    {
+        fallar(c, "memoria insuficiente");
+        return NULL;
+    }
+    *capacidad = nueva;
+    return nueva_tabla;
+}
+
+// Agregar una instrucción; devuelve su posición, o SIN_DESTINO si no hubo memoria
+static uint32_t emitir(compilador* c, codigo_operacion op, uint32_t n, uint32_t a, uint32_t b)
+{
+    instruccion* tabla = crecer(c, c->instrucciones, c->num_instrucciones, &c->cap_instrucciones, sizeof(instruccion));
+    if (tabla == NULL)
+    {
+        return SIN_DESTINO;
+    }
+    c->instrucciones = tabla;
+    tabla[c->num_instrucciones] = (instruccion){.op = (uint16_t)op, .n = (uint16_t)n, .a = a, .b = b};
+    return c->num_instrucciones++;
+}
+
+// Agregar una cadena a la tabla de cadenas; devuelve su desplazamiento
+static uint32_t agregar_cadena(compilador* c, const char* texto)
+{
+    size_t largo = strlen(texto) + 1;
+    if (c->fallo)
+    {
+        return 0;
+    }
+    if (c->cap_cadenas - c->largo_cadenas < largo)
+    {
+        size_t nueva = c->cap_cadenas == 0 ? 256 : c->cap_cadenas * 2;
+        while (nueva - c->largo_cadenas < largo)
+            nueva *= 2;
+        if (nueva > UINT32_MAX)
+        {
+            fallar(c, "el programa es demasiado grande");
+            return 0;
+        }
+        char* cadenas = realloc(c->cadenas, nueva);
+        if (cadenas == NULL)
+        {
+            fallar(c, "memoria insuficiente");
+            return 0;
+        }
+        c->cadenas = cadenas;
+        c->cap_cadenas = nueva;
+    }
+    memcpy(c->cadenas + c->largo_cadenas, texto, largo);
+    c->largo_cadenas += largo;
+    return (uint32_t)(c->largo_cadenas - largo);
+}
+
+// Compilar una palabra
+static palabra_compilada compilar_palabra(compilador* c, const palabra* p)
+{
+    palabra_compilada compilada = {.texto = agregar_cadena(c, p->texto), .expandir = p->expandir ? 1u : 0u};
+    return compilada;
+}
+
+// Agregar una palabra a la tabla de palabras; devuelve su índice
+static uint32_t agregar_palabra(compilador* c, const palabra* p)
+{
+    palabra_compilada* tabla = crecer(c, c->palabras, c->num_palabras, &c->cap_palabras, sizeof(palabra_compilada));
+    if (tabla == NULL)
+    {
+        return 0;
+    }
+    c->palabras = tabla;
+    tabla[c->num_palabras] = compilar_palabra(c, p);
+    return c->num_palabras++;
+}
+
+// Agregar varias palabras seguidas; devuelve el índice de la primera
+static uint32_t agregar_palabras(compilador* c, const palabra* palabras, int n)
+{
+    uint32_t primera = c->num_palabras;
+    for (int i = 0; i < n; i++)
+    {
+        agregar_palabra(c, &palabras[i]);
+    }
+    return primera;
+}
+
+// Devolver el operando que guarda el destino de una instrucción de salto
+static uint32_t* operando_de_salto(instruccion* i)
+{
+    switch (i->op)
+    {
+    case OP_PARA_SIGUIENTE:
+    case OP_CASO_PROBAR:
+    case OP_FUNCION:
+        return &i->b;
+    default:
+        return &i->a;
+    }
+}
+
+// Agregar un salto sin resolver a una cadena de saltos pendientes, que se enlazan a través de su propio destino
+static void encadenar(compilador* c, uint32_t pc, uint32_t* cadena)
+{
+    if (pc == SIN_DESTINO)
+    {
+        return;
+    }
+    *operando_de_salto(&c->instrucciones[pc]) = *cadena;
+    *cadena = pc;
+}
+
+// Resolver todos los saltos de una cadena con el destino indicado
+static void resolver(compilador* c, uint32_t cadena, uint32_t destino)
+{
+    while (cadena != SIN_DESTINO && !c->fallo)
+    {
+        uint32_t* operando = operando_de_salto(&c->instrucciones[cadena]);
+        cadena = *operando;
+        *operando = destino;
+    }
+}
+
+static bool compilar_cuerpo(compilador* c, const lista_comandos* lista);
+
+// Compilar un pipe como una instrucción OP_EJECUTAR con sus tablas
+static bool compilar_ejecucion(compilador* c, const pipeline* p)
+{
+    pipeline_compilado* pipelines =
+        crecer(c, c->pipelines, c->num_pipelines, &c->cap_pipelines, sizeof(pipeline_compilado));
+    if (pipelines == NULL)
+    {
+        return false;
+    }
+    c->pipelines = pipelines;
+    pipelines[c->num_pipelines] = (pipeline_compilado){.primera_etapa = c->num_etapas,
+                                                       .num_etapas = (uint32_t)p->num_etapas,
+                                                       .en_segundo_plano = p->en_segundo_plano ? 1u : 0u,
+                                                       .linea = p->linea};
+
+    for (int i = 0; i < p->num_etapas; i++)
+    {
+        const comando_simple* comando = &p->etapas[i];
+        etapa_compilada* etapas = crecer(c, c->etapas, c->num_etapas, &c->cap_etapas, sizeof(etapa_compilada));
+        if (etapas == NULL)
+        {
+            return false;
+        }
+        c->etapas = etapas;
+        etapa_compilada* etapa = &etapas[c->num_etapas++];
+        etapa->primera_palabra = agregar_palabras(c, comando->palabras, comando->num_palabras);
+        etapa->num_palabras = (uint32_t)comando->num_palabras;
+        etapa->primera_redireccion = c->num_redirecciones;
+        etapa->num_redirecciones = 0;
+
+        for (const redireccion* r = comando->redirecciones; r != NULL; r = r->siguiente)
+        {
+            redireccion_compilada* tabla = crecer(c, c->redirecciones, c->num_redirecciones, &c->cap_redirecciones,
+                                                  sizeof(redireccion_compilada));
+            if (tabla == NULL)
+            {
+                return false;
+            }
+            c->redirecciones = tabla;
+            palabra_compilada destino = compilar_palabra(c, &r->destino);
+            tabla[c->num_redirecciones++] =
+                (redireccion_compilada){.tipo = (uint32_t)r->tipo, .fd = r->fd, .destino = destino};
+            etapa->num_redirecciones++;
+        }
+    }
+    emitir(c, OP_EJECUTAR, 0, c->num_pipelines++, 0);
+    return !c->fallo;
+}
+
+// Verificar si una palabra es una asignación nombre=valor
+static bool es_asignacion(const palabra* p)
+{
+    const char* igual = strchr(p->texto, '=');
+    return igual != NULL && es_nombre_valido(p->texto, (size_t)(igual - p->texto));
+}
+
+// Verificar si un pipe es un comando formado sólo por asignaciones, que se ejecutan sin buscar ningún programa
+static bool es_solo_asignaciones(const pipeline* p)
+{
+    const comando_simple* comando = &p->etapas[0];
+    if (p->num_etapas != 1 || p->en_segundo_plano || comando->compuesto != NULL || comando->redirecciones != NULL ||
+        comando->num_palabras == 0 || comando->num_palabras > UINT16_MAX)
+    {
+        return false;
+    }
+    for (int i = 0; i < comando->num_palabras; i++)
+    {
+        if (!es_asignacion(&comando->palabras[i]))
+            return false;
+    }
+    return true;
+}
+
+// Reconocer break, continue y return, que se resuelven al compilar; devuelve el nombre o NULL
+static const char* comando_de_control(const pipeline* p)
+{
+    static const char* const nombres[] = {"break", "continue", "return"};
+    const comando_simple* comando = &p->etapas[0];
+    if (p->num_etapas != 1 || p->en_segundo_plano || comando->compuesto != NULL || comando->redirecciones != NULL ||
+        comando->num_palabras == 0 || comando->palabras[0].expandir)
+    {
+        return NULL;
+    }
+    for (size_t i = 0; i < sizeof(nombres) / sizeof(nombres[0]); i++)
+    {
+        if (strcmp(comando->palabras[0].texto, nombres[i]) == 0)
+            return nombres[i];
+    }
+    return NULL;
+}
+
+// Compilar break [n] o continue [n]: guardar el estado 0 en el ciclo destino y saltar a su salida o a su próxima vuelta
+static bool compilar_salto_de_ciclo(compilador* c, const pipeline* p, const char* nombre)
+{
+    const comando_simple* comando = &p->etapas[0];
+    long niveles = 1;
+    if (comando->num_palabras > 2)
+    {
+        return fallar(c, "línea %d: %s: demasiados argumentos", p->linea, nombre);
+    }
+    if (comando->num_palabras == 2)
+    {
+        char* fin;
+        niveles = strtol(comando->palabras[1].texto, &fin, 10);
+        if (comando->palabras[1].expandir || *fin != '\0' || fin == comando->palabras[1].texto || niveles < 1)
+            return fallar(c, "línea %d: %s: '%s': se esperaba un número positivo", p->linea, nombre,
+                          comando->palabras[1].texto);
+    }
+    if (c->ambito.cantidad == 0)
+    {
+        return fallar(c, "línea %d: %s: sólo tiene sentido dentro de un ciclo", p->linea, nombre);
+    }
+
+    // Como en sh, un n mayor que la cantidad de ciclos abiertos se refiere al más externo
+    int destino = niveles >= c->ambito.cantidad ? 0 : c->ambito.cantidad - (int)niveles;
+    ciclo_abierto* ciclo = &c->ambito.ciclos[destino];
+    emitir(c, OP_ESTADO, 0, 0, 0);
+    emitir(c, OP_CICLO_GUARDAR, (uint32_t)destino, 0, 0);
+    if (strcmp(nombre, "break") == 0)
+    {
+        encadenar(c, emitir(c, OP_SALTAR, 0, SIN_DESTINO, 0), &ciclo->salidas);
+    }
+    else
+    {
+        emitir(c, OP_SALTAR, 0, ciclo->continuar, 0);
+    }
+    return !c->fallo;
+}
+
+// Compilar return [valor]
+static bool compilar_retorno(compilador* c, const pipeline* p)
+{
+    const comando_simple* comando = &p->etapas[0];
+    if (!c->ambito.en_funcion)
+    {
+        return fallar(c, "línea %d: return: sólo tiene sentido dentro de una función", p->linea);
+    }
+    if (comando->num_palabras > 2)
+    {
+        return fallar(c, "línea %d: return: demasiados argumentos", p->linea);
+    }
+    if (comando->num_palabras == 2)
+    {
+        emitir(c, OP_RETORNAR, 1, agregar_palabra(c, &comando->palabras[1]), 0);
+    }
+    else
+    {
+        emitir(c, OP_RETORNAR, 0, 0, 0);
+    }
+    return !c->fallo;
+}
+
+// Abrir un ciclo; devuelve su número dentro del cuerpo actual, o -1 si hay demasiados anidados
+static int abrir_ciclo(compilador* c, int linea)
+{
+    if (c->ambito.cantidad == BYTECODE_MAX_CICLOS)
+    {
+        fallar(c, "línea %d: demasiados ciclos anidados (máximo %d)", linea, BYTECODE_MAX_CICLOS);
+        return -1;
+    }
+    ciclo_abierto* ciclo = &c->ambito.ciclos[c->ambito.cantidad];
+    ciclo->continuar = SIN_DESTINO;
+    ciclo->salidas = SIN_DESTINO;
+    return c->ambito.cantidad++;
+}
+
+// Cerrar el último ciclo abierto: sus salidas llevan a la instrucción que recupera su estado
+static bool cerrar_ciclo(compilador* c, int numero)
+{
+    resolver(c, c->ambito.ciclos[numero].salidas, c->num_instrucciones);
+    emitir(c, OP_CICLO_FIN, (uint32_t)numero, 0, 0);
+    c->ambito.cantidad--;
+    return !c->fallo;
+}
+
+// if: condición; si falla, a la alternativa; si no, el cuerpo y al final
+static bool compilar_si(compilador* c, const comando_compuesto* cc)
+{
+    uint32_t alternativa = SIN_DESTINO;
+    uint32_t fin = SIN_DESTINO;
+    if (!compilar_cuerpo(c, cc->condicion))
+    {
+        return false;
+    }
+    encadenar(c, emitir(c, OP_SALTAR_SI_FALLA, 0, SIN_DESTINO, 0), &alternativa);
+    if (!compilar_cuerpo(c, cc->cuerpo))
+    {
+        return false;
+    }
+    encadenar(c, emitir(c, OP_SALTAR, 0, SIN_DESTINO, 0), &fin);
+    resolver(c, alternativa, c->num_instrucciones);
+    if (cc->alternativa != NULL)
+    {
+        compilar_cuerpo(c, cc->alternativa);
+    }
+    else
+    {
+        emitir(c, OP_ESTADO, 0, 0, 0); // Un if sin else cuya condición falla termina con estado 0
+    }
+    resolver(c, fin, c->num_instrucciones);
+    return !c->fallo;
+}
+
+// while y until: la condición se evalúa antes de cada vuelta; el estado del ciclo es el de la última vuelta
+static bool compilar_mientras(compilador* c, const comando_compuesto* cc, int linea)
+{
+    int numero = abrir_ciclo(c, linea);
+    if (numero < 0)
+    {
+        return false;
+    }
+    ciclo_abierto* ciclo = &c->ambito.ciclos[numero];
+    emitir(c, OP_CICLO_INICIO, (uint32_t)numero, 0, 0);
+    ciclo->continuar = c->num_instrucciones;
+    if (!compilar_cuerpo(c, cc->condicion))
+    {
+        return false;
+    }
+    codigo_operacion salida = cc->tipo == COMPUESTO_MIENTRAS ? OP_SALTAR_SI_FALLA : OP_SALTAR_SI_EXITO;
+    encadenar(c, emitir(c, salida, 0, SIN_DESTINO, 0), &ciclo->salidas);
+    if (!compilar_cuerpo(c, cc->cuerpo))
+    {
+        return false;
+    }
+    emitir(c, OP_CICLO_GUARDAR, (uint32_t)numero, 0, 0);
+    emitir(c, OP_SALTAR, 0, ciclo->continuar, 0);
+    return cerrar_ciclo(c, numero);
+}
+
+// for: los campos se expanden una vez al entrar; cada vuelta asigna el siguiente a la variable
+static bool compilar_para(compilador* c, const comando_compuesto* cc, int linea)
+{
+    uint32_t primera = agregar_palabras(c, cc->palabras, cc->num_palabras);
+    int numero = abrir_ciclo(c, linea);
+    if (numero < 0)
+    {
+        return false;
+    }
+    ciclo_abierto* ciclo = &c->ambito.ciclos[numero];
+    emitir(c, OP_PARA_INICIO, (uint32_t)numero, primera, (uint32_t)cc->num_palabras);
+    ciclo->continuar = c->num_instrucciones;
+    uint32_t variable = agregar_cadena(c, cc->nombre);
+    encadenar(c, emitir(c, OP_PARA_SIGUIENTE, (uint32_t)numero, variable, SIN_DESTINO), &ciclo->salidas);
+    if (!compilar_cuerpo(c, cc->cuerpo))
+    {
+        return false;
+    }
+    emitir(c, OP_CICLO_GUARDAR, (uint32_t)numero, 0, 0);
+    emitir(c, OP_SALTAR, 0, ciclo->continuar, 0);
+    return cerrar_ciclo(c, numero);
+}
+
+// case: se prueban los patrones de cada rama en orden; la primera que coincide ejecuta su cuerpo y sale
+static bool compilar_caso(compilador* c, const comando_compuesto* cc)
+{
+    uint32_t fin = SIN_DESTINO;
+    emitir(c, OP_CASO_SUJETO, 0, agregar_palabra(c, &cc->palabras[0]), 0);
+
+    for (const rama_caso* r = cc->ramas; r != NULL; r = r->siguiente)
+    {
+        uint32_t cuerpo = SIN_DESTINO;
+        uint32_t siguiente = SIN_DESTINO;
+        for (int i = 0; i < r->num_patrones; i++)
+        {
+            uint32_t patron = agregar_palabra(c, &r->patrones[i]);
+            encadenar(c, emitir(c, OP_CASO_PROBAR, 0, patron, SIN_DESTINO), &cuerpo);
+        }
+        encadenar(c, emitir(c, OP_SALTAR, 0, SIN_DESTINO, 0), &siguiente);
+
+        resolver(c, cuerpo, c->num_instrucciones);
+        if (r->cuerpo->num_pipelines == 0)
+        {
+            emitir(c, OP_ESTADO, 0, 0, 0); // Rama vacía
+        }
+        else if (!compilar_cuerpo(c, r->cuerpo))
+        {
+            return false;
+        }
+        encadenar(c, emitir(c, OP_SALTAR, 0, SIN_DESTINO, 0), &fin);
+        resolver(c, siguiente, c->num_instrucciones);
+    }
+    emitir(c, OP_ESTADO, 0, 0, 0); // Ninguna rama coincidió
+    resolver(c, fin, c->num_instrucciones);
+    return !c->fallo;
+}
+
+// Definición de función: el cuerpo va en línea, después de la definición, y se saltea al ejecutarla
+static bool compilar_funcion(compilador* c, const comando_compuesto* cc)
+{
+    uint32_t fin = SIN_DESTINO;
+    uint32_t nombre = agregar_cadena(c, cc->nombre);
+    encadenar(c, emitir(c, OP_FUNCION, 0, nombre, SIN_DESTINO), &fin);
+
+    // La función se ejecuta con sus propios ciclos: no ve los del cuerpo donde se define
+    ambito_compilacion anterior = c->ambito;
+    c->ambito.cantidad = 0;
+    c->ambito.en_funcion = true;
+    bool ok = compilar_cuerpo(c, cc->cuerpo);
+    c->ambito = anterior;
+    if (!ok)
+    {
+        return false;
+    }
+    emitir(c, OP_RETORNAR, 0, 0, 0);
+    resolver(c, fin, c->num_instrucciones);
+    return !c->fallo;
+}
+
+// Compilar un comando compuesto
+static bool compilar_compuesto(compilador* c, const comando_compuesto* cc, int linea)
+{
+    switch (cc->tipo)
+    {
+    case COMPUESTO_SI:
+        return compilar_si(c, cc);
+    case COMPUESTO_MIENTRAS:
+    case COMPUESTO_HASTA:
+        return compilar_mientras(c, cc, linea);
+    case COMPUESTO_PARA:
+        return compilar_para(c, cc, linea);
+    case COMPUESTO_CASO:
+        return compilar_caso(c, cc);
+    case COMPUESTO_GRUPO:
+        return compilar_cuerpo(c, cc->cuerpo);
+    case COMPUESTO_FUNCION:
+        return compilar_funcion(c, cc);
+    }
+    return fallar(c, "línea %d: comando compuesto desconocido", linea);
+}
+
+// Compilar un pipe con su conector: '&&' y '||' saltan por encima de él según el estado del anterior
+static bool compilar_pipeline(compilador* c, const pipeline* p)
+{
+    uint32_t salto = SIN_DESTINO;
+    if (p->conector != CONECTOR_SECUENCIA)
+    {
+        codigo_operacion op = p->conector == CONECTOR_Y ? OP_SALTAR_SI_FALLA : OP_SALTAR_SI_EXITO;
+        encadenar(c, emitir(c, op, 0, SIN_DESTINO, 0), &salto);
+    }
+
+    const char* control = comando_de_control(p);
+    bool ok;
+    if (p->etapas[0].compuesto != NULL)
+    {
+        ok = compilar_compuesto(c, p->etapas[0].compuesto, p->linea);
+    }
+    else if (control != NULL)
+    {
+        ok = strcmp(control, "return") == 0 ? compilar_retorno(c, p) : compilar_salto_de_ciclo(c, p, control);
+    }
+    else if (es_solo_asignaciones(p))
+    {
+        uint32_t primera = agregar_palabras(c, p->etapas[0].palabras, p->etapas[0].num_palabras);
+        ok = emitir(c, OP_ASIGNAR, (uint32_t)p->etapas[0].num_palabras, primera, 0) != SIN_DESTINO;
+    }
+    else
+    {
+        ok = compilar_ejecucion(c, p);
+    }
+    if (!ok)
+    {
+        return false;
+    }
+
+    if (p->negado)
+    {
+        emitir(c, OP_NEGAR, 0, 0, 0);
+    }
+    resolver(c, salto, c->num_instrucciones);
+    return !c->fallo;
+}
+
+// Compilar los pipes de una lista, en orden
+static bool compilar_cuerpo(compilador* c, const lista_comandos* lista)
+{
+    for (int i = 0; i < lista->num_pipelines && !c->fallo; i++)
+    {
+        compilar_pipeline(c, &lista->pipelines[i]);
+    }
+    return !c->fallo;
+}
+
+// Redondear un desplazamiento a múltiplo de 8
+static uint64_t alinear8(uint64_t desplazamiento)
+{
+    return (desplazamiento + 7) & ~(uint64_t)7;
+}
+
+// Calcular dónde va cada tabla a partir de las cantidades de la cabecera
+static disposicion_programa calcular_disposicion(const cabecera_programa* cabecera)
+{
+    disposicion_programa d;
+    d.instrucciones = alinear8(sizeof(cabecera_programa));
+    d.pipelines = alinear8(d.instrucciones + (uint64_t)cabecera->num_instrucciones * sizeof(instruccion));
+    d.etapas = alinear8(d.pipelines + (uint64_t)cabecera->num_pipelines * sizeof(pipeline_compilado));
+    d.palabras = alinear8(d.etapas + (uint64_t)cabecera->num_etapas * sizeof(etapa_compilada));
+    d.redirecciones = alinear8(d.palabras + (uint64_t)cabecera->num_palabras * sizeof(palabra_compilada));
+    d.cadenas = alinear8(d.redirecciones + (uint64_t)cabecera->num_redirecciones * sizeof(redireccion_compilada));
+    d.total = d.cadenas + cabecera->largo_cadenas;
+    return d;
+}
+
+// Completar los punteros de un programa a las tablas de su bloque
+static void ubicar_tablas(const void* bloque, size_t largo, const disposicion_programa* d, programa* p)
+{
+    const unsigned char* base = bloque;
+    p->cabecera = bloque;
+    p->instrucciones = (const instruccion*)(base + d->instrucciones);
+    p->pipelines = (const pipeline_compilado*)(base + d->pipelines);
+    p->etapas = (const etapa_compilada*)(base + d->etapas);
+    p->palabras = (const palabra_compilada*)(base + d->palabras);
+    p->redirecciones = (const redireccion_compilada*)(base + d->redirecciones);
+    p->cadenas = (const char*)(base + d->cadenas);
+    p->largo = largo;
+}
+
+// Copiar las tablas del compilador en un único bloque de la arena
+static int ensamblar(compilador* c, arena* a, programa* salida)
+{
+    cabecera_programa cabecera = {.magia = BYTECODE_MAGIA,
+                                  .version = BYTECODE_VERSION,
+                                  .num_instrucciones = c->num_instrucciones,
+                                  .num_pipelines = c->num_pipelines,
+                                  .num_etapas = c->num_etapas,
+                                  .num_palabras = c->num_palabras,
+                                  .num_redirecciones = c->num_redirecciones,
+                                  .largo_cadenas = (uint32_t)c->largo_cadenas};
+    disposicion_programa d = calcular_disposicion(&cabecera);
+    unsigned char* bloque = arena_reservar_cero(a, (size_t)d.total); // El relleno entre tablas queda en cero
+    if (bloque == NULL)
+    {
+        fallar(c, "memoria insuficiente");
+        return -1;
+    }
+
+    memcpy(bloque, &cabecera, sizeof(cabecera));
+    if (c->num_instrucciones > 0)
+        memcpy(bloque + d.instrucciones, c->instrucciones, c->num_instrucciones * sizeof(instruccion));
+    if (c->num_pipelines > 0)
+        memcpy(bloque + d.pipelines, c->pipelines, c->num_pipelines * sizeof(pipeline_compilado));
+    if (c->num_etapas > 0)
+        memcpy(bloque + d.etapas, c->etapas, c->num_etapas * sizeof(etapa_compilada));
+    if (c->num_palabras > 0)
+        memcpy(bloque + d.palabras, c->palabras, c->num_palabras * sizeof(palabra_compilada));
+    if (c->num_redirecciones > 0)
+        memcpy(bloque + d.redirecciones, c->redirecciones, c->num_redirecciones * sizeof(redireccion_compilada));
+    memcpy(bloque + d.cadenas, c->cadenas, c->largo_cadenas);
+    ubicar_tablas(bloque, (size_t)d.total, &d, salida);
+    return 0;
+}
+
+// Compilar una lista de comandos en un programa
+int compilar_lista(const lista_comandos* lista, arena* a, programa* salida, char* error, size_t tam_error)
+{
+    compilador c;
+    memset(&c, 0, sizeof(c));
+    c.error = error;
+    c.tam_error = tam_error;
+    if (error != NULL && tam_error > 0)
+        error[0] = '\0';
+
+    compilar_cuerpo(&c, lista);
+    emitir(&c, OP_FIN, 0, 0, 0);
+    agregar_cadena(&c, ""); // La tabla de cadenas nunca queda vacía y termina en '\0'
+    int resultado = c.fallo ? -1 : ensamblar(&c, a, salida);
+
+    free(c.instrucciones);
+    free(c.pipelines);
+    free(c.etapas);
+    free(c.palabras);
+    free(c.redirecciones);
+    free(c.cadenas);
+    return resultado;
+}
+
+// Verificar que una palabra apunte dentro de la tabla de cadenas
+static bool palabra_valida(const programa* p, const palabra_compilada* w)
+{
+    return w->texto < p->cabecera->largo_cadenas && w->expandir <= 1;
+}
+
+// Verificar que un rango [primero, primero + cantidad) esté dentro de una tabla de n elementos
+static bool rango_valido(uint32_t primero, uint32_t cantidad, uint32_t n)
+{
+    return (uint64_t)primero + cantidad <= n;
+}
+
+// Verificar los operandos de una instrucción
+static bool instruccion_valida(const programa* p, const instruccion* i)
+{
+    const cabecera_programa* h = p->cabecera;
+    switch (i->op)
+    {
+    case OP_EJECUTAR:
+        return i->a < h->num_pipelines;
+    case OP_ASIGNAR:
+        return rango_valido(i->a, i->n, h->num_palabras);
+    case OP_SALTAR:
+    case OP_SALTAR_SI_FALLA:
+    case OP_SALTAR_SI_EXITO:
+        return i->a < h->num_instrucciones;
+    case OP_NEGAR:
+    case OP_FIN:
+        return true;
+    case OP_ESTADO:
+        return i->a <= 255;
+    case OP_CICLO_INICIO:
+    case OP_CICLO_GUARDAR:
+    case OP_CICLO_FIN:
+        return i->n < BYTECODE_MAX_CICLOS;
+    case OP_PARA_INICIO:
+        return i->n < BYTECODE_MAX_CICLOS && rango_valido(i->a, i->b, h->num_palabras);
+    case OP_PARA_SIGUIENTE:
+        return i->n < BYTECODE_MAX_CICLOS && i->a < h->largo_cadenas && i->b < h->num_instrucciones;
+    case OP_CASO_SUJETO:
+        return i->a < h->num_palabras;
+    case OP_CASO_PROBAR:
+        return i->a < h->num_palabras && i->b < h->num_instrucciones;
+    case OP_FUNCION:
+        return i->a < h->largo_cadenas && i->b < h->num_instrucciones;
+    case OP_RETORNAR:
+        return i->n == 0 || (i->n == 1 && i->a < h->num_palabras);
+    default:
+        return false;
+    }
+}
+
+// Abrir un programa guardado en un bloque, verificando que sea válido
+int programa_abrir(const void* bloque, size_t largo, programa* p)
+{
+    if (bloque == NULL || largo < sizeof(cabecera_programa) || (uintptr_t)bloque % 8 != 0)
+    {
+        return -1;
+    }
+    const cabecera_programa* h = bloque;
+    if (h->magia != BYTECODE_MAGIA || h->version != BYTECODE_VERSION || h->num_instrucciones == 0 ||
+        h->largo_cadenas == 0)
+    {
+        return -1;
+    }
+    disposicion_programa d = calcular_disposicion(h);
+    if (d.total != largo)
+    {
+        return -1;
+    }
+    ubicar_tablas(bloque, largo, &d, p);
+
+    if (p->cadenas[h->largo_cadenas - 1] != '\0')
+    {
+        return -1; // Toda cadena termina dentro de la tabla
+    }
+    for (uint32_t i = 0; i < h->num_palabras; i++)
+    {
+        if (!palabra_valida(p, &p->palabras[i]))
+            return -1;
+    }
+    for (uint32_t i = 0; i < h->num_redirecciones; i++)
+    {
+        const redireccion_compilada* r = &p->redirecciones[i];
+        if (r->tipo > REDIR_AGREGAR_Y_ERRORES || r->fd < 0 || !palabra_valida(p, &r->destino))
+            return -1;
+    }
+    for (uint32_t i = 0; i < h->num_etapas; i++)
+    {
+        const etapa_compilada* e = &p->etapas[i];
+        if (!rango_valido(e->primera_palabra, e->num_palabras, h->num_palabras) ||
+            !rango_valido(e->primera_redireccion, e->num_redirecciones, h->num_redirecciones))
+            return -1;
+    }
+    for (uint32_t i = 0; i < h->num_pipelines; i++)
+    {
+        const pipeline_compilado* t = &p->pipelines[i];
+        if (t->num_etapas == 0 || !rango_valido(t->primera_etapa, t->num_etapas, h->num_etapas) ||
+            t->en_segundo_plano > 1)
+            return -1;
+    }
+    for (uint32_t i = 0; i < h->num_instrucciones; i++)
+    {
+        if (!instruccion_valida(p, &p->instrucciones[i]))
+            return -1;
+    }
+    uint16_t ultima = p->instrucciones[h->num_instrucciones - 1].op;
+    return ultima == OP_FIN || ultima == OP_RETORNAR ? 0 : -1; // La ejecución nunca sigue de largo
+}
+
+// Escribir las palabras [primera, primera + n) separadas por espacios
+static void volcar_palabras(const programa* p, uint32_t primera, uint32_t n, FILE* salida)
+{
+    for (uint32_t i = 0; i < n; i++)
+    {
+        fprintf(salida, "%s%s", i > 0 ? " " : "", p->cadenas + p->palabras[primera + i].texto);
+    }
+}
+
+// Escribir el texto de un pipe compilado
+static void volcar_pipeline(const programa* p, const pipeline_compilado* t, FILE* salida)
+{
+    fprintf(salida, "línea %d: ", t->linea);
+    for (uint32_t i = 0; i < t->num_etapas; i++)
+    {
+        const etapa_compilada* e = &p->etapas[t->primera_etapa + i];
+        fprintf(salida, "%s", i > 0 ? " | " : "");
+        volcar_palabras(p, e->primera_palabra, e->num_palabras, salida);
+        for (uint32_t j = 0; j < e->num_redirecciones; j++)
+        {
+            const redireccion_compilada* r = &p->redirecciones[e->primera_redireccion + j];
+            bool con_fd = r->tipo != REDIR_SALIDA_Y_ERRORES && r->tipo != REDIR_AGREGAR_Y_ERRORES;
+            fprintf(salida, " ");
+            if (con_fd)
+                fprintf(salida, "%d", r->fd);
+            fprintf(salida, "%s%s", operadores_redireccion[r->tipo], p->cadenas + r->destino.texto);
+        }
+    }
+    fprintf(salida, "%s", t->en_segundo_plano ? " &" : "");
+}
+
+// Escribir un listado legible del programa
+void programa_volcar(const programa* p, FILE* salida)
+{
+    const cabecera_programa* h = p->cabecera;
+    fprintf(salida, "; %u instrucciones, %u pipes, %u palabras, %u bytes de cadenas (%zu bytes en total)\n",
+            h->num_instrucciones, h->num_pipelines, h->num_palabras, h->largo_cadenas, p->largo);
+
+    for (uint32_t pc = 0; pc < h->num_instrucciones; pc++)
+    {
+        const instruccion* i = &p->instrucciones[pc];
+        bool sin_operandos = i->op == OP_NEGAR || i->op == OP_FIN || (i->op == OP_RETORNAR && i->n == 0);
+        fprintf(salida, "%04u  %-*s", pc, sin_operandos ? 0 : 16, nombres_operaciones[i->op]);
+        switch (i->op)
+        {
+        case OP_EJECUTAR:
+            fprintf(salida, "p%u ; ", i->a);
+            volcar_pipeline(p, &p->pipelines[i->a], salida);
+            break;
+        case OP_ASIGNAR:
+            volcar_palabras(p, i->a, i->n, salida);
+            break;
+        case OP_SALTAR:
+        case OP_SALTAR_SI_FALLA:
+        case OP_SALTAR_SI_EXITO:
+            fprintf(salida, "-> %04u", i->a);
+            break;
+        case OP_ESTADO:
+            fprintf(salida, "%u", i->a);
+            break;
+        case OP_CICLO_INICIO:
+        case OP_CICLO_GUARDAR:
+        case OP_CICLO_FIN:
+            fprintf(salida, "c%u", i->n);
+            break;
+        case OP_PARA_INICIO:
+            fprintf(salida, "c%u ", i->n);
+            volcar_palabras(p, i->a, i->b, salida);
+            break;
+        case OP_PARA_SIGUIENTE:
+            fprintf(salida, "c%u %s, si no quedan -> %04u", i->n, p->cadenas + i->a, i->b);
+            break;
+        case OP_CASO_SUJETO:
+            volcar_palabras(p, i->a, 1, salida);
+            break;
+        case OP_CASO_PROBAR:
+            volcar_palabras(p, i->a, 1, salida);
+            fprintf(salida, " -> %04u", i->b);
+            break;
+        case OP_FUNCION:
+            fprintf(salida, "%s, fin -> %04u", p->cadenas + i->a, i->b);
+            break;
+        case OP_RETORNAR:
+            if (i->n == 1)
+                volcar_palabras(p, i->a, 1, salida);
+            break;
+        default:
+            break;
+        }
+        fprintf(salida, "\n");
+    }
+}
@@ -4,12 +4,22 @@
  */
 
 #include "commands.h"
+#include "builtins.h"
+#include "bytecode.h"
+#include "fd_plan.h"
 #include "globals.h"
+#include "jobs.h"
+#include "launcher.h"
 #include "monitor.h"
+#include "parser.h"
+#include "prompt.h"
 #include "shell_utils.h"
 #include "signal_handlers.h"
-#include <dirent.h>
+#include "vm.h"
+#include <errno.h>
 #include <limits.h>
+#include <sys/mman.h>
+#include <termios.h>
 
 // Variables globales
 /**
@@ -22,129 +32,565 @@ char cwd[PATH_MAX];
  */
 int EXIT = 1;
 
-// Variables para el manejo de trabajos en segundo plano
 /**
- *  @brief ID del trabajo en segundo plano
+ *  @brief PID del proceso en primer plano
  */
-pid_t jobs[MAX_JOBS];
+pid_t proceso_en_primer_plano = 0; // PID del proceso en primer plano
 
 /**
- *  @brief Lista para almacenar los PIDs de los trabajos en segundo plano
+ *  @brief Código de salida del último comando ejecutado en primer plano
  */
+int ultimo_estado = 0;
 
 /**
- *  @brief PID del proceso en primer plano
+ *  @brief Opción pipefail: el estado de un pipe es el de la última etapa que falló, o 0 si ninguna falló
  */
-pid_t proceso_en_primer_plano = 0; // PID del proceso en primer plano
+bool opcion_pipefail = false;
+
+/**
+ *  @brief Opción internos: cat, wc, head, tail, true, false y test se ejecutan en el shell (ver core_utils.h)
+ */
+bool opcion_internos = false;
+
+/**
+ *  @brief Opción --dump-bytecode: cada programa se lista en stderr antes de ejecutarse
+ */
+bool opcion_volcar_bytecode = false;
+
+/**
+ *  @brief Códigos de salida de cada etapa del último pipe ejecutado en primer plano
+ */
+static int* estados_etapas = NULL;
+
+/**
+ *  @brief Cantidad de códigos guardados en estados_etapas
+ */
+static int num_estados_etapas = 0;
+
+/**
+ * @brief Opción del shell que se activa con "set -o" y se desactiva con "set +o".
+ */
+typedef struct
+{
+    const char* nombre; /**< Nombre de la opción */
+    bool* valor;        /**< Variable que guarda el estado de la opción */
+} opcion_shell;
+
+/**
+ *  @brief Opciones reconocidas por el comando "set"
+ */
+static const opcion_shell opciones_shell[] = {{"pipefail", &opcion_pipefail}, {"internos", &opcion_internos}};
 
 /**
- *  @brief ID del grupo de procesos de la shell
+ *  @brief Arena de la línea en ejecución: guarda el árbol de comandos y las expansiones, y se reinicia en O(1)
  */
-int job_id = 1; // ID para los trabajos en segundo plano
+static arena arena_linea;
+
+/**
+ *  @brief Cantidad de listas de comandos en ejecución; la arena de la línea sólo se reinicia al volver a cero
+ */
+static int profundidad_ejecucion = 0;
 
 // Analiza comandos y ejecuta acciones correspondientes
 int analizar_comando(char* comando)
 {
-    char comando_copy[MAX_LINE];              // Copia del comando para evitar cambios
-    strncpy(comando_copy, comando, MAX_LINE); // Copiar el comando a la variable de copia
+    lista_comandos* lista;
+    char error[256];
+
+    // Construir el árbol de la línea completa en una sola pasada; ejecutar_lista() libera sus nodos al terminar
+    if (parsear_comandos(&arena_linea, comando, strlen(comando), 1, &lista, error, sizeof(error)) == PARSEO_OK)
+    {
+        ejecutar_lista(lista);
+    }
+    else
+    {
+        fprintf(stderr, "Error: %s\n", error);
+        if (profundidad_ejecucion == 0)
+        {
+            arena_reiniciar(&arena_linea);
+        }
+    }
+    return 0; // Indicar que el comando fue procesado
+}
 
-    char* comando_base = strtok(comando_copy, " "); // Obtener el comando base
-    char* argumento = strtok(NULL, " ");            // Obtener el argumento del comando
+// Compilar una lista de comandos y ejecutar el programa resultante
+void ejecutar_lista(const lista_comandos* lista)
+{
+    programa p;
+    char error[256];
 
-    // Verificar si el comando contiene un pipe
-    if (strchr(comando, '|') != NULL)
+    if (compilar_lista(lista, &arena_linea, &p, error, sizeof(error)) == 0)
     {
-        ejecutar_comando_con_pipes(comando);
-        return 0;
+        ejecutar_programa(&p);
     }
+    else
+    {
+        fprintf(stderr, "Error: %s\n", error);
+        ultimo_estado = 2;
+        if (profundidad_ejecucion == 0)
+        {
+            arena_reiniciar(&arena_linea);
+        }
+    }
+}
 
-    // Verificar si el comando es "cd"
-    if (comando_base != NULL && strcmp(comando_base, "cd") == 0)
+// Ejecutar un programa ya compilado
+void ejecutar_programa(const programa* p)
+{
+    profundidad_ejecucion++;
+    if (opcion_volcar_bytecode)
     {
-        Ctrl_CD(argumento); // Llamar a la función para cambiar el directorio
-        return 0;           // Indicar que el comando fue procesado
+        programa_volcar(p, stderr);
     }
+    vm_ejecutar(p);
 
-    // Verificar si el comando es "clr"
-    if (comando_base != NULL && strcmp(comando_base, "clr") == 0)
+    // Liberar de una vez los nodos y las expansiones de la línea, salvo que sea una lista anidada
+    if (--profundidad_ejecucion == 0)
     {
-        limpiar_pantalla(); // Llamar a la función para limpiar la pantalla
-        return 0;           // Indicar que el comando fue procesado
+        arena_reiniciar(&arena_linea);
     }
+}
 
-    // Verificar si el comando es "echo"
-    if (comando_base != NULL && strcmp(comando_base, "echo") == 0 && argumento[strlen(argumento) - 1] != '&')
+// Ejecutar un pipe, liberando al terminar lo que reservaron sus expansiones
+void ejecutar_pipe(const pipeline* p)
+{
+    marca_arena marca = arena_marcar(&arena_linea);
+    if (p->num_etapas == 1)
     {
-        ejecutar_echo(argumento); // Llamar a la función para imprimir el texto
-        return 0;
+        ejecutar_comando_simple(&p->etapas[0], p->en_segundo_plano);
+    }
+    else
+    {
+        ejecutar_pipeline(p);
     }
+    arena_volver(&arena_linea, marca); // Un ciclo largo no acumula las expansiones de cada vuelta
+}
 
-    // Verificar si el comando es "quit"
-    if (comando_base != NULL && strcmp(comando_base, "quit") == 0)
+// Guardar los códigos de salida de las etapas del último pipe y calcular el estado del pipe
+static void guardar_estados(const int* estados, int n)
+{
+    int* nuevos = realloc(estados_etapas, (size_t)n * sizeof(int));
+    if (nuevos != NULL)
     {
-        EXIT = 0;           // Cambiar el valor de la variable para salir del shell
-        liberar_recursos(); // Llamar a la función para liberar los recursos
-        return 0;           // Indicar que el comando fue procesado
+        memcpy(nuevos, estados, (size_t)n * sizeof(int));
+        estados_etapas = nuevos;
+        num_estados_etapas = n;
+    }
+
+    ultimo_estado = estados[n - 1]; // Por defecto, el estado del pipe es el de la última etapa
+    if (opcion_pipefail)
+    {
+        ultimo_estado = 0;
+        for (int i = n - 1; i >= 0 && ultimo_estado == 0; i--)
+        {
+            ultimo_estado = estados[i]; // Con pipefail, el de la última etapa que falló
+        }
     }
+}
 
-    // Verificar si el comando es "fg"
-    if (comando_base != NULL && strcmp(comando_base, "fg") == 0)
+// Armar el texto de un pipe a partir de sus argumentos ya expandidos, para los listados de trabajos
+static char* texto_pipeline(char*** args, int n)
+{
+    size_t largo = 1;
+    for (int i = 0; i < n; i++)
     {
-        int job_number = argumento ? atoi(argumento) : -1; // Obtener el número de trabajo
-        manejar_comando_fg(job_number);
-        return 0; // Indicar que el comando fue procesado
+        for (int j = 0; args[i][j] != NULL; j++)
+        {
+            largo += strlen(args[i][j]) + 1;
+        }
+        largo += 3; // " | "
     }
 
-    // Verificar si el comando es "bg"
-    if (comando_base != NULL && strcmp(comando_base, "bg") == 0)
+    char* texto = arena_reservar(&arena_linea, largo);
+    if (texto == NULL)
     {
-        int job_number = argumento ? atoi(argumento) : -1; // Obtener el número de trabajo
-        manejar_comando_bg(job_number);
-        return 0; // Indicar que el comando fue procesado
+        return "";
     }
+    char* p = texto;
+    for (int i = 0; i < n; i++)
+    {
+        p = stpcpy(p, i > 0 ? " | " : "");
+        for (int j = 0; args[i][j] != NULL; j++)
+        {
+            p = stpcpy(p, j > 0 ? " " : "");
+            p = stpcpy(p, args[i][j]);
+        }
+    }
+    return texto;
+}
 
-    // Verificar si el comando es "start_monitor"
-    if (comando_base != NULL && strcmp(comando_base, "start_monitor") == 0)
+// Contar los argumentos de un vector terminado en NULL
+static int contar_argumentos(char** args)
+{
+    int argc = 0;
+    while (args[argc] != NULL)
     {
-        start_monitor(); // Llamar a la función para iniciar el monitor
-        return 0;        // Indicar que el comando fue procesado
+        argc++;
     }
+    return argc;
+}
+
+// Ejecutar un comando interno en el hijo de una etapa del pipe
+static int ejecutar_interno_en_hijo(void* dato)
+{
+    char** args = dato;
+    return buscar_builtin(args[0])->manejador(contar_argumentos(args), args);
+}
 
-    // Verificar si el comando es "stop_monitor"
-    if (comando_base != NULL && strcmp(comando_base, "stop_monitor") == 0)
+// Ejecutar una función del shell en el hijo de una etapa del pipe o de un comando en segundo plano
+static int ejecutar_funcion_en_hijo(void* dato)
+{
+    char** args = dato;
+    return vm_llamar_funcion(vm_buscar_funcion(args[0]), contar_argumentos(args), args);
+}
+
+// Ejecutar un comando interno o una función en el propio shell con la entrada, la salida y las redirecciones indicadas
+static int ejecutar_interno_en_shell(const comando_simple* comando, char** args, int entrada, int salida)
+{
+    funcion_shell* funcion = args[0] != NULL ? vm_buscar_funcion(args[0]) : NULL; // Las funciones tienen prioridad
+    const descriptor_builtin* builtin = args[0] != NULL && funcion == NULL ? elegir_builtin(args) : NULL;
+    plan_spawn plan;
+    plan_aplicado aplicado;
+
+    // Compilar el plan del comando: primero el pipe o buffer de la etapa, después sus redirecciones, que tienen
+    // prioridad sobre él
+    plan_inicializar(&plan, args);
+    if (entrada != -1)
+    {
+        plan_agregar_dup2(&plan, entrada, STDIN_FILENO);
+    }
+    if (salida != -1)
     {
-        stop_monitor(); // Llamar a la función para detener el monitor
-        return 0;       // Indicar que el comando fue procesado
+        plan_agregar_dup2(&plan, salida, STDOUT_FILENO);
+    }
+    if (plan_compilar_redirecciones(&plan, &arena_linea, comando->redirecciones) == -1)
+    {
+        return 1; // Si una redirección falla el comando no se ejecuta
     }
 
-    // Verifica si el comando es "status_monitor"
-    if (comando_base != NULL && strcmp(comando_base, "status_monitor") == 0)
+    // Los comandos que sólo usan stdio (y las líneas sin comando) reciben flujos nuevos; el resto, y las funciones,
+    // que pueden lanzar procesos, descriptores
+    int estado = 1;
+    bool en_flujos = funcion == NULL && (builtin == NULL || builtin->usa_flujos);
+    if ((en_flujos ? plan_aplicar_en_flujos(&plan, &aplicado) : plan_aplicar_en_shell(&plan, &aplicado)) == 0)
     {
-        status_monitor(); // Llamar a la función para mostrar el estado del monitor
-        return 0;         // Indicar que el comando fue procesado
+        if (funcion != NULL)
+            estado = vm_llamar_funcion(funcion, contar_argumentos(args), args);
+        else
+            estado = builtin != NULL ? builtin->manejador(contar_argumentos(args), args) : 0; // Ejecutar el comando
+        fflush(stdout); // La salida del comando interno debe aparecer antes que la de los comandos siguientes
     }
+    plan_restaurar(&aplicado);
+    return estado;
+}
 
-    // Verifica si el comando es "update_config"
-    if (comando_base != NULL && strcmp(comando_base, "update_config") == 0)
+// Verificar si una etapa de un pipe es un comando interno que puede ejecutarse en el propio shell
+static bool se_ejecuta_en_shell(char** args)
+{
+    if (args[0] != NULL && vm_buscar_funcion(args[0]) != NULL)
     {
-        handle_update_command(comando); // Llamar a la función para actualizar la configuración
-        return 0;                       // Indicar que el comando fue procesado
+        return false; // Una función en un pipe corre en su propio proceso, como en sh
     }
+    const descriptor_builtin* builtin = args[0] != NULL ? elegir_builtin(args) : NULL;
+    return builtin != NULL && builtin->en_pipeline && !builtin->requiere_fork;
+}
 
-    // Verifica si el comando es "explorar_config"
-    if (comando_base != NULL && strcmp(comando_base, "explorar_config") == 0)
+// Ejecutar en el propio shell etapas internas consecutivas; entre ellas los datos pasan por buffers en memoria
+static void ejecutar_internos_en_shell(const comando_simple* etapas, char*** args, int desde, int hasta, int entrada,
+                                       int salida, int* estados)
+{
+    int buffer_entrada = -1; // Buffer que dejó la etapa anterior, propiedad de esta función
+
+    for (int i = desde; i < hasta; i++)
     {
-        const char* directorio = argumento ? argumento : cwd; // Si no se pasa directorio, usar el actual
-        const char* extension = ".config";                    // Usar .config como ejemplo, pero puede ser .json u otro
+        int buffer_salida = -1;
+        if (i < hasta - 1)
+        {
+            buffer_salida = memfd_create("pipe_interno", MFD_CLOEXEC); // Archivo anónimo en memoria
+            if (buffer_salida == -1)
+            {
+                perror("Error al crear el buffer entre comandos internos");
+                break;
+            }
+        }
+
+        estados[i] = ejecutar_interno_en_shell(&etapas[i], args[i], buffer_entrada != -1 ? buffer_entrada : entrada,
+                                               buffer_salida != -1 ? buffer_salida : salida);
 
-        printf("Explorando el directorio: %s en busca de archivos '%s'\n", directorio, extension);
-        buscar_configuraciones(directorio, extension); // Llamar a la función de búsqueda
-        return 0;                                      // Indicar que el comando fue procesado
+        if (buffer_entrada != -1)
+        {
+            close(buffer_entrada);
+        }
+        buffer_entrada = buffer_salida;
+        if (buffer_entrada != -1)
+        {
+            lseek(buffer_entrada, 0, SEEK_SET); // La siguiente etapa lee desde el principio lo que escribió esta
+        }
     }
 
-    // Interpretar cualquier otro comando como un programa externo
-    ejecutar_programa_externo(comando); // Llamar a la función para ejecutar un programa externo
-    return 0;                           // Indicar que el comando fue procesado
+    if (buffer_entrada != -1)
+    {
+        close(buffer_entrada);
+    }
+}
+
+// Lanzar un proceso por etapa, todos en un mismo grupo de procesos, y esperarlos si el pipe va en primer plano. Los
+// comandos internos del principio y del final del pipe se ejecutan en el propio shell, sin crear procesos
+static void ejecutar_etapas(const comando_simple* etapas, int n, char*** args, bool en_segundo_plano)
+{
+    pid_t* pids = arena_reservar(&arena_linea, (size_t)n * sizeof(pid_t));
+    int* estados = arena_reservar(&arena_linea, (size_t)n * sizeof(int));
+    if (pids == NULL || estados == NULL)
+    {
+        fprintf(stderr, "Error: memoria insuficiente\n");
+        return;
+    }
+    for (int i = 0; i < n; i++)
+    {
+        pids[i] = -1;
+        estados[i] = 127; // Estado de una etapa que no se pudo lanzar
+    }
+
+    // Delimitar las etapas internas del principio [0, fin_inicial) y del final [inicio_final, n); en segundo plano
+    // todas las etapas son procesos aparte
+    int fin_inicial = 0;
+    int inicio_final = n;
+    if (!en_segundo_plano)
+    {
+        while (fin_inicial < n && se_ejecuta_en_shell(args[fin_inicial]))
+            fin_inicial++;
+        while (inicio_final > fin_inicial && se_ejecuta_en_shell(args[inicio_final - 1]))
+            inicio_final--;
+    }
+
+    if (fin_inicial == n) // Pipe formado sólo por comandos internos: no se crea ningún proceso
+    {
+        ejecutar_internos_en_shell(etapas, args, 0, n, -1, -1, estados);
+        guardar_estados(estados, n);
+        return;
+    }
+
+    // El shell escribe en pipes cuyos lectores pueden terminar antes: un EPIPE no debe matarlo
+    struct sigaction ignorar;
+    struct sigaction sigpipe_anterior;
+    memset(&ignorar, 0, sizeof(ignorar));
+    ignorar.sa_handler = SIG_IGN;
+    sigaction(SIGPIPE, &ignorar, &sigpipe_anterior);
+
+    int input_fd = STDIN_FILENO; // Inicialmente, entrada estándar
+    int salida_inicial = -1;     // Pipe donde escriben las etapas internas del principio
+    if (fin_inicial > 0)
+    {
+        if (inicio_final < n)
+        {
+            // Si también hay etapas internas al final, la salida de las del principio se guarda en memoria: escribirla
+            // en un pipe podría bloquear al shell, que todavía no está leyendo del final del pipe
+            input_fd = memfd_create("pipe_interno", MFD_CLOEXEC);
+            if (input_fd != -1)
+            {
+                ejecutar_internos_en_shell(etapas, args, 0, fin_inicial, -1, input_fd, estados);
+                lseek(input_fd, 0, SEEK_SET);
+            }
+        }
+        else
+        {
+            // Las etapas internas escriben directo en el pipe una vez que sus lectores están en ejecución
+            int pipefd[2];
+            if (pipe2(pipefd, O_CLOEXEC) == 0)
+            {
+                input_fd = pipefd[0];
+                salida_inicial = pipefd[1];
+            }
+            else
+            {
+                input_fd = -1;
+            }
+        }
+        if (input_fd == -1)
+        {
+            perror("Error al conectar los comandos internos del pipe");
+            sigaction(SIGPIPE, &sigpipe_anterior, NULL);
+            return;
+        }
+    }
+
+    pid_t pgid = 0;          // Grupo del pipe: el PID de la primera etapa lanzada
+    pid_t ultimo_pid = -1;   // PID de la última etapa lanzada
+    bool interrumpido = false;
+
+    for (int i = fin_inicial; i < inicio_final; i++) // Iterar sobre las etapas que son procesos
+    {
+        bool ultimo = (i == n - 1); // El último comando escribe en la salida estándar
+
+        // Pipe para conectar con el siguiente comando; ningún hijo hereda sus extremos salvo por dup2
+        int pipefd[2] = {-1, -1};
+        if (!ultimo && pipe2(pipefd, O_CLOEXEC) == -1)
+        {
+            perror("Error al crear el pipe");
+            interrumpido = true;
+            break;
+        }
+
+        // Preparar el plan: grupo del pipe, conectar la entrada y la salida a los pipes y cerrar los extremos sobrantes
+        plan_spawn plan;
+        plan_inicializar(&plan, args[i]);
+        plan.pgid = pgid;
+        if (input_fd != STDIN_FILENO)
+        {
+            plan_agregar_dup2(&plan, input_fd, STDIN_FILENO);
+            plan_agregar_cerrar(&plan, input_fd);
+        }
+        if (!ultimo)
+        {
+            plan_agregar_dup2(&plan, pipefd[1], STDOUT_FILENO);
+            plan_agregar_cerrar(&plan, pipefd[1]);
+            plan_agregar_cerrar(&plan, pipefd[0]);
+        }
+        if (salida_inicial != -1)
+        {
+            plan_agregar_cerrar(&plan, salida_inicial); // Sólo el shell escribe en el primer pipe
+        }
+
+        // Las redirecciones de la etapa se aplican después de los pipes, por lo que tienen prioridad
+        if (args[i][0] != NULL && plan_compilar_redirecciones(&plan, &arena_linea, etapas[i].redirecciones) == 0)
+        {
+            const descriptor_builtin* builtin = elegir_builtin(args[i]);
+            if (vm_buscar_funcion(args[i][0]) != NULL)
+            {
+                pids[i] = lanzar_con_fork(&plan, ejecutar_funcion_en_hijo, args[i]); // Función del shell
+            }
+            else if (builtin != NULL && builtin->en_pipeline)
+            {
+                pids[i] = lanzar_con_fork(&plan, ejecutar_interno_en_hijo, args[i]); // Interno en medio del pipe
+            }
+            else
+            {
+                pids[i] = lanzar_plan(&plan); // Ejecutar el comando actual sin fork
+            }
+        }
+        else if (args[i][0] == NULL)
+        {
+            estados[i] = 0; // Etapa vacía, por ejemplo una expansión sin valor
+        }
+
+        if (pids[i] > 0)
+        {
+            if (pgid == 0)
+            {
+                pgid = pids[i]; // La primera etapa lanzada es la líder del grupo
+                if (!en_segundo_plano && shell_is_interactive)
+                {
+                    tcsetpgrp(shell_terminal, pgid); // Entregar la terminal al grupo del pipe
+                }
+            }
+            setpgid(pids[i], pgid); // Repetir en el padre para no depender de cuándo corre el hijo
+            ultimo_pid = pids[i];
+        }
+
+        // En el padre, cerrar los extremos que ya pertenecen a los hijos (si la etapa falló, la siguiente verá EOF)
+        if (input_fd != STDIN_FILENO)
+        {
+            close(input_fd);
+        }
+        input_fd = ultimo ? STDIN_FILENO : pipefd[0]; // Leer del pipe para el próximo comando
+        if (!ultimo)
+        {
+            close(pipefd[1]); // Cerrar lado de escritura del pipe
+        }
+    }
+
+    // Con los procesos ya en ejecución, correr las etapas internas que escriben en el primer pipe o leen del último
+    if (salida_inicial != -1)
+    {
+        ejecutar_internos_en_shell(etapas, args, 0, fin_inicial, -1, salida_inicial, estados);
+        close(salida_inicial); // El lector ve EOF
+    }
+    if (inicio_final < n && !interrumpido)
+    {
+        ejecutar_internos_en_shell(etapas, args, inicio_final, n, input_fd, -1, estados);
+    }
+    if (input_fd != STDIN_FILENO) // Cerrar el último extremo
+    {
+        close(input_fd);
+    }
+    sigaction(SIGPIPE, &sigpipe_anterior, NULL);
+
+    if (pgid != 0 && en_segundo_plano)
+    {
+        trabajo* t = trabajos_agregar(pgid, pids, NULL, n, texto_pipeline(args, n), TRABAJO_EN_EJECUCION);
+        if (t != NULL)
+        {
+            printf("[%d] %d\n", t->id, ultimo_pid); // Imprimir el trabajo en segundo plano
+            fflush(stdout);
+        }
+        else
+        {
+            fprintf(stderr, "Error: memoria insuficiente para registrar el trabajo\n");
+        }
+        ultimo_estado = 0;
+        return;
+    }
+
+    // Esperar exactamente a las etapas de este pipe; los trabajos en segundo plano no se tocan
+    if (pgid != 0)
+    {
+        for (int i = 0; i < n; i++)
+        {
+            if (pids[i] > 0)
+                estados[i] = -1; // Marca de proceso vivo, por si el pipe se detiene y pasa a ser un trabajo
+        }
+
+        proceso_en_primer_plano = pgid;
+        bool detenido = esperar_procesos(pids, n, estados);
+        proceso_en_primer_plano = 0;
+
+        if (shell_is_interactive)
+        {
+            tcsetpgrp(shell_terminal, shell_pgid); // Recuperar la terminal
+            tcsetattr(shell_terminal, TCSADRAIN, &shell_tmodes);
+        }
+        if (detenido)
+        {
+            trabajo* t = trabajos_agregar(pgid, pids, estados, n, texto_pipeline(args, n), TRABAJO_DETENIDO);
+            if (t != NULL)
+            {
+                printf("\n[%d]+  Detenido    %s\n", t->id, t->comando);
+                t->notificado = true;
+            }
+            ultimo_estado = 128 + SIGTSTP;
+            return;
+        }
+    }
+    guardar_estados(estados, n);
+}
+
+// Ejecutar un comando simple que no forma parte de un pipe
+void ejecutar_comando_simple(const comando_simple* comando, bool en_segundo_plano)
+{
+    int argc = 0;
+    char** args = expandir_argumentos(&arena_linea, comando, &argc); // Expandir variables al momento de ejecutar
+    if (args == NULL)
+    {
+        fprintf(stderr, "Error: memoria insuficiente\n");
+        ultimo_estado = 1;
+        return;
+    }
+
+    // Buscar el comando entre las funciones y en la tabla de comandos internos; en segundo plano se ejecuta siempre
+    // en otro proceso
+    bool en_shell = argc == 0 ||
+                    (!en_segundo_plano && (vm_buscar_funcion(args[0]) != NULL || elegir_builtin(args) != NULL));
+
+    // Las funciones, los comandos internos y las líneas que sólo tienen redirecciones se ejecutan en el propio shell
+    if (en_shell)
+    {
+        int estado = ejecutar_interno_en_shell(comando, args, -1, -1);
+        guardar_estados(&estado, 1);
+        return;
+    }
+
+    // Interpretar cualquier otro comando como un programa externo: un pipe de una sola etapa
+    ejecutar_etapas(comando, 1, &args, en_segundo_plano);
 }
 
 // Controlador para el comando "cd"
@@ -208,6 +654,7 @@ void actualizar_pwd()
     {
         setenv("OLDPWD", old_cwd, 1); // Establecer OLDPWD al directorio anterior
         setenv("PWD", cwd, 1);        // Actualizar PWD al nuevo directorio
+        prompt_directorio_cambiado(); // El prompt no vuelve a llamar a getcwd()
     }
     else
     {
@@ -225,388 +672,173 @@ void limpiar_pantalla()
 }
 
 // Imprimir el texto en la consola
-void ejecutar_echo(char* argumento)
+void ejecutar_echo(char** args)
 {
-    // Guardar los descriptores de archivo originales
-    int stdout_fd = dup(STDOUT_FILENO); // Descriptor de archivo para stdout
-    int stdin_fd = dup(STDIN_FILENO);   // Descriptor de archivo para stdin
-    char* args[MAX_LINE];               // Variable para almacenar el texto a imprimir
-    int i = 0;                          // Contador de argumentos
-    bool redireccion = false;           // Bandera para redirección de salida
-
-    if (argumento == NULL || strlen(argumento) == 0)
+    for (int i = 0; args[i] != NULL; i++) // Recorrer todos los argumentos, ya expandidos
     {
-        printf("\n");
-        return;
-    }
-
-    // Tokeniza el comando y guarda cada argumento en args
-    while (argumento != NULL)
-    {
-        if (strcmp(argumento, ">") == 0 || strcmp(argumento, "<") == 0) // Verificar si se requiere redirección
-        {
-            redireccion = true;
-        }
-        args[i++] = argumento;         // Guardar el argumento
-        argumento = strtok(NULL, " "); // Tokeniza el argumento
-    }
-    args[i] = NULL; // Agregar NULL al final de la lista de argumentos
-
-    // Verificar si se requiere redirección
-    if (redireccion)
-    {
-        manejar_redirecciones(args);
-    }
-
-    for (int j = 0; args[j] != NULL; j++) // Recorrer todos los argumentos
-    {
-        if (args[j][0] == '$') // Verificar si el argumento es una variable de entorno
-        {
-            char* var_nombre = args[j] + 1;   // Saltar el '$'
-            char* valor = getenv(var_nombre); // Obtener el valor de la variable
-            if (valor != NULL)
-            {
-                printf("%s", valor); // Imprimir el valor de la variable
-            }
-            else
-            {
-                printf(" "); // Si la variable no existe, imprimir un espacio
-            }
-        }
-        else
-        {
-
-            printf("%s", args[j]); // Imprimir el argumento
-        }
-
-        printf(" "); // Imprimir un espacio entre los argumentos
+        printf("%s%s", i > 0 ? " " : "", args[i]); // Separar los argumentos con un espacio
     }
     printf("\n"); // Imprimir una nueva línea al final
-
-    if (redireccion)
-    {
-        // Restaurar los descriptores de archivo originales
-        dup2(stdout_fd, STDOUT_FILENO);
-        dup2(stdin_fd, STDIN_FILENO);
-        close(stdout_fd);
-        close(stdin_fd);
-    }
-
-    return;
 }
 
-// Ejecutar un programa externo
-void ejecutar_programa_externo(char* comando)
+// Manejar el comando "fg"
+int manejar_comando_fg(int argc, char** argv)
 {
-
-    char* args[MAX_LINE];          // Lista de argumentos
-    int i = 0;                     // Contador de argumentos
-    bool en_segundo_plano = false; // Verifica si se ejecuta en segundo plano
-
-    if (comando[strlen(comando) - 1] == '&') // Verifica si el comando debe ejecutarse en segundo plano
+    trabajos_actualizar();
+    trabajo* t = trabajos_buscar(argc > 1 ? argv[1] : NULL);
+    if (t == NULL)
     {
-        en_segundo_plano = true;
-        comando[strlen(comando) - 1] = '\0'; // Elimina el '&' del comando
+        fprintf(stderr, "fg: %s: no existe ese trabajo\n", argc > 1 ? argv[1] : "actual");
+        return 1;
     }
+    printf("%s\n", t->comando);
+    fflush(stdout);
 
-    // Tokeniza el comando y guarda cada argumento en args
-    char* token = strtok(comando, " ");
-    while (token != NULL)
+    // Entregar la terminal al grupo y reanudarlo
+    if (shell_is_interactive)
     {
-        // Eliminar comillas simples si están presentes
-        if (token[0] == '\'' && token[strlen(token) - 1] == '\'')
-        {
-            token[strlen(token) - 1] = '\0';
-            token++;
-        }
-        args[i++] = token;         // Guardar el argumento
-        token = strtok(NULL, " "); // Tokeniza el argumento
+        tcsetpgrp(shell_terminal, t->pgid);
     }
-    args[i] = NULL; // Agregar NULL al final de la lista de argumentos
-
-    if (args[0] == NULL)
-        return; // Si no hay comando, salir
-
-    pid_t pid = fork(); // Crear un proceso hijo
-    if (pid < 0)
+    if (t->estado != TRABAJO_TERMINADO && kill(-t->pgid, SIGCONT) == -1)
     {
-        perror("Error al crear el proceso hijo");
+        perror("Error al enviar SIGCONT");
     }
-    else if (pid == 0) // Código del proceso hijo
-    {
-
-        setpgid(0, 0);               // Establecer el grupo de procesos del hijo
-        manejar_redirecciones(args); // Llama a la función de redirecciones
+    t->estado = t->vivos > 0 ? TRABAJO_EN_EJECUCION : TRABAJO_TERMINADO;
 
-        if (execvp(args[0], args) == -1) // ejectuar programa
-        {
-            perror("Error al ejecutar el programa");
-            exit(EXIT_FAILURE);
-        }
+    // Esperar sólo a los procesos que siguen vivos
+    pid_t* vivos = arena_reservar(&arena_linea, (size_t)t->num_procesos * sizeof(pid_t));
+    bool detenido = false;
+    if (vivos == NULL)
+    {
+        fprintf(stderr, "Error: memoria insuficiente\n");
+        detenido = true; // Sin poder esperarlo, el trabajo queda como estaba, en segundo plano
     }
-    else // Código del proceso padre
+    else
     {
-        setpgid(pid, pid); // Establecer el grupo de procesos del hijo
-        if (en_segundo_plano)
+        for (int i = 0; i < t->num_procesos; i++)
         {
-            int j;
-            for (j = 0; j < MAX_JOBS && jobs[j] != 0; j++)
-                ;             // Encuentra espacio en jobs
-            if (j < MAX_JOBS) // Si hay espacio, agrega el trabajo
-            {
-                jobs[j] = pid;                      // Guardar el PID en la lista de trabajos
-                printf("[%d] %d\n", job_id++, pid); // Imprimir el trabajo en segundo plano
-            }
-            else
-            {
-                printf("Máximo de trabajos en segundo plano alcanzado.\n");
-            }
+            vivos[i] = t->estados[i] == -1 ? t->pids[i] : -1;
         }
-        else // Si no se ejecuta en segundo plano
-        {
-            proceso_en_primer_plano = pid;               // Establecer el proceso en primer plano
-            int status;                                  // Variable para almacenar el estado del proceso
-            while (waitpid(pid, &status, WUNTRACED) > 0) // Espera a que el proceso termine
-            {
-                if (WIFSTOPPED(status)) // Verifica si el proceso fue suspendido
-                {
-                    printf("\nProceso %d suspendido\n", pid);
-                    proceso_en_primer_plano = 0; // Establecer el proceso en primer plano a 0
-                    return;
-                }
-            }
-            proceso_en_primer_plano = 0;
-        }
-    }
-}
-
-// Manejar el comando "fg"
-void manejar_comando_fg(int job_number)
-{
-    pid_t pid = job_number; // Convertir el número de trabajo en un PID
-    if (pid == -1)          // Verificar si el PID es válido
-    {
-        printf("Trabajo no encontrado\n");
-        return;
+        proceso_en_primer_plano = t->pgid;
+        detenido = esperar_procesos(vivos, t->num_procesos, t->estados);
+        proceso_en_primer_plano = 0;
+        trabajos_sincronizar(t);
     }
 
-    // Enviar SIGCONT para reanudar el trabajo en primer plano
-    if (kill(pid, SIGCONT) == 0)
+    if (shell_is_interactive)
     {
-        // Esperar a que el proceso termine en primer plano
-        proceso_en_primer_plano = pid;            // Establecer el proceso en primer plano
-        int status;                               // Variable para almacenar el estado del proceso
-        if (waitpid(pid, &status, WUNTRACED) > 0) // Esperar a que el proceso termine o sea suspendido
-        {
-            if (WIFSTOPPED(status))
-            {
-                printf("\nProceso %d suspendido\n", pid);
-            }
-            else
-            {
-                printf("Proceso %d terminado\n", pid);
-            }
-        }
-        proceso_en_primer_plano = 0;
+        tcsetpgrp(shell_terminal, shell_pgid); // Recuperar la terminal
+        tcsetattr(shell_terminal, TCSADRAIN, &shell_tmodes);
     }
-    else
+    if (detenido)
     {
-        perror("Error al enviar SIGCONT");
+        t->estado = TRABAJO_DETENIDO;
+        t->notificado = true;
+        printf("\n[%d]+  Detenido    %s\n", t->id, t->comando);
+        return 128 + SIGTSTP;
     }
+
+    guardar_estados(t->estados, t->num_procesos);
+    trabajos_eliminar(t);
+    return ultimo_estado;
 }
 
 // Manejar el comando "bg"
-void manejar_comando_bg(int job_number)
+int manejar_comando_bg(int argc, char** argv)
 {
-    pid_t pid = job_number; // Convertir el número de trabajo en un PID
-    if (pid == -1)          // Verificar si el PID es válido
-    {
-        printf("Trabajo no encontrado\n");
-        return;
-    }
-
-    // Enviar SIGCONT para reanudar el trabajo en segundo plano
-    if (kill(pid, SIGCONT) == 0)
+    trabajos_actualizar();
+    trabajo* t = trabajos_buscar(argc > 1 ? argv[1] : NULL);
+    if (t == NULL)
     {
-        printf("Proceso %d reanudado en segundo plano\n", pid);
+        fprintf(stderr, "bg: %s: no existe ese trabajo\n", argc > 1 ? argv[1] : "actual");
+        return 1;
     }
-    else
+    if (t->estado != TRABAJO_DETENIDO)
     {
-        perror("Error al enviar SIGCONT");
+        fprintf(stderr, "bg: el trabajo %d ya está en segundo plano\n", t->id);
+        return 0;
     }
 
-    // Agregar el proceso a la lista de trabajos en segundo plano
-    int j; // Variable para el índice de trabajos
-    for (j = 0; j < MAX_JOBS && jobs[j] != 0; j++)
-        ; // Buscar espacio libre en la lista de trabajos
-
-    if (j < MAX_JOBS)
-    {
-        jobs[j] = pid; // Guardar el PID en la lista de trabajos
-    }
-    else
+    // Enviar SIGCONT para reanudar el trabajo en segundo plano
+    if (kill(-t->pgid, SIGCONT) == -1)
     {
-        printf("Máximo de trabajos en segundo plano alcanzado.\n");
+        perror("Error al enviar SIGCONT");
+        return 1;
     }
+    t->estado = TRABAJO_EN_EJECUCION;
+    printf("[%d]+ %s &\n", t->id, t->comando);
+    return 0;
 }
 
-// Ejecutar un comando con pipes
-void ejecutar_comando_con_pipes(char* comando)
+// Manejar el comando "set"
+int manejar_comando_set(int argc, char** argv)
 {
-    char* comandos[MAX_LINE]; // Array para almacenar los comandos divididos por |
-    int num_comandos = 0;     // Número de comandos en la cadena
+    size_t num_opciones = sizeof(opciones_shell) / sizeof(opciones_shell[0]);
 
-    // Dividir el comando en segmentos separados por |
-    char* segmento = strtok(comando, "|"); // Tokenizar el comando por |
-    while (segmento != NULL && num_comandos < MAX_LINE)
+    if (argc == 1 || (argc == 2 && strcmp(argv[1], "-o") == 0)) // Listar las opciones
     {
-        comandos[num_comandos++] = segmento;
-        segmento = strtok(NULL, "|");
+        for (size_t i = 0; i < num_opciones; i++)
+        {
+            printf("%-15s %s\n", opciones_shell[i].nombre, *opciones_shell[i].valor ? "on" : "off");
+        }
+        return 0;
     }
 
-    int pipefd[2];               // Pipe para conectar procesos
-    int input_fd = STDIN_FILENO; // Inicialmente, entrada estándar
-
-    for (int i = 0; i < num_comandos; i++) // Iterar sobre todos los comandos
+    if (argc != 3 || (strcmp(argv[1], "-o") != 0 && strcmp(argv[1], "+o") != 0))
     {
-        if (pipe(pipefd) == -1) // Verificar si hay un error al crear el pipe
-        {
-            perror("Error al crear el pipe");
-            exit(EXIT_FAILURE);
-        } // Crear un nuevo pipe
+        fprintf(stderr, "Uso: set [-o|+o] [opción]\n");
+        return 2;
+    }
 
-        pid_t pid = fork(); // Crear un nuevo proceso hijo
-        if (pid == 0)       // Código del proceso hijo
+    for (size_t i = 0; i < num_opciones; i++)
+    {
+        if (strcmp(argv[2], opciones_shell[i].nombre) == 0)
         {
-            // Redireccionar input_fd a entrada estándar
-            dup2(input_fd, STDIN_FILENO);
-            // Si no es el último comando, redirecciona salida al pipe
-            if (i < num_comandos - 1)
-            {
-                dup2(pipefd[1], STDOUT_FILENO); // Redireccionar salida del pipe al nuevo pipe
-            }
-            close(pipefd[0]);                       // Cerrar el lado de lectura del pipe
-            ejecutar_programa_externo(comandos[i]); // Ejecutar el comando actual
-            exit(EXIT_FAILURE);
+            *opciones_shell[i].valor = argv[1][0] == '-'; // "-o" activa la opción, "+o" la desactiva
+            return 0;
         }
-        else if (pid < 0)
-        {
-            perror("Error en fork");
-            return;
-        }
-
-        // En el padre, actualizar input_fd para la próxima iteración
-        close(pipefd[1]);     // Cerrar lado de escritura del pipe
-        input_fd = pipefd[0]; // Leer del pipe para el próximo comando
     }
-
-    // Esperar a todos los procesos hijos
-    while (wait(NULL) > 0)
-        ;
+    fprintf(stderr, "set: %s: opción desconocida\n", argv[2]);
+    return 1;
 }
 
-// Manejar redirecciones de entrada y salida
-void manejar_redirecciones(char** args)
+// Manejar el comando "pipestatus"
+int manejar_comando_pipestatus(int argc __attribute__((unused)), char** argv __attribute__((unused)))
 {
-    int in = -1, out = -1; // Descriptores para los archivos de entrada y salida
-    int i = 0;             // Índice para recorrer los argumentos
-
-    // Recorre los argumentos en busca de operadores de redirección
-    while (args[i] != NULL)
-    {
-        if (strcmp(args[i], ">") == 0)
-        { // Redirección de salida
-            if (args[i + 1] != NULL)
-            { // Verifica si hay un archivo de salida
-                out = open(args[i + 1], O_CREAT | O_WRONLY | O_TRUNC, S_IRUSR | S_IWUSR); // Abre el archivo de salida
-                if (out == -1)
-                {
-                    perror("Error al abrir archivo de salida");
-                    return;
-                }
-                dup2(out, STDOUT_FILENO); // Redirige stdout al archivo
-                close(out);               // Cierra el descriptor de archivo
-                args[i] = NULL;           // Remueve el operador y archivo de args
-            }
-            else
-            {
-                fprintf(stderr, "Error: falta el archivo para redirección de salida\n");
-                return;
-            }
-        }
-        else if (strcmp(args[i], "<") == 0)
-        { // Redirección de entrada
-            if (args[i + 1] != NULL)
-            {                                     // Verifica si hay un archivo de entrada
-                in = open(args[i + 1], O_RDONLY); // Abre el archivo de entrada
-                if (in == -1)
-                {
-                    perror("Error al abrir archivo de entrada");
-                    return;
-                }
-                dup2(in, STDIN_FILENO); // Redirige stdin al archivo
-                close(in);              // Cierra el descriptor de archivo
-                args[i] = NULL;         // Remueve el operador y archivo de args
-            }
-            else
-            {
-                fprintf(stderr, "Error: falta el archivo para redirección de entrada\n");
-                return;
-            }
-        }
-        i++; // Incrementa el índice
+    for (int i = 0; i < num_estados_etapas; i++)
+    {
+        printf("%s%d", i > 0 ? " " : "", estados_etapas[i]);
     }
+    printf("\n");
+    return 0;
 }
 
-void buscar_configuraciones(const char* directorio, const char* extension)
+// Ejecutar un comando con pipes
+void ejecutar_comando_con_pipes(char* comando)
 {
-    DIR* dir = opendir(directorio);
-    if (dir == NULL)
+    analizar_comando(comando); // El analizador separa las etapas; la línea se ejecuta con ejecutar_pipeline()
+}
+
+// Ejecutar las etapas de un pipe ya analizado
+void ejecutar_pipeline(const pipeline* p)
+{
+    char*** args = arena_reservar(&arena_linea, (size_t)p->num_etapas * sizeof(char**));
+    if (args == NULL)
     {
-        perror("No se puede abrir el directorio");
+        fprintf(stderr, "Error: memoria insuficiente\n");
         return;
     }
 
-    struct dirent* entry;
-    while ((entry = readdir(dir)) != NULL)
+    // Expandir las palabras de todas las etapas antes de lanzar la primera
+    for (int i = 0; i < p->num_etapas; i++)
     {
-        // Ignorar los directorios "." y ".."
-        if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0)
-        {
-            continue;
-        }
-
-        char ruta_completa[512];
-        snprintf(ruta_completa, sizeof(ruta_completa), "%s/%s", directorio, entry->d_name);
-
-        // Si es un directorio, hacer llamada recursiva
-        if (entry->d_type == DT_DIR)
+        int argc;
+        args[i] = expandir_argumentos(&arena_linea, &p->etapas[i], &argc);
+        if (args[i] == NULL)
         {
-            buscar_configuraciones(ruta_completa, extension);
-        }
-        else
-        {
-            // Comprobar si el archivo tiene la extensión especificada
-            if (strstr(entry->d_name, extension) != NULL)
-            {
-                printf("Archivo de configuración encontrado: %s\n", ruta_completa);
-                FILE* archivo = fopen(ruta_completa, "r");
-                if (archivo)
-                {
-                    char linea[256];
-                    printf("Contenido de %s:\n", ruta_completa);
-                    while (fgets(linea, sizeof(linea), archivo))
-                    {
-                        printf("%s", linea);
-                    }
-                    fclose(archivo);
-                }
-                else
-                {
-                    perror("Error al abrir el archivo");
-                }
-            }
+            fprintf(stderr, "Error: memoria insuficiente\n");
+            return;
         }
     }
-    closedir(dir);
-}
\ No newline at end of file
+    ejecutar_etapas(p->etapas, p->num_etapas, args, p->en_segundo_plano);
+}
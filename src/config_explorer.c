@@ -0,0 +1,916 @@
+/**
+ * @file config_explorer.c
+ * @brief Comando interno 'explorar_config': recorrido paralelo de un árbol de directorios en busca de archivos.
+ */
+#include "config_explorer.h"
+#include "config_index.h"
+#include "file_stream.h"
+#include "globals.h"
+#include "launcher.h"
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <fnmatch.h>
+#include <limits.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**
+ *  @brief Bytes que cada trabajador pide a getdents64() por llamada
+ */
+#define TAM_LECTURA_DIRECTORIO 32768
+
+/**
+ *  @brief Máximo de directorios en espera con su descriptor ya abierto; los demás se abren por ruta
+ */
+#define MAX_DESCRIPTORES_EN_ESPERA 256
+
+/**
+ *  @brief Máximo de palabras del comando del paginador
+ */
+#define MAX_ARGUMENTOS_PAGINADOR 16
+
+typedef struct nodo_directorio nodo_directorio;
+
+/**
+ * @brief Entrada de un directorio que interesa al recorrido
+ */
+typedef struct
+{
+    size_t nombre;           /**< Desplazamiento del nombre dentro de los nombres del directorio */
+    bool directorio;         /**< Es un subdirectorio; si no, un archivo que cumple los filtros */
+    nodo_directorio* hijo;   /**< Subdirectorio pendiente de entregar, o NULL */
+    long long tamano;        /**< Archivos, con metadatos: tamaño, o -1 si no se pudo consultar */
+    long long modificado_ns; /**< Archivos, con metadatos: última modificación */
+} entrada_directorio;
+
+/**
+ * @brief Directorio del recorrido
+ *
+ * Un trabajador lo lee y lo marca como listo; después sólo lo usa el hilo que entrega los hallazgos, que lo libera
+ * cuando terminó de entregar su subárbol.
+ */
+struct nodo_directorio
+{
+    char* ruta;                   /**< Ruta completa */
+    int fd;                       /**< Descriptor que abrió el padre con openat(), o -1 para abrirlo por ruta */
+    int profundidad;              /**< Niveles bajo el directorio inicial */
+    const nodo_directorio* padre; /**< Directorio padre, o NULL en la raíz */
+    dev_t dispositivo;            /**< Dispositivo del directorio */
+    ino_t inodo;                  /**< Inodo del directorio */
+    long long modificado_ns;      /**< Última modificación del directorio */
+    entrada_directorio* entradas; /**< Archivos y subdirectorios, ordenados por nombre */
+    int num_entradas;             /**< Entradas */
+    char* nombres;                /**< Nombres de las entradas, cada uno terminado en '\0' */
+    int error;                    /**< errno si no se pudo abrir o leer */
+    bool bucle;                   /**< Es el mismo directorio que un ancestro: no se leyó */
+    bool listo;                   /**< Un trabajador terminó de leerlo (protegido por mutex_listos) */
+};
+
+/**
+ * @brief Pila de directorios pendientes de un trabajador.
+ *
+ * El dueño toma del final (el último directorio que descubrió, así recorre en profundidad) y los demás roban del
+ * principio, donde están los directorios más antiguos.
+ */
+typedef struct
+{
+    nodo_directorio** nodos; /**< Directorios pendientes */
+    size_t primero;          /**< Próximo directorio que roban los demás */
+    size_t ultimo;           /**< Uno más que el próximo directorio que toma el dueño */
+    size_t capacidad;        /**< Tamaño de nodos */
+    pthread_mutex_t mutex;   /**< Protege los campos anteriores */
+} pila_directorios;
+
+/**
+ * @brief Estado compartido por los trabajadores de una exploración
+ */
+typedef struct
+{
+    const opciones_exploracion* opciones; /**< Filtros */
+    pila_directorios* pilas;              /**< Pila de cada trabajador */
+    int num_trabajadores;                 /**< Trabajadores */
+    atomic_long pendientes;               /**< Directorios encolados o en lectura */
+    atomic_int descriptores;              /**< Directorios en espera con su descriptor abierto */
+    atomic_bool cancelada;                /**< El manejador pidió terminar: los directorios pendientes no se leen */
+    long encolados;                       /**< Directorios en las pilas (protegido por mutex_trabajo) */
+    pthread_mutex_t mutex_trabajo;        /**< Protege encolados */
+    pthread_cond_t hay_trabajo;           /**< Se encolaron directorios o ya no quedan pendientes */
+    pthread_mutex_t mutex_listos;         /**< Protege el campo listo de los nodos */
+    pthread_cond_t hay_listos;            /**< Un trabajador terminó de leer un directorio */
+} exploracion;
+
+/**
+ * @brief Argumento de cada hilo trabajador
+ */
+typedef struct
+{
+    exploracion* x; /**< Estado compartido */
+    int id;         /**< Índice del trabajador y de su pila */
+    char* buffer;   /**< Buffer de getdents64() */
+} trabajador_exploracion;
+
+/**
+ * @brief Estado del hilo que entrega los hallazgos
+ */
+typedef struct
+{
+    manejador_hallazgo manejador; /**< Manejador del llamador */
+    void* dato;                   /**< Dato del manejador */
+    long entregados;              /**< Archivos entregados */
+    bool seguir;                  /**< El manejador no pidió terminar */
+    char* ruta;                   /**< Ruta del archivo que se entrega */
+    size_t capacidad;             /**< Tamaño de ruta */
+} entrega;
+
+// Armar la ruta de una entrada dentro de un directorio; devuelve NULL si no hay memoria
+static char* unir_ruta(const char* directorio, const char* nombre, char* destino, size_t* capacidad)
+{
+    size_t largo = strlen(directorio);
+    bool barra = largo > 0 && directorio[largo - 1] == '/';
+    size_t total = largo + (barra ? 0 : 1) + strlen(nombre) + 1;
+    if (capacidad == NULL || total > *capacidad)
+    {
+        char* nuevo = realloc(destino, total);
+        if (nuevo == NULL)
+            return NULL;
+        destino = nuevo;
+        if (capacidad != NULL)
+            *capacidad = total;
+    }
+    memcpy(destino, directorio, largo);
+    if (!barra)
+        destino[largo++] = '/';
+    strcpy(destino + largo, nombre);
+    return destino;
+}
+
+// Un nombre cumple los filtros: el patrón glob, si hay, y alguna de las extensiones, si hay
+bool explorar_cumple_filtros(const opciones_exploracion* o, const char* nombre)
+{
+    if (o->patron != NULL && fnmatch(o->patron, nombre, FNM_PERIOD) != 0)
+        return false;
+    if (o->num_extensiones == 0)
+        return true;
+    size_t largo = strlen(nombre);
+    for (int i = 0; i < o->num_extensiones; i++)
+    {
+        size_t sufijo = strlen(o->extensiones[i]);
+        if (largo >= sufijo && memcmp(nombre + largo - sufijo, o->extensiones[i], sufijo) == 0)
+            return true;
+    }
+    return false;
+}
+
+// Una entrada es un directorio que hay que recorrer; sin d_type, o con un enlace que se sigue, se consulta fstatat()
+bool explorar_es_directorio(int fd, const char* nombre, unsigned char tipo, bool seguir_enlaces)
+{
+    if (tipo == DT_DIR)
+        return true;
+    if (tipo != DT_UNKNOWN && (tipo != DT_LNK || !seguir_enlaces))
+        return false;
+    struct stat st;
+    return fstatat(fd, nombre, &st, seguir_enlaces ? 0 : AT_SYMLINK_NOFOLLOW) == 0 && S_ISDIR(st.st_mode);
+}
+
+// Tiempo de modificación de un stat en nanosegundos
+static long long modificacion_ns(const struct stat* st)
+{
+    return (long long)st->st_mtim.tv_sec * 1000000000LL + st->st_mtim.tv_nsec;
+}
+
+// Agregar una entrada al directorio, con los metadatos del archivo si se consultaron; false si no hay memoria
+static bool agregar_entrada(nodo_directorio* n, int* capacidad, size_t* capacidad_nombres, size_t* usados,
+                            const char* nombre, bool directorio, const struct stat* st)
+{
+    size_t largo = strlen(nombre) + 1;
+    if (*usados + largo > *capacidad_nombres)
+    {
+        size_t nueva = *capacidad_nombres * 2 > *usados + largo ? *capacidad_nombres * 2 : *usados + largo + 1024;
+        char* nombres = realloc(n->nombres, nueva);
+        if (nombres == NULL)
+            return false;
+        n->nombres = nombres;
+        *capacidad_nombres = nueva;
+    }
+    if (n->num_entradas == *capacidad)
+    {
+        int nueva = *capacidad > 0 ? *capacidad * 2 : 32;
+        entrada_directorio* entradas = realloc(n->entradas, (size_t)nueva * sizeof(entrada_directorio));
+        if (entradas == NULL)
+            return false;
+        n->entradas = entradas;
+        *capacidad = nueva;
+    }
+    memcpy(n->nombres + *usados, nombre, largo);
+    n->entradas[n->num_entradas++] = (entrada_directorio){*usados, directorio, NULL, st != NULL ? st->st_size : -1,
+                                                          st != NULL ? modificacion_ns(st) : 0};
+    *usados += largo;
+    return true;
+}
+
+// Comparar dos entradas por nombre (orden de bytes, el mismo en cualquier configuración regional)
+static int comparar_entradas(const void* a, const void* b, void* nombres)
+{
+    return strcmp((const char*)nombres + ((const entrada_directorio*)a)->nombre,
+                  (const char*)nombres + ((const entrada_directorio*)b)->nombre);
+}
+
+// Crear el nodo de un subdirectorio, abriéndolo respecto del padre si quedan descriptores para los que esperan
+static nodo_directorio* crear_hijo(exploracion* x, const nodo_directorio* padre, int fd_padre, const char* nombre)
+{
+    nodo_directorio* h = calloc(1, sizeof(nodo_directorio));
+    if (h == NULL)
+        return NULL;
+    h->ruta = unir_ruta(padre->ruta, nombre, NULL, NULL);
+    if (h->ruta == NULL)
+    {
+        free(h);
+        return NULL;
+    }
+    h->padre = padre;
+    h->profundidad = padre->profundidad + 1;
+    h->fd = -1;
+    if (atomic_fetch_add(&x->descriptores, 1) < MAX_DESCRIPTORES_EN_ESPERA)
+    {
+        int seguir = x->opciones->seguir_enlaces ? 0 : O_NOFOLLOW;
+        h->fd = openat(fd_padre, nombre, O_RDONLY | O_DIRECTORY | O_CLOEXEC | seguir);
+        if (h->fd == -1 && errno != EMFILE && errno != ENFILE)
+            h->error = errno;
+    }
+    if (h->fd == -1)
+        atomic_fetch_sub(&x->descriptores, 1);
+    return h;
+}
+
+// Encolar directorios en la pila de un trabajador y despertar a los que esperan
+static bool encolar(exploracion* x, int id, nodo_directorio** nodos, int cantidad)
+{
+    pila_directorios* p = &x->pilas[id];
+    pthread_mutex_lock(&p->mutex);
+    if (p->primero > 0 && p->ultimo + (size_t)cantidad > p->capacidad)
+    {
+        memmove(p->nodos, p->nodos + p->primero, (p->ultimo - p->primero) * sizeof(nodo_directorio*));
+        p->ultimo -= p->primero;
+        p->primero = 0;
+    }
+    if (p->ultimo + (size_t)cantidad > p->capacidad)
+    {
+        size_t nueva = p->capacidad * 2 > p->ultimo + (size_t)cantidad ? p->capacidad * 2 : p->ultimo + 64;
+        nueva = nueva > p->ultimo + (size_t)cantidad ? nueva : p->ultimo + (size_t)cantidad;
+        nodo_directorio** nodos_nuevos = realloc(p->nodos, nueva * sizeof(nodo_directorio*));
+        if (nodos_nuevos == NULL)
+        {
+            pthread_mutex_unlock(&p->mutex);
+            return false;
+        }
+        p->nodos = nodos_nuevos;
+        p->capacidad = nueva;
+    }
+    atomic_fetch_add(&x->pendientes, cantidad);
+    memcpy(p->nodos + p->ultimo, nodos, (size_t)cantidad * sizeof(nodo_directorio*));
+    p->ultimo += (size_t)cantidad;
+    pthread_mutex_unlock(&p->mutex);
+
+    pthread_mutex_lock(&x->mutex_trabajo);
+    x->encolados += cantidad;
+    pthread_cond_broadcast(&x->hay_trabajo);
+    pthread_mutex_unlock(&x->mutex_trabajo);
+    return true;
+}
+
+// Tomar un directorio de la pila propia o, si está vacía, robar el más antiguo de otra; NULL si no hay
+static nodo_directorio* tomar_directorio(exploracion* x, int id)
+{
+    nodo_directorio* n = NULL;
+    pila_directorios* propia = &x->pilas[id];
+    pthread_mutex_lock(&propia->mutex);
+    if (propia->primero < propia->ultimo)
+        n = propia->nodos[--propia->ultimo];
+    pthread_mutex_unlock(&propia->mutex);
+
+    for (int i = 1; n == NULL && i < x->num_trabajadores; i++)
+    {
+        pila_directorios* victima = &x->pilas[(id + i) % x->num_trabajadores];
+        pthread_mutex_lock(&victima->mutex);
+        if (victima->primero < victima->ultimo)
+            n = victima->nodos[victima->primero++];
+        pthread_mutex_unlock(&victima->mutex);
+    }
+    return n;
+}
+
+// Encolar los subdirectorios de un directorio; si no hay memoria, se entregan como error
+static void encolar_hijos(exploracion* x, int id, nodo_directorio** hijos, int cantidad)
+{
+    if (cantidad == 0 || encolar(x, id, hijos, cantidad))
+        return;
+    for (int i = 0; i < cantidad; i++)
+    {
+        hijos[i]->error = ENOMEM;
+        hijos[i]->listo = true; // Todavía no son visibles para el hilo que entrega: el padre no está listo
+    }
+}
+
+// Leer un directorio: filtrar y ordenar sus entradas, abrir sus subdirectorios y encolarlos
+static void leer_directorio(exploracion* x, const trabajador_exploracion* t, nodo_directorio* n)
+{
+    const opciones_exploracion* o = x->opciones;
+    int fd = n->fd;
+    int seguir = n->padre == NULL || o->seguir_enlaces ? 0 : O_NOFOLLOW; // Sin -L, sólo la raíz sigue un enlace
+    if (fd != -1)
+        atomic_fetch_sub(&x->descriptores, 1);
+    else
+        fd = open(n->ruta, O_RDONLY | O_DIRECTORY | O_CLOEXEC | seguir); // El padre no lo abrió: se abre por ruta
+    n->fd = -1;
+    if (fd == -1)
+    {
+        n->error = errno;
+        return;
+    }
+    if (atomic_load(&x->cancelada))
+    {
+        close(fd);
+        return;
+    }
+
+    // Un directorio que ya es un ancestro (por un enlace o un montaje) cerraría un ciclo
+    struct stat st;
+    if (fstat(fd, &st) == 0)
+    {
+        n->dispositivo = st.st_dev;
+        n->inodo = st.st_ino;
+        n->modificado_ns = modificacion_ns(&st);
+        for (const nodo_directorio* a = n->padre; a != NULL && !n->bucle; a = a->padre)
+            n->bucle = a->dispositivo == st.st_dev && a->inodo == st.st_ino;
+        if (n->bucle)
+        {
+            close(fd);
+            return;
+        }
+    }
+
+    bool descender = o->profundidad_maxima < 0 || n->profundidad < o->profundidad_maxima;
+    int capacidad = 0;
+    size_t capacidad_nombres = 0;
+    size_t usados = 0;
+    ssize_t leidos;
+    while (n->error == 0 && (leidos = getdents64(fd, t->buffer, TAM_LECTURA_DIRECTORIO)) != 0)
+    {
+        if (leidos == -1)
+        {
+            n->error = errno;
+            break;
+        }
+        for (ssize_t pos = 0; pos < leidos && n->error == 0;)
+        {
+            const struct dirent64* d = (const struct dirent64*)(t->buffer + pos);
+            pos += d->d_reclen;
+            const char* nombre = d->d_name;
+            if (nombre[0] == '.' && (nombre[1] == '\0' || (nombre[1] == '.' && nombre[2] == '\0')))
+                continue;
+            bool directorio = explorar_es_directorio(fd, nombre, d->d_type, o->seguir_enlaces);
+            if (directorio ? !descender : !explorar_cumple_filtros(o, nombre))
+                continue;
+            bool metadatos = !directorio && o->metadatos && fstatat(fd, nombre, &st, 0) == 0;
+            const struct stat* datos = metadatos ? &st : NULL;
+            if (!agregar_entrada(n, &capacidad, &capacidad_nombres, &usados, nombre, directorio, datos))
+                n->error = ENOMEM;
+        }
+    }
+    if (n->num_entradas > 1)
+        qsort_r(n->entradas, (size_t)n->num_entradas, sizeof(entrada_directorio), comparar_entradas, n->nombres);
+
+    // Los subdirectorios se encolan al revés, así el dueño de la pila toma primero el que se entrega primero
+    nodo_directorio* hijos[64];
+    int num_hijos = 0;
+    for (int i = n->num_entradas - 1; i >= 0; i--)
+    {
+        entrada_directorio* e = &n->entradas[i];
+        if (!e->directorio)
+            continue;
+        e->hijo = crear_hijo(x, n, fd, n->nombres + e->nombre);
+        if (e->hijo == NULL)
+            n->error = ENOMEM;
+        else if (e->hijo->error != 0)
+            e->hijo->listo = true; // No hay nada que leer: el error se entrega en su lugar
+        else
+            hijos[num_hijos++] = e->hijo;
+        if (num_hijos == (int)(sizeof(hijos) / sizeof(hijos[0])))
+        {
+            encolar_hijos(x, t->id, hijos, num_hijos);
+            num_hijos = 0;
+        }
+    }
+    encolar_hijos(x, t->id, hijos, num_hijos);
+    close(fd);
+}
+
+// Hilo trabajador: leer directorios hasta que no quede ninguno pendiente
+static void* trabajar(void* arg)
+{
+    const trabajador_exploracion* t = arg;
+    exploracion* x = t->x;
+    while (true)
+    {
+        nodo_directorio* n = tomar_directorio(x, t->id);
+        if (n != NULL)
+        {
+            pthread_mutex_lock(&x->mutex_trabajo);
+            x->encolados--;
+            pthread_mutex_unlock(&x->mutex_trabajo);
+
+            leer_directorio(x, t, n);
+
+            pthread_mutex_lock(&x->mutex_listos);
+            n->listo = true;
+            pthread_cond_broadcast(&x->hay_listos);
+            pthread_mutex_unlock(&x->mutex_listos);
+            if (atomic_fetch_sub(&x->pendientes, 1) == 1)
+            {
+                pthread_mutex_lock(&x->mutex_trabajo);
+                pthread_cond_broadcast(&x->hay_trabajo); // Era el último: los que esperan terminan
+                pthread_mutex_unlock(&x->mutex_trabajo);
+            }
+            continue;
+        }
+
+        // Sin directorios a la vista: esperar a que otro encole o a que no quede ninguno pendiente
+        pthread_mutex_lock(&x->mutex_trabajo);
+        while (x->encolados <= 0 && atomic_load(&x->pendientes) > 0)
+            pthread_cond_wait(&x->hay_trabajo, &x->mutex_trabajo);
+        bool terminar = atomic_load(&x->pendientes) == 0;
+        pthread_mutex_unlock(&x->mutex_trabajo);
+        if (terminar)
+            break;
+    }
+    return NULL;
+}
+
+// Liberar un directorio y los subdirectorios que todavía no se entregaron
+static void liberar_arbol(nodo_directorio* n)
+{
+    for (int i = 0; i < n->num_entradas; i++)
+    {
+        if (n->entradas[i].hijo != NULL)
+            liberar_arbol(n->entradas[i].hijo);
+    }
+    free(n->entradas);
+    free(n->nombres);
+    free(n->ruta);
+    free(n);
+}
+
+// Entregar en orden los hallazgos de un directorio, esperando a que esté leído; devuelve true si lo liberó
+static bool entregar(exploracion* x, entrega* e, nodo_directorio* n)
+{
+    pthread_mutex_lock(&x->mutex_listos);
+    while (!n->listo)
+        pthread_cond_wait(&x->hay_listos, &x->mutex_listos);
+    pthread_mutex_unlock(&x->mutex_listos);
+
+    hallazgo h = {HALLAZGO_DIRECTORIO, n->ruta, n->error, 0, n->modificado_ns, n->dispositivo, n->inodo, 0};
+    if (n->bucle)
+        h.tipo = HALLAZGO_BUCLE;
+    else if (n->error != 0)
+        h.tipo = HALLAZGO_ERROR;
+    e->seguir = e->manejador(&h, e->dato);
+
+    for (int i = 0; i < n->num_entradas && e->seguir; i++)
+    {
+        entrada_directorio* entrada = &n->entradas[i];
+        if (entrada->hijo != NULL)
+        {
+            if (entregar(x, e, entrada->hijo))
+                entrada->hijo = NULL;
+        }
+        else if (!entrada->directorio)
+        {
+            char* ruta = unir_ruta(n->ruta, n->nombres + entrada->nombre, e->ruta, &e->capacidad);
+            if (ruta == NULL)
+            {
+                hallazgo sin_memoria = {HALLAZGO_ERROR, n->ruta, ENOMEM, 0, 0, 0, 0, 0};
+                e->seguir = e->manejador(&sin_memoria, e->dato);
+                continue;
+            }
+            e->ruta = ruta;
+            e->entregados++;
+            hallazgo archivo = {HALLAZGO_ARCHIVO, ruta, 0, entrada->tamano, entrada->modificado_ns, 0, 0, 0};
+            e->seguir = e->manejador(&archivo, e->dato);
+        }
+    }
+    if (!e->seguir)
+    {
+        atomic_store(&x->cancelada, true); // Los trabajadores descartan lo que quede
+        return false;
+    }
+    free(n->entradas);
+    free(n->nombres);
+    free(n->ruta);
+    free(n);
+    return true;
+}
+
+// Recorrer un árbol de directorios con un grupo de trabajadores
+long explorar_directorio(const char* directorio, const opciones_exploracion* opciones, manejador_hallazgo manejador,
+                         void* dato)
+{
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    int trabajadores = opciones->trabajadores;
+    if (trabajadores <= 0)
+        trabajadores = cpus > 0 ? (int)(cpus < EXPLORAR_MAX_TRABAJADORES ? cpus : EXPLORAR_MAX_TRABAJADORES) : 1;
+
+    exploracion x;
+    memset(&x, 0, sizeof(x));
+    x.opciones = opciones;
+    x.num_trabajadores = trabajadores;
+    atomic_init(&x.pendientes, 0);
+    atomic_init(&x.descriptores, 0);
+    atomic_init(&x.cancelada, false);
+    x.pilas = calloc((size_t)trabajadores, sizeof(pila_directorios));
+    trabajador_exploracion* hilos = calloc((size_t)trabajadores, sizeof(trabajador_exploracion));
+    pthread_t* ids = calloc((size_t)trabajadores, sizeof(pthread_t));
+    nodo_directorio* raiz = calloc(1, sizeof(nodo_directorio));
+    bool memoria = x.pilas != NULL && hilos != NULL && ids != NULL && raiz != NULL;
+    if (memoria)
+    {
+        raiz->ruta = strdup(directorio);
+        raiz->fd = -1;
+        memoria = raiz->ruta != NULL;
+    }
+    for (int i = 0; memoria && i < trabajadores; i++)
+    {
+        hilos[i] = (trabajador_exploracion){&x, i, malloc(TAM_LECTURA_DIRECTORIO)};
+        memoria = hilos[i].buffer != NULL;
+    }
+    if (!memoria)
+    {
+        for (int i = 0; hilos != NULL && i < trabajadores; i++)
+            free(hilos[i].buffer);
+        if (raiz != NULL)
+            free(raiz->ruta);
+        free(raiz);
+        free(ids);
+        free(hilos);
+        free(x.pilas);
+        return -1;
+    }
+
+    for (int i = 0; i < trabajadores; i++)
+        pthread_mutex_init(&x.pilas[i].mutex, NULL);
+    pthread_mutex_init(&x.mutex_trabajo, NULL);
+    pthread_cond_init(&x.hay_trabajo, NULL);
+    pthread_mutex_init(&x.mutex_listos, NULL);
+    pthread_cond_init(&x.hay_listos, NULL);
+
+    entrega e = {manejador, dato, 0, true, NULL, 0};
+    if (!encolar(&x, 0, &raiz, 1))
+    {
+        raiz->error = ENOMEM;
+        raiz->listo = true;
+    }
+
+    // Las señales se atienden en el hilo principal del shell: los trabajadores las tienen bloqueadas
+    sigset_t todas;
+    sigset_t anterior;
+    sigfillset(&todas);
+    pthread_sigmask(SIG_BLOCK, &todas, &anterior);
+    int creados = 0;
+    while (creados < trabajadores && pthread_create(&ids[creados], NULL, trabajar, &hilos[creados]) == 0)
+        creados++;
+    pthread_sigmask(SIG_SETMASK, &anterior, NULL);
+    if (creados == 0)
+        trabajar(&hilos[0]); // Sin hilos, el propio shell recorre todo el árbol antes de entregarlo
+
+    // Este hilo entrega mientras los trabajadores leen; los directorios se liberan a medida que se entregan
+    bool liberado = entregar(&x, &e, raiz);
+    for (int i = 0; i < creados; i++)
+        pthread_join(ids[i], NULL);
+    if (!liberado)
+        liberar_arbol(raiz);
+
+    for (int i = 0; i < trabajadores; i++)
+    {
+        pthread_mutex_destroy(&x.pilas[i].mutex);
+        free(x.pilas[i].nodos);
+        free(hilos[i].buffer);
+    }
+    pthread_mutex_destroy(&x.mutex_trabajo);
+    pthread_cond_destroy(&x.hay_trabajo);
+    pthread_mutex_destroy(&x.mutex_listos);
+    pthread_cond_destroy(&x.hay_listos);
+    free(e.ruta);
+    free(ids);
+    free(hilos);
+    free(x.pilas);
+    return e.entregados;
+}
+
+// Validar un número entero dentro de un rango
+static bool leer_numero(const char* texto, int minimo, int maximo, int* valor)
+{
+    char* fin;
+    long numero = texto != NULL ? strtol(texto, &fin, 10) : 0;
+    if (texto == NULL || *fin != '\0' || numero < minimo || numero > maximo)
+    {
+        return false;
+    }
+    *valor = (int)numero;
+    return true;
+}
+
+// Inicializar las opciones de recorrido de un comando interno
+void explorar_argumentos_inicializar(argumentos_exploracion* a)
+{
+    memset(a, 0, sizeof(*a));
+    a->opciones.profundidad_maxima = -1;
+    a->usar_indice = true;
+}
+
+// Interpretar una opción de recorrido
+bool explorar_argumentos_leer(argumentos_exploracion* a, int argc, char** argv, int* i)
+{
+    opciones_exploracion* o = &a->opciones;
+    const char* opcion = argv[*i];
+    const char* valor = *i + 1 < argc ? argv[*i + 1] : NULL;
+
+    if (strcmp(opcion, "-L") == 0)
+        o->seguir_enlaces = true;
+    else if (strcmp(opcion, "-n") == 0 && !a->reconstruir)
+        a->usar_indice = false;
+    else if (strcmp(opcion, "-r") == 0 && a->usar_indice)
+        a->reconstruir = true;
+    else if ((strcmp(opcion, "-d") == 0 && leer_numero(valor, 0, INT_MAX, &o->profundidad_maxima)) ||
+             (strcmp(opcion, "-j") == 0 && leer_numero(valor, 1, EXPLORAR_MAX_TRABAJADORES, &o->trabajadores)))
+        (*i)++;
+    else if (strcmp(opcion, "-g") == 0 && valor != NULL)
+        o->patron = argv[++(*i)];
+    else if (strcmp(opcion, "-e") == 0 && valor != NULL && valor[0] != '\0' &&
+             o->num_extensiones < EXPLORAR_MAX_EXTENSIONES)
+    {
+        // La extensión es un sufijo con su punto: "json" busca ".json", no cualquier nombre que termine en json
+        snprintf(a->extensiones[o->num_extensiones], sizeof(a->extensiones[0]), "%s%s", valor[0] == '.' ? "" : ".",
+                 valor);
+        o->extensiones[o->num_extensiones] = a->extensiones[o->num_extensiones];
+        o->num_extensiones++;
+        (*i)++;
+    }
+    else
+        return false;
+    return true;
+}
+
+// Buscar la extensión predeterminada si no se indicó ningún filtro
+void explorar_argumentos_completar(argumentos_exploracion* a)
+{
+    if (a->opciones.num_extensiones == 0 && a->opciones.patron == NULL)
+        a->opciones.extensiones[a->opciones.num_extensiones++] = EXPLORAR_EXTENSION_PREDETERMINADA;
+}
+
+// Recorrer un árbol con el índice o, con -n, sin él
+long explorar_argumentos_ejecutar(const argumentos_exploracion* a, const char* directorio,
+                                  manejador_hallazgo manejador, void* dato)
+{
+    if (a->usar_indice)
+        return indice_explorar(directorio, &a->opciones, a->reconstruir, manejador, dato, NULL);
+    return explorar_directorio(directorio, &a->opciones, manejador, dato);
+}
+
+/**
+ * @brief Cómo muestra 'explorar_config' los archivos encontrados
+ */
+typedef struct
+{
+    bool solo_rutas;   /**< Mostrar sólo la ruta de cada archivo */
+    modo_volcado modo; /**< Parte del contenido que se muestra */
+    int lineas;        /**< Líneas que se muestran con VOLCAR_PRIMERAS o VOLCAR_ULTIMAS */
+    int errores;       /**< Directorios y archivos que no se pudieron leer */
+} salida_exploracion;
+
+/**
+ * @brief Paginador al que se dirige la salida estándar
+ */
+typedef struct
+{
+    pid_t pid;                         /**< Proceso del paginador */
+    int salida_original;               /**< Copia de la salida estándar anterior */
+    struct sigaction sigpipe_anterior; /**< Acción de SIGPIPE antes de abrir el paginador */
+} paginador;
+
+// Mostrar el contenido de un archivo encontrado; false si ya no se puede escribir la salida
+static bool mostrar_contenido(const char* ruta, salida_exploracion* s)
+{
+    int fd = open(ruta, O_RDONLY | O_NONBLOCK | O_CLOEXEC); // Abrir una FIFO no debe bloquear al shell
+    struct stat st;
+    if (fd == -1 || fstat(fd, &st) == -1 || !S_ISREG(st.st_mode))
+    {
+        const char* motivo = fd == -1 ? strerror(errno) : "no es un archivo regular";
+        fflush(stdout); // El error aparece después del encabezado del archivo
+        fprintf(stderr, "explorar_config: %s: %s\n", ruta, motivo);
+        if (fd != -1)
+            close(fd);
+        s->errores++;
+        return true;
+    }
+
+    printf("Contenido de %s:\n", ruta);
+    fflush(stdout); // El contenido se escribe directamente en el descriptor, después de lo que ya está en el buffer
+    resultado_volcado resultado = volcar_descriptor(fd, STDOUT_FILENO, s->modo, s->lineas);
+    int error = errno;
+    close(fd);
+    if (resultado == VOLCADO_ERROR_LECTURA)
+    {
+        fprintf(stderr, "explorar_config: %s: %s\n", ruta, strerror(error));
+        s->errores++;
+    }
+    return resultado != VOLCADO_ERROR_ESCRITURA && !ferror(stdout);
+}
+
+// Mostrar un hallazgo de 'explorar_config'; deja de explorar si ya no se puede escribir la salida
+static bool mostrar_hallazgo(const hallazgo* h, void* dato)
+{
+    salida_exploracion* s = dato;
+    if (h->tipo == HALLAZGO_ERROR)
+    {
+        fprintf(stderr, "explorar_config: %s: %s\n", h->ruta, strerror(h->error));
+        s->errores++;
+        return true;
+    }
+    if (h->tipo == HALLAZGO_BUCLE)
+    {
+        fprintf(stderr, "explorar_config: %s: bucle en el sistema de archivos, no se recorre\n", h->ruta);
+        return true;
+    }
+    if (h->tipo == HALLAZGO_DIRECTORIO)
+        return true;
+    if (s->solo_rutas)
+    {
+        printf("%s\n", h->ruta);
+        return !ferror(stdout);
+    }
+    printf("Archivo de configuración encontrado: %s\n", h->ruta);
+    return mostrar_contenido(h->ruta, s);
+}
+
+// Lanzar el paginador y dirigirle la salida estándar; false si no se pudo (la salida no cambia)
+static bool abrir_paginador(paginador* p)
+{
+    const char* variable = getenv("PAGER");
+    char comando[PATH_MAX];
+    char* args[MAX_ARGUMENTOS_PAGINADOR + 1];
+    int num_args = 0;
+    char* resto;
+    snprintf(comando, sizeof(comando), "%s",
+             variable != NULL && variable[0] != '\0' ? variable : EXPLORAR_PAGINADOR_PREDETERMINADO);
+    for (char* palabra = strtok_r(comando, " \t", &resto); palabra != NULL && num_args < MAX_ARGUMENTOS_PAGINADOR;
+         palabra = strtok_r(NULL, " \t", &resto))
+        args[num_args++] = palabra;
+    args[num_args] = NULL;
+    if (num_args == 0)
+        return false;
+
+    int tubo[2];
+    if (pipe2(tubo, O_CLOEXEC) == -1)
+    {
+        perror("explorar_config: error al crear el pipe del paginador");
+        return false;
+    }
+
+    // El paginador lee el teclado: queda en el grupo del shell, que es el que tiene la terminal
+    plan_spawn plan;
+    plan_inicializar(&plan, args);
+    plan.pgid = PLAN_SIN_GRUPO;
+    plan_agregar_dup2(&plan, tubo[0], STDIN_FILENO);
+    fflush(stdout);
+    p->pid = lanzar_plan(&plan);
+    close(tubo[0]);
+    if (p->pid == -1)
+    {
+        close(tubo[1]);
+        return false;
+    }
+
+    p->salida_original = fcntl(STDOUT_FILENO, F_DUPFD_CLOEXEC, 0);
+    bool redirigida = p->salida_original != -1 && dup2(tubo[1], STDOUT_FILENO) != -1;
+    close(tubo[1]); // Sin redirección, el paginador recibe el fin de su entrada y termina
+    if (!redirigida)
+    {
+        perror("explorar_config: error al dirigir la salida al paginador");
+        if (p->salida_original != -1)
+            close(p->salida_original);
+        int estado;
+        esperar_procesos(&p->pid, 1, &estado);
+        return false;
+    }
+
+    // Si el usuario cierra el paginador antes del final, las escrituras fallan con EPIPE y la exploración termina
+    struct sigaction ignorar;
+    memset(&ignorar, 0, sizeof(ignorar));
+    ignorar.sa_handler = SIG_IGN;
+    sigaction(SIGPIPE, &ignorar, &p->sigpipe_anterior);
+    return true;
+}
+
+// Devolver la salida estándar a la terminal y esperar a que el usuario cierre el paginador
+static void cerrar_paginador(paginador* p)
+{
+    fflush(stdout);
+    clearerr(stdout);
+    dup2(p->salida_original, STDOUT_FILENO); // El paginador recibe el fin de su entrada
+    close(p->salida_original);
+    int estado;
+    if (esperar_procesos(&p->pid, 1, &estado))
+    {
+        // Detenido (por ejemplo, con Ctrl+Z): no es un trabajo del shell y nadie podría reanudarlo
+        kill(p->pid, SIGKILL);
+        esperar_procesos(&p->pid, 1, &estado);
+    }
+    sigaction(SIGPIPE, &p->sigpipe_anterior, NULL);
+}
+
+// Comando "explorar_config"
+int manejar_comando_explorar_config(int argc, char** argv)
+{
+    argumentos_exploracion a;
+    const char* directorio = cwd; // Si no se pasa directorio, usar el actual
+    bool paginar = false;
+    salida_exploracion salida = {.modo = VOLCAR_TODO};
+    explorar_argumentos_inicializar(&a);
+
+    // Opciones: terminan en la primera palabra que no empieza con '-' o en "--"
+    int i = 1;
+    for (; i < argc && argv[i][0] == '-'; i++)
+    {
+        if (strcmp(argv[i], "--") == 0)
+        {
+            i++;
+            break;
+        }
+        else if (explorar_argumentos_leer(&a, argc, argv, &i))
+            continue;
+        else if (strcmp(argv[i], "-l") == 0 && salida.modo == VOLCAR_TODO)
+            salida.solo_rutas = true;
+        else if (strcmp(argv[i], "-i") == 0 && !salida.solo_rutas && salida.modo != VOLCAR_ULTIMAS &&
+                 leer_numero(argv[i + 1], 0, INT_MAX, &salida.lineas))
+        {
+            salida.modo = VOLCAR_PRIMERAS;
+            i++;
+        }
+        else if (strcmp(argv[i], "-f") == 0 && !salida.solo_rutas && salida.modo != VOLCAR_PRIMERAS &&
+                 leer_numero(argv[i + 1], 0, INT_MAX, &salida.lineas))
+        {
+            salida.modo = VOLCAR_ULTIMAS;
+            i++;
+        }
+        else if (strcmp(argv[i], "-p") == 0)
+            paginar = true;
+        else
+        {
+            fprintf(stderr, "explorar_config: opción inválida '%s'\n", argv[i]);
+            fprintf(stderr, "Uso: explorar_config [-d N] [-e extensión]... [-g patrón] [-j N] [-L] [-n | -r] "
+                            "[-l | -i N | -f N] [-p] [directorio]\n");
+            return 2;
+        }
+    }
+    if (i < argc)
+        directorio = argv[i++];
+    if (i < argc)
+    {
+        fprintf(stderr, "explorar_config: sobra el argumento '%s'\n", argv[i]);
+        fprintf(stderr, "Uso: explorar_config [-d N] [-e extensión]... [-g patrón] [-j N] [-L] [-n | -r] "
+                        "[-l | -i N | -f N] [-p] [directorio]\n");
+        return 2;
+    }
+    explorar_argumentos_completar(&a);
+
+    paginador p;
+    paginar = paginar && isatty(STDOUT_FILENO) && abrir_paginador(&p);
+
+    if (!salida.solo_rutas)
+    {
+        printf("Explorando el directorio: %s en busca de archivos", directorio);
+        for (int j = 0; j < a.opciones.num_extensiones; j++)
+            printf(" '%s'", a.opciones.extensiones[j]);
+        if (a.opciones.patron != NULL)
+            printf(" '%s'", a.opciones.patron);
+        printf("\n");
+    }
+
+    long encontrados = explorar_argumentos_ejecutar(&a, directorio, mostrar_hallazgo, &salida);
+    if (paginar)
+        cerrar_paginador(&p);
+    fflush(stdout);
+    clearerr(stdout); // Un lector que cerró el pipe no afecta a los comandos siguientes
+    if (encontrados == -1)
+    {
+        fprintf(stderr, "explorar_config: memoria insuficiente\n");
+        return 1;
+    }
+    return salida.errores > 0 ? 1 : 0;
+}
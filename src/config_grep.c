@@ -0,0 +1,463 @@
+/**
+ * @file config_grep.c
+ * @brief Comando interno 'buscar_config': busca un texto en los archivos que encuentra 'explorar_config'.
+ */
+#include "config_grep.h"
+#include "config_explorer.h"
+#include "globals.h"
+#include "simd_search.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**
+ * @brief Elemento de una expresión simple
+ */
+typedef struct
+{
+    char caracter;   /**< Carácter que acepta */
+    bool cualquiera; /**< '.': acepta cualquier carácter */
+    bool repetido;   /**< Seguido de '*': se acepta cero o más veces */
+} atomo_patron;
+
+/**
+ * @brief Texto buscado, literal o expresión simple compilada
+ */
+typedef struct
+{
+    char literal[BUSCAR_MAX_ATOMOS + 1];    /**< Subcadena que contiene toda coincidencia */
+    size_t largo_literal;                   /**< Bytes del literal; 0 si la expresión no tiene ninguno */
+    bool expresion;                         /**< Las líneas con el literal se verifican con los elementos */
+    atomo_patron atomos[BUSCAR_MAX_ATOMOS]; /**< Elementos de la expresión */
+    int num_atomos;                         /**< Elementos */
+    bool ancla_inicio;                      /**< '^': la coincidencia empieza al principio de la línea */
+    bool ancla_fin;                         /**< '$': la coincidencia termina al final de la línea */
+} patron_busqueda;
+
+/**
+ * @brief Archivo a revisar y su resultado
+ */
+typedef struct
+{
+    char* ruta;          /**< Ruta del archivo */
+    char* salida;        /**< Líneas coincidentes, con el formato de salida */
+    size_t largo_salida; /**< Bytes de la salida */
+    long coincidencias;  /**< Líneas coincidentes */
+    int error;           /**< errno si no se pudo leer; 0 si se leyó o no es un archivo regular */
+    bool listo;          /**< Ya se revisó (protegido por el mutex de la búsqueda) */
+} archivo_buscado;
+
+/**
+ * @brief Estado de una búsqueda
+ */
+typedef struct
+{
+    patron_busqueda patron;    /**< Texto buscado */
+    nivel_busqueda nivel;      /**< Juego de instrucciones de los núcleos */
+    archivo_buscado* archivos; /**< Archivos en orden de recorrido */
+    int num_archivos;          /**< Archivos encontrados */
+    int capacidad;             /**< Capacidad del arreglo de archivos */
+    int errores;               /**< Directorios que no se pudieron leer */
+    bool sin_memoria;          /**< Falló una reserva al recolectar los archivos */
+    atomic_int siguiente;      /**< Próximo archivo sin asignar */
+    atomic_bool cancelada;     /**< La salida falló: los archivos restantes no se revisan */
+    pthread_mutex_t mutex;     /**< Protege 'listo' */
+    pthread_cond_t hay_listos; /**< Se terminó de revisar un archivo */
+} busqueda;
+
+// Compilar el texto buscado; con una expresión, extraer su literal más largo. false si la expresión no es válida
+static bool compilar_patron(patron_busqueda* p, const char* texto, bool expresion)
+{
+    memset(p, 0, sizeof(*p));
+    if (strchr(texto, '\n') != NULL)
+        return false; // Las coincidencias son de una línea
+    if (!expresion)
+    {
+        if (strlen(texto) > BUSCAR_MAX_ATOMOS)
+            return false;
+        strcpy(p->literal, texto);
+        p->largo_literal = strlen(texto);
+        return true;
+    }
+
+    p->expresion = true;
+    const char* c = texto;
+    if (*c == '^')
+    {
+        p->ancla_inicio = true;
+        c++;
+    }
+    for (; *c != '\0'; c++)
+    {
+        if (*c == '$' && c[1] == '\0')
+            p->ancla_fin = true;
+        else if (*c == '*' && p->num_atomos > 0 && !p->atomos[p->num_atomos - 1].repetido)
+            p->atomos[p->num_atomos - 1].repetido = true;
+        else if (p->num_atomos == BUSCAR_MAX_ATOMOS || (*c == '\\' && c[1] == '\0'))
+            return false;
+        else
+        {
+            // Un '*' sin elemento anterior es literal, como en las expresiones básicas de POSIX
+            bool escapado = *c == '\\';
+            c += escapado;
+            p->atomos[p->num_atomos++] = (atomo_patron){*c, !escapado && *c == '.', false};
+        }
+    }
+
+    // Literal más largo: la racha más larga de elementos que aceptan un único carácter exactamente una vez
+    for (int i = 0; i < p->num_atomos;)
+    {
+        int fin = i;
+        while (fin < p->num_atomos && !p->atomos[fin].cualquiera && !p->atomos[fin].repetido)
+            fin++;
+        if ((size_t)(fin - i) > p->largo_literal)
+        {
+            p->largo_literal = (size_t)(fin - i);
+            for (int j = i; j < fin; j++)
+                p->literal[j - i] = p->atomos[j].caracter;
+        }
+        i = fin + 1;
+    }
+    return true;
+}
+
+// Verificar si un elemento acepta un carácter
+static bool acepta(const atomo_patron* a, char c)
+{
+    return a->cualquiera || a->caracter == c;
+}
+
+// Verificar si los elementos desde 'a' coinciden con el texto desde 't' hasta 'fin'
+static bool coincide_aqui(const patron_busqueda* p, int a, const char* t, const char* fin)
+{
+    for (; a < p->num_atomos; a++, t++)
+    {
+        const atomo_patron* x = &p->atomos[a];
+        if (x->repetido)
+        {
+            // Probar con cero repeticiones, con una, con dos...
+            do
+            {
+                if (coincide_aqui(p, a + 1, t, fin))
+                    return true;
+            } while (t < fin && acepta(x, *t++));
+            return false;
+        }
+        if (t == fin || !acepta(x, *t))
+            return false;
+    }
+    return !p->ancla_fin || t == fin;
+}
+
+// Verificar si una expresión coincide en alguna posición de una línea
+static bool coincide_linea(const patron_busqueda* p, const char* linea, const char* fin)
+{
+    if (p->ancla_inicio)
+        return coincide_aqui(p, 0, linea, fin);
+    for (const char* t = linea;; t++)
+    {
+        if (coincide_aqui(p, 0, t, fin))
+            return true;
+        if (t == fin)
+            return false;
+    }
+}
+
+// Buscar en el contenido de un archivo y escribir cada línea coincidente; devuelve las coincidencias
+static long buscar_en_contenido(const busqueda* b, const char* ruta, const char* datos, size_t largo, FILE* salida)
+{
+    const patron_busqueda* p = &b->patron;
+    const char* fin = datos + largo;
+    const char* actual = datos;  // Siempre al principio de una línea
+    const char* contado = datos; // Los saltos de línea anteriores ya están en 'numero'
+    size_t numero = 1;
+    long coincidencias = 0;
+    while (actual < fin)
+    {
+        const char* inicio_linea = actual;
+        if (p->largo_literal > 0)
+        {
+            const char* hallado = buscar_subcadena(b->nivel, actual, (size_t)(fin - actual), p->literal,
+                                                   p->largo_literal);
+            if (hallado == NULL)
+                break;
+            const char* salto = memrchr(actual, '\n', (size_t)(hallado - actual));
+            inicio_linea = salto != NULL ? salto + 1 : actual;
+        }
+        const char* fin_linea = memchr(inicio_linea, '\n', (size_t)(fin - inicio_linea));
+        if (fin_linea == NULL)
+            fin_linea = fin;
+
+        if (!p->expresion || coincide_linea(p, inicio_linea, fin_linea))
+        {
+            numero += contar_byte(b->nivel, contado, (size_t)(inicio_linea - contado), '\n');
+            contado = inicio_linea;
+            fprintf(salida, "%s:%zu:", ruta, numero);
+            fwrite(inicio_linea, 1, (size_t)(fin_linea - inicio_linea), salida);
+            fputc('\n', salida);
+            coincidencias++;
+        }
+        if (fin_linea == fin)
+            break;
+        actual = fin_linea + 1;
+    }
+    return coincidencias;
+}
+
+// Leer un archivo regular entero en un buffer que se agranda si hace falta; false si no se pudo (errno indica por
+// qué; 0 si no es un archivo regular)
+static bool leer_archivo(const char* ruta, char** buffer, size_t* capacidad, size_t* largo)
+{
+    int fd = open(ruta, O_RDONLY | O_NONBLOCK | O_CLOEXEC); // Abrir una FIFO no debe bloquear al trabajador
+    if (fd == -1)
+        return false;
+    struct stat st;
+    bool leido = fstat(fd, &st) == 0;
+    if (leido && !S_ISREG(st.st_mode))
+    {
+        errno = 0;
+        leido = false;
+    }
+    size_t tamano = leido ? (size_t)st.st_size : 0;
+    if (leido && tamano > *capacidad)
+    {
+        char* nuevo = realloc(*buffer, tamano);
+        leido = nuevo != NULL;
+        if (leido)
+        {
+            *buffer = nuevo;
+            *capacidad = tamano;
+        }
+    }
+    *largo = 0;
+    while (leido && *largo < tamano)
+    {
+        ssize_t n = pread(fd, *buffer + *largo, tamano - *largo, (off_t)*largo);
+        if (n == -1 && errno == EINTR)
+            continue;
+        leido = n != -1;
+        if (n <= 0)
+            break; // El archivo se acortó: se revisa lo leído
+        *largo += (size_t)n;
+    }
+    int error = errno;
+    close(fd);
+    errno = error;
+    return leido;
+}
+
+// Buscar en un archivo con el buffer de lectura de un trabajador
+static void revisar_archivo(const busqueda* b, archivo_buscado* a, char** buffer, size_t* capacidad)
+{
+    size_t largo;
+    if (!leer_archivo(a->ruta, buffer, capacidad, &largo))
+    {
+        a->error = errno;
+        return;
+    }
+    FILE* salida = open_memstream(&a->salida, &a->largo_salida);
+    if (salida == NULL)
+    {
+        a->error = errno;
+        return;
+    }
+    a->coincidencias = buscar_en_contenido(b, a->ruta, *buffer, largo, salida);
+    if (fclose(salida) != 0)
+        a->error = ENOMEM;
+}
+
+// Hilo trabajador: revisar archivos hasta que no quede ninguno sin asignar
+static void* trabajar(void* arg)
+{
+    busqueda* b = arg;
+    char* buffer = NULL;
+    size_t capacidad = 0;
+    int i;
+    while ((i = atomic_fetch_add(&b->siguiente, 1)) < b->num_archivos)
+    {
+        archivo_buscado* a = &b->archivos[i];
+        if (!atomic_load(&b->cancelada))
+            revisar_archivo(b, a, &buffer, &capacidad);
+
+        pthread_mutex_lock(&b->mutex);
+        a->listo = true;
+        pthread_cond_broadcast(&b->hay_listos);
+        pthread_mutex_unlock(&b->mutex);
+    }
+    free(buffer);
+    return NULL;
+}
+
+// Guardar la ruta de cada archivo encontrado e informar los directorios que no se pudieron leer
+static bool recolectar(const hallazgo* h, void* dato)
+{
+    busqueda* b = dato;
+    if (h->tipo == HALLAZGO_ERROR)
+    {
+        fprintf(stderr, "buscar_config: %s: %s\n", h->ruta, strerror(h->error));
+        b->errores++;
+        return true;
+    }
+    if (h->tipo == HALLAZGO_BUCLE)
+    {
+        fprintf(stderr, "buscar_config: %s: bucle en el sistema de archivos, no se recorre\n", h->ruta);
+        return true;
+    }
+    if (h->tipo != HALLAZGO_ARCHIVO)
+        return true;
+
+    if (b->num_archivos == b->capacidad)
+    {
+        int capacidad = b->capacidad > 0 ? b->capacidad * 2 : 64;
+        archivo_buscado* archivos = realloc(b->archivos, (size_t)capacidad * sizeof(archivo_buscado));
+        if (archivos == NULL)
+        {
+            b->sin_memoria = true;
+            return false;
+        }
+        b->archivos = archivos;
+        b->capacidad = capacidad;
+    }
+    archivo_buscado* a = &b->archivos[b->num_archivos];
+    memset(a, 0, sizeof(*a));
+    a->ruta = strdup(h->ruta);
+    if (a->ruta == NULL)
+    {
+        b->sin_memoria = true;
+        return false;
+    }
+    b->num_archivos++;
+    return true;
+}
+
+// Revisar en paralelo los archivos recolectados y mostrar sus coincidencias en orden; devuelve las coincidencias
+static long revisar_archivos(busqueda* b, int trabajadores)
+{
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    if (trabajadores <= 0)
+        trabajadores = cpus > 0 ? (int)(cpus < EXPLORAR_MAX_TRABAJADORES ? cpus : EXPLORAR_MAX_TRABAJADORES) : 1;
+    if (trabajadores > b->num_archivos)
+        trabajadores = b->num_archivos;
+
+    pthread_t hilos[EXPLORAR_MAX_TRABAJADORES];
+    int lanzados = 0;
+    while (lanzados < trabajadores && pthread_create(&hilos[lanzados], NULL, trabajar, b) == 0)
+        lanzados++;
+    if (lanzados == 0)
+        trabajar(b); // Sin hilos, revisar todo antes de mostrar
+
+    long coincidencias = 0;
+    for (int i = 0; i < b->num_archivos; i++)
+    {
+        archivo_buscado* a = &b->archivos[i];
+        pthread_mutex_lock(&b->mutex);
+        while (!a->listo)
+            pthread_cond_wait(&b->hay_listos, &b->mutex);
+        pthread_mutex_unlock(&b->mutex);
+
+        if (atomic_load(&b->cancelada))
+            continue;
+        if (a->error != 0)
+        {
+            fflush(stdout); // El error aparece entre las coincidencias de los archivos anteriores y siguientes
+            fprintf(stderr, "buscar_config: %s: %s\n", a->ruta, strerror(a->error));
+            b->errores++;
+        }
+        fwrite(a->salida, 1, a->largo_salida, stdout);
+        coincidencias += a->coincidencias;
+        if (ferror(stdout))
+            atomic_store(&b->cancelada, true); // Por ejemplo, el lector cerró el pipe
+    }
+
+    for (int i = 0; i < lanzados; i++)
+        pthread_join(hilos[i], NULL);
+    return coincidencias;
+}
+
+// Comando "buscar_config"
+int manejar_comando_buscar_config(int argc, char** argv)
+{
+    argumentos_exploracion a;
+    bool expresion = false;
+    explorar_argumentos_inicializar(&a);
+
+    // Opciones: terminan en la primera palabra que no empieza con '-' o en "--"
+    int i = 1;
+    for (; i < argc && argv[i][0] == '-'; i++)
+    {
+        if (strcmp(argv[i], "--") == 0)
+        {
+            i++;
+            break;
+        }
+        else if (explorar_argumentos_leer(&a, argc, argv, &i))
+            continue;
+        else if (strcmp(argv[i], "-x") == 0)
+            expresion = true;
+        else
+        {
+            fprintf(stderr, "buscar_config: opción inválida '%s'\n", argv[i]);
+            fprintf(stderr, "Uso: buscar_config [-d N] [-e extensión]... [-g patrón] [-j N] [-L] [-n | -r] [-x] "
+                            "texto [directorio]\n");
+            return 2;
+        }
+    }
+    if (i == argc || argc - i > 2)
+    {
+        fprintf(stderr, i == argc ? "buscar_config: falta el texto a buscar\n" : "buscar_config: sobran argumentos\n");
+        fprintf(stderr, "Uso: buscar_config [-d N] [-e extensión]... [-g patrón] [-j N] [-L] [-n | -r] [-x] "
+                        "texto [directorio]\n");
+        return 2;
+    }
+    const char* texto = argv[i];
+    const char* directorio = i + 1 < argc ? argv[i + 1] : cwd; // Si no se pasa directorio, usar el actual
+    explorar_argumentos_completar(&a);
+
+    busqueda* b = calloc(1, sizeof(busqueda));
+    if (b == NULL)
+    {
+        fprintf(stderr, "buscar_config: memoria insuficiente\n");
+        return 2;
+    }
+    if (!compilar_patron(&b->patron, texto, expresion))
+    {
+        fprintf(stderr, "buscar_config: texto inválido '%s' (una línea, a lo sumo %d elementos)\n", texto,
+                BUSCAR_MAX_ATOMOS);
+        free(b);
+        return 2;
+    }
+    b->nivel = busqueda_nivel_disponible();
+    atomic_init(&b->siguiente, 0);
+    atomic_init(&b->cancelada, false);
+    pthread_mutex_init(&b->mutex, NULL);
+    pthread_cond_init(&b->hay_listos, NULL);
+
+    long coincidencias = 0;
+    if (explorar_argumentos_ejecutar(&a, directorio, recolectar, b) == -1 || b->sin_memoria)
+    {
+        fprintf(stderr, "buscar_config: memoria insuficiente\n");
+        b->errores++;
+    }
+    else
+        coincidencias = revisar_archivos(b, a.opciones.trabajadores);
+    fflush(stdout);
+    clearerr(stdout); // Un lector que cerró el pipe no afecta a los comandos siguientes
+
+    int estado = b->errores > 0 ? 2 : coincidencias > 0 ? 0 : 1;
+    for (int j = 0; j < b->num_archivos; j++)
+    {
+        free(b->archivos[j].ruta);
+        free(b->archivos[j].salida);
+    }
+    free(b->archivos);
+    pthread_mutex_destroy(&b->mutex);
+    pthread_cond_destroy(&b->hay_listos);
+    free(b);
+    return estado;
+}
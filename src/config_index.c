@@ -0,0 +1,1376 @@
+/**
+ * @file config_index.c
+ * @brief Implementación del índice persistente de 'explorar_config'.
+ */
+
+#include "config_index.h"
+#include "event_loop.h"
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+/**
+ *  @brief Comienzo de todo archivo de índice; cambia con el formato
+ */
+#define INDICE_MAGICO "SPINDX01"
+
+/**
+ *  @brief Tamaño máximo de un archivo de índice que se acepta al cargarlo
+ */
+#define INDICE_TAM_MAX (256L * 1024 * 1024)
+
+/**
+ *  @brief Profundidad máxima del árbol que se acepta al cargar un índice
+ */
+#define INDICE_PROFUNDIDAD_MAX 4096
+
+/**
+ *  @brief Avisos de inotify que interesan en cada directorio vigilado
+ */
+#define INDICE_MASCARA_VIGILANCIA                                                                                      \
+    (IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_CLOSE_WRITE | IN_ATTRIB | IN_DELETE_SELF |            \
+     IN_MOVE_SELF | IN_ONLYDIR)
+
+/**
+ *  @brief Base del hash FNV-1a de 64 bits
+ */
+#define FNV_BASE 14695981039346656037ULL
+
+/**
+ *  @brief Primo del hash FNV-1a de 64 bits
+ */
+#define FNV_PRIMO 1099511628211ULL
+
+/**
+ * @brief Archivo del índice que cumple los filtros
+ */
+typedef struct
+{
+    char* nombre;            /**< Nombre dentro del directorio */
+    long long tamano;        /**< Tamaño, o -1 si no se pudo consultar */
+    long long modificado_ns; /**< Última modificación */
+    unsigned long long hash; /**< FNV-1a del contenido; 0 si no es un archivo regular o no se pudo leer */
+} archivo_indice;
+
+typedef struct directorio_indice directorio_indice;
+
+/**
+ * @brief Directorio del índice
+ */
+struct directorio_indice
+{
+    char* nombre;                   /**< Nombre dentro del padre; en la raíz, la cadena vacía */
+    directorio_indice* padre;       /**< Directorio padre, o NULL en la raíz */
+    int profundidad;                /**< Niveles bajo la raíz */
+    unsigned long long dispositivo; /**< Dispositivo del directorio */
+    unsigned long long inodo;       /**< Inodo del directorio */
+    long long modificado_ns;        /**< st_mtim cuando se listó */
+    int error;                      /**< errno si no se pudo abrir o leer */
+    bool bucle;                     /**< Es el mismo directorio que un ancestro: no se recorre */
+    archivo_indice* archivos;       /**< Archivos que cumplen los filtros, ordenados por nombre */
+    int num_archivos;               /**< Archivos */
+    directorio_indice** hijos;      /**< Subdirectorios, ordenados por nombre */
+    int num_hijos;                  /**< Subdirectorios */
+    int vigilancia;                 /**< Descriptor de vigilancia de inotify, o -1 */
+    bool sucio;                     /**< Su lista de entradas pudo cambiar: hay que revisarlo */
+    bool archivos_sucios;           /**< Alguno de sus archivos pudo cambiar */
+    bool pendiente_debajo;          /**< Algún descendiente está sucio */
+};
+
+/**
+ * @brief Directorio al que corresponde un descriptor de vigilancia
+ */
+typedef struct
+{
+    int vigilancia;       /**< Descriptor de vigilancia */
+    directorio_indice* d; /**< Directorio vigilado */
+} vigilancia_indice;
+
+/**
+ * @brief Índice en memoria
+ */
+typedef struct
+{
+    char* clave;                    /**< Directorio real y filtros */
+    char* archivo;                  /**< Ruta del archivo en disco, o NULL si no hay dónde guardarlo */
+    directorio_indice* raiz;        /**< Directorio inicial, o NULL si todavía no se recorrió */
+    long long validado_ns;          /**< Comienzo de la última consulta */
+    int inotify_fd;                 /**< Descriptor de inotify, o -1 si no se vigila */
+    bool en_bucle;                  /**< inotify_fd está registrado en el bucle de eventos */
+    vigilancia_indice* vigilancias; /**< Directorios vigilados, ordenados por descriptor de vigilancia */
+    int num_vigilancias;            /**< Directorios vigilados */
+    bool revisar_todo;              /**< Revalidar todo el árbol por st_mtim en la próxima consulta */
+    bool modificado;                /**< Cambió desde que se cargó o se guardó */
+} indice;
+
+/**
+ * @brief Ruta que se arma al recorrer el índice
+ */
+typedef struct
+{
+    char* texto;      /**< Ruta, terminada en '\0' */
+    size_t largo;     /**< Largo de la ruta */
+    size_t capacidad; /**< Tamaño de texto */
+} ruta_trabajo;
+
+/**
+ * @brief Estado de una consulta
+ */
+typedef struct
+{
+    indice* ix;                           /**< Índice consultado */
+    const opciones_exploracion* opciones; /**< Filtros */
+    long long anterior_ns;                /**< Comienzo de la consulta anterior: lo modificado después es dudoso */
+    resumen_indice* resumen;              /**< Trabajo hecho */
+    bool sin_memoria;                     /**< Faltó memoria: el índice no es confiable */
+} consulta;
+
+/**
+ * @brief Directorio abierto mientras se arma un subárbol a partir de los hallazgos de explorar_directorio()
+ */
+typedef struct
+{
+    directorio_indice* d; /**< Directorio, o NULL si se descartan sus entradas (está dentro de un bucle) */
+    size_t largo;         /**< Largo de su ruta */
+} nivel_construccion;
+
+/**
+ * @brief Estado de la construcción de un subárbol
+ */
+typedef struct
+{
+    consulta* c;                  /**< Consulta */
+    directorio_indice* raiz;      /**< Directorio que recibe el primer hallazgo, o NULL para crear la raíz */
+    nivel_construccion* pila;     /**< Directorios abiertos, desde la raíz */
+    int num_niveles;              /**< Directorios abiertos */
+    ruta_trabajo ruta;            /**< Ruta del último directorio abierto */
+    manejador_hallazgo manejador; /**< Manejador al que se reenvían los hallazgos, o NULL */
+    void* dato;                   /**< Dato del manejador */
+    bool seguir;                  /**< El manejador no pidió terminar */
+} constructor;
+
+/**
+ * @brief Índice en memoria, NULL si no hay
+ */
+static indice* actual = NULL;
+
+// Hora actual en nanosegundos
+static long long ahora_ns(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_REALTIME, &t);
+    return (long long)t.tv_sec * 1000000000LL + t.tv_nsec;
+}
+
+// Tiempo de modificación de un stat en nanosegundos
+static long long modificacion_ns(const struct stat* st)
+{
+    return (long long)st->st_mtim.tv_sec * 1000000000LL + st->st_mtim.tv_nsec;
+}
+
+// Una modificación tan cercana a la consulta anterior que su st_mtim no alcanza para descartar otra posterior
+static bool dudoso(const consulta* c, long long modificado_ns)
+{
+    return modificado_ns >= c->anterior_ns - INDICE_MARGEN_DUDOSO_NS;
+}
+
+// Agrandar un arreglo que empezó vacío antes de agregarle un elemento; se realoja al llegar a cada potencia de dos
+static bool agrandar(void** arreglo, int cantidad, size_t tam)
+{
+    if (cantidad >= 4 && (cantidad & (cantidad - 1)) != 0)
+        return true;
+    void* nuevo = realloc(*arreglo, (size_t)(cantidad < 4 ? 4 : cantidad * 2) * tam);
+    if (nuevo == NULL)
+        return false;
+    *arreglo = nuevo;
+    return true;
+}
+
+// Agregar un nombre a la ruta; guarda el largo anterior para volver con ruta_salir()
+static bool ruta_entrar(ruta_trabajo* r, const char* nombre, size_t* anterior)
+{
+    size_t largo = strlen(nombre);
+    if (r->largo + largo + 2 > r->capacidad)
+    {
+        size_t nueva = (r->largo + largo + 2) * 2;
+        char* texto = realloc(r->texto, nueva);
+        if (texto == NULL)
+            return false;
+        r->texto = texto;
+        r->capacidad = nueva;
+    }
+    *anterior = r->largo;
+    if (r->largo == 0 || r->texto[r->largo - 1] != '/')
+        r->texto[r->largo++] = '/'; // La misma regla que explorar_directorio(), así las rutas coinciden
+    memcpy(r->texto + r->largo, nombre, largo + 1);
+    r->largo += largo;
+    return true;
+}
+
+// Volver a la ruta anterior a ruta_entrar()
+static void ruta_salir(ruta_trabajo* r, size_t anterior)
+{
+    r->largo = anterior;
+    r->texto[anterior] = '\0';
+}
+
+// Reemplazar la ruta
+static bool ruta_fijar(ruta_trabajo* r, const char* texto)
+{
+    size_t largo = strlen(texto);
+    if (largo + 1 > r->capacidad)
+    {
+        char* nuevo = realloc(r->texto, largo + 1);
+        if (nuevo == NULL)
+            return false;
+        r->texto = nuevo;
+        r->capacidad = largo + 1;
+    }
+    memcpy(r->texto, texto, largo + 1);
+    r->largo = largo;
+    return true;
+}
+
+// Hash FNV-1a de un texto
+static unsigned long long hash_texto(const char* texto)
+{
+    unsigned long long hash = FNV_BASE;
+    for (const unsigned char* p = (const unsigned char*)texto; *p != '\0'; p++)
+        hash = (hash ^ *p) * FNV_PRIMO;
+    return hash;
+}
+
+// Leer tamaño, modificación y hash del contenido de un archivo, con los datos del mismo descriptor
+static void leer_archivo(int dir_fd, const char* nombre, archivo_indice* a)
+{
+    a->tamano = -1;
+    a->modificado_ns = 0;
+    a->hash = 0;
+    int fd = openat(dir_fd, nombre, O_RDONLY | O_CLOEXEC | O_NOCTTY | O_NONBLOCK); // Un FIFO no bloquea
+    if (fd == -1)
+        return;
+    struct stat st;
+    if (fstat(fd, &st) == 0)
+    {
+        a->tamano = st.st_size;
+        a->modificado_ns = modificacion_ns(&st);
+    }
+    if (a->tamano >= 0 && S_ISREG(st.st_mode))
+    {
+        char bloque[16384];
+        unsigned long long hash = FNV_BASE;
+        ssize_t leidos;
+        while ((leidos = read(fd, bloque, sizeof(bloque))) > 0)
+        {
+            for (ssize_t i = 0; i < leidos; i++)
+                hash = (hash ^ (unsigned char)bloque[i]) * FNV_PRIMO;
+        }
+        a->hash = leidos == 0 ? hash : 0;
+    }
+    close(fd);
+}
+
+// Marcar un directorio para revisarlo y avisar a sus ancestros
+static void marcar_sucio(directorio_indice* d, bool solo_archivos)
+{
+    if (solo_archivos)
+        d->archivos_sucios = true;
+    else
+        d->sucio = true;
+    for (directorio_indice* a = d->padre; a != NULL && !a->pendiente_debajo; a = a->padre)
+        a->pendiente_debajo = true;
+}
+
+// Posición de un descriptor de vigilancia en la tabla, o de donde habría que insertarlo
+static int buscar_vigilancia(const indice* ix, int vigilancia)
+{
+    int desde = 0;
+    int hasta = ix->num_vigilancias;
+    while (desde < hasta)
+    {
+        int medio = (desde + hasta) / 2;
+        if (ix->vigilancias[medio].vigilancia < vigilancia)
+            desde = medio + 1;
+        else
+            hasta = medio;
+    }
+    return desde;
+}
+
+// Dejar de vigilar un directorio
+static void olvidar_vigilancia(indice* ix, directorio_indice* d)
+{
+    if (d->vigilancia == -1)
+        return;
+    int i = buscar_vigilancia(ix, d->vigilancia);
+    if (i < ix->num_vigilancias && ix->vigilancias[i].d == d)
+    {
+        memmove(&ix->vigilancias[i], &ix->vigilancias[i + 1],
+                (size_t)(ix->num_vigilancias - i - 1) * sizeof(vigilancia_indice));
+        ix->num_vigilancias--;
+    }
+    if (ix->inotify_fd != -1)
+        inotify_rm_watch(ix->inotify_fd, d->vigilancia);
+    d->vigilancia = -1;
+}
+
+// Olvidar los descriptores de vigilancia de un subárbol
+static void olvidar_subarbol(directorio_indice* d)
+{
+    d->vigilancia = -1;
+    for (int i = 0; i < d->num_hijos; i++)
+        olvidar_subarbol(d->hijos[i]);
+}
+
+// Renunciar a inotify: desde ahora el índice se revalida por st_mtim en cada consulta
+static void dejar_de_vigilar(indice* ix)
+{
+    if (ix->inotify_fd == -1)
+        return;
+    if (ix->en_bucle)
+        eventos_quitar_fd(ix->inotify_fd);
+    close(ix->inotify_fd);
+    ix->inotify_fd = -1;
+    ix->en_bucle = false;
+    free(ix->vigilancias);
+    ix->vigilancias = NULL;
+    ix->num_vigilancias = 0;
+    if (ix->raiz != NULL)
+        olvidar_subarbol(ix->raiz);
+    ix->revisar_todo = true;
+}
+
+// Vigilar un directorio; si inotify no puede (límite de vigilancias, un mismo directorio por dos rutas), renunciar
+static void vigilar(consulta* c, directorio_indice* d, const char* ruta)
+{
+    indice* ix = c->ix;
+    if (ix->inotify_fd == -1 || d->vigilancia != -1 || d->bucle || d->error != 0)
+        return;
+    uint32_t mascara = INDICE_MASCARA_VIGILANCIA;
+    if (d->padre != NULL && !c->opciones->seguir_enlaces)
+        mascara |= IN_DONT_FOLLOW;
+    int vigilancia = inotify_add_watch(ix->inotify_fd, ruta, mascara);
+    if (vigilancia == -1 && errno == ENOENT)
+    {
+        marcar_sucio(d->padre != NULL ? d->padre : d, false); // Ya no está: lo quitará la revisión del padre
+        return;
+    }
+    int i = vigilancia != -1 ? buscar_vigilancia(ix, vigilancia) : 0;
+    bool repetida = vigilancia != -1 && i < ix->num_vigilancias && ix->vigilancias[i].vigilancia == vigilancia;
+    if (vigilancia == -1 || repetida ||
+        !agrandar((void**)&ix->vigilancias, ix->num_vigilancias, sizeof(vigilancia_indice)))
+    {
+        dejar_de_vigilar(ix);
+        return;
+    }
+    memmove(&ix->vigilancias[i + 1], &ix->vigilancias[i],
+            (size_t)(ix->num_vigilancias - i) * sizeof(vigilancia_indice));
+    ix->vigilancias[i] = (vigilancia_indice){vigilancia, d};
+    ix->num_vigilancias++;
+    d->vigilancia = vigilancia;
+}
+
+// Consumir los avisos de inotify pendientes y marcar los directorios afectados
+static void leer_avisos(indice* ix)
+{
+    char avisos[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+    ssize_t n;
+    while (ix->inotify_fd != -1 && (n = read(ix->inotify_fd, avisos, sizeof(avisos))) > 0)
+    {
+        for (char* p = avisos; p < avisos + n;)
+        {
+            const struct inotify_event* aviso = (const struct inotify_event*)p;
+            p += sizeof(struct inotify_event) + aviso->len;
+            if (aviso->mask & IN_Q_OVERFLOW)
+            {
+                ix->revisar_todo = true; // Se perdieron avisos
+                continue;
+            }
+            int i = buscar_vigilancia(ix, aviso->wd);
+            if (i == ix->num_vigilancias || ix->vigilancias[i].vigilancia != aviso->wd)
+                continue;
+            directorio_indice* d = ix->vigilancias[i].d;
+            if (aviso->mask & IN_IGNORED)
+            {
+                memmove(&ix->vigilancias[i], &ix->vigilancias[i + 1],
+                        (size_t)(ix->num_vigilancias - i - 1) * sizeof(vigilancia_indice));
+                ix->num_vigilancias--;
+                d->vigilancia = -1;
+                marcar_sucio(d, false); // La revisión lo vuelve a vigilar, o lo quita si ya no existe
+            }
+            else if (aviso->mask & (IN_DELETE_SELF | IN_MOVE_SELF))
+                marcar_sucio(d->padre != NULL ? d->padre : d, false);
+            else if (aviso->mask & (IN_CLOSE_WRITE | IN_ATTRIB))
+            {
+                if (aviso->len > 0 && !(aviso->mask & IN_ISDIR))
+                    marcar_sucio(d, true);
+            }
+            else
+                marcar_sucio(d, false);
+        }
+    }
+}
+
+// Atender los avisos de inotify desde el bucle de eventos
+static void al_avisar_inotify(int fd __attribute__((unused)), uint32_t eventos __attribute__((unused)),
+                              void* dato __attribute__((unused)))
+{
+    if (actual != NULL)
+        leer_avisos(actual);
+}
+
+// Liberar los archivos y subdirectorios de un directorio
+static void vaciar_directorio(indice* ix, directorio_indice* d);
+
+// Liberar un directorio y su subárbol
+static void liberar_directorio(indice* ix, directorio_indice* d)
+{
+    vaciar_directorio(ix, d);
+    olvidar_vigilancia(ix, d);
+    free(d->nombre);
+    free(d);
+}
+
+// Liberar los archivos y subdirectorios de un directorio
+static void vaciar_directorio(indice* ix, directorio_indice* d)
+{
+    for (int i = 0; i < d->num_hijos; i++)
+        liberar_directorio(ix, d->hijos[i]);
+    for (int i = 0; i < d->num_archivos; i++)
+        free(d->archivos[i].nombre);
+    free(d->hijos);
+    free(d->archivos);
+    d->hijos = NULL;
+    d->archivos = NULL;
+    d->num_hijos = 0;
+    d->num_archivos = 0;
+}
+
+// Crear un directorio del índice
+static directorio_indice* crear_directorio(directorio_indice* padre, const char* nombre)
+{
+    directorio_indice* d = calloc(1, sizeof(directorio_indice));
+    if (d == NULL)
+        return NULL;
+    d->nombre = strdup(nombre);
+    if (d->nombre == NULL)
+    {
+        free(d);
+        return NULL;
+    }
+    d->padre = padre;
+    d->profundidad = padre != NULL ? padre->profundidad + 1 : 0;
+    d->vigilancia = -1;
+    return d;
+}
+
+// Un directorio es el mismo que alguno de sus ancestros
+static bool es_bucle(const directorio_indice* padre, unsigned long long dispositivo, unsigned long long inodo)
+{
+    for (const directorio_indice* a = padre; a != NULL; a = a->padre)
+    {
+        if (!a->bucle && a->error == 0 && a->dispositivo == dispositivo && a->inodo == inodo)
+            return true;
+    }
+    return false;
+}
+
+// Nombre de una ruta si es una entrada directa del directorio de otra ruta, o NULL
+static const char* nombre_hijo(const ruta_trabajo* directorio, const char* ruta)
+{
+    if (strncmp(ruta, directorio->texto, directorio->largo) != 0)
+        return NULL;
+    const char* nombre = ruta + directorio->largo;
+    if (directorio->largo == 0 || directorio->texto[directorio->largo - 1] != '/')
+    {
+        if (*nombre != '/')
+            return NULL;
+        nombre++;
+    }
+    return *nombre != '\0' && strchr(nombre, '/') == NULL ? nombre : NULL;
+}
+
+// Registrar un directorio nuevo (leído, con error o bucle) en el subárbol en construcción
+static bool registrar_directorio(constructor* k, directorio_indice* padre, bool descartar, hallazgo* h)
+{
+    directorio_indice* d = NULL;
+    if (!descartar && k->num_niveles == 0 && k->raiz != NULL)
+        d = k->raiz;
+    else if (!descartar)
+    {
+        const char* nombre = k->num_niveles > 0 ? nombre_hijo(&k->ruta, h->ruta) : "";
+        if (padre != NULL && !agrandar((void**)&padre->hijos, padre->num_hijos, sizeof(directorio_indice*)))
+            return false;
+        d = crear_directorio(padre, nombre);
+        if (d == NULL)
+            return false;
+        if (padre != NULL)
+            padre->hijos[padre->num_hijos++] = d;
+        else
+            k->raiz = k->c->ix->raiz = d;
+    }
+    if (!agrandar((void**)&k->pila, k->num_niveles, sizeof(nivel_construccion)) || !ruta_fijar(&k->ruta, h->ruta))
+        return false;
+    k->pila[k->num_niveles++] = (nivel_construccion){d, k->ruta.largo};
+    if (d == NULL)
+        return true;
+
+    k->c->resumen->releidos++;
+    d->error = h->tipo == HALLAZGO_ERROR ? h->error : 0;
+    d->bucle = h->tipo == HALLAZGO_BUCLE;
+    d->dispositivo = h->dispositivo;
+    d->inodo = h->inodo;
+    d->modificado_ns = h->modificado_ns;
+    if (h->tipo == HALLAZGO_DIRECTORIO && es_bucle(d->padre, d->dispositivo, d->inodo))
+    {
+        // Un enlace hacia un ancestro de fuera del subárbol: explorar_directorio() no lo conocía
+        d->bucle = true;
+        h->tipo = HALLAZGO_BUCLE;
+        k->pila[k->num_niveles - 1].d = NULL;
+    }
+    if (d->bucle || d->error != 0)
+    {
+        marcar_sucio(d, false); // Se vuelven a comprobar en cada consulta
+        return true;
+    }
+
+    // La vigilancia empieza después de la lectura: lo que cambió entretanto se revisa en la próxima consulta
+    vigilar(k->c, d, h->ruta);
+    struct stat st;
+    int seguir = d->padre == NULL || k->c->opciones->seguir_enlaces ? 0 : AT_SYMLINK_NOFOLLOW;
+    if (fstatat(AT_FDCWD, h->ruta, &st, seguir) == -1 || modificacion_ns(&st) != d->modificado_ns ||
+        d->modificado_ns >= ahora_ns() - INDICE_MARGEN_DUDOSO_NS)
+        marcar_sucio(d, false);
+    return true;
+}
+
+// Registrar un hallazgo de explorar_directorio() en el subárbol en construcción; false si no hay memoria
+static bool registrar(constructor* k, hallazgo* h)
+{
+    // El directorio del hallazgo es el último abierto que lo contiene; los demás ya se entregaron completos
+    bool mismo = k->num_niveles > 0 && strcmp(h->ruta, k->ruta.texto) == 0;
+    while (!mismo && k->num_niveles > 0 && nombre_hijo(&k->ruta, h->ruta) == NULL)
+    {
+        k->num_niveles--;
+        if (k->num_niveles > 0)
+            ruta_salir(&k->ruta, k->pila[k->num_niveles - 1].largo);
+    }
+    if (k->num_niveles == 0 && (k->ruta.largo > 0 || h->tipo == HALLAZGO_ARCHIVO))
+        return false; // Un hallazgo fuera del subárbol: no debería pasar
+    directorio_indice* padre = k->num_niveles > 0 ? k->pila[k->num_niveles - 1].d : NULL;
+    bool descartar = k->num_niveles > 0 && padre == NULL;
+
+    if (h->tipo == HALLAZGO_ERROR && mismo)
+    {
+        // El directorio se abrió pero no se pudo leer entero
+        if (padre != NULL)
+        {
+            padre->error = h->error;
+            marcar_sucio(padre, false);
+        }
+        return true;
+    }
+    if (h->tipo != HALLAZGO_ARCHIVO)
+        return registrar_directorio(k, padre, descartar, h);
+    if (descartar)
+        return true;
+
+    archivo_indice a;
+    leer_archivo(AT_FDCWD, h->ruta, &a);
+    a.nombre = strdup(nombre_hijo(&k->ruta, h->ruta));
+    if (a.nombre == NULL || !agrandar((void**)&padre->archivos, padre->num_archivos, sizeof(archivo_indice)))
+    {
+        free(a.nombre);
+        return false;
+    }
+    padre->archivos[padre->num_archivos++] = a;
+    h->tamano = a.tamano;
+    h->modificado_ns = a.modificado_ns;
+    h->hash = a.hash;
+    return true;
+}
+
+// Manejador de explorar_directorio() que arma el subárbol y, si hay, reenvía los hallazgos al del llamador
+static bool construir(const hallazgo* h, void* dato)
+{
+    constructor* k = dato;
+    hallazgo copia = *h;
+    if (!k->c->sin_memoria && !registrar(k, &copia))
+        k->c->sin_memoria = true;
+    if (k->manejador == NULL)
+        return !k->c->sin_memoria;
+    k->seguir = k->manejador(&copia, k->dato);
+    return k->seguir;
+}
+
+// Recorrer un subárbol con explorar_directorio() para armarlo, reenviando los hallazgos si hay manejador
+static long construir_subarbol(consulta* c, directorio_indice* raiz, const char* ruta, manejador_hallazgo manejador,
+                               void* dato, bool* completo)
+{
+    opciones_exploracion o = *c->opciones;
+    if (raiz != NULL && o.profundidad_maxima >= 0)
+        o.profundidad_maxima -= raiz->profundidad;
+    constructor k = {c, raiz, NULL, 0, {NULL, 0, 0}, manejador, dato, true};
+    long entregados = explorar_directorio(ruta, &o, construir, &k);
+    if (entregados == -1)
+        c->sin_memoria = true;
+    free(k.pila);
+    free(k.ruta.texto);
+    c->ix->modificado = true;
+    *completo = k.seguir;
+    return entregados;
+}
+
+// Volver a recorrer un subárbol completo
+static void reconstruir(consulta* c, directorio_indice* d, const ruta_trabajo* r)
+{
+    vaciar_directorio(c->ix, d);
+    olvidar_vigilancia(c->ix, d); // Si el directorio se reemplazó, la vigilancia es del anterior
+    d->error = 0;
+    d->bucle = false;
+    bool completo;
+    construir_subarbol(c, d, r->texto, NULL, NULL, &completo);
+}
+
+// Comparar dos nombres para qsort()
+static int comparar_nombres(const void* a, const void* b)
+{
+    return strcmp(*(char* const*)a, *(char* const*)b);
+}
+
+// Agregar un nombre a una lista; false si no hay memoria
+static bool agregar_nombre(char*** nombres, int* cantidad, const char* nombre)
+{
+    char* copia = strdup(nombre);
+    if (copia == NULL || !agrandar((void**)nombres, *cantidad, sizeof(char*)))
+    {
+        free(copia);
+        return false;
+    }
+    (*nombres)[(*cantidad)++] = copia;
+    return true;
+}
+
+// Leer las entradas de un directorio que cumplen los filtros, ordenadas; false si no se pudo
+static bool listar(consulta* c, const directorio_indice* d, int fd, char*** archivos, int* num_archivos,
+                   char*** directorios, int* num_directorios)
+{
+    const opciones_exploracion* o = c->opciones;
+    bool descender = o->profundidad_maxima < 0 || d->profundidad < o->profundidad_maxima;
+    DIR* dir = fdopendir(fd);
+    if (dir == NULL)
+    {
+        close(fd);
+        return false;
+    }
+    bool ok = true;
+    struct dirent* e;
+    errno = 0;
+    while (ok && (e = readdir(dir)) != NULL)
+    {
+        const char* nombre = e->d_name;
+        if (nombre[0] == '.' && (nombre[1] == '\0' || (nombre[1] == '.' && nombre[2] == '\0')))
+            continue;
+        if (explorar_es_directorio(dirfd(dir), nombre, e->d_type, o->seguir_enlaces))
+            ok = !descender || agregar_nombre(directorios, num_directorios, nombre);
+        else if (explorar_cumple_filtros(o, nombre))
+            ok = agregar_nombre(archivos, num_archivos, nombre);
+    }
+    ok = ok && errno == 0;
+    closedir(dir);
+    if (*num_archivos > 1)
+        qsort(*archivos, (size_t)*num_archivos, sizeof(char*), comparar_nombres);
+    if (*num_directorios > 1)
+        qsort(*directorios, (size_t)*num_directorios, sizeof(char*), comparar_nombres);
+    return ok;
+}
+
+// Volver a listar un directorio cuya lista de entradas cambió; los subdirectorios nuevos se recorren completos
+static void releer(consulta* c, directorio_indice* d, ruta_trabajo* r)
+{
+    int seguir = d->padre == NULL || c->opciones->seguir_enlaces ? 0 : O_NOFOLLOW;
+    int fd = open(r->texto, O_RDONLY | O_DIRECTORY | O_CLOEXEC | seguir);
+    int dir_fd = -1;
+    struct stat st;
+    char** nombres = NULL;
+    char** subdirectorios = NULL;
+    int num_nombres = 0;
+    int num_subdirectorios = 0;
+    archivo_indice* archivos = NULL;
+    directorio_indice** hijos = NULL;
+    bool* nuevos = NULL;
+    bool ok = fd != -1 && fstat(fd, &st) == 0 && (dir_fd = fcntl(fd, F_DUPFD_CLOEXEC, 0)) != -1;
+    if (ok)
+        ok = listar(c, d, fd, &nombres, &num_nombres, &subdirectorios, &num_subdirectorios); // Cierra fd
+    else if (fd != -1)
+        close(fd);
+    if (ok && num_nombres > 0)
+        ok = (archivos = calloc((size_t)num_nombres, sizeof(archivo_indice))) != NULL;
+    if (ok && num_subdirectorios > 0)
+        ok = (hijos = calloc((size_t)num_subdirectorios, sizeof(directorio_indice*))) != NULL &&
+             (nuevos = calloc((size_t)num_subdirectorios, sizeof(bool))) != NULL;
+    if (!ok)
+    {
+        for (int i = 0; i < num_nombres; i++)
+            free(nombres[i]);
+        for (int i = 0; i < num_subdirectorios; i++)
+            free(subdirectorios[i]);
+        free(nombres);
+        free(subdirectorios);
+        free(archivos);
+        free(hijos);
+        if (dir_fd != -1)
+            close(dir_fd);
+        reconstruir(c, d, r); // Ya no se puede leer: el recorrido registra el error
+        return;
+    }
+    c->resumen->releidos++;
+
+    // Los archivos que siguen igual conservan su hash; los demás se vuelven a leer. Las dos listas están ordenadas
+    int j = 0;
+    for (int i = 0; i < num_nombres; i++)
+    {
+        while (j < d->num_archivos && strcmp(d->archivos[j].nombre, nombres[i]) < 0)
+            j++;
+        const archivo_indice* viejo =
+            j < d->num_archivos && strcmp(d->archivos[j].nombre, nombres[i]) == 0 ? &d->archivos[j] : NULL;
+        struct stat actual_st;
+        if (viejo != NULL && fstatat(dir_fd, nombres[i], &actual_st, 0) == 0 && actual_st.st_size == viejo->tamano &&
+            modificacion_ns(&actual_st) == viejo->modificado_ns && !dudoso(c, viejo->modificado_ns))
+            archivos[i] = *viejo;
+        else
+            leer_archivo(dir_fd, nombres[i], &archivos[i]);
+        archivos[i].nombre = nombres[i];
+    }
+    close(dir_fd);
+
+    // Los subdirectorios que siguen se conservan; los que desaparecieron se liberan
+    j = 0;
+    for (int i = 0; i < num_subdirectorios; i++)
+    {
+        while (j < d->num_hijos && strcmp(d->hijos[j]->nombre, subdirectorios[i]) < 0)
+            liberar_directorio(c->ix, d->hijos[j++]);
+        if (j < d->num_hijos && strcmp(d->hijos[j]->nombre, subdirectorios[i]) == 0)
+            hijos[i] = d->hijos[j++];
+        else
+        {
+            hijos[i] = crear_directorio(d, subdirectorios[i]);
+            nuevos[i] = true;
+        }
+        c->sin_memoria = c->sin_memoria || hijos[i] == NULL;
+    }
+    while (j < d->num_hijos)
+        liberar_directorio(c->ix, d->hijos[j++]);
+
+    // Un subdirectorio que no se pudo crear por falta de memoria se omite: el índice se descarta al terminar
+    int num_hijos = 0;
+    for (int i = 0; i < num_subdirectorios; i++)
+    {
+        if (hijos[i] != NULL)
+        {
+            nuevos[num_hijos] = nuevos[i];
+            hijos[num_hijos++] = hijos[i];
+        }
+        free(subdirectorios[i]);
+    }
+    for (int i = 0; i < d->num_archivos; i++)
+        free(d->archivos[i].nombre);
+    free(d->archivos);
+    free(d->hijos);
+    d->archivos = archivos;
+    d->num_archivos = num_nombres;
+    d->hijos = hijos;
+    d->num_hijos = num_hijos;
+    d->modificado_ns = modificacion_ns(&st);
+    free(nombres);
+    free(subdirectorios);
+    c->ix->modificado = true;
+
+    // Los subdirectorios nuevos se recorren completos
+    for (int i = 0; i < num_hijos && !c->sin_memoria; i++)
+    {
+        size_t anterior;
+        if (!nuevos[i])
+            continue;
+        if (!ruta_entrar(r, hijos[i]->nombre, &anterior))
+        {
+            c->sin_memoria = true;
+            break;
+        }
+        reconstruir(c, hijos[i], r);
+        ruta_salir(r, anterior);
+    }
+    free(nuevos);
+}
+
+// Revisar los archivos de un directorio cuya lista de entradas no cambió; los modificados se vuelven a leer
+static void revisar_archivos(consulta* c, directorio_indice* d, const ruta_trabajo* r)
+{
+    if (d->num_archivos == 0)
+        return;
+    int fd = open(r->texto, O_PATH | O_DIRECTORY | O_CLOEXEC);
+    if (fd == -1)
+    {
+        marcar_sucio(d, false);
+        return;
+    }
+    for (int i = 0; i < d->num_archivos; i++)
+    {
+        archivo_indice* a = &d->archivos[i];
+        struct stat st;
+        if (fstatat(fd, a->nombre, &st, 0) == 0 && st.st_size == a->tamano &&
+            modificacion_ns(&st) == a->modificado_ns && !dudoso(c, a->modificado_ns))
+            continue;
+        char* nombre = a->nombre;
+        leer_archivo(fd, nombre, a);
+        a->nombre = nombre;
+        c->ix->modificado = true;
+    }
+    close(fd);
+}
+
+// Comprobar un directorio contra el sistema de archivos: recorrerlo de nuevo, volver a listarlo o revisar sus archivos
+static void revisar(consulta* c, directorio_indice* d, ruta_trabajo* r, bool profundo)
+{
+    // La vigilancia empieza antes de la comprobación, así no se pierde un cambio posterior
+    vigilar(c, d, r->texto);
+    c->resumen->revisados++;
+    struct stat st;
+    int seguir = d->padre == NULL || c->opciones->seguir_enlaces ? 0 : AT_SYMLINK_NOFOLLOW;
+    bool existe = fstatat(AT_FDCWD, r->texto, &st, seguir) == 0 && S_ISDIR(st.st_mode);
+    if (existe && es_bucle(d->padre, st.st_dev, st.st_ino))
+    {
+        if (!d->bucle)
+        {
+            vaciar_directorio(c->ix, d);
+            olvidar_vigilancia(c->ix, d);
+            d->bucle = true;
+            c->ix->modificado = true;
+        }
+        marcar_sucio(d, false);
+        return;
+    }
+    if (!existe || d->error != 0 || d->bucle || st.st_dev != d->dispositivo || st.st_ino != d->inodo)
+    {
+        reconstruir(c, d, r);
+        return;
+    }
+    if (modificacion_ns(&st) != d->modificado_ns || dudoso(c, d->modificado_ns))
+        releer(c, d, r);
+    else
+        revisar_archivos(c, d, r);
+
+    for (int i = 0; profundo && i < d->num_hijos && !c->sin_memoria; i++)
+    {
+        size_t anterior;
+        if (!ruta_entrar(r, d->hijos[i]->nombre, &anterior))
+        {
+            c->sin_memoria = true;
+            break;
+        }
+        revisar(c, d->hijos[i], r, true);
+        ruta_salir(r, anterior);
+    }
+}
+
+// Revisar sólo los directorios que inotify marcó
+static void revisar_marcados(consulta* c, directorio_indice* d, ruta_trabajo* r)
+{
+    bool sucio = d->sucio;
+    bool archivos = d->archivos_sucios;
+    bool debajo = d->pendiente_debajo;
+    d->sucio = false;
+    d->archivos_sucios = false;
+    d->pendiente_debajo = false;
+    if (sucio)
+        revisar(c, d, r, false);
+    else if (archivos)
+        revisar_archivos(c, d, r);
+
+    for (int i = 0; debajo && i < d->num_hijos && !c->sin_memoria; i++)
+    {
+        size_t anterior;
+        if (!d->hijos[i]->sucio && !d->hijos[i]->archivos_sucios && !d->hijos[i]->pendiente_debajo)
+            continue;
+        if (!ruta_entrar(r, d->hijos[i]->nombre, &anterior))
+        {
+            c->sin_memoria = true;
+            break;
+        }
+        revisar_marcados(c, d->hijos[i], r);
+        ruta_salir(r, anterior);
+    }
+}
+
+// Entregar desde el índice los hallazgos de un directorio, en el mismo orden que explorar_directorio()
+static bool entregar(consulta* c, const directorio_indice* d, ruta_trabajo* r, manejador_hallazgo manejador, void* dato,
+                     long* entregados)
+{
+    hallazgo h = {HALLAZGO_DIRECTORIO, r->texto, d->error, 0, d->modificado_ns, d->dispositivo, d->inodo, 0};
+    if (d->bucle)
+        h.tipo = HALLAZGO_BUCLE;
+    else if (d->error != 0)
+        h.tipo = HALLAZGO_ERROR;
+    if (!manejador(&h, dato))
+        return false;
+
+    // Archivos y subdirectorios se intercalan por nombre, como las entradas de explorar_directorio()
+    int i = 0;
+    int j = 0;
+    while (i < d->num_archivos || j < d->num_hijos)
+    {
+        bool archivo =
+            j == d->num_hijos || (i < d->num_archivos && strcmp(d->archivos[i].nombre, d->hijos[j]->nombre) < 0);
+        size_t anterior;
+        if (!ruta_entrar(r, archivo ? d->archivos[i].nombre : d->hijos[j]->nombre, &anterior))
+        {
+            c->sin_memoria = true;
+            return false;
+        }
+        bool seguir;
+        if (archivo)
+        {
+            const archivo_indice* a = &d->archivos[i++];
+            hallazgo f = {HALLAZGO_ARCHIVO, r->texto, 0, a->tamano, a->modificado_ns, 0, 0, a->hash};
+            (*entregados)++;
+            seguir = manejador(&f, dato);
+        }
+        else
+            seguir = entregar(c, d->hijos[j++], r, manejador, dato, entregados);
+        ruta_salir(r, anterior);
+        if (!seguir)
+            return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Buffer en el que se serializa un índice
+ */
+typedef struct
+{
+    char* datos;      /**< Bytes escritos */
+    size_t largo;     /**< Bytes escritos */
+    size_t capacidad; /**< Tamaño de datos */
+    bool ok;          /**< No faltó memoria */
+} buffer_indice;
+
+/**
+ * @brief Lector de un índice serializado
+ */
+typedef struct
+{
+    const char* p; /**< Próximo byte */
+    size_t resto;  /**< Bytes que quedan */
+    bool ok;       /**< Los datos leídos son válidos */
+} lector_indice;
+
+// Agregar bytes al buffer
+static void escribir_bytes(buffer_indice* b, const void* datos, size_t largo)
+{
+    if (!b->ok)
+        return;
+    if (b->largo + largo > b->capacidad)
+    {
+        size_t nueva = (b->largo + largo) * 2;
+        char* nuevos = realloc(b->datos, nueva);
+        if (nuevos == NULL)
+        {
+            b->ok = false;
+            return;
+        }
+        b->datos = nuevos;
+        b->capacidad = nueva;
+    }
+    memcpy(b->datos + b->largo, datos, largo);
+    b->largo += largo;
+}
+
+// Agregar un texto precedido por su largo
+static void escribir_texto(buffer_indice* b, const char* texto)
+{
+    uint32_t largo = (uint32_t)strlen(texto);
+    escribir_bytes(b, &largo, sizeof(largo));
+    escribir_bytes(b, texto, largo);
+}
+
+// Serializar un directorio y su subárbol, en preorden
+static void escribir_directorio(buffer_indice* b, const directorio_indice* d)
+{
+    int32_t error = d->error;
+    uint8_t bucle = d->bucle;
+    uint32_t num_archivos = (uint32_t)d->num_archivos;
+    uint32_t num_hijos = (uint32_t)d->num_hijos;
+    escribir_texto(b, d->nombre);
+    escribir_bytes(b, &error, sizeof(error));
+    escribir_bytes(b, &bucle, sizeof(bucle));
+    escribir_bytes(b, &d->dispositivo, sizeof(d->dispositivo));
+    escribir_bytes(b, &d->inodo, sizeof(d->inodo));
+    escribir_bytes(b, &d->modificado_ns, sizeof(d->modificado_ns));
+    escribir_bytes(b, &num_archivos, sizeof(num_archivos));
+    for (int i = 0; i < d->num_archivos; i++)
+    {
+        escribir_texto(b, d->archivos[i].nombre);
+        escribir_bytes(b, &d->archivos[i].tamano, sizeof(d->archivos[i].tamano));
+        escribir_bytes(b, &d->archivos[i].modificado_ns, sizeof(d->archivos[i].modificado_ns));
+        escribir_bytes(b, &d->archivos[i].hash, sizeof(d->archivos[i].hash));
+    }
+    escribir_bytes(b, &num_hijos, sizeof(num_hijos));
+    for (int i = 0; i < d->num_hijos; i++)
+        escribir_directorio(b, d->hijos[i]);
+}
+
+// Leer bytes del índice serializado
+static void leer_bytes(lector_indice* l, void* destino, size_t largo)
+{
+    if (!l->ok || largo > l->resto)
+    {
+        l->ok = false;
+        memset(destino, 0, largo);
+        return;
+    }
+    memcpy(destino, l->p, largo);
+    l->p += largo;
+    l->resto -= largo;
+}
+
+// Leer un nombre precedido por su largo; NULL si no es válido o no hay memoria
+static char* leer_nombre(lector_indice* l, bool vacio)
+{
+    uint32_t largo;
+    leer_bytes(l, &largo, sizeof(largo));
+    if (!l->ok || largo > l->resto || largo > NAME_MAX || (largo == 0 && !vacio) ||
+        memchr(l->p, '/', largo) != NULL || memchr(l->p, '\0', largo) != NULL)
+    {
+        l->ok = false;
+        return NULL;
+    }
+    char* nombre = strndup(l->p, largo);
+    l->p += largo;
+    l->resto -= largo;
+    l->ok = nombre != NULL;
+    return nombre;
+}
+
+// Leer un directorio y su subárbol; las entradas deben estar ordenadas, como las deja el recorrido
+static directorio_indice* leer_directorio_indice(indice* ix, lector_indice* l, directorio_indice* padre)
+{
+    char* nombre = leer_nombre(l, padre == NULL);
+    directorio_indice* d = nombre != NULL ? crear_directorio(padre, nombre) : NULL;
+    free(nombre);
+    if (d == NULL || d->profundidad > INDICE_PROFUNDIDAD_MAX)
+    {
+        l->ok = false;
+        if (d != NULL)
+            free(d->nombre);
+        free(d);
+        return NULL;
+    }
+    int32_t error;
+    uint8_t bucle;
+    uint32_t cantidad;
+    leer_bytes(l, &error, sizeof(error));
+    leer_bytes(l, &bucle, sizeof(bucle));
+    leer_bytes(l, &d->dispositivo, sizeof(d->dispositivo));
+    leer_bytes(l, &d->inodo, sizeof(d->inodo));
+    leer_bytes(l, &d->modificado_ns, sizeof(d->modificado_ns));
+    leer_bytes(l, &cantidad, sizeof(cantidad));
+    d->error = error;
+    d->bucle = bucle != 0;
+    if (l->ok && cantidad > 0 && cantidad <= l->resto / 29) // Cada archivo ocupa al menos 29 bytes
+        l->ok = (d->archivos = calloc(cantidad, sizeof(archivo_indice))) != NULL;
+    else if (cantidad > 0)
+        l->ok = false;
+    for (uint32_t i = 0; l->ok && i < cantidad; i++)
+    {
+        archivo_indice* a = &d->archivos[d->num_archivos];
+        a->nombre = leer_nombre(l, false);
+        if (a->nombre == NULL)
+            break;
+        d->num_archivos++;
+        leer_bytes(l, &a->tamano, sizeof(a->tamano));
+        leer_bytes(l, &a->modificado_ns, sizeof(a->modificado_ns));
+        leer_bytes(l, &a->hash, sizeof(a->hash));
+        l->ok = l->ok && (i == 0 || strcmp(d->archivos[i - 1].nombre, a->nombre) < 0);
+    }
+    leer_bytes(l, &cantidad, sizeof(cantidad));
+    if (l->ok && cantidad > 0 && cantidad <= l->resto / 42) // Cada subdirectorio ocupa al menos 42 bytes
+        l->ok = (d->hijos = calloc(cantidad, sizeof(directorio_indice*))) != NULL;
+    else if (cantidad > 0)
+        l->ok = false;
+    for (uint32_t i = 0; l->ok && i < cantidad; i++)
+    {
+        directorio_indice* h = leer_directorio_indice(ix, l, d);
+        if (h == NULL)
+            break;
+        d->hijos[d->num_hijos++] = h;
+        l->ok = l->ok && (i == 0 || strcmp(d->hijos[i - 1]->nombre, h->nombre) < 0);
+    }
+    if (!l->ok)
+    {
+        liberar_directorio(ix, d);
+        return NULL;
+    }
+    return d;
+}
+
+// Cargar el índice del disco; NULL si no existe, no es de esta clave o no es válido
+static directorio_indice* cargar(indice* ix)
+{
+    int fd = ix->archivo != NULL ? open(ix->archivo, O_RDONLY | O_CLOEXEC) : -1;
+    if (fd == -1)
+        return NULL;
+    struct stat st;
+    char* datos = NULL;
+    ssize_t leidos = -1;
+    if (fstat(fd, &st) == 0 && st.st_size < INDICE_TAM_MAX && (datos = malloc((size_t)st.st_size + 1)) != NULL)
+        leidos = read(fd, datos, (size_t)st.st_size);
+    close(fd);
+    if (datos == NULL || leidos != st.st_size)
+    {
+        free(datos);
+        return NULL;
+    }
+
+    lector_indice l = {datos, (size_t)leidos, true};
+    char magico[sizeof(INDICE_MAGICO) - 1];
+    uint32_t largo_clave;
+    leer_bytes(&l, magico, sizeof(magico));
+    leer_bytes(&l, &largo_clave, sizeof(largo_clave));
+    bool propio = l.ok && memcmp(magico, INDICE_MAGICO, sizeof(magico)) == 0 && largo_clave == strlen(ix->clave) &&
+                  largo_clave <= l.resto && memcmp(l.p, ix->clave, largo_clave) == 0;
+    directorio_indice* raiz = NULL;
+    if (propio)
+    {
+        l.p += largo_clave;
+        l.resto -= largo_clave;
+        leer_bytes(&l, &ix->validado_ns, sizeof(ix->validado_ns));
+        raiz = l.ok ? leer_directorio_indice(ix, &l, NULL) : NULL;
+        if (raiz != NULL && l.resto != 0)
+        {
+            liberar_directorio(ix, raiz);
+            raiz = NULL;
+        }
+    }
+    free(datos);
+    return raiz;
+}
+
+// Escribir todo el buffer en un descriptor
+static bool escribir_todo(int fd, const char* datos, size_t largo)
+{
+    while (largo > 0)
+    {
+        ssize_t n = write(fd, datos, largo);
+        if (n == -1 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return false;
+        datos += n;
+        largo -= (size_t)n;
+    }
+    return true;
+}
+
+// Guardar el índice si cambió: temporal en el mismo directorio y rename(), sin fsync() porque es una caché
+static void guardar(indice* ix)
+{
+    if (!ix->modificado || ix->archivo == NULL || ix->raiz == NULL)
+        return;
+    buffer_indice b = {NULL, 0, 0, true};
+    uint32_t largo_clave = (uint32_t)strlen(ix->clave);
+    escribir_bytes(&b, INDICE_MAGICO, sizeof(INDICE_MAGICO) - 1);
+    escribir_bytes(&b, &largo_clave, sizeof(largo_clave));
+    escribir_bytes(&b, ix->clave, largo_clave);
+    escribir_bytes(&b, &ix->validado_ns, sizeof(ix->validado_ns));
+    escribir_directorio(&b, ix->raiz);
+
+    char temporal[PATH_MAX + 8];
+    snprintf(temporal, sizeof(temporal), "%s.XXXXXX", ix->archivo);
+    int fd = b.ok ? mkostemp(temporal, O_CLOEXEC) : -1;
+    if (fd != -1)
+    {
+        bool ok = escribir_todo(fd, b.datos, b.largo);
+        ok = close(fd) == 0 && ok;
+        if (!ok || rename(temporal, ix->archivo) == -1)
+            unlink(temporal);
+        else
+            ix->modificado = false;
+    }
+    free(b.datos);
+}
+
+// Ruta del archivo de un índice, creando el directorio de los índices si hace falta; NULL si no hay dónde
+static char* ruta_archivo(const char* clave)
+{
+    char directorio[PATH_MAX];
+    const char* indicado = getenv(INDICE_ENV);
+    const char* cache = getenv("XDG_CACHE_HOME");
+    const char* home = getenv("HOME");
+    if (indicado != NULL && indicado[0] != '\0')
+        snprintf(directorio, sizeof(directorio), "%s", indicado);
+    else if (cache != NULL && cache[0] == '/')
+        snprintf(directorio, sizeof(directorio), "%s/ShellProject", cache);
+    else if (home != NULL && home[0] != '\0')
+        snprintf(directorio, sizeof(directorio), "%s/.cache/ShellProject", home);
+    else
+        return NULL;
+
+    // Crear los directorios que falten, de arriba hacia abajo
+    for (char* barra = strchr(directorio + 1, '/'); barra != NULL; barra = strchr(barra + 1, '/'))
+    {
+        *barra = '\0';
+        mkdir(directorio, 0700);
+        *barra = '/';
+    }
+    if (mkdir(directorio, 0700) == -1 && errno != EEXIST)
+        return NULL;
+
+    char* archivo = malloc(strlen(directorio) + 22);
+    if (archivo != NULL)
+        sprintf(archivo, "%s/%016llx.idx", directorio, hash_texto(clave));
+    return archivo;
+}
+
+// Clave de un índice: directorio real y filtros; NULL si no hay memoria
+static char* armar_clave(const char* real, const opciones_exploracion* o)
+{
+    size_t largo = strlen(real) + 64 + (o->patron != NULL ? strlen(o->patron) : 0);
+    for (int i = 0; i < o->num_extensiones; i++)
+        largo += strlen(o->extensiones[i]) + 4;
+    char* clave = malloc(largo);
+    if (clave == NULL)
+        return NULL;
+    int n = snprintf(clave, largo, "%s\n-d %d%s", real, o->profundidad_maxima, o->seguir_enlaces ? "\n-L" : "");
+    if (o->patron != NULL)
+        n += snprintf(clave + n, largo - (size_t)n, "\n-g %s", o->patron);
+    for (int i = 0; i < o->num_extensiones; i++)
+        n += snprintf(clave + n, largo - (size_t)n, "\n-e %s", o->extensiones[i]);
+    return clave;
+}
+
+// Crear el índice en memoria de una clave, vigilado con inotify si se puede
+static indice* crear_indice(char* clave)
+{
+    indice* ix = calloc(1, sizeof(indice));
+    if (ix == NULL)
+        return NULL;
+    ix->clave = clave;
+    ix->archivo = ruta_archivo(clave);
+    ix->inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (ix->inotify_fd != -1)
+        ix->en_bucle = eventos_agregar_fd(ix->inotify_fd, EPOLLIN, al_avisar_inotify, NULL) == 0;
+    ix->revisar_todo = true;
+    return ix;
+}
+
+// Consultar el índice
+long indice_explorar(const char* directorio, const opciones_exploracion* opciones, bool reconstruir_todo,
+                     manejador_hallazgo manejador, void* dato, resumen_indice* resumen)
+{
+    resumen_indice propio;
+    if (resumen == NULL)
+        resumen = &propio;
+    memset(resumen, 0, sizeof(*resumen));
+
+    // Sin directorio real no hay índice: el recorrido informa el error
+    char real[PATH_MAX];
+    if (realpath(directorio, real) == NULL)
+        return explorar_directorio(directorio, opciones, manejador, dato);
+    char* clave = armar_clave(real, opciones);
+    if (clave == NULL)
+        return -1;
+    if (actual != NULL && (reconstruir_todo || strcmp(actual->clave, clave) != 0))
+        indice_liberar();
+    if (actual == NULL)
+    {
+        actual = crear_indice(clave);
+        if (actual == NULL)
+        {
+            free(clave);
+            return explorar_directorio(directorio, opciones, manejador, dato);
+        }
+        if (reconstruir_todo && actual->archivo != NULL)
+            unlink(actual->archivo);
+        else
+            actual->raiz = cargar(actual);
+        resumen->desde_disco = actual->raiz != NULL;
+    }
+    else
+        free(clave);
+
+    indice* ix = actual;
+    consulta c = {ix, opciones, ix->validado_ns, resumen, false};
+    ix->validado_ns = ahora_ns();
+    if (ix->raiz == NULL)
+    {
+        // Primer recorrido: los hallazgos se entregan a medida que llegan mientras se arma el índice
+        resumen->reconstruido = true;
+        bool completo;
+        long entregados = construir_subarbol(&c, NULL, directorio, manejador, dato, &completo);
+        if (entregados == -1 || c.sin_memoria || !completo)
+        {
+            indice_liberar(); // Incompleto: no sirve para la próxima consulta
+            return entregados;
+        }
+        ix->revisar_todo = ix->inotify_fd == -1;
+        guardar(ix);
+        return entregados;
+    }
+
+    // Índice en memoria: revisar lo que cambió y entregar desde la memoria
+    leer_avisos(ix);
+    ruta_trabajo r = {NULL, 0, 0};
+    long entregados = 0;
+    if (ruta_fijar(&r, directorio))
+    {
+        if (ix->revisar_todo)
+            revisar(&c, ix->raiz, &r, true);
+        else
+            revisar_marcados(&c, ix->raiz, &r);
+        ix->revisar_todo = ix->revisar_todo && (c.sin_memoria || ix->inotify_fd == -1);
+    }
+    else
+        c.sin_memoria = true;
+    if (!c.sin_memoria)
+    {
+        guardar(ix);
+        entregar(&c, ix->raiz, &r, manejador, dato, &entregados);
+    }
+    free(r.texto);
+    if (c.sin_memoria)
+    {
+        indice_liberar();
+        return entregados == 0 ? explorar_directorio(directorio, opciones, manejador, dato) : -1;
+    }
+    return entregados;
+}
+
+// Liberar el índice en memoria
+void indice_liberar(void)
+{
+    if (actual == NULL)
+        return;
+    if (actual->en_bucle)
+        eventos_quitar_fd(actual->inotify_fd);
+    if (actual->inotify_fd != -1)
+        close(actual->inotify_fd);
+    actual->inotify_fd = -1;
+    if (actual->raiz != NULL)
+        liberar_directorio(actual, actual->raiz);
+    free(actual->vigilancias);
+    free(actual->clave);
+    free(actual->archivo);
+    free(actual);
+    actual = NULL;
+}
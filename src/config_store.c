@@ -0,0 +1,470 @@
+/**
+ * @file config_store.c
+ * @brief Implementación de la configuración en memoria y de su escritura atómica.
+ */
+
+#include "config_store.h"
+#include "event_loop.h"
+#include "globals.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**
+ *  @brief Tamaño máximo del archivo de configuración
+ */
+#define CONFIG_TAM_MAX (1024 * 1024)
+
+/**
+ * @brief Métricas de la configuración predeterminada
+ */
+static const char* const metricas_predeterminadas[] = {"First_Fit",    "Best_Fit",     "Worst_Fit",
+                                                        "cpu_usage",    "memory_usage", "network_usage"};
+
+/**
+ * @brief Configuración en memoria, NULL si no se cargó
+ */
+static cJSON* configuracion = NULL;
+
+/**
+ * @brief Ruta absoluta del archivo
+ */
+static char ruta_config[PATH_MAX];
+
+/**
+ * @brief La configuración en memoria tiene cambios que no se escribieron
+ */
+static bool modificada = false;
+
+/**
+ * @brief Descriptor de inotify que vigila el directorio del archivo, -1 si no hay
+ */
+static int inotify_fd = -1;
+
+/**
+ * @brief El descriptor de inotify está registrado en el bucle de eventos
+ */
+static bool vigilada_en_bucle = false;
+
+/**
+ * @brief Identidad del archivo tal como lo dejó la última escritura propia, para ignorar su propio aviso
+ */
+static struct stat escrito;
+
+/**
+ * @brief Manejador de los cambios externos, o NULL
+ */
+static manejador_configuracion al_cambiar = NULL;
+
+// Nombre del archivo dentro de su directorio
+static const char* nombre_archivo(void)
+{
+    const char* barra = strrchr(ruta_config, '/');
+    return barra != NULL ? barra + 1 : ruta_config;
+}
+
+// Resolver la ruta del archivo: SHELL_CONFIG o la predeterminada, relativa al directorio actual
+static bool resolver_ruta(void)
+{
+    const char* ruta = getenv(CONFIG_ENV);
+    if (ruta == NULL || *ruta == '\0')
+        ruta = CONFIG_RUTA_PREDETERMINADA;
+    if (ruta[0] == '/')
+        return (size_t)snprintf(ruta_config, sizeof(ruta_config), "%s", ruta) < sizeof(ruta_config);
+
+    char directorio[PATH_MAX];
+    if (getcwd(directorio, sizeof(directorio)) == NULL)
+        return false;
+    return (size_t)snprintf(ruta_config, sizeof(ruta_config), "%s/%s", directorio, ruta) < sizeof(ruta_config);
+}
+
+// Crear la configuración predeterminada
+static cJSON* configuracion_predeterminada(void)
+{
+    cJSON* raiz = cJSON_CreateObject();
+    cJSON* metricas = cJSON_CreateArray();
+    if (raiz == NULL || metricas == NULL)
+    {
+        cJSON_Delete(raiz);
+        cJSON_Delete(metricas);
+        return NULL;
+    }
+    cJSON_AddNumberToObject(raiz, "sampling_interval", intervalo);
+    for (size_t i = 0; i < sizeof(metricas_predeterminadas) / sizeof(metricas_predeterminadas[0]); i++)
+        cJSON_AddItemToArray(metricas, cJSON_CreateString(metricas_predeterminadas[i]));
+    cJSON_AddItemToObject(raiz, "metrics", metricas);
+    return raiz;
+}
+
+// Leer y analizar el archivo; devuelve NULL si no existe o no es un objeto JSON
+static cJSON* leer_archivo(bool* existe)
+{
+    int fd = open(ruta_config, O_RDONLY | O_CLOEXEC);
+    *existe = fd != -1 || errno != ENOENT;
+    if (fd == -1)
+        return NULL;
+
+    struct stat st;
+    char* texto = NULL;
+    ssize_t leidos = -1;
+    if (fstat(fd, &st) == 0 && st.st_size < CONFIG_TAM_MAX && (texto = malloc((size_t)st.st_size + 1)) != NULL)
+    {
+        leidos = read(fd, texto, (size_t)st.st_size);
+    }
+    close(fd);
+    if (leidos < 0)
+    {
+        free(texto);
+        return NULL;
+    }
+    texto[leidos] = '\0';
+
+    cJSON* raiz = cJSON_Parse(texto);
+    free(texto);
+    if (!cJSON_IsObject(raiz))
+    {
+        cJSON_Delete(raiz);
+        return NULL;
+    }
+    return raiz;
+}
+
+// Escribir todo el texto en un descriptor
+static bool escribir_todo(int fd, const char* texto, size_t largo)
+{
+    while (largo > 0)
+    {
+        ssize_t n = write(fd, texto, largo);
+        if (n == -1 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return false;
+        texto += n;
+        largo -= (size_t)n;
+    }
+    return true;
+}
+
+// Reemplazar el archivo de forma atómica: temporal en el mismo directorio, fsync() y rename()
+static bool escribir_atomico(const char* texto)
+{
+    char temporal[PATH_MAX + 8];
+    snprintf(temporal, sizeof(temporal), "%s.XXXXXX", ruta_config);
+    int fd = mkostemp(temporal, O_CLOEXEC);
+    if (fd == -1)
+        return false;
+
+    // El temporal nace con permisos 0600: conservar los del archivo que reemplaza
+    struct stat anterior;
+    fchmod(fd, stat(ruta_config, &anterior) == 0 ? anterior.st_mode & 07777 : 0644);
+
+    bool ok = escribir_todo(fd, texto, strlen(texto)) && escribir_todo(fd, "\n", 1) && fsync(fd) == 0;
+    ok = close(fd) == 0 && ok;
+    if (!ok || rename(temporal, ruta_config) == -1)
+    {
+        int error = errno;
+        unlink(temporal);
+        errno = error;
+        return false;
+    }
+
+    // Sincronizar también el directorio, para que el rename() sobreviva a un corte
+    char directorio[PATH_MAX];
+    snprintf(directorio, sizeof(directorio), "%.*s", (int)(nombre_archivo() - ruta_config), ruta_config);
+    int dir = open(directorio[0] != '\0' ? directorio : ".", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dir != -1)
+    {
+        fsync(dir);
+        close(dir);
+    }
+    if (stat(ruta_config, &escrito) == -1)
+        memset(&escrito, 0, sizeof(escrito));
+    return true;
+}
+
+// Volver a leer el archivo si lo modificó otro programa
+static void recargar_si_cambio(void)
+{
+    struct stat st;
+    if (stat(ruta_config, &st) == -1)
+        return; // Borrado: se conserva la configuración en memoria
+    if (st.st_ino == escrito.st_ino && st.st_dev == escrito.st_dev && st.st_size == escrito.st_size &&
+        st.st_mtim.tv_sec == escrito.st_mtim.tv_sec && st.st_mtim.tv_nsec == escrito.st_mtim.tv_nsec)
+        return; // Es la última escritura propia
+
+    bool existe;
+    cJSON* nueva = leer_archivo(&existe);
+    escrito = st;
+    if (nueva == NULL)
+    {
+        fprintf(stderr, "Aviso: %s no es JSON válido; se conserva la configuración anterior\n", ruta_config);
+        return;
+    }
+    bool igual = cJSON_Compare(nueva, configuracion, true);
+    cJSON_Delete(configuracion);
+    configuracion = nueva;
+    modificada = false;
+    if (!igual && al_cambiar != NULL)
+        al_cambiar();
+}
+
+// Consumir los avisos de inotify pendientes y recargar si alguno se refiere al archivo
+static void revisar_cambios(void)
+{
+    if (inotify_fd == -1)
+        return;
+    char avisos[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+    bool cambio = false;
+    ssize_t n;
+    while ((n = read(inotify_fd, avisos, sizeof(avisos))) > 0)
+    {
+        for (char* p = avisos; p < avisos + n;)
+        {
+            const struct inotify_event* aviso = (const struct inotify_event*)p;
+            if (aviso->len > 0 && strcmp(aviso->name, nombre_archivo()) == 0)
+                cambio = true;
+            p += sizeof(struct inotify_event) + aviso->len;
+        }
+    }
+    if (cambio)
+        recargar_si_cambio();
+}
+
+// Atender los avisos de inotify desde el bucle de eventos
+static void al_avisar_inotify(int fd __attribute__((unused)), uint32_t eventos __attribute__((unused)),
+                              void* dato __attribute__((unused)))
+{
+    revisar_cambios();
+}
+
+// Vigilar el directorio del archivo: los editores suelen reemplazarlo con rename(), cambiando su inodo
+static void crear_vigilancia(void)
+{
+    inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotify_fd == -1)
+        return;
+    char directorio[PATH_MAX];
+    snprintf(directorio, sizeof(directorio), "%.*s", (int)(nombre_archivo() - ruta_config), ruta_config);
+    if (inotify_add_watch(inotify_fd, directorio, IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE) == -1)
+    {
+        close(inotify_fd);
+        inotify_fd = -1;
+        return;
+    }
+    vigilada_en_bucle = eventos_agregar_fd(inotify_fd, EPOLLIN, al_avisar_inotify, NULL) == 0;
+}
+
+// Fijar la ruta del archivo
+bool config_preparar(void)
+{
+    return ruta_config[0] != '\0' || resolver_ruta();
+}
+
+// Cargar la configuración
+bool config_cargar(void)
+{
+    if (configuracion != NULL)
+        return true;
+    if (!config_preparar())
+    {
+        fprintf(stderr, "No se pudo resolver la ruta del archivo de configuración\n");
+        return false;
+    }
+
+    bool existe;
+    configuracion = leer_archivo(&existe);
+    if (configuracion == NULL)
+    {
+        if (existe)
+            fprintf(stderr, "Aviso: %s no se pudo leer; se usa la configuración predeterminada\n", ruta_config);
+        configuracion = configuracion_predeterminada();
+        if (configuracion == NULL)
+            return false;
+        modificada = !existe; // Un archivo ilegible no se reemplaza: puede tener cambios del usuario
+        if (modificada)
+            config_guardar();
+    }
+    if (stat(ruta_config, &escrito) == -1)
+        memset(&escrito, 0, sizeof(escrito));
+    crear_vigilancia();
+    return true;
+}
+
+// Ruta del archivo
+const char* config_ruta(void)
+{
+    return configuracion != NULL ? ruta_config : "";
+}
+
+// Valor de una clave
+const cJSON* config_obtener(const char* clave)
+{
+    if (!config_cargar())
+        return NULL;
+    if (!vigilada_en_bucle)
+        revisar_cambios(); // Sin bucle de eventos, los avisos se revisan al leer
+    return cJSON_GetObjectItemCaseSensitive(configuracion, clave);
+}
+
+// Intervalo de muestreo
+int config_intervalo(void)
+{
+    const cJSON* valor = config_obtener("sampling_interval");
+    return cJSON_IsNumber(valor) ? valor->valueint : intervalo;
+}
+
+// Métricas configuradas
+int config_metricas(const char** nombres, int max)
+{
+    const cJSON* lista = config_obtener("metrics");
+    const cJSON* elemento;
+    int n = 0;
+    cJSON_ArrayForEach(elemento, lista)
+    {
+        if (cJSON_IsString(elemento) && n < max)
+            nombres[n++] = elemento->valuestring;
+    }
+    return n;
+}
+
+// Reemplazar el valor de una clave
+int config_establecer(const char* clave, cJSON* valor)
+{
+    if (valor == NULL || !config_cargar())
+    {
+        cJSON_Delete(valor);
+        return -1;
+    }
+    cJSON* actual = cJSON_GetObjectItemCaseSensitive(configuracion, clave);
+    if (actual != NULL && cJSON_Compare(actual, valor, true))
+    {
+        cJSON_Delete(valor);
+        return 0;
+    }
+    if (actual != NULL)
+        cJSON_ReplaceItemInObject(configuracion, clave, valor);
+    else
+        cJSON_AddItemToObject(configuracion, clave, valor);
+    modificada = true;
+    return 1;
+}
+
+// Posición de un valor en una lista, o -1
+static int buscar_en_lista(const cJSON* lista, const cJSON* valor)
+{
+    int i = 0;
+    const cJSON* elemento;
+    cJSON_ArrayForEach(elemento, lista)
+    {
+        if (cJSON_Compare(elemento, valor, true))
+            return i;
+        i++;
+    }
+    return -1;
+}
+
+// Aplicar una operación de update_config
+int config_aplicar(const char* operacion, const char* clave, const char* valor)
+{
+    bool quitar = strcmp(operacion, "remove") == 0;
+    if ((strcmp(operacion, "set") != 0 && strcmp(operacion, "add") != 0 && !quitar) || (valor == NULL && !quitar))
+    {
+        fprintf(stderr, "update_config: operación inválida '%s'\n", operacion);
+        return -1;
+    }
+    if (!config_cargar())
+        return -1;
+    if (valor == NULL)
+    {
+        if (cJSON_GetObjectItemCaseSensitive(configuracion, clave) == NULL)
+            return 0;
+        cJSON_DeleteItemFromObject(configuracion, clave);
+        modificada = true;
+        return 1;
+    }
+
+    // El valor se interpreta como JSON si lo es (números, listas, comillas) y si no, como texto
+    cJSON* nuevo = cJSON_Parse(valor);
+    if (nuevo == NULL)
+        nuevo = cJSON_CreateString(valor);
+    if (strcmp(operacion, "set") == 0)
+        return config_establecer(clave, nuevo);
+
+    cJSON* lista = cJSON_GetObjectItemCaseSensitive(configuracion, clave);
+    if (lista != NULL && !cJSON_IsArray(lista))
+    {
+        fprintf(stderr, "update_config: '%s' no es una lista\n", clave);
+        cJSON_Delete(nuevo);
+        return -1;
+    }
+    int posicion = buscar_en_lista(lista, nuevo);
+    int resultado = 0;
+    if (quitar && posicion != -1)
+    {
+        cJSON_DeleteItemFromArray(lista, posicion);
+        resultado = 1;
+    }
+    else if (!quitar && posicion == -1)
+    {
+        if (lista == NULL)
+            lista = cJSON_AddArrayToObject(configuracion, clave);
+        cJSON_AddItemToArray(lista, nuevo);
+        nuevo = NULL;
+        resultado = 1;
+    }
+    cJSON_Delete(nuevo);
+    modificada = modificada || resultado == 1;
+    return resultado;
+}
+
+// Escribir la configuración si cambió
+int config_guardar(void)
+{
+    if (configuracion == NULL || !modificada)
+        return 0;
+    char* texto = cJSON_Print(configuracion);
+    if (texto == NULL || !escribir_atomico(texto))
+    {
+        fprintf(stderr, "No se pudo escribir %s: %s\n", ruta_config, texto != NULL ? strerror(errno) : "sin memoria");
+        cJSON_free(texto);
+        return -1;
+    }
+    cJSON_free(texto);
+    modificada = false;
+    return 0;
+}
+
+// Serializar la configuración
+char* config_serializar(void)
+{
+    return config_cargar() ? cJSON_PrintUnformatted(configuracion) : NULL;
+}
+
+// Registrar el manejador de cambios externos
+void config_al_cambiar(manejador_configuracion manejador)
+{
+    al_cambiar = manejador;
+}
+
+// Liberar la configuración
+void config_liberar(void)
+{
+    if (inotify_fd != -1)
+    {
+        if (vigilada_en_bucle)
+            eventos_quitar_fd(inotify_fd);
+        close(inotify_fd);
+        inotify_fd = -1;
+    }
+    vigilada_en_bucle = false;
+    cJSON_Delete(configuracion);
+    configuracion = NULL;
+    modificada = false;
+    ruta_config[0] = '\0';
+}
@@ -0,0 +1,801 @@
+/**
+ * @file core_utils.c
+ * @brief Implementación de las versiones internas de cat, wc, head, tail y test.
+ */
+
+#include "core_utils.h"
+#include "file_stream.h"
+#include "simd_search.h"
+#include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**
+ * @brief Opciones de wc, head y tail ya analizadas.
+ */
+typedef struct
+{
+    bool contar_lineas; /**< wc -l */
+    bool contar_bytes;  /**< wc -c */
+    long lineas;        /**< head y tail -n */
+    int primer_archivo; /**< Índice del primer operando en argv */
+} opciones_utilidad;
+
+/**
+ * @brief Estado de la evaluación de una expresión de test.
+ */
+typedef struct
+{
+    char** argv; /**< Argumentos de test */
+    int argc;    /**< Cantidad de argumentos */
+    int pos;     /**< Próximo argumento a leer */
+    bool error;  /**< La expresión es inválida (el error ya se informó) */
+} evaluacion_test;
+
+// Verificar que coreutils mostraría el nombre tal cual, sin comillas ni escapes
+static bool nombre_sin_comillas(const char* nombre)
+{
+    if (nombre[0] == '\0')
+        return false;
+    for (const char* p = nombre; *p != '\0'; p++)
+    {
+        if (!isalnum((unsigned char)*p) && strchr("%+,-./:=@_", *p) == NULL)
+            return false;
+    }
+    return true;
+}
+
+// Leer una cantidad de líneas: sólo dígitos, sin signo ni sufijos
+static bool leer_cantidad(const char* texto, long* cantidad)
+{
+    if (!isdigit((unsigned char)texto[0]))
+        return false;
+    char* fin;
+    errno = 0;
+    long valor = strtol(texto, &fin, 10);
+    if (*fin != '\0' || errno == ERANGE)
+        return false;
+    *cantidad = valor;
+    return true;
+}
+
+// Analizar los argumentos de cat, wc, head o tail; false si el comando usa algo que la versión interna no reproduce
+static bool analizar_opciones(char** argv, opciones_utilidad* o)
+{
+    bool es_wc = strcmp(argv[0], "wc") == 0;
+    bool es_cat = strcmp(argv[0], "cat") == 0;
+    memset(o, 0, sizeof(*o));
+    o->lineas = 10;
+    int i = 1;
+
+    // Forma obsoleta -N de head y tail, sólo como primer argumento y con un archivo como máximo (como en tail)
+    if (!es_wc && !es_cat && argv[1] != NULL && argv[1][0] == '-' && isdigit((unsigned char)argv[1][1]) &&
+        (argv[2] == NULL || argv[3] == NULL))
+    {
+        if (!leer_cantidad(argv[1] + 1, &o->lineas))
+            return false;
+        i = 2;
+    }
+
+    for (; argv[i] != NULL && argv[i][0] == '-' && argv[i][1] != '\0'; i++)
+    {
+        const char* a = argv[i];
+        if (strcmp(a, "--") == 0)
+        {
+            i++;
+            break;
+        }
+        if (es_cat)
+        {
+            if (strcmp(a, "-u") != 0) // -u (sin buffer) no cambia la salida
+                return false;
+        }
+        else if (es_wc)
+        {
+            if (strcmp(a, "--lines") == 0)
+                o->contar_lineas = true;
+            else if (strcmp(a, "--bytes") == 0)
+                o->contar_bytes = true;
+            else if (a[1] != '-' && a[strspn(a + 1, "lc") + 1] == '\0')
+            {
+                o->contar_lineas = o->contar_lineas || strchr(a, 'l') != NULL;
+                o->contar_bytes = o->contar_bytes || strchr(a, 'c') != NULL;
+            }
+            else
+                return false;
+        }
+        else if (strcmp(a, "-n") == 0)
+        {
+            if (argv[i + 1] == NULL || !leer_cantidad(argv[i + 1], &o->lineas))
+                return false;
+            i++;
+        }
+        else if (strncmp(a, "-n", 2) == 0 || strncmp(a, "--lines=", 8) == 0)
+        {
+            if (!leer_cantidad(a + (a[1] == 'n' ? 2 : 8), &o->lineas))
+                return false;
+        }
+        else
+            return false;
+    }
+    if (es_wc && !o->contar_lineas && !o->contar_bytes)
+        return false; // Contar palabras depende del locale: se deja al programa
+
+    // Las opciones después de los archivos (que getopt de GNU acepta) se dejan al programa
+    o->primer_archivo = i;
+    for (bool fin_opciones = i > 1 && strcmp(argv[i - 1], "--") == 0; argv[i] != NULL; i++)
+    {
+        if (!fin_opciones && argv[i][0] == '-' && argv[i][1] != '\0')
+            return false;
+    }
+    return true;
+}
+
+// Abrir una entrada: "-" es la entrada estándar
+static int abrir_entrada(const char* nombre)
+{
+    return strcmp(nombre, "-") == 0 ? STDIN_FILENO : open(nombre, O_RDONLY | O_CLOEXEC);
+}
+
+// Cerrar una entrada abierta con abrir_entrada()
+static void cerrar_entrada(int fd)
+{
+    if (fd != STDIN_FILENO)
+        close(fd);
+}
+
+// Informar un error de escritura; sin lector, el programa moriría por SIGPIPE sin mensaje
+static int fallo_escritura(const char* comando, int error)
+{
+    if (error == EPIPE)
+        return 128 + SIGPIPE;
+    fprintf(stderr, "%s: write error: %s\n", comando, strerror(error));
+    return 1;
+}
+
+// Comando "cat"
+int manejar_comando_cat(int argc, char** argv)
+{
+    opciones_utilidad o;
+    if (!analizar_opciones(argv, &o))
+    {
+        fprintf(stderr, "cat: opción no soportada por el comando interno\n");
+        return 1;
+    }
+
+    struct stat salida;
+    bool salida_regular = fstat(STDOUT_FILENO, &salida) == 0 && S_ISREG(salida.st_mode);
+    char* entrada_estandar[] = {"-"};
+    char** archivos = o.primer_archivo < argc ? argv + o.primer_archivo : entrada_estandar;
+    int num_archivos = o.primer_archivo < argc ? argc - o.primer_archivo : 1;
+    int estado = 0;
+
+    fflush(stdout);
+    for (int i = 0; i < num_archivos; i++)
+    {
+        int fd = abrir_entrada(archivos[i]);
+        if (fd == -1)
+        {
+            fprintf(stderr, "cat: %s: %s\n", archivos[i], strerror(errno));
+            estado = 1;
+            continue;
+        }
+
+        // Como cat de GNU, no copiar un archivo sobre sí mismo: crecería sin fin
+        struct stat st;
+        if (salida_regular && fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_dev == salida.st_dev &&
+            st.st_ino == salida.st_ino && lseek(fd, 0, SEEK_CUR) < st.st_size)
+        {
+            fprintf(stderr, "cat: %s: input file is output file\n", archivos[i]);
+            cerrar_entrada(fd);
+            estado = 1;
+            continue;
+        }
+
+        resultado_volcado resultado = volcar_descriptor(fd, STDOUT_FILENO, VOLCAR_TODO, 0);
+        int error = errno;
+        cerrar_entrada(fd);
+        if (resultado == VOLCADO_ERROR_ESCRITURA)
+            return fallo_escritura("cat", error);
+        if (resultado == VOLCADO_ERROR_LECTURA)
+        {
+            fprintf(stderr, "cat: %s: %s\n", archivos[i], strerror(error));
+            estado = 1;
+        }
+    }
+    return estado;
+}
+
+// Contar las líneas y los bytes de una entrada desde su posición actual; false si falló una lectura
+static bool contar_entrada(int fd, bool contar_lineas, char* bloque, uintmax_t* lineas, uintmax_t* bytes)
+{
+    static nivel_busqueda nivel = BUSQUEDA_ESCALAR;
+    static bool nivel_elegido = false;
+    if (!nivel_elegido)
+    {
+        nivel = busqueda_nivel_disponible();
+        nivel_elegido = true;
+    }
+    *lineas = 0;
+    *bytes = 0;
+
+    // Sólo bytes: el tamaño de un archivo regular alcanza (los de /proc informan 0 y se leen)
+    struct stat st;
+    if (!contar_lineas && fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0)
+    {
+        off_t actual = lseek(fd, 0, SEEK_CUR);
+        if (actual != -1 && lseek(fd, 0, SEEK_END) != -1)
+            *bytes = actual < st.st_size ? (uintmax_t)(st.st_size - actual) : 0;
+    }
+
+    posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+    for (;;)
+    {
+        ssize_t leidos = read(fd, bloque, UTILIDADES_TAM_BLOQUE);
+        if (leidos == -1 && errno == EINTR)
+            continue;
+        if (leidos == -1)
+            return false;
+        if (leidos == 0)
+            return true;
+        *bytes += (uintmax_t)leidos;
+        if (contar_lineas)
+            *lineas += contar_byte(nivel, bloque, (size_t)leidos, '\n');
+    }
+}
+
+// Ancho de las columnas de wc, calculado como en coreutils a partir de los tamaños de las entradas
+static int ancho_columnas(char** archivos, int num_archivos, bool una_columna)
+{
+    if (num_archivos == 1 && una_columna)
+        return 1;
+
+    int minimo = 1;
+    uintmax_t total = 0;
+    for (int i = 0; i < num_archivos; i++)
+    {
+        struct stat st;
+        int resultado = strcmp(archivos[i], "-") == 0 ? fstat(STDIN_FILENO, &st) : stat(archivos[i], &st);
+        if (resultado == -1)
+        {
+            if (i == 0)
+                return 1; // coreutils abandona el cálculo si falla la primera entrada
+            continue;
+        }
+        if (S_ISREG(st.st_mode))
+            total += (uintmax_t)st.st_size;
+        else
+            minimo = 7;
+    }
+
+    int ancho = 1;
+    for (; total >= 10; total /= 10)
+        ancho++;
+    return ancho > minimo ? ancho : minimo;
+}
+
+// Escribir una línea de wc
+static void escribir_conteos(const opciones_utilidad* o, int ancho, uintmax_t lineas, uintmax_t bytes,
+                             const char* nombre)
+{
+    const char* separador = "";
+    if (o->contar_lineas)
+    {
+        printf("%*" PRIuMAX, ancho, lineas);
+        separador = " ";
+    }
+    if (o->contar_bytes)
+        printf("%s%*" PRIuMAX, separador, ancho, bytes);
+    if (nombre != NULL)
+        printf(" %s", nombre);
+    putchar('\n');
+}
+
+// Comando "wc"
+int manejar_comando_wc(int argc, char** argv)
+{
+    opciones_utilidad o;
+    if (!analizar_opciones(argv, &o))
+    {
+        fprintf(stderr, "wc: opción no soportada por el comando interno\n");
+        return 1;
+    }
+    char* bloque = malloc(UTILIDADES_TAM_BLOQUE);
+    if (bloque == NULL)
+    {
+        fprintf(stderr, "wc: memoria insuficiente\n");
+        return 1;
+    }
+
+    // Sin archivos se cuenta la entrada estándar, sin nombre en la salida
+    char* entrada_estandar[] = {"-"};
+    bool sin_archivos = o.primer_archivo >= argc;
+    char** archivos = sin_archivos ? entrada_estandar : argv + o.primer_archivo;
+    int num_archivos = sin_archivos ? 1 : argc - o.primer_archivo;
+    int ancho = ancho_columnas(archivos, num_archivos, o.contar_lineas != o.contar_bytes);
+    uintmax_t total_lineas = 0;
+    uintmax_t total_bytes = 0;
+    int estado = 0;
+
+    for (int i = 0; i < num_archivos; i++)
+    {
+        int fd = abrir_entrada(archivos[i]);
+        if (fd == -1)
+        {
+            fprintf(stderr, "wc: %s: %s\n", archivos[i], strerror(errno));
+            estado = 1;
+            continue;
+        }
+        uintmax_t lineas;
+        uintmax_t bytes;
+        if (!contar_entrada(fd, o.contar_lineas, bloque, &lineas, &bytes))
+        {
+            fprintf(stderr, "wc: %s: %s\n", archivos[i], strerror(errno));
+            estado = 1; // Como coreutils, se muestra lo contado hasta el error
+        }
+        cerrar_entrada(fd);
+        escribir_conteos(&o, ancho, lineas, bytes, sin_archivos ? NULL : archivos[i]);
+        total_lineas += lineas;
+        total_bytes += bytes;
+    }
+    if (num_archivos > 1)
+        escribir_conteos(&o, ancho, total_lineas, total_bytes, "total");
+    free(bloque);
+
+    if (fflush(stdout) == EOF)
+        return fallo_escritura("wc", errno);
+    return estado;
+}
+
+// Mostrar las primeras o las últimas líneas de cada entrada, con cabeceras si hay más de una
+static int mostrar_lineas(int argc, char** argv, modo_volcado modo)
+{
+    const char* comando = argv[0];
+    opciones_utilidad o;
+    if (!analizar_opciones(argv, &o))
+    {
+        fprintf(stderr, "%s: opción no soportada por el comando interno\n", comando);
+        return 1;
+    }
+
+    char* entrada_estandar[] = {"-"};
+    char** archivos = o.primer_archivo < argc ? argv + o.primer_archivo : entrada_estandar;
+    int num_archivos = o.primer_archivo < argc ? argc - o.primer_archivo : 1;
+    bool primera_cabecera = true;
+    int estado = 0;
+
+    for (int i = 0; i < num_archivos; i++)
+    {
+        const char* nombre = strcmp(archivos[i], "-") == 0 ? "standard input" : archivos[i];
+        int fd = abrir_entrada(archivos[i]);
+        if (fd == -1)
+        {
+            fprintf(stderr, "%s: cannot open '%s' for reading: %s\n", comando, nombre, strerror(errno));
+            estado = 1;
+            continue;
+        }
+        if (num_archivos > 1)
+        {
+            printf("%s==> %s <==\n", primera_cabecera ? "" : "\n", nombre);
+            primera_cabecera = false;
+        }
+        if (fflush(stdout) == EOF)
+        {
+            cerrar_entrada(fd);
+            return fallo_escritura(comando, errno);
+        }
+
+        resultado_volcado resultado = volcar_descriptor(fd, STDOUT_FILENO, modo, o.lineas);
+        int error = errno;
+        cerrar_entrada(fd);
+        if (resultado == VOLCADO_ERROR_ESCRITURA)
+            return fallo_escritura(comando, error);
+        if (resultado == VOLCADO_ERROR_LECTURA)
+        {
+            fprintf(stderr, "%s: error reading '%s': %s\n", comando, nombre, strerror(error));
+            estado = 1;
+        }
+    }
+    return estado;
+}
+
+// Comando "head"
+int manejar_comando_head(int argc, char** argv)
+{
+    return mostrar_lineas(argc, argv, VOLCAR_PRIMERAS);
+}
+
+// Comando "tail"
+int manejar_comando_tail(int argc, char** argv)
+{
+    return mostrar_lineas(argc, argv, VOLCAR_ULTIMAS);
+}
+
+// Informar un error de sintaxis de test
+static bool error_test(evaluacion_test* t, const char* formato, const char* argumento)
+{
+    if (!t->error)
+    {
+        fputs("test: ", stderr);
+        fprintf(stderr, formato, argumento);
+        fputc('\n', stderr);
+    }
+    t->error = true;
+    return false;
+}
+
+// Informar que la expresión terminó antes de tiempo; como coreutils, se nombra el último argumento
+static bool falta_argumento_test(evaluacion_test* t)
+{
+    return error_test(t, "missing argument after '%s'", t->argv[t->argc - 1]);
+}
+
+// Validar un entero de test (blancos alrededor y signo opcionales); devuelve el inicio de su signo o dígitos
+static const char* leer_entero_test(evaluacion_test* t, const char* texto)
+{
+    const char* p = texto;
+    while (isblank((unsigned char)*p))
+        p++;
+    const char* inicio = p;
+    if (*p == '+' || *p == '-')
+        p++;
+    if (isdigit((unsigned char)*p))
+    {
+        while (isdigit((unsigned char)*p))
+            p++;
+        while (isblank((unsigned char)*p))
+            p++;
+        if (*p == '\0')
+            return inicio;
+    }
+    error_test(t, "invalid integer '%s'", texto);
+    return NULL;
+}
+
+// Comparar dos enteros ya validados de cualquier largo; devuelve <0, 0 o >0
+static int comparar_enteros(const char* a, const char* b)
+{
+    bool negativo_a = *a == '-';
+    bool negativo_b = *b == '-';
+    a += *a == '+' || *a == '-';
+    b += *b == '+' || *b == '-';
+    while (*a == '0')
+        a++;
+    while (*b == '0')
+        b++;
+    size_t largo_a = strspn(a, "0123456789");
+    size_t largo_b = strspn(b, "0123456789");
+    negativo_a = negativo_a && largo_a > 0; // -0 es 0
+    negativo_b = negativo_b && largo_b > 0;
+    if (negativo_a != negativo_b)
+        return negativo_a ? -1 : 1;
+
+    int orden = largo_a != largo_b ? (largo_a < largo_b ? -1 : 1) : memcmp(a, b, largo_a);
+    orden = orden < 0 ? -1 : (orden > 0 ? 1 : 0);
+    return negativo_a ? -orden : orden;
+}
+
+// Verificar si un argumento es un operador binario de test
+static bool es_binario_test(const char* s)
+{
+    static const char* const binarios[] = {"=",   "==",  "!=",  "-eq", "-ne", "-lt",
+                                           "-le", "-gt", "-ge", "-nt", "-ot", "-ef"};
+    for (size_t i = 0; i < sizeof(binarios) / sizeof(binarios[0]); i++)
+    {
+        if (strcmp(s, binarios[i]) == 0)
+            return true;
+    }
+    return false;
+}
+
+// Verificar si un argumento es un operador unario de test
+static bool es_unario_test(const char* s)
+{
+    return s[0] == '-' && s[1] != '\0' && s[2] == '\0' && strchr("bcdefgGhkLnOprsStuwxz", s[1]) != NULL;
+}
+
+// Evaluar el operador binario en la posición actual + 1
+static bool binario_test(evaluacion_test* t)
+{
+    const char* izquierda = t->argv[t->pos];
+    const char* op = t->argv[t->pos + 1];
+    const char* derecha = t->argv[t->pos + 2];
+    t->pos += 3;
+
+    if (op[0] != '-')
+    {
+        bool iguales = strcmp(izquierda, derecha) == 0;
+        return op[0] == '!' ? !iguales : iguales;
+    }
+    if (op[1] == 'n' && op[2] == 't') // -nt: más nuevo; un archivo que no existe es el más viejo
+    {
+        struct stat a;
+        struct stat b;
+        if (stat(izquierda, &a) == -1)
+            return false;
+        if (stat(derecha, &b) == -1)
+            return true;
+        return a.st_mtim.tv_sec != b.st_mtim.tv_sec ? a.st_mtim.tv_sec > b.st_mtim.tv_sec
+                                                    : a.st_mtim.tv_nsec > b.st_mtim.tv_nsec;
+    }
+    if (op[1] == 'o' && op[2] == 't')
+    {
+        struct stat a;
+        struct stat b;
+        if (stat(derecha, &b) == -1)
+            return false;
+        if (stat(izquierda, &a) == -1)
+            return true;
+        return a.st_mtim.tv_sec != b.st_mtim.tv_sec ? a.st_mtim.tv_sec < b.st_mtim.tv_sec
+                                                    : a.st_mtim.tv_nsec < b.st_mtim.tv_nsec;
+    }
+    if (op[1] == 'e' && op[2] == 'f')
+    {
+        struct stat a;
+        struct stat b;
+        return stat(izquierda, &a) == 0 && stat(derecha, &b) == 0 && a.st_dev == b.st_dev && a.st_ino == b.st_ino;
+    }
+
+    const char* a = leer_entero_test(t, izquierda);
+    const char* b = a != NULL ? leer_entero_test(t, derecha) : NULL;
+    if (b == NULL)
+        return false;
+    int orden = comparar_enteros(a, b);
+    switch (op[1])
+    {
+    case 'e':
+        return orden == 0;
+    case 'n':
+        return orden != 0;
+    case 'l':
+        return op[2] == 't' ? orden < 0 : orden <= 0;
+    default:
+        return op[2] == 't' ? orden > 0 : orden >= 0;
+    }
+}
+
+// Evaluar el operador unario en la posición actual
+static bool unario_test(evaluacion_test* t)
+{
+    char op = t->argv[t->pos][1];
+    if (t->pos + 1 >= t->argc)
+        return falta_argumento_test(t);
+    const char* operando = t->argv[t->pos + 1];
+    t->pos += 2;
+
+    struct stat st;
+    switch (op)
+    {
+    case 'n':
+        return operando[0] != '\0';
+    case 'z':
+        return operando[0] == '\0';
+    case 't':
+    {
+        const char* fd = leer_entero_test(t, operando);
+        return fd != NULL && isatty(atoi(fd));
+    }
+    case 'h':
+    case 'L':
+        return lstat(operando, &st) == 0 && S_ISLNK(st.st_mode);
+    case 'r':
+        return euidaccess(operando, R_OK) == 0;
+    case 'w':
+        return euidaccess(operando, W_OK) == 0;
+    case 'x':
+        return euidaccess(operando, X_OK) == 0;
+    default:
+        break;
+    }
+
+    if (stat(operando, &st) == -1)
+        return false;
+    switch (op)
+    {
+    case 'e':
+        return true;
+    case 'f':
+        return S_ISREG(st.st_mode);
+    case 'd':
+        return S_ISDIR(st.st_mode);
+    case 'b':
+        return S_ISBLK(st.st_mode);
+    case 'c':
+        return S_ISCHR(st.st_mode);
+    case 'p':
+        return S_ISFIFO(st.st_mode);
+    case 'S':
+        return S_ISSOCK(st.st_mode);
+    case 's':
+        return st.st_size > 0;
+    case 'g':
+        return (st.st_mode & S_ISGID) != 0;
+    case 'u':
+        return (st.st_mode & S_ISUID) != 0;
+    case 'k':
+        return (st.st_mode & S_ISVTX) != 0;
+    case 'O':
+        return st.st_uid == geteuid();
+    default: // 'G'
+        return st.st_gid == getegid();
+    }
+}
+
+static bool expresion_test(evaluacion_test* t);
+static bool posix_test(evaluacion_test* t, int n);
+
+// Evaluar un término: '!' término, '(' expresión ')', una operación binaria o unaria, o una cadena
+static bool termino_test(evaluacion_test* t)
+{
+    if (t->pos >= t->argc)
+        return falta_argumento_test(t);
+    if (strcmp(t->argv[t->pos], "!") == 0)
+    {
+        t->pos++;
+        return !termino_test(t) && !t->error;
+    }
+    if (strcmp(t->argv[t->pos], "(") == 0)
+    {
+        t->pos++;
+        if (t->pos >= t->argc)
+            return falta_argumento_test(t);
+
+        // Los paréntesis que encierran hasta 4 argumentos se evalúan con las reglas de POSIX, como en coreutils;
+        // si no se cierran antes, el resto de la expresión
+        int n = 1;
+        while (t->pos + n < t->argc && strcmp(t->argv[t->pos + n], ")") != 0 && n < 4)
+            n++;
+        if (n == 4 && t->pos + n < t->argc && strcmp(t->argv[t->pos + n], ")") != 0)
+            n = t->argc - t->pos;
+        bool valor = posix_test(t, n);
+        if (t->error)
+            return false;
+        if (t->pos >= t->argc)
+            return error_test(t, "%s expected", "')'");
+        if (strcmp(t->argv[t->pos], ")") != 0)
+        {
+            fprintf(stderr, "test: ')' expected, found '%s'\n", t->argv[t->pos]);
+            t->error = true;
+            return false;
+        }
+        t->pos++;
+        return valor;
+    }
+    if (t->argc - t->pos >= 3 && es_binario_test(t->argv[t->pos + 1]))
+        return binario_test(t);
+    const char* a = t->argv[t->pos];
+    if (a[0] == '-' && a[1] != '\0' && a[2] == '\0')
+    {
+        if (es_unario_test(a))
+            return unario_test(t);
+        return error_test(t, "'%s': unary operator expected", a);
+    }
+    t->pos++;
+    return a[0] != '\0';
+}
+
+// Evaluar una conjunción: término ('-a' término)*
+static bool conjuncion_test(evaluacion_test* t)
+{
+    bool valor = termino_test(t);
+    while (!t->error && t->pos < t->argc && strcmp(t->argv[t->pos], "-a") == 0)
+    {
+        t->pos++;
+        valor = termino_test(t) && valor;
+    }
+    return valor;
+}
+
+// Evaluar una expresión completa: conjunción ('-o' conjunción)*
+static bool expresion_test(evaluacion_test* t)
+{
+    bool valor = conjuncion_test(t);
+    while (!t->error && t->pos < t->argc && strcmp(t->argv[t->pos], "-o") == 0)
+    {
+        t->pos++;
+        valor = conjuncion_test(t) || valor;
+    }
+    return valor;
+}
+
+// Evaluar n argumentos con las reglas de POSIX según su cantidad; con más de 4, como expresión
+static bool posix_test(evaluacion_test* t, int n)
+{
+    char** a = t->argv + t->pos;
+    switch (n)
+    {
+    case 1:
+        t->pos++;
+        return a[0][0] != '\0';
+    case 2:
+        if (strcmp(a[0], "!") == 0)
+        {
+            t->pos += 2;
+            return a[1][0] == '\0';
+        }
+        if (es_unario_test(a[0]))
+            return unario_test(t);
+        if (a[0][0] == '-' && a[0][1] != '\0' && a[0][2] == '\0')
+            return error_test(t, "'%s': unary operator expected", a[0]);
+        return falta_argumento_test(t);
+    case 3:
+        if (es_binario_test(a[1]))
+            return binario_test(t);
+        if (strcmp(a[0], "!") == 0)
+        {
+            t->pos++;
+            return !posix_test(t, 2) && !t->error;
+        }
+        if (strcmp(a[0], "(") == 0 && strcmp(a[2], ")") == 0)
+        {
+            t->pos += 3;
+            return a[1][0] != '\0';
+        }
+        if (strcmp(a[1], "-a") == 0 || strcmp(a[1], "-o") == 0)
+            return expresion_test(t);
+        return error_test(t, "'%s': binary operator expected", a[1]);
+    case 4:
+        if (strcmp(a[0], "!") == 0)
+        {
+            t->pos++;
+            return !posix_test(t, 3) && !t->error;
+        }
+        if (strcmp(a[0], "(") == 0 && strcmp(a[3], ")") == 0)
+        {
+            t->pos++;
+            bool valor = posix_test(t, 2);
+            t->pos++;
+            return valor;
+        }
+        return expresion_test(t);
+    default:
+        return expresion_test(t);
+    }
+}
+
+// Comando "test"
+int manejar_comando_test(int argc, char** argv)
+{
+    if (argc <= 1)
+        return 1; // Sin expresión, falso
+    evaluacion_test t = {argv + 1, argc - 1, 0, false};
+    bool valor = posix_test(&t, t.argc);
+    if (!t.error && t.pos < t.argc)
+        error_test(&t, "extra argument '%s'", t.argv[t.pos]);
+    return t.error ? 2 : (valor ? 0 : 1);
+}
+
+// Verificar si la versión interna reproduce al programa con estos argumentos
+bool utilidad_aplicable(char** argv)
+{
+    const char* nombre = argv[0];
+    if (strcmp(nombre, "test") == 0)
+        return true;
+    if (strcmp(nombre, "true") == 0 || strcmp(nombre, "false") == 0)
+    {
+        // Con un único argumento --help o --version, coreutils muestra la ayuda o la versión
+        return argv[1] == NULL || argv[2] != NULL ||
+               (strcmp(argv[1], "--help") != 0 && strcmp(argv[1], "--version") != 0);
+    }
+
+    opciones_utilidad o;
+    if (!analizar_opciones(argv, &o))
+        return false;
+    bool lee_entrada_estandar = argv[o.primer_archivo] == NULL;
+    for (int i = o.primer_archivo; argv[i] != NULL; i++)
+    {
+        if (strcmp(argv[i], "-") == 0)
+            lee_entrada_estandar = true;
+        else if (!nombre_sin_comillas(argv[i]))
+            return false;
+    }
+    return !lee_entrada_estandar || !isatty(STDIN_FILENO);
+}
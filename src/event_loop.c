@@ -0,0 +1,396 @@
+/**
+ * @file event_loop.c
+ * @brief Implementación del bucle de eventos con epoll, signalfd, timerfd y pidfd.
+ */
+
+#include "event_loop.h"
+#include "jobs.h"
+#include <errno.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/signalfd.h>
+#include <sys/syscall.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+/**
+ * @brief Eventos leídos por cada llamada a epoll_wait()
+ */
+#define EVENTOS_POR_RONDA 32
+
+/**
+ * @brief Origen de un descriptor registrado, que decide cómo se atiende y si el bucle lo cierra
+ */
+typedef enum
+{
+    REGISTRO_FD,           /**< Descriptor externo: sólo se llama al manejador */
+    REGISTRO_SENALES,      /**< El signalfd del propio bucle */
+    REGISTRO_TEMPORIZADOR, /**< timerfd creado por el bucle: se consume el contador antes del manejador */
+    REGISTRO_PROCESO       /**< pidfd creado por el bucle */
+} tipo_registro;
+
+/**
+ * @brief Descriptor registrado en el bucle
+ */
+typedef struct registro
+{
+    int fd;                     /**< Descriptor vigilado */
+    tipo_registro tipo;         /**< Origen del descriptor */
+    manejador_evento manejador; /**< Función llamada cuando el descriptor está listo */
+    void* dato;                 /**< Dato opaco para el manejador */
+    bool quitado;               /**< Ya se quitó del bucle; se libera al terminar la ronda */
+    struct registro* siguiente; /**< Siguiente registro pendiente de liberar */
+} registro;
+
+/**
+ * @brief Descriptor de epoll, -1 si el bucle no está inicializado
+ */
+static int epoll_fd = -1;
+
+/**
+ * @brief Descriptor de signalfd
+ */
+static int senales_fd = -1;
+
+/**
+ * @brief Máscara de señales anterior a eventos_inicializar()
+ */
+static sigset_t mascara_anterior;
+
+/**
+ * @brief Función llamada con cada señal recibida
+ */
+static manejador_senal_bucle manejador_senales_bucle = NULL;
+
+/**
+ * @brief Registros activos
+ */
+static registro** registros = NULL;
+
+/**
+ * @brief Cantidad de registros activos
+ */
+static int num_registros = 0;
+
+/**
+ * @brief Capacidad del vector de registros
+ */
+static int capacidad_registros = 0;
+
+/**
+ * @brief Registros quitados durante una ronda, que todavía pueden aparecer entre los eventos leídos
+ */
+static registro* pendientes_liberar = NULL;
+
+/**
+ * @brief Profundidad de eventos_esperar(): un manejador puede ejecutar un comando que vuelva a esperar eventos
+ */
+static int profundidad = 0;
+
+/**
+ * @brief Algún manejador escribió en la terminal
+ */
+static bool hubo_salida = false;
+
+// Convertir milisegundos en un itimerspec para timerfd
+static struct itimerspec tiempo_temporizador(unsigned ms, bool periodico)
+{
+    struct itimerspec t;
+    memset(&t, 0, sizeof(t));
+    t.it_value.tv_sec = (time_t)(ms / 1000);
+    t.it_value.tv_nsec = (long)(ms % 1000) * 1000000L;
+    if (periodico)
+    {
+        t.it_interval = t.it_value;
+    }
+    return t;
+}
+
+// Crear un registro y agregarlo a epoll
+static int registrar(int fd, uint32_t eventos, tipo_registro tipo, manejador_evento manejador, void* dato)
+{
+    if (epoll_fd == -1)
+    {
+        errno = EBADF;
+        return -1;
+    }
+
+    if (num_registros == capacidad_registros)
+    {
+        int nueva = capacidad_registros > 0 ? capacidad_registros * 2 : 8;
+        registro** nuevos = realloc(registros, (size_t)nueva * sizeof(registro*));
+        if (nuevos == NULL)
+            return -1;
+        registros = nuevos;
+        capacidad_registros = nueva;
+    }
+
+    registro* r = calloc(1, sizeof(registro));
+    if (r == NULL)
+        return -1;
+    r->fd = fd;
+    r->tipo = tipo;
+    r->manejador = manejador;
+    r->dato = dato;
+
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = eventos;
+    ev.data.ptr = r;
+    if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &ev) == -1)
+    {
+        free(r);
+        return -1;
+    }
+    registros[num_registros++] = r;
+    return 0;
+}
+
+// Leer las señales pendientes del signalfd y entregarlas al manejador
+static void atender_senales(void)
+{
+    struct signalfd_siginfo info[8];
+    ssize_t leidos;
+    while ((leidos = read(senales_fd, info, sizeof(info))) > 0)
+    {
+        for (size_t i = 0; i < (size_t)leidos / sizeof(info[0]); i++)
+        {
+            int sig = (int)info[i].ssi_signo;
+            if (sig == SIGCHLD)
+            {
+                hijos_pendientes = 1; // Varias terminaciones pueden llegar como una sola señal
+            }
+            if (manejador_senales_bucle != NULL)
+            {
+                manejador_senales_bucle(sig);
+            }
+        }
+    }
+}
+
+// Atender un evento de un registro según su tipo
+static void atender(registro* r, uint32_t eventos)
+{
+    switch (r->tipo)
+    {
+    case REGISTRO_SENALES:
+        atender_senales();
+        break;
+    case REGISTRO_TEMPORIZADOR: {
+        uint64_t vencimientos;
+        if (read(r->fd, &vencimientos, sizeof(vencimientos)) != (ssize_t)sizeof(vencimientos))
+            break; // Reprogramado después de despertar epoll: no venció
+        r->manejador(r->fd, eventos, r->dato);
+        break;
+    }
+    case REGISTRO_FD:
+    case REGISTRO_PROCESO:
+        r->manejador(r->fd, eventos, r->dato);
+        break;
+    }
+}
+
+// Liberar los registros quitados durante la ronda
+static void liberar_pendientes(void)
+{
+    while (pendientes_liberar != NULL)
+    {
+        registro* r = pendientes_liberar;
+        pendientes_liberar = r->siguiente;
+        free(r);
+    }
+}
+
+// Crear el bucle y bloquear las señales que atiende
+bool eventos_inicializar(bool interactivo, manejador_senal_bucle manejador)
+{
+    if (epoll_fd != -1)
+        return true; // Ya inicializado: se conserva el manejador original
+
+    sigset_t senales;
+    sigemptyset(&senales);
+    sigaddset(&senales, SIGCHLD);
+    if (interactivo)
+    {
+        sigaddset(&senales, SIGINT);
+        sigaddset(&senales, SIGQUIT);
+        sigaddset(&senales, SIGTSTP);
+    }
+
+    epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (epoll_fd == -1)
+    {
+        perror("epoll_create1");
+        return false;
+    }
+
+    // Las señales se bloquean antes de crear el signalfd: sólo así quedan pendientes para leerlas
+    sigprocmask(SIG_BLOCK, &senales, &mascara_anterior);
+    senales_fd = signalfd(-1, &senales, SFD_NONBLOCK | SFD_CLOEXEC);
+    if (senales_fd == -1 || registrar(senales_fd, EPOLLIN, REGISTRO_SENALES, NULL, NULL) == -1)
+    {
+        perror("signalfd");
+        sigprocmask(SIG_SETMASK, &mascara_anterior, NULL);
+        eventos_cerrar();
+        return false;
+    }
+    manejador_senales_bucle = manejador;
+    return true;
+}
+
+// Registrar un descriptor externo
+int eventos_agregar_fd(int fd, uint32_t eventos, manejador_evento manejador, void* dato)
+{
+    return registrar(fd, eventos, REGISTRO_FD, manejador, dato);
+}
+
+// Quitar un descriptor del bucle
+void eventos_quitar_fd(int fd)
+{
+    for (int i = 0; i < num_registros; i++)
+    {
+        registro* r = registros[i];
+        if (r->fd != fd)
+            continue;
+
+        epoll_ctl(epoll_fd, EPOLL_CTL_DEL, fd, NULL);
+        if (r->tipo == REGISTRO_TEMPORIZADOR || r->tipo == REGISTRO_PROCESO)
+        {
+            close(fd);
+        }
+        registros[i] = registros[--num_registros];
+
+        // Si hay una ronda en curso, el registro puede estar entre los eventos ya leídos
+        r->quitado = true;
+        r->siguiente = pendientes_liberar;
+        pendientes_liberar = r;
+        if (profundidad == 0)
+        {
+            liberar_pendientes();
+        }
+        return;
+    }
+}
+
+// Crear un temporizador y registrarlo
+int eventos_agregar_temporizador(unsigned ms, bool periodico, manejador_evento manejador, void* dato)
+{
+    if (epoll_fd == -1)
+        return -1;
+
+    int fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (fd == -1)
+        return -1;
+
+    struct itimerspec t = tiempo_temporizador(ms > 0 ? ms : 1, periodico); // Un valor nulo desarmaría el temporizador
+    if (timerfd_settime(fd, 0, &t, NULL) == -1 || registrar(fd, EPOLLIN, REGISTRO_TEMPORIZADOR, manejador, dato) == -1)
+    {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// Reprogramar un temporizador existente
+int eventos_reprogramar(int fd, unsigned ms, bool periodico)
+{
+    struct itimerspec t = tiempo_temporizador(ms, periodico);
+    return timerfd_settime(fd, 0, &t, NULL);
+}
+
+// Vigilar la terminación de un proceso con un pidfd
+int eventos_vigilar_proceso(pid_t pid, manejador_evento manejador, void* dato)
+{
+    if (epoll_fd == -1)
+        return -1;
+
+#ifdef SYS_pidfd_open
+    int fd = (int)syscall(SYS_pidfd_open, pid, 0);
+    if (fd == -1)
+        return -1;
+    if (registrar(fd, EPOLLIN, REGISTRO_PROCESO, manejador, dato) == -1)
+    {
+        close(fd);
+        return -1;
+    }
+    return fd;
+#else
+    (void)pid;
+    (void)manejador;
+    (void)dato;
+    errno = ENOSYS;
+    return -1;
+#endif
+}
+
+// Esperar eventos y atenderlos
+int eventos_esperar(int espera_ms)
+{
+    if (epoll_fd == -1)
+        return -1;
+
+    struct epoll_event eventos[EVENTOS_POR_RONDA];
+    int n = epoll_wait(epoll_fd, eventos, EVENTOS_POR_RONDA, espera_ms);
+    if (n == -1)
+        return errno == EINTR ? 0 : -1;
+
+    profundidad++;
+    for (int i = 0; i < n; i++)
+    {
+        registro* r = eventos[i].data.ptr;
+        if (!r->quitado)
+        {
+            atender(r, eventos[i].events);
+        }
+    }
+    profundidad--;
+
+    if (profundidad == 0)
+    {
+        liberar_pendientes();
+    }
+    return n;
+}
+
+// Marcar que el prompt debe volver a mostrarse
+void eventos_marcar_salida(void)
+{
+    hubo_salida = true;
+}
+
+// Consultar y limpiar la marca de salida
+bool eventos_hubo_salida(void)
+{
+    bool resultado = hubo_salida;
+    hubo_salida = false;
+    return resultado;
+}
+
+// Cerrar el bucle y restaurar la máscara de señales
+void eventos_cerrar(void)
+{
+    if (epoll_fd == -1)
+        return;
+
+    while (num_registros > 0)
+    {
+        eventos_quitar_fd(registros[num_registros - 1]->fd);
+    }
+    liberar_pendientes();
+    free(registros);
+    registros = NULL;
+    capacidad_registros = 0;
+
+    if (senales_fd != -1)
+    {
+        close(senales_fd);
+        senales_fd = -1;
+        sigprocmask(SIG_SETMASK, &mascara_anterior, NULL);
+    }
+    close(epoll_fd);
+    epoll_fd = -1;
+    manejador_senales_bucle = NULL;
+}
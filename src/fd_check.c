@@ -0,0 +1,190 @@
+/**
+ * @file fd_check.c
+ * @brief Comando interno de depuración 'fdcheck'.
+ */
+
+#include "fd_check.h"
+#include "commands.h"
+#include <dirent.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/**
+ *  @brief Directorio con un enlace por cada descriptor abierto del proceso
+ */
+#define DIRECTORIO_DESCRIPTORES "/proc/self/fd"
+
+// Agregar un descriptor al final de la tabla
+static int agregar_descriptor(tabla_descriptores* tabla, int* capacidad, int fd)
+{
+    if (tabla->cantidad == *capacidad)
+    {
+        int nueva = *capacidad == 0 ? 16 : *capacidad * 2;
+        descriptor_abierto* nuevos = realloc(tabla->descriptores, (size_t)nueva * sizeof(descriptor_abierto));
+        if (nuevos == NULL)
+            return -1;
+        tabla->descriptores = nuevos;
+        *capacidad = nueva;
+    }
+
+    descriptor_abierto* d = &tabla->descriptores[tabla->cantidad++];
+    d->fd = fd;
+    d->cierre_en_exec = (fcntl(fd, F_GETFD) & FD_CLOEXEC) != 0;
+    strcpy(d->destino, "?");
+
+    char enlace[32];
+    snprintf(enlace, sizeof(enlace), DIRECTORIO_DESCRIPTORES "/%d", fd);
+    ssize_t largo = readlink(enlace, d->destino, sizeof(d->destino) - 1);
+    if (largo >= 0)
+        d->destino[largo] = '\0'; // readlink() no termina la cadena; los destinos largos quedan truncados
+    return 0;
+}
+
+// Ordenar los descriptores por número
+static int comparar_descriptores(const void* a, const void* b)
+{
+    return ((const descriptor_abierto*)a)->fd - ((const descriptor_abierto*)b)->fd;
+}
+
+// Leer la tabla de descriptores abiertos del shell
+int tabla_descriptores_leer(tabla_descriptores* tabla)
+{
+    int capacidad = 0;
+    tabla->descriptores = NULL;
+    tabla->cantidad = 0;
+
+    DIR* dir = opendir(DIRECTORIO_DESCRIPTORES);
+    if (dir == NULL)
+    {
+        // Sin /proc, probar cada número: más lento y sin destinos, pero igual de exacto
+        for (int fd = 0; fd < FDCHECK_MAX_SIN_PROC; fd++)
+        {
+            if (fcntl(fd, F_GETFD) != -1 && agregar_descriptor(tabla, &capacidad, fd) == -1)
+                return -1;
+        }
+        return 0;
+    }
+
+    struct dirent* entrada;
+    int propio = dirfd(dir); // El descriptor del recorrido no es parte de la tabla
+    while ((entrada = readdir(dir)) != NULL)
+    {
+        char* fin;
+        long fd = strtol(entrada->d_name, &fin, 10);
+        if (*fin != '\0' || fin == entrada->d_name || fd == propio)
+            continue; // "." y ".."
+        if (agregar_descriptor(tabla, &capacidad, (int)fd) == -1)
+        {
+            closedir(dir);
+            return -1;
+        }
+    }
+    closedir(dir);
+
+    qsort(tabla->descriptores, (size_t)tabla->cantidad, sizeof(descriptor_abierto), comparar_descriptores);
+    return 0;
+}
+
+// Liberar una tabla de descriptores
+void tabla_descriptores_liberar(tabla_descriptores* tabla)
+{
+    free(tabla->descriptores);
+    tabla->descriptores = NULL;
+    tabla->cantidad = 0;
+}
+
+// Verificar si un descriptor está en una tabla
+static bool tabla_contiene(const tabla_descriptores* tabla, int fd)
+{
+    for (int i = 0; i < tabla->cantidad; i++)
+    {
+        if (tabla->descriptores[i].fd == fd)
+            return true;
+    }
+    return false;
+}
+
+// Comparar dos fotos de la tabla e informar los problemas de la segunda
+int tabla_descriptores_comparar(const tabla_descriptores* antes, const tabla_descriptores* despues, FILE* informe)
+{
+    int problemas = 0;
+    for (int i = 0; i < despues->cantidad; i++)
+    {
+        const descriptor_abierto* d = &despues->descriptores[i];
+        bool nuevo = antes != NULL && !tabla_contiene(antes, d->fd);
+        bool heredable = d->fd > STDERR_FILENO && !d->cierre_en_exec;
+        if (!nuevo && !heredable)
+            continue;
+
+        problemas++;
+        if (informe != NULL)
+        {
+            fprintf(informe, "fdcheck: fd %d (%s): %s%s%s\n", d->fd, d->destino, nuevo ? "quedó abierto" : "",
+                    nuevo && heredable ? ", " : "", heredable ? "sin FD_CLOEXEC, lo heredan los hijos" : "");
+        }
+    }
+    return problemas;
+}
+
+// Listar los descriptores abiertos del shell
+static void listar_descriptores(const tabla_descriptores* tabla)
+{
+    printf("%-6s %-7s %s\n", "fd", "exec", "destino");
+    for (int i = 0; i < tabla->cantidad; i++)
+    {
+        const descriptor_abierto* d = &tabla->descriptores[i];
+        printf("%-6d %-7s %s\n", d->fd, d->cierre_en_exec ? "cierra" : "hereda", d->destino);
+    }
+}
+
+// Comando "fdcheck"
+int manejar_comando_fdcheck(int argc, char** argv)
+{
+    tabla_descriptores antes;
+    if (tabla_descriptores_leer(&antes) == -1)
+    {
+        fprintf(stderr, "fdcheck: memoria insuficiente\n");
+        return 2;
+    }
+    if (argc == 1)
+    {
+        listar_descriptores(&antes);
+        int problemas = tabla_descriptores_comparar(NULL, &antes, stderr);
+        tabla_descriptores_liberar(&antes);
+        return problemas > 0 ? 1 : 0;
+    }
+
+    // Ejecutar el resto de los argumentos como un comando simple, sin volver a expandirlos
+    palabra* palabras = malloc((size_t)(argc - 1) * sizeof(palabra));
+    if (palabras == NULL)
+    {
+        fprintf(stderr, "fdcheck: memoria insuficiente\n");
+        tabla_descriptores_liberar(&antes);
+        return 2;
+    }
+    for (int i = 1; i < argc; i++)
+    {
+        palabras[i - 1].texto = argv[i];
+        palabras[i - 1].expandir = false;
+    }
+    comando_simple comando = {.palabras = palabras, .num_palabras = argc - 1, .redirecciones = NULL};
+    ejecutar_comando_simple(&comando, false);
+    free(palabras);
+
+    tabla_descriptores despues;
+    int estado = 2;
+    if (tabla_descriptores_leer(&despues) == 0)
+    {
+        fflush(stdout); // La salida del comando, antes que el informe
+        estado = tabla_descriptores_comparar(&antes, &despues, stderr) > 0 ? 1 : 0;
+        tabla_descriptores_liberar(&despues);
+    }
+    else
+    {
+        fprintf(stderr, "fdcheck: memoria insuficiente\n");
+    }
+    tabla_descriptores_liberar(&antes);
+    return estado;
+}
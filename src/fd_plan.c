@@ -0,0 +1,364 @@
+/**
+ * @file fd_plan.c
+ * @brief Compilación de redirecciones en planes de descriptores y aplicación de los planes en el propio shell.
+ */
+
+#include "fd_plan.h"
+#include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**
+ * @brief Tabla de descriptores virtual de plan_aplicar_en_flujos(): a qué descriptor real apunta cada uno.
+ */
+typedef struct
+{
+    int fd[PLAN_MAX_ACCIONES];   /**< Descriptores que cambiaron */
+    int real[PLAN_MAX_ACCIONES]; /**< Descriptor real de cada uno, o -1 si quedó cerrado */
+    int cantidad;                /**< Cantidad de descriptores que cambiaron */
+} tabla_virtual;
+
+// Obtener los flags de open() de una redirección a un archivo
+static int flags_redireccion(tipo_redireccion tipo)
+{
+    switch (tipo)
+    {
+    case REDIR_SALIDA:
+    case REDIR_SALIDA_Y_ERRORES:
+        return O_CREAT | O_WRONLY | O_TRUNC;
+    case REDIR_AGREGAR:
+    case REDIR_AGREGAR_Y_ERRORES:
+        return O_CREAT | O_WRONLY | O_APPEND;
+    case REDIR_LECTURA_ESCRITURA:
+        return O_CREAT | O_RDWR;
+    case REDIR_ENTRADA:
+    default:
+        return O_RDONLY;
+    }
+}
+
+// Interpretar el destino de una duplicación: un número de descriptor, o -1 si es '-' (cerrar)
+static bool leer_descriptor(const char* texto, int* fd)
+{
+    if (strcmp(texto, "-") == 0)
+    {
+        *fd = -1;
+        return true;
+    }
+    long valor = 0;
+    for (const char* c = texto; *c != '\0'; c++)
+    {
+        if (!isdigit((unsigned char)*c))
+            return false;
+        valor = valor * 10 + (*c - '0');
+        if (valor > INT_MAX)
+            return false;
+    }
+    *fd = (int)valor;
+    return *texto != '\0';
+}
+
+// Compilar las redirecciones de un comando en acciones del plan
+int plan_compilar_redirecciones(plan_spawn* plan, arena* a, const redireccion* redirecciones)
+{
+    for (const redireccion* r = redirecciones; r != NULL; r = r->siguiente)
+    {
+        char* destino = expandir_palabra(a, &r->destino);
+        if (destino == NULL)
+        {
+            fprintf(stderr, "Error: memoria insuficiente\n");
+            return -1;
+        }
+
+        int error;
+        if (r->tipo == REDIR_DUPLICAR)
+        {
+            int origen;
+            if (!leer_descriptor(destino, &origen))
+            {
+                fprintf(stderr, "Error: %s: redirección ambigua, se esperaba un descriptor o '-'\n", destino);
+                return -1;
+            }
+            error = origen == -1 ? plan_agregar_cerrar(plan, r->fd) : plan_agregar_dup2(plan, origen, r->fd);
+        }
+        else
+        {
+            error = plan_agregar_abrir(plan, r->fd, destino, flags_redireccion(r->tipo), S_IRUSR | S_IWUSR);
+            if (error == 0 && (r->tipo == REDIR_SALIDA_Y_ERRORES || r->tipo == REDIR_AGREGAR_Y_ERRORES))
+            {
+                error = plan_agregar_dup2(plan, r->fd, STDERR_FILENO); // Los errores van al mismo archivo
+            }
+        }
+        if (error == -1)
+        {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+// Dejar el estado sin nada que deshacer
+static void iniciar_aplicado(plan_aplicado* aplicado)
+{
+    for (int i = 0; i < PLAN_FLUJOS_ESTANDAR; i++)
+    {
+        aplicado->originales[i] = NULL;
+        aplicado->flujos[i] = NULL;
+    }
+    aplicado->num_abiertos = 0;
+    aplicado->num_guardados = 0;
+}
+
+// Informar una duplicación que no se pudo hacer, con el errno que la hizo fallar
+static void informar_duplicacion(const accion_fd* accion)
+{
+    fprintf(stderr, "Error en la redirección %d>&%d: %s\n", accion->fd, accion->fd_origen, strerror(errno));
+}
+
+// Descriptor real detrás de un descriptor de la tabla; los que no cambiaron son los del propio shell
+static int tabla_resolver(const tabla_virtual* tabla, int fd)
+{
+    for (int i = 0; i < tabla->cantidad; i++)
+    {
+        if (tabla->fd[i] == fd)
+            return tabla->real[i];
+    }
+    return fd;
+}
+
+// Hacer que un descriptor de la tabla apunte a un descriptor real
+static void tabla_asignar(tabla_virtual* tabla, int fd, int real)
+{
+    for (int i = 0; i < tabla->cantidad; i++)
+    {
+        if (tabla->fd[i] == fd)
+        {
+            tabla->real[i] = real;
+            return;
+        }
+    }
+    tabla->fd[tabla->cantidad] = fd; // Cada acción agrega a lo sumo un descriptor: nunca se llena
+    tabla->real[tabla->cantidad++] = real;
+}
+
+// Escribir en el descriptor de un flujo reemplazado, completando las escrituras parciales
+static ssize_t escribir_en_descriptor(void* cookie, const char* buffer, size_t largo)
+{
+    int fd = (int)(intptr_t)cookie;
+    size_t escritos = 0;
+    while (escritos < largo)
+    {
+        ssize_t n = write(fd, buffer + escritos, largo - escritos);
+        if (n == -1 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            break; // Devolver menos de lo pedido marca el error en el flujo
+        escritos += (size_t)n;
+    }
+    return (ssize_t)escritos;
+}
+
+// Leer del descriptor de un flujo reemplazado
+static ssize_t leer_de_descriptor(void* cookie, char* buffer, size_t largo)
+{
+    ssize_t n;
+    do
+    {
+        n = read((int)(intptr_t)cookie, buffer, largo);
+    } while (n == -1 && errno == EINTR);
+    return n;
+}
+
+// Crear un flujo sobre un descriptor sin adueñarse de él: cerrar el flujo no cierra el descriptor
+static FILE* flujo_sobre_descriptor(int fd, bool lectura)
+{
+    cookie_io_functions_t funciones = {.read = NULL, .write = NULL, .seek = NULL, .close = NULL};
+    if (lectura)
+        funciones.read = leer_de_descriptor;
+    else
+        funciones.write = escribir_en_descriptor;
+    return fopencookie((void*)(intptr_t)fd, lectura ? "r" : "w", funciones);
+}
+
+// Aplicar un plan a los flujos de stdio
+int plan_aplicar_en_flujos(const plan_spawn* plan, plan_aplicado* aplicado)
+{
+    iniciar_aplicado(aplicado);
+    if (plan->num_acciones == 0)
+    {
+        return 0;
+    }
+
+    // Recorrer las acciones sobre la tabla virtual; sólo las aperturas tocan descriptores reales
+    tabla_virtual tabla;
+    tabla.cantidad = 0;
+    for (int i = 0; i < plan->num_acciones; i++)
+    {
+        const accion_fd* accion = &plan->acciones[i];
+        switch (accion->tipo)
+        {
+        case ACCION_ABRIR: {
+            int fd = open(accion->ruta, accion->flags | O_CLOEXEC, accion->modo);
+            if (fd == -1)
+            {
+                fprintf(stderr, "Error al abrir %s: %s\n", accion->ruta, strerror(errno));
+                return -1;
+            }
+            aplicado->abiertos[aplicado->num_abiertos++] = fd;
+            tabla_asignar(&tabla, accion->fd, fd);
+            break;
+        }
+        case ACCION_DUP2: {
+            int real = tabla_resolver(&tabla, accion->fd_origen);
+            errno = EBADF;
+            if (real == -1 || fcntl(real, F_GETFD) == -1)
+            {
+                informar_duplicacion(accion);
+                return -1;
+            }
+            tabla_asignar(&tabla, accion->fd, real);
+            break;
+        }
+        case ACCION_CERRAR:
+            tabla_asignar(&tabla, accion->fd, -1);
+            break;
+        }
+    }
+
+    // Reemplazar los flujos estándar cuyo descriptor terminó apuntando a otro lugar
+    FILE** estandar[PLAN_FLUJOS_ESTANDAR] = {&stdin, &stdout, &stderr};
+    fflush(stdout); // Lo que ya estaba en los buffers pertenece a los descriptores originales
+    fflush(stderr);
+    for (int i = 0; i < PLAN_FLUJOS_ESTANDAR; i++)
+    {
+        int real = tabla_resolver(&tabla, i);
+        if (real == i)
+        {
+            continue;
+        }
+        FILE* flujo = flujo_sobre_descriptor(real, i == STDIN_FILENO); // Uno cerrado falla con EBADF al usarse
+        if (flujo == NULL)
+        {
+            perror("Error al redirigir un flujo estándar");
+            return -1;
+        }
+        if (i == STDERR_FILENO)
+        {
+            setvbuf(flujo, NULL, _IONBF, 0); // Como stderr, sin buffer
+        }
+        aplicado->originales[i] = *estandar[i];
+        aplicado->flujos[i] = flujo;
+        *estandar[i] = flujo;
+    }
+    return 0;
+}
+
+// Guardar un descriptor del shell antes de reemplazarlo, si todavía no estaba guardado
+static void guardar_descriptor(plan_aplicado* aplicado, int fd)
+{
+    for (int i = 0; i < aplicado->num_guardados; i++)
+    {
+        if (aplicado->guardados[i].fd == fd)
+        {
+            return;
+        }
+    }
+    descriptor_guardado* g = &aplicado->guardados[aplicado->num_guardados++];
+    g->fd = fd;
+    g->copia = fcntl(fd, F_DUPFD_CLOEXEC, 10); // -1 si el descriptor estaba cerrado
+}
+
+// Aplicar un plan sobre los descriptores del propio shell
+int plan_aplicar_en_shell(const plan_spawn* plan, plan_aplicado* aplicado)
+{
+    iniciar_aplicado(aplicado);
+    if (plan->num_acciones == 0)
+    {
+        return 0;
+    }
+
+    fflush(NULL); // Lo que ya estaba en los buffers pertenece a los descriptores originales
+    for (int i = 0; i < plan->num_acciones; i++)
+    {
+        const accion_fd* accion = &plan->acciones[i];
+        guardar_descriptor(aplicado, accion->fd); // Guardar el original la primera vez que cambia
+        switch (accion->tipo)
+        {
+        case ACCION_ABRIR: {
+            int fd = open(accion->ruta, accion->flags | O_CLOEXEC, accion->modo);
+            if (fd == -1)
+            {
+                fprintf(stderr, "Error al abrir %s: %s\n", accion->ruta, strerror(errno));
+                return -1;
+            }
+            if (fd != accion->fd)
+            {
+                dup2(fd, accion->fd); // dup2 deja el descriptor destino sin FD_CLOEXEC
+                close(fd);
+            }
+            else
+            {
+                fcntl(fd, F_SETFD, 0);
+            }
+            break;
+        }
+        case ACCION_DUP2:
+            if (accion->fd_origen == accion->fd ? fcntl(accion->fd, F_GETFD) == -1
+                                                : dup2(accion->fd_origen, accion->fd) == -1)
+            {
+                informar_duplicacion(accion);
+                return -1;
+            }
+            break;
+        case ACCION_CERRAR:
+            close(accion->fd);
+            break;
+        }
+    }
+    return 0;
+}
+
+// Deshacer un plan aplicado
+void plan_restaurar(plan_aplicado* aplicado)
+{
+    FILE** estandar[PLAN_FLUJOS_ESTANDAR] = {&stdin, &stdout, &stderr};
+    for (int i = 0; i < PLAN_FLUJOS_ESTANDAR; i++)
+    {
+        if (aplicado->flujos[i] != NULL)
+        {
+            *estandar[i] = aplicado->originales[i];
+            fclose(aplicado->flujos[i]); // Escribe lo pendiente; el descriptor sigue abierto
+            aplicado->flujos[i] = NULL;
+        }
+    }
+    for (int i = 0; i < aplicado->num_abiertos; i++)
+    {
+        close(aplicado->abiertos[i]);
+    }
+    aplicado->num_abiertos = 0;
+
+    if (aplicado->num_guardados == 0)
+    {
+        return;
+    }
+    fflush(NULL); // Vaciar la salida del comando interno antes de devolver los descriptores
+    for (int i = aplicado->num_guardados - 1; i >= 0; i--)
+    {
+        const descriptor_guardado* g = &aplicado->guardados[i];
+        if (g->copia >= 0)
+        {
+            dup2(g->copia, g->fd);
+            close(g->copia);
+        }
+        else
+        {
+            close(g->fd);
+        }
+    }
+    aplicado->num_guardados = 0;
+}
@@ -0,0 +1,290 @@
+/**
+ * @file file_stream.c
+ * @brief Volcado del contenido de un descriptor en otro sin pasar por buffers del shell.
+ */
+#include "file_stream.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/sendfile.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**
+ *  @brief Bytes por lectura cuando los datos pasan por el shell
+ */
+#define TAM_BLOQUE_VOLCADO 65536
+
+/**
+ *  @brief Máximo de bytes por llamada a sendfile() o splice()
+ */
+#define MAX_ENVIO_DIRECTO ((size_t)1 << 30)
+
+// Escribir todos los bytes, reintentando las escrituras parciales
+static bool escribir_todo(int fd, const char* datos, size_t cantidad)
+{
+    while (cantidad > 0)
+    {
+        ssize_t escritos = write(fd, datos, cantidad);
+        if (escritos == -1)
+        {
+            if (errno == EINTR)
+                continue;
+            return false;
+        }
+        datos += escritos;
+        cantidad -= (size_t)escritos;
+    }
+    return true;
+}
+
+// Largo del prefijo de un bloque que termina con la última de las líneas restantes; las descuenta
+static size_t fin_de_primeras(const char* datos, size_t cantidad, long* restantes)
+{
+    const char* p = datos;
+    const char* fin = datos + cantidad;
+    while (*restantes > 0 && p < fin)
+    {
+        const char* salto = memchr(p, '\n', (size_t)(fin - p));
+        if (salto == NULL)
+            return cantidad;
+        p = salto + 1;
+        (*restantes)--;
+    }
+    return (size_t)(p - datos);
+}
+
+// Desplazamiento en que empiezan las últimas líneas de un bloque; el salto de línea final no abre otra línea
+static size_t inicio_de_ultimas(const char* datos, size_t cantidad, long lineas)
+{
+    size_t limite = cantidad > 0 && datos[cantidad - 1] == '\n' ? cantidad - 1 : cantidad;
+    size_t inicio = cantidad;
+    for (long i = 0; i < lineas; i++)
+    {
+        const char* salto = memrchr(datos, '\n', limite);
+        if (salto == NULL)
+            return 0;
+        limite = (size_t)(salto - datos);
+        inicio = limite + 1;
+    }
+    return inicio;
+}
+
+// Buscar, leyendo por bloques desde el principio del rango, dónde terminan sus primeras líneas
+static bool buscar_primeras(int entrada, off_t desde, off_t hasta, long lineas, off_t* fin)
+{
+    char bloque[TAM_BLOQUE_VOLCADO];
+    long restantes = lineas;
+    off_t posicion = desde;
+    while (restantes > 0 && posicion < hasta)
+    {
+        size_t pedir = hasta - posicion < (off_t)sizeof(bloque) ? (size_t)(hasta - posicion) : sizeof(bloque);
+        ssize_t leidos = pread(entrada, bloque, pedir, posicion);
+        if (leidos == -1 && errno == EINTR)
+            continue;
+        if (leidos == -1)
+            return false;
+        if (leidos == 0)
+            break; // El archivo se acortó
+        posicion += (off_t)fin_de_primeras(bloque, (size_t)leidos, &restantes);
+    }
+    *fin = restantes > 0 ? hasta : posicion;
+    return true;
+}
+
+// Buscar, leyendo por bloques hacia atrás desde el final del rango, dónde empiezan sus últimas líneas
+static bool buscar_ultimas(int entrada, off_t desde, off_t hasta, long lineas, off_t* inicio)
+{
+    char bloque[TAM_BLOQUE_VOLCADO];
+    long restantes = lineas;
+    off_t limite = hasta;
+    *inicio = hasta;
+    while (restantes > 0 && limite > desde)
+    {
+        size_t pedir = limite - desde < (off_t)sizeof(bloque) ? (size_t)(limite - desde) : sizeof(bloque);
+        off_t posicion = limite - (off_t)pedir;
+        ssize_t leidos = pread(entrada, bloque, pedir, posicion);
+        if (leidos == -1 && errno == EINTR)
+            continue;
+        if (leidos == -1)
+            return false;
+
+        size_t cantidad = (size_t)leidos;
+        if (limite == hasta && cantidad > 0 && bloque[cantidad - 1] == '\n')
+            cantidad--; // El salto de línea final no abre otra línea
+        const char* salto;
+        while (restantes > 0 && (salto = memrchr(bloque, '\n', cantidad)) != NULL)
+        {
+            cantidad = (size_t)(salto - bloque);
+            *inicio = posicion + (off_t)cantidad + 1;
+            restantes--;
+        }
+        limite = posicion;
+    }
+    if (restantes > 0)
+        *inicio = desde; // El rango tiene menos líneas que las pedidas
+    return true;
+}
+
+// Copiar con pread()/write() un rango de un archivo regular, avanzando su inicio
+static resultado_volcado copiar_rango(int entrada, int salida, off_t* desde, off_t hasta)
+{
+    char bloque[TAM_BLOQUE_VOLCADO];
+    while (*desde < hasta)
+    {
+        size_t pedir = hasta - *desde < (off_t)sizeof(bloque) ? (size_t)(hasta - *desde) : sizeof(bloque);
+        ssize_t leidos = pread(entrada, bloque, pedir, *desde);
+        if (leidos == -1 && errno == EINTR)
+            continue;
+        if (leidos == -1)
+            return VOLCADO_ERROR_LECTURA;
+        if (leidos == 0)
+            break; // El archivo se acortó
+        if (!escribir_todo(salida, bloque, (size_t)leidos))
+            return VOLCADO_ERROR_ESCRITURA;
+        *desde += leidos;
+    }
+    return VOLCADO_COMPLETO;
+}
+
+// Enviar un rango de un archivo regular, avanzando su inicio: copy_file_range() si la salida es otro archivo
+// regular (el sistema de archivos puede compartir los bloques), si no sendfile(); si el núcleo no puede, copiar
+static resultado_volcado enviar_rango(int entrada, int salida, off_t* desde, off_t hasta)
+{
+    bool entre_archivos = true;
+    while (*desde < hasta)
+    {
+        size_t pedir = hasta - *desde < (off_t)MAX_ENVIO_DIRECTO ? (size_t)(hasta - *desde) : MAX_ENVIO_DIRECTO;
+        ssize_t enviados = -1;
+        if (entre_archivos)
+        {
+            enviados = copy_file_range(entrada, desde, salida, NULL, pedir, 0);
+            if (enviados == -1 && errno != EINTR)
+                entre_archivos = false; // Pipe, terminal, O_APPEND o sistemas de archivos distintos en núcleos viejos
+            if (enviados == -1)
+                continue;
+        }
+        else
+            enviados = sendfile(salida, entrada, desde, pedir);
+        if (enviados == 0)
+            break; // El archivo se acortó
+        if (enviados == -1 && errno != EINTR)
+        {
+            // Por ejemplo, una terminal o una salida con O_APPEND; copiar_rango() distingue además si el error fue
+            // de lectura o de escritura
+            return copiar_rango(entrada, salida, desde, hasta);
+        }
+    }
+    return VOLCADO_COMPLETO;
+}
+
+// Volcar las últimas líneas de una entrada que no se puede leer hacia atrás: se lee entera en memoria
+static resultado_volcado volcar_ultimas_de_flujo(int entrada, int salida, long lineas)
+{
+    char* datos = NULL;
+    size_t cantidad = 0;
+    size_t capacidad = 0;
+    resultado_volcado resultado = VOLCADO_COMPLETO;
+    while (true)
+    {
+        if (capacidad - cantidad < TAM_BLOQUE_VOLCADO)
+        {
+            size_t nueva = capacidad > 0 ? capacidad * 2 : TAM_BLOQUE_VOLCADO;
+            char* ampliados = realloc(datos, nueva);
+            if (ampliados == NULL)
+            {
+                free(datos);
+                errno = ENOMEM;
+                return VOLCADO_ERROR_LECTURA;
+            }
+            datos = ampliados;
+            capacidad = nueva;
+        }
+        ssize_t leidos = read(entrada, datos + cantidad, capacidad - cantidad);
+        if (leidos == -1 && errno == EINTR)
+            continue;
+        if (leidos == -1)
+            resultado = VOLCADO_ERROR_LECTURA;
+        if (leidos <= 0)
+            break;
+        cantidad += (size_t)leidos;
+    }
+    if (resultado == VOLCADO_COMPLETO)
+    {
+        size_t inicio = inicio_de_ultimas(datos, cantidad, lineas);
+        if (!escribir_todo(salida, datos + inicio, cantidad - inicio))
+            resultado = VOLCADO_ERROR_ESCRITURA;
+    }
+    int error = errno;
+    free(datos);
+    errno = error;
+    return resultado;
+}
+
+// Volcar una entrada que no es un archivo regular con tamaño conocido, leyéndola hasta el final
+static resultado_volcado volcar_flujo(int entrada, int salida, modo_volcado modo, long lineas)
+{
+    if (modo == VOLCAR_ULTIMAS)
+        return volcar_ultimas_de_flujo(entrada, salida, lineas);
+
+    if (modo == VOLCAR_TODO)
+    {
+        // splice() mueve las páginas sin copiarlas si uno de los dos extremos es un pipe
+        while (true)
+        {
+            ssize_t movidos = splice(entrada, NULL, salida, NULL, MAX_ENVIO_DIRECTO, SPLICE_F_MOVE);
+            if (movidos == 0)
+                return VOLCADO_COMPLETO;
+            if (movidos == -1 && errno == EPIPE)
+                return VOLCADO_ERROR_ESCRITURA;
+            if (movidos == -1 && errno != EINTR)
+                break; // Ninguno de los extremos es un pipe, o el núcleo no puede: copiar
+        }
+    }
+
+    char bloque[TAM_BLOQUE_VOLCADO];
+    long restantes = lineas;
+    while (modo == VOLCAR_TODO || restantes > 0)
+    {
+        ssize_t leidos = read(entrada, bloque, sizeof(bloque));
+        if (leidos == -1 && errno == EINTR)
+            continue;
+        if (leidos == -1)
+            return VOLCADO_ERROR_LECTURA;
+        if (leidos == 0)
+            break;
+        size_t cantidad = modo == VOLCAR_TODO ? (size_t)leidos : fin_de_primeras(bloque, (size_t)leidos, &restantes);
+        if (!escribir_todo(salida, bloque, cantidad))
+            return VOLCADO_ERROR_ESCRITURA;
+    }
+    return VOLCADO_COMPLETO;
+}
+
+// Volcar el contenido de un descriptor en otro
+resultado_volcado volcar_descriptor(int entrada, int salida, modo_volcado modo, long lineas)
+{
+    struct stat st;
+    if (fstat(entrada, &st) == -1)
+        return VOLCADO_ERROR_LECTURA;
+
+    // Los archivos de /proc y /sys son regulares pero informan tamaño 0: se leen como un flujo
+    off_t desde = S_ISREG(st.st_mode) && st.st_size > 0 ? lseek(entrada, 0, SEEK_CUR) : -1;
+    if (desde == -1)
+        return volcar_flujo(entrada, salida, modo, lineas);
+
+    off_t hasta = st.st_size > desde ? st.st_size : desde;
+    bool encontrado = true;
+    if (modo == VOLCAR_PRIMERAS)
+        encontrado = buscar_primeras(entrada, desde, hasta, lineas, &hasta);
+    else if (modo == VOLCAR_ULTIMAS)
+        encontrado = buscar_ultimas(entrada, desde, hasta, lineas, &desde);
+    if (!encontrado)
+        return VOLCADO_ERROR_LECTURA;
+
+    resultado_volcado resultado = enviar_rango(entrada, salida, &desde, hasta);
+    if (resultado == VOLCADO_COMPLETO)
+        lseek(entrada, desde, SEEK_SET);
+    return resultado;
+}
@@ -0,0 +1,557 @@
+/**
+ * @file jobs.c
+ * @brief Implementación de la tabla de trabajos y del comando interno 'jobs'.
+ */
+
+#include "jobs.h"
+#include "globals.h"
+#include "launcher.h"
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <time.h>
+
+/**
+ * @brief Capacidad inicial de la tabla de PIDs (potencia de dos)
+ */
+#define TRABAJOS_CAPACIDAD_PIDS 64
+
+/**
+ * @brief Entrada de la tabla de PIDs: proceso y trabajo al que pertenece
+ */
+typedef struct
+{
+    pid_t pid;        /**< PID del proceso, 0 si la celda está libre */
+    int indice;       /**< Posición del proceso dentro del pipe */
+    trabajo* trabajo; /**< Trabajo del proceso */
+} entrada_pid;
+
+/**
+ * @brief Bandera que activa el manejador de SIGCHLD
+ */
+volatile sig_atomic_t hijos_pendientes = 0;
+
+/**
+ * @brief Trabajos ordenados por número
+ */
+static trabajo** trabajos = NULL;
+
+/**
+ * @brief Cantidad de trabajos
+ */
+static int num_trabajos = 0;
+
+/**
+ * @brief Capacidad del vector de trabajos
+ */
+static int capacidad_trabajos = 0;
+
+/**
+ * @brief Tabla hash de PID a proceso, con direccionamiento abierto y sondeo lineal
+ */
+static entrada_pid* pids_tabla = NULL;
+
+/**
+ * @brief Capacidad de la tabla de PIDs
+ */
+static size_t capacidad_pids = 0;
+
+/**
+ * @brief Procesos en la tabla de PIDs
+ */
+static size_t ocupadas_pids = 0;
+
+// Hash multiplicativo de un PID
+static size_t hash_pid(pid_t pid)
+{
+    return (size_t)((uint32_t)pid * 2654435761u);
+}
+
+// Buscar la celda de un PID: la ocupada por él o la libre donde debería ir
+static size_t buscar_celda(pid_t pid)
+{
+    size_t mascara = capacidad_pids - 1;
+    size_t i = hash_pid(pid) & mascara;
+    while (pids_tabla[i].pid != 0 && pids_tabla[i].pid != pid)
+    {
+        i = (i + 1) & mascara;
+    }
+    return i;
+}
+
+// Asegurar lugar para n procesos más manteniendo el factor de carga por debajo de 0.7
+static bool reservar_pids(size_t n)
+{
+    size_t nueva_capacidad = capacidad_pids ? capacidad_pids : TRABAJOS_CAPACIDAD_PIDS;
+    while ((ocupadas_pids + n) * 10 > nueva_capacidad * 7)
+    {
+        nueva_capacidad *= 2;
+    }
+    if (nueva_capacidad == capacidad_pids)
+    {
+        return true;
+    }
+
+    entrada_pid* nueva = calloc(nueva_capacidad, sizeof(entrada_pid));
+    if (nueva == NULL)
+    {
+        return false;
+    }
+
+    entrada_pid* vieja = pids_tabla;
+    size_t vieja_capacidad = capacidad_pids;
+    pids_tabla = nueva;
+    capacidad_pids = nueva_capacidad;
+    for (size_t i = 0; i < vieja_capacidad; i++)
+    {
+        if (vieja[i].pid != 0)
+        {
+            pids_tabla[buscar_celda(vieja[i].pid)] = vieja[i];
+        }
+    }
+    free(vieja);
+    return true;
+}
+
+// Buscar un proceso por PID en O(1)
+static entrada_pid* buscar_pid(pid_t pid)
+{
+    if (capacidad_pids == 0 || pid <= 0)
+    {
+        return NULL;
+    }
+    size_t i = buscar_celda(pid);
+    return pids_tabla[i].pid != 0 ? &pids_tabla[i] : NULL;
+}
+
+// Quitar un proceso de la tabla reubicando los siguientes del mismo grupo (borrado sin lápidas)
+static void eliminar_pid(pid_t pid)
+{
+    entrada_pid* entrada = buscar_pid(pid);
+    if (entrada == NULL)
+    {
+        return;
+    }
+
+    size_t mascara = capacidad_pids - 1;
+    size_t i = (size_t)(entrada - pids_tabla);
+    pids_tabla[i].pid = 0;
+    ocupadas_pids--;
+
+    size_t j = i;
+    for (;;)
+    {
+        j = (j + 1) & mascara;
+        if (pids_tabla[j].pid == 0)
+        {
+            return;
+        }
+        size_t ideal = hash_pid(pids_tabla[j].pid) & mascara;
+        // Mover la entrada j al hueco i si su posición ideal no está entre i (exclusivo) y j (inclusivo)
+        bool entre = (i <= j) ? (i < ideal && ideal <= j) : (i < ideal || ideal <= j);
+        if (!entre)
+        {
+            pids_tabla[i] = pids_tabla[j];
+            pids_tabla[j].pid = 0;
+            i = j;
+        }
+    }
+}
+
+// Buscar la posición de un trabajo por número (el vector está ordenado); devuelve -1 si no existe
+static int posicion_trabajo(int id)
+{
+    int desde = 0;
+    int hasta = num_trabajos;
+    while (desde < hasta)
+    {
+        int medio = desde + (hasta - desde) / 2;
+        if (trabajos[medio]->id < id)
+            desde = medio + 1;
+        else
+            hasta = medio;
+    }
+    return desde < num_trabajos && trabajos[desde]->id == id ? desde : -1;
+}
+
+// Agregar un trabajo a la tabla
+trabajo* trabajos_agregar(pid_t pgid, const pid_t* pids, const int* estados, int n, const char* comando,
+                          estado_trabajo estado)
+{
+    if (num_trabajos == capacidad_trabajos)
+    {
+        int nueva_capacidad = capacidad_trabajos ? capacidad_trabajos * 2 : 16;
+        trabajo** nuevo = realloc(trabajos, (size_t)nueva_capacidad * sizeof(trabajo*));
+        if (nuevo == NULL)
+        {
+            return NULL;
+        }
+        trabajos = nuevo;
+        capacidad_trabajos = nueva_capacidad;
+    }
+    if (!reservar_pids((size_t)n))
+    {
+        return NULL;
+    }
+
+    // Un solo bloque para el trabajo, sus PIDs, sus estados y el texto del comando
+    size_t largo = strlen(comando);
+    trabajo* t = malloc(sizeof(trabajo) + (size_t)n * (sizeof(pid_t) + sizeof(int)) + largo + 1);
+    if (t == NULL)
+    {
+        return NULL;
+    }
+    t->pids = (pid_t*)(t + 1);
+    t->estados = (int*)(t->pids + n);
+    t->comando = (char*)(t->estados + n);
+    memcpy(t->comando, comando, largo + 1);
+
+    // Los números crecen con cada trabajo y sólo vuelven a empezar cuando la tabla queda vacía
+    t->id = num_trabajos > 0 ? trabajos[num_trabajos - 1]->id + 1 : 1;
+    t->pgid = pgid;
+    t->num_procesos = n;
+    t->vivos = 0;
+    t->estado = estado;
+    t->notificado = false;
+    struct timespec ahora;
+    clock_gettime(CLOCK_REALTIME, &ahora);
+    t->inicio_ns = (uint64_t)ahora.tv_sec * 1000000000ull + (uint64_t)ahora.tv_nsec;
+    for (int i = 0; i < n; i++)
+    {
+        t->pids[i] = pids[i] > 0 ? pids[i] : -1;
+        t->estados[i] = estados != NULL ? estados[i] : -1;
+        if (t->pids[i] == -1 && t->estados[i] == -1)
+        {
+            t->estados[i] = 127; // Etapa que no se pudo lanzar
+        }
+        if (t->estados[i] == -1)
+        {
+            entrada_pid* entrada = &pids_tabla[buscar_celda(t->pids[i])];
+            entrada->pid = t->pids[i];
+            entrada->indice = i;
+            entrada->trabajo = t;
+            ocupadas_pids++;
+            t->vivos++;
+        }
+    }
+    if (t->vivos == 0)
+    {
+        t->estado = TRABAJO_TERMINADO;
+    }
+
+    trabajos[num_trabajos++] = t;
+    return t;
+}
+
+// Buscar un trabajo a partir de una especificación
+trabajo* trabajos_buscar(const char* especificacion)
+{
+    if (especificacion == NULL || especificacion[0] == '\0' || strcmp(especificacion, "%+") == 0 ||
+        strcmp(especificacion, "%%") == 0)
+    {
+        return num_trabajos > 0 ? trabajos[num_trabajos - 1] : NULL;
+    }
+    if (strcmp(especificacion, "%-") == 0)
+    {
+        return num_trabajos > 1 ? trabajos[num_trabajos - 2] : NULL;
+    }
+
+    bool por_numero = especificacion[0] == '%';
+    const char* digitos = por_numero ? especificacion + 1 : especificacion;
+    char* fin;
+    long numero = strtol(digitos, &fin, 10);
+    if (fin == digitos || *fin != '\0' || numero <= 0 || numero > INT32_MAX)
+    {
+        return NULL;
+    }
+    if (por_numero)
+    {
+        int posicion = posicion_trabajo((int)numero);
+        return posicion != -1 ? trabajos[posicion] : NULL;
+    }
+
+    // Un PID: cualquiera de los procesos vivos o el grupo de procesos del trabajo
+    entrada_pid* entrada = buscar_pid((pid_t)numero);
+    if (entrada != NULL)
+    {
+        return entrada->trabajo;
+    }
+    for (int i = 0; i < num_trabajos; i++)
+    {
+        if (trabajos[i]->pgid == (pid_t)numero)
+        {
+            return trabajos[i];
+        }
+    }
+    return NULL;
+}
+
+// Eliminar un trabajo
+void trabajos_eliminar(trabajo* t)
+{
+    int posicion = posicion_trabajo(t->id);
+    if (posicion == -1)
+    {
+        return;
+    }
+    for (int i = 0; i < t->num_procesos; i++)
+    {
+        if (t->estados[i] == -1)
+        {
+            eliminar_pid(t->pids[i]);
+        }
+    }
+    memmove(&trabajos[posicion], &trabajos[posicion + 1], (size_t)(num_trabajos - posicion - 1) * sizeof(trabajo*));
+    num_trabajos--;
+    free(t);
+}
+
+// Actualizar la tabla después de que otro código recolectó procesos del trabajo
+void trabajos_sincronizar(trabajo* t)
+{
+    for (int i = 0; i < t->num_procesos; i++)
+    {
+        entrada_pid* entrada = buscar_pid(t->pids[i]);
+        if (t->estados[i] != -1 && entrada != NULL && entrada->trabajo == t)
+        {
+            eliminar_pid(t->pids[i]);
+            t->vivos--;
+        }
+    }
+    if (t->vivos == 0)
+    {
+        t->estado = TRABAJO_TERMINADO;
+    }
+}
+
+// Registrar el estado de un proceso recolectado
+static void registrar_recoleccion(entrada_pid* entrada, int status)
+{
+    trabajo* t = entrada->trabajo;
+
+    if (WIFSTOPPED(status))
+    {
+        t->estado = TRABAJO_DETENIDO;
+        t->notificado = false;
+    }
+    else if (WIFCONTINUED(status))
+    {
+        t->estado = TRABAJO_EN_EJECUCION;
+    }
+    else
+    {
+        t->estados[entrada->indice] = codigo_de_salida(status);
+        eliminar_pid(entrada->pid);
+        if (--t->vivos == 0)
+        {
+            t->estado = TRABAJO_TERMINADO;
+            t->notificado = false;
+        }
+    }
+}
+
+// Recolectar los hijos que cambiaron de estado
+void trabajos_actualizar(void)
+{
+    // Con el bucle de eventos SIGCHLD está bloqueada: puede estar pendiente sin que nadie la haya leído todavía
+    sigset_t pendientes;
+    if (!hijos_pendientes && sigpending(&pendientes) == 0 && sigismember(&pendientes, SIGCHLD) == 1)
+    {
+        hijos_pendientes = 1;
+    }
+
+    if (!hijos_pendientes)
+    {
+        return;
+    }
+    hijos_pendientes = 0; // Antes de recolectar: un hijo que cambie después vuelve a activarla
+
+    int status;
+    pid_t pid;
+    while ((pid = waitpid(-1, &status, WNOHANG | WUNTRACED | WCONTINUED)) > 0)
+    {
+        entrada_pid* entrada = buscar_pid(pid);
+        if (entrada != NULL)
+        {
+            registrar_recoleccion(entrada, status);
+        }
+        else if (pid == monitor_pid && !WIFSTOPPED(status) && !WIFCONTINUED(status))
+        {
+            monitor_pid = -1; // El monitor terminó por su cuenta
+        }
+    }
+}
+
+// Texto del estado de un trabajo
+static const char* texto_estado(const trabajo* t, char* buffer, size_t tam)
+{
+    switch (t->estado)
+    {
+    case TRABAJO_EN_EJECUCION:
+        return "Ejecutando";
+    case TRABAJO_DETENIDO:
+        return "Detenido";
+    case TRABAJO_TERMINADO:
+        break;
+    }
+
+    int estado = t->estados[t->num_procesos - 1];
+    if (estado == 0)
+    {
+        return "Hecho";
+    }
+    snprintf(buffer, tam, "Salida %d", estado);
+    return buffer;
+}
+
+// Imprimir la línea de un trabajo al estilo de 'jobs'
+static void imprimir_trabajo(const trabajo* t, int posicion, bool con_grupo)
+{
+    char buffer[32];
+    char marca = posicion == num_trabajos - 1 ? '+' : posicion == num_trabajos - 2 ? '-' : ' ';
+    if (con_grupo)
+    {
+        printf("[%d]%c %d  %-12s%s\n", t->id, marca, t->pgid, texto_estado(t, buffer, sizeof(buffer)), t->comando);
+    }
+    else
+    {
+        printf("[%d]%c  %-12s%s\n", t->id, marca, texto_estado(t, buffer, sizeof(buffer)), t->comando);
+    }
+}
+
+// Quitar de la tabla los trabajos terminados que ya se informaron
+static void compactar_trabajos(void)
+{
+    int quedan = 0;
+    for (int i = 0; i < num_trabajos; i++)
+    {
+        if (trabajos[i]->estado == TRABAJO_TERMINADO && trabajos[i]->notificado)
+        {
+            free(trabajos[i]); // Un trabajo terminado no tiene procesos en la tabla de PIDs
+        }
+        else
+        {
+            trabajos[quedan++] = trabajos[i];
+        }
+    }
+    num_trabajos = quedan;
+}
+
+// Verificar si hay cambios de estado pendientes de aviso
+bool trabajos_hay_avisos(void)
+{
+    for (int i = 0; i < num_trabajos; i++)
+    {
+        if (!trabajos[i]->notificado && trabajos[i]->estado != TRABAJO_EN_EJECUCION)
+            return true;
+    }
+    return false;
+}
+
+// Informar los trabajos con cambios de estado pendientes de aviso
+void trabajos_notificar(void)
+{
+    bool hubo_avisos = false;
+    for (int i = 0; i < num_trabajos; i++)
+    {
+        if (!trabajos[i]->notificado && trabajos[i]->estado != TRABAJO_EN_EJECUCION)
+        {
+            imprimir_trabajo(trabajos[i], i, false);
+            trabajos[i]->notificado = true;
+            hubo_avisos = true;
+        }
+    }
+    if (hubo_avisos)
+    {
+        fflush(stdout);
+        compactar_trabajos();
+    }
+}
+
+// Cantidad de trabajos
+int trabajos_cantidad(void)
+{
+    return num_trabajos;
+}
+
+// Terminar todos los trabajos al salir del shell
+void trabajos_terminar_todos(void)
+{
+    for (int i = 0; i < num_trabajos; i++)
+    {
+        if (trabajos[i]->estado != TRABAJO_TERMINADO)
+        {
+            kill(-trabajos[i]->pgid, SIGTERM);
+            if (trabajos[i]->estado == TRABAJO_DETENIDO)
+            {
+                kill(-trabajos[i]->pgid, SIGCONT); // Un proceso detenido no atiende SIGTERM hasta continuar
+            }
+        }
+        free(trabajos[i]);
+    }
+    free(trabajos);
+    free(pids_tabla);
+    trabajos = NULL;
+    pids_tabla = NULL;
+    num_trabajos = capacidad_trabajos = 0;
+    capacidad_pids = ocupadas_pids = 0;
+}
+
+// Listar un trabajo para 'jobs'; el listado cuenta como aviso de su estado
+static void listar_trabajo(trabajo* t, bool con_grupo, bool solo_grupos)
+{
+    if (solo_grupos)
+    {
+        printf("%d\n", t->pgid);
+    }
+    else
+    {
+        imprimir_trabajo(t, posicion_trabajo(t->id), con_grupo);
+    }
+    t->notificado = true;
+}
+
+// Manejar el comando "jobs"
+int manejar_comando_jobs(int argc, char** argv)
+{
+    bool con_grupo = false;
+    bool solo_grupos = false;
+    int i = 1;
+    for (; i < argc && argv[i][0] == '-'; i++)
+    {
+        if (strcmp(argv[i], "-l") == 0)
+            con_grupo = true;
+        else if (strcmp(argv[i], "-p") == 0)
+            solo_grupos = true;
+        else
+        {
+            fprintf(stderr, "jobs: opción inválida '%s'\nUso: jobs [-l | -p] [%%n...]\n", argv[i]);
+            return 2;
+        }
+    }
+
+    int estado = 0;
+    if (i == argc) // Sin especificaciones: todos los trabajos
+    {
+        for (int j = 0; j < num_trabajos; j++)
+        {
+            listar_trabajo(trabajos[j], con_grupo, solo_grupos);
+        }
+    }
+    for (; i < argc; i++)
+    {
+        trabajo* t = trabajos_buscar(argv[i]);
+        if (t == NULL)
+        {
+            fprintf(stderr, "jobs: %s: no existe ese trabajo\n", argv[i]);
+            estado = 1;
+            continue;
+        }
+        listar_trabajo(t, con_grupo, solo_grupos);
+    }
+    compactar_trabajos();
+    return estado;
+}
@@ -0,0 +1,436 @@
+/**
+ * @file launcher.c
+ * @brief Implementación del lanzador de procesos basado en posix_spawn.
+ */
+
+#include "launcher.h"
+#include "path_cache.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <signal.h>
+#include <spawn.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <poll.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+/**
+ * @brief Entorno del proceso, usado para heredarlo en los hijos
+ */
+extern char** environ;
+
+/**
+ * @brief Señales que el shell maneja o ignora y que deben volver a SIG_DFL en el hijo
+ */
+static const int senales_del_shell[] = {SIGINT, SIGQUIT, SIGTSTP, SIGTTIN, SIGTTOU, SIGCHLD, SIGTERM, SIGPIPE};
+
+// Inicializar un plan vacío
+void plan_inicializar(plan_spawn* plan, char** argv)
+{
+    plan->argv = argv;
+    plan->num_acciones = 0;
+    plan->pgid = 0;
+    plan->restaurar_senales = true;
+}
+
+// Reservar la siguiente acción libre del plan
+static accion_fd* plan_nueva_accion(plan_spawn* plan)
+{
+    if (plan->num_acciones >= PLAN_MAX_ACCIONES)
+    {
+        fprintf(stderr, "Error: demasiadas redirecciones en el comando\n");
+        return NULL;
+    }
+    accion_fd* accion = &plan->acciones[plan->num_acciones++];
+    memset(accion, 0, sizeof(*accion));
+    return accion;
+}
+
+// Agregar la apertura de un archivo
+int plan_agregar_abrir(plan_spawn* plan, int fd, const char* ruta, int flags, mode_t modo)
+{
+    accion_fd* accion = plan_nueva_accion(plan);
+    if (accion == NULL)
+        return -1;
+
+    accion->tipo = ACCION_ABRIR;
+    accion->fd = fd;
+    accion->ruta = ruta;
+    accion->flags = flags;
+    accion->modo = modo;
+    return 0;
+}
+
+// Agregar la duplicación de un descriptor
+int plan_agregar_dup2(plan_spawn* plan, int fd_origen, int fd)
+{
+    accion_fd* accion = plan_nueva_accion(plan);
+    if (accion == NULL)
+        return -1;
+
+    accion->tipo = ACCION_DUP2;
+    accion->fd_origen = fd_origen;
+    accion->fd = fd;
+    return 0;
+}
+
+// Agregar el cierre de un descriptor
+int plan_agregar_cerrar(plan_spawn* plan, int fd)
+{
+    accion_fd* accion = plan_nueva_accion(plan);
+    if (accion == NULL)
+        return -1;
+
+    accion->tipo = ACCION_CERRAR;
+    accion->fd = fd;
+    return 0;
+}
+
+// Descriptor más alto que abre o duplica el plan; 2 si sólo toca la entrada y las salidas estándar
+static int plan_mayor_destino(const plan_spawn* plan)
+{
+    int mayor = STDERR_FILENO;
+    for (int i = 0; i < plan->num_acciones; i++)
+    {
+        if (plan->acciones[i].tipo != ACCION_CERRAR && plan->acciones[i].fd > mayor)
+            mayor = plan->acciones[i].fd;
+    }
+    return mayor;
+}
+
+// Cargar las acciones del plan en las acciones de archivo de posix_spawn
+static int cargar_acciones(const plan_spawn* plan, posix_spawn_file_actions_t* acciones)
+{
+    for (int i = 0; i < plan->num_acciones; i++)
+    {
+        const accion_fd* accion = &plan->acciones[i];
+        int error = 0;
+        switch (accion->tipo)
+        {
+        case ACCION_ABRIR:
+            error = posix_spawn_file_actions_addopen(acciones, accion->fd, accion->ruta, accion->flags, accion->modo);
+            break;
+        case ACCION_DUP2:
+            error = posix_spawn_file_actions_adddup2(acciones, accion->fd_origen, accion->fd);
+            break;
+        case ACCION_CERRAR:
+            error = posix_spawn_file_actions_addclose(acciones, accion->fd);
+            break;
+        }
+        if (error != 0)
+            return error;
+    }
+#ifdef CLOSE_RANGE_CLOEXEC
+    // Cerrar en el hijo todo lo que el plan no dejó en su lugar, aunque al shell se le haya escapado sin O_CLOEXEC
+    int mayor = plan_mayor_destino(plan);
+    if (mayor < INT_MAX)
+        return posix_spawn_file_actions_addclosefrom_np(acciones, mayor + 1);
+#endif
+    return 0;
+}
+
+// Cargar el grupo de procesos y el estado de las señales en los atributos de posix_spawn
+static int cargar_atributos(const plan_spawn* plan, posix_spawnattr_t* atributos)
+{
+    short flags = 0;
+    int error = 0;
+
+    if (plan->pgid != PLAN_SIN_GRUPO)
+    {
+        flags |= POSIX_SPAWN_SETPGROUP;
+        error = posix_spawnattr_setpgroup(atributos, plan->pgid);
+    }
+
+    if (error == 0 && plan->restaurar_senales)
+    {
+        sigset_t por_defecto;
+        sigset_t mascara;
+        sigemptyset(&por_defecto);
+        for (size_t i = 0; i < sizeof(senales_del_shell) / sizeof(senales_del_shell[0]); i++)
+        {
+            sigaddset(&por_defecto, senales_del_shell[i]);
+        }
+        sigemptyset(&mascara);
+
+        flags |= POSIX_SPAWN_SETSIGDEF | POSIX_SPAWN_SETSIGMASK;
+        error = posix_spawnattr_setsigdefault(atributos, &por_defecto);
+        if (error == 0)
+            error = posix_spawnattr_setsigmask(atributos, &mascara);
+    }
+
+    if (error == 0)
+        error = posix_spawnattr_setflags(atributos, flags);
+    return error;
+}
+
+// Verificar si un error de posix_spawn puede deberse a una ruta cacheada que ya no existe
+static bool es_error_de_ruta(int error)
+{
+    return error == ENOENT || error == ENOTDIR || error == EACCES;
+}
+
+// Lanzar el plan con posix_spawn sobre la ruta resuelta por la caché
+pid_t lanzar_plan(const plan_spawn* plan)
+{
+    posix_spawn_file_actions_t acciones;
+    posix_spawnattr_t atributos;
+    char ruta[PATH_MAX];
+    pid_t pid = -1;
+
+    if (plan->argv == NULL || plan->argv[0] == NULL)
+        return -1;
+
+    if (!cache_resolver(plan->argv[0], ruta, sizeof(ruta)))
+    {
+        fprintf(stderr, "Error al ejecutar el programa %s: %s\n", plan->argv[0], strerror(ENOENT));
+        return -1;
+    }
+
+    posix_spawn_file_actions_init(&acciones);
+    posix_spawnattr_init(&atributos);
+
+    int error = cargar_acciones(plan, &acciones);
+    if (error == 0)
+        error = cargar_atributos(plan, &atributos);
+    if (error == 0)
+        error = posix_spawn(&pid, ruta, &acciones, &atributos, plan->argv, environ);
+
+    // Si la ruta cacheada desapareció, descartarla y volver a buscar en $PATH una sola vez
+    if (es_error_de_ruta(error) && cache_olvidar(plan->argv[0]) && cache_resolver(plan->argv[0], ruta, sizeof(ruta)))
+        error = posix_spawn(&pid, ruta, &acciones, &atributos, plan->argv, environ);
+
+    posix_spawnattr_destroy(&atributos);
+    posix_spawn_file_actions_destroy(&acciones);
+
+    if (error != 0)
+    {
+        fprintf(stderr, "Error al ejecutar el programa %s: %s\n", plan->argv[0], strerror(error));
+        return -1;
+    }
+    return pid;
+}
+
+// Aplicar el plan dentro de un hijo creado con fork
+static void aplicar_plan_en_hijo(const plan_spawn* plan)
+{
+    if (plan->pgid != PLAN_SIN_GRUPO)
+        setpgid(0, plan->pgid);
+
+    if (plan->restaurar_senales)
+    {
+        sigset_t mascara;
+        for (size_t i = 0; i < sizeof(senales_del_shell) / sizeof(senales_del_shell[0]); i++)
+        {
+            signal(senales_del_shell[i], SIG_DFL);
+        }
+        sigemptyset(&mascara);
+        sigprocmask(SIG_SETMASK, &mascara, NULL);
+    }
+
+    for (int i = 0; i < plan->num_acciones; i++)
+    {
+        const accion_fd* accion = &plan->acciones[i];
+        switch (accion->tipo)
+        {
+        case ACCION_ABRIR: {
+            // Con O_CLOEXEC, el descriptor intermedio no puede llegar al programa aunque algo falle antes del dup2
+            int fd = open(accion->ruta, accion->flags | O_CLOEXEC, accion->modo);
+            if (fd == -1)
+            {
+                fprintf(stderr, "Error al abrir %s: %s\n", accion->ruta, strerror(errno));
+                _exit(EXIT_FAILURE);
+            }
+            if (fd != accion->fd)
+            {
+                dup2(fd, accion->fd); // dup2 deja el descriptor destino sin FD_CLOEXEC
+                close(fd);
+            }
+            else
+            {
+                fcntl(fd, F_SETFD, 0);
+            }
+            break;
+        }
+        case ACCION_DUP2:
+            // Duplicar un descriptor sobre sí mismo sólo debe quitarle FD_CLOEXEC, como en posix_spawn
+            if (accion->fd_origen == accion->fd ? fcntl(accion->fd, F_SETFD, 0) == -1
+                                                : dup2(accion->fd_origen, accion->fd) == -1)
+            {
+                fprintf(stderr, "Error en la redirección %d>&%d: %s\n", accion->fd, accion->fd_origen, strerror(errno));
+                _exit(EXIT_FAILURE);
+            }
+            break;
+        case ACCION_CERRAR:
+            close(accion->fd);
+            break;
+        }
+    }
+
+#ifdef CLOSE_RANGE_CLOEXEC
+    // Ningún descriptor del shell llega a los programas que ejecute el hijo, salvo los que el plan puso en su lugar
+    if (close_range(STDERR_FILENO + 1, ~0U, CLOSE_RANGE_CLOEXEC) == 0)
+    {
+        for (int i = 0; i < plan->num_acciones; i++)
+        {
+            if (plan->acciones[i].tipo != ACCION_CERRAR && plan->acciones[i].fd > STDERR_FILENO)
+                fcntl(plan->acciones[i].fd, F_SETFD, 0); // Falla sin efecto si una acción posterior lo cerró
+        }
+    }
+#endif
+}
+
+// Lanzar un comando interno en un hijo creado con fork
+pid_t lanzar_con_fork(const plan_spawn* plan, funcion_hijo funcion, void* dato)
+{
+    fflush(NULL); // Evitar que el hijo herede datos pendientes en los buffers de stdio
+
+    pid_t pid = fork();
+    if (pid < 0)
+    {
+        perror("Error al crear el proceso hijo");
+        return -1;
+    }
+    if (pid == 0) // Código del proceso hijo
+    {
+        aplicar_plan_en_hijo(plan);
+        int estado = funcion(dato);
+        fflush(NULL);
+        _exit(estado);
+    }
+    return pid;
+}
+
+// Convertir un estado de wait en un código de salida
+int codigo_de_salida(int status)
+{
+    if (WIFEXITED(status))
+        return WEXITSTATUS(status);
+    if (WIFSIGNALED(status))
+        return 128 + WTERMSIG(status);
+    if (WIFSTOPPED(status))
+        return 128 + WSTOPSIG(status);
+    return 1;
+}
+
+// Obtener un pidfd para un proceso hijo
+static int abrir_pidfd(pid_t pid)
+{
+#ifdef SYS_pidfd_open
+    return (int)syscall(SYS_pidfd_open, pid, 0);
+#else
+    (void)pid;
+    errno = ENOSYS;
+    return -1;
+#endif
+}
+
+// Esperar los procesos uno por uno con waitpid, cuando no hay soporte de pidfd
+static bool esperar_con_waitpid(const pid_t* pids, int n, int* estados)
+{
+    for (int i = 0; i < n; i++)
+    {
+        int status;
+        pid_t resultado;
+        if (pids[i] <= 0)
+            continue;
+        while ((resultado = waitpid(pids[i], &status, WUNTRACED)) == -1 && errno == EINTR)
+            ;
+        if (resultado == -1)
+            continue; // Ya no es un hijo que se pueda esperar
+        if (WIFSTOPPED(status))
+            return true; // Un proceso detenido sigue vivo: su estado no se modifica
+        estados[i] = codigo_de_salida(status);
+    }
+    return false;
+}
+
+// Esperar los procesos indicados con pidfd
+bool esperar_procesos(const pid_t* pids, int n, int* estados)
+{
+    struct pollfd* pidfds = calloc((size_t)n, sizeof(struct pollfd));
+    if (pidfds == NULL)
+        return esperar_con_waitpid(pids, n, estados);
+
+    int pendientes = 0;
+    for (int i = 0; i < n; i++)
+    {
+        pidfds[i].fd = -1; // poll() ignora las posiciones con descriptor negativo
+        pidfds[i].events = POLLIN;
+        if (pids[i] <= 0)
+            continue;
+        pidfds[i].fd = abrir_pidfd(pids[i]);
+        if (pidfds[i].fd == -1)
+        {
+            // Sin pidfd no hay forma de esperar sólo a estos procesos: volver a waitpid
+            for (int j = 0; j < i; j++)
+            {
+                if (pidfds[j].fd >= 0)
+                    close(pidfds[j].fd);
+            }
+            free(pidfds);
+            return esperar_con_waitpid(pids, n, estados);
+        }
+        pendientes++;
+    }
+
+    // SIGCHLD queda bloqueada salvo dentro de ppoll(), así una detención no puede perderse entre la consulta y la
+    // espera. Una terminación además vuelve legible el pidfd. La máscara de ppoll() se arma a partir de la anterior
+    // sin SIGCHLD, que puede estar bloqueada de antes por el bucle de eventos.
+    sigset_t bloqueo;
+    sigset_t anterior;
+    sigset_t durante_espera;
+    sigemptyset(&bloqueo);
+    sigaddset(&bloqueo, SIGCHLD);
+    sigprocmask(SIG_BLOCK, &bloqueo, &anterior);
+    durante_espera = anterior;
+    sigdelset(&durante_espera, SIGCHLD);
+
+    bool detenido = false;
+    while (pendientes > 0 && !detenido)
+    {
+        for (int i = 0; i < n; i++)
+        {
+            siginfo_t info;
+            if (pidfds[i].fd < 0)
+                continue;
+            info.si_pid = 0;
+            int resultado = waitid(P_PIDFD, (id_t)pidfds[i].fd, &info, WEXITED | WSTOPPED | WNOHANG);
+            if ((resultado == 0 && info.si_pid == 0) || (resultado == -1 && errno == EINTR))
+                continue; // Sigue en ejecución
+
+            if (resultado == -1) // Ya no es un hijo que se pueda esperar
+            {
+                close(pidfds[i].fd);
+                pidfds[i].fd = -1;
+                pendientes--;
+                continue;
+            }
+            if (info.si_code == CLD_STOPPED)
+            {
+                detenido = true; // Un proceso detenido sigue vivo: su estado no se modifica
+                continue;
+            }
+            estados[i] = info.si_code == CLD_EXITED ? info.si_status : 128 + info.si_status;
+            close(pidfds[i].fd);
+            pidfds[i].fd = -1;
+            pendientes--;
+        }
+
+        if (pendientes > 0 && !detenido && ppoll(pidfds, (nfds_t)n, NULL, &durante_espera) == -1 && errno != EINTR)
+            break;
+    }
+
+    sigprocmask(SIG_SETMASK, &anterior, NULL);
+    for (int i = 0; i < n; i++)
+    {
+        if (pidfds[i].fd >= 0)
+            close(pidfds[i].fd);
+    }
+    free(pidfds);
+    return detenido;
+}
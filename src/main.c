@@ -11,27 +11,226 @@
  */
 
 // Incluir bibliotecas necesarias
-#include "commands.h"    // Incluir el archivo de funciones de comandos
-#include "globals.h"     // Incluir el archivo de definiciones globales
-#include "shell_utils.h" // Incluir el archivo de utilidades de shell
-#include <stdio.h>       // Incluir la biblioteca estándar de entrada/salida
-#include <termios.h>     // Incluir la biblioteca de control de terminal
+#include "batch.h"        // Incluir la ejecución de archivos de comandos
+#include "commands.h"     // Incluir el archivo de funciones de comandos
+#include "config_store.h" // Incluir la configuración del monitor
+#include "event_loop.h"   // Incluir el bucle de eventos
+#include "globals.h"      // Incluir el archivo de definiciones globales
+#include "jobs.h"         // Incluir la tabla de trabajos
+#include "prompt.h"       // Incluir el motor del prompt
+#include "shell_vars.h"   // Incluir los parámetros posicionales
+#include "shell_utils.h"  // Incluir el archivo de utilidades de shell
+#include <errno.h>        // Incluir los códigos de error
+#include <signal.h>       // Incluir los números de señal
+#include <stdio.h>        // Incluir la biblioteca estándar de entrada/salida
+#include <string.h>       // Incluir strcmp()
+#include <sys/epoll.h>    // Incluir los eventos de epoll
+#include <termios.h>      // Incluir la biblioteca de control de terminal
+#include <time.h>         // Incluir clock_gettime()
+#include <unistd.h>       // Incluir read()
+
+/**
+ *  @brief Bytes que se leen de la entrada por cada evento
+ */
+#define TAM_LECTURA 4096
+
+/**
+ *  @brief Máximo de fases del perfil de arranque
+ */
+#define MAX_FASES 8
+
+/**
+ * @brief Fase del arranque medida con --startup-profile
+ */
+typedef struct
+{
+    const char* nombre; /**< Nombre de la fase */
+    long long ns;       /**< Duración en nanosegundos */
+} fase_arranque;
+
+/**
+ * @brief Perfil de arranque: fases medidas hasta el primer prompt (o hasta el final del script)
+ */
+typedef struct
+{
+    bool activo;                    /**< Se pidió con --startup-profile y todavía no se informó */
+    struct timespec inicio;         /**< Comienzo de main() */
+    struct timespec ultima;         /**< Final de la última fase medida */
+    fase_arranque fases[MAX_FASES]; /**< Fases medidas, en orden */
+    int num_fases;                  /**< Fases medidas */
+} perfil_arranque;
+
+/**
+ *  @brief Perfil de arranque del shell
+ */
+static perfil_arranque perfil;
+
+/**
+ * @brief Entrada del usuario acumulada hasta completar una línea
+ */
+typedef struct
+{
+    char* datos;      /**< Bytes leídos que todavía no forman una línea completa */
+    size_t longitud;  /**< Bytes ocupados */
+    size_t capacidad; /**< Tamaño del buffer */
+    bool fin;         /**< Se alcanzó el final de la entrada */
+    bool salir;       /**< Un comando pidió salir del shell */
+} entrada_terminal;
+
+/**
+ *  @brief Entrada de la terminal
+ */
+static entrada_terminal entrada;
+
+/**
+ *  @brief El prompt debe mostrarse antes de esperar la próxima línea
+ */
+static bool prompt_pendiente = true;
+
+// Nanosegundos entre dos instantes
+static long long ns_entre(const struct timespec* desde, const struct timespec* hasta)
+{
+    return (long long)(hasta->tv_sec - desde->tv_sec) * 1000000000LL + (hasta->tv_nsec - desde->tv_nsec);
+}
+
+// Cerrar una fase del perfil de arranque
+static void marcar_fase(const char* nombre)
+{
+    if (!perfil.activo || perfil.num_fases == MAX_FASES)
+        return;
+    struct timespec ahora;
+    clock_gettime(CLOCK_MONOTONIC, &ahora);
+    perfil.fases[perfil.num_fases].nombre = nombre;
+    perfil.fases[perfil.num_fases++].ns = ns_entre(&perfil.ultima, &ahora);
+    perfil.ultima = ahora;
+}
+
+// Informar el perfil de arranque en stderr, una sola vez
+static void informar_perfil(void)
+{
+    if (!perfil.activo)
+        return;
+    perfil.activo = false;
+    fprintf(stderr, "Perfil de arranque:\n");
+    for (int i = 0; i < perfil.num_fases; i++)
+        fprintf(stderr, "  %-20s %10.3f ms\n", perfil.fases[i].nombre, (double)perfil.fases[i].ns / 1e6);
+    fprintf(stderr, "  %-20s %10.3f ms\n", "total", (double)ns_entre(&perfil.inicio, &perfil.ultima) / 1e6);
+}
+
+// Avisar los trabajos pendientes y mostrar el prompt si hace falta
+static void mostrar_prompt_pendiente(void)
+{
+    if (!prompt_pendiente)
+        return;
+    trabajos_actualizar();
+    trabajos_notificar();
+    prompt_mostrar(); // Vacía stdout antes de escribir el prompt: read() no lo hace como la lectura con stdio
+    prompt_pendiente = false;
+}
+
+// Ejecutar las líneas completas del buffer de entrada
+static void ejecutar_lineas(entrada_terminal* e)
+{
+    size_t inicio = 0;
+    char* salto;
+    while (!e->salir && (salto = memchr(e->datos + inicio, '\n', e->longitud - inicio)) != NULL)
+    {
+        *salto = '\0';
+        mostrar_prompt_pendiente(); // Varias líneas en una misma lectura: un prompt por línea, como antes
+        prompt_antes_de_comando();
+        e->salir = analizar_comando(e->datos + inicio) != 0;
+        prompt_despues_de_comando();
+        prompt_pendiente = true;
+        inicio = (size_t)(salto - e->datos) + 1;
+    }
+    e->longitud -= inicio;
+    memmove(e->datos, e->datos + inicio, e->longitud);
+}
+
+// Leer de la terminal y ejecutar cada línea completa
+static void leer_entrada(int fd, uint32_t eventos __attribute__((unused)), void* dato)
+{
+    entrada_terminal* e = dato;
+    if (e->capacidad - e->longitud < TAM_LECTURA)
+    {
+        char* nuevo = realloc(e->datos, e->capacidad + TAM_LECTURA + 1); // +1 para terminar la última línea
+        if (nuevo == NULL)
+        {
+            perror("realloc");
+            e->fin = true;
+            return;
+        }
+        e->datos = nuevo;
+        e->capacidad += TAM_LECTURA;
+    }
+
+    ssize_t leidos = read(fd, e->datos + e->longitud, e->capacidad - e->longitud);
+    if (leidos == -1 && (errno == EINTR || errno == EAGAIN))
+        return;
+    if (leidos <= 0)
+    {
+        // Final de la entrada: la última línea puede no terminar en salto de línea
+        if (e->longitud > 0)
+            e->datos[e->longitud++] = '\n';
+        e->fin = true;
+    }
+    else
+    {
+        e->longitud += (size_t)leidos;
+    }
+    ejecutar_lineas(e);
+}
+
+// Atender las señales recibidas mientras el shell espera una línea
+static void al_recibir_senal(int sig)
+{
+    if (sig == SIGCHLD)
+    {
+        // Los avisos de trabajos no esperan a que el usuario presione Enter
+        trabajos_actualizar();
+        if (trabajos_hay_avisos())
+        {
+            if (!prompt_pendiente)
+                putchar('\n'); // No escribir sobre el prompt ya mostrado
+            trabajos_notificar();
+            prompt_pendiente = true;
+        }
+    }
+    else if (sig == SIGINT)
+    {
+        // Ctrl+C descarta la línea a medio escribir, como lo hace la terminal
+        putchar('\n');
+        entrada.longitud = 0;
+        prompt_pendiente = true;
+    }
+    // SIGQUIT y SIGTSTP no afectan al shell mientras espera una línea
+}
 
 /** @brief Punto de entrada principal para el programa shell.
  *
- * Este archivo contiene la función principal que inicializa el shell, carga la
- * configuración y procesa los comandos ya sea desde un archivo batch o desde stdin.
+ * Este archivo contiene la función principal que inicializa el shell y procesa los
+ * comandos ya sea desde un archivo batch o desde stdin.
  *
  * El programa opera en dos modos:
  * - Modo interactivo: donde el usuario ingresa comandos a través de stdin.
  * - Modo batch: donde los comandos se leen desde un archivo especificado.
  *
- * El bucle principal lee comandos, los procesa y sale cuando se cumple una condición de salida.
+ * Uso: ShellProject [--startup-profile] [--dump-bytecode] [archivo [argumentos...]]
+ *
+ * El arranque hace sólo lo imprescindible: la terminal se configura únicamente en modo interactivo y la
+ * configuración del monitor (config.json) no se lee ni se escribe hasta que un comando la necesita (ver
+ * config_store.h). Con --startup-profile se informa en stderr la duración de cada fase del arranque, hasta el primer
+ * prompt o, en modo batch, hasta el final del script. Con --dump-bytecode se lista en stderr el bytecode de cada
+ * línea o unidad del script antes de ejecutarla (ver bytecode.h). Los argumentos que siguen al archivo son los
+ * parámetros posicionales del script ($1, $2, ...).
+ *
+ * El bucle principal espera eventos (líneas de la entrada, señales, cambios de estado de los trabajos), procesa cada
+ * línea completa y sale cuando se cumple una condición de salida.
  *
  * Funciones:
  * - inicializar_shell(): Inicializa el entorno del shell.
- * - load_config(): Carga la configuración predeterminada desde un archivo JSON.
- * - mostrar_prompt(): Muestra el prompt del shell.
+ * - config_preparar(): Fija la ruta de la configuración del monitor, sin leerla.
+ * - prompt_mostrar(): Muestra el prompt del shell (ver prompt.h).
  * - analizar_comando(const char* comando): Analiza y procesa el comando dado.
  *
  * @param argc Número de argumentos de la línea de comandos.
@@ -40,62 +239,81 @@
  */
 int main(int argc, char* argv[])
 {
-    inicializar_shell();         // Llamar a la función de inicialización al iniciar la shell
-    load_config();               // Cargar la configuración predeterminada del archivo JSON
-    char comando[MAX_LINE] = ""; // Buffer para almacenar el comando ingresado
-    FILE* batch_file = NULL;     // Puntero al archivo de comandos
-
-    // Verificar si se pasa un archivo de comandos como argumento
-    if (argc == 2)
+    clock_gettime(CLOCK_MONOTONIC, &perfil.inicio);
+    perfil.ultima = perfil.inicio;
+    int primer_argumento = 1;
+    for (; primer_argumento < argc && strncmp(argv[primer_argumento], "--", 2) == 0; primer_argumento++)
     {
-        batch_file = fopen(argv[1], "r"); // Abrir el archivo en modo lectura
-        if (batch_file == NULL)           // Manejar errores al abrir el archivo
+        if (strcmp(argv[primer_argumento], "--startup-profile") == 0)
         {
-            perror("Error al abrir el archivo de comandos");
-            return 1;
+            perfil.activo = true;
+        }
+        else if (strcmp(argv[primer_argumento], "--dump-bytecode") == 0)
+        {
+            opcion_volcar_bytecode = true;
+        }
+        else
+        {
+            fprintf(stderr, "Uso: %s [--startup-profile] [--dump-bytecode] [archivo [argumentos...]]\n", argv[0]);
+            return 2;
         }
     }
 
-    // Bucle principal del shell: lee desde el archivo o stdin según corresponda
-    while (EXIT)
+    inicializar_shell(); // Llamar a la función de inicialización al iniciar la shell
+    marcar_fase("inicializar_shell");
+    config_preparar(); // Sólo la ruta: el archivo se lee cuando un comando lo necesita
+    marcar_fase("config_preparar");
+
+    // Modo batch: ejecutar el archivo de comandos pasado como argumento; el resto son sus parámetros posicionales
+    if (argc > primer_argumento)
     {
-        // Si no estamos en modo batch, mostrar el prompt
-        if (batch_file == NULL)
+        parametros_shell anteriores;
+        parametros_fijar_nombre(argv[primer_argumento]);
+        parametros_cambiar(argc - primer_argumento - 1, argv + primer_argumento + 1, &anteriores);
+        eventos_inicializar(false, NULL); // Sin terminal: el bucle sólo atiende SIGCHLD y los descriptores del shell
+        marcar_fase("eventos_inicializar");
+        int fallos = ejecutar_script(argv[primer_argumento]);
+        marcar_fase("ejecutar_script");
+        informar_perfil();
+        eventos_cerrar();
+        if (fallos == -1) // El archivo no se pudo abrir o leer
         {
-            mostrar_prompt();
+            return 1;
         }
+        printf("Saliendo del shell...\n");
+        return fallos > 0 ? 1 : 0;
+    }
 
-        // Leer el comando desde el archivo o desde stdin
-        if (batch_file)
+    // Bucle principal del shell en modo interactivo: la entrada, las señales y los trabajos llegan como eventos
+    eventos_inicializar(shell_is_interactive, al_recibir_senal);
+    marcar_fase("eventos_inicializar");
+    bool entrada_en_bucle = eventos_agregar_fd(STDIN_FILENO, EPOLLIN, leer_entrada, &entrada) == 0;
+    while (EXIT && !entrada.salir && !entrada.fin)
+    {
+        if (eventos_hubo_salida())
+            prompt_pendiente = true; // Un manejador escribió sobre el prompt
+        mostrar_prompt_pendiente();
+        if (perfil.activo)
         {
-            if (fgets(comando, sizeof(comando), batch_file) == NULL)
-            {
-                break; // Salir si se alcanza el final del archivo
-            }
+            marcar_fase("primer prompt");
+            printf("\n");
+            fflush(stdout);
+            informar_perfil();
+            prompt_pendiente = true; // Volver a mostrar el prompt debajo del informe
+            continue;
         }
-        else
+        if (entrada_en_bucle)
         {
-            if (fgets(comando, sizeof(comando), stdin) == NULL)
-            {
-                break; // Salir si se cierra stdin
-            }
+            eventos_esperar(-1);
         }
-
-        // Eliminar el salto de línea al final del comando
-        comando[strcspn(comando, "\n")] = 0;
-
-        // Analizar y procesar el comando
-        if (analizar_comando(comando))
+        else
         {
-            break;
+            leer_entrada(STDIN_FILENO, EPOLLIN, &entrada); // epoll no admite archivos regulares: leer directamente
         }
     }
 
-    // Cerrar el archivo batch si se abrió
-    if (batch_file != NULL)
-    {
-        fclose(batch_file);
-    }
+    eventos_cerrar();
+    free(entrada.datos);
 
     printf("Saliendo del shell...\n");
     return 0;
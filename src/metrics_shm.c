@@ -0,0 +1,147 @@
+/**
+ * @file metrics_shm.c
+ * @brief Implementación del anillo de muestras de métricas en memoria compartida.
+ */
+
+#include "metrics_shm.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Mapear un segmento ya abierto
+static anillo_metricas* mapear(int fd, bool escritura)
+{
+    int proteccion = escritura ? PROT_READ | PROT_WRITE : PROT_READ;
+    void* mapa = mmap(NULL, sizeof(anillo_metricas), proteccion, MAP_SHARED, fd, 0);
+    close(fd); // El mapeo se mantiene sin el descriptor
+    return mapa == MAP_FAILED ? NULL : mapa;
+}
+
+// Crear el segmento y dejarlo vacío
+anillo_metricas* metricas_crear(const char* nombre)
+{
+    int fd = shm_open(nombre, O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0600);
+    if (fd == -1 && errno == EEXIST)
+    {
+        shm_unlink(nombre); // Segmento abandonado por un shell anterior con el mismo nombre
+        fd = shm_open(nombre, O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0600);
+    }
+    if (fd == -1)
+        return NULL;
+
+    if (ftruncate(fd, (off_t)sizeof(anillo_metricas)) == -1)
+    {
+        close(fd);
+        shm_unlink(nombre);
+        return NULL;
+    }
+
+    // ftruncate() deja el segmento en cero: versiones pares y ninguna muestra publicada
+    anillo_metricas* anillo = mapear(fd, true);
+    if (anillo == NULL)
+    {
+        shm_unlink(nombre);
+        return NULL;
+    }
+    anillo->version = METRICAS_VERSION;
+    anillo->capacidad = METRICAS_CAPACIDAD;
+    atomic_store_explicit(&anillo->escritas, 0, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    anillo->magia = METRICAS_MAGIA; // Al final: un lector que ve la marca ve la cabecera completa
+    return anillo;
+}
+
+// Abrir un segmento existente y validar su formato
+anillo_metricas* metricas_abrir(const char* nombre, bool escritura)
+{
+    int fd = shm_open(nombre, (escritura ? O_RDWR : O_RDONLY) | O_CLOEXEC, 0);
+    if (fd == -1)
+        return NULL;
+
+    struct stat st;
+    if (fstat(fd, &st) == -1 || (size_t)st.st_size < sizeof(anillo_metricas))
+    {
+        close(fd);
+        return NULL;
+    }
+
+    anillo_metricas* anillo = mapear(fd, escritura);
+    if (anillo != NULL && (anillo->magia != METRICAS_MAGIA || anillo->version != METRICAS_VERSION ||
+                           anillo->capacidad != METRICAS_CAPACIDAD))
+    {
+        metricas_cerrar(anillo);
+        return NULL;
+    }
+    return anillo;
+}
+
+// Desmapear el segmento
+void metricas_cerrar(anillo_metricas* anillo)
+{
+    if (anillo != NULL)
+        munmap(anillo, sizeof(anillo_metricas));
+}
+
+// Eliminar el nombre del segmento
+void metricas_eliminar(const char* nombre)
+{
+    shm_unlink(nombre);
+}
+
+// Publicar una muestra en la celda siguiente
+void metricas_publicar(anillo_metricas* anillo, const muestra_metricas* muestra)
+{
+    uint64_t numero = atomic_load_explicit(&anillo->escritas, memory_order_relaxed);
+    celda_metricas* celda = &anillo->celdas[numero & (METRICAS_CAPACIDAD - 1)];
+    uint64_t version = atomic_load_explicit(&celda->version, memory_order_relaxed);
+
+    // Versión impar antes de tocar la muestra: un lector que llegue ahora la descarta
+    atomic_store_explicit(&celda->version, version + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    celda->muestra = *muestra;
+    atomic_store_explicit(&celda->version, version + 2, memory_order_release);
+    atomic_store_explicit(&anillo->escritas, numero + 1, memory_order_release);
+}
+
+// Cantidad de muestras publicadas
+uint64_t metricas_total(const anillo_metricas* anillo)
+{
+    return atomic_load_explicit(&anillo->escritas, memory_order_acquire);
+}
+
+// Leer una muestra, verificando con la versión de la celda que no cambió durante la copia
+bool metricas_leer(const anillo_metricas* anillo, uint64_t numero, muestra_metricas* muestra)
+{
+    if (numero >= metricas_total(anillo))
+        return false;
+
+    const celda_metricas* celda = &anillo->celdas[numero & (METRICAS_CAPACIDAD - 1)];
+    uint64_t esperada = 2 * (numero / METRICAS_CAPACIDAD + 1);
+    if (atomic_load_explicit(&celda->version, memory_order_acquire) != esperada)
+        return false; // Reemplazada, o reemplazándose
+
+    memcpy(muestra, &celda->muestra, sizeof(*muestra));
+    atomic_thread_fence(memory_order_acquire);
+    return atomic_load_explicit(&celda->version, memory_order_relaxed) == esperada;
+}
+
+// Leer las n muestras más recientes
+int metricas_leer_ultimas(const anillo_metricas* anillo, muestra_metricas* muestras, int n)
+{
+    uint64_t total = metricas_total(anillo);
+    uint64_t cantidad = n > 0 ? (uint64_t)n : 0;
+    if (cantidad > METRICAS_CAPACIDAD)
+        cantidad = METRICAS_CAPACIDAD;
+    uint64_t desde = total > cantidad ? total - cantidad : 0;
+
+    int leidas = 0;
+    for (uint64_t k = desde; k < total; k++)
+    {
+        if (metricas_leer(anillo, k, &muestras[leidas]))
+            leidas++; // Las reemplazadas durante la lectura son siempre las más antiguas: se omiten
+    }
+    return leidas;
+}
@@ -0,0 +1,737 @@
+/**
+ * @file metrics_store.c
+ * @brief Implementación del historial de métricas por columnas y del comando interno 'metrics_query'.
+ */
+
+#include "metrics_store.h"
+#include "config_store.h"
+#include "event_loop.h"
+#include "globals.h"
+#include "jobs.h"
+#include "monitor.h"
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/**
+ *  @brief Nanosegundos por segundo
+ */
+#define NS_POR_SEGUNDO 1000000000ull
+
+/**
+ *  @brief Máximo de agregados por consulta
+ */
+#define MAX_AGREGADOS 16
+
+/**
+ * @brief Columna que el almacén sabe llenar a partir de una muestra del monitor
+ */
+typedef struct
+{
+    const char* metrica; /**< Métrica de config.json que la produce */
+    const char* columna; /**< Nombre de la columna */
+    size_t campo;        /**< offsetof del valor en muestra_metricas */
+    bool porcentaje;     /**< Valor entre 0 y 100 (histograma lineal); si no, tasa (histograma logarítmico) */
+} columna_conocida;
+
+/**
+ * @brief Columnas conocidas, en el orden en que se muestran
+ */
+static const columna_conocida columnas_conocidas[] = {
+    {"cpu_usage", "cpu_usage", offsetof(muestra_metricas, cpu), true},
+    {"memory_usage", "memory_usage", offsetof(muestra_metricas, memoria), true},
+    {"network_usage", "network_rx", offsetof(muestra_metricas, red_rx), false},
+    {"network_usage", "network_tx", offsetof(muestra_metricas, red_tx), false},
+};
+
+/**
+ * @brief Nivel de resolución: un anillo de entradas guardado por columnas
+ *
+ * En el nivel crudo cada entrada es una muestra y sólo se usa valores; en los demás cada entrada es un intervalo y se
+ * usan cuenta, minimo, maximo, suma y clases.
+ */
+typedef struct
+{
+    int capacidad;                            /**< Entradas del anillo */
+    uint64_t ancho_ns;                        /**< Duración de un intervalo; 0 en el nivel crudo */
+    uint64_t escritas;                        /**< Entradas escritas desde la creación */
+    uint64_t* inicio;                         /**< Instante de la muestra o comienzo del intervalo */
+    uint32_t* cuenta;                         /**< Muestras de cada intervalo */
+    double* valores[ALMACEN_MAX_COLUMNAS];    /**< Valor de cada muestra */
+    double* minimo[ALMACEN_MAX_COLUMNAS];     /**< Mínimo de cada intervalo */
+    double* maximo[ALMACEN_MAX_COLUMNAS];     /**< Máximo de cada intervalo */
+    double* suma[ALMACEN_MAX_COLUMNAS];       /**< Suma de cada intervalo */
+    uint32_t* clases[ALMACEN_MAX_COLUMNAS];   /**< Histograma de cada intervalo (ALMACEN_CLASES por entrada) */
+} nivel_almacen;
+
+/**
+ * @brief Almacén de métricas
+ */
+struct almacen_metricas
+{
+    int num_columnas;                                    /**< Columnas en uso */
+    const columna_conocida* columnas[ALMACEN_MAX_COLUMNAS]; /**< Columnas, en orden */
+    nivel_almacen niveles[ALMACEN_NIVELES];              /**< Niveles, del más fino al más grueso */
+    uint64_t ultimo_ns;                                  /**< Instante de la última muestra agregada */
+};
+
+/**
+ * @brief Tipo de agregado de una consulta
+ */
+typedef enum
+{
+    AGREGADO_MINIMO,    /**< min */
+    AGREGADO_MAXIMO,    /**< max */
+    AGREGADO_MEDIA,     /**< mean */
+    AGREGADO_CANTIDAD,  /**< count */
+    AGREGADO_PERCENTIL  /**< pNN */
+} tipo_agregado;
+
+/**
+ * @brief Agregado pedido en la línea de comandos
+ */
+typedef struct
+{
+    tipo_agregado tipo; /**< Tipo */
+    int percentil;      /**< Posición en resultado_consulta.percentiles, si es un percentil */
+    char nombre[16];    /**< Nombre, para el encabezado */
+} agregado_consulta;
+
+/**
+ * @brief Nombre de cada nivel de resolución
+ */
+static const char* const nombres_niveles[ALMACEN_NIVELES] = {"crudo", "1 min", "15 min"};
+
+/**
+ * @brief Historial del shell, NULL hasta que se inicia el monitor
+ */
+static almacen_metricas* historial = NULL;
+
+/**
+ * @brief Muestras del anillo del monitor actual ya copiadas al historial
+ */
+static uint64_t historial_leidas = 0;
+
+/**
+ * @brief Temporizador que copia el anillo al historial, -1 si no existe
+ */
+static int temporizador_historial = -1;
+
+// Reservar un vector en cero, registrando si falló
+static void* reservar(size_t n, size_t tam, bool* ok)
+{
+    void* p = calloc(n, tam);
+    if (p == NULL)
+        *ok = false;
+    return p;
+}
+
+// Reservar las columnas de un nivel
+static bool reservar_nivel(nivel_almacen* nivel, int num_columnas, int capacidad, uint64_t ancho_ns)
+{
+    bool ok = true;
+    size_t n = (size_t)capacidad;
+    nivel->capacidad = capacidad;
+    nivel->ancho_ns = ancho_ns;
+    nivel->inicio = reservar(n, sizeof(uint64_t), &ok);
+    if (ancho_ns > 0)
+        nivel->cuenta = reservar(n, sizeof(uint32_t), &ok);
+    for (int c = 0; c < num_columnas; c++)
+    {
+        if (ancho_ns == 0)
+        {
+            nivel->valores[c] = reservar(n, sizeof(double), &ok);
+            continue;
+        }
+        nivel->minimo[c] = reservar(n, sizeof(double), &ok);
+        nivel->maximo[c] = reservar(n, sizeof(double), &ok);
+        nivel->suma[c] = reservar(n, sizeof(double), &ok);
+        nivel->clases[c] = reservar(n * ALMACEN_CLASES, sizeof(uint32_t), &ok);
+    }
+    return ok;
+}
+
+// Liberar las columnas de un nivel
+static void liberar_nivel(nivel_almacen* nivel)
+{
+    free(nivel->inicio);
+    free(nivel->cuenta);
+    for (int c = 0; c < ALMACEN_MAX_COLUMNAS; c++)
+    {
+        free(nivel->valores[c]);
+        free(nivel->minimo[c]);
+        free(nivel->maximo[c]);
+        free(nivel->suma[c]);
+        free(nivel->clases[c]);
+    }
+}
+
+// Crear un almacén vacío
+almacen_metricas* almacen_crear(const char* const* metricas, int n)
+{
+    almacen_metricas* almacen = calloc(1, sizeof(almacen_metricas));
+    if (almacen == NULL)
+        return NULL;
+
+    // Las columnas se agregan en el orden de la tabla, una sola vez aunque la métrica se repita
+    for (size_t k = 0; k < sizeof(columnas_conocidas) / sizeof(columnas_conocidas[0]); k++)
+    {
+        bool pedida = metricas == NULL;
+        for (int i = 0; i < n && !pedida; i++)
+            pedida = strcmp(metricas[i], columnas_conocidas[k].metrica) == 0;
+        if (pedida && almacen->num_columnas < ALMACEN_MAX_COLUMNAS)
+            almacen->columnas[almacen->num_columnas++] = &columnas_conocidas[k];
+    }
+
+    bool ok = almacen->num_columnas > 0;
+    if (ok)
+    {
+        ok = reservar_nivel(&almacen->niveles[0], almacen->num_columnas, ALMACEN_CAPACIDAD_CRUDA, 0) &&
+             reservar_nivel(&almacen->niveles[1], almacen->num_columnas, ALMACEN_CAPACIDAD_NIVEL_1,
+                            ALMACEN_ANCHO_NIVEL_1 * NS_POR_SEGUNDO) &&
+             reservar_nivel(&almacen->niveles[2], almacen->num_columnas, ALMACEN_CAPACIDAD_NIVEL_2,
+                            ALMACEN_ANCHO_NIVEL_2 * NS_POR_SEGUNDO);
+    }
+    if (!ok)
+    {
+        almacen_liberar(almacen);
+        return NULL;
+    }
+    return almacen;
+}
+
+// Liberar un almacén
+void almacen_liberar(almacen_metricas* almacen)
+{
+    if (almacen == NULL)
+        return;
+    for (int i = 0; i < ALMACEN_NIVELES; i++)
+        liberar_nivel(&almacen->niveles[i]);
+    free(almacen);
+}
+
+// Clase del histograma de un valor: lineal para porcentajes, potencias de dos para tasas
+static int clase_de(double v, bool porcentaje)
+{
+    if (porcentaje)
+    {
+        int k = (int)(v / 100.0 * ALMACEN_CLASES);
+        return k < 0 ? 0 : (k >= ALMACEN_CLASES ? ALMACEN_CLASES - 1 : k);
+    }
+    if (!(v >= 1.0))
+        return 0;
+    int k = 1;
+    while (v >= 2.0 && k < ALMACEN_CLASES - 1)
+    {
+        v /= 2.0;
+        k++;
+    }
+    return k;
+}
+
+// Límites de los valores de una clase del histograma
+static void limites_clase(int k, bool porcentaje, double* bajo, double* alto)
+{
+    if (porcentaje)
+    {
+        *bajo = 100.0 * k / ALMACEN_CLASES;
+        *alto = 100.0 * (k + 1) / ALMACEN_CLASES;
+        return;
+    }
+    *bajo = k == 0 ? 0.0 : 1.0;
+    for (int i = 1; i < k; i++)
+        *bajo *= 2.0;
+    *alto = k == 0 ? 1.0 : *bajo * 2.0;
+}
+
+// Valor de una columna dentro de una muestra
+static double valor_columna(const muestra_metricas* m, const columna_conocida* columna)
+{
+    return *(const double*)((const char*)m + columna->campo);
+}
+
+// Agregar una muestra a un nivel de intervalos
+static void agregar_intervalo(almacen_metricas* almacen, nivel_almacen* nivel, const muestra_metricas* muestra)
+{
+    uint64_t comienzo = muestra->instante_ns - muestra->instante_ns % nivel->ancho_ns;
+    if (nivel->escritas == 0 || nivel->inicio[(nivel->escritas - 1) % (uint64_t)nivel->capacidad] != comienzo)
+    {
+        size_t nuevo = (size_t)(nivel->escritas % (uint64_t)nivel->capacidad);
+        nivel->inicio[nuevo] = comienzo;
+        nivel->cuenta[nuevo] = 0;
+        for (int c = 0; c < almacen->num_columnas; c++)
+            memset(&nivel->clases[c][nuevo * ALMACEN_CLASES], 0, ALMACEN_CLASES * sizeof(uint32_t));
+        nivel->escritas++;
+    }
+
+    size_t e = (size_t)((nivel->escritas - 1) % (uint64_t)nivel->capacidad);
+    for (int c = 0; c < almacen->num_columnas; c++)
+    {
+        double v = valor_columna(muestra, almacen->columnas[c]);
+        if (nivel->cuenta[e] == 0 || v < nivel->minimo[c][e])
+            nivel->minimo[c][e] = v;
+        if (nivel->cuenta[e] == 0 || v > nivel->maximo[c][e])
+            nivel->maximo[c][e] = v;
+        nivel->suma[c][e] = nivel->cuenta[e] == 0 ? v : nivel->suma[c][e] + v;
+        nivel->clases[c][e * ALMACEN_CLASES + (size_t)clase_de(v, almacen->columnas[c]->porcentaje)]++;
+    }
+    nivel->cuenta[e]++;
+}
+
+// Agregar una muestra a todos los niveles
+void almacen_agregar(almacen_metricas* almacen, const muestra_metricas* muestra)
+{
+    if (muestra->instante_ns < almacen->ultimo_ns)
+        return;
+    almacen->ultimo_ns = muestra->instante_ns;
+
+    nivel_almacen* crudo = &almacen->niveles[0];
+    size_t e = (size_t)(crudo->escritas % (uint64_t)crudo->capacidad);
+    crudo->inicio[e] = muestra->instante_ns;
+    for (int c = 0; c < almacen->num_columnas; c++)
+        crudo->valores[c][e] = valor_columna(muestra, almacen->columnas[c]);
+    crudo->escritas++;
+
+    for (int i = 1; i < ALMACEN_NIVELES; i++)
+        agregar_intervalo(almacen, &almacen->niveles[i], muestra);
+}
+
+// Copiar las muestras nuevas del anillo
+int almacen_copiar_anillo(almacen_metricas* almacen, const anillo_metricas* anillo, uint64_t* leidas)
+{
+    uint64_t total = metricas_total(anillo);
+    if (total - *leidas > METRICAS_CAPACIDAD)
+        *leidas = total - METRICAS_CAPACIDAD; // Las anteriores ya se reemplazaron en el anillo
+
+    int copiadas = 0;
+    muestra_metricas muestra;
+    for (uint64_t k = *leidas; k < total; k++)
+    {
+        if (metricas_leer(anillo, k, &muestra))
+        {
+            almacen_agregar(almacen, &muestra);
+            copiadas++;
+        }
+    }
+    *leidas = total;
+    return copiadas;
+}
+
+// Buscar las columnas de una métrica
+int almacen_columnas(const almacen_metricas* almacen, const char* metrica, const char** columnas, int max)
+{
+    int n = 0;
+    for (int c = 0; c < almacen->num_columnas && n < max; c++)
+    {
+        const columna_conocida* columna = almacen->columnas[c];
+        if (metrica == NULL || strcmp(metrica, columna->columna) == 0 || strcmp(metrica, columna->metrica) == 0)
+            columnas[n++] = columna->columna;
+    }
+    return n;
+}
+
+// Primera entrada que todavía guarda un nivel
+static uint64_t primera_entrada(const nivel_almacen* nivel)
+{
+    return nivel->escritas > (uint64_t)nivel->capacidad ? nivel->escritas - (uint64_t)nivel->capacidad : 0;
+}
+
+// Instante de una entrada de un nivel
+static uint64_t inicio_entrada(const nivel_almacen* nivel, uint64_t entrada)
+{
+    return nivel->inicio[entrada % (uint64_t)nivel->capacidad];
+}
+
+// Primera entrada del nivel que termina después de desde_ns (búsqueda binaria: los instantes están ordenados)
+static uint64_t buscar_desde(const nivel_almacen* nivel, uint64_t desde_ns)
+{
+    uint64_t ancho = nivel->ancho_ns > 0 ? nivel->ancho_ns : 1;
+    uint64_t bajo = primera_entrada(nivel);
+    uint64_t alto = nivel->escritas;
+    while (bajo < alto)
+    {
+        uint64_t medio = bajo + (alto - bajo) / 2;
+        if (inicio_entrada(nivel, medio) + ancho > desde_ns)
+            alto = medio;
+        else
+            bajo = medio + 1;
+    }
+    return bajo;
+}
+
+// Nivel más fino que guarda toda la ventana, o el más grueso si ninguno llega tan atrás
+static int elegir_nivel(const almacen_metricas* almacen, uint64_t desde_ns)
+{
+    for (int i = 0; i < ALMACEN_NIVELES; i++)
+    {
+        const nivel_almacen* nivel = &almacen->niveles[i];
+        if (nivel->escritas <= (uint64_t)nivel->capacidad || inicio_entrada(nivel, primera_entrada(nivel)) <= desde_ns)
+            return i;
+    }
+    return ALMACEN_NIVELES - 1;
+}
+
+// Comparar dos valores para qsort()
+static int comparar_valores(const void* a, const void* b)
+{
+    double x = *(const double*)a;
+    double y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+// Percentiles exactos sobre las muestras crudas de la ventana
+static void percentiles_crudos(const nivel_almacen* nivel, int c, uint64_t desde, uint64_t hasta,
+                               const double* percentiles, resultado_consulta* resultado)
+{
+    double* ordenados = malloc((size_t)resultado->cantidad * sizeof(double));
+    if (ordenados == NULL)
+    {
+        for (int p = 0; p < resultado->num_percentiles; p++)
+            resultado->percentiles[p] = resultado->media; // Sin memoria para ordenar, la mejor aproximación
+        return;
+    }
+    size_t n = 0;
+    for (uint64_t e = desde; e < hasta; e++)
+        ordenados[n++] = nivel->valores[c][e % (uint64_t)nivel->capacidad];
+    qsort(ordenados, n, sizeof(double), comparar_valores);
+
+    for (int p = 0; p < resultado->num_percentiles; p++)
+    {
+        double posicion = percentiles[p] / 100.0 * (double)(n - 1); // Interpolación entre los rangos vecinos
+        size_t i = (size_t)posicion;
+        double fraccion = posicion - (double)i;
+        resultado->percentiles[p] = i + 1 < n ? ordenados[i] + fraccion * (ordenados[i + 1] - ordenados[i])
+                                              : ordenados[n - 1];
+    }
+    free(ordenados);
+}
+
+// Percentiles aproximados con la suma de los histogramas de los intervalos de la ventana
+static void percentiles_intervalos(const nivel_almacen* nivel, int c, bool porcentaje, uint64_t desde, uint64_t hasta,
+                                   const double* percentiles, resultado_consulta* resultado)
+{
+    uint64_t clases[ALMACEN_CLASES] = {0};
+    for (uint64_t e = desde; e < hasta; e++)
+    {
+        const uint32_t* h = &nivel->clases[c][(size_t)(e % (uint64_t)nivel->capacidad) * ALMACEN_CLASES];
+        for (int k = 0; k < ALMACEN_CLASES; k++)
+            clases[k] += h[k];
+    }
+
+    for (int p = 0; p < resultado->num_percentiles; p++)
+    {
+        double rango = percentiles[p] / 100.0 * (double)resultado->cantidad;
+        double v = resultado->minimo;
+        uint64_t acumuladas = 0;
+        for (int k = 0; k < ALMACEN_CLASES && rango > 0; k++)
+        {
+            if (clases[k] == 0 || (double)(acumuladas + clases[k]) < rango)
+            {
+                acumuladas += clases[k];
+                continue;
+            }
+            double bajo, alto;
+            limites_clase(k, porcentaje, &bajo, &alto);
+            v = bajo + (rango - (double)acumuladas) / (double)clases[k] * (alto - bajo); // Uniforme dentro de la clase
+            break;
+        }
+        // La clase sólo acota el valor: el mínimo y el máximo exactos lo acotan mejor
+        v = v < resultado->minimo ? resultado->minimo : v;
+        resultado->percentiles[p] = v > resultado->maximo ? resultado->maximo : v;
+    }
+}
+
+// Calcular los agregados de una métrica en una ventana
+int almacen_consultar(const almacen_metricas* almacen, const char* metrica, uint64_t desde_ns, uint64_t hasta_ns,
+                      int nivel, const double* percentiles, int num_percentiles, resultado_consulta* resultado)
+{
+    int c = 0;
+    while (c < almacen->num_columnas && strcmp(almacen->columnas[c]->columna, metrica) != 0)
+        c++;
+    if (c == almacen->num_columnas)
+        return -1;
+
+    memset(resultado, 0, sizeof(*resultado));
+    resultado->nivel = nivel >= 0 && nivel < ALMACEN_NIVELES ? nivel : elegir_nivel(almacen, desde_ns);
+    resultado->num_percentiles = num_percentiles < ALMACEN_MAX_PERCENTILES ? num_percentiles : ALMACEN_MAX_PERCENTILES;
+
+    // La ventana es un rango contiguo de entradas: los instantes de cada nivel crecen
+    const nivel_almacen* n = &almacen->niveles[resultado->nivel];
+    uint64_t desde = buscar_desde(n, desde_ns);
+    uint64_t hasta = desde;
+    while (hasta < n->escritas && inicio_entrada(n, hasta) <= hasta_ns)
+        hasta++;
+    if (desde == hasta)
+        return 1;
+
+    double suma = 0;
+    for (uint64_t e = desde; e < hasta; e++)
+    {
+        size_t i = (size_t)(e % (uint64_t)n->capacidad);
+        double minimo = n->ancho_ns > 0 ? n->minimo[c][i] : n->valores[c][i];
+        double maximo = n->ancho_ns > 0 ? n->maximo[c][i] : n->valores[c][i];
+        if (e == desde || minimo < resultado->minimo)
+            resultado->minimo = minimo;
+        if (e == desde || maximo > resultado->maximo)
+            resultado->maximo = maximo;
+        suma += n->ancho_ns > 0 ? n->suma[c][i] : n->valores[c][i];
+        resultado->cantidad += n->ancho_ns > 0 ? n->cuenta[i] : 1;
+    }
+    resultado->media = suma / (double)resultado->cantidad;
+
+    if (n->ancho_ns == 0)
+        percentiles_crudos(n, c, desde, hasta, percentiles, resultado);
+    else
+        percentiles_intervalos(n, c, almacen->columnas[c]->porcentaje, desde, hasta, percentiles, resultado);
+    return 0;
+}
+
+// Copiar periódicamente el anillo del monitor al historial
+static void al_vencer_copia(int fd __attribute__((unused)), uint32_t eventos __attribute__((unused)),
+                            void* dato __attribute__((unused)))
+{
+    historial_sincronizar(monitor_metricas());
+}
+
+// Crear el historial con las métricas de la configuración; sin métricas, con todas las que publica el monitor
+static almacen_metricas* crear_historial(void)
+{
+    const char* nombres[32];
+    int n = config_metricas(nombres, 32);
+    return n > 0 ? almacen_crear(nombres, n) : almacen_crear(NULL, 0);
+}
+
+// Preparar el historial para un monitor recién iniciado
+void historial_iniciar(void)
+{
+    historial_leidas = 0; // Cada monitor publica en un segmento nuevo
+    if (historial == NULL)
+    {
+        historial = crear_historial();
+        if (historial == NULL)
+        {
+            fprintf(stderr, "Aviso: config.json no tiene métricas que el historial pueda guardar\n");
+            return;
+        }
+    }
+    if (temporizador_historial == -1)
+    {
+        temporizador_historial =
+            eventos_agregar_temporizador(ALMACEN_PERIODO_COPIA * 1000, true, al_vencer_copia, NULL);
+    }
+}
+
+// Copiar al historial las muestras pendientes del anillo
+void historial_sincronizar(const anillo_metricas* anillo)
+{
+    if (historial != NULL && anillo != NULL)
+        almacen_copiar_anillo(historial, anillo, &historial_leidas);
+}
+
+// Liberar el historial del shell
+void historial_liberar(void)
+{
+    if (temporizador_historial != -1)
+    {
+        eventos_quitar_fd(temporizador_historial);
+        temporizador_historial = -1;
+    }
+    almacen_liberar(historial);
+    historial = NULL;
+}
+
+// Leer una duración con unidad (s, m, h o d), en nanosegundos
+static bool leer_duracion(const char* texto, uint64_t* ns)
+{
+    char* fin;
+    unsigned long long numero = texto != NULL ? strtoull(texto, &fin, 10) : 0;
+    if (texto == NULL || fin == texto || numero == 0 || numero > 366ull * 86400)
+        return false;
+    unsigned long long unidad = 1;
+    if (strcmp(fin, "m") == 0)
+        unidad = 60;
+    else if (strcmp(fin, "h") == 0)
+        unidad = 3600;
+    else if (strcmp(fin, "d") == 0)
+        unidad = 86400;
+    else if (*fin != '\0' && strcmp(fin, "s") != 0)
+        return false;
+    *ns = (uint64_t)(numero * unidad) * NS_POR_SEGUNDO;
+    return true;
+}
+
+// Leer el comienzo de la ventana: %n (inicio de un trabajo) o segundos desde la época
+static bool leer_comienzo(const char* texto, uint64_t* ns)
+{
+    if (texto != NULL && texto[0] == '%')
+    {
+        trabajo* t = trabajos_buscar(texto);
+        if (t == NULL)
+            return false;
+        *ns = t->inicio_ns;
+        return true;
+    }
+    char* fin;
+    unsigned long long segundos = texto != NULL ? strtoull(texto, &fin, 10) : 0;
+    if (texto == NULL || fin == texto || *fin != '\0')
+        return false;
+    *ns = (uint64_t)segundos * NS_POR_SEGUNDO;
+    return true;
+}
+
+// Leer un nivel de resolución (0 a ALMACEN_NIVELES - 1)
+static bool leer_nivel(const char* texto, int* nivel)
+{
+    if (texto == NULL || texto[0] < '0' || texto[0] >= '0' + ALMACEN_NIVELES || texto[1] != '\0')
+        return false;
+    *nivel = texto[0] - '0';
+    return true;
+}
+
+// Leer la lista de agregados separados por comas
+static int leer_agregados(const char* texto, agregado_consulta* agregados, double* percentiles, int* num_percentiles)
+{
+    int n = 0;
+    *num_percentiles = 0;
+    while (*texto != '\0')
+    {
+        size_t largo = strcspn(texto, ",");
+        if (largo == 0 || largo >= sizeof(agregados[0].nombre) || n == MAX_AGREGADOS)
+            return -1;
+        agregado_consulta* a = &agregados[n++];
+        memcpy(a->nombre, texto, largo);
+        a->nombre[largo] = '\0';
+        texto += largo + (texto[largo] == ',');
+
+        if (strcmp(a->nombre, "min") == 0)
+            a->tipo = AGREGADO_MINIMO;
+        else if (strcmp(a->nombre, "max") == 0)
+            a->tipo = AGREGADO_MAXIMO;
+        else if (strcmp(a->nombre, "mean") == 0)
+            a->tipo = AGREGADO_MEDIA;
+        else if (strcmp(a->nombre, "count") == 0)
+            a->tipo = AGREGADO_CANTIDAD;
+        else
+        {
+            char* fin;
+            double p = a->nombre[0] == 'p' ? strtod(a->nombre + 1, &fin) : -1;
+            if (p < 0 || p > 100 || fin == a->nombre + 1 || *fin != '\0' || *num_percentiles == ALMACEN_MAX_PERCENTILES)
+                return -1;
+            a->tipo = AGREGADO_PERCENTIL;
+            a->percentil = *num_percentiles;
+            percentiles[(*num_percentiles)++] = p;
+        }
+    }
+    return n;
+}
+
+// Mostrar el uso del comando
+static int uso_metrics_query(const char* error, const char* texto)
+{
+    fprintf(stderr, "metrics_query: %s '%s'\n", error, texto);
+    fprintf(stderr, "Uso: metrics_query [-w ventana | -s desde] [-r nivel] agregado[,agregado...] [métrica...]\n");
+    return 2;
+}
+
+// Manejar el comando "metrics_query"
+int manejar_comando_metrics_query(int argc, char** argv)
+{
+    struct timespec ahora;
+    clock_gettime(CLOCK_REALTIME, &ahora);
+    uint64_t hasta_ns = (uint64_t)ahora.tv_sec * NS_POR_SEGUNDO + (uint64_t)ahora.tv_nsec;
+    uint64_t desde_ns = 0;
+    uint64_t ventana_ns = 0;
+    int nivel = -1;
+
+    int i = 1;
+    for (; i < argc && argv[i][0] == '-'; i += 2)
+    {
+        bool valida = false;
+        if (strcmp(argv[i], "-w") == 0)
+        {
+            valida = leer_duracion(argv[i + 1], &ventana_ns);
+            desde_ns = valida && ventana_ns < hasta_ns ? hasta_ns - ventana_ns : 0;
+        }
+        else if (strcmp(argv[i], "-s") == 0)
+            valida = leer_comienzo(argv[i + 1], &desde_ns);
+        else if (strcmp(argv[i], "-r") == 0)
+            valida = leer_nivel(argv[i + 1], &nivel);
+        if (!valida)
+            return uso_metrics_query("opción inválida", argv[i]);
+    }
+
+    agregado_consulta agregados[MAX_AGREGADOS];
+    double percentiles[ALMACEN_MAX_PERCENTILES];
+    int num_percentiles;
+    int num_agregados = i < argc ? leer_agregados(argv[i], agregados, percentiles, &num_percentiles) : -1;
+    if (num_agregados <= 0)
+        return uso_metrics_query("agregados inválidos", i < argc ? argv[i] : "");
+    i++;
+
+    if (historial == NULL)
+    {
+        fprintf(stderr, "metrics_query: no hay historial; inicie el monitor con start_monitor\n");
+        return 1;
+    }
+    historial_sincronizar(monitor_metricas());
+
+    // Resolver las métricas antes de mostrar nada: network_usage equivale a sus dos columnas
+    const char* columnas[ALMACEN_MAX_COLUMNAS * 4];
+    int num_columnas = 0;
+    if (i == argc)
+        num_columnas = almacen_columnas(historial, NULL, columnas, ALMACEN_MAX_COLUMNAS);
+    for (; i < argc; i++)
+    {
+        int n = almacen_columnas(historial, argv[i], columnas + num_columnas,
+                                 (int)(sizeof(columnas) / sizeof(columnas[0])) - num_columnas);
+        if (n == 0)
+        {
+            fprintf(stderr, "metrics_query: '%s' no es una métrica del historial\n", argv[i]);
+            return 2;
+        }
+        num_columnas += n;
+    }
+
+    printf("%-15s %9s %7s", "métrica", "muestras", "nivel"); // La tilde ocupa dos bytes
+    for (int a = 0; a < num_agregados; a++)
+        printf(" %12s", agregados[a].nombre);
+    printf("\n");
+
+    int estado = 0;
+    for (int c = 0; c < num_columnas; c++)
+    {
+        resultado_consulta r;
+        if (almacen_consultar(historial, columnas[c], desde_ns, hasta_ns, nivel, percentiles, num_percentiles, &r) != 0)
+        {
+            printf("%-14s %9d %7s  sin muestras en la ventana\n", columnas[c], 0, nombres_niveles[r.nivel]);
+            estado = 1;
+            continue;
+        }
+        printf("%-14s %9llu %7s", columnas[c], (unsigned long long)r.cantidad, nombres_niveles[r.nivel]);
+        for (int a = 0; a < num_agregados; a++)
+        {
+            switch (agregados[a].tipo)
+            {
+            case AGREGADO_MINIMO:
+                printf(" %12.2f", r.minimo);
+                break;
+            case AGREGADO_MAXIMO:
+                printf(" %12.2f", r.maximo);
+                break;
+            case AGREGADO_MEDIA:
+                printf(" %12.2f", r.media);
+                break;
+            case AGREGADO_CANTIDAD:
+                printf(" %12llu", (unsigned long long)r.cantidad);
+                break;
+            case AGREGADO_PERCENTIL:
+                printf(" %12.2f", r.percentiles[agregados[a].percentil]);
+                break;
+            }
+        }
+        printf("\n");
+    }
+    return estado;
+}
@@ -4,24 +4,281 @@
  */
 
 #include "monitor.h"
+#include "config_store.h"
+#include "event_loop.h"
 #include "globals.h"
+#include "metrics_shm.h"
+#include "metrics_store.h"
+#include "monitor_protocol.h"
 #include "shell_utils.h"
 #include <cjson/cJSON.h>
+#include <errno.h>
+#include <fcntl.h>
 #include <signal.h>
+#include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
 #include <unistd.h>
 
 /**
- * @brief Tamaño del array de métricas
+ * @brief PID del proceso en primer plano
  */
-#define SIZE_METRICS 10 // Define the size of the metrics array
+pid_t monitor_pid = -1; // PID del proceso de monitoreo
 
 /**
- * @brief PID del proceso en primer plano
+ * @brief pidfd del monitor registrado en el bucle de eventos, -1 si no se vigila
  */
-pid_t monitor_pid = -1; // PID del proceso de monitoreo
+static int monitor_pidfd = -1;
+
+/**
+ * @brief Extremo del shell del canal de control, -1 si no hay canal
+ */
+static int control_fd = -1;
+
+/**
+ * @brief El monitor anunció que entiende el protocolo (MONITOR_MSG_HOLA)
+ */
+static bool monitor_habla_protocolo = false;
+
+/**
+ * @brief Configuración en JSON que espera a que pase la ventana de agrupamiento, o NULL
+ */
+static char* configuracion_pendiente = NULL;
+
+/**
+ * @brief Temporizador que agrupa las actualizaciones seguidas, -1 si no existe
+ */
+static int temporizador_agrupar = -1;
+
+/**
+ * @brief Temporizador de espera del ACK, -1 si no hay configuración sin confirmar
+ */
+static int temporizador_ack = -1;
+
+/**
+ * @brief Secuencia del último mensaje enviado al monitor
+ */
+static uint32_t secuencia_control = 0;
+
+/**
+ * @brief Anillo de muestras compartido con el monitor, NULL si no hay
+ */
+static anillo_metricas* metricas = NULL;
+
+/**
+ * @brief Nombre POSIX del segmento de métricas
+ */
+static char nombre_metricas[64];
+
+// Crear el segmento de métricas del monitor; sin él, el monitor funciona igual pero monitor_top no tiene datos
+static void crear_metricas(void)
+{
+    snprintf(nombre_metricas, sizeof(nombre_metricas), "/shell_metricas_%d", (int)getpid());
+    metricas = metricas_crear(nombre_metricas);
+    if (metricas == NULL)
+    {
+        perror("Error al crear la memoria compartida de métricas");
+        return;
+    }
+    historial_iniciar();
+}
+
+// Desmapear y eliminar el segmento de métricas
+static void eliminar_metricas(void)
+{
+    if (metricas != NULL)
+    {
+        historial_sincronizar(metricas); // Las últimas muestras del monitor quedan en el historial
+        metricas_cerrar(metricas);
+        metricas_eliminar(nombre_metricas);
+        metricas = NULL;
+    }
+}
+
+// Esperar a que el monitor termine, forzándolo con SIGKILL si no atiende SIGTERM a tiempo
+static void recolectar_monitor(pid_t pid)
+{
+    for (int i = 0; i < MONITOR_ESPERA_TERMINAR_MS / 10; i++)
+    {
+        pid_t r = waitpid(pid, NULL, WNOHANG);
+        if (r == pid || (r == -1 && errno == ECHILD))
+            return; // Recolectado (aquí o por trabajos_actualizar())
+        usleep(10000);
+    }
+    kill(pid, SIGKILL);
+    waitpid(pid, NULL, 0);
+}
+
+// Cancelar un temporizador del bucle de eventos
+static void cancelar_temporizador(int* fd)
+{
+    if (*fd != -1)
+    {
+        eventos_quitar_fd(*fd);
+        *fd = -1;
+    }
+}
+
+// Cerrar el canal de control y descartar lo que estaba pendiente de enviar o confirmar
+static void cerrar_control(void)
+{
+    cancelar_temporizador(&temporizador_agrupar);
+    cancelar_temporizador(&temporizador_ack);
+    free(configuracion_pendiente);
+    configuracion_pendiente = NULL;
+    if (control_fd != -1)
+    {
+        eventos_quitar_fd(control_fd);
+        close(control_fd);
+        control_fd = -1;
+    }
+    monitor_habla_protocolo = false;
+}
+
+// Reiniciar el monitor para que lea la configuración del archivo (monitores sin canal de control)
+static void reiniciar_monitor(void)
+{
+    stop_monitor();  // Detiene el monitor
+    start_monitor(); // Reinicia el monitor
+}
+
+// Recolectar el monitor cuando termina por su cuenta
+static void al_terminar_monitor(int fd, uint32_t eventos __attribute__((unused)), void* dato __attribute__((unused)))
+{
+    siginfo_t info;
+    info.si_pid = 0;
+    if (waitid(P_PIDFD, (id_t)fd, &info, WEXITED | WNOHANG) == 0 && info.si_pid == 0)
+        return; // Sigue en ejecución
+
+    // Si waitid() falla, el monitor ya fue recolectado por trabajos_actualizar()
+    eventos_quitar_fd(fd);
+    monitor_pidfd = -1;
+    monitor_pid = -1;
+    cerrar_control();
+    eliminar_metricas();
+    printf("\nEl monitor terminó\n");
+    eventos_marcar_salida();
+}
+
+// Atender los mensajes del monitor
+static void al_recibir_control(int fd, uint32_t eventos __attribute__((unused)), void* dato __attribute__((unused)))
+{
+    mensaje_monitor mensaje;
+    int r;
+    while ((r = monitor_recibir_mensaje(fd, &mensaje)) == 1)
+    {
+        const cabecera_monitor* c = &mensaje.cabecera;
+        if (c->tipo == MONITOR_MSG_HOLA)
+        {
+            monitor_habla_protocolo = true;
+        }
+        else if (c->tipo == MONITOR_MSG_ACK && temporizador_ack != -1 && c->secuencia == secuencia_control)
+        {
+            int32_t estado = 0;
+            if (c->longitud >= sizeof(estado))
+                memcpy(&estado, mensaje.carga, sizeof(estado));
+            cancelar_temporizador(&temporizador_ack);
+            if (estado == 0)
+                printf("\nMonitor reconfigurado sin reiniciar\n");
+            else
+                printf("\nEl monitor rechazó la configuración (estado %d)\n", (int)estado);
+            eventos_marcar_salida();
+        }
+    }
+
+    if (r == 0 || (errno != EAGAIN && errno != EWOULDBLOCK))
+    {
+        // El monitor cerró el canal o habla otro protocolo: las próximas configuraciones lo reinician
+        cerrar_control();
+    }
+}
+
+// El monitor no confirmó la configuración a tiempo: aplicarla reiniciándolo
+static void al_vencer_ack(int fd __attribute__((unused)), uint32_t eventos __attribute__((unused)),
+                          void* dato __attribute__((unused)))
+{
+    cancelar_temporizador(&temporizador_ack);
+    printf("\nEl monitor no confirmó la configuración; reiniciándolo\n");
+    reiniciar_monitor();
+    eventos_marcar_salida();
+}
+
+// Enviar la configuración pendiente, o reiniciar el monitor si no tiene canal de control
+static void enviar_configuracion(void)
+{
+    char* configuracion = configuracion_pendiente;
+    configuracion_pendiente = NULL;
+    if (configuracion == NULL || monitor_pid <= 0)
+    {
+        free(configuracion);
+        return;
+    }
+
+    uint32_t longitud = (uint32_t)strlen(configuracion);
+    bool enviado = control_fd != -1 && monitor_habla_protocolo &&
+                   monitor_enviar_mensaje(control_fd, MONITOR_MSG_CONFIGURAR, ++secuencia_control, configuracion,
+                                          longitud) == 0;
+    free(configuracion);
+
+    if (!enviado)
+    {
+        reiniciar_monitor();
+        eventos_marcar_salida();
+        return;
+    }
+
+    // Una configuración nueva reemplaza a la que esperaba confirmación
+    cancelar_temporizador(&temporizador_ack);
+    temporizador_ack = eventos_agregar_temporizador(MONITOR_ESPERA_ACK_MS, false, al_vencer_ack, NULL);
+}
+
+// Vence la ventana de agrupamiento: enviar la última configuración
+static void al_vencer_agrupar(int fd __attribute__((unused)), uint32_t eventos __attribute__((unused)),
+                              void* dato __attribute__((unused)))
+{
+    cancelar_temporizador(&temporizador_agrupar);
+    enviar_configuracion();
+}
+
+// Programar el envío de la configuración en memoria al monitor
+static void programar_configuracion(void)
+{
+    char* json_string = config_serializar();
+    if (!json_string)
+    {
+        fprintf(stderr, "No se pudo imprimir el objeto JSON.\n");
+        return;
+    }
+
+    // Sólo se envía la última configuración de una ráfaga de actualizaciones
+    free(configuracion_pendiente);
+    configuracion_pendiente = strdup(json_string);
+    cJSON_free(json_string);
+
+    if (temporizador_agrupar != -1)
+    {
+        eventos_reprogramar(temporizador_agrupar, MONITOR_AGRUPAR_MS, false);
+        return;
+    }
+    temporizador_agrupar = eventos_agregar_temporizador(MONITOR_AGRUPAR_MS, false, al_vencer_agrupar, NULL);
+    if (temporizador_agrupar == -1)
+    {
+        enviar_configuracion(); // Sin bucle de eventos no se puede agrupar
+    }
+}
+
+// Aplicar al monitor en ejecución una configuración que otro programa escribió en el archivo
+static void al_cambiar_configuracion(void)
+{
+    if (monitor_pid > 0)
+    {
+        programar_configuracion();
+    }
+}
 
 // Inicializa el monitor
 void start_monitor()
@@ -32,22 +289,66 @@ void start_monitor()
         return;
     }
 
+    // Canal de control: si no se puede crear, el monitor funciona igual y se reinicia para reconfigurarlo
+    int canal[2];
+    if (socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0, canal) == -1)
+    {
+        perror("Error al crear el canal de control del monitor");
+        canal[0] = canal[1] = -1;
+    }
+
+    config_cargar(); // El monitor lee el archivo al iniciar: crearlo si todavía no existe
+    config_al_cambiar(al_cambiar_configuracion); // Las ediciones externas del archivo también llegan al monitor
+    crear_metricas();
+
     // Crear un proceso hijo para el monitor
     monitor_pid = fork();
     if (monitor_pid == 0)
     {
-        // Este es el proceso hijo
+        // Este es el proceso hijo: no heredar las señales que el shell atiende por signalfd
+        sigset_t mascara;
+        sigemptyset(&mascara);
+        sigprocmask(SIG_SETMASK, &mascara, NULL);
+        setpgid(0, 0); // Grupo propio: el Ctrl+C que termina monitor_top no debe llegarle al monitor
+#ifdef CLOSE_RANGE_CLOEXEC
+        close_range(STDERR_FILENO + 1, ~0U, CLOSE_RANGE_CLOEXEC); // Sólo el canal de control llega al monitor
+#endif
+        if (canal[1] != -1)
+        {
+            char numero[16];
+            snprintf(numero, sizeof(numero), "%d", canal[1]);
+            fcntl(canal[1], F_SETFD, 0); // El extremo del monitor sobrevive a execl()
+            setenv(MONITOR_CONTROL_ENV, numero, 1);
+        }
+        if (metricas != NULL)
+        {
+            setenv(METRICAS_SHM_ENV, nombre_metricas, 1);
+        }
         execl("bin/metrics", "bin/metrics", NULL); // Ejecutar el programa de monitoreo
         perror("Error al iniciar el monitor");     // Imprimir un mensaje de error si execl() falla
         exit(EXIT_FAILURE);
     }
-    else if (monitor_pid < 0)
+
+    if (canal[1] != -1)
+        close(canal[1]);
+    if (monitor_pid < 0)
     {
         perror("Error al crear el proceso de monitor");
+        if (canal[0] != -1)
+            close(canal[0]);
+        eliminar_metricas();
+        return;
     }
-    else
+
+    printf("Monitor iniciado con PID %d\n", monitor_pid);
+    monitor_pidfd = eventos_vigilar_proceso(monitor_pid, al_terminar_monitor, NULL);
+    if (canal[0] != -1 && eventos_agregar_fd(canal[0], EPOLLIN, al_recibir_control, NULL) == 0)
+    {
+        control_fd = canal[0];
+    }
+    else if (canal[0] != -1)
     {
-        printf("Monitor iniciado con PID %d\n", monitor_pid);
+        close(canal[0]); // Sin bucle de eventos no hay quien lea el canal
     }
 }
 
@@ -60,10 +361,19 @@ void stop_monitor()
         return;
     }
 
+    cerrar_control();
+    if (monitor_pidfd != -1) // La terminación pedida aquí no debe informarse como inesperada
+    {
+        eventos_quitar_fd(monitor_pidfd);
+        monitor_pidfd = -1;
+    }
+
     if (kill(monitor_pid, SIGTERM) == 0) // Envia la señal SIGTERM al monitor
     {
+        recolectar_monitor(monitor_pid); // El manejador de SIGCHLD sólo recolecta trabajos
         printf("Monitor detenido con éxito\n");
         monitor_pid = -1;
+        eliminar_metricas();
     }
     else
     {
@@ -71,6 +381,12 @@ void stop_monitor()
     }
 }
 
+// Devuelve el anillo de muestras del monitor
+const anillo_metricas* monitor_metricas(void)
+{
+    return monitor_pid > 0 ? metricas : NULL;
+}
+
 // Muestra el estado del monitor
 void status_monitor()
 {
@@ -85,91 +401,85 @@ void status_monitor()
 }
 
 // Maneja el comando de actualización
-void handle_update_command(char* input)
+int handle_update_command(int argc, char** argv)
 {
-    char* token = strtok(input, " "); // Tokeniza la cadena de entrada
-    // Procesa el intervalo de muestreo
-    token = strtok(NULL, " "); // Obtiene el siguiente token
-    if (!token)
+    if (argc < 2)
     {
         fprintf(stderr, "Intervalo no proporcionado.\n");
-        return;
+        fprintf(stderr, "Uso: update_config set|add|remove clave [valor] | update_config intervalo métrica...\n");
+        return 2;
     }
-    int interval = atoi(token); // Convierte el token a un entero
-    // Procesa las métricas
-    char* metrics[SIZE_METRICS]; // Array para almacenar las métricas
-    int metric_count = 0;        // Contador de métricas
-    while ((token = strtok(NULL, " ")) != NULL && metric_count < 10)
+
+    int cambio;
+    if (strcmp(argv[1], "set") == 0 || strcmp(argv[1], "add") == 0 || strcmp(argv[1], "remove") == 0)
     {
-        metrics[metric_count++] = token;
+        bool valor_opcional = strcmp(argv[1], "remove") == 0;
+        if (argc != 4 && !(valor_opcional && argc == 3))
+        {
+            fprintf(stderr, "Uso: update_config %s clave %s\n", argv[1], valor_opcional ? "[valor]" : "valor");
+            return 2;
+        }
+        cambio = config_aplicar(argv[1], argv[2], argc == 4 ? argv[3] : NULL);
+    }
+    else
+    {
+        // Forma original: intervalo y lista completa de métricas
+        char* fin;
+        long interval = strtol(argv[1], &fin, 10);
+        if (*fin != '\0' || interval <= 0 || interval > INT_MAX)
+        {
+            fprintf(stderr, "update_config: intervalo inválido '%s'\n", argv[1]);
+            return 2;
+        }
+        if (argc == 2)
+        {
+            fprintf(stderr, "No se proporcionaron métricas para monitorear.\n");
+            return 2;
+        }
+        cambio = update_config((int)interval, argv + 2, argc - 2);
     }
 
-    if (metric_count == 0)
+    if (cambio == -1 || config_guardar() == -1)
     {
-        fprintf(stderr, "No se proporcionaron métricas para monitorear.\n");
-        return;
+        return 1;
+    }
+    if (cambio == 0)
+    {
+        return 0; // Nada que escribir ni enviar
     }
 
-    // Actualiza la configuración y notifica al programa de monitoreo
-    update_config(interval, metrics, metric_count);
+    // Se envía al monitor la configuración ya guardada; el monitor la aplica sin reiniciarse
     if (monitor_pid > 0)
     {
-        stop_monitor();  // Detiene el monitor
-        start_monitor(); // Reinicia el monitor
+        programar_configuracion();
     }
     else
     {
         printf("Monitor no está en ejecución\n");
     }
+    return 0;
 }
 
-// Actualiza el archivo de configuración
-void update_config(int interval, char** metrics, int metric_count)
+// Actualiza la configuración con un intervalo y una lista de métricas
+int update_config(int interval, char** metrics, int metric_count)
 {
-    cJSON* root = cJSON_CreateObject(); // Crea un objeto JSON raíz
-    if (!root)
-    {
-        fprintf(stderr, "No se pudo crear el objeto JSON.\n");
-        return;
-    }
-
-    cJSON_AddNumberToObject(root, "sampling_interval", interval); // Agrega el intervalo de muestreo
-
     cJSON* metrics_array = cJSON_CreateArray(); // Crea un array JSON
     if (!metrics_array)
     {
         fprintf(stderr, "No se pudo crear el array JSON.\n");
-        cJSON_Delete(root);
-        return;
+        return -1;
     }
-
     for (int i = 0; i < metric_count; i++) // Agrega las metricas al array
     {
         cJSON_AddItemToArray(metrics_array, cJSON_CreateString(metrics[i]));
     }
 
-    cJSON_AddItemToObject(root, "metrics", metrics_array); // Agrega el array de métricas al objeto
-
-    char* json_string = cJSON_Print(root); // Convierte el objeto JSON a una cadena
-    if (!json_string)
-    {
-        fprintf(stderr, "No se pudo imprimir el objeto JSON.\n");
-        cJSON_Delete(root);
-        return;
-    }
-
-    FILE* file = fopen("../config.json", "w"); // Abre el archivo de configuración para escritura
-    if (!file)
+    int intervalo_cambio = config_establecer("sampling_interval", cJSON_CreateNumber(interval));
+    int metricas_cambio = config_establecer("metrics", metrics_array);
+    if (intervalo_cambio == -1 || metricas_cambio == -1)
     {
-        perror("No se pudo abrir el archivo de configuración para escribir");
-        cJSON_free(json_string);
-        cJSON_Delete(root);
-        return;
+        fprintf(stderr, "No se pudo actualizar la configuración.\n");
+        return -1;
     }
-
-    fprintf(file, "%s\n", json_string); // Escribe la cadena JSON en el archivo
-    fclose(file);                       // Cierra el archivo
-
-    cJSON_free(json_string); // Libera la cadena JSON
-    cJSON_Delete(root);      // Libera el objeto JSON
+    return intervalo_cambio || metricas_cambio;
 }
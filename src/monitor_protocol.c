@@ -0,0 +1,79 @@
+/**
+ * @file monitor_protocol.c
+ * @brief Implementación del envío y la recepción de mensajes del canal de control del monitor.
+ */
+
+#include "monitor_protocol.h"
+#include <errno.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+// Enviar la cabecera y la carga en un único paquete
+int monitor_enviar_mensaje(int fd, tipo_mensaje_monitor tipo, uint32_t secuencia, const void* carga,
+                           uint32_t longitud)
+{
+    if (longitud > MONITOR_CARGA_MAX)
+    {
+        errno = EMSGSIZE;
+        return -1;
+    }
+
+    cabecera_monitor cabecera;
+    cabecera.magia = MONITOR_PROTOCOLO_MAGIA;
+    cabecera.version = MONITOR_PROTOCOLO_VERSION;
+    cabecera.tipo = (uint16_t)tipo;
+    cabecera.secuencia = secuencia;
+    cabecera.longitud = longitud;
+
+    struct iovec partes[2];
+    partes[0].iov_base = &cabecera;
+    partes[0].iov_len = sizeof(cabecera);
+    partes[1].iov_base = (void*)carga;
+    partes[1].iov_len = carga != NULL ? longitud : 0;
+
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = partes;
+    msg.msg_iovlen = 2;
+
+    ssize_t enviados;
+    do
+    {
+        enviados = sendmsg(fd, &msg, MSG_NOSIGNAL); // Sin SIGPIPE si el monitor ya cerró el canal
+    } while (enviados == -1 && errno == EINTR);
+    return enviados == -1 ? -1 : 0;
+}
+
+// Recibir un paquete y validar su cabecera
+int monitor_recibir_mensaje(int fd, mensaje_monitor* mensaje)
+{
+    struct iovec partes[2];
+    partes[0].iov_base = &mensaje->cabecera;
+    partes[0].iov_len = sizeof(mensaje->cabecera);
+    partes[1].iov_base = mensaje->carga;
+    partes[1].iov_len = MONITOR_CARGA_MAX;
+
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = partes;
+    msg.msg_iovlen = 2;
+
+    ssize_t recibidos;
+    do
+    {
+        recibidos = recvmsg(fd, &msg, MSG_DONTWAIT);
+    } while (recibidos == -1 && errno == EINTR);
+    if (recibidos <= 0)
+        return (int)recibidos;
+
+    const cabecera_monitor* c = &mensaje->cabecera;
+    if ((size_t)recibidos < sizeof(*c) || (msg.msg_flags & MSG_TRUNC) || c->magia != MONITOR_PROTOCOLO_MAGIA ||
+        c->version != MONITOR_PROTOCOLO_VERSION || c->longitud != (size_t)recibidos - sizeof(*c))
+    {
+        errno = EPROTO;
+        return -1;
+    }
+    mensaje->carga[c->longitud] = '\0';
+    return 1;
+}
@@ -0,0 +1,230 @@
+/**
+ * @file monitor_top.c
+ * @brief Implementación del comando interno 'monitor_top'.
+ */
+
+#include "monitor_top.h"
+#include "globals.h"
+#include "metrics_shm.h"
+#include "monitor.h"
+#include <signal.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/**
+ *  @brief Columnas máximas del gráfico de evolución
+ */
+#define ANCHO_GRAFICO 60
+
+/**
+ * @brief Cuadro en construcción: se escribe completo de una vez
+ */
+typedef struct
+{
+    char texto[8192]; /**< Contenido del cuadro */
+    size_t longitud;  /**< Bytes ocupados */
+} cuadro_top;
+
+/**
+ * @brief Métrica que se muestra: nombre y posición dentro de la muestra
+ */
+typedef struct
+{
+    const char* nombre; /**< Nombre en la tabla */
+    size_t campo;       /**< offsetof del valor en muestra_metricas */
+    bool bytes;         /**< El valor es una tasa en bytes por segundo */
+} metrica_top;
+
+/**
+ * @brief Métricas de la tabla, en orden
+ */
+static const metrica_top metricas_top[] = {
+    {"CPU %", offsetof(muestra_metricas, cpu), false},
+    {"Memoria %", offsetof(muestra_metricas, memoria), false},
+    {"Red rx", offsetof(muestra_metricas, red_rx), true},
+    {"Red tx", offsetof(muestra_metricas, red_tx), true},
+};
+
+/**
+ * @brief Niveles del gráfico de evolución, de 0 % a 100 %
+ */
+static const char* const niveles_grafico[] = {"▁", "▂", "▃", "▄", "▅", "▆", "▇", "█"};
+
+/**
+ * @brief Ventana de muestras leída del anillo
+ */
+static muestra_metricas ventana[METRICAS_CAPACIDAD];
+
+// Agregar texto con formato al cuadro, descartando lo que no entra
+__attribute__((format(printf, 2, 3))) static void agregar(cuadro_top* c, const char* formato, ...)
+{
+    if (c->longitud >= sizeof(c->texto))
+        return;
+    va_list args;
+    va_start(args, formato);
+    int n = vsnprintf(c->texto + c->longitud, sizeof(c->texto) - c->longitud, formato, args);
+    va_end(args);
+    if (n > 0)
+        c->longitud += (size_t)n < sizeof(c->texto) - c->longitud ? (size_t)n : sizeof(c->texto) - c->longitud - 1;
+}
+
+// Valor de una métrica dentro de una muestra
+static double valor(const muestra_metricas* m, const metrica_top* metrica)
+{
+    return *(const double*)((const char*)m + metrica->campo);
+}
+
+// Agregar un valor con el formato de su métrica
+static void agregar_valor(cuadro_top* c, double v, bool bytes)
+{
+    static const char* const unidades[] = {"B/s", "KiB/s", "MiB/s", "GiB/s"};
+    if (!bytes)
+    {
+        agregar(c, " %12.1f", v);
+        return;
+    }
+    int u = 0;
+    while (v >= 1024.0 && u < 3)
+    {
+        v /= 1024.0;
+        u++;
+    }
+    char texto[32];
+    snprintf(texto, sizeof(texto), "%.1f %s", v, unidades[u]);
+    agregar(c, " %12s", texto);
+}
+
+// Agregar el gráfico de evolución de un porcentaje
+static void agregar_grafico(cuadro_top* c, const metrica_top* metrica, int n)
+{
+    int desde = n > ANCHO_GRAFICO ? n - ANCHO_GRAFICO : 0;
+    agregar(c, "%-10s ", metrica->nombre);
+    for (int i = desde; i < n; i++)
+    {
+        double v = valor(&ventana[i], metrica);
+        int nivel = (int)(v / 100.0 * 8.0);
+        nivel = nivel < 0 ? 0 : (nivel > 7 ? 7 : nivel);
+        agregar(c, "%s", niveles_grafico[nivel]);
+    }
+    agregar(c, "\n");
+}
+
+// Construir un cuadro con la ventana leída del anillo
+static void armar_cuadro(cuadro_top* c, const anillo_metricas* anillo, int muestras, bool limpiar)
+{
+    c->longitud = 0;
+    if (limpiar)
+        agregar(c, "\033[H\033[2J");
+
+    int n = metricas_leer_ultimas(anillo, ventana, muestras);
+    agregar(c, "Monitor PID %d: %d muestras en la ventana de %d", (int)monitor_pid, n, muestras);
+    if (anillo->intervalo_ms > 0)
+        agregar(c, ", intervalo %u ms", anillo->intervalo_ms);
+    agregar(c, "\n");
+    if (n == 0)
+    {
+        agregar(c, "Todavía no hay muestras\n");
+        return;
+    }
+
+    agregar(c, "\n%-10s %12s %13s %12s %13s\n", "", "actual", "mín", "media", "máx"); // La tilde ocupa dos bytes
+    for (size_t i = 0; i < sizeof(metricas_top) / sizeof(metricas_top[0]); i++)
+    {
+        const metrica_top* metrica = &metricas_top[i];
+        double minimo = valor(&ventana[0], metrica);
+        double maximo = minimo;
+        double suma = 0;
+        for (int k = 0; k < n; k++)
+        {
+            double v = valor(&ventana[k], metrica);
+            minimo = v < minimo ? v : minimo;
+            maximo = v > maximo ? v : maximo;
+            suma += v;
+        }
+        agregar(c, "%-10s", metrica->nombre);
+        agregar_valor(c, valor(&ventana[n - 1], metrica), metrica->bytes);
+        agregar_valor(c, minimo, metrica->bytes);
+        agregar_valor(c, suma / n, metrica->bytes);
+        agregar_valor(c, maximo, metrica->bytes);
+        agregar(c, "\n");
+    }
+
+    agregar(c, "\n");
+    agregar_grafico(c, &metricas_top[0], n); // CPU
+    agregar_grafico(c, &metricas_top[1], n); // Memoria
+}
+
+// Esperar hasta la próxima actualización; devuelve false si el usuario presionó Ctrl+C
+static bool esperar_actualizacion(int segundos)
+{
+    // En el shell interactivo SIGINT está bloqueada (ver event_loop.h): esperarla aquí también sirve de pausa
+    sigset_t senales;
+    sigemptyset(&senales);
+    sigaddset(&senales, SIGINT);
+    struct timespec tiempo = {.tv_sec = segundos, .tv_nsec = 0};
+    return sigtimedwait(&senales, NULL, &tiempo) != SIGINT;
+}
+
+// Leer un número entero positivo de una opción
+static bool leer_numero(const char* texto, int maximo, int* valor_leido)
+{
+    char* fin;
+    long numero = texto != NULL ? strtol(texto, &fin, 10) : 0;
+    if (texto == NULL || *fin != '\0' || numero < 1 || numero > maximo)
+    {
+        return false;
+    }
+    *valor_leido = (int)numero;
+    return true;
+}
+
+// Manejar el comando "monitor_top"
+int manejar_comando_monitor_top(int argc, char** argv)
+{
+    int muestras = MONITOR_TOP_VENTANA;
+    int segundos = MONITOR_TOP_INTERVALO;
+    bool en_terminal = isatty(STDOUT_FILENO);
+    int cuadros = en_terminal ? 0 : 1; // 0: hasta Ctrl+C
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "-n") == 0 && leer_numero(argv[i + 1], METRICAS_CAPACIDAD, &muestras))
+            i++;
+        else if (strcmp(argv[i], "-d") == 0 && leer_numero(argv[i + 1], 3600, &segundos))
+            i++;
+        else if (strcmp(argv[i], "-c") == 0 && leer_numero(argv[i + 1], 1000000, &cuadros))
+            i++;
+        else
+        {
+            fprintf(stderr, "monitor_top: opción inválida '%s'\n", argv[i]);
+            fprintf(stderr, "Uso: monitor_top [-n muestras] [-d segundos] [-c cuadros]\n");
+            return 2;
+        }
+    }
+
+    const anillo_metricas* anillo = monitor_metricas();
+    if (anillo == NULL)
+    {
+        fprintf(stderr, "monitor_top: el monitor no está en ejecución\n");
+        return 1;
+    }
+
+    static cuadro_top cuadro;
+    for (int i = 0; cuadros == 0 || i < cuadros; i++)
+    {
+        if (i > 0 && !esperar_actualizacion(segundos))
+        {
+            printf("\n");
+            break;
+        }
+        armar_cuadro(&cuadro, anillo, muestras, en_terminal && (cuadros != 1));
+        fwrite(cuadro.texto, 1, cuadro.longitud, stdout);
+        fflush(stdout);
+    }
+    return 0;
+}
@@ -0,0 +1,552 @@
+/**
+ * @file parallel.c
+ * @brief Implementación del comando interno 'parallel'.
+ */
+
+#include "parallel.h"
+#include "launcher.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+/**
+ * @brief Entorno del proceso, que ocupa parte de ARG_MAX en cada ejecución
+ */
+extern char** environ;
+
+/**
+ * @brief Cola de lotes de un trabajador: un rango [primero, ultimo) de índices de lote.
+ *
+ * El dueño toma lotes del principio y los demás trabajadores roban del final, así ambos extremos casi nunca compiten.
+ */
+typedef struct
+{
+    int primero;           /**< Próximo lote que toma el dueño */
+    int ultimo;            /**< Uno más que el último lote de la cola */
+    pthread_mutex_t mutex; /**< Protege primero y ultimo */
+} cola_lotes;
+
+/**
+ * @brief Estado compartido por todos los trabajadores.
+ */
+typedef struct
+{
+    char** comando;                 /**< Comando y sus argumentos, con "{}" opcional */
+    int num_comando;                /**< Cantidad de palabras del comando */
+    char** elementos;               /**< Elementos a procesar */
+    int num_elementos;              /**< Cantidad de elementos */
+    int* inicio_lote;               /**< Primer elemento de cada lote; inicio_lote[num_lotes] = num_elementos */
+    int num_lotes;                  /**< Cantidad de lotes */
+    int* estados;                   /**< Estado de salida de cada lote, -1 si no se ejecutó */
+    int* salidas;                   /**< Con -k: buffer en memoria con la salida de cada lote, -1 si no hay */
+    bool* terminados;               /**< Con -k: el lote ya terminó y su salida puede escribirse */
+    int siguiente;                  /**< Con -k: próximo lote cuya salida se escribe */
+    pthread_mutex_t mutex_salida;   /**< Protege terminados, salidas y siguiente */
+    cola_lotes* colas;              /**< Cola de cada trabajador */
+    int num_trabajadores;           /**< Cantidad de trabajadores */
+    bool ordenado;                  /**< -k */
+    bool detener_al_fallar;         /**< --halt */
+    bool entrada_nula;              /**< Los elementos se leyeron de stdin: los procesos leen de /dev/null */
+    atomic_bool detenido;           /**< Hubo un fallo con --halt: no se lanzan más lotes */
+} trabajo_paralelo;
+
+/**
+ * @brief Argumento de cada hilo trabajador.
+ */
+typedef struct
+{
+    trabajo_paralelo* trabajo; /**< Estado compartido */
+    int id;                    /**< Índice del trabajador y de su cola */
+} trabajador;
+
+// Tomar un lote de la cola propia o, si está vacía, robarlo del final de otra; devuelve -1 si no quedan lotes
+static int tomar_lote(trabajo_paralelo* t, int id)
+{
+    cola_lotes* propia = &t->colas[id];
+    int lote = -1;
+
+    pthread_mutex_lock(&propia->mutex);
+    if (propia->primero < propia->ultimo)
+    {
+        lote = propia->primero++;
+    }
+    pthread_mutex_unlock(&propia->mutex);
+
+    for (int i = 1; lote == -1 && i < t->num_trabajadores; i++)
+    {
+        cola_lotes* victima = &t->colas[(id + i) % t->num_trabajadores];
+        pthread_mutex_lock(&victima->mutex);
+        if (victima->primero < victima->ultimo)
+        {
+            lote = --victima->ultimo;
+        }
+        pthread_mutex_unlock(&victima->mutex);
+    }
+    return lote;
+}
+
+// Copiar a la salida estándar el contenido de un buffer en memoria
+static void volcar_salida(int fd)
+{
+    char buffer[65536];
+    ssize_t leidos;
+
+    lseek(fd, 0, SEEK_SET);
+    while ((leidos = read(fd, buffer, sizeof(buffer))) > 0 || (leidos == -1 && errno == EINTR))
+    {
+        for (ssize_t escritos = 0; leidos > 0 && escritos < leidos;)
+        {
+            ssize_t n = write(STDOUT_FILENO, buffer + escritos, (size_t)(leidos - escritos));
+            if (n == -1 && errno != EINTR)
+                return; // El lector de la salida ya no está
+            escritos += n > 0 ? n : 0;
+        }
+    }
+}
+
+// Escribir en orden las salidas de los lotes terminados; con final, también las de los lotes que no se ejecutaron
+static void escribir_salidas(trabajo_paralelo* t, bool final)
+{
+    while (t->siguiente < t->num_lotes && (final || t->terminados[t->siguiente]))
+    {
+        int fd = t->salidas[t->siguiente];
+        if (fd != -1)
+        {
+            volcar_salida(fd);
+            close(fd);
+            t->salidas[t->siguiente] = -1;
+        }
+        t->siguiente++;
+    }
+}
+
+// Armar el vector de argumentos de un lote: "{}" se reemplaza por los elementos, o se agregan al final
+static char** armar_argumentos(const trabajo_paralelo* t, int lote)
+{
+    int desde = t->inicio_lote[lote];
+    int cantidad = t->inicio_lote[lote + 1] - desde;
+    int reemplazos = 0;
+    for (int i = 0; i < t->num_comando; i++)
+    {
+        reemplazos += strcmp(t->comando[i], "{}") == 0;
+    }
+
+    char** argv = malloc((size_t)(t->num_comando + (reemplazos > 0 ? reemplazos : 1) * cantidad + 1) * sizeof(char*));
+    if (argv == NULL)
+    {
+        return NULL;
+    }
+
+    int n = 0;
+    for (int i = 0; i < t->num_comando; i++)
+    {
+        if (strcmp(t->comando[i], "{}") == 0)
+        {
+            memcpy(&argv[n], &t->elementos[desde], (size_t)cantidad * sizeof(char*));
+            n += cantidad;
+        }
+        else
+        {
+            argv[n++] = t->comando[i];
+        }
+    }
+    if (reemplazos == 0)
+    {
+        memcpy(&argv[n], &t->elementos[desde], (size_t)cantidad * sizeof(char*));
+        n += cantidad;
+    }
+    argv[n] = NULL;
+    return argv;
+}
+
+// Ejecutar un lote y esperar a que termine; devuelve su estado de salida
+static int ejecutar_lote(trabajo_paralelo* t, int lote)
+{
+    char** argv = armar_argumentos(t, lote);
+    if (argv == NULL)
+    {
+        fprintf(stderr, "parallel: memoria insuficiente\n");
+        return 127;
+    }
+
+    // Los procesos quedan en el grupo del shell, así Ctrl+C les llega a todos
+    plan_spawn plan;
+    plan_inicializar(&plan, argv);
+    plan.pgid = PLAN_SIN_GRUPO;
+    if (t->entrada_nula)
+    {
+        plan_agregar_abrir(&plan, STDIN_FILENO, "/dev/null", O_RDONLY, 0);
+    }
+
+    int salida = -1;
+    if (t->ordenado)
+    {
+        salida = memfd_create("parallel", MFD_CLOEXEC);
+        if (salida == -1)
+        {
+            perror("parallel: error al crear el buffer de salida");
+            free(argv);
+            return 127;
+        }
+        plan_agregar_dup2(&plan, salida, STDOUT_FILENO);
+    }
+
+    int estado = 127;
+    int status;
+    pid_t pid = lanzar_plan(&plan);
+    if (pid > 0)
+    {
+        while (waitpid(pid, &status, 0) == -1 && errno == EINTR)
+            ;
+        estado = codigo_de_salida(status);
+    }
+    free(argv);
+
+    if (t->ordenado)
+    {
+        pthread_mutex_lock(&t->mutex_salida);
+        t->salidas[lote] = salida;
+        t->terminados[lote] = true;
+        escribir_salidas(t, false);
+        pthread_mutex_unlock(&t->mutex_salida);
+    }
+    return estado;
+}
+
+// Hilo trabajador: ejecutar lotes hasta que no quede ninguno
+static void* trabajar(void* dato)
+{
+    trabajador* w = dato;
+    trabajo_paralelo* t = w->trabajo;
+    int lote;
+
+    while (!atomic_load(&t->detenido) && (lote = tomar_lote(t, w->id)) != -1)
+    {
+        t->estados[lote] = ejecutar_lote(t, lote);
+        if (t->estados[lote] != 0 && t->detener_al_fallar)
+        {
+            atomic_store(&t->detenido, true);
+        }
+    }
+    return NULL;
+}
+
+// Leer los elementos de la entrada estándar, uno por línea, ignorando las líneas vacías
+static char* leer_elementos(char*** elementos, int* num_elementos)
+{
+    size_t largo = 0;
+    size_t capacidad = 0;
+    char* texto = NULL;
+
+    // Se lee el descriptor directamente: el buffer de stdio retendría datos que no son de este comando
+    for (;;)
+    {
+        if (largo + 1 >= capacidad)
+        {
+            capacidad = capacidad == 0 ? 65536 : capacidad * 2;
+            char* nuevo = realloc(texto, capacidad);
+            if (nuevo == NULL)
+            {
+                free(texto);
+                return NULL;
+            }
+            texto = nuevo;
+        }
+        ssize_t leidos = read(STDIN_FILENO, texto + largo, capacidad - largo - 1);
+        if (leidos == -1 && errno == EINTR)
+            continue;
+        if (leidos <= 0)
+            break;
+        largo += (size_t)leidos;
+    }
+    texto[largo] = '\0';
+
+    int lineas = 1;
+    for (size_t i = 0; i < largo; i++)
+    {
+        lineas += texto[i] == '\n';
+    }
+    *elementos = malloc((size_t)lineas * sizeof(char*));
+    if (*elementos == NULL)
+    {
+        free(texto);
+        return NULL;
+    }
+
+    *num_elementos = 0;
+    for (char* linea = texto; linea < texto + largo;)
+    {
+        char* fin = strchr(linea, '\n');
+        if (fin != NULL)
+            *fin = '\0';
+        if (*linea != '\0')
+            (*elementos)[(*num_elementos)++] = linea;
+        linea = fin != NULL ? fin + 1 : texto + largo;
+    }
+    return texto;
+}
+
+// Espacio de ARG_MAX disponible para los elementos de un lote, descontando el entorno y el comando
+static long espacio_argumentos(char** comando, int num_comando)
+{
+    long maximo = sysconf(_SC_ARG_MAX);
+    long usado = 4096; // Margen para el vector auxiliar y la alineación que arma el núcleo
+    if (maximo <= 0)
+    {
+        maximo = _POSIX_ARG_MAX;
+    }
+    for (char** e = environ; e != NULL && *e != NULL; e++)
+    {
+        usado += (long)(strlen(*e) + 1 + sizeof(char*));
+    }
+    for (int i = 0; i < num_comando; i++)
+    {
+        usado += (long)(strlen(comando[i]) + 1 + sizeof(char*));
+    }
+    return maximo - usado;
+}
+
+// Agrupar los elementos en lotes de hasta por_lote elementos que entren en ARG_MAX; devuelve la cantidad de lotes
+static int armar_lotes(trabajo_paralelo* t, int por_lote)
+{
+    long espacio = espacio_argumentos(t->comando, t->num_comando);
+    int lotes = 0;
+
+    for (int i = 0; i < t->num_elementos;)
+    {
+        t->inicio_lote[lotes++] = i;
+        long usado = 0;
+        int en_lote = 0;
+        do
+        {
+            usado += (long)(strlen(t->elementos[i]) + 1 + sizeof(char*));
+            en_lote++;
+            i++;
+        } while (i < t->num_elementos && en_lote < por_lote &&
+                 usado + (long)(strlen(t->elementos[i]) + 1 + sizeof(char*)) <= espacio);
+    }
+    t->inicio_lote[lotes] = t->num_elementos;
+    return lotes;
+}
+
+// Leer un número entero positivo de una opción
+static bool leer_numero(const char* texto, int maximo, int* valor)
+{
+    char* fin;
+    long numero = texto != NULL ? strtol(texto, &fin, 10) : 0;
+    if (texto == NULL || *fin != '\0' || numero < 1 || numero > maximo)
+    {
+        return false;
+    }
+    *valor = (int)numero;
+    return true;
+}
+
+// Informar el estado de los elementos y devolver el estado de salida del comando
+static int informar_estados(const trabajo_paralelo* t, bool todos)
+{
+    int fallidos = 0;
+    int sin_ejecutar = 0;
+
+    for (int lote = 0; lote < t->num_lotes; lote++)
+    {
+        int estado = t->estados[lote];
+        for (int i = t->inicio_lote[lote]; i < t->inicio_lote[lote + 1]; i++)
+        {
+            if (estado == -1)
+            {
+                sin_ejecutar++;
+            }
+            else if (estado != 0 || todos)
+            {
+                fprintf(stderr, "parallel: %s: estado %d\n", t->elementos[i], estado);
+            }
+            fallidos += estado != 0;
+        }
+    }
+    if (sin_ejecutar > 0)
+    {
+        fprintf(stderr, "parallel: %d elementos sin ejecutar por --halt\n", sin_ejecutar);
+    }
+    return fallidos > 100 ? 100 : fallidos;
+}
+
+// Repartir los lotes entre los trabajadores, ejecutarlos y esperar a que terminen
+static void ejecutar_trabajadores(trabajo_paralelo* t, int trabajadores, trabajador* hilos, pthread_t* ids)
+{
+    // Cada trabajador empieza con un tramo contiguo de lotes
+    t->num_trabajadores = trabajadores < t->num_lotes ? trabajadores : t->num_lotes;
+    for (int w = 0; w < t->num_trabajadores; w++)
+    {
+        t->colas[w].primero = (int)((long)t->num_lotes * w / t->num_trabajadores);
+        t->colas[w].ultimo = (int)((long)t->num_lotes * (w + 1) / t->num_trabajadores);
+        pthread_mutex_init(&t->colas[w].mutex, NULL);
+    }
+    pthread_mutex_init(&t->mutex_salida, NULL);
+    atomic_init(&t->detenido, false);
+
+    // Las señales se atienden en el hilo principal del shell: los trabajadores las tienen bloqueadas
+    sigset_t todas;
+    sigset_t anterior;
+    sigfillset(&todas);
+    pthread_sigmask(SIG_BLOCK, &todas, &anterior);
+    int creados = 0;
+    for (; creados < t->num_trabajadores; creados++)
+    {
+        hilos[creados].trabajo = t;
+        hilos[creados].id = creados;
+        if (pthread_create(&ids[creados], NULL, trabajar, &hilos[creados]) != 0)
+        {
+            break; // Los trabajadores creados roban los lotes de los que faltan
+        }
+    }
+    pthread_sigmask(SIG_SETMASK, &anterior, NULL);
+
+    if (creados == 0 && t->num_trabajadores > 0)
+    {
+        trabajar(&hilos[0]); // Sin hilos, el propio shell procesa todos los lotes
+    }
+    for (int w = 0; w < creados; w++)
+    {
+        pthread_join(ids[w], NULL);
+    }
+
+    for (int w = 0; w < t->num_trabajadores; w++)
+    {
+        pthread_mutex_destroy(&t->colas[w].mutex);
+    }
+    pthread_mutex_destroy(&t->mutex_salida);
+}
+
+// Manejar el comando "parallel"
+int manejar_comando_parallel(int argc, char** argv)
+{
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    int trabajadores = cpus > 0 ? (int)(cpus < PARALLEL_MAX_TRABAJADORES ? cpus : PARALLEL_MAX_TRABAJADORES) : 1;
+    int por_lote = 1;
+    bool repartir = false;
+    bool mostrar_todos = false;
+    trabajo_paralelo t;
+    memset(&t, 0, sizeof(t));
+
+    // Opciones: terminan en la primera palabra que no empieza con '-' o en "--"
+    int i = 1;
+    for (; i < argc && argv[i][0] == '-'; i++)
+    {
+        if (strcmp(argv[i], "--") == 0)
+        {
+            i++;
+            break;
+        }
+        else if (strcmp(argv[i], "-j") == 0 && leer_numero(argv[i + 1], PARALLEL_MAX_TRABAJADORES, &trabajadores))
+            i++;
+        else if (strcmp(argv[i], "-n") == 0 && leer_numero(argv[i + 1], INT_MAX, &por_lote))
+            i++;
+        else if (strcmp(argv[i], "-X") == 0)
+            repartir = true;
+        else if (strcmp(argv[i], "-k") == 0)
+            t.ordenado = true;
+        else if (strcmp(argv[i], "-s") == 0)
+            mostrar_todos = true;
+        else if (strcmp(argv[i], "--halt") == 0)
+            t.detener_al_fallar = true;
+        else
+        {
+            fprintf(stderr, "parallel: opción inválida '%s'\n", argv[i]);
+            fprintf(stderr, "Uso: parallel [-j N] [-n N | -X] [-k] [-s] [--halt] comando [args...] "
+                            "[::: elementos...]\n");
+            return 255;
+        }
+    }
+
+    // El comando llega hasta ":::" o hasta el final
+    t.comando = &argv[i];
+    while (i < argc && strcmp(argv[i], PARALLEL_SEPARADOR) != 0)
+    {
+        i++;
+    }
+    t.num_comando = (int)(&argv[i] - t.comando);
+    if (t.num_comando == 0)
+    {
+        fprintf(stderr, "parallel: falta el comando\n");
+        return 255;
+    }
+
+    char* texto = NULL; // Texto leído de stdin, dueño de los elementos
+    if (i < argc)
+    {
+        t.elementos = &argv[i + 1];
+        t.num_elementos = argc - i - 1;
+    }
+    else
+    {
+        texto = leer_elementos(&t.elementos, &t.num_elementos);
+        if (texto == NULL)
+        {
+            fprintf(stderr, "parallel: memoria insuficiente para leer los elementos\n");
+            return 255;
+        }
+        t.entrada_nula = true;
+    }
+
+    int estado = 0;
+    t.inicio_lote = malloc((size_t)(t.num_elementos + 1) * sizeof(int));
+    t.estados = malloc((size_t)(t.num_elementos + 1) * sizeof(int));
+    t.salidas = malloc((size_t)(t.num_elementos + 1) * sizeof(int));
+    t.terminados = calloc((size_t)(t.num_elementos + 1), sizeof(bool));
+    t.colas = calloc((size_t)trabajadores, sizeof(cola_lotes));
+    trabajador* hilos = calloc((size_t)trabajadores, sizeof(trabajador));
+    pthread_t* ids = calloc((size_t)trabajadores, sizeof(pthread_t));
+    if (t.inicio_lote == NULL || t.estados == NULL || t.salidas == NULL || t.terminados == NULL || t.colas == NULL ||
+        hilos == NULL || ids == NULL)
+    {
+        fprintf(stderr, "parallel: memoria insuficiente\n");
+        estado = 255;
+    }
+    else
+    {
+        // Con -X los elementos se reparten en partes iguales, un lote por trabajador salvo que no entren en ARG_MAX
+        if (repartir)
+        {
+            por_lote = (t.num_elementos + trabajadores - 1) / trabajadores;
+            por_lote = por_lote > 0 ? por_lote : 1;
+        }
+        t.num_lotes = armar_lotes(&t, por_lote);
+        for (int lote = 0; lote < t.num_lotes; lote++)
+        {
+            t.estados[lote] = -1;
+            t.salidas[lote] = -1;
+        }
+
+        ejecutar_trabajadores(&t, trabajadores, hilos, ids);
+        if (t.ordenado)
+        {
+            escribir_salidas(&t, true);
+        }
+        estado = informar_estados(&t, mostrar_todos);
+    }
+
+    free(ids);
+    free(hilos);
+    free(t.colas);
+    free(t.terminados);
+    free(t.salidas);
+    free(t.estados);
+    free(t.inicio_lote);
+    if (texto != NULL)
+    {
+        free(t.elementos);
+        free(texto);
+    }
+    return estado;
+}
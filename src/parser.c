@@ -0,0 +1,1126 @@
+/**
+ * @file parser.c
+ * @brief Implementación del analizador léxico y sintáctico de la línea de comandos.
+ */
+
+#include "parser.h"
+#include "shell_vars.h"
+#include <ctype.h>
+#include <limits.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @brief Tipo de token de la línea de comandos.
+ */
+typedef enum
+{
+    TOKEN_PALABRA,      /**< Palabra, con sus comillas y escapes */
+    TOKEN_PIPE,         /**< '|' */
+    TOKEN_FONDO,        /**< '&' */
+    TOKEN_Y,            /**< '&&' */
+    TOKEN_O,            /**< '||' */
+    TOKEN_PUNTO_Y_COMA, /**< ';' */
+    TOKEN_FIN_RAMA,     /**< ';;', fin de una rama de case */
+    TOKEN_ABRE,         /**< '(' */
+    TOKEN_CIERRA,       /**< ')' */
+    TOKEN_NUEVA_LINEA,  /**< Salto de línea */
+    TOKEN_REDIRECCION,  /**< '<', '>', '>>', '<>', '>&', '<&', '&>' o '&>>', con un descriptor opcional delante */
+    TOKEN_FIN           /**< Fin del texto */
+} tipo_token;
+
+/**
+ * @brief Token producido por el analizador léxico.
+ */
+typedef struct
+{
+    tipo_token tipo;        /**< Tipo de token */
+    palabra texto;          /**< Palabra (sólo TOKEN_PALABRA) */
+    tipo_redireccion redir; /**< Tipo de redirección (sólo TOKEN_REDIRECCION) */
+    int fd;                 /**< Descriptor redirigido (sólo TOKEN_REDIRECCION) */
+    int linea;              /**< Línea donde empieza el token */
+    const char* inicio;     /**< Texto original del token, para los mensajes de error */
+    size_t largo;           /**< Largo del texto original */
+} token;
+
+/**
+ * @brief Estado del análisis: posición en el texto y token actual.
+ */
+typedef struct
+{
+    arena* a;                /**< Arena de los nodos */
+    const char* p;           /**< Posición actual */
+    const char* fin;         /**< Fin del texto */
+    int linea;               /**< Línea actual */
+    token actual;            /**< Último token leído */
+    resultado_parseo estado; /**< Resultado acumulado */
+    char* error;             /**< Buffer del mensaje de error */
+    size_t tam_error;        /**< Tamaño del buffer de error */
+} analizador;
+
+// Registrar un error de análisis con su línea
+static bool fallar(analizador* an, resultado_parseo estado, const char* formato, ...)
+{
+    an->estado = estado;
+    if (an->error != NULL && an->tam_error > 0)
+    {
+        int escrito = snprintf(an->error, an->tam_error, "línea %d: ", an->linea);
+        if (escrito >= 0 && (size_t)escrito < an->tam_error)
+        {
+            va_list argumentos;
+            va_start(argumentos, formato);
+            vsnprintf(an->error + escrito, an->tam_error - (size_t)escrito, formato, argumentos);
+            va_end(argumentos);
+        }
+    }
+    return false;
+}
+
+// Verificar si un carácter termina una palabra fuera de comillas
+static bool es_separador(char c)
+{
+    return c == ' ' || c == '\t' || c == '\n' || c == '|' || c == '&' || c == ';' || c == '<' || c == '>' || c == '(' ||
+           c == ')';
+}
+
+// Verificar si un carácter puede formar parte de un nombre de variable
+static bool es_caracter_nombre(char c, bool primero)
+{
+    return c == '_' || isalpha((unsigned char)c) || (!primero && isdigit((unsigned char)c));
+}
+
+// Verificar si un carácter es un parámetro especial o posicional: $?, $#, $@, $*, $$ y $0 a $9
+static bool es_parametro_especial(char c)
+{
+    return c == '?' || c == '#' || c == '@' || c == '*' || c == '$' || isdigit((unsigned char)c);
+}
+
+// Verificar si un '$' inicia una expansión
+static bool es_inicio_expansion(const char* p, const char* fin)
+{
+    return p < fin && (*p == '{' || es_caracter_nombre(*p, true) || es_parametro_especial(*p));
+}
+
+// Verificar si un texto es un nombre de variable o de función
+bool es_nombre_valido(const char* texto, size_t largo)
+{
+    for (size_t i = 0; i < largo; i++)
+    {
+        if (!es_caracter_nombre(texto[i], i == 0))
+            return false;
+    }
+    return largo > 0;
+}
+
+// Buscar el valor de la variable que sigue a un '$'; devuelve cuántos bytes ocupa la referencia (0 si no es válida)
+static size_t buscar_variable(const char* s, size_t n, const char** valor)
+{
+    bool llaves = n > 0 && s[0] == '{';
+    size_t inicio = llaves ? 1 : 0;
+    size_t i = inicio;
+
+    if (i < n && es_parametro_especial(s[i]))
+    {
+        i++; // Un solo carácter, salvo los posicionales entre llaves: ${10}
+        while (llaves && isdigit((unsigned char)s[inicio]) && i < n && isdigit((unsigned char)s[i]))
+            i++;
+    }
+    else
+    {
+        while (i < n && es_caracter_nombre(s[i], i == inicio))
+            i++;
+    }
+    size_t largo = i - inicio;
+    if (largo == 0 || (llaves && (i >= n || s[i] != '}')))
+    {
+        return 0; // No es una referencia válida: el '$' es literal
+    }
+
+    char nombre[NAME_MAX + 1];
+    *valor = NULL;
+    if (largo < sizeof(nombre))
+    {
+        memcpy(nombre, s + inicio, largo);
+        nombre[largo] = '\0';
+        *valor = variable_buscar(nombre);
+    }
+    if (*valor == NULL)
+    {
+        *valor = ""; // Una variable no definida se expande a vacío
+    }
+    return llaves ? largo + 2 : largo;
+}
+
+// Agregar bytes a la salida, o sólo contarlos si la salida es NULL
+static void emitir(char* salida, size_t* largo, const char* datos, size_t n)
+{
+    if (salida != NULL)
+    {
+        memcpy(salida + *largo, datos, n);
+    }
+    *largo += n;
+}
+
+// Quitar comillas y escapes de una palabra y, si se pide, expandir sus variables; devuelve el largo del resultado
+static size_t cocinar(const char* s, size_t n, bool expandir, char* salida)
+{
+    size_t largo = 0;
+    char comilla = '\0';
+    size_t i = 0;
+
+    while (i < n)
+    {
+        char c = s[i];
+
+        if (comilla == '\'') // Dentro de comillas simples todo es literal
+        {
+            if (c == '\'')
+                comilla = '\0';
+            else
+                emitir(salida, &largo, &c, 1);
+            i++;
+            continue;
+        }
+
+        if (c == '\\' && i + 1 < n)
+        {
+            char siguiente = s[i + 1];
+            if (siguiente == '\n') // Continuación de línea
+            {
+                i += 2;
+                continue;
+            }
+            if (comilla == '"' && strchr("$\"\\`", siguiente) == NULL)
+            {
+                emitir(salida, &largo, &c, 1); // Entre comillas dobles la barra sólo escapa $ " \ `
+                i++;
+                continue;
+            }
+            emitir(salida, &largo, &siguiente, 1);
+            i += 2;
+            continue;
+        }
+
+        if ((c == '\'' || c == '"') && comilla == '\0')
+        {
+            comilla = c;
+            i++;
+            continue;
+        }
+        if (c == '"' && comilla == '"')
+        {
+            comilla = '\0';
+            i++;
+            continue;
+        }
+
+        if (c == '$' && expandir)
+        {
+            const char* valor = NULL;
+            size_t consumido = buscar_variable(s + i + 1, n - i - 1, &valor);
+            if (consumido > 0)
+            {
+                emitir(salida, &largo, valor, strlen(valor));
+                i += 1 + consumido;
+                continue;
+            }
+        }
+
+        emitir(salida, &largo, &c, 1);
+        i++;
+    }
+    return largo;
+}
+
+// Leer una palabra a partir de la posición actual
+static bool leer_palabra(analizador* an)
+{
+    const char* inicio = an->p;
+    const char* q = an->p;
+    bool expandir = false;
+    char comilla = '\0';
+    int lineas = 0;
+
+    while (q < an->fin)
+    {
+        char c = *q;
+        if (comilla == '\'')
+        {
+            if (c == '\'')
+                comilla = '\0';
+        }
+        else if (c == '\\')
+        {
+            if (q + 1 >= an->fin)
+            {
+                return fallar(an, PARSEO_INCOMPLETO, "'\\' al final del texto");
+            }
+            if (q[1] == '\n')
+                lineas++;
+            q += 2;
+            continue;
+        }
+        else if (c == '"' && comilla == '"')
+        {
+            comilla = '\0';
+        }
+        else if ((c == '\'' || c == '"') && comilla == '\0')
+        {
+            comilla = c;
+        }
+        else if (c == '$' && es_inicio_expansion(q + 1, an->fin))
+        {
+            expandir = true;
+        }
+        else if (comilla == '\0' && es_separador(c))
+        {
+            break;
+        }
+        if (c == '\n')
+            lineas++;
+        q++;
+    }
+
+    if (comilla != '\0')
+    {
+        return fallar(an, PARSEO_INCOMPLETO, "falta cerrar las comillas %c", comilla);
+    }
+
+    size_t largo = (size_t)(q - inicio);
+    char* texto;
+    if (expandir)
+    {
+        texto = arena_copiar(an->a, inicio, largo); // Se conserva el texto original para expandirlo al ejecutar
+    }
+    else
+    {
+        texto = arena_reservar(an->a, largo + 1);
+        if (texto != NULL)
+            texto[cocinar(inicio, largo, false, texto)] = '\0';
+    }
+    if (texto == NULL)
+    {
+        return fallar(an, PARSEO_ERROR, "memoria insuficiente");
+    }
+
+    an->actual.tipo = TOKEN_PALABRA;
+    an->actual.texto.texto = texto;
+    an->actual.texto.expandir = expandir;
+    an->p = q;
+    an->linea += lineas;
+    return true;
+}
+
+// Leer un operador de redirección, con el descriptor opcional que lo precede
+static bool leer_redireccion(analizador* an, const char* operador)
+{
+    int fd = -1;
+    if (operador != an->p) // Hay dígitos antes del operador
+    {
+        long valor = 0;
+        for (const char* d = an->p; d < operador; d++)
+        {
+            valor = valor * 10 + (*d - '0');
+            if (valor > INT_MAX)
+            {
+                return fallar(an, PARSEO_ERROR, "descriptor de archivo fuera de rango");
+            }
+        }
+        fd = (int)valor;
+    }
+
+    an->actual.tipo = TOKEN_REDIRECCION;
+    const char* p = operador + 1;
+    char siguiente = p < an->fin ? *p : '\0';
+    if (*operador == '&') // '&>' y '&>>' redirigen la salida y los errores
+    {
+        p++;
+        bool agregar = p < an->fin && *p == '>';
+        an->actual.redir = agregar ? REDIR_AGREGAR_Y_ERRORES : REDIR_SALIDA_Y_ERRORES;
+        p += agregar;
+    }
+    else if (siguiente == '&') // '>&' y '<&' duplican o cierran un descriptor
+    {
+        an->actual.redir = REDIR_DUPLICAR;
+        p++;
+    }
+    else if (*operador == '<')
+    {
+        an->actual.redir = siguiente == '>' ? REDIR_LECTURA_ESCRITURA : REDIR_ENTRADA;
+        p += siguiente == '>';
+    }
+    else
+    {
+        an->actual.redir = siguiente == '>' ? REDIR_AGREGAR : REDIR_SALIDA;
+        p += siguiente == '>';
+    }
+    an->p = p;
+    an->actual.fd = fd >= 0 ? fd : (*operador == '<' ? 0 : 1);
+    return true;
+}
+
+// Leer el siguiente token
+static bool siguiente_token(analizador* an)
+{
+    // Saltar espacios, continuaciones de línea y comentarios
+    while (an->p < an->fin)
+    {
+        if (*an->p == ' ' || *an->p == '\t')
+        {
+            an->p++;
+        }
+        else if (*an->p == '\\' && an->p + 1 < an->fin && an->p[1] == '\n')
+        {
+            an->p += 2;
+            an->linea++;
+        }
+        else if (*an->p == '#')
+        {
+            while (an->p < an->fin && *an->p != '\n')
+                an->p++;
+        }
+        else
+        {
+            break;
+        }
+    }
+
+    an->actual.inicio = an->p;
+    an->actual.linea = an->linea;
+
+    if (an->p >= an->fin)
+    {
+        an->actual.tipo = TOKEN_FIN;
+        an->actual.largo = 0;
+        return true;
+    }
+
+    bool exito = true;
+    bool doble = an->p + 1 < an->fin && an->p[1] == *an->p; // '||', '&&' y ';;'
+    switch (*an->p)
+    {
+    case '\n':
+        an->actual.tipo = TOKEN_NUEVA_LINEA;
+        an->p++;
+        an->linea++;
+        break;
+    case '|':
+        an->actual.tipo = doble ? TOKEN_O : TOKEN_PIPE;
+        an->p += doble ? 2 : 1;
+        break;
+    case '&':
+        if (an->p + 1 < an->fin && an->p[1] == '>')
+        {
+            exito = leer_redireccion(an, an->p);
+            break;
+        }
+        an->actual.tipo = doble ? TOKEN_Y : TOKEN_FONDO;
+        an->p += doble ? 2 : 1;
+        break;
+    case ';':
+        an->actual.tipo = doble ? TOKEN_FIN_RAMA : TOKEN_PUNTO_Y_COMA;
+        an->p += doble ? 2 : 1;
+        break;
+    case '(':
+        an->actual.tipo = TOKEN_ABRE;
+        an->p++;
+        break;
+    case ')':
+        an->actual.tipo = TOKEN_CIERRA;
+        an->p++;
+        break;
+    case '<':
+    case '>':
+        exito = leer_redireccion(an, an->p);
+        break;
+    default: {
+        // Un número pegado a '<' o '>' es el descriptor de la redirección
+        const char* d = an->p;
+        while (d < an->fin && isdigit((unsigned char)*d))
+            d++;
+        if (d > an->p && d < an->fin && (*d == '<' || *d == '>'))
+            exito = leer_redireccion(an, d);
+        else
+            exito = leer_palabra(an);
+        break;
+    }
+    }
+
+    an->actual.largo = (size_t)(an->p - an->actual.inicio);
+    return exito;
+}
+
+// Informar un token inesperado
+static bool token_inesperado(analizador* an)
+{
+    if (an->actual.tipo == TOKEN_FIN || an->actual.tipo == TOKEN_NUEVA_LINEA)
+    {
+        return fallar(an, PARSEO_ERROR, "error de sintaxis cerca del fin de línea");
+    }
+    return fallar(an, PARSEO_ERROR, "error de sintaxis cerca de '%.*s'", (int)an->actual.largo, an->actual.inicio);
+}
+
+// Asegurar lugar para un elemento más en un vector de la arena; el vector puede cambiar de dirección
+static void* reservar_lugar(arena* a, void* vector, int cantidad, int* capacidad, size_t tam)
+{
+    if (cantidad < *capacidad)
+    {
+        return vector;
+    }
+    int nueva = *capacidad == 0 ? 4 : *capacidad * 2;
+    void* nuevo = arena_reservar(a, (size_t)nueva * tam);
+    if (nuevo == NULL)
+    {
+        return NULL;
+    }
+    if (cantidad > 0)
+    {
+        memcpy(nuevo, vector, (size_t)cantidad * tam);
+    }
+    *capacidad = nueva;
+    return nuevo;
+}
+
+// comando := (PALABRA | REDIRECCION PALABRA)+
+static bool parsear_comando_simple(analizador* an, comando_simple* comando)
+{
+    int capacidad = 0;
+    redireccion** ultima = &comando->redirecciones;
+
+    comando->palabras = NULL;
+    comando->num_palabras = 0;
+    comando->redirecciones = NULL;
+    comando->compuesto = NULL;
+
+    while (an->actual.tipo == TOKEN_PALABRA || an->actual.tipo == TOKEN_REDIRECCION)
+    {
+        if (an->actual.tipo == TOKEN_PALABRA)
+        {
+            comando->palabras =
+                reservar_lugar(an->a, comando->palabras, comando->num_palabras, &capacidad, sizeof(palabra));
+            if (comando->palabras == NULL)
+                return fallar(an, PARSEO_ERROR, "memoria insuficiente");
+            comando->palabras[comando->num_palabras++] = an->actual.texto;
+        }
+        else
+        {
+            redireccion* r = arena_reservar(an->a, sizeof(redireccion));
+            if (r == NULL)
+                return fallar(an, PARSEO_ERROR, "memoria insuficiente");
+            r->tipo = an->actual.redir;
+            r->fd = an->actual.fd;
+            r->siguiente = NULL;
+
+            if (!siguiente_token(an))
+                return false;
+            if (an->actual.tipo != TOKEN_PALABRA) // La redirección necesita un archivo o un descriptor
+                return token_inesperado(an);
+            r->destino = an->actual.texto;
+
+            *ultima = r;
+            ultima = &r->siguiente;
+        }
+        if (!siguiente_token(an))
+            return false;
+    }
+
+    if (comando->num_palabras == 0 && comando->redirecciones == NULL)
+    {
+        return token_inesperado(an);
+    }
+    return true;
+}
+
+// Verificar si el token actual es una palabra reservada, escrita sin comillas ni escapes
+static bool es_reservada(const analizador* an, const char* reservada)
+{
+    size_t largo = strlen(reservada);
+    return an->actual.tipo == TOKEN_PALABRA && an->actual.largo == largo &&
+           memcmp(an->actual.inicio, reservada, largo) == 0;
+}
+
+// Verificar si el token actual termina una lista: una palabra que cierra un comando compuesto, ';;' o ')'
+static bool termina_lista(const analizador* an)
+{
+    static const char* const cierres[] = {"then", "elif", "else", "fi", "do", "done", "esac", "}"};
+    if (an->actual.tipo == TOKEN_FIN_RAMA || an->actual.tipo == TOKEN_CIERRA)
+    {
+        return true;
+    }
+    for (size_t i = 0; i < sizeof(cierres) / sizeof(cierres[0]); i++)
+    {
+        if (es_reservada(an, cierres[i]))
+            return true;
+    }
+    return false;
+}
+
+// Verificar si el token actual empieza un comando compuesto
+static bool empieza_compuesto(const analizador* an)
+{
+    return es_reservada(an, "if") || es_reservada(an, "while") || es_reservada(an, "until") ||
+           es_reservada(an, "for") || es_reservada(an, "case") || es_reservada(an, "{");
+}
+
+// Verificar si la palabra actual es el nombre de una definición de función: la sigue '('
+static bool empieza_funcion(const analizador* an)
+{
+    if (an->actual.tipo != TOKEN_PALABRA || !es_nombre_valido(an->actual.inicio, an->actual.largo))
+    {
+        return false;
+    }
+    const char* p = an->p;
+    while (p < an->fin && (*p == ' ' || *p == '\t'))
+        p++;
+    return p < an->fin && *p == '(';
+}
+
+// Saltar los saltos de línea
+static bool saltar_lineas(analizador* an)
+{
+    while (an->actual.tipo == TOKEN_NUEVA_LINEA)
+    {
+        if (!siguiente_token(an))
+            return false;
+    }
+    return true;
+}
+
+// Consumir la palabra reservada que cierra o continúa un comando compuesto
+static bool exigir(analizador* an, const char* reservada)
+{
+    if (!es_reservada(an, reservada))
+    {
+        return an->actual.tipo == TOKEN_FIN ? fallar(an, PARSEO_INCOMPLETO, "falta '%s'", reservada)
+                                            : token_inesperado(an);
+    }
+    return siguiente_token(an);
+}
+
+// Envolver un comando compuesto en una lista de un solo pipe de una etapa
+static lista_comandos* lista_de_compuesto(analizador* an, comando_compuesto* c)
+{
+    lista_comandos* l = arena_reservar_cero(an->a, sizeof(lista_comandos));
+    pipeline* p = arena_reservar_cero(an->a, sizeof(pipeline));
+    comando_simple* etapa = arena_reservar_cero(an->a, sizeof(comando_simple));
+    if (l == NULL || p == NULL || etapa == NULL)
+    {
+        fallar(an, PARSEO_ERROR, "memoria insuficiente");
+        return NULL;
+    }
+    etapa->compuesto = c;
+    p->etapas = etapa;
+    p->num_etapas = 1;
+    p->linea = an->actual.linea;
+    l->pipelines = p;
+    l->num_pipelines = 1;
+    return l;
+}
+
+static bool parsear_lista(analizador* an, lista_comandos* l, const char* esperado);
+static bool parsear_compuesto(analizador* an, comando_compuesto* c);
+
+// Analizar una lista que no puede quedar vacía, como la condición o el cuerpo de un comando compuesto
+static bool parsear_cuerpo(analizador* an, lista_comandos** l, const char* esperado)
+{
+    *l = arena_reservar_cero(an->a, sizeof(lista_comandos));
+    if (*l == NULL)
+    {
+        return fallar(an, PARSEO_ERROR, "memoria insuficiente");
+    }
+    if (!parsear_lista(an, *l, esperado))
+    {
+        return false;
+    }
+    return (*l)->num_pipelines > 0 || token_inesperado(an);
+}
+
+// si := 'if' lista 'then' lista ('elif' lista 'then' lista)* ['else' lista] 'fi'; el 'if' o 'elif' ya se consumió
+static bool parsear_si(analizador* an, comando_compuesto* c)
+{
+    c->tipo = COMPUESTO_SI;
+    if (!parsear_cuerpo(an, &c->condicion, "then") || !exigir(an, "then") || !parsear_cuerpo(an, &c->cuerpo, "fi"))
+    {
+        return false;
+    }
+    if (es_reservada(an, "elif"))
+    {
+        // Un elif es un if completo dentro de la alternativa: su 'fi' cierra también a este
+        comando_compuesto* anidado = arena_reservar_cero(an->a, sizeof(comando_compuesto));
+        if (anidado == NULL)
+            return fallar(an, PARSEO_ERROR, "memoria insuficiente");
+        c->alternativa = lista_de_compuesto(an, anidado);
+        return c->alternativa != NULL && siguiente_token(an) && parsear_si(an, anidado);
+    }
+    if (es_reservada(an, "else") && (!siguiente_token(an) || !parsear_cuerpo(an, &c->alternativa, "fi")))
+    {
+        return false;
+    }
+    return exigir(an, "fi");
+}
+
+// para := 'for' NOMBRE [NUEVA_LINEA* 'in' PALABRA* (';' | NUEVA_LINEA)] NUEVA_LINEA* 'do' lista 'done'
+static bool parsear_para(analizador* an, comando_compuesto* c)
+{
+    c->tipo = COMPUESTO_PARA;
+    if (!siguiente_token(an))
+        return false;
+    if (an->actual.tipo != TOKEN_PALABRA || !es_nombre_valido(an->actual.inicio, an->actual.largo))
+        return token_inesperado(an);
+    c->nombre = an->actual.texto.texto;
+    if (!siguiente_token(an) || !saltar_lineas(an))
+        return false;
+
+    if (es_reservada(an, "in"))
+    {
+        int capacidad = 0;
+        if (!siguiente_token(an))
+            return false;
+        while (an->actual.tipo == TOKEN_PALABRA)
+        {
+            c->palabras = reservar_lugar(an->a, c->palabras, c->num_palabras, &capacidad, sizeof(palabra));
+            if (c->palabras == NULL)
+                return fallar(an, PARSEO_ERROR, "memoria insuficiente");
+            c->palabras[c->num_palabras++] = an->actual.texto;
+            if (!siguiente_token(an))
+                return false;
+        }
+        if (an->actual.tipo != TOKEN_PUNTO_Y_COMA && an->actual.tipo != TOKEN_NUEVA_LINEA)
+            return an->actual.tipo == TOKEN_FIN ? fallar(an, PARSEO_INCOMPLETO, "falta 'do'") : token_inesperado(an);
+        if (!siguiente_token(an))
+            return false;
+    }
+    else
+    {
+        // Sin 'in', el for recorre los parámetros posicionales
+        c->palabras = arena_reservar(an->a, sizeof(palabra));
+        if (c->palabras == NULL)
+            return fallar(an, PARSEO_ERROR, "memoria insuficiente");
+        c->palabras[0].texto = "\"$@\"";
+        c->palabras[0].expandir = true;
+        c->num_palabras = 1;
+        if (an->actual.tipo == TOKEN_PUNTO_Y_COMA && !siguiente_token(an))
+            return false;
+    }
+
+    return saltar_lineas(an) && exigir(an, "do") && parsear_cuerpo(an, &c->cuerpo, "done") && exigir(an, "done");
+}
+
+// caso := 'case' PALABRA NUEVA_LINEA* 'in' (NUEVA_LINEA* ['('] PALABRA ('|' PALABRA)* ')' lista [';;'])* 'esac'
+static bool parsear_caso(analizador* an, comando_compuesto* c)
+{
+    c->tipo = COMPUESTO_CASO;
+    if (!siguiente_token(an))
+        return false;
+    if (an->actual.tipo != TOKEN_PALABRA)
+        return token_inesperado(an);
+    c->palabras = arena_reservar(an->a, sizeof(palabra));
+    if (c->palabras == NULL)
+        return fallar(an, PARSEO_ERROR, "memoria insuficiente");
+    c->palabras[0] = an->actual.texto;
+    c->num_palabras = 1;
+    if (!siguiente_token(an) || !saltar_lineas(an) || !exigir(an, "in"))
+        return false;
+
+    rama_caso** ultima = &c->ramas;
+    for (;;)
+    {
+        if (!saltar_lineas(an))
+            return false;
+        if (an->actual.tipo == TOKEN_FIN)
+            return fallar(an, PARSEO_INCOMPLETO, "falta 'esac'");
+        if (es_reservada(an, "esac"))
+            return siguiente_token(an);
+        if (an->actual.tipo == TOKEN_ABRE && !siguiente_token(an))
+            return false;
+
+        rama_caso* r = arena_reservar_cero(an->a, sizeof(rama_caso));
+        if (r == NULL)
+            return fallar(an, PARSEO_ERROR, "memoria insuficiente");
+        int capacidad = 0;
+        for (;;)
+        {
+            if (an->actual.tipo != TOKEN_PALABRA)
+                return token_inesperado(an);
+            r->patrones = reservar_lugar(an->a, r->patrones, r->num_patrones, &capacidad, sizeof(palabra));
+            if (r->patrones == NULL)
+                return fallar(an, PARSEO_ERROR, "memoria insuficiente");
+            r->patrones[r->num_patrones++] = an->actual.texto;
+            if (!siguiente_token(an))
+                return false;
+            if (an->actual.tipo != TOKEN_PIPE)
+                break;
+            if (!siguiente_token(an))
+                return false;
+        }
+        if (an->actual.tipo != TOKEN_CIERRA)
+            return token_inesperado(an);
+
+        r->cuerpo = arena_reservar_cero(an->a, sizeof(lista_comandos));
+        if (r->cuerpo == NULL)
+            return fallar(an, PARSEO_ERROR, "memoria insuficiente");
+        if (!siguiente_token(an) || !parsear_lista(an, r->cuerpo, "esac"))
+            return false;
+        *ultima = r;
+        ultima = &r->siguiente;
+
+        if (an->actual.tipo == TOKEN_FIN_RAMA)
+        {
+            if (!siguiente_token(an))
+                return false;
+        }
+        else if (!es_reservada(an, "esac"))
+        {
+            return token_inesperado(an);
+        }
+    }
+}
+
+// compuesto := si | ('while' | 'until') lista 'do' lista 'done' | para | caso | '{' lista '}'
+static bool parsear_compuesto(analizador* an, comando_compuesto* c)
+{
+    if (es_reservada(an, "if"))
+    {
+        return siguiente_token(an) && parsear_si(an, c);
+    }
+    if (es_reservada(an, "while") || es_reservada(an, "until"))
+    {
+        c->tipo = es_reservada(an, "while") ? COMPUESTO_MIENTRAS : COMPUESTO_HASTA;
+        return siguiente_token(an) && parsear_cuerpo(an, &c->condicion, "do") && exigir(an, "do") &&
+               parsear_cuerpo(an, &c->cuerpo, "done") && exigir(an, "done");
+    }
+    if (es_reservada(an, "for"))
+    {
+        return parsear_para(an, c);
+    }
+    if (es_reservada(an, "case"))
+    {
+        return parsear_caso(an, c);
+    }
+    c->tipo = COMPUESTO_GRUPO;
+    return siguiente_token(an) && parsear_cuerpo(an, &c->cuerpo, "}") && exigir(an, "}");
+}
+
+// funcion := NOMBRE '(' ')' NUEVA_LINEA* compuesto
+static bool parsear_funcion(analizador* an, comando_compuesto* c)
+{
+    c->tipo = COMPUESTO_FUNCION;
+    c->nombre = an->actual.texto.texto;
+    if (!siguiente_token(an) || !siguiente_token(an)) // El nombre y '('
+        return false;
+    if (an->actual.tipo != TOKEN_CIERRA)
+        return token_inesperado(an);
+    if (!siguiente_token(an) || !saltar_lineas(an))
+        return false;
+    if (an->actual.tipo == TOKEN_FIN)
+        return fallar(an, PARSEO_INCOMPLETO, "falta el cuerpo de la función %s", c->nombre);
+    if (!empieza_compuesto(an))
+        return token_inesperado(an);
+
+    comando_compuesto* cuerpo = arena_reservar_cero(an->a, sizeof(comando_compuesto));
+    if (cuerpo == NULL)
+        return fallar(an, PARSEO_ERROR, "memoria insuficiente");
+    c->cuerpo = lista_de_compuesto(an, cuerpo);
+    return c->cuerpo != NULL && parsear_compuesto(an, cuerpo);
+}
+
+// comando := compuesto | funcion | comando_simple
+static bool parsear_comando(analizador* an, comando_simple* comando)
+{
+    bool funcion = empieza_funcion(an);
+    if (!funcion && !empieza_compuesto(an))
+    {
+        return parsear_comando_simple(an, comando);
+    }
+
+    comando->palabras = NULL;
+    comando->num_palabras = 0;
+    comando->redirecciones = NULL;
+    comando->compuesto = arena_reservar_cero(an->a, sizeof(comando_compuesto));
+    if (comando->compuesto == NULL)
+    {
+        return fallar(an, PARSEO_ERROR, "memoria insuficiente");
+    }
+    return funcion ? parsear_funcion(an, comando->compuesto) : parsear_compuesto(an, comando->compuesto);
+}
+
+// pipeline := ['!'] comando ('|' NUEVA_LINEA* comando)*
+static bool parsear_pipeline(analizador* an, pipeline* p)
+{
+    int capacidad = 0;
+    p->etapas = NULL;
+    p->num_etapas = 0;
+    p->en_segundo_plano = false;
+    p->linea = an->actual.linea;
+    p->conector = CONECTOR_SECUENCIA;
+    p->negado = es_reservada(an, "!");
+    if (p->negado && !siguiente_token(an))
+    {
+        return false;
+    }
+
+    for (;;)
+    {
+        p->etapas = reservar_lugar(an->a, p->etapas, p->num_etapas, &capacidad, sizeof(comando_simple));
+        if (p->etapas == NULL)
+            return fallar(an, PARSEO_ERROR, "memoria insuficiente");
+        if (!parsear_comando(an, &p->etapas[p->num_etapas]))
+            return false;
+        p->num_etapas++;
+
+        if (an->actual.tipo != TOKEN_PIPE)
+            break;
+
+        // Después de '|' se permiten saltos de línea; si el texto termina, el pipe está incompleto
+        do
+        {
+            if (!siguiente_token(an))
+                return false;
+        } while (an->actual.tipo == TOKEN_NUEVA_LINEA);
+        if (an->actual.tipo == TOKEN_FIN)
+            return fallar(an, PARSEO_INCOMPLETO, "falta un comando después de '|'");
+    }
+
+    for (int i = 0; i < p->num_etapas && p->num_etapas > 1; i++)
+    {
+        if (p->etapas[i].compuesto != NULL)
+            return fallar(an, PARSEO_ERROR, "un comando compuesto no puede ser una etapa de un pipe");
+    }
+    return true;
+}
+
+// y_o := pipeline (('&&' | '||') NUEVA_LINEA* pipeline)*
+static bool parsear_y_o(analizador* an, lista_comandos* l, int* capacidad)
+{
+    tipo_conector conector = CONECTOR_SECUENCIA;
+    for (;;)
+    {
+        l->pipelines = reservar_lugar(an->a, l->pipelines, l->num_pipelines, capacidad, sizeof(pipeline));
+        if (l->pipelines == NULL)
+            return fallar(an, PARSEO_ERROR, "memoria insuficiente");
+        pipeline* p = &l->pipelines[l->num_pipelines];
+        if (!parsear_pipeline(an, p))
+            return false;
+        p->conector = conector;
+        l->num_pipelines++;
+
+        if (an->actual.tipo != TOKEN_Y && an->actual.tipo != TOKEN_O)
+            return true;
+        conector = an->actual.tipo == TOKEN_Y ? CONECTOR_Y : CONECTOR_O;
+
+        // Como después de '|', se permiten saltos de línea
+        do
+        {
+            if (!siguiente_token(an))
+                return false;
+        } while (an->actual.tipo == TOKEN_NUEVA_LINEA);
+        if (an->actual.tipo == TOKEN_FIN)
+            return fallar(an, PARSEO_INCOMPLETO, "falta un comando después de '%s'",
+                          conector == CONECTOR_Y ? "&&" : "||");
+    }
+}
+
+// lista := (y_o ('&' | ';' | NUEVA_LINEA))*, hasta el fin del texto o una palabra que la termina
+static bool parsear_lista(analizador* an, lista_comandos* l, const char* esperado)
+{
+    int capacidad = 0;
+    for (;;)
+    {
+        if (!saltar_lineas(an)) // Líneas vacías
+            return false;
+        if (an->actual.tipo == TOKEN_FIN)
+            return esperado == NULL || fallar(an, PARSEO_INCOMPLETO, "falta '%s'", esperado);
+        if (termina_lista(an))
+            return true; // Quien abrió el comando compuesto verifica que sea la palabra esperada
+
+        if (!parsear_y_o(an, l, &capacidad))
+            return false;
+
+        pipeline* p = &l->pipelines[l->num_pipelines - 1];
+        switch (an->actual.tipo)
+        {
+        case TOKEN_FONDO:
+            if (p->etapas[0].compuesto != NULL)
+                return fallar(an, PARSEO_ERROR, "un comando compuesto no puede ejecutarse en segundo plano");
+            p->en_segundo_plano = true;
+            // fall through
+        case TOKEN_PUNTO_Y_COMA:
+        case TOKEN_NUEVA_LINEA:
+            if (!siguiente_token(an))
+                return false;
+            break;
+        case TOKEN_FIN:
+            break;
+        default:
+            if (!termina_lista(an))
+                return token_inesperado(an);
+            break;
+        }
+    }
+}
+
+// Analizar un texto completo
+resultado_parseo parsear_comandos(arena* a, const char* texto, size_t largo, int linea_inicial, lista_comandos** lista,
+                                  char* error, size_t tam_error)
+{
+    analizador an = {.a = a,
+                     .p = texto,
+                     .fin = texto + largo,
+                     .linea = linea_inicial,
+                     .estado = PARSEO_OK,
+                     .error = error,
+                     .tam_error = tam_error};
+
+    if (error != NULL && tam_error > 0)
+        error[0] = '\0';
+
+    *lista = arena_reservar_cero(a, sizeof(lista_comandos));
+    if (*lista == NULL)
+    {
+        fallar(&an, PARSEO_ERROR, "memoria insuficiente");
+        return an.estado;
+    }
+
+    if (siguiente_token(&an) && parsear_lista(&an, *lista, NULL) && an.actual.tipo != TOKEN_FIN)
+    {
+        token_inesperado(&an); // Una palabra que cierra un comando compuesto que no se abrió
+    }
+    return an.estado;
+}
+
+// Expandir una palabra
+char* expandir_palabra(arena* a, const palabra* p)
+{
+    if (!p->expandir)
+    {
+        return (char*)p->texto;
+    }
+
+    size_t largo_original = strlen(p->texto);
+    size_t largo = cocinar(p->texto, largo_original, true, NULL); // Primera pasada: medir
+    char* resultado = arena_reservar(a, largo + 1);
+    if (resultado != NULL)
+    {
+        cocinar(p->texto, largo_original, true, resultado); // Segunda pasada: escribir
+        resultado[largo] = '\0';
+    }
+    return resultado;
+}
+
+// Verificar si una palabra es exactamente $@ o "$@", que se expande a un argumento por parámetro posicional
+static bool es_arroba(const palabra* p)
+{
+    return p->expandir && (strcmp(p->texto, "$@") == 0 || strcmp(p->texto, "\"$@\"") == 0);
+}
+
+// Agregar un argumento al final de un vector de la arena
+static bool agregar_argumento(arena* a, char*** argv, int* n, int* capacidad, char* texto)
+{
+    *argv = reservar_lugar(a, *argv, *n, capacidad, sizeof(char*));
+    if (*argv == NULL)
+    {
+        return false;
+    }
+    (*argv)[(*n)++] = texto;
+    return true;
+}
+
+// Agregar un argumento por cada parámetro posicional
+static bool agregar_posicionales(arena* a, char*** argv, int* n, int* capacidad)
+{
+    int num_parametros;
+    char* const* parametros = parametros_posicionales(&num_parametros);
+    for (int i = 0; i < num_parametros; i++)
+    {
+        if (!agregar_argumento(a, argv, n, capacidad, parametros[i]))
+            return false;
+    }
+    return true;
+}
+
+// Expandir las palabras de un comando en un vector de argumentos
+char** expandir_argumentos(arena* a, const comando_simple* comando, int* argc)
+{
+    int capacidad = comando->num_palabras + 1;
+    char** argv = arena_reservar(a, (size_t)capacidad * sizeof(char*));
+    if (argv == NULL)
+    {
+        return NULL;
+    }
+
+    int n = 0;
+    for (int i = 0; i < comando->num_palabras; i++)
+    {
+        const palabra* p = &comando->palabras[i];
+        if (es_arroba(p))
+        {
+            if (!agregar_posicionales(a, &argv, &n, &capacidad))
+                return NULL;
+            continue;
+        }
+        char* texto = expandir_palabra(a, p);
+        if (texto == NULL)
+        {
+            return NULL;
+        }
+        // Una expansión vacía sin comillas no produce argumento
+        if (texto[0] == '\0' && p->expandir && strpbrk(p->texto, "'\"") == NULL)
+        {
+            continue;
+        }
+        if (!agregar_argumento(a, &argv, &n, &capacidad, texto))
+            return NULL;
+    }
+    if (!agregar_argumento(a, &argv, &n, &capacidad, NULL))
+    {
+        return NULL;
+    }
+    *argc = n - 1;
+    return argv;
+}
+
+// Expandir una lista de palabras separando en campos las expansiones sin comillas
+char** expandir_campos(arena* a, const palabra* palabras, int n, int* num_campos)
+{
+    char** campos = NULL;
+    int cantidad = 0;
+    int capacidad = 0;
+
+    for (int i = 0; i < n; i++)
+    {
+        const palabra* p = &palabras[i];
+        if (es_arroba(p))
+        {
+            if (!agregar_posicionales(a, &campos, &cantidad, &capacidad))
+                return NULL;
+            continue;
+        }
+        char* texto = expandir_palabra(a, p);
+        if (texto == NULL)
+        {
+            return NULL;
+        }
+        if (!p->expandir || strpbrk(p->texto, "'\"") != NULL)
+        {
+            if (!agregar_argumento(a, &campos, &cantidad, &capacidad, texto)) // Con comillas: un solo campo
+                return NULL;
+            continue;
+        }
+
+        // Sin comillas, el resultado de la expansión (propio de la arena) se corta en los blancos
+        char* resto;
+        for (char* campo = strtok_r(texto, " \t\n", &resto); campo != NULL; campo = strtok_r(NULL, " \t\n", &resto))
+        {
+            if (!agregar_argumento(a, &campos, &cantidad, &capacidad, campo))
+                return NULL;
+        }
+    }
+    if (!agregar_argumento(a, &campos, &cantidad, &capacidad, NULL))
+    {
+        return NULL;
+    }
+    *num_campos = cantidad - 1;
+    return campos;
+}
@@ -0,0 +1,359 @@
+/**
+ * @file path_cache.c
+ * @brief Implementación de la caché de ubicación de comandos y del comando interno 'hash'.
+ */
+
+#include "path_cache.h"
+#include <limits.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**
+ * @brief Capacidad inicial de la tabla (potencia de dos)
+ */
+#define CACHE_CAPACIDAD_INICIAL 64
+
+/**
+ * @brief Entrada de la caché: nombre del comando y ruta absoluta
+ */
+typedef struct
+{
+    char* nombre;  /**< Nombre del comando, NULL si la celda está libre */
+    char* ruta;    /**< Ruta absoluta del ejecutable */
+    uint32_t hash; /**< Hash del nombre */
+    unsigned usos; /**< Cantidad de veces que se resolvió el comando */
+} entrada_cache;
+
+/**
+ * @brief Tabla hash con direccionamiento abierto y sondeo lineal
+ */
+static entrada_cache* tabla = NULL;
+
+/**
+ * @brief Capacidad de la tabla
+ */
+static size_t capacidad = 0;
+
+/**
+ * @brief Entradas ocupadas
+ */
+static size_t ocupadas = 0;
+
+/**
+ * @brief Valor de $PATH con el que se llenó la caché
+ */
+static char* path_cacheado = NULL;
+
+/**
+ * @brief Protege la tabla: los trabajadores de 'parallel' resuelven comandos desde varios hilos
+ */
+static pthread_mutex_t mutex_cache = PTHREAD_MUTEX_INITIALIZER;
+
+// Hash FNV-1a de 32 bits
+static uint32_t hash_nombre(const char* nombre)
+{
+    uint32_t h = 2166136261u;
+    for (const unsigned char* p = (const unsigned char*)nombre; *p != '\0'; p++)
+    {
+        h ^= *p;
+        h *= 16777619u;
+    }
+    return h;
+}
+
+// Buscar la celda de un nombre: la ocupada por él o la libre donde debería ir
+static size_t buscar_celda(const char* nombre, uint32_t h)
+{
+    size_t mascara = capacidad - 1;
+    size_t i = h & mascara;
+    while (tabla[i].nombre != NULL && (tabla[i].hash != h || strcmp(tabla[i].nombre, nombre) != 0))
+    {
+        i = (i + 1) & mascara;
+    }
+    return i;
+}
+
+// Duplicar la capacidad de la tabla y reubicar las entradas
+static bool crecer_tabla(void)
+{
+    size_t nueva_capacidad = capacidad ? capacidad * 2 : CACHE_CAPACIDAD_INICIAL;
+    entrada_cache* nueva = calloc(nueva_capacidad, sizeof(entrada_cache));
+    if (nueva == NULL)
+    {
+        return false;
+    }
+
+    entrada_cache* vieja = tabla;
+    size_t vieja_capacidad = capacidad;
+    tabla = nueva;
+    capacidad = nueva_capacidad;
+
+    for (size_t i = 0; i < vieja_capacidad; i++)
+    {
+        if (vieja[i].nombre != NULL)
+        {
+            tabla[buscar_celda(vieja[i].nombre, vieja[i].hash)] = vieja[i];
+        }
+    }
+    free(vieja);
+    return true;
+}
+
+// Eliminar la entrada de una celda reubicando las siguientes del mismo grupo (borrado sin lápidas)
+static void eliminar_celda(size_t i)
+{
+    size_t mascara = capacidad - 1;
+    free(tabla[i].nombre);
+    free(tabla[i].ruta);
+    tabla[i].nombre = NULL;
+    ocupadas--;
+
+    size_t j = i;
+    for (;;)
+    {
+        j = (j + 1) & mascara;
+        if (tabla[j].nombre == NULL)
+        {
+            return;
+        }
+        size_t ideal = tabla[j].hash & mascara;
+        // Mover la entrada j al hueco i si su posición ideal no está entre i (exclusivo) y j (inclusivo)
+        bool entre = (i <= j) ? (i < ideal && ideal <= j) : (i < ideal || ideal <= j);
+        if (!entre)
+        {
+            tabla[i] = tabla[j];
+            tabla[j].nombre = NULL;
+            i = j;
+        }
+    }
+}
+
+// Liberar todas las entradas de la tabla (con el mutex tomado)
+static void vaciar_tabla(void)
+{
+    for (size_t i = 0; i < capacidad; i++)
+    {
+        if (tabla[i].nombre != NULL)
+        {
+            free(tabla[i].nombre);
+            free(tabla[i].ruta);
+            tabla[i].nombre = NULL;
+        }
+    }
+    ocupadas = 0;
+}
+
+// Vaciar la caché si $PATH cambió desde que se llenó (con el mutex tomado)
+static void verificar_path(void)
+{
+    const char* path = getenv("PATH");
+    if (path == NULL)
+    {
+        path = "";
+    }
+    if (path_cacheado != NULL && strcmp(path_cacheado, path) == 0)
+    {
+        return;
+    }
+    vaciar_tabla();
+    free(path_cacheado);
+    path_cacheado = strdup(path);
+}
+
+// Verificar que una ruta sea un archivo regular ejecutable
+static bool es_ejecutable(const char* ruta)
+{
+    struct stat st;
+    return stat(ruta, &st) == 0 && S_ISREG(st.st_mode) && access(ruta, X_OK) == 0;
+}
+
+// Recorrer $PATH buscando el comando; indica si la ruta es cacheable (directorio absoluto)
+static bool buscar_en_path(const char* nombre, char* ruta, size_t tam, bool* cacheable)
+{
+    const char* path = path_cacheado != NULL ? path_cacheado : "";
+    const char* inicio = path;
+
+    for (;;)
+    {
+        const char* fin = strchr(inicio, ':');
+        size_t largo = fin ? (size_t)(fin - inicio) : strlen(inicio);
+
+        // Un componente vacío significa el directorio actual
+        int escrito = largo == 0 ? snprintf(ruta, tam, "%s", nombre)
+                                 : snprintf(ruta, tam, "%.*s/%s", (int)largo, inicio, nombre);
+        if (escrito > 0 && (size_t)escrito < tam && es_ejecutable(ruta))
+        {
+            *cacheable = largo > 0 && inicio[0] == '/'; // Las rutas relativas dependen del directorio actual
+            return true;
+        }
+
+        if (fin == NULL)
+        {
+            return false;
+        }
+        inicio = fin + 1;
+    }
+}
+
+// Resolver un comando usando la caché (con el mutex tomado)
+static bool resolver_en_tabla(const char* nombre, char* ruta, size_t tam)
+{
+    verificar_path();
+
+    uint32_t h = hash_nombre(nombre);
+    if (capacidad > 0)
+    {
+        size_t i = buscar_celda(nombre, h);
+        if (tabla[i].nombre != NULL)
+        {
+            tabla[i].usos++;
+            snprintf(ruta, tam, "%s", tabla[i].ruta);
+            return true;
+        }
+    }
+
+    bool cacheable = false;
+    if (!buscar_en_path(nombre, ruta, tam, &cacheable))
+    {
+        return false;
+    }
+    if (!cacheable)
+    {
+        return true;
+    }
+
+    // Mantener el factor de carga por debajo de 0.7
+    if ((ocupadas + 1) * 10 > capacidad * 7 && !crecer_tabla())
+    {
+        return true;
+    }
+
+    size_t i = buscar_celda(nombre, h);
+    tabla[i].nombre = strdup(nombre);
+    tabla[i].ruta = strdup(ruta);
+    if (tabla[i].nombre == NULL || tabla[i].ruta == NULL)
+    {
+        free(tabla[i].nombre);
+        free(tabla[i].ruta);
+        tabla[i].nombre = NULL;
+        return true;
+    }
+    tabla[i].hash = h;
+    tabla[i].usos = 1;
+    ocupadas++;
+    return true;
+}
+
+// Resolver un comando usando la caché
+bool cache_resolver(const char* nombre, char* ruta, size_t tam)
+{
+    if (nombre == NULL || nombre[0] == '\0' || tam == 0)
+    {
+        return false;
+    }
+
+    // Las rutas explícitas no pasan por $PATH
+    if (strchr(nombre, '/') != NULL)
+    {
+        snprintf(ruta, tam, "%s", nombre);
+        return true;
+    }
+
+    pthread_mutex_lock(&mutex_cache);
+    bool encontrado = resolver_en_tabla(nombre, ruta, tam);
+    pthread_mutex_unlock(&mutex_cache);
+    return encontrado;
+}
+
+// Descartar la entrada de un comando
+bool cache_olvidar(const char* nombre)
+{
+    if (nombre == NULL)
+    {
+        return false;
+    }
+
+    pthread_mutex_lock(&mutex_cache);
+    bool habia = false;
+    if (capacidad > 0)
+    {
+        size_t i = buscar_celda(nombre, hash_nombre(nombre));
+        habia = tabla[i].nombre != NULL;
+        if (habia)
+        {
+            eliminar_celda(i);
+        }
+    }
+    pthread_mutex_unlock(&mutex_cache);
+    return habia;
+}
+
+// Vaciar la caché
+void cache_limpiar(void)
+{
+    pthread_mutex_lock(&mutex_cache);
+    vaciar_tabla();
+    pthread_mutex_unlock(&mutex_cache);
+}
+
+// Cantidad de entradas en la caché
+size_t cache_tamano(void)
+{
+    return ocupadas;
+}
+
+// Listar las entradas de la caché
+static void listar_cache(void)
+{
+    if (ocupadas == 0)
+    {
+        printf("hash: la tabla está vacía\n");
+        return;
+    }
+    printf("usos\tcomando\n");
+    for (size_t i = 0; i < capacidad; i++)
+    {
+        if (tabla[i].nombre != NULL)
+        {
+            printf("%4u\t%s\n", tabla[i].usos, tabla[i].ruta);
+        }
+    }
+}
+
+// Manejar el comando "hash"
+int manejar_comando_hash(int argc, char** argv)
+{
+    if (argc < 2) // Sin argumentos: listar
+    {
+        pthread_mutex_lock(&mutex_cache);
+        verificar_path();
+        listar_cache();
+        pthread_mutex_unlock(&mutex_cache);
+        return 0;
+    }
+
+    if (strcmp(argv[1], "-r") == 0) // Vaciar la caché
+    {
+        cache_limpiar();
+        return 0;
+    }
+
+    bool olvidar = strcmp(argv[1], "-d") == 0; // Descartar entradas en lugar de precargarlas
+    int estado = 0;
+
+    for (int i = olvidar ? 2 : 1; i < argc; i++)
+    {
+        char ruta[PATH_MAX];
+        if (olvidar ? !cache_olvidar(argv[i]) : !cache_resolver(argv[i], ruta, sizeof(ruta)))
+        {
+            fprintf(stderr, "hash: %s: no encontrado\n", argv[i]);
+            estado = 1;
+        }
+    }
+    return estado;
+}
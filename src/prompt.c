@@ -0,0 +1,566 @@
+/**
+ * @file prompt.c
+ * @brief Motor del prompt: datos en caché, segmentos configurables y cálculo asíncrono de los segmentos lentos.
+ */
+#include "prompt.h"
+#include "globals.h"
+#include "jobs.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <pthread.h>
+#include <pwd.h>
+#include <signal.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+/**
+ *  @brief Tamaño del texto de un segmento
+ */
+#define TAM_SEGMENTO 128
+
+/**
+ *  @brief Tamaño del buffer del prompt completo
+ */
+#define TAM_PROMPT (PATH_MAX + 2 * MAX_NAMES + 1024)
+
+/**
+ *  @brief Largo del identificador abreviado de un commit (HEAD separado)
+ */
+#define LARGO_COMMIT 7
+
+/**
+ * @brief Segmentos del prompt
+ */
+typedef enum
+{
+    SEGMENTO_ESTADO,   /**< Estado de salida del último comando */
+    SEGMENTO_DURACION, /**< Duración del último comando */
+    SEGMENTO_TRABAJOS, /**< Cantidad de trabajos */
+    SEGMENTO_MONITOR,  /**< Estado del monitor */
+    SEGMENTO_GIT,      /**< Rama del repositorio git */
+    NUM_SEGMENTOS      /**< Cantidad de segmentos */
+} tipo_segmento;
+
+/**
+ * @brief Descripción de un segmento del prompt
+ */
+typedef struct
+{
+    const char* nombre;                           /**< Nombre con el que se elige en 'prompt' */
+    const char* color;                            /**< Secuencia SGR con la que se muestra */
+    bool lento;                                   /**< Se calcula en el hilo de segmentos lentos */
+    void (*calcular)(const char*, char*, size_t); /**< Escribe el texto del segmento; vacío si no aplica */
+} descriptor_segmento;
+
+/**
+ * @brief Estado del prompt en el hilo principal
+ */
+typedef struct
+{
+    bool iniciado;                        /**< Usuario, host y home ya se leyeron */
+    char usuario[MAX_NAMES];              /**< Nombre del usuario */
+    char host[MAX_NAMES];                 /**< Nombre del host */
+    char home[PATH_MAX];                  /**< Directorio home del usuario */
+    char directorio[PATH_MAX + 1];        /**< Directorio actual como se muestra ("~" en lugar del home) */
+    tipo_segmento activos[NUM_SEGMENTOS]; /**< Segmentos activos, en orden */
+    int num_activos;                      /**< Segmentos activos */
+    bool midiendo;                        /**< Hay un comando en curso cuya duración se mide */
+    struct timespec inicio_comando;       /**< Comienzo del último comando */
+    long long duracion_ms;                /**< Duración del último comando */
+    int estado;                           /**< Estado de salida del último comando */
+    unsigned long generacion;             /**< Cambia cuando los segmentos lentos pueden haber cambiado */
+} motor_prompt;
+
+/**
+ * @brief Solicitudes y resultados del hilo de segmentos lentos
+ */
+typedef struct
+{
+    pthread_mutex_t mutex;                   /**< Protege los campos siguientes */
+    pthread_cond_t pedido;                   /**< Hay una solicitud nueva o el hilo debe terminar */
+    pthread_cond_t listo;                    /**< El hilo terminó una solicitud (reloj CLOCK_MONOTONIC) */
+    pthread_t hilo;                          /**< Hilo que calcula los segmentos */
+    bool hilo_activo;                        /**< El hilo está en ejecución */
+    bool sin_hilo;                           /**< El hilo no se pudo crear: los segmentos lentos no se muestran */
+    bool terminar;                           /**< El hilo debe terminar */
+    unsigned long solicitada;                /**< Generación de la última solicitud */
+    unsigned long atendida;                  /**< Generación que el hilo tomó por última vez */
+    unsigned long calculada;                 /**< Generación del resultado */
+    unsigned mascara;                        /**< Segmentos pedidos (un bit por tipo_segmento) */
+    char pedido_directorio[PATH_MAX];        /**< Directorio de la solicitud */
+    char directorio[PATH_MAX];               /**< Directorio del resultado */
+    char texto[NUM_SEGMENTOS][TAM_SEGMENTO]; /**< Resultado de cada segmento pedido */
+} segmentos_lentos;
+
+/**
+ * @brief Prompt en construcción
+ */
+typedef struct
+{
+    char* texto;     /**< Buffer de destino */
+    size_t tam;      /**< Tamaño del buffer */
+    size_t longitud; /**< Bytes ocupados, sin contar el '\0' */
+} texto_prompt;
+
+static void calcular_estado(const char* directorio, char* texto, size_t tam);
+static void calcular_duracion(const char* directorio, char* texto, size_t tam);
+static void calcular_trabajos(const char* directorio, char* texto, size_t tam);
+static void calcular_monitor(const char* directorio, char* texto, size_t tam);
+static void calcular_git(const char* directorio, char* texto, size_t tam);
+
+/**
+ * @brief Segmentos disponibles, indexados por tipo_segmento
+ */
+static const descriptor_segmento segmentos[NUM_SEGMENTOS] = {
+    {"estado", "1;31", false, calcular_estado},
+    {"duracion", "33", false, calcular_duracion},
+    {"trabajos", "36", false, calcular_trabajos},
+    {"monitor", "32", false, calcular_monitor},
+    {"git", "1;35", true, calcular_git},
+};
+
+/**
+ *  @brief Estado del prompt
+ */
+static motor_prompt motor = {.generacion = 1};
+
+/**
+ *  @brief Hilo de segmentos lentos
+ */
+static segmentos_lentos lentos = {.mutex = PTHREAD_MUTEX_INITIALIZER, .pedido = PTHREAD_COND_INITIALIZER};
+
+// Agregar texto con formato al prompt, descartando lo que no entra
+__attribute__((format(printf, 2, 3))) static void agregar(texto_prompt* p, const char* formato, ...)
+{
+    if (p->longitud + 1 >= p->tam)
+        return;
+    va_list args;
+    va_start(args, formato);
+    int n = vsnprintf(p->texto + p->longitud, p->tam - p->longitud, formato, args);
+    va_end(args);
+    if (n > 0)
+        p->longitud += (size_t)n < p->tam - p->longitud ? (size_t)n : p->tam - p->longitud - 1;
+}
+
+// Segmento "estado": estado de salida del último comando, si falló
+static void calcular_estado(const char* directorio __attribute__((unused)), char* texto, size_t tam)
+{
+    if (motor.estado != 0)
+        snprintf(texto, tam, "[%d]", motor.estado);
+}
+
+// Segmento "duracion": duración del último comando, si fue larga
+static void calcular_duracion(const char* directorio __attribute__((unused)), char* texto, size_t tam)
+{
+    if (motor.duracion_ms < PROMPT_DURACION_MINIMA_MS)
+        return;
+    if (motor.duracion_ms < 60000)
+        snprintf(texto, tam, "%.1fs", (double)motor.duracion_ms / 1000.0);
+    else
+        snprintf(texto, tam, "%lldm%02llds", motor.duracion_ms / 60000, motor.duracion_ms / 1000 % 60);
+}
+
+// Segmento "trabajos": cantidad de trabajos en la tabla
+static void calcular_trabajos(const char* directorio __attribute__((unused)), char* texto, size_t tam)
+{
+    int n = trabajos_cantidad();
+    if (n > 0)
+        snprintf(texto, tam, "%d trabajo%s", n, n == 1 ? "" : "s");
+}
+
+// Segmento "monitor": el monitor está en ejecución
+static void calcular_monitor(const char* directorio __attribute__((unused)), char* texto, size_t tam)
+{
+    if (monitor_pid > 0)
+        snprintf(texto, tam, "monitor");
+}
+
+// Leer la primera línea de un archivo pequeño, sin el salto de línea
+static bool leer_linea(const char* ruta, char* linea, size_t tam)
+{
+    int fd = open(ruta, O_RDONLY | O_CLOEXEC);
+    if (fd == -1)
+        return false;
+    ssize_t leidos = read(fd, linea, tam - 1);
+    close(fd);
+    if (leidos <= 0)
+        return false;
+    linea[leidos] = '\0';
+    linea[strcspn(linea, "\n")] = '\0';
+    return true;
+}
+
+// Segmento "git": rama o commit de HEAD del repositorio que contiene al directorio
+static void calcular_git(const char* directorio, char* texto, size_t tam)
+{
+    char base[PATH_MAX];
+    char ruta[PATH_MAX + 16];
+    char linea[PATH_MAX];
+    struct stat st;
+    snprintf(base, sizeof(base), "%s", directorio);
+
+    // Subir desde el directorio hasta encontrar .git (un directorio o, en worktrees y submódulos, un archivo)
+    while (true)
+    {
+        snprintf(ruta, sizeof(ruta), "%s/.git", strcmp(base, "/") == 0 ? "" : base);
+        if (stat(ruta, &st) == 0)
+            break;
+        char* barra = strrchr(base, '/');
+        if (barra == NULL || strcmp(base, "/") == 0)
+            return;
+        barra[barra == base ? 1 : 0] = '\0';
+    }
+
+    if (S_ISREG(st.st_mode))
+    {
+        // El archivo .git contiene "gitdir: ruta", relativa al directorio que lo contiene
+        if (!leer_linea(ruta, linea, sizeof(linea)) || strncmp(linea, "gitdir: ", 8) != 0)
+            return;
+        if (linea[8] == '/')
+            snprintf(ruta, sizeof(ruta), "%s/HEAD", linea + 8);
+        else
+            snprintf(ruta, sizeof(ruta), "%s/%s/HEAD", base, linea + 8);
+    }
+    else
+    {
+        strcat(ruta, "/HEAD");
+    }
+    if (!leer_linea(ruta, linea, sizeof(linea)))
+        return;
+
+    if (strncmp(linea, "ref: refs/heads/", 16) == 0)
+        snprintf(texto, tam, "(%s)", linea + 16);
+    else if (strncmp(linea, "ref: ", 5) == 0)
+        snprintf(texto, tam, "(%s)", linea + 5);
+    else
+        snprintf(texto, tam, "(%.*s)", LARGO_COMMIT, linea); // HEAD separado: commit abreviado
+}
+
+// Hilo que calcula los segmentos lentos de cada solicitud
+static void* calcular_segmentos_lentos(void* arg __attribute__((unused)))
+{
+    char directorio[PATH_MAX];
+    char texto[NUM_SEGMENTOS][TAM_SEGMENTO];
+    pthread_mutex_lock(&lentos.mutex);
+    while (!lentos.terminar)
+    {
+        if (lentos.atendida == lentos.solicitada)
+        {
+            pthread_cond_wait(&lentos.pedido, &lentos.mutex);
+            continue;
+        }
+        unsigned long generacion = lentos.solicitada;
+        unsigned mascara = lentos.mascara;
+        memcpy(directorio, lentos.pedido_directorio, sizeof(directorio));
+        lentos.atendida = generacion;
+        pthread_mutex_unlock(&lentos.mutex);
+
+        // El cálculo se hace sin el mutex: el prompt no espera más que su presupuesto
+        for (int i = 0; i < NUM_SEGMENTOS; i++)
+        {
+            texto[i][0] = '\0';
+            if (mascara & (1u << i))
+                segmentos[i].calcular(directorio, texto[i], TAM_SEGMENTO);
+        }
+
+        pthread_mutex_lock(&lentos.mutex);
+        memcpy(lentos.texto, texto, sizeof(texto));
+        memcpy(lentos.directorio, directorio, sizeof(directorio));
+        lentos.calculada = generacion;
+        pthread_cond_broadcast(&lentos.listo);
+    }
+    pthread_mutex_unlock(&lentos.mutex);
+    return NULL;
+}
+
+// Crear el hilo de segmentos lentos, si todavía no existe
+static bool iniciar_hilo(void)
+{
+    if (lentos.hilo_activo || lentos.sin_hilo)
+        return lentos.hilo_activo;
+
+    static bool condicion_creada = false;
+    if (!condicion_creada)
+    {
+        pthread_condattr_t atributos;
+        pthread_condattr_init(&atributos);
+        pthread_condattr_setclock(&atributos, CLOCK_MONOTONIC); // El presupuesto no depende de la hora del sistema
+        pthread_cond_init(&lentos.listo, &atributos);
+        pthread_condattr_destroy(&atributos);
+        condicion_creada = true;
+    }
+
+    // Las señales se atienden en el hilo principal del shell: el hilo las tiene bloqueadas
+    sigset_t todas;
+    sigset_t anterior;
+    sigfillset(&todas);
+    pthread_sigmask(SIG_BLOCK, &todas, &anterior);
+    lentos.terminar = false;
+    lentos.hilo_activo = pthread_create(&lentos.hilo, NULL, calcular_segmentos_lentos, NULL) == 0;
+    pthread_sigmask(SIG_SETMASK, &anterior, NULL);
+    lentos.sin_hilo = !lentos.hilo_activo; // No reintentar en cada prompt
+    return lentos.hilo_activo;
+}
+
+// Obtener los segmentos lentos para el directorio actual, esperando a lo sumo el presupuesto
+static void obtener_segmentos_lentos(unsigned mascara, char (*texto)[TAM_SEGMENTO])
+{
+    if (!iniciar_hilo())
+        return;
+
+    pthread_mutex_lock(&lentos.mutex);
+    if (lentos.calculada != motor.generacion)
+    {
+        if (lentos.solicitada != motor.generacion)
+        {
+            lentos.solicitada = motor.generacion;
+            lentos.mascara = mascara;
+            snprintf(lentos.pedido_directorio, sizeof(lentos.pedido_directorio), "%s", cwd);
+            pthread_cond_signal(&lentos.pedido);
+        }
+
+        struct timespec limite;
+        clock_gettime(CLOCK_MONOTONIC, &limite);
+        limite.tv_nsec += PROMPT_PRESUPUESTO_MS * 1000000L;
+        if (limite.tv_nsec >= 1000000000L)
+        {
+            limite.tv_sec++;
+            limite.tv_nsec -= 1000000000L;
+        }
+        while (lentos.calculada != motor.generacion &&
+               pthread_cond_timedwait(&lentos.listo, &lentos.mutex, &limite) != ETIMEDOUT)
+            ;
+    }
+
+    // Si el resultado no llegó a tiempo se usa el anterior, pero sólo si es del mismo directorio
+    if (strcmp(lentos.directorio, cwd) == 0)
+    {
+        for (int i = 0; i < NUM_SEGMENTOS; i++)
+        {
+            if (mascara & (1u << i))
+                memcpy(texto[i], lentos.texto[i], TAM_SEGMENTO);
+        }
+    }
+    pthread_mutex_unlock(&lentos.mutex);
+}
+
+// Leer una lista de segmentos separados por espacios o comas; devuelve cuántos hay o -1 si alguno no existe
+static int leer_segmentos(char* const* nombres, int n, tipo_segmento* activos)
+{
+    int cantidad = 0;
+    for (int i = 0; i < n; i++)
+    {
+        char copia[256];
+        snprintf(copia, sizeof(copia), "%s", nombres[i]);
+        char* contexto = NULL;
+        for (char* nombre = strtok_r(copia, ", ", &contexto); nombre != NULL; nombre = strtok_r(NULL, ", ", &contexto))
+        {
+            int tipo = 0;
+            while (tipo < NUM_SEGMENTOS && strcmp(segmentos[tipo].nombre, nombre) != 0)
+                tipo++;
+            if (tipo == NUM_SEGMENTOS)
+            {
+                fprintf(stderr, "prompt: segmento desconocido '%s'\n", nombre);
+                return -1;
+            }
+            bool repetido = false;
+            for (int j = 0; j < cantidad; j++)
+                repetido = repetido || activos[j] == (tipo_segmento)tipo;
+            if (!repetido)
+                activos[cantidad++] = (tipo_segmento)tipo;
+        }
+    }
+    return cantidad;
+}
+
+// Recalcular el directorio que se muestra a partir de cwd
+static void actualizar_directorio(void)
+{
+    size_t largo_home = strlen(motor.home);
+    if (largo_home > 1 && strncmp(cwd, motor.home, largo_home) == 0 &&
+        (cwd[largo_home] == '\0' || cwd[largo_home] == '/'))
+    {
+        snprintf(motor.directorio, sizeof(motor.directorio), "~%s", cwd + largo_home);
+    }
+    else
+    {
+        snprintf(motor.directorio, sizeof(motor.directorio), "%s", cwd);
+    }
+}
+
+// Leer usuario, host, home y los segmentos iniciales, una sola vez
+static void iniciar_motor(void)
+{
+    if (motor.iniciado)
+        return;
+    motor.iniciado = true;
+
+    struct passwd* pw = getpwuid(getuid());
+    const char* usuario = pw != NULL ? pw->pw_name : getenv("USER");
+    const char* home = pw != NULL ? pw->pw_dir : getenv("HOME");
+    snprintf(motor.usuario, sizeof(motor.usuario), "%s", usuario != NULL ? usuario : "");
+    snprintf(motor.home, sizeof(motor.home), "%s", home != NULL ? home : "");
+    if (gethostname(motor.host, sizeof(motor.host)) == -1)
+        motor.host[0] = '\0';
+    motor.host[sizeof(motor.host) - 1] = '\0';
+
+    if (cwd[0] == '\0' && getcwd(cwd, sizeof(cwd)) == NULL)
+        perror("getcwd() error");
+    actualizar_directorio();
+
+    char* inicial = getenv(PROMPT_ENV);
+    if (inicial != NULL)
+    {
+        tipo_segmento activos[NUM_SEGMENTOS];
+        int n = leer_segmentos(&inicial, 1, activos);
+        if (n >= 0)
+        {
+            memcpy(motor.activos, activos, sizeof(activos));
+            motor.num_activos = n;
+        }
+    }
+}
+
+// Registrar el comienzo de un comando
+void prompt_antes_de_comando(void)
+{
+    clock_gettime(CLOCK_MONOTONIC, &motor.inicio_comando);
+    motor.midiendo = true;
+}
+
+// Registrar el final de un comando
+void prompt_despues_de_comando(void)
+{
+    if (!motor.midiendo)
+        return;
+    struct timespec ahora;
+    clock_gettime(CLOCK_MONOTONIC, &ahora);
+    motor.duracion_ms = (long long)(ahora.tv_sec - motor.inicio_comando.tv_sec) * 1000 +
+                        (ahora.tv_nsec - motor.inicio_comando.tv_nsec) / 1000000;
+    motor.estado = ultimo_estado;
+    motor.midiendo = false;
+    motor.generacion++;
+}
+
+// Actualizar el directorio del prompt después de un 'cd'
+void prompt_directorio_cambiado(void)
+{
+    if (!motor.iniciado)
+        return; // Se calcula al armar el primer prompt
+    actualizar_directorio();
+    motor.generacion++;
+}
+
+// Armar el prompt en un buffer
+size_t prompt_componer(char* buffer, size_t tam)
+{
+    if (tam == 0)
+        return 0;
+    iniciar_motor();
+
+    // Los segmentos rápidos se calculan acá; los lentos, en el hilo
+    char texto[NUM_SEGMENTOS][TAM_SEGMENTO];
+    unsigned mascara_lentos = 0;
+    for (int i = 0; i < motor.num_activos; i++)
+    {
+        tipo_segmento tipo = motor.activos[i];
+        texto[tipo][0] = '\0';
+        if (segmentos[tipo].lento)
+            mascara_lentos |= 1u << tipo;
+        else
+            segmentos[tipo].calcular(cwd, texto[tipo], TAM_SEGMENTO);
+    }
+    if (mascara_lentos != 0)
+        obtener_segmentos_lentos(mascara_lentos, texto);
+
+    texto_prompt p = {buffer, tam, 0};
+    buffer[0] = '\0';
+    agregar(&p, "\033[1;33m%s@%s:\033[1;34m%s\033[0m", motor.usuario, motor.host, motor.directorio);
+    for (int i = 0; i < motor.num_activos; i++)
+    {
+        tipo_segmento tipo = motor.activos[i];
+        if (texto[tipo][0] != '\0')
+            agregar(&p, " \033[%sm%s\033[0m", segmentos[tipo].color, texto[tipo]);
+    }
+    agregar(&p, "$ ");
+    return p.longitud;
+}
+
+// Mostrar el prompt con un único write()
+void prompt_mostrar(void)
+{
+    char buffer[TAM_PROMPT];
+    size_t longitud = prompt_componer(buffer, sizeof(buffer));
+    fflush(stdout); // Lo que quedó en el buffer de stdio va antes que el prompt
+
+    size_t escritos = 0;
+    while (escritos < longitud)
+    {
+        ssize_t n = write(STDOUT_FILENO, buffer + escritos, longitud - escritos);
+        if (n == -1 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            break;
+        escritos += (size_t)n;
+    }
+}
+
+// Detener el hilo de segmentos lentos
+void prompt_liberar(void)
+{
+    if (!lentos.hilo_activo)
+        return;
+    pthread_mutex_lock(&lentos.mutex);
+    lentos.terminar = true;
+    pthread_cond_signal(&lentos.pedido);
+    pthread_mutex_unlock(&lentos.mutex);
+    pthread_join(lentos.hilo, NULL);
+    lentos.hilo_activo = false;
+}
+
+// Comando "prompt"
+int manejar_comando_prompt(int argc, char** argv)
+{
+    iniciar_motor();
+    if (argc == 1)
+    {
+        printf("Segmentos activos:");
+        for (int i = 0; i < motor.num_activos; i++)
+            printf(" %s", segmentos[motor.activos[i]].nombre);
+        printf("%s\nDisponibles:", motor.num_activos == 0 ? " (ninguno)" : "");
+        for (int i = 0; i < NUM_SEGMENTOS; i++)
+            printf(" %s", segmentos[i].nombre);
+        printf("\n");
+        return 0;
+    }
+
+    if (argc == 2 && strcmp(argv[1], "-r") == 0)
+    {
+        motor.num_activos = 0;
+        return 0;
+    }
+    if (argv[1][0] == '-')
+    {
+        fprintf(stderr, "prompt: opción inválida '%s'\nUso: prompt [-r | segmento...]\n", argv[1]);
+        return 2;
+    }
+
+    tipo_segmento activos[NUM_SEGMENTOS];
+    int n = leer_segmentos(argv + 1, argc - 1, activos);
+    if (n < 0)
+    {
+        fprintf(stderr, "Uso: prompt [-r | segmento...]\n");
+        return 2;
+    }
+    memcpy(motor.activos, activos, sizeof(activos));
+    motor.num_activos = n;
+    motor.generacion++; // Los segmentos lentos nuevos se piden en el próximo prompt
+    return 0;
+}
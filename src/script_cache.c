@@ -0,0 +1,367 @@
+/**
+ * @file script_cache.c
+ * @brief Implementación de la caché en disco de los scripts compilados.
+ */
+
+#include "script_cache.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <unistd.h>
+
+/**
+ *  @brief Valor inicial del hash FNV-1a de 64 bits
+ */
+#define FNV_BASE 14695981039346656037ULL
+
+/**
+ *  @brief Primo del hash FNV-1a de 64 bits
+ */
+#define FNV_PRIMO 1099511628211ULL
+
+/**
+ * @brief Cabecera de un archivo de caché; le siguen la ruta real del script y los registros de las unidades.
+ */
+typedef struct
+{
+    uint32_t magia;            /**< CACHE_SCRIPTS_MAGIA */
+    uint32_t version;          /**< CACHE_SCRIPTS_VERSION */
+    uint32_t version_bytecode; /**< BYTECODE_VERSION */
+    uint32_t num_unidades;     /**< Registros que siguen a la ruta */
+    char version_shell[16];    /**< SHELL_VERSION, terminada en '\0' */
+    uint64_t tamano;           /**< Tamaño del script */
+    uint64_t dispositivo;      /**< Dispositivo del script */
+    uint64_t inodo;            /**< Inodo del script */
+    int64_t modificado_ns;     /**< st_mtim del script, en nanosegundos */
+    uint64_t suma;             /**< Hash FNV-1a de todo lo que sigue a la cabecera */
+    uint32_t largo_ruta;       /**< Bytes de la ruta real, terminador incluido */
+    int32_t lineas;            /**< Líneas del script */
+} cabecera_cache;
+
+/**
+ * @brief Registro de una unidad; le siguen sus datos, completados con ceros hasta un múltiplo de 8 bytes.
+ */
+typedef struct
+{
+    uint32_t tipo;  /**< tipo_unidad */
+    int32_t linea;  /**< Línea donde empieza la unidad */
+    int32_t grado;  /**< Grado de un begin_parallel */
+    uint32_t largo; /**< Bytes de datos: el bloque del programa o el mensaje con su terminador */
+} registro_unidad;
+
+// Redondear un tamaño al siguiente múltiplo de 8
+static size_t alinear8(size_t n)
+{
+    return (n + 7) & ~(size_t)7;
+}
+
+// Hash FNV-1a de 64 bits de un bloque
+static uint64_t hash_bloque(const unsigned char* datos, size_t largo)
+{
+    uint64_t hash = FNV_BASE;
+    for (size_t i = 0; i < largo; i++)
+        hash = (hash ^ datos[i]) * FNV_PRIMO;
+    return hash;
+}
+
+// Tiempo de modificación de un stat en nanosegundos
+static int64_t modificacion_ns(const struct stat* st)
+{
+    return (int64_t)st->st_mtim.tv_sec * 1000000000LL + st->st_mtim.tv_nsec;
+}
+
+// Ruta del archivo de caché de un script, creando el directorio de las cachés si hace falta; NULL si no hay dónde
+static char* ruta_archivo(const char* real)
+{
+    char directorio[PATH_MAX];
+    const char* indicado = getenv(CACHE_SCRIPTS_ENV);
+    const char* cache = getenv("XDG_CACHE_HOME");
+    const char* home = getenv("HOME");
+    if (indicado != NULL && indicado[0] != '\0')
+        snprintf(directorio, sizeof(directorio), "%s", indicado);
+    else if (cache != NULL && cache[0] == '/')
+        snprintf(directorio, sizeof(directorio), "%s/ShellProject/scripts", cache);
+    else if (home != NULL && home[0] != '\0')
+        snprintf(directorio, sizeof(directorio), "%s/.cache/ShellProject/scripts", home);
+    else
+        return NULL;
+
+    // Crear los directorios que falten, de arriba hacia abajo
+    for (char* barra = strchr(directorio + 1, '/'); barra != NULL; barra = strchr(barra + 1, '/'))
+    {
+        *barra = '\0';
+        mkdir(directorio, 0700);
+        *barra = '/';
+    }
+    if (mkdir(directorio, 0700) == -1 && errno != EEXIST)
+        return NULL;
+
+    char* archivo = malloc(strlen(directorio) + 21);
+    if (archivo != NULL)
+        sprintf(archivo, "%s/%016llx.bc", directorio,
+                (unsigned long long)hash_bloque((const unsigned char*)real, strlen(real)));
+    return archivo;
+}
+
+// Comprobar que la cabecera corresponde al script y a esta versión del shell
+static bool cabecera_vigente(const cabecera_cache* h, const char* real, const struct stat* info)
+{
+    return h->magia == CACHE_SCRIPTS_MAGIA && h->version == CACHE_SCRIPTS_VERSION &&
+           h->version_bytecode == BYTECODE_VERSION &&
+           strncmp(h->version_shell, SHELL_VERSION, sizeof(h->version_shell) - 1) == 0 &&
+           h->tamano == (uint64_t)info->st_size && h->dispositivo == (uint64_t)info->st_dev &&
+           h->inodo == (uint64_t)info->st_ino && h->modificado_ns == modificacion_ns(info) &&
+           h->largo_ruta == strlen(real) + 1;
+}
+
+// Leer y validar el registro que empieza en *posicion, avanzando *posicion hasta el siguiente
+static bool leer_registro(const cache_script* c, size_t* posicion, unidad_cacheada* u)
+{
+    if (c->largo - *posicion < sizeof(registro_unidad))
+        return false;
+    const registro_unidad* r = (const registro_unidad*)(c->mapa + *posicion);
+    const unsigned char* datos = c->mapa + *posicion + sizeof(registro_unidad);
+    size_t disponible = c->largo - *posicion - sizeof(registro_unidad);
+    if (r->largo > disponible || alinear8(r->largo) > disponible)
+        return false;
+
+    u->tipo = (tipo_unidad)r->tipo;
+    u->linea = r->linea;
+    u->grado = r->grado;
+    u->error = NULL;
+    switch (r->tipo)
+    {
+    case UNIDAD_COMANDOS:
+        if (programa_abrir(datos, r->largo, &u->programa) == -1)
+            return false;
+        break;
+    case UNIDAD_ERROR:
+        if (r->largo == 0 || datos[r->largo - 1] != '\0')
+            return false;
+        u->error = (const char*)datos;
+        break;
+    case UNIDAD_INICIO_PARALELO:
+    case UNIDAD_FIN_PARALELO:
+        break;
+    default:
+        return false;
+    }
+    *posicion += sizeof(registro_unidad) + alinear8(r->largo);
+    return true;
+}
+
+// Abrir la caché de un script
+int cache_abrir(const char* ruta, const struct stat* info, cache_script* c)
+{
+    memset(c, 0, sizeof(*c));
+    char real[PATH_MAX];
+    if (!S_ISREG(info->st_mode) || realpath(ruta, real) == NULL)
+        return -1;
+    char* archivo = ruta_archivo(real);
+    if (archivo == NULL)
+        return -1;
+    int fd = open(archivo, O_RDONLY | O_CLOEXEC);
+    struct stat datos;
+    if (fd == -1 || fstat(fd, &datos) == -1 || (size_t)datos.st_size < sizeof(cabecera_cache))
+    {
+        if (fd != -1)
+            close(fd);
+        free(archivo);
+        return -1;
+    }
+    void* mapa = mmap(NULL, (size_t)datos.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapa == MAP_FAILED)
+    {
+        free(archivo);
+        return -1;
+    }
+    c->mapa = mapa;
+    c->largo = (size_t)datos.st_size;
+
+    // Una caché de otra versión del script o del shell se reemplaza al guardar la nueva; una dañada se borra ya
+    const cabecera_cache* h = mapa;
+    bool valida = cabecera_vigente(h, real, info);
+    bool danada = false;
+    size_t posicion = sizeof(cabecera_cache) + alinear8(h->largo_ruta);
+    if (valida)
+    {
+        danada = posicion > c->largo ||
+                 hash_bloque(c->mapa + sizeof(cabecera_cache), c->largo - sizeof(cabecera_cache)) != h->suma ||
+                 memcmp(c->mapa + sizeof(cabecera_cache), real, h->largo_ruta) != 0;
+        c->posicion = posicion;
+        for (uint32_t i = 0; !danada && i < h->num_unidades; i++)
+        {
+            unidad_cacheada u;
+            danada = !leer_registro(c, &posicion, &u);
+        }
+        danada = danada || posicion != c->largo;
+        valida = !danada;
+    }
+    if (danada)
+        unlink(archivo);
+    free(archivo);
+    if (!valida)
+    {
+        cache_cerrar(c);
+        return -1;
+    }
+    madvise(c->mapa, c->largo, MADV_SEQUENTIAL);
+    c->restantes = h->num_unidades;
+    c->lineas = h->lineas;
+    return 0;
+}
+
+// Leer la siguiente unidad de una caché abierta
+bool cache_siguiente(cache_script* c, unidad_cacheada* u)
+{
+    if (c->restantes == 0 || !leer_registro(c, &c->posicion, u))
+        return false;
+    c->restantes--;
+    return true;
+}
+
+// Cerrar una caché abierta
+void cache_cerrar(cache_script* c)
+{
+    if (c->mapa != NULL)
+        munmap(c->mapa, c->largo);
+    memset(c, 0, sizeof(*c));
+}
+
+// Agregar bytes al contenido de la caché en construcción
+static void escribir_bytes(escritor_cache* w, const void* datos, size_t largo)
+{
+    if (!w->ok)
+        return;
+    if (w->capacidad - w->largo < largo)
+    {
+        size_t nueva = w->capacidad == 0 ? 65536 : w->capacidad * 2;
+        while (nueva - w->largo < largo)
+            nueva *= 2;
+        unsigned char* datos_nuevos = realloc(w->datos, nueva);
+        if (datos_nuevos == NULL)
+        {
+            w->ok = false;
+            return;
+        }
+        w->datos = datos_nuevos;
+        w->capacidad = nueva;
+    }
+    memcpy(w->datos + w->largo, datos, largo);
+    w->largo += largo;
+}
+
+// Completar con ceros hasta un múltiplo de 8 bytes
+static void completar8(escritor_cache* w)
+{
+    static const unsigned char ceros[8] = {0};
+    escribir_bytes(w, ceros, alinear8(w->largo) - w->largo);
+}
+
+// Empezar a armar la caché de un script
+void cache_crear(escritor_cache* w, const char* ruta, const struct stat* info)
+{
+    memset(w, 0, sizeof(*w));
+    w->ok = true;
+
+    struct timespec ahora;
+    clock_gettime(CLOCK_REALTIME, &ahora);
+    int64_t ahora_ns = (int64_t)ahora.tv_sec * 1000000000LL + ahora.tv_nsec;
+    char real[PATH_MAX];
+    if (!S_ISREG(info->st_mode) || modificacion_ns(info) >= ahora_ns - CACHE_SCRIPTS_MARGEN_NS ||
+        realpath(ruta, real) == NULL || (w->archivo = ruta_archivo(real)) == NULL)
+        return;
+
+    cabecera_cache h;
+    memset(&h, 0, sizeof(h));
+    h.magia = CACHE_SCRIPTS_MAGIA;
+    h.version = CACHE_SCRIPTS_VERSION;
+    h.version_bytecode = BYTECODE_VERSION;
+    snprintf(h.version_shell, sizeof(h.version_shell), "%s", SHELL_VERSION);
+    h.tamano = (uint64_t)info->st_size;
+    h.dispositivo = (uint64_t)info->st_dev;
+    h.inodo = (uint64_t)info->st_ino;
+    h.modificado_ns = modificacion_ns(info);
+    h.largo_ruta = (uint32_t)strlen(real) + 1;
+    escribir_bytes(w, &h, sizeof(h));
+    escribir_bytes(w, real, h.largo_ruta);
+    completar8(w);
+}
+
+// Agregar una unidad a la caché en construcción
+void cache_agregar(escritor_cache* w, const unidad_cacheada* u)
+{
+    if (w->archivo == NULL)
+        return;
+    const void* datos = NULL;
+    size_t largo = 0;
+    if (u->tipo == UNIDAD_COMANDOS)
+    {
+        datos = u->programa.cabecera;
+        largo = u->programa.largo;
+    }
+    else if (u->tipo == UNIDAD_ERROR)
+    {
+        datos = u->error;
+        largo = strlen(u->error) + 1;
+    }
+    if (largo > UINT32_MAX)
+    {
+        w->ok = false;
+        return;
+    }
+
+    registro_unidad r = {(uint32_t)u->tipo, u->linea, u->grado, (uint32_t)largo};
+    escribir_bytes(w, &r, sizeof(r));
+    escribir_bytes(w, datos, largo);
+    completar8(w);
+    w->num_unidades++;
+}
+
+// Escribir un bloque completo en un descriptor
+static bool escribir_todo(int fd, const unsigned char* datos, size_t largo)
+{
+    while (largo > 0)
+    {
+        ssize_t n = write(fd, datos, largo);
+        if (n == -1 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return false;
+        datos += n;
+        largo -= (size_t)n;
+    }
+    return true;
+}
+
+// Guardar la caché: temporal en el mismo directorio y rename(), sin fsync() porque se puede regenerar
+void cache_terminar(escritor_cache* w, int lineas, bool guardar)
+{
+    if (guardar && w->archivo != NULL && w->ok)
+    {
+        cabecera_cache* h = (cabecera_cache*)w->datos;
+        h->num_unidades = w->num_unidades;
+        h->lineas = lineas;
+        h->suma = hash_bloque(w->datos + sizeof(cabecera_cache), w->largo - sizeof(cabecera_cache));
+
+        char temporal[PATH_MAX + 8];
+        snprintf(temporal, sizeof(temporal), "%s.XXXXXX", w->archivo);
+        int fd = mkostemp(temporal, O_CLOEXEC);
+        if (fd != -1)
+        {
+            bool ok = escribir_todo(fd, w->datos, w->largo);
+            ok = close(fd) == 0 && ok;
+            if (!ok || rename(temporal, w->archivo) == -1)
+                unlink(temporal);
+        }
+    }
+    free(w->archivo);
+    free(w->datos);
+    memset(w, 0, sizeof(*w));
+}
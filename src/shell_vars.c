@@ -0,0 +1,364 @@
+/**
+ * @file shell_vars.c
+ * @brief Implementación de las variables del shell y de los parámetros especiales.
+ */
+
+#include "shell_vars.h"
+#include "globals.h"
+#include "parser.h"
+#include <ctype.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/**
+ * @brief Capacidad inicial de la tabla de variables (potencia de dos)
+ */
+#define VARIABLES_CAPACIDAD_INICIAL 32
+
+/**
+ * @brief Variable del shell: nombre y valor en un mismo bloque
+ */
+typedef struct
+{
+    char* nombre;  /**< Nombre de la variable, NULL si la celda está libre; el valor sigue al nombre */
+    char* valor;   /**< Valor de la variable */
+    uint32_t hash; /**< Hash del nombre */
+} entrada_variable;
+
+/**
+ * @brief Tabla hash de variables del shell, con direccionamiento abierto y sondeo lineal
+ */
+static entrada_variable* tabla = NULL;
+
+/**
+ * @brief Capacidad de la tabla
+ */
+static size_t capacidad = 0;
+
+/**
+ * @brief Entradas ocupadas
+ */
+static size_t ocupadas = 0;
+
+/**
+ *  @brief Parámetros posicionales actuales
+ */
+static parametros_shell parametros = {NULL, 0};
+
+/**
+ *  @brief Valor de $0
+ */
+static const char* nombre_shell = "ShellProject";
+
+/**
+ *  @brief Buffer de los parámetros especiales numéricos ($?, $#, $$)
+ */
+static char numero[24];
+
+/**
+ *  @brief Buffer de $@ y $*: los parámetros posicionales unidos por espacios
+ */
+static char* unidos = NULL;
+
+// Hash FNV-1a de 32 bits
+static uint32_t hash_nombre(const char* nombre)
+{
+    uint32_t h = 2166136261u;
+    for (const unsigned char* p = (const unsigned char*)nombre; *p != '\0'; p++)
+    {
+        h ^= *p;
+        h *= 16777619u;
+    }
+    return h;
+}
+
+// Buscar la celda de un nombre: la ocupada por él o la libre donde debería ir
+static size_t buscar_celda(const char* nombre, uint32_t h)
+{
+    size_t mascara = capacidad - 1;
+    size_t i = h & mascara;
+    while (tabla[i].nombre != NULL && (tabla[i].hash != h || strcmp(tabla[i].nombre, nombre) != 0))
+    {
+        i = (i + 1) & mascara;
+    }
+    return i;
+}
+
+// Duplicar la capacidad de la tabla y reubicar las entradas
+static bool crecer_tabla(void)
+{
+    size_t nueva_capacidad = capacidad ? capacidad * 2 : VARIABLES_CAPACIDAD_INICIAL;
+    entrada_variable* nueva = calloc(nueva_capacidad, sizeof(entrada_variable));
+    if (nueva == NULL)
+    {
+        return false;
+    }
+
+    entrada_variable* vieja = tabla;
+    size_t vieja_capacidad = capacidad;
+    tabla = nueva;
+    capacidad = nueva_capacidad;
+
+    for (size_t i = 0; i < vieja_capacidad; i++)
+    {
+        if (vieja[i].nombre != NULL)
+        {
+            tabla[buscar_celda(vieja[i].nombre, vieja[i].hash)] = vieja[i];
+        }
+    }
+    free(vieja);
+    return true;
+}
+
+// Eliminar la entrada de una celda reubicando las siguientes del mismo grupo (borrado sin lápidas)
+static void eliminar_celda(size_t i)
+{
+    size_t mascara = capacidad - 1;
+    free(tabla[i].nombre);
+    tabla[i].nombre = NULL;
+    ocupadas--;
+
+    size_t j = i;
+    for (;;)
+    {
+        j = (j + 1) & mascara;
+        if (tabla[j].nombre == NULL)
+        {
+            return;
+        }
+        size_t ideal = tabla[j].hash & mascara;
+        bool entre = (i <= j) ? (i < ideal && ideal <= j) : (i < ideal || ideal <= j);
+        if (!entre)
+        {
+            tabla[i] = tabla[j];
+            tabla[j].nombre = NULL;
+            i = j;
+        }
+    }
+}
+
+// Unir los parámetros posicionales con espacios, para $@ y $*
+static const char* unir_parametros(void)
+{
+    size_t largo = 1;
+    for (int i = 0; i < parametros.cantidad; i++)
+    {
+        largo += strlen(parametros.valores[i]) + 1;
+    }
+    char* nuevo = realloc(unidos, largo);
+    if (nuevo == NULL)
+    {
+        return "";
+    }
+    unidos = nuevo;
+
+    char* p = unidos;
+    *p = '\0';
+    for (int i = 0; i < parametros.cantidad; i++)
+    {
+        p = stpcpy(p, i > 0 ? " " : "");
+        p = stpcpy(p, parametros.valores[i]);
+    }
+    return unidos;
+}
+
+// Resolver un parámetro especial o posicional; devuelve NULL si el nombre no es uno de ellos o no está definido
+static const char* buscar_especial(const char* nombre)
+{
+    if (isdigit((unsigned char)nombre[0]))
+    {
+        long n = strtol(nombre, NULL, 10);
+        if (n == 0)
+            return nombre_shell;
+        return n <= parametros.cantidad ? parametros.valores[n - 1] : NULL;
+    }
+    switch (nombre[0])
+    {
+    case '?':
+        snprintf(numero, sizeof(numero), "%d", ultimo_estado);
+        return numero;
+    case '#':
+        snprintf(numero, sizeof(numero), "%d", parametros.cantidad);
+        return numero;
+    case '$':
+        snprintf(numero, sizeof(numero), "%d", (int)getpid());
+        return numero;
+    case '@':
+    case '*':
+        return unir_parametros();
+    default:
+        return NULL;
+    }
+}
+
+// Buscar el valor de una variable o de un parámetro especial
+const char* variable_buscar(const char* nombre)
+{
+    if (!es_nombre_valido(nombre, strlen(nombre)))
+    {
+        return buscar_especial(nombre);
+    }
+    if (capacidad > 0)
+    {
+        size_t i = buscar_celda(nombre, hash_nombre(nombre));
+        if (tabla[i].nombre != NULL)
+        {
+            return tabla[i].valor;
+        }
+    }
+    return getenv(nombre);
+}
+
+// Asignar una variable
+int variable_asignar(const char* nombre, const char* valor)
+{
+    if (getenv(nombre) != NULL) // Las variables de entorno siguen en el entorno, para que las vean los programas
+    {
+        return setenv(nombre, valor, 1);
+    }
+    if ((ocupadas + 1) * 4 > capacidad * 3 && !crecer_tabla()) // Factor de carga máximo: 0.75
+    {
+        return -1;
+    }
+
+    size_t largo_nombre = strlen(nombre);
+    size_t largo_valor = strlen(valor);
+    char* bloque = malloc(largo_nombre + largo_valor + 2);
+    if (bloque == NULL)
+    {
+        return -1;
+    }
+    memcpy(bloque, nombre, largo_nombre + 1);
+    memcpy(bloque + largo_nombre + 1, valor, largo_valor + 1);
+
+    uint32_t h = hash_nombre(nombre);
+    size_t i = buscar_celda(nombre, h);
+    if (tabla[i].nombre != NULL)
+    {
+        free(tabla[i].nombre); // Reemplazar el valor anterior
+    }
+    else
+    {
+        ocupadas++;
+    }
+    tabla[i].nombre = bloque;
+    tabla[i].valor = bloque + largo_nombre + 1;
+    tabla[i].hash = h;
+    return 0;
+}
+
+// Eliminar una variable del shell y del entorno
+void variable_eliminar(const char* nombre)
+{
+    if (capacidad > 0)
+    {
+        size_t i = buscar_celda(nombre, hash_nombre(nombre));
+        if (tabla[i].nombre != NULL)
+        {
+            eliminar_celda(i);
+        }
+    }
+    unsetenv(nombre);
+}
+
+// Fijar el valor de $0
+void parametros_fijar_nombre(const char* nombre)
+{
+    nombre_shell = nombre;
+}
+
+// Devolver los parámetros posicionales actuales
+char* const* parametros_posicionales(int* cantidad)
+{
+    *cantidad = parametros.cantidad;
+    return parametros.valores;
+}
+
+// Reemplazar los parámetros posicionales
+void parametros_cambiar(int cantidad, char** valores, parametros_shell* anteriores)
+{
+    *anteriores = parametros;
+    parametros.valores = valores;
+    parametros.cantidad = cantidad;
+}
+
+// Volver a los parámetros guardados
+void parametros_restaurar(const parametros_shell* anteriores)
+{
+    parametros = *anteriores;
+}
+
+// Pasar una variable del shell al entorno
+static int exportar(const char* argumento)
+{
+    const char* igual = strchr(argumento, '=');
+    size_t largo = igual != NULL ? (size_t)(igual - argumento) : strlen(argumento);
+    if (!es_nombre_valido(argumento, largo))
+    {
+        fprintf(stderr, "export: '%s': no es un nombre válido\n", argumento);
+        return 1;
+    }
+
+    char* nombre = strndup(argumento, largo);
+    if (nombre == NULL)
+    {
+        fprintf(stderr, "export: memoria insuficiente\n");
+        return 1;
+    }
+    const char* valor = igual != NULL ? igual + 1 : variable_buscar(nombre);
+    int estado = 0;
+    if (valor != NULL && setenv(nombre, valor, 1) == -1) // setenv() copia el valor antes de eliminar la variable
+    {
+        perror("export");
+        estado = 1;
+    }
+    else if (capacidad > 0)
+    {
+        size_t i = buscar_celda(nombre, hash_nombre(nombre));
+        if (tabla[i].nombre != NULL)
+            eliminar_celda(i); // Desde ahora la variable vive en el entorno
+    }
+    free(nombre);
+    return estado;
+}
+
+// Comando "export"
+int manejar_comando_export(int argc, char** argv)
+{
+    if (argc == 1)
+    {
+        for (size_t i = 0; i < capacidad; i++)
+        {
+            if (tabla[i].nombre != NULL)
+                printf("%s=%s\n", tabla[i].nombre, tabla[i].valor);
+        }
+        return 0;
+    }
+
+    int estado = 0;
+    for (int i = 1; i < argc; i++)
+    {
+        estado |= exportar(argv[i]);
+    }
+    return estado;
+}
+
+// Comando "unset"
+int manejar_comando_unset(int argc, char** argv)
+{
+    int estado = 0;
+    for (int i = 1; i < argc; i++)
+    {
+        if (!es_nombre_valido(argv[i], strlen(argv[i])))
+        {
+            fprintf(stderr, "unset: '%s': no es un nombre válido\n", argv[i]);
+            estado = 1;
+            continue;
+        }
+        variable_eliminar(argv[i]);
+    }
+    return estado;
+}
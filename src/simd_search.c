@@ -0,0 +1,192 @@
+/**
+ * @file simd_search.c
+ * @brief Búsqueda de subcadenas y conteo de bytes con instrucciones vectoriales.
+ */
+#include "simd_search.h"
+#include <string.h>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+// Buscar una subcadena recorriendo las apariciones de su primer byte con memchr()
+static const char* buscar_escalar(const char* texto, size_t largo, const char* aguja, size_t largo_aguja)
+{
+    if (largo_aguja == 0)
+        return texto;
+    if (largo < largo_aguja)
+        return NULL;
+    const char* p = texto;
+    const char* ultimo = texto + (largo - largo_aguja); // Último comienzo posible
+    while (p <= ultimo)
+    {
+        p = memchr(p, aguja[0], (size_t)(ultimo - p) + 1);
+        if (p == NULL)
+            return NULL;
+        if (memcmp(p + 1, aguja + 1, largo_aguja - 1) == 0)
+            return p;
+        p++;
+    }
+    return NULL;
+}
+
+// Contar las apariciones de un byte de a uno
+static size_t contar_escalar(const char* texto, size_t largo, char byte)
+{
+    size_t total = 0;
+    for (size_t i = 0; i < largo; i++)
+        total += texto[i] == byte;
+    return total;
+}
+
+#if defined(__x86_64__)
+
+// Buscar una subcadena de a 16 posiciones: candidatas son las que coinciden en el primer y el último byte
+static const char* buscar_sse2(const char* texto, size_t largo, const char* aguja, size_t largo_aguja)
+{
+    if (largo_aguja == 0 || largo < largo_aguja)
+        return buscar_escalar(texto, largo, aguja, largo_aguja);
+    const __m128i primero = _mm_set1_epi8(aguja[0]);
+    const __m128i ultimo = _mm_set1_epi8(aguja[largo_aguja - 1]);
+    size_t i = 0;
+    for (; i + largo_aguja - 1 + 16 <= largo; i += 16)
+    {
+        __m128i inicios = _mm_loadu_si128((const __m128i*)(texto + i));
+        __m128i finales = _mm_loadu_si128((const __m128i*)(texto + i + largo_aguja - 1));
+        __m128i ambos = _mm_and_si128(_mm_cmpeq_epi8(inicios, primero), _mm_cmpeq_epi8(finales, ultimo));
+        unsigned candidatos = (unsigned)_mm_movemask_epi8(ambos);
+        while (candidatos != 0)
+        {
+            size_t posicion = i + (size_t)__builtin_ctz(candidatos);
+            if (largo_aguja <= 2 || memcmp(texto + posicion + 1, aguja + 1, largo_aguja - 2) == 0)
+                return texto + posicion;
+            candidatos &= candidatos - 1;
+        }
+    }
+    return buscar_escalar(texto + i, largo - i, aguja, largo_aguja); // Posiciones que no completan un bloque
+}
+
+// Contar las apariciones de un byte de a 16: cada byte de un acumulador cuenta hasta 255 antes de sumarse
+static size_t contar_sse2(const char* texto, size_t largo, char byte)
+{
+    const __m128i buscado = _mm_set1_epi8(byte);
+    const __m128i cero = _mm_setzero_si128();
+    __m128i sumas = cero;
+    size_t i = 0;
+    while (i + 16 <= largo)
+    {
+        __m128i parciales = cero;
+        for (int j = 0; j < 255 && i + 16 <= largo; j++, i += 16)
+        {
+            __m128i bloque = _mm_loadu_si128((const __m128i*)(texto + i));
+            parciales = _mm_sub_epi8(parciales, _mm_cmpeq_epi8(bloque, buscado)); // Coincidencia = -1
+        }
+        sumas = _mm_add_epi64(sumas, _mm_sad_epu8(parciales, cero));
+    }
+    size_t total = (size_t)_mm_cvtsi128_si64(sumas) + (size_t)_mm_cvtsi128_si64(_mm_unpackhi_epi64(sumas, sumas));
+    return total + contar_escalar(texto + i, largo - i, byte);
+}
+
+// Buscar una subcadena de a 32 posiciones
+__attribute__((target("avx2"))) static const char* buscar_avx2(const char* texto, size_t largo, const char* aguja,
+                                                               size_t largo_aguja)
+{
+    if (largo_aguja == 0 || largo < largo_aguja)
+        return buscar_escalar(texto, largo, aguja, largo_aguja);
+    const __m256i primero = _mm256_set1_epi8(aguja[0]);
+    const __m256i ultimo = _mm256_set1_epi8(aguja[largo_aguja - 1]);
+    size_t i = 0;
+    for (; i + largo_aguja - 1 + 32 <= largo; i += 32)
+    {
+        __m256i inicios = _mm256_loadu_si256((const __m256i*)(texto + i));
+        __m256i finales = _mm256_loadu_si256((const __m256i*)(texto + i + largo_aguja - 1));
+        __m256i ambos = _mm256_and_si256(_mm256_cmpeq_epi8(inicios, primero), _mm256_cmpeq_epi8(finales, ultimo));
+        unsigned candidatos = (unsigned)_mm256_movemask_epi8(ambos);
+        while (candidatos != 0)
+        {
+            size_t posicion = i + (size_t)__builtin_ctz(candidatos);
+            if (largo_aguja <= 2 || memcmp(texto + posicion + 1, aguja + 1, largo_aguja - 2) == 0)
+                return texto + posicion;
+            candidatos &= candidatos - 1;
+        }
+    }
+    return buscar_sse2(texto + i, largo - i, aguja, largo_aguja);
+}
+
+// Contar las apariciones de un byte de a 32
+__attribute__((target("avx2"))) static size_t contar_avx2(const char* texto, size_t largo, char byte)
+{
+    const __m256i buscado = _mm256_set1_epi8(byte);
+    const __m256i cero = _mm256_setzero_si256();
+    __m256i sumas = cero;
+    size_t i = 0;
+    while (i + 32 <= largo)
+    {
+        __m256i parciales = cero;
+        for (int j = 0; j < 255 && i + 32 <= largo; j++, i += 32)
+        {
+            __m256i bloque = _mm256_loadu_si256((const __m256i*)(texto + i));
+            parciales = _mm256_sub_epi8(parciales, _mm256_cmpeq_epi8(bloque, buscado));
+        }
+        sumas = _mm256_add_epi64(sumas, _mm256_sad_epu8(parciales, cero));
+    }
+    size_t total = (size_t)_mm256_extract_epi64(sumas, 0) + (size_t)_mm256_extract_epi64(sumas, 1) +
+                   (size_t)_mm256_extract_epi64(sumas, 2) + (size_t)_mm256_extract_epi64(sumas, 3);
+    return total + contar_sse2(texto + i, largo - i, byte);
+}
+
+#endif
+
+// Mejor juego de instrucciones disponible
+nivel_busqueda busqueda_nivel_disponible(void)
+{
+#if defined(__x86_64__)
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") ? BUSQUEDA_AVX2 : BUSQUEDA_SSE2;
+#else
+    return BUSQUEDA_ESCALAR;
+#endif
+}
+
+// Nombre de un juego de instrucciones
+const char* busqueda_nombre_nivel(nivel_busqueda nivel)
+{
+    switch (nivel)
+    {
+    case BUSQUEDA_AVX2:
+        return "avx2";
+    case BUSQUEDA_SSE2:
+        return "sse2";
+    default:
+        return "escalar";
+    }
+}
+
+// Buscar la primera aparición de una subcadena
+const char* buscar_subcadena(nivel_busqueda nivel, const char* texto, size_t largo, const char* aguja,
+                             size_t largo_aguja)
+{
+#if defined(__x86_64__)
+    if (nivel == BUSQUEDA_AVX2)
+        return buscar_avx2(texto, largo, aguja, largo_aguja);
+    if (nivel == BUSQUEDA_SSE2)
+        return buscar_sse2(texto, largo, aguja, largo_aguja);
+#else
+    (void)nivel;
+#endif
+    return buscar_escalar(texto, largo, aguja, largo_aguja);
+}
+
+// Contar las apariciones de un byte
+size_t contar_byte(nivel_busqueda nivel, const char* texto, size_t largo, char byte)
+{
+#if defined(__x86_64__)
+    if (nivel == BUSQUEDA_AVX2)
+        return contar_avx2(texto, largo, byte);
+    if (nivel == BUSQUEDA_SSE2)
+        return contar_sse2(texto, largo, byte);
+#else
+    (void)nivel;
+#endif
+    return contar_escalar(texto, largo, byte);
+}
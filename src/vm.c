@@ -0,0 +1,486 @@
+/**
+ * @file vm.c
+ * @brief Implementación de la máquina virtual de bytecode y de la tabla de funciones.
+ */
+
+#include "vm.h"
+#include "commands.h"
+#include "globals.h"
+#include "shell_vars.h"
+#include <fnmatch.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @brief Copia de un programa compartida por las funciones definidas en él.
+ */
+typedef struct
+{
+    int referencias;                             /**< Funciones y llamadas en curso que usan la copia */
+    programa programa;                           /**< Programa abierto sobre datos */
+    _Alignas(max_align_t) unsigned char datos[]; /**< Bloque del programa */
+} programa_compartido;
+
+/**
+ * @brief Función definida en el shell.
+ */
+struct funcion_shell
+{
+    char* nombre;                /**< Nombre de la función */
+    programa_compartido* codigo; /**< Programa que contiene el cuerpo */
+    uint32_t entrada;            /**< Primera instrucción del cuerpo */
+};
+
+/**
+ * @brief Ciclo en curso de una máquina.
+ */
+typedef struct
+{
+    bool activo;    /**< El ciclo está abierto */
+    int estado;     /**< Estado de la última vuelta (0 si todavía no terminó ninguna) */
+    char** campos;  /**< Campos de un for, en un solo bloque con sus textos; NULL en while y until */
+    int num_campos; /**< Cantidad de campos */
+    int siguiente;  /**< Próximo campo a asignar */
+} marco_ciclo;
+
+/**
+ * @brief Estado de una ejecución de la máquina: el programa principal o una llamada a una función.
+ */
+typedef struct
+{
+    const programa* p;                       /**< Programa en ejecución */
+    programa_compartido* propio;             /**< Copia compartida del programa, o NULL si todavía no se necesitó */
+    marco_ciclo ciclos[BYTECODE_MAX_CICLOS]; /**< Ciclos en curso, por número */
+    char* sujeto;                            /**< Sujeto expandido del case en evaluación */
+} ejecucion_vm;
+
+/**
+ *  @brief Arena de las expansiones de la máquina; cada instrucción libera lo que reservó
+ */
+static arena arena_vm;
+
+/**
+ *  @brief Funciones definidas; las entradas no se liberan, sólo cambian de código al redefinirse
+ */
+static funcion_shell** funciones = NULL;
+
+/**
+ *  @brief Cantidad de funciones definidas
+ */
+static int num_funciones = 0;
+
+/**
+ *  @brief Capacidad de la tabla de funciones
+ */
+static int cap_funciones = 0;
+
+/**
+ *  @brief Llamadas a funciones en curso
+ */
+static int profundidad_llamadas = 0;
+
+static void ejecutar_desde(const programa* p, uint32_t pc, programa_compartido* propio);
+
+// Soltar una referencia a una copia de un programa
+static void soltar_programa(programa_compartido* codigo)
+{
+    if (codigo != NULL && --codigo->referencias == 0)
+    {
+        free(codigo);
+    }
+}
+
+// Copiar el programa en ejecución para que sobreviva a la arena donde se compiló
+static programa_compartido* copiar_programa(const programa* p)
+{
+    programa_compartido* copia = malloc(sizeof(programa_compartido) + p->largo);
+    if (copia == NULL)
+    {
+        return NULL;
+    }
+    memcpy(copia->datos, p->cabecera, p->largo);
+    copia->referencias = 0;
+    if (programa_abrir(copia->datos, p->largo, &copia->programa) == -1)
+    {
+        free(copia);
+        return NULL;
+    }
+    return copia;
+}
+
+// Buscar una función definida en el shell
+funcion_shell* vm_buscar_funcion(const char* nombre)
+{
+    for (int i = 0; i < num_funciones; i++)
+    {
+        if (strcmp(funciones[i]->nombre, nombre) == 0)
+            return funciones[i];
+    }
+    return NULL;
+}
+
+// Definir (o redefinir) una función cuyo cuerpo empieza en la instrucción indicada
+static void definir_funcion(ejecucion_vm* e, const char* nombre, uint32_t entrada)
+{
+    if (e->propio == NULL && (e->propio = copiar_programa(e->p)) == NULL)
+    {
+        fprintf(stderr, "%s: memoria insuficiente para definir la función\n", nombre);
+        ultimo_estado = 1;
+        return;
+    }
+
+    funcion_shell* f = vm_buscar_funcion(nombre);
+    if (f == NULL)
+    {
+        if (num_funciones == cap_funciones)
+        {
+            int nueva = cap_funciones == 0 ? 8 : cap_funciones * 2;
+            funcion_shell** tabla = realloc(funciones, (size_t)nueva * sizeof(funcion_shell*));
+            if (tabla == NULL)
+            {
+                fprintf(stderr, "%s: memoria insuficiente para definir la función\n", nombre);
+                ultimo_estado = 1;
+                return;
+            }
+            funciones = tabla;
+            cap_funciones = nueva;
+        }
+        f = calloc(1, sizeof(funcion_shell));
+        if (f == NULL || (f->nombre = strdup(nombre)) == NULL)
+        {
+            free(f);
+            fprintf(stderr, "%s: memoria insuficiente para definir la función\n", nombre);
+            ultimo_estado = 1;
+            return;
+        }
+        funciones[num_funciones++] = f;
+    }
+
+    e->propio->referencias++; // Antes de soltar el código anterior, que puede ser la misma copia
+    soltar_programa(f->codigo);
+    f->codigo = e->propio;
+    f->entrada = entrada;
+    ultimo_estado = 0;
+}
+
+// Llamar a una función con los argumentos como parámetros posicionales
+int vm_llamar_funcion(funcion_shell* f, int argc, char** argv)
+{
+    if (profundidad_llamadas >= VM_MAX_LLAMADAS)
+    {
+        fprintf(stderr, "%s: demasiadas llamadas anidadas (máximo %d)\n", argv[0], VM_MAX_LLAMADAS);
+        return 1;
+    }
+
+    programa_compartido* codigo = f->codigo; // La llamada conserva el código aunque la función se redefina
+    codigo->referencias++;
+    parametros_shell anteriores;
+    parametros_cambiar(argc - 1, argv + 1, &anteriores);
+    profundidad_llamadas++;
+
+    ejecutar_desde(&codigo->programa, f->entrada, codigo);
+
+    profundidad_llamadas--;
+    parametros_restaurar(&anteriores);
+    soltar_programa(codigo);
+    return ultimo_estado;
+}
+
+// Obtener una palabra del programa
+static palabra palabra_compilada_en(const programa* p, uint32_t indice)
+{
+    const palabra_compilada* w = &p->palabras[indice];
+    palabra resultado = {.texto = p->cadenas + w->texto, .expandir = w->expandir != 0};
+    return resultado;
+}
+
+// Obtener el destino de una redirección del programa
+static palabra palabra_de_redireccion(const programa* p, const redireccion_compilada* r)
+{
+    palabra resultado = {.texto = p->cadenas + r->destino.texto, .expandir = r->destino.expandir != 0};
+    return resultado;
+}
+
+// Expandir una palabra del programa en la arena de la máquina
+static char* expandir_palabra_compilada(const programa* p, uint32_t indice)
+{
+    palabra w = palabra_compilada_en(p, indice);
+    return expandir_palabra(&arena_vm, &w);
+}
+
+// Armar el pipe a partir de sus tablas y ejecutarlo
+static void ejecutar_pipeline_compilado(const programa* p, uint32_t indice)
+{
+    const pipeline_compilado* t = &p->pipelines[indice];
+    marca_arena marca = arena_marcar(&arena_vm);
+    pipeline tubo = {.num_etapas = (int)t->num_etapas,
+                     .en_segundo_plano = t->en_segundo_plano != 0,
+                     .linea = t->linea,
+                     .conector = CONECTOR_SECUENCIA,
+                     .negado = false};
+    tubo.etapas = arena_reservar_cero(&arena_vm, t->num_etapas * sizeof(comando_simple));
+
+    bool completo = tubo.etapas != NULL;
+    for (uint32_t i = 0; completo && i < t->num_etapas; i++)
+    {
+        const etapa_compilada* e = &p->etapas[t->primera_etapa + i];
+        comando_simple* comando = &tubo.etapas[i];
+        comando->num_palabras = (int)e->num_palabras;
+        comando->palabras = arena_reservar(&arena_vm, e->num_palabras * sizeof(palabra));
+        completo = comando->palabras != NULL;
+        for (uint32_t j = 0; completo && j < e->num_palabras; j++)
+        {
+            comando->palabras[j] = palabra_compilada_en(p, e->primera_palabra + j);
+        }
+
+        // Las redirecciones vuelven a ser una lista, en el mismo orden
+        redireccion** ultima = &comando->redirecciones;
+        for (uint32_t j = 0; completo && j < e->num_redirecciones; j++)
+        {
+            const redireccion_compilada* rc = &p->redirecciones[e->primera_redireccion + j];
+            redireccion* r = arena_reservar(&arena_vm, sizeof(redireccion));
+            completo = r != NULL;
+            if (r != NULL)
+            {
+                r->tipo = (tipo_redireccion)rc->tipo;
+                r->fd = rc->fd;
+                r->destino = palabra_de_redireccion(p, rc);
+                r->siguiente = NULL;
+                *ultima = r;
+                ultima = &r->siguiente;
+            }
+        }
+    }
+
+    if (completo)
+    {
+        ejecutar_pipe(&tubo);
+    }
+    else
+    {
+        fprintf(stderr, "Error: memoria insuficiente\n");
+        ultimo_estado = 1;
+    }
+    arena_volver(&arena_vm, marca);
+}
+
+// Asignar las variables de un comando formado sólo por nombre=valor
+static void asignar(const programa* p, const instruccion* i)
+{
+    int estado = 0;
+    for (uint32_t j = 0; j < i->n; j++)
+    {
+        marca_arena marca = arena_marcar(&arena_vm);
+        char* texto = expandir_palabra_compilada(p, i->a + j);
+        const char* igual = texto != NULL ? strchr(texto, '=') : NULL;
+        char* nombre = igual != NULL ? arena_copiar(&arena_vm, texto, (size_t)(igual - texto)) : NULL;
+        if (nombre == NULL || variable_asignar(nombre, igual + 1) == -1)
+        {
+            fprintf(stderr, "Error: memoria insuficiente para asignar la variable\n");
+            estado = 1;
+        }
+        arena_volver(&arena_vm, marca);
+    }
+    ultimo_estado = estado;
+}
+
+// Cerrar los ciclos desde el número indicado, liberando los campos de los for
+static void cerrar_ciclos(ejecucion_vm* e, uint32_t desde)
+{
+    for (uint32_t n = desde; n < BYTECODE_MAX_CICLOS && e->ciclos[n].activo; n++)
+    {
+        free(e->ciclos[n].campos);
+        memset(&e->ciclos[n], 0, sizeof(marco_ciclo));
+    }
+}
+
+// Abrir un ciclo, cerrando antes el que hubiera quedado abierto con el mismo número
+static marco_ciclo* abrir_ciclo(ejecucion_vm* e, uint32_t n)
+{
+    cerrar_ciclos(e, n);
+    e->ciclos[n].activo = true;
+    return &e->ciclos[n];
+}
+
+// Abrir el ciclo de un for: expandir sus palabras y copiar los campos a un bloque propio del ciclo
+static void iniciar_para(ejecucion_vm* e, const instruccion* i)
+{
+    marco_ciclo* ciclo = abrir_ciclo(e, i->n);
+    marca_arena marca = arena_marcar(&arena_vm);
+    palabra* palabras = arena_reservar(&arena_vm, (i->b > 0 ? i->b : 1) * sizeof(palabra));
+    int num_campos = 0;
+    char** campos = NULL;
+    if (palabras != NULL)
+    {
+        for (uint32_t j = 0; j < i->b; j++)
+        {
+            palabras[j] = palabra_compilada_en(e->p, i->a + j);
+        }
+        campos = expandir_campos(&arena_vm, palabras, (int)i->b, &num_campos);
+    }
+
+    size_t largo = 0;
+    for (int j = 0; campos != NULL && j < num_campos; j++)
+    {
+        largo += strlen(campos[j]) + 1;
+    }
+    ciclo->campos = campos != NULL ? malloc((size_t)num_campos * sizeof(char*) + largo) : NULL;
+    if (ciclo->campos == NULL)
+    {
+        if (campos == NULL || num_campos > 0)
+            fprintf(stderr, "Error: memoria insuficiente para recorrer el for\n");
+        arena_volver(&arena_vm, marca);
+        return; // Sin campos, el ciclo no da ninguna vuelta
+    }
+    char* texto = (char*)(ciclo->campos + num_campos);
+    for (int j = 0; j < num_campos; j++)
+    {
+        ciclo->campos[j] = texto;
+        texto = stpcpy(texto, campos[j]) + 1;
+    }
+    ciclo->num_campos = num_campos;
+    arena_volver(&arena_vm, marca);
+}
+
+// Asignar el siguiente campo de un for; devuelve false si no quedan
+static bool siguiente_campo(ejecucion_vm* e, const instruccion* i)
+{
+    marco_ciclo* ciclo = &e->ciclos[i->n];
+    if (!ciclo->activo || ciclo->siguiente >= ciclo->num_campos)
+    {
+        return false;
+    }
+    if (variable_asignar(e->p->cadenas + i->a, ciclo->campos[ciclo->siguiente++]) == -1)
+    {
+        fprintf(stderr, "Error: memoria insuficiente para asignar la variable\n");
+        return false;
+    }
+    return true;
+}
+
+// Expandir y guardar el sujeto de un case
+static void fijar_sujeto(ejecucion_vm* e, uint32_t indice)
+{
+    marca_arena marca = arena_marcar(&arena_vm);
+    char* texto = expandir_palabra_compilada(e->p, indice);
+    free(e->sujeto);
+    e->sujeto = texto != NULL ? strdup(texto) : NULL;
+    arena_volver(&arena_vm, marca);
+}
+
+// Verificar si el sujeto del case coincide con un patrón
+static bool coincide_patron(const ejecucion_vm* e, uint32_t indice)
+{
+    marca_arena marca = arena_marcar(&arena_vm);
+    char* patron = expandir_palabra_compilada(e->p, indice);
+    bool coincide = patron != NULL && fnmatch(patron, e->sujeto != NULL ? e->sujeto : "", 0) == 0;
+    arena_volver(&arena_vm, marca);
+    return coincide;
+}
+
+// Fijar el estado de return: el valor indicado, o el del último comando
+static void retornar(const programa* p, const instruccion* i)
+{
+    if (i->n == 0)
+    {
+        return;
+    }
+    marca_arena marca = arena_marcar(&arena_vm);
+    char* texto = expandir_palabra_compilada(p, i->a);
+    char* fin = NULL;
+    long valor = texto != NULL ? strtol(texto, &fin, 10) : 0;
+    if (fin == NULL || fin == texto || *fin != '\0')
+    {
+        fprintf(stderr, "return: '%s': se esperaba un número\n", texto != NULL ? texto : "");
+        ultimo_estado = 2;
+    }
+    else
+    {
+        ultimo_estado = (int)(valor & 0xFF);
+    }
+    arena_volver(&arena_vm, marca);
+}
+
+// Ejecutar un programa desde una instrucción hasta OP_FIN u OP_RETORNAR
+static void ejecutar_desde(const programa* p, uint32_t pc, programa_compartido* propio)
+{
+    ejecucion_vm maquina = {.p = p, .propio = propio};
+    ejecucion_vm* e = &maquina;
+
+    bool seguir = true;
+    while (seguir && EXIT)
+    {
+        const instruccion* i = &p->instrucciones[pc++];
+        switch (i->op)
+        {
+        case OP_EJECUTAR:
+            ejecutar_pipeline_compilado(p, i->a);
+            seguir = ultimo_estado != 128 + SIGINT;
+            break;
+        case OP_ASIGNAR:
+            asignar(p, i);
+            break;
+        case OP_SALTAR:
+            pc = i->a;
+            break;
+        case OP_SALTAR_SI_FALLA:
+            pc = ultimo_estado != 0 ? i->a : pc;
+            break;
+        case OP_SALTAR_SI_EXITO:
+            pc = ultimo_estado == 0 ? i->a : pc;
+            break;
+        case OP_NEGAR:
+            ultimo_estado = ultimo_estado == 0 ? 1 : 0;
+            break;
+        case OP_ESTADO:
+            ultimo_estado = (int)i->a;
+            break;
+        case OP_CICLO_INICIO:
+            abrir_ciclo(e, i->n);
+            break;
+        case OP_CICLO_GUARDAR:
+            e->ciclos[i->n].estado = ultimo_estado;
+            cerrar_ciclos(e, i->n + 1u); // break y continue con nivel salen de los ciclos internos
+            break;
+        case OP_CICLO_FIN:
+            ultimo_estado = e->ciclos[i->n].estado;
+            cerrar_ciclos(e, i->n);
+            break;
+        case OP_PARA_INICIO:
+            iniciar_para(e, i);
+            break;
+        case OP_PARA_SIGUIENTE:
+            pc = siguiente_campo(e, i) ? pc : i->b;
+            break;
+        case OP_CASO_SUJETO:
+            fijar_sujeto(e, i->a);
+            break;
+        case OP_CASO_PROBAR:
+            pc = coincide_patron(e, i->a) ? i->b : pc;
+            break;
+        case OP_FUNCION:
+            definir_funcion(e, p->cadenas + i->a, pc);
+            pc = i->b;
+            break;
+        case OP_RETORNAR:
+            retornar(p, i);
+            seguir = false;
+            break;
+        default: // OP_FIN
+            seguir = false;
+            break;
+        }
+    }
+
+    cerrar_ciclos(e, 0);
+    free(e->sujeto);
+}
+
+// Ejecutar un programa desde su primera instrucción
+void vm_ejecutar(const programa* p)
+{
+    ejecutar_desde(p, 0, NULL);
+}
@@ -0,0 +1,135 @@
+/**
+ * @file bench_busqueda.c
+ * @brief Microbenchmark de los núcleos de simd_search.h contra una búsqueda ingenua byte a byte.
+ *
+ * Arma en memoria un texto con el formato de un archivo de configuración y mide, con cada juego de instrucciones
+ * disponible, la búsqueda de una clave que aparece una sola vez al final y el conteo de saltos de línea. Antes de
+ * medir verifica que todos los núcleos den el mismo resultado que la versión ingenua.
+ *
+ * Uso: bench_busqueda [megabytes] [repeticiones]
+ */
+
+#include "simd_search.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/**
+ *  @brief Clave buscada; aparece sólo al final del texto
+ */
+#define CLAVE_BUSCADA "secret_token = "
+
+// Buscar una subcadena comparando cada posición byte a byte
+static const char* buscar_ingenuo(const char* texto, size_t largo, const char* aguja, size_t largo_aguja)
+{
+    for (size_t i = 0; i + largo_aguja <= largo; i++)
+    {
+        size_t j = 0;
+        while (j < largo_aguja && texto[i + j] == aguja[j])
+            j++;
+        if (j == largo_aguja)
+            return texto + i;
+    }
+    return NULL;
+}
+
+// Contar las apariciones de un byte sin que el compilador vectorice el bucle
+__attribute__((optimize("no-tree-vectorize"))) static size_t contar_ingenuo(const char* texto, size_t largo, char byte)
+{
+    size_t total = 0;
+    for (size_t i = 0; i < largo; i++)
+        total += texto[i] == byte;
+    return total;
+}
+
+// Segundos transcurridos desde un instante
+static double segundos_desde(const struct timespec* inicio)
+{
+    struct timespec ahora;
+    clock_gettime(CLOCK_MONOTONIC, &ahora);
+    return (double)(ahora.tv_sec - inicio->tv_sec) + (double)(ahora.tv_nsec - inicio->tv_nsec) / 1e9;
+}
+
+// Armar un texto de líneas "clave = valor" con la clave buscada sólo en la última línea
+static char* armar_texto(size_t largo)
+{
+    static const char* claves[] = {"server", "timeout", "host", "enable", "log_level", "retry", "cache", "secret"};
+    char* texto = malloc(largo);
+    if (texto == NULL)
+        return NULL;
+    size_t usado = 0;
+    unsigned semilla = 1;
+    while (usado + 64 < largo)
+    {
+        semilla = semilla * 1103515245u + 12345u;
+        int escritos = snprintf(texto + usado, largo - usado, "%s_%u = \"%s-%u\"\n", claves[(semilla >> 8) % 8],
+                                (semilla >> 4) % 1000, claves[(semilla >> 12) % 8], (semilla >> 16) % 100000);
+        usado += (size_t)escritos;
+    }
+    memset(texto + usado, ' ', largo - usado);
+    memcpy(texto + largo - sizeof(CLAVE_BUSCADA), CLAVE_BUSCADA "\n", sizeof(CLAVE_BUSCADA));
+    return texto;
+}
+
+/**
+ * @brief Función principal del microbenchmark
+ *
+ * @param argc Número de argumentos.
+ * @param argv Argumentos: megabytes del texto y repeticiones de cada medición.
+ * @return int 0 si todos los núcleos coinciden con la versión ingenua, 1 si no.
+ */
+int main(int argc, char** argv)
+{
+    size_t megabytes = argc > 1 ? strtoul(argv[1], NULL, 10) : 64;
+    int repeticiones = argc > 2 ? atoi(argv[2]) : 5;
+    if (megabytes == 0 || repeticiones <= 0)
+    {
+        fprintf(stderr, "Uso: %s [megabytes] [repeticiones]\n", argv[0]);
+        return 1;
+    }
+    size_t largo = megabytes << 20;
+    char* texto = armar_texto(largo);
+    if (texto == NULL)
+    {
+        fprintf(stderr, "Memoria insuficiente\n");
+        return 1;
+    }
+
+    const char* esperado = buscar_ingenuo(texto, largo, CLAVE_BUSCADA, strlen(CLAVE_BUSCADA));
+    size_t saltos = contar_ingenuo(texto, largo, '\n');
+    printf("%zu MiB, %d repeticiones, nivel disponible: %s\n", megabytes, repeticiones,
+           busqueda_nombre_nivel(busqueda_nivel_disponible()));
+    printf("%-10s %14s %14s\n", "núcleo", "buscar MB/s", "contar MB/s");
+
+    int fallos = 0;
+    for (int nivel = -1; nivel <= (int)busqueda_nivel_disponible(); nivel++)
+    {
+        // El nivel -1 es la versión ingenua
+        struct timespec inicio;
+        const char* hallado = NULL;
+        size_t contados = 0;
+        clock_gettime(CLOCK_MONOTONIC, &inicio);
+        for (int r = 0; r < repeticiones; r++)
+        {
+            hallado = nivel < 0 ? buscar_ingenuo(texto, largo, CLAVE_BUSCADA, strlen(CLAVE_BUSCADA))
+                                : buscar_subcadena((nivel_busqueda)nivel, texto, largo, CLAVE_BUSCADA,
+                                                   strlen(CLAVE_BUSCADA));
+        }
+        double busqueda = segundos_desde(&inicio);
+        clock_gettime(CLOCK_MONOTONIC, &inicio);
+        for (int r = 0; r < repeticiones; r++)
+        {
+            contados = nivel < 0 ? contar_ingenuo(texto, largo, '\n')
+                                 : contar_byte((nivel_busqueda)nivel, texto, largo, '\n');
+        }
+        double conteo = segundos_desde(&inicio);
+
+        double total = (double)largo * repeticiones / 1e6;
+        printf("%-10s %14.0f %14.0f%s\n", nivel < 0 ? "ingenuo" : busqueda_nombre_nivel((nivel_busqueda)nivel),
+               total / busqueda, total / conteo, hallado == esperado && contados == saltos ? "" : "  DISTINTO");
+        fallos += hallado != esperado || contados != saltos;
+    }
+    free(texto);
+    return fallos > 0 ? 1 : 0;
+}
@@ -7,12 +7,42 @@
  * ./test_shell
  */
 
+#include "batch.h"
+#include "builtins.h"
+#include "bytecode.h"
 #include "commands.h"
+#include "config_explorer.h"
+#include "config_grep.h"
+#include "config_index.h"
+#include "config_store.h"
+#include "core_utils.h"
+#include "event_loop.h"
+#include "fd_check.h"
+#include "file_stream.h"
+#include "jobs.h"
+#include "metrics_shm.h"
+#include "metrics_store.h"
 #include "monitor.h"
+#include "monitor_protocol.h"
+#include "parallel.h"
+#include "parser.h"
+#include "path_cache.h"
+#include "prompt.h"
+#include "script_cache.h"
+#include "shell_vars.h"
 #include "signal_handlers.h"
+#include "simd_search.h"
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/epoll.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
 #include <unistd.h>
 #include <unity/unity.h>
 
@@ -45,6 +75,174 @@ void test_ejecutar_comando_con_pipes(void);
  */
 void test_handle_sigterm(void);
 
+/**
+ * @brief Prueba la caché de ubicación de comandos
+ *
+ * Esta función prueba cache_resolver, cache_olvidar y la invalidación al cambiar PATH.
+ */
+void test_cache_resolver(void);
+
+/**
+ * @brief Prueba el analizador de la línea de comandos
+ *
+ * Esta función prueba parsear_comandos con comillas, pipes, redirecciones, separadores y errores de sintaxis.
+ */
+void test_parsear_comandos(void);
+
+/**
+ * @brief Prueba el estado de salida de los pipes
+ *
+ * Esta función prueba ultimo_estado con y sin la opción pipefail.
+ */
+void test_estado_pipeline(void);
+
+/**
+ * @brief Prueba la ejecución de archivos de comandos
+ *
+ * Esta función prueba ejecutar_script con comandos de varias líneas, un bloque paralelo y errores.
+ */
+void test_ejecutar_script(void);
+
+/**
+ * @brief Prueba el comando interno parallel
+ *
+ * Esta función prueba el orden de la salida con -k, el reemplazo de {} y los estados de salida con y sin --halt.
+ */
+void test_parallel(void);
+
+/**
+ * @brief Prueba la tabla de trabajos
+ *
+ * Esta función prueba el registro de un pipe en segundo plano, la búsqueda por %n y por PID, y los cambios de estado
+ * recolectados fuera del manejador de SIGCHLD.
+ */
+void test_trabajos(void);
+
+/**
+ * @brief Prueba el bucle de eventos
+ *
+ * Esta función prueba que un descriptor, un temporizador, la terminación de un proceso y SIGCHLD se atienden desde
+ * eventos_esperar(), y que eventos_cerrar() restaura la máscara de señales.
+ */
+void test_bucle_eventos(void);
+
+/**
+ * @brief Prueba el protocolo del canal de control del monitor
+ *
+ * Esta función prueba el envío y la recepción de mensajes, el rechazo de paquetes que no respetan el protocolo y el
+ * cierre del canal.
+ */
+void test_protocolo_monitor(void);
+
+/**
+ * @brief Prueba el anillo de métricas en memoria compartida
+ *
+ * Esta función prueba la publicación y lectura de muestras, el reemplazo de las más antiguas al llenarse el anillo y
+ * que un lector concurrente nunca ve una muestra a medio escribir.
+ */
+void test_anillo_metricas(void);
+
+/**
+ * @brief Prueba el historial de métricas por columnas
+ *
+ * Esta función prueba los agregados sobre una ventana, los percentiles exactos y aproximados, y la elección del nivel
+ * de resolución cuando las muestras crudas más antiguas ya se descartaron.
+ */
+void test_metricas_consulta(void);
+
+/**
+ * @brief Prueba la configuración en memoria
+ *
+ * Esta función prueba que el archivo predeterminado se crea recién al cargar la configuración, las operaciones de
+ * 'update_config', que el archivo sólo se reescribe cuando algo cambió y que una edición externa se vuelve a leer.
+ */
+void test_configuracion(void);
+
+/**
+ * @brief Prueba el motor del prompt
+ *
+ * Esta función prueba que el prompt sigue al directorio cambiado con 'cd', la elección de segmentos con 'prompt', el
+ * segmento del estado del último comando y que la rama de git, calculada en otro hilo, aparece en el prompt.
+ */
+void test_prompt(void);
+
+/**
+ * @brief Prueba el recorrido de directorios de 'explorar_config'
+ *
+ * Esta función prueba que los archivos se entregan en el mismo orden con uno o varios trabajadores, los filtros de
+ * extensión (como sufijo), patrón y profundidad, y que un enlace a un ancestro se informa como bucle con -L.
+ */
+void test_explorar_config(void);
+
+/**
+ * @brief Prueba el índice persistente de 'explorar_config'
+ *
+ * Esta función prueba que el índice entrega lo mismo que el recorrido completo al construirse, desde la memoria,
+ * después de agregar y borrar archivos y directorios (avisados por inotify) y al cargarse del disco, y que una consulta
+ * sin cambios no vuelve a leer ningún directorio.
+ */
+void test_indice_config(void);
+
+/**
+ * @brief Prueba el volcado de archivos con sendfile() y splice()
+ *
+ * Esta función prueba el volcado completo y de las primeras o últimas líneas de un archivo regular (también cuando las
+ * últimas líneas ocupan varios bloques) y de un pipe, y que la posición del archivo queda después de lo volcado.
+ */
+void test_volcado(void);
+
+/**
+ * @brief Prueba la búsqueda de 'buscar_config'
+ *
+ * Esta función prueba que los núcleos vectoriales de búsqueda y conteo coinciden con una búsqueda ingenua en todas las
+ * alineaciones y cerca de los bordes de bloque, y la salida "ruta:línea:texto" del comando con un texto literal y con
+ * expresiones con '.', '*', '^' y '$'.
+ */
+void test_buscar_config(void);
+
+/**
+ * @brief Prueba las redirecciones y los planes de descriptores
+ *
+ * Esta función prueba el análisis de '<>', '>&', '<&', '&>' y '&>>', y su ejecución con comandos internos (que reciben
+ * flujos nuevos sin que cambien los descriptores del shell) y con programas externos, incluidos los errores.
+ */
+void test_redirecciones(void);
+
+/**
+ * @brief Prueba la higiene de la tabla de descriptores
+ *
+ * Esta función prueba que 'fdcheck' detecta un descriptor de más y uno heredable, que los comandos internos, los
+ * pipes y las redirecciones no dejan descriptores abiertos en el shell, y que los hijos no heredan un descriptor sin
+ * FD_CLOEXEC salvo que el plan lo ponga en su lugar.
+ */
+void test_descriptores(void);
+
+/**
+ * @brief Prueba el compilador de bytecode y la máquina virtual
+ *
+ * Esta función prueba que las asignaciones, if, while, for, case, '&&', '||', '!', break, continue y las funciones
+ * se ejecutan dentro del shell, que break fuera de un ciclo es un error de compilación y que programa_abrir() acepta
+ * un programa compilado pero rechaza copias con la cabecera, el tamaño o un salto alterados.
+ */
+void test_interprete(void);
+
+/**
+ * @brief Prueba la caché de scripts compilados
+ *
+ * Esta función prueba que un script se ejecuta igual desde su caché, que una caché dañada o de una versión anterior
+ * del script se descarta y se vuelve a generar, y que 'source' ejecuta un archivo en el shell con sus argumentos.
+ */
+void test_cache_scripts(void);
+
+/**
+ * @brief Prueba las versiones internas de cat, wc, head, tail, true, false y test
+ *
+ * Esta función prueba que su salida y su estado coinciden con los de coreutils (incluidos los anchos de columna de wc,
+ * las cabeceras de head y tail y los errores de sintaxis de test), y que sólo se eligen con "set -o internos" y con
+ * argumentos que reproducen.
+ */
+void test_utilidades_internas(void);
+
 // Funciones de configuración y limpieza
 void setUp(void)
 {
@@ -73,6 +271,27 @@ int main(void)
     RUN_TEST(test_start_monitor_and_stop_monitor);
     RUN_TEST(test_ejecutar_comando_con_pipes);
     RUN_TEST(test_handle_sigterm);
+    RUN_TEST(test_cache_resolver);
+    RUN_TEST(test_parsear_comandos);
+    RUN_TEST(test_estado_pipeline);
+    RUN_TEST(test_ejecutar_script);
+    RUN_TEST(test_parallel);
+    RUN_TEST(test_trabajos);
+    RUN_TEST(test_bucle_eventos);
+    RUN_TEST(test_protocolo_monitor);
+    RUN_TEST(test_anillo_metricas);
+    RUN_TEST(test_metricas_consulta);
+    RUN_TEST(test_configuracion);
+    RUN_TEST(test_prompt);
+    RUN_TEST(test_explorar_config);
+    RUN_TEST(test_indice_config);
+    RUN_TEST(test_volcado);
+    RUN_TEST(test_buscar_config);
+    RUN_TEST(test_redirecciones);
+    RUN_TEST(test_descriptores);
+    RUN_TEST(test_interprete);
+    RUN_TEST(test_cache_scripts);
+    RUN_TEST(test_utilidades_internas);
 
     return UNITY_END(); // Finaliza las pruebas y devuelve el resultado
 }
@@ -131,6 +350,7 @@ void test_ejecutar_comando_con_pipes(void)
     int fd = open("salida_test.txt", O_RDWR | O_CREAT | O_TRUNC, 0666);
     TEST_ASSERT_TRUE(fd >= 0); // Verificar que el archivo se abrió correctamente
 
+    fflush(stdout);                         // Vaciar la salida pendiente antes de cambiar el descriptor
     int stdout_backup = dup(STDOUT_FILENO); // Respaldar stdout
     dup2(fd, STDOUT_FILENO);                // Redirigir stdout al archivo
     close(fd);
@@ -166,3 +386,1419 @@ void test_handle_sigterm(void)
     // Verificar que running ahora sea 0
     TEST_ASSERT_EQUAL_INT(0, running);
 }
+
+// Prueba de la caché de ubicación de comandos
+void test_cache_resolver(void)
+{
+    char ruta[PATH_MAX];
+    char* path_original = strdup(getenv("PATH"));
+
+    // Caso 1: Un comando de $PATH se resuelve a una ruta absoluta y queda en la caché
+    setenv("PATH", "/usr/bin:/bin", 1);
+    TEST_ASSERT_TRUE(cache_resolver("sh", ruta, sizeof(ruta)));
+    TEST_ASSERT_EQUAL_INT('/', ruta[0]);
+    TEST_ASSERT_EQUAL_INT(1, cache_tamano());
+
+    // Caso 2: Las rutas explícitas no se cachean y los comandos inexistentes no se resuelven
+    TEST_ASSERT_TRUE(cache_resolver("./programa", ruta, sizeof(ruta)));
+    TEST_ASSERT_EQUAL_STRING("./programa", ruta);
+    TEST_ASSERT_FALSE(cache_resolver("comando_que_no_existe", ruta, sizeof(ruta)));
+    TEST_ASSERT_EQUAL_INT(1, cache_tamano());
+
+    // Caso 3: cache_olvidar descarta la entrada
+    TEST_ASSERT_TRUE(cache_olvidar("sh"));
+    TEST_ASSERT_EQUAL_INT(0, cache_tamano());
+
+    // Caso 4: Cambiar PATH vacía la caché
+    TEST_ASSERT_TRUE(cache_resolver("sh", ruta, sizeof(ruta)));
+    setenv("PATH", "/bin:/usr/bin", 1);
+    TEST_ASSERT_TRUE(cache_resolver("ls", ruta, sizeof(ruta)));
+    TEST_ASSERT_EQUAL_INT(1, cache_tamano());
+
+    setenv("PATH", path_original, 1);
+    free(path_original);
+}
+
+// Prueba del analizador de la línea de comandos
+void test_parsear_comandos(void)
+{
+    arena a;
+    lista_comandos* lista;
+    char error[256];
+    int argc;
+    arena_inicializar(&a);
+
+    // Caso 1: Comillas, escapes, pipe, redirección con descriptor y segundo plano
+    const char* linea = "echo 'a  b' \\| \"$HOME\" 2>>err.txt | wc -l & ls";
+    TEST_ASSERT_EQUAL_INT(PARSEO_OK, parsear_comandos(&a, linea, strlen(linea), 1, &lista, error, sizeof(error)));
+    TEST_ASSERT_EQUAL_INT(2, lista->num_pipelines);
+    TEST_ASSERT_EQUAL_INT(2, lista->pipelines[0].num_etapas);
+    TEST_ASSERT_TRUE(lista->pipelines[0].en_segundo_plano);
+    TEST_ASSERT_FALSE(lista->pipelines[1].en_segundo_plano);
+
+    const comando_simple* echo = &lista->pipelines[0].etapas[0];
+    char** args = expandir_argumentos(&a, echo, &argc);
+    TEST_ASSERT_EQUAL_INT(4, argc);
+    TEST_ASSERT_EQUAL_STRING("a  b", args[1]);
+    TEST_ASSERT_EQUAL_STRING("|", args[2]);
+    TEST_ASSERT_EQUAL_STRING(getenv("HOME"), args[3]);
+    TEST_ASSERT_NOT_NULL(echo->redirecciones);
+    TEST_ASSERT_EQUAL_INT(REDIR_AGREGAR, echo->redirecciones->tipo);
+    TEST_ASSERT_EQUAL_INT(2, echo->redirecciones->fd);
+    TEST_ASSERT_EQUAL_STRING("err.txt", echo->redirecciones->destino.texto);
+
+    // Caso 2: Una variable no definida y sin comillas no produce argumento
+    arena_reiniciar(&a);
+    linea = "ls $VARIABLE_QUE_NO_EXISTE \"\"";
+    TEST_ASSERT_EQUAL_INT(PARSEO_OK, parsear_comandos(&a, linea, strlen(linea), 1, &lista, error, sizeof(error)));
+    expandir_argumentos(&a, &lista->pipelines[0].etapas[0], &argc);
+    TEST_ASSERT_EQUAL_INT(2, argc);
+
+    // Caso 3: Errores de sintaxis y texto incompleto
+    linea = "ls | | wc";
+    TEST_ASSERT_EQUAL_INT(PARSEO_ERROR, parsear_comandos(&a, linea, strlen(linea), 1, &lista, error, sizeof(error)));
+    linea = "echo \"sin cerrar";
+    TEST_ASSERT_EQUAL_INT(PARSEO_INCOMPLETO,
+                          parsear_comandos(&a, linea, strlen(linea), 1, &lista, error, sizeof(error)));
+
+    arena_liberar(&a);
+}
+
+// Prueba del estado de salida de los pipes
+void test_estado_pipeline(void)
+{
+    char sin_pipefail[] = "false | true";
+    char con_pipefail[] = "sh -c 'exit 3' | false | true";
+
+    // Caso 1: Sin pipefail, el estado es el de la última etapa
+    opcion_pipefail = false;
+    analizar_comando(sin_pipefail);
+    TEST_ASSERT_EQUAL_INT(0, ultimo_estado);
+
+    // Caso 2: Con pipefail, el estado es el de la última etapa que falló
+    opcion_pipefail = true;
+    analizar_comando(con_pipefail);
+    TEST_ASSERT_EQUAL_INT(1, ultimo_estado);
+
+    opcion_pipefail = false;
+}
+
+void test_ejecutar_script(void)
+{
+    char ruta[] = "/tmp/test_script_XXXXXX";
+    const char* script = "echo \"uno\ndos\" > /dev/null\n"
+                         "begin_parallel 2\n"
+                         "true\n"
+                         "false\n"
+                         "sh -c 'exit 3'\n"
+                         "end_parallel\n"
+                         "echo |\n"
+                         "  cat > /dev/null\n"
+                         "echo 'sin cerrar\n";
+
+    int fd = mkstemp(ruta);
+    TEST_ASSERT_NOT_EQUAL(-1, fd);
+    TEST_ASSERT_EQUAL_INT((int)strlen(script), (int)write(fd, script, strlen(script)));
+    close(fd);
+
+    // Caso 1: Fallan los dos comandos del bloque y la última línea tiene un error de sintaxis
+    TEST_ASSERT_EQUAL_INT(3, ejecutar_script(ruta));
+
+    // Caso 2: Un archivo inexistente no se ejecuta
+    unlink(ruta);
+    TEST_ASSERT_EQUAL_INT(-1, ejecutar_script(ruta));
+}
+
+void test_parallel(void)
+{
+    char* ordenado[] = {"parallel", "-k", "-j", "4", "sh", "-c", "sleep 0.0$1; echo $1", "x", ":::",
+                        "3",        "1",  "2",  NULL};
+    char* con_llaves[] = {"parallel", "-k", "-n", "2", "echo", "<", "{}", ">", ":::", "a", "b", "c", NULL};
+    char* fallos[] = {"parallel", "sh", "-c", "exit $1", "x", ":::", "0", "1", "2", "0", NULL};
+    char* detener[] = {"parallel", "--halt", "-j", "1", "sh", "-c", "exit $1", "x", ":::", "0", "1", "0", "0", NULL};
+
+    // Caso 1: Con -k la salida respeta el orden de los elementos aunque terminen en otro orden
+    int fd = open("salida_test.txt", O_RDWR | O_CREAT | O_TRUNC, 0666);
+    TEST_ASSERT_TRUE(fd >= 0);
+    fflush(stdout);
+    int stdout_backup = dup(STDOUT_FILENO);
+    dup2(fd, STDOUT_FILENO);
+    close(fd);
+
+    TEST_ASSERT_EQUAL_INT(0, manejar_comando_parallel(12, ordenado));
+    TEST_ASSERT_EQUAL_INT(0, manejar_comando_parallel(12, con_llaves));
+
+    dup2(stdout_backup, STDOUT_FILENO);
+    close(stdout_backup);
+
+    char resultado[1024] = {0};
+    FILE* file = fopen("salida_test.txt", "r");
+    TEST_ASSERT_NOT_NULL(file);
+    TEST_ASSERT_TRUE(fread(resultado, 1, sizeof(resultado) - 1, file) > 0);
+    fclose(file);
+    remove("salida_test.txt");
+
+    // Caso 2: {} se reemplaza por los elementos de cada lote
+    TEST_ASSERT_EQUAL_STRING("3\n1\n2\n< a b >\n< c >\n", resultado);
+
+    // Caso 3: Sin --halt se ejecutan todos y el estado es la cantidad de elementos que fallaron
+    TEST_ASSERT_EQUAL_INT(2, manejar_comando_parallel(10, fallos));
+
+    // Caso 4: Con --halt los elementos posteriores al fallo no se ejecutan y también cuentan
+    TEST_ASSERT_EQUAL_INT(3, manejar_comando_parallel(13, detener));
+}
+
+// Esperar a que un trabajo llegue a un estado, recolectando como lo hace el shell entre comandos
+static bool esperar_estado(const trabajo* t, estado_trabajo estado)
+{
+    for (int i = 0; i < 200 && t->estado != estado; i++)
+    {
+        usleep(10000);
+        trabajos_actualizar();
+    }
+    return t->estado == estado;
+}
+
+void test_trabajos(void)
+{
+    char segundo_plano[] = "sleep 0.3 | sleep 0.2 &";
+    signal(SIGCHLD, manejador_SIGCHLD);
+
+    // Caso 1: El pipe queda registrado como un trabajo con número estable
+    analizar_comando(segundo_plano);
+    TEST_ASSERT_EQUAL_INT(1, trabajos_cantidad());
+    trabajo* t = trabajos_buscar("%1");
+    TEST_ASSERT_NOT_NULL(t);
+    TEST_ASSERT_EQUAL_INT(2, t->num_procesos);
+    TEST_ASSERT_EQUAL_PTR(t, trabajos_buscar(NULL));
+    TEST_ASSERT_EQUAL_PTR(t, trabajos_buscar("%+"));
+    TEST_ASSERT_NULL(trabajos_buscar("%2"));
+
+    // Caso 2: Cualquier PID del pipe encuentra el trabajo
+    char pid[16];
+    snprintf(pid, sizeof(pid), "%d", t->pids[1]);
+    TEST_ASSERT_EQUAL_PTR(t, trabajos_buscar(pid));
+
+    // Caso 3: Detener y reanudar el grupo cambia el estado del trabajo
+    kill(-t->pgid, SIGSTOP);
+    TEST_ASSERT_TRUE(esperar_estado(t, TRABAJO_DETENIDO));
+    kill(-t->pgid, SIGCONT);
+    TEST_ASSERT_TRUE(esperar_estado(t, TRABAJO_EN_EJECUCION));
+
+    // Caso 4: Al terminar, el aviso elimina el trabajo de la tabla
+    TEST_ASSERT_TRUE(esperar_estado(t, TRABAJO_TERMINADO));
+    TEST_ASSERT_EQUAL_INT(0, t->estados[0]);
+    trabajos_notificar();
+    TEST_ASSERT_EQUAL_INT(0, trabajos_cantidad());
+
+    signal(SIGCHLD, SIG_DFL);
+}
+
+/**
+ * @brief Veces que se atendió cada tipo de evento en test_bucle_eventos
+ */
+static int eventos_atendidos[4];
+
+// Contar un evento de descriptor y quitarlo del bucle desde su propio manejador
+static void contar_evento(int fd, uint32_t eventos __attribute__((unused)), void* dato)
+{
+    eventos_atendidos[*(int*)dato]++;
+    eventos_quitar_fd(fd);
+}
+
+// Contar las SIGCHLD recibidas por el bucle
+static void contar_senal(int sig)
+{
+    if (sig == SIGCHLD)
+        eventos_atendidos[3]++;
+}
+
+void test_bucle_eventos(void)
+{
+    int tipos[] = {0, 1, 2};
+    int tubo[2];
+    memset(eventos_atendidos, 0, sizeof(eventos_atendidos));
+
+    // Caso 1: Sin inicializar, el bucle no hace nada
+    TEST_ASSERT_EQUAL_INT(-1, eventos_esperar(0));
+    TEST_ASSERT_EQUAL_INT(-1, eventos_agregar_temporizador(1, false, contar_evento, &tipos[1]));
+
+    // Caso 2: Un descriptor, un temporizador y un proceso se atienden en el hilo que espera
+    TEST_ASSERT_TRUE(eventos_inicializar(false, contar_senal));
+    TEST_ASSERT_EQUAL_INT(0, pipe(tubo));
+    TEST_ASSERT_EQUAL_INT(0, eventos_agregar_fd(tubo[0], EPOLLIN, contar_evento, &tipos[0]));
+    TEST_ASSERT_NOT_EQUAL(-1, eventos_agregar_temporizador(20, false, contar_evento, &tipos[1]));
+    pid_t hijo = fork();
+    if (hijo == 0)
+    {
+        _exit(0);
+    }
+    TEST_ASSERT_NOT_EQUAL(-1, eventos_vigilar_proceso(hijo, contar_evento, &tipos[2]));
+    TEST_ASSERT_EQUAL_INT(1, (int)write(tubo[1], "x", 1));
+
+    for (int i = 0; i < 100 && (!eventos_atendidos[1] || !eventos_atendidos[2] || !eventos_atendidos[3]); i++)
+    {
+        eventos_esperar(50);
+    }
+    TEST_ASSERT_EQUAL_INT(1, eventos_atendidos[0]);
+    TEST_ASSERT_EQUAL_INT(1, eventos_atendidos[1]);
+    TEST_ASSERT_EQUAL_INT(1, eventos_atendidos[2]);
+    TEST_ASSERT_TRUE(eventos_atendidos[3] >= 1);
+    waitpid(hijo, NULL, 0);
+
+    // Caso 3: Al cerrar, SIGCHLD deja de estar bloqueada
+    eventos_cerrar();
+    sigset_t mascara;
+    sigprocmask(SIG_BLOCK, NULL, &mascara);
+    TEST_ASSERT_FALSE(sigismember(&mascara, SIGCHLD));
+    close(tubo[0]);
+    close(tubo[1]);
+}
+
+void test_protocolo_monitor(void)
+{
+    const char configuracion[] = "{\"sampling_interval\":5,\"metrics\":[\"cpu_usage\"]}";
+    mensaje_monitor mensaje;
+    int canal[2];
+    TEST_ASSERT_EQUAL_INT(0, socketpair(AF_UNIX, SOCK_SEQPACKET, 0, canal));
+
+    // Caso 1: Sin mensajes pendientes no se bloquea
+    TEST_ASSERT_EQUAL_INT(-1, monitor_recibir_mensaje(canal[1], &mensaje));
+
+    // Caso 2: Un mensaje llega completo, con su tipo, secuencia y carga
+    TEST_ASSERT_EQUAL_INT(0, monitor_enviar_mensaje(canal[0], MONITOR_MSG_CONFIGURAR, 7, configuracion,
+                                                    (uint32_t)strlen(configuracion)));
+    TEST_ASSERT_EQUAL_INT(1, monitor_recibir_mensaje(canal[1], &mensaje));
+    TEST_ASSERT_EQUAL_INT(MONITOR_MSG_CONFIGURAR, mensaje.cabecera.tipo);
+    TEST_ASSERT_EQUAL_INT(7, (int)mensaje.cabecera.secuencia);
+    TEST_ASSERT_EQUAL_STRING(configuracion, mensaje.carga);
+
+    // Caso 3: Los límites entre mensajes se conservan
+    int32_t estado = 0;
+    TEST_ASSERT_EQUAL_INT(0, monitor_enviar_mensaje(canal[1], MONITOR_MSG_HOLA, 0, NULL, 0));
+    TEST_ASSERT_EQUAL_INT(0, monitor_enviar_mensaje(canal[1], MONITOR_MSG_ACK, 7, &estado, sizeof(estado)));
+    TEST_ASSERT_EQUAL_INT(1, monitor_recibir_mensaje(canal[0], &mensaje));
+    TEST_ASSERT_EQUAL_INT(MONITOR_MSG_HOLA, mensaje.cabecera.tipo);
+    TEST_ASSERT_EQUAL_INT(1, monitor_recibir_mensaje(canal[0], &mensaje));
+    TEST_ASSERT_EQUAL_INT(MONITOR_MSG_ACK, mensaje.cabecera.tipo);
+    TEST_ASSERT_EQUAL_INT((int)sizeof(estado), (int)mensaje.cabecera.longitud);
+
+    // Caso 4: Un paquete que no respeta el protocolo se rechaza
+    TEST_ASSERT_EQUAL_INT(3, (int)send(canal[0], "abc", 3, 0));
+    TEST_ASSERT_EQUAL_INT(-1, monitor_recibir_mensaje(canal[1], &mensaje));
+    TEST_ASSERT_EQUAL_INT(EPROTO, errno);
+
+    // Caso 5: Una carga demasiado grande no se envía
+    TEST_ASSERT_EQUAL_INT(-1, monitor_enviar_mensaje(canal[0], MONITOR_MSG_CONFIGURAR, 8, configuracion,
+                                                     MONITOR_CARGA_MAX + 1));
+
+    // Caso 6: El cierre del otro extremo se informa con 0
+    close(canal[0]);
+    TEST_ASSERT_EQUAL_INT(0, monitor_recibir_mensaje(canal[1], &mensaje));
+    close(canal[1]);
+}
+
+// Publicar muestras cuyos campos valen todos lo mismo, para detectar lecturas mezcladas
+static void* escribir_muestras(void* dato)
+{
+    anillo_metricas* anillo = dato;
+    for (int k = 0; k < 200000; k++)
+    {
+        muestra_metricas m = {.instante_ns = (uint64_t)k, .cpu = k, .memoria = k, .red_rx = k, .red_tx = k};
+        metricas_publicar(anillo, &m);
+    }
+    return NULL;
+}
+
+void test_anillo_metricas(void)
+{
+    char nombre[64];
+    muestra_metricas muestras[8];
+    snprintf(nombre, sizeof(nombre), "/shell_metricas_prueba_%d", (int)getpid());
+
+    // Caso 1: Un segmento nuevo está vacío y se puede abrir sólo para lectura
+    anillo_metricas* anillo = metricas_crear(nombre);
+    TEST_ASSERT_NOT_NULL(anillo);
+    anillo_metricas* lector = metricas_abrir(nombre, false);
+    TEST_ASSERT_NOT_NULL(lector);
+    TEST_ASSERT_EQUAL_INT(0, metricas_leer_ultimas(lector, muestras, 8));
+
+    // Caso 2: Las muestras se leen de la más antigua a la más nueva
+    for (int k = 0; k < 3; k++)
+    {
+        muestra_metricas m = {.instante_ns = (uint64_t)k, .cpu = 10.0 * k};
+        metricas_publicar(anillo, &m);
+    }
+    TEST_ASSERT_EQUAL_INT(2, metricas_leer_ultimas(lector, muestras, 2));
+    TEST_ASSERT_EQUAL_INT(10, (int)muestras[0].cpu);
+    TEST_ASSERT_EQUAL_INT(20, (int)muestras[1].cpu);
+
+    // Caso 3: Al llenarse el anillo se reemplazan las muestras más antiguas
+    for (int k = 3; k < METRICAS_CAPACIDAD + 5; k++)
+    {
+        muestra_metricas m = {.instante_ns = (uint64_t)k, .cpu = k, .memoria = k, .red_rx = k, .red_tx = k};
+        metricas_publicar(anillo, &m);
+    }
+    TEST_ASSERT_FALSE(metricas_leer(lector, 4, &muestras[0]));
+    TEST_ASSERT_TRUE(metricas_leer(lector, 5, &muestras[0]));
+    TEST_ASSERT_EQUAL_INT(5, (int)muestras[0].instante_ns);
+    TEST_ASSERT_FALSE(metricas_leer(lector, METRICAS_CAPACIDAD + 5, &muestras[0]));
+
+    // Caso 4: Un lector concurrente sólo ve muestras completas
+    pthread_t escritor;
+    pthread_create(&escritor, NULL, escribir_muestras, anillo);
+    int inconsistentes = 0;
+    for (int i = 0; i < 200000; i++)
+    {
+        int n = metricas_leer_ultimas(lector, muestras, 8);
+        for (int k = 0; k < n; k++)
+        {
+            const muestra_metricas* m = &muestras[k];
+            if (m->cpu != m->memoria || m->cpu != m->red_rx || m->cpu != m->red_tx || m->cpu != (double)m->instante_ns)
+                inconsistentes++;
+        }
+    }
+    pthread_join(escritor, NULL);
+    TEST_ASSERT_EQUAL_INT(0, inconsistentes);
+
+    metricas_cerrar(lector);
+    metricas_cerrar(anillo);
+    metricas_eliminar(nombre);
+    TEST_ASSERT_NULL(metricas_abrir(nombre, false));
+}
+
+void test_metricas_consulta(void)
+{
+    const uint64_t segundo = 1000000000ull;
+    const uint64_t base = 1200ull * ALMACEN_ANCHO_NIVEL_2 * segundo; // Comienzo de un intervalo de todos los niveles
+    const char* metricas[] = {"First_Fit", "cpu_usage", "network_usage"};
+    const char* columnas[4];
+    double percentiles[] = {50, 99};
+    resultado_consulta r;
+
+    // Caso 1: Sólo se crean columnas para las métricas que publica el monitor
+    TEST_ASSERT_NULL(almacen_crear(metricas, 1));
+    almacen_metricas* almacen = almacen_crear(metricas, 3);
+    TEST_ASSERT_NOT_NULL(almacen);
+    TEST_ASSERT_EQUAL_INT(2, almacen_columnas(almacen, "network_usage", columnas, 4));
+    TEST_ASSERT_EQUAL_STRING("network_rx", columnas[0]);
+    TEST_ASSERT_EQUAL_INT(3, almacen_columnas(almacen, NULL, columnas, 4));
+    TEST_ASSERT_EQUAL_INT(-1, almacen_consultar(almacen, "memory_usage", 0, UINT64_MAX, -1, NULL, 0, &r));
+    TEST_ASSERT_EQUAL_INT(1, almacen_consultar(almacen, "cpu_usage", 0, UINT64_MAX, -1, NULL, 0, &r));
+
+    // Caso 2: Agregados exactos sobre las muestras crudas; una muestra fuera de orden se descarta
+    for (int k = 0; k < 100; k++)
+    {
+        muestra_metricas m = {.instante_ns = base + (uint64_t)k * segundo, .cpu = k, .red_rx = 1024};
+        almacen_agregar(almacen, &m);
+    }
+    muestra_metricas vieja = {.instante_ns = base - segundo, .cpu = 1000};
+    almacen_agregar(almacen, &vieja);
+    TEST_ASSERT_EQUAL_INT(0, almacen_consultar(almacen, "cpu_usage", 0, UINT64_MAX, -1, percentiles, 2, &r));
+    TEST_ASSERT_EQUAL_INT(0, r.nivel);
+    TEST_ASSERT_EQUAL_UINT64(100, r.cantidad);
+    TEST_ASSERT_EQUAL_DOUBLE(0, r.minimo);
+    TEST_ASSERT_EQUAL_DOUBLE(99, r.maximo);
+    TEST_ASSERT_EQUAL_DOUBLE(49.5, r.media);
+    TEST_ASSERT_EQUAL_DOUBLE(49.5, r.percentiles[0]);
+    TEST_ASSERT_EQUAL_DOUBLE(98.01, r.percentiles[1]);
+
+    // Caso 3: La ventana sólo incluye las muestras entre sus extremos
+    TEST_ASSERT_EQUAL_INT(0, almacen_consultar(almacen, "cpu_usage", base + 10 * segundo, base + 19 * segundo, -1,
+                                               NULL, 0, &r));
+    TEST_ASSERT_EQUAL_UINT64(10, r.cantidad);
+    TEST_ASSERT_EQUAL_DOUBLE(10, r.minimo);
+    TEST_ASSERT_EQUAL_DOUBLE(19, r.maximo);
+
+    // Caso 4: Los niveles agrupados dan los mismos extremos y media, y percentiles aproximados
+    TEST_ASSERT_EQUAL_INT(0, almacen_consultar(almacen, "cpu_usage", 0, UINT64_MAX, 1, percentiles, 2, &r));
+    TEST_ASSERT_EQUAL_INT(1, r.nivel);
+    TEST_ASSERT_EQUAL_UINT64(100, r.cantidad);
+    TEST_ASSERT_EQUAL_DOUBLE(0, r.minimo);
+    TEST_ASSERT_EQUAL_DOUBLE(99, r.maximo);
+    TEST_ASSERT_EQUAL_DOUBLE(49.5, r.media);
+    TEST_ASSERT_DOUBLE_WITHIN(2.0, 49.5, r.percentiles[0]);
+    TEST_ASSERT_DOUBLE_WITHIN(2.0, 98.01, r.percentiles[1]);
+    TEST_ASSERT_EQUAL_INT(0, almacen_consultar(almacen, "network_rx", 0, UINT64_MAX, 2, percentiles, 1, &r));
+    TEST_ASSERT_EQUAL_DOUBLE(1024, r.percentiles[0]);
+
+    // Caso 5: Sin las muestras crudas del comienzo de la ventana, se usa el primer nivel que las conserva
+    for (int k = 100; k < ALMACEN_CAPACIDAD_CRUDA + 100; k++)
+    {
+        muestra_metricas m = {.instante_ns = base + (uint64_t)k * segundo, .cpu = 50};
+        almacen_agregar(almacen, &m);
+    }
+    TEST_ASSERT_EQUAL_INT(0, almacen_consultar(almacen, "cpu_usage", base, UINT64_MAX, -1, NULL, 0, &r));
+    TEST_ASSERT_EQUAL_INT(1, r.nivel);
+    TEST_ASSERT_EQUAL_UINT64(ALMACEN_CAPACIDAD_CRUDA + 100, r.cantidad);
+    TEST_ASSERT_EQUAL_INT(0, almacen_consultar(almacen, "cpu_usage", base + 200 * segundo, UINT64_MAX, -1, NULL, 0,
+                                               &r));
+    TEST_ASSERT_EQUAL_INT(0, r.nivel);
+
+    almacen_liberar(almacen);
+}
+
+void test_configuracion(void)
+{
+    char directorio[] = "/tmp/test_config_XXXXXX";
+    char ruta[64];
+    char temporal[80];
+    struct stat antes, despues;
+    const char* metricas[8];
+    TEST_ASSERT_NOT_NULL(mkdtemp(directorio));
+    snprintf(ruta, sizeof(ruta), "%s/config.json", directorio);
+    config_liberar();
+    setenv(CONFIG_ENV, ruta, 1);
+
+    // Caso 1: Fijar la ruta no toca el disco; al cargar sin archivo, se crea con la configuración predeterminada
+    TEST_ASSERT_TRUE(config_preparar());
+    TEST_ASSERT_EQUAL_INT(-1, stat(ruta, &antes));
+    TEST_ASSERT_TRUE(config_cargar());
+    TEST_ASSERT_EQUAL_STRING(ruta, config_ruta());
+    TEST_ASSERT_EQUAL_INT(0, stat(ruta, &antes));
+    TEST_ASSERT_EQUAL_INT(10, config_intervalo());
+    TEST_ASSERT_EQUAL_INT(6, config_metricas(metricas, 8));
+
+    // Caso 2: Las operaciones informan si cambiaron algo y sin cambios no se reescribe el archivo
+    TEST_ASSERT_EQUAL_INT(1, config_aplicar("set", "sampling_interval", "5"));
+    TEST_ASSERT_EQUAL_INT(0, config_aplicar("set", "sampling_interval", "5"));
+    TEST_ASSERT_EQUAL_INT(1, config_aplicar("add", "metrics", "disk_usage"));
+    TEST_ASSERT_EQUAL_INT(0, config_aplicar("add", "metrics", "disk_usage"));
+    TEST_ASSERT_EQUAL_INT(1, config_aplicar("remove", "metrics", "First_Fit"));
+    TEST_ASSERT_EQUAL_INT(0, config_aplicar("remove", "metrics", "First_Fit"));
+    TEST_ASSERT_EQUAL_INT(0, config_aplicar("remove", "inexistente", NULL));
+    TEST_ASSERT_EQUAL_INT(-1, config_aplicar("add", "sampling_interval", "1"));
+    TEST_ASSERT_EQUAL_INT(-1, config_aplicar("mover", "metrics", "1"));
+    TEST_ASSERT_EQUAL_INT(0, config_guardar());
+    TEST_ASSERT_EQUAL_INT(0, stat(ruta, &despues));
+    TEST_ASSERT_NOT_EQUAL(antes.st_ino, despues.st_ino); // Reemplazado con rename()
+    TEST_ASSERT_EQUAL_INT(5, config_intervalo());
+    TEST_ASSERT_EQUAL_INT(0, config_guardar());
+    TEST_ASSERT_EQUAL_INT(0, stat(ruta, &antes));
+    TEST_ASSERT_EQUAL_INT(despues.st_ino, antes.st_ino);
+
+    // Caso 3: El archivo escrito tiene la configuración en memoria
+    config_liberar();
+    TEST_ASSERT_EQUAL_INT(5, config_intervalo());
+    TEST_ASSERT_EQUAL_INT(6, config_metricas(metricas, 8));
+    TEST_ASSERT_EQUAL_STRING("disk_usage", metricas[5]);
+
+    // Caso 4: Una edición externa se lee antes de la próxima consulta
+    snprintf(temporal, sizeof(temporal), "%s/editado", directorio);
+    FILE* archivo = fopen(temporal, "w");
+    TEST_ASSERT_NOT_NULL(archivo);
+    fputs("{\"sampling_interval\": 2, \"metrics\": [\"cpu_usage\"]}\n", archivo);
+    fclose(archivo);
+    TEST_ASSERT_EQUAL_INT(0, rename(temporal, ruta));
+    TEST_ASSERT_EQUAL_INT(2, config_intervalo());
+    TEST_ASSERT_EQUAL_INT(1, config_metricas(metricas, 8));
+
+    config_liberar();
+    unsetenv(CONFIG_ENV);
+    unlink(ruta);
+    TEST_ASSERT_EQUAL_INT(0, rmdir(directorio));
+}
+
+void test_prompt(void)
+{
+    char prompt[8192];
+    char original[PATH_MAX];
+    char directorio[] = "/tmp/test_prompt_XXXXXX";
+    char ruta[96];
+    char* quitar[] = {"prompt", "-r"};
+    char* invalidos[] = {"prompt", "estado", "color"};
+    char* elegidos[] = {"prompt", "estado,duracion", "git"};
+    TEST_ASSERT_NOT_NULL(getcwd(original, sizeof(original)));
+    TEST_ASSERT_NOT_NULL(mkdtemp(directorio));
+
+    // Caso 1: Sin segmentos, el prompt es "usuario@host:directorio$ " y sigue al 'cd'
+    TEST_ASSERT_EQUAL_INT(0, manejar_comando_prompt(2, quitar));
+    Ctrl_CD(directorio);
+    size_t largo = prompt_componer(prompt, sizeof(prompt));
+    TEST_ASSERT_EQUAL_size_t(strlen(prompt), largo);
+    TEST_ASSERT_NOT_NULL(strstr(prompt, directorio));
+    TEST_ASSERT_EQUAL_STRING("$ ", prompt + largo - 2);
+
+    // Caso 2: Un segmento desconocido se rechaza; el estado del último comando aparece si falló
+    TEST_ASSERT_EQUAL_INT(2, manejar_comando_prompt(3, invalidos));
+    TEST_ASSERT_EQUAL_INT(0, manejar_comando_prompt(3, elegidos));
+    ultimo_estado = 3;
+    prompt_antes_de_comando();
+    prompt_despues_de_comando();
+    prompt_componer(prompt, sizeof(prompt));
+    TEST_ASSERT_NOT_NULL(strstr(prompt, "[3]"));
+    ultimo_estado = 0;
+    prompt_antes_de_comando();
+    prompt_despues_de_comando();
+
+    // Caso 3: La rama de git se calcula en otro hilo y aparece en un prompt posterior si no llegó a tiempo
+    snprintf(ruta, sizeof(ruta), "%s/.git", directorio);
+    TEST_ASSERT_EQUAL_INT(0, mkdir(ruta, 0700));
+    snprintf(ruta, sizeof(ruta), "%s/.git/HEAD", directorio);
+    FILE* head = fopen(ruta, "w");
+    TEST_ASSERT_NOT_NULL(head);
+    fputs("ref: refs/heads/rama-prueba\n", head);
+    fclose(head);
+    snprintf(ruta, sizeof(ruta), "%s/sub", directorio);
+    TEST_ASSERT_EQUAL_INT(0, mkdir(ruta, 0700));
+    Ctrl_CD(ruta);
+    bool encontrada = false;
+    for (int i = 0; i < 100 && !encontrada; i++)
+    {
+        prompt_componer(prompt, sizeof(prompt));
+        encontrada = strstr(prompt, "(rama-prueba)") != NULL;
+        if (!encontrada)
+            usleep(10000);
+    }
+    TEST_ASSERT_TRUE(encontrada);
+    TEST_ASSERT_NULL(strstr(prompt, "[3]")); // El último comando terminó bien
+
+    Ctrl_CD(original);
+    manejar_comando_prompt(2, quitar);
+    prompt_liberar();
+    rmdir(ruta);
+    snprintf(ruta, sizeof(ruta), "%s/.git/HEAD", directorio);
+    unlink(ruta);
+    snprintf(ruta, sizeof(ruta), "%s/.git", directorio);
+    rmdir(ruta);
+    TEST_ASSERT_EQUAL_INT(0, rmdir(directorio));
+}
+
+/**
+ * @brief Hallazgos recibidos durante test_explorar_config
+ */
+typedef struct
+{
+    char rutas[8][128]; /**< Archivos, relativos al directorio de la prueba */
+    int num_rutas;      /**< Archivos recibidos */
+    int bucles;         /**< Bucles informados */
+    size_t prefijo;     /**< Largo del directorio de la prueba */
+} hallazgos_prueba;
+
+// Guardar cada hallazgo de la exploración
+static bool guardar_hallazgo(const hallazgo* encontrado, void* dato)
+{
+    hallazgos_prueba* h = dato;
+    if (encontrado->tipo == HALLAZGO_BUCLE)
+        h->bucles++;
+    else if (encontrado->tipo == HALLAZGO_ARCHIVO && h->num_rutas < 8)
+        snprintf(h->rutas[h->num_rutas++], sizeof(h->rutas[0]), "%s", encontrado->ruta + h->prefijo);
+    return true;
+}
+
+void test_explorar_config(void)
+{
+    char directorio[] = "/tmp/test_explorar_XXXXXX";
+    const char* archivos[] = {"a.config", "b.json", "x.configx", "sub/c.config", "sub/deep/d.config"};
+    char ruta[96];
+    hallazgos_prueba h;
+    TEST_ASSERT_NOT_NULL(mkdtemp(directorio));
+    snprintf(ruta, sizeof(ruta), "%s/sub", directorio);
+    TEST_ASSERT_EQUAL_INT(0, mkdir(ruta, 0700));
+    snprintf(ruta, sizeof(ruta), "%s/sub/deep", directorio);
+    TEST_ASSERT_EQUAL_INT(0, mkdir(ruta, 0700));
+    for (size_t i = 0; i < sizeof(archivos) / sizeof(archivos[0]); i++)
+    {
+        snprintf(ruta, sizeof(ruta), "%s/%s", directorio, archivos[i]);
+        FILE* archivo = fopen(ruta, "w");
+        TEST_ASSERT_NOT_NULL(archivo);
+        fclose(archivo);
+    }
+    snprintf(ruta, sizeof(ruta), "%s/sub/deep/arriba", directorio);
+    TEST_ASSERT_EQUAL_INT(0, symlink("../..", ruta));
+
+    // Caso 1: Orden estable con uno y con varios trabajadores; ".config" no acepta "x.configx"
+    opciones_exploracion o = {.profundidad_maxima = -1, .extensiones = {".config"}, .num_extensiones = 1};
+    for (int trabajadores = 1; trabajadores <= 4; trabajadores += 3)
+    {
+        memset(&h, 0, sizeof(h));
+        h.prefijo = strlen(directorio) + 1;
+        o.trabajadores = trabajadores;
+        TEST_ASSERT_EQUAL_INT(3, explorar_directorio(directorio, &o, guardar_hallazgo, &h));
+        TEST_ASSERT_EQUAL_STRING("a.config", h.rutas[0]);
+        TEST_ASSERT_EQUAL_STRING("sub/c.config", h.rutas[1]);
+        TEST_ASSERT_EQUAL_STRING("sub/deep/d.config", h.rutas[2]);
+        TEST_ASSERT_EQUAL_INT(0, h.bucles); // Sin -L el enlace no se sigue
+    }
+
+    // Caso 2: Profundidad máxima y patrón glob
+    memset(&h, 0, sizeof(h));
+    h.prefijo = strlen(directorio) + 1;
+    o.profundidad_maxima = 1;
+    TEST_ASSERT_EQUAL_INT(2, explorar_directorio(directorio, &o, guardar_hallazgo, &h));
+    memset(&h, 0, sizeof(h));
+    h.prefijo = strlen(directorio) + 1;
+    opciones_exploracion glob = {.profundidad_maxima = -1, .patron = "*.json"};
+    TEST_ASSERT_EQUAL_INT(1, explorar_directorio(directorio, &glob, guardar_hallazgo, &h));
+    TEST_ASSERT_EQUAL_STRING("b.json", h.rutas[0]);
+
+    // Caso 3: Con -L el enlace a un ancestro se informa como bucle y no se recorre
+    memset(&h, 0, sizeof(h));
+    h.prefijo = strlen(directorio) + 1;
+    o.profundidad_maxima = -1;
+    o.seguir_enlaces = true;
+    TEST_ASSERT_EQUAL_INT(3, explorar_directorio(directorio, &o, guardar_hallazgo, &h));
+    TEST_ASSERT_EQUAL_INT(1, h.bucles);
+
+    unlink(ruta);
+    for (size_t i = sizeof(archivos) / sizeof(archivos[0]); i > 0; i--)
+    {
+        snprintf(ruta, sizeof(ruta), "%s/%s", directorio, archivos[i - 1]);
+        unlink(ruta);
+    }
+    snprintf(ruta, sizeof(ruta), "%s/sub/deep", directorio);
+    rmdir(ruta);
+    snprintf(ruta, sizeof(ruta), "%s/sub", directorio);
+    rmdir(ruta);
+    TEST_ASSERT_EQUAL_INT(0, rmdir(directorio));
+}
+
+// Comparar los archivos que entrega el índice con los del recorrido completo
+static void comparar_con_recorrido(const char* directorio, const opciones_exploracion* o, const hallazgos_prueba* h)
+{
+    hallazgos_prueba recorrido;
+    memset(&recorrido, 0, sizeof(recorrido));
+    recorrido.prefijo = h->prefijo;
+    TEST_ASSERT_EQUAL_INT(h->num_rutas, explorar_directorio(directorio, o, guardar_hallazgo, &recorrido));
+    for (int i = 0; i < h->num_rutas; i++)
+        TEST_ASSERT_EQUAL_STRING(recorrido.rutas[i], h->rutas[i]);
+}
+
+void test_indice_config(void)
+{
+    char directorio[] = "/tmp/test_indice_XXXXXX";
+    char indices[] = "/tmp/test_indices_XXXXXX";
+    const char* rutas[] = {"sub", "sub/deep", "a.config", "b.json", "sub/c.config", "sub/deep/d.config"};
+    char ruta[96];
+    hallazgos_prueba h;
+    resumen_indice resumen;
+    TEST_ASSERT_NOT_NULL(mkdtemp(directorio));
+    TEST_ASSERT_NOT_NULL(mkdtemp(indices));
+    setenv(INDICE_ENV, indices, 1);
+    for (size_t i = 0; i < sizeof(rutas) / sizeof(rutas[0]); i++)
+    {
+        snprintf(ruta, sizeof(ruta), "%s/%s", directorio, rutas[i]);
+        if (i < 2)
+            TEST_ASSERT_EQUAL_INT(0, mkdir(ruta, 0700));
+        else
+        {
+            FILE* archivo = fopen(ruta, "w");
+            TEST_ASSERT_NOT_NULL(archivo);
+            fputs(rutas[i], archivo);
+            fclose(archivo);
+        }
+    }
+
+    // Modificaciones antiguas: st_mtim alcanza para confiar en que no cambiaron
+    struct timespec antes[2] = {{1000000000, 0}, {1000000000, 0}};
+    for (size_t i = sizeof(rutas) / sizeof(rutas[0]); i > 0; i--)
+    {
+        snprintf(ruta, sizeof(ruta), "%s/%s", directorio, rutas[i - 1]);
+        utimensat(AT_FDCWD, ruta, antes, 0);
+    }
+    utimensat(AT_FDCWD, directorio, antes, 0);
+
+    // Caso 1: Sin índice se recorre todo el árbol y se entrega lo mismo que explorar_directorio()
+    opciones_exploracion o = {.profundidad_maxima = -1, .extensiones = {".config"}, .num_extensiones = 1};
+    memset(&h, 0, sizeof(h));
+    h.prefijo = strlen(directorio) + 1;
+    TEST_ASSERT_EQUAL_INT(3, indice_explorar(directorio, &o, false, guardar_hallazgo, &h, &resumen));
+    TEST_ASSERT_TRUE(resumen.reconstruido);
+    comparar_con_recorrido(directorio, &o, &h);
+
+    // Caso 2: Sin cambios la consulta se responde desde la memoria, sin leer ningún directorio
+    memset(&h, 0, sizeof(h));
+    h.prefijo = strlen(directorio) + 1;
+    TEST_ASSERT_EQUAL_INT(3, indice_explorar(directorio, &o, false, guardar_hallazgo, &h, &resumen));
+    TEST_ASSERT_FALSE(resumen.reconstruido);
+    TEST_ASSERT_EQUAL_INT(0, resumen.releidos);
+    comparar_con_recorrido(directorio, &o, &h);
+
+    // Caso 3: Un archivo nuevo se ve en la consulta siguiente, releyendo sólo su directorio
+    snprintf(ruta, sizeof(ruta), "%s/sub/e.config", directorio);
+    FILE* nuevo = fopen(ruta, "w");
+    TEST_ASSERT_NOT_NULL(nuevo);
+    fclose(nuevo);
+    memset(&h, 0, sizeof(h));
+    h.prefijo = strlen(directorio) + 1;
+    TEST_ASSERT_EQUAL_INT(4, indice_explorar(directorio, &o, false, guardar_hallazgo, &h, &resumen));
+    TEST_ASSERT_EQUAL_INT(1, resumen.releidos);
+    comparar_con_recorrido(directorio, &o, &h);
+
+    // Caso 4: Otro shell carga el índice del disco y lo revalida; un directorio borrado desaparece
+    indice_liberar();
+    snprintf(ruta, sizeof(ruta), "%s/sub/deep/d.config", directorio);
+    TEST_ASSERT_EQUAL_INT(0, unlink(ruta));
+    snprintf(ruta, sizeof(ruta), "%s/sub/deep", directorio);
+    TEST_ASSERT_EQUAL_INT(0, rmdir(ruta));
+    memset(&h, 0, sizeof(h));
+    h.prefijo = strlen(directorio) + 1;
+    TEST_ASSERT_EQUAL_INT(3, indice_explorar(directorio, &o, false, guardar_hallazgo, &h, &resumen));
+    TEST_ASSERT_TRUE(resumen.desde_disco);
+    TEST_ASSERT_FALSE(resumen.reconstruido);
+    comparar_con_recorrido(directorio, &o, &h);
+    TEST_ASSERT_EQUAL_STRING("sub/e.config", h.rutas[2]);
+
+    indice_liberar();
+    unsetenv(INDICE_ENV);
+    DIR* dir = opendir(indices);
+    TEST_ASSERT_NOT_NULL(dir);
+    const struct dirent* e;
+    while ((e = readdir(dir)) != NULL)
+    {
+        if (e->d_name[0] != '.')
+            unlinkat(dirfd(dir), e->d_name, 0);
+    }
+    closedir(dir);
+    TEST_ASSERT_EQUAL_INT(0, rmdir(indices));
+    const char* restos[] = {"sub/e.config", "sub/c.config", "b.json", "a.config", "sub"};
+    for (size_t i = 0; i < sizeof(restos) / sizeof(restos[0]); i++)
+    {
+        snprintf(ruta, sizeof(ruta), "%s/%s", directorio, restos[i]);
+        TEST_ASSERT_EQUAL_INT(0, remove(ruta));
+    }
+    TEST_ASSERT_EQUAL_INT(0, rmdir(directorio));
+}
+
+// Volcar una entrada en un archivo en memoria y devolver lo que quedó escrito (terminado en '\0')
+static char* volcar_a_memoria(int entrada, modo_volcado modo, long lineas)
+{
+    static char leido[262144];
+    int salida = memfd_create("volcado", MFD_CLOEXEC);
+    TEST_ASSERT_NOT_EQUAL(-1, salida);
+    TEST_ASSERT_EQUAL_INT(VOLCADO_COMPLETO, volcar_descriptor(entrada, salida, modo, lineas));
+    ssize_t leidos = pread(salida, leido, sizeof(leido) - 1, 0);
+    TEST_ASSERT_TRUE(leidos >= 0);
+    leido[leidos] = '\0';
+    close(salida);
+    return leido;
+}
+
+void test_volcado(void)
+{
+    char ruta[] = "/tmp/test_volcado_XXXXXX";
+    int fd = mkstemp(ruta);
+    TEST_ASSERT_NOT_EQUAL(-1, fd);
+    unlink(ruta);
+    const char texto[] = "uno\ndos\ntres\ncuatro\n";
+    TEST_ASSERT_EQUAL_INT((int)strlen(texto), (int)write(fd, texto, strlen(texto)));
+
+    // Caso 1: Archivo regular completo, primeras y últimas líneas; la posición queda después de lo volcado
+    lseek(fd, 0, SEEK_SET);
+    TEST_ASSERT_EQUAL_STRING(texto, volcar_a_memoria(fd, VOLCAR_TODO, 0));
+    TEST_ASSERT_EQUAL_INT((int)strlen(texto), (int)lseek(fd, 0, SEEK_CUR));
+    lseek(fd, 0, SEEK_SET);
+    TEST_ASSERT_EQUAL_STRING("uno\ndos\n", volcar_a_memoria(fd, VOLCAR_PRIMERAS, 2));
+    TEST_ASSERT_EQUAL_STRING("tres\n", volcar_a_memoria(fd, VOLCAR_PRIMERAS, 1)); // Sigue desde donde quedó
+    lseek(fd, 0, SEEK_SET);
+    TEST_ASSERT_EQUAL_STRING("tres\ncuatro\n", volcar_a_memoria(fd, VOLCAR_ULTIMAS, 2));
+    lseek(fd, 0, SEEK_SET);
+    TEST_ASSERT_EQUAL_STRING(texto, volcar_a_memoria(fd, VOLCAR_ULTIMAS, 10));
+    lseek(fd, 0, SEEK_SET);
+    TEST_ASSERT_EQUAL_STRING("", volcar_a_memoria(fd, VOLCAR_PRIMERAS, 0));
+
+    // Caso 2: Sin salto de línea final la última línea también cuenta
+    TEST_ASSERT_EQUAL_INT(0, ftruncate(fd, (off_t)strlen(texto) - 1));
+    lseek(fd, 0, SEEK_SET);
+    TEST_ASSERT_EQUAL_STRING("cuatro", volcar_a_memoria(fd, VOLCAR_ULTIMAS, 1));
+
+    // Caso 3: Las últimas líneas ocupan varios bloques de lectura
+    TEST_ASSERT_EQUAL_INT(0, ftruncate(fd, 0));
+    lseek(fd, 0, SEEK_SET);
+    char linea[16];
+    for (int i = 0; i < 20000; i++)
+    {
+        snprintf(linea, sizeof(linea), "linea %05d\n", i);
+        TEST_ASSERT_EQUAL_INT(12, (int)write(fd, linea, strlen(linea)));
+    }
+    lseek(fd, 0, SEEK_SET);
+    const char* ultimas = volcar_a_memoria(fd, VOLCAR_ULTIMAS, 15000);
+    TEST_ASSERT_EQUAL_INT(15000 * 12, (int)strlen(ultimas));
+    TEST_ASSERT_EQUAL_INT(0, strncmp(ultimas, "linea 05000\n", 12));
+    close(fd);
+
+    // Caso 4: Un pipe, completo (splice()), primeras y últimas líneas
+    for (modo_volcado modo = VOLCAR_TODO; modo <= VOLCAR_ULTIMAS; modo++)
+    {
+        const char* esperado[] = {texto, "uno\n", "cuatro\n"};
+        int tubo[2];
+        TEST_ASSERT_EQUAL_INT(0, pipe(tubo));
+        TEST_ASSERT_EQUAL_INT((int)strlen(texto), (int)write(tubo[1], texto, strlen(texto)));
+        close(tubo[1]);
+        TEST_ASSERT_EQUAL_STRING(esperado[modo], volcar_a_memoria(tubo[0], modo, 1));
+        close(tubo[0]);
+    }
+}
+
+// Ejecutar 'buscar_config' con la salida estándar dirigida a un archivo en memoria; devuelve lo que escribió
+static char* ejecutar_busqueda(char** argv, int* estado)
+{
+    static char leido[4096];
+    int argc = 0;
+    while (argv[argc] != NULL)
+        argc++;
+    int salida = memfd_create("busqueda", MFD_CLOEXEC);
+    TEST_ASSERT_NOT_EQUAL(-1, salida);
+    fflush(stdout);
+    int original = dup(STDOUT_FILENO);
+    dup2(salida, STDOUT_FILENO);
+    *estado = manejar_comando_buscar_config(argc, argv);
+    fflush(stdout);
+    dup2(original, STDOUT_FILENO);
+    close(original);
+    ssize_t leidos = pread(salida, leido, sizeof(leido) - 1, 0);
+    TEST_ASSERT_TRUE(leidos >= 0);
+    leido[leidos] = '\0';
+    close(salida);
+    return leido;
+}
+
+void test_buscar_config(void)
+{
+    // Caso 1: Cada núcleo encuentra lo mismo que una búsqueda ingenua, con la aguja en cualquier posición
+    char texto[160];
+    const char* agujas[] = {"x", "xy", "xyz", "abcdefghijklmnopqrstuvwxyz0123456789"};
+    for (int nivel = BUSQUEDA_ESCALAR; nivel <= (int)busqueda_nivel_disponible(); nivel++)
+    {
+        for (size_t a = 0; a < sizeof(agujas) / sizeof(agujas[0]); a++)
+        {
+            size_t largo_aguja = strlen(agujas[a]);
+            for (size_t posicion = 0; posicion + largo_aguja <= 100; posicion++)
+            {
+                // Con un relleno igual al primer byte de la aguja, cada posición es candidata
+                memset(texto, largo_aguja > 1 ? agujas[a][0] : '-', sizeof(texto));
+                memcpy(texto + posicion, agujas[a], largo_aguja);
+                size_t largo = posicion + largo_aguja + (posicion % 7);
+                const char* esperado = NULL;
+                for (size_t i = 0; esperado == NULL && i + largo_aguja <= largo; i++)
+                {
+                    if (memcmp(texto + i, agujas[a], largo_aguja) == 0)
+                        esperado = texto + i;
+                }
+                TEST_ASSERT_EQUAL_PTR(esperado,
+                                      buscar_subcadena((nivel_busqueda)nivel, texto, largo, agujas[a], largo_aguja));
+                TEST_ASSERT_NULL(buscar_subcadena((nivel_busqueda)nivel, texto, largo_aguja - 1, agujas[a],
+                                                  largo_aguja));
+            }
+        }
+        for (size_t largo = 0; largo < sizeof(texto); largo += 13)
+        {
+            size_t saltos = 0;
+            for (size_t i = 0; i < largo; i++)
+            {
+                texto[i] = i % 3 == 0 ? '\n' : 'a';
+                saltos += texto[i] == '\n';
+            }
+            TEST_ASSERT_EQUAL_UINT64(saltos, contar_byte((nivel_busqueda)nivel, texto, largo, '\n'));
+        }
+    }
+
+    // Caso 2: Salida del comando en orden de recorrido, con literales y expresiones
+    char directorio[] = "/tmp/test_buscar_XXXXXX";
+    char ruta[96];
+    TEST_ASSERT_NOT_NULL(mkdtemp(directorio));
+    snprintf(ruta, sizeof(ruta), "%s/a.config", directorio);
+    FILE* archivo = fopen(ruta, "w");
+    TEST_ASSERT_NOT_NULL(archivo);
+    fputs("clave=1\nport = 8080\n# port\nport=9090", archivo); // Sin salto de línea final
+    fclose(archivo);
+    snprintf(ruta, sizeof(ruta), "%s/b.config", directorio);
+    archivo = fopen(ruta, "w");
+    TEST_ASSERT_NOT_NULL(archivo);
+    fputs("\nportal\n", archivo);
+    fclose(archivo);
+
+    struct
+    {
+        bool expresion;
+        const char* texto;
+        const char* esperado;
+        int estado;
+    } casos[] = {
+        {false, "port", "a.config:2:port = 8080\na.config:3:# port\na.config:4:port=9090\nb.config:2:portal\n", 0},
+        {true, "^port *=", "a.config:2:port = 8080\na.config:4:port=9090\n", 0},
+        {true, "p.rt$", "a.config:3:# port\n", 0},
+        {true, "=.*0$", "a.config:2:port = 8080\na.config:4:port=9090\n", 0},
+        {true, "^$", "b.config:1:\n", 0},
+        {false, "ausente", "", 1},
+    };
+    char prefijo[sizeof(directorio) + 1];
+    snprintf(prefijo, sizeof(prefijo), "%s/", directorio);
+    for (size_t i = 0; i < sizeof(casos) / sizeof(casos[0]); i++)
+    {
+        char* argv[] = {"buscar_config", "-n", casos[i].expresion ? "-x" : "--", (char*)casos[i].texto, directorio,
+                        NULL};
+        int estado;
+        char* salida = ejecutar_busqueda(argv, &estado);
+        TEST_ASSERT_EQUAL_INT(casos[i].estado, estado);
+
+        // Quitar el directorio temporal de cada línea antes de comparar
+        char sin_prefijo[4096] = "";
+        for (char* linea = salida; *linea != '\0';)
+        {
+            TEST_ASSERT_EQUAL_INT(0, strncmp(linea, prefijo, strlen(prefijo)));
+            linea += strlen(prefijo);
+            char* fin = strchr(linea, '\n');
+            TEST_ASSERT_NOT_NULL(fin);
+            strncat(sin_prefijo, linea, (size_t)(fin - linea) + 1);
+            linea = fin + 1;
+        }
+        TEST_ASSERT_EQUAL_STRING(casos[i].esperado, sin_prefijo);
+    }
+
+    char* argv[] = {"buscar_config", NULL};
+    int estado;
+    ejecutar_busqueda(argv, &estado);
+    TEST_ASSERT_EQUAL_INT(2, estado);
+
+    snprintf(ruta, sizeof(ruta), "%s/a.config", directorio);
+    TEST_ASSERT_EQUAL_INT(0, unlink(ruta));
+    snprintf(ruta, sizeof(ruta), "%s/b.config", directorio);
+    TEST_ASSERT_EQUAL_INT(0, unlink(ruta));
+    TEST_ASSERT_EQUAL_INT(0, rmdir(directorio));
+}
+
+// Leer un archivo de texto completo en un buffer; devuelve "" si no existe
+static const char* leer_archivo_prueba(const char* ruta, char* buffer, size_t tam)
+{
+    buffer[0] = '\0';
+    FILE* archivo = fopen(ruta, "r");
+    if (archivo != NULL)
+    {
+        size_t leidos = fread(buffer, 1, tam - 1, archivo);
+        buffer[leidos] = '\0';
+        fclose(archivo);
+    }
+    return buffer;
+}
+
+// Prueba de las redirecciones
+void test_redirecciones(void)
+{
+    arena a;
+    lista_comandos* lista;
+    char error[256];
+    arena_inicializar(&a);
+
+    // Caso 1: Operadores, descriptores por omisión y destinos
+    const char* linea = "cmd 2>&1 <>rw 3<&- &>todo &>>mas 4>&2";
+    TEST_ASSERT_EQUAL_INT(PARSEO_OK, parsear_comandos(&a, linea, strlen(linea), 1, &lista, error, sizeof(error)));
+    const struct
+    {
+        tipo_redireccion tipo;
+        int fd;
+        const char* destino;
+    } esperadas[] = {{REDIR_DUPLICAR, 2, "1"},          {REDIR_LECTURA_ESCRITURA, 0, "rw"},
+                     {REDIR_DUPLICAR, 3, "-"},          {REDIR_SALIDA_Y_ERRORES, 1, "todo"},
+                     {REDIR_AGREGAR_Y_ERRORES, 1, "mas"}, {REDIR_DUPLICAR, 4, "2"}};
+    const redireccion* r = lista->pipelines[0].etapas[0].redirecciones;
+    for (size_t i = 0; i < sizeof(esperadas) / sizeof(esperadas[0]); i++, r = r->siguiente)
+    {
+        TEST_ASSERT_NOT_NULL(r);
+        TEST_ASSERT_EQUAL_INT(esperadas[i].tipo, r->tipo);
+        TEST_ASSERT_EQUAL_INT(esperadas[i].fd, r->fd);
+        TEST_ASSERT_EQUAL_STRING(esperadas[i].destino, r->destino.texto);
+    }
+    TEST_ASSERT_NULL(r);
+    TEST_ASSERT_EQUAL_INT(1, lista->pipelines[0].etapas[0].num_palabras);
+    arena_liberar(&a);
+
+    // Caso 2: Un comando interno con redirecciones no cambia los descriptores ni los flujos del shell
+    char directorio[] = "/tmp/test_redir_XXXXXX";
+    char comando[256];
+    char contenido[256];
+    char ruta[96];
+    TEST_ASSERT_NOT_NULL(mkdtemp(directorio));
+    struct stat antes;
+    struct stat despues;
+    FILE* salida_original = stdout;
+    TEST_ASSERT_EQUAL_INT(0, fstat(STDOUT_FILENO, &antes));
+    snprintf(comando, sizeof(comando), "echo uno dos > %s/interno 2>&1; echo tres &>> %s/interno", directorio,
+             directorio);
+    analizar_comando(comando);
+    TEST_ASSERT_EQUAL_INT(0, fstat(STDOUT_FILENO, &despues));
+    TEST_ASSERT_TRUE(antes.st_ino == despues.st_ino && antes.st_dev == despues.st_dev);
+    TEST_ASSERT_EQUAL_PTR(salida_original, stdout);
+    snprintf(ruta, sizeof(ruta), "%s/interno", directorio);
+    TEST_ASSERT_EQUAL_STRING("uno dos\ntres\n", leer_archivo_prueba(ruta, contenido, sizeof(contenido)));
+
+    // Caso 3: Duplicaciones sobre un descriptor abierto por la misma línea, en un interno y en un programa externo
+    snprintf(comando, sizeof(comando), "echo cuatro 3>%s/tres 1>&3", directorio);
+    analizar_comando(comando);
+    snprintf(ruta, sizeof(ruta), "%s/tres", directorio);
+    TEST_ASSERT_EQUAL_STRING("cuatro\n", leer_archivo_prueba(ruta, contenido, sizeof(contenido)));
+    snprintf(comando, sizeof(comando), "sh -c 'echo out; echo err >&2' > %s/externo 2>&1", directorio);
+    analizar_comando(comando);
+    snprintf(ruta, sizeof(ruta), "%s/externo", directorio);
+    TEST_ASSERT_EQUAL_STRING("out\nerr\n", leer_archivo_prueba(ruta, contenido, sizeof(contenido)));
+    TEST_ASSERT_EQUAL_INT(0, ultimo_estado);
+
+    // Caso 4: '<>' no trunca el archivo y un descriptor inválido impide ejecutar el comando
+    snprintf(comando, sizeof(comando), "sh -c 'printf XY >&3' 3<>%s/externo", directorio);
+    analizar_comando(comando);
+    TEST_ASSERT_EQUAL_STRING("XYt\nerr\n", leer_archivo_prueba(ruta, contenido, sizeof(contenido)));
+    snprintf(comando, sizeof(comando), "echo nada > %s/invalido 1>&9", directorio);
+    analizar_comando(comando);
+    TEST_ASSERT_EQUAL_INT(1, ultimo_estado);
+    snprintf(ruta, sizeof(ruta), "%s/invalido", directorio);
+    TEST_ASSERT_EQUAL_STRING("", leer_archivo_prueba(ruta, contenido, sizeof(contenido)));
+    analizar_comando("echo nada >&archivo");
+    TEST_ASSERT_EQUAL_INT(1, ultimo_estado);
+
+    const char* nombres[] = {"interno", "tres", "externo", "invalido"};
+    for (size_t i = 0; i < sizeof(nombres) / sizeof(nombres[0]); i++)
+    {
+        snprintf(ruta, sizeof(ruta), "%s/%s", directorio, nombres[i]);
+        unlink(ruta);
+    }
+    rmdir(directorio);
+}
+
+// Prueba de la higiene de la tabla de descriptores
+void test_descriptores(void)
+{
+    tabla_descriptores antes;
+    tabla_descriptores despues;
+
+    // Caso 1: Un descriptor nuevo y sin FD_CLOEXEC es un problema; con FD_CLOEXEC lo es sólo por ser nuevo
+    TEST_ASSERT_EQUAL_INT(0, tabla_descriptores_leer(&antes));
+    int base = tabla_descriptores_comparar(NULL, &antes, NULL); // Lo que ya heredó el proceso de las pruebas
+    int fuga = open("/dev/null", O_RDONLY);
+    TEST_ASSERT_TRUE(fuga > STDERR_FILENO);
+    TEST_ASSERT_EQUAL_INT(0, tabla_descriptores_leer(&despues));
+    TEST_ASSERT_EQUAL_INT(base + 1, tabla_descriptores_comparar(&antes, &despues, NULL));
+    TEST_ASSERT_EQUAL_INT(base + 1, tabla_descriptores_comparar(NULL, &despues, NULL));
+    tabla_descriptores_liberar(&despues);
+    fcntl(fuga, F_SETFD, FD_CLOEXEC);
+    TEST_ASSERT_EQUAL_INT(0, tabla_descriptores_leer(&despues));
+    TEST_ASSERT_EQUAL_INT(base + 1, tabla_descriptores_comparar(&antes, &despues, NULL));
+    TEST_ASSERT_EQUAL_INT(base, tabla_descriptores_comparar(NULL, &despues, NULL));
+    tabla_descriptores_liberar(&despues);
+    close(fuga);
+
+    // Caso 2: Comandos internos, pipes y redirecciones no dejan descriptores abiertos
+    const char* lineas[] = {"echo hola > /dev/null",
+                            "echo a | cat > /dev/null",
+                            "echo b | sh -c cat 2>&1 | cat > /dev/null",
+                            "echo c 3>/dev/null 1>&3",
+                            "pipestatus 2>&1 | cat >/dev/null",
+                            "ls /archivo_que_no_existe 2>/dev/null",
+                            "echo d > /directorio_que_no_existe/archivo",
+                            "fdcheck echo e > /dev/null"};
+    for (size_t i = 0; i < sizeof(lineas) / sizeof(lineas[0]); i++)
+    {
+        char linea[128];
+        snprintf(linea, sizeof(linea), "%s", lineas[i]);
+        analizar_comando(linea);
+        TEST_ASSERT_EQUAL_INT(0, tabla_descriptores_leer(&despues));
+        TEST_ASSERT_EQUAL_INT_MESSAGE(base, tabla_descriptores_comparar(&antes, &despues, stderr), lineas[i]);
+        tabla_descriptores_liberar(&despues);
+    }
+    tabla_descriptores_liberar(&antes);
+
+    // Caso 3: Un descriptor sin FD_CLOEXEC no llega al hijo; uno que el plan pone en su lugar, sí
+    fuga = fcntl(STDIN_FILENO, F_DUPFD, 20);
+    TEST_ASSERT_TRUE(fuga >= 20);
+    char linea[160];
+    snprintf(linea, sizeof(linea), "sh -c 'test ! -e /proc/$$/fd/%d && test -e /proc/$$/fd/3' 3</dev/null", fuga);
+    analizar_comando(linea);
+    TEST_ASSERT_EQUAL_INT(0, ultimo_estado);
+    close(fuga);
+}
+
+// Prueba del compilador de bytecode y de la máquina virtual
+void test_interprete(void)
+{
+    // Caso 1: Las estructuras de control y las funciones se ejecutan en el shell y dejan sus variables
+    const char* lineas[] = {"suma=; for i in a b c; do suma=$suma$i; done",
+                            "if false; then rama=if; elif true; then rama=elif; else rama=else; fi",
+                            "n=a; while test $n != aaa; do n=${n}a; done",
+                            "for w in 1 2 3; do case $w in 1) c1=$w ;; 2|3) c2=$c2$w; continue ;; esac; done",
+                            "for i in 1 2; do for j in x y; do test $j = y && continue 2; par=$par$i$j; done; done",
+                            "doble() { resultado=$1$1; return 3; }; doble ab",
+                            "false && y=si || o=si; ! false && negado=si"};
+    for (size_t i = 0; i < sizeof(lineas) / sizeof(lineas[0]); i++)
+    {
+        char linea[160];
+        snprintf(linea, sizeof(linea), "%s", lineas[i]);
+        analizar_comando(linea);
+    }
+    TEST_ASSERT_EQUAL_STRING("abc", variable_buscar("suma"));
+    TEST_ASSERT_EQUAL_STRING("elif", variable_buscar("rama"));
+    TEST_ASSERT_EQUAL_STRING("aaa", variable_buscar("n"));
+    TEST_ASSERT_EQUAL_STRING("1", variable_buscar("c1"));
+    TEST_ASSERT_EQUAL_STRING("23", variable_buscar("c2"));
+    TEST_ASSERT_EQUAL_STRING("1x2x", variable_buscar("par"));
+    TEST_ASSERT_EQUAL_STRING("abab", variable_buscar("resultado"));
+    TEST_ASSERT_NULL(variable_buscar("y"));
+    TEST_ASSERT_EQUAL_STRING("si", variable_buscar("o"));
+    TEST_ASSERT_EQUAL_STRING("si", variable_buscar("negado"));
+    TEST_ASSERT_EQUAL_INT(0, ultimo_estado);
+    char llamada[] = "doble x";
+    analizar_comando(llamada);
+    TEST_ASSERT_EQUAL_INT(3, ultimo_estado);
+
+    // Caso 2: break fuera de un ciclo no compila
+    arena a;
+    lista_comandos* lista;
+    programa p;
+    char error[256];
+    arena_inicializar(&a);
+    const char* texto = "echo antes; break";
+    TEST_ASSERT_EQUAL_INT(PARSEO_OK, parsear_comandos(&a, texto, strlen(texto), 1, &lista, error, sizeof(error)));
+    TEST_ASSERT_EQUAL_INT(-1, compilar_lista(lista, &a, &p, error, sizeof(error)));
+    TEST_ASSERT_NOT_NULL(strstr(error, "break"));
+
+    // Caso 3: Un programa compilado se abre desde una copia; una copia alterada se rechaza
+    texto = "for i in 1 2; do if test $i = 1; then echo $i > /dev/null; fi; done";
+    TEST_ASSERT_EQUAL_INT(PARSEO_OK, parsear_comandos(&a, texto, strlen(texto), 1, &lista, error, sizeof(error)));
+    TEST_ASSERT_EQUAL_INT(0, compilar_lista(lista, &a, &p, error, sizeof(error)));
+    uint64_t* copia = malloc(p.largo);
+    TEST_ASSERT_NOT_NULL(copia);
+    memcpy(copia, p.cabecera, p.largo);
+    programa abierto;
+    TEST_ASSERT_EQUAL_INT(0, programa_abrir(copia, p.largo, &abierto));
+    TEST_ASSERT_EQUAL_INT(p.cabecera->num_instrucciones, abierto.cabecera->num_instrucciones);
+    TEST_ASSERT_EQUAL_INT(-1, programa_abrir(copia, p.largo - 8, &abierto));
+
+    cabecera_programa* cabecera = (cabecera_programa*)copia;
+    cabecera->magia ^= 1;
+    TEST_ASSERT_EQUAL_INT(-1, programa_abrir(copia, p.largo, &abierto));
+    cabecera->magia ^= 1;
+
+    size_t desplazamiento = (size_t)((const char*)p.instrucciones - (const char*)p.cabecera);
+    instruccion* instrucciones = (instruccion*)((char*)copia + desplazamiento);
+    for (uint32_t i = 0; i < cabecera->num_instrucciones; i++)
+    {
+        if (instrucciones[i].op == OP_SALTAR)
+        {
+            instrucciones[i].a = cabecera->num_instrucciones + 5;
+            break;
+        }
+    }
+    TEST_ASSERT_EQUAL_INT(-1, programa_abrir(copia, p.largo, &abierto));
+
+    free(copia);
+    arena_liberar(&a);
+}
+
+// Escribir un script de prueba con una fecha de modificación antigua, para que su caché se guarde
+static void escribir_script_antiguo(const char* ruta, const char* texto, time_t modificado)
+{
+    FILE* f = fopen(ruta, "w");
+    TEST_ASSERT_NOT_NULL(f);
+    fputs(texto, f);
+    fclose(f);
+    struct timespec tiempos[2] = {{modificado, 0}, {modificado, 0}};
+    TEST_ASSERT_EQUAL_INT(0, utimensat(AT_FDCWD, ruta, tiempos, 0));
+}
+
+// Ruta del único archivo de caché de un directorio; false si no hay exactamente uno
+static bool unica_cache(const char* directorio, char* ruta, size_t tam)
+{
+    int cantidad = 0;
+    DIR* d = opendir(directorio);
+    if (d == NULL)
+        return false;
+    struct dirent* entrada;
+    while ((entrada = readdir(d)) != NULL)
+    {
+        if (entrada->d_name[0] != '.')
+        {
+            snprintf(ruta, tam, "%s/%s", directorio, entrada->d_name);
+            cantidad++;
+        }
+    }
+    closedir(d);
+    return cantidad == 1;
+}
+
+// Prueba de la caché de scripts compilados
+void test_cache_scripts(void)
+{
+    char directorio[] = "/tmp/test_cache_XXXXXX";
+    TEST_ASSERT_NOT_NULL(mkdtemp(directorio));
+    char caches[64];
+    char script[64];
+    char archivo[128];
+    snprintf(caches, sizeof(caches), "%s/caches", directorio);
+    snprintf(script, sizeof(script), "%s/script.sh", directorio);
+    setenv(CACHE_SCRIPTS_ENV, caches, 1);
+    time_t antiguo = time(NULL) - 3600;
+
+    // Caso 1: La primera ejecución guarda la caché y la segunda se ejecuta desde ella
+    escribir_script_antiguo(script, "valor_cache=uno\nfor i in a b; do valor_cache=$valor_cache$i; done\n", antiguo);
+    TEST_ASSERT_EQUAL_INT(0, ejecutar_script(script));
+    TEST_ASSERT_EQUAL_STRING("unoab", variable_buscar("valor_cache"));
+    TEST_ASSERT_TRUE(unica_cache(caches, archivo, sizeof(archivo)));
+
+    struct stat info;
+    cache_script cache;
+    unidad_cacheada u;
+    TEST_ASSERT_EQUAL_INT(0, stat(script, &info));
+    TEST_ASSERT_EQUAL_INT(0, cache_abrir(script, &info, &cache));
+    TEST_ASSERT_EQUAL_INT(2, cache.lineas);
+    TEST_ASSERT_TRUE(cache_siguiente(&cache, &u));
+    TEST_ASSERT_EQUAL_INT(UNIDAD_COMANDOS, u.tipo);
+    TEST_ASSERT_TRUE(cache_siguiente(&cache, &u));
+    TEST_ASSERT_EQUAL_INT(2, u.linea);
+    TEST_ASSERT_FALSE(cache_siguiente(&cache, &u));
+    cache_cerrar(&cache);
+
+    variable_eliminar("valor_cache");
+    TEST_ASSERT_EQUAL_INT(0, ejecutar_script(script));
+    TEST_ASSERT_EQUAL_STRING("unoab", variable_buscar("valor_cache"));
+
+    // Caso 2: Una caché dañada se borra y la ejecución siguiente la vuelve a generar
+    int fd = open(archivo, O_RDWR);
+    TEST_ASSERT_NOT_EQUAL(-1, fd);
+    off_t tamano = lseek(fd, 0, SEEK_END);
+    unsigned char byte;
+    TEST_ASSERT_EQUAL_INT(1, (int)pread(fd, &byte, 1, tamano / 2));
+    byte ^= 0x5a;
+    TEST_ASSERT_EQUAL_INT(1, (int)pwrite(fd, &byte, 1, tamano / 2));
+    close(fd);
+    TEST_ASSERT_EQUAL_INT(-1, cache_abrir(script, &info, &cache));
+    TEST_ASSERT_NOT_EQUAL(0, access(archivo, F_OK));
+    TEST_ASSERT_EQUAL_INT(0, ejecutar_script(script));
+    TEST_ASSERT_EQUAL_INT(0, cache_abrir(script, &info, &cache));
+    cache_cerrar(&cache);
+
+    // Caso 3: Un script modificado no usa la caché anterior
+    const char* modificado = "valor_cache=dos\nfor i in a b; do valor_cache=$valor_cache$i; done\n";
+    escribir_script_antiguo(script, modificado, antiguo + 1);
+    TEST_ASSERT_EQUAL_INT(0, stat(script, &info));
+    TEST_ASSERT_EQUAL_INT(-1, cache_abrir(script, &info, &cache));
+    TEST_ASSERT_EQUAL_INT(0, ejecutar_script(script));
+    TEST_ASSERT_EQUAL_STRING("dosab", variable_buscar("valor_cache"));
+
+    // Caso 4: source ejecuta el archivo en el shell, con sus propios parámetros posicionales
+    escribir_script_antiguo(script, "valor_cache=\"$1 $#\"\nfalse\n", antiguo);
+    char linea[128];
+    snprintf(linea, sizeof(linea), "source %s uno dos", script);
+    analizar_comando(linea);
+    TEST_ASSERT_EQUAL_INT(1, ultimo_estado);
+    TEST_ASSERT_EQUAL_STRING("uno 2", variable_buscar("valor_cache"));
+    snprintf(linea, sizeof(linea), "source %s/no_existe", directorio);
+    analizar_comando(linea);
+    TEST_ASSERT_EQUAL_INT(1, ultimo_estado);
+
+    variable_eliminar("valor_cache");
+    unsetenv(CACHE_SCRIPTS_ENV);
+    if (unica_cache(caches, archivo, sizeof(archivo)))
+        unlink(archivo);
+    rmdir(caches);
+    unlink(script);
+    rmdir(directorio);
+}
+
+// Ejecutar una utilidad interna con la salida estándar dirigida a un archivo en memoria; devuelve lo que escribió
+static char* ejecutar_utilidad(manejador_builtin manejador, char** argv, int* estado)
+{
+    static char leido[4096];
+    int argc = 0;
+    while (argv[argc] != NULL)
+        argc++;
+    int salida = memfd_create("utilidad", MFD_CLOEXEC);
+    TEST_ASSERT_NOT_EQUAL(-1, salida);
+    fflush(stdout);
+    int original = dup(STDOUT_FILENO);
+    dup2(salida, STDOUT_FILENO);
+    *estado = manejador(argc, argv);
+    fflush(stdout);
+    dup2(original, STDOUT_FILENO);
+    close(original);
+    ssize_t leidos = pread(salida, leido, sizeof(leido) - 1, 0);
+    TEST_ASSERT_TRUE(leidos >= 0);
+    leido[leidos] = '\0';
+    close(salida);
+    return leido;
+}
+
+// Prueba de las versiones internas de las utilidades
+void test_utilidades_internas(void)
+{
+    char directorio[] = "/tmp/test_utilidades_XXXXXX";
+    TEST_ASSERT_NOT_NULL(mkdtemp(directorio));
+    char a[64];
+    char b[64];
+    char falta[64];
+    char esperado[256];
+    snprintf(a, sizeof(a), "%s/a", directorio);
+    snprintf(b, sizeof(b), "%s/b", directorio);
+    snprintf(falta, sizeof(falta), "%s/falta", directorio);
+    FILE* f = fopen(a, "w");
+    TEST_ASSERT_NOT_NULL(f);
+    fputs("uno\ndos\ntres\n", f);
+    fclose(f);
+    f = fopen(b, "w");
+    TEST_ASSERT_NOT_NULL(f);
+    fputs("cuatro", f); // Sin salto de línea final
+    fclose(f);
+    int estado;
+
+    // Caso 1: cat concatena los archivos y sigue después de uno que no existe
+    char* cat[] = {"cat", a, falta, b, NULL};
+    TEST_ASSERT_EQUAL_STRING("uno\ndos\ntres\ncuatro", ejecutar_utilidad(manejar_comando_cat, cat, &estado));
+    TEST_ASSERT_EQUAL_INT(1, estado);
+
+    // Caso 2: wc con una sola columna no alinea; con varias, el ancho es el de la suma de los tamaños
+    char* wc_l[] = {"wc", "-l", a, NULL};
+    snprintf(esperado, sizeof(esperado), "3 %s\n", a);
+    TEST_ASSERT_EQUAL_STRING(esperado, ejecutar_utilidad(manejar_comando_wc, wc_l, &estado));
+    TEST_ASSERT_EQUAL_INT(0, estado);
+    char* wc_lc[] = {"wc", "-lc", a, b, NULL};
+    snprintf(esperado, sizeof(esperado), " 3 13 %s\n 0  6 %s\n 3 19 total\n", a, b);
+    TEST_ASSERT_EQUAL_STRING(esperado, ejecutar_utilidad(manejar_comando_wc, wc_lc, &estado));
+    TEST_ASSERT_EQUAL_INT(0, estado);
+
+    // Caso 3: head y tail, con cabeceras cuando hay más de un archivo
+    char* head[] = {"head", "-n", "2", a, NULL};
+    TEST_ASSERT_EQUAL_STRING("uno\ndos\n", ejecutar_utilidad(manejar_comando_head, head, &estado));
+    char* tail[] = {"tail", "-1", a, NULL};
+    TEST_ASSERT_EQUAL_STRING("tres\n", ejecutar_utilidad(manejar_comando_tail, tail, &estado));
+    char* tail_varios[] = {"tail", "--lines=1", a, b, NULL};
+    snprintf(esperado, sizeof(esperado), "==> %s <==\ntres\n\n==> %s <==\ncuatro", a, b);
+    TEST_ASSERT_EQUAL_STRING(esperado, ejecutar_utilidad(manejar_comando_tail, tail_varios, &estado));
+    TEST_ASSERT_EQUAL_INT(0, estado);
+
+    // Caso 4: test con archivos, cadenas, enteros de cualquier largo, conectores y errores de sintaxis
+    char* verdaderas[][7] = {{"test", "-f", a, NULL},
+                             {"test", "!", "-e", falta, NULL},
+                             {"test", " 12 ", "-eq", "012", NULL},
+                             {"test", "99999999999999999999", "-gt", "-99999999999999999999", NULL},
+                             {"test", "(", "x", "=", "x", ")", NULL},
+                             {"test", "a", "-o", "", "-a", "", NULL}};
+    for (size_t i = 0; i < sizeof(verdaderas) / sizeof(verdaderas[0]); i++)
+    {
+        int argc = 0;
+        while (verdaderas[i][argc] != NULL)
+            argc++;
+        TEST_ASSERT_EQUAL_INT_MESSAGE(0, manejar_comando_test(argc, verdaderas[i]), verdaderas[i][1]);
+    }
+    char* falsa[] = {"test", "-d", a, NULL};
+    TEST_ASSERT_EQUAL_INT(1, manejar_comando_test(3, falsa));
+    char* no_entero[] = {"test", "x", "-lt", "1", NULL};
+    TEST_ASSERT_EQUAL_INT(2, manejar_comando_test(4, no_entero));
+    char* incompleta[] = {"test", "(", "x", ")", "-a", NULL};
+    TEST_ASSERT_EQUAL_INT(2, manejar_comando_test(5, incompleta));
+    TEST_ASSERT_EQUAL_INT(1, manejar_comando_test(1, falsa)); // Sin expresión
+
+    // Caso 5: Los comandos internos sólo reemplazan a los programas con la opción y con argumentos que reproducen
+    char* numerar[] = {"cat", "-n", a, NULL};
+    char* echo[] = {"echo", "x", NULL};
+    opcion_internos = false;
+    TEST_ASSERT_NULL(elegir_builtin(cat));
+    TEST_ASSERT_NOT_NULL(elegir_builtin(echo));
+    opcion_internos = true;
+    TEST_ASSERT_NOT_NULL(elegir_builtin(cat));
+    TEST_ASSERT_NOT_NULL(elegir_builtin(verdaderas[0]));
+    TEST_ASSERT_NULL(elegir_builtin(numerar));
+    analizar_comando("false");
+    TEST_ASSERT_EQUAL_INT(1, ultimo_estado);
+    opcion_internos = false;
+
+    unlink(a);
+    unlink(b);
+    rmdir(directorio);
+}